@@ -1,17 +1,23 @@
 #ifndef AI_VISION_SYSTEM_H
 #define AI_VISION_SYSTEM_H
 
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <memory>
 #include <functional>
 
 namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
 namespace AI {
 
 // Forward declarations
 class Entity;
 class Transform;
+class AIVisionManager;
 
 // Vision sense types
 enum class VisionSense {
@@ -124,6 +130,15 @@ struct OcclusionTest {
     std::vector<Entity*> occluders;
 };
 
+// A target inside an observer's vision cone, found by AIVisionManager's vision pass
+struct VisionSighting {
+    Entity* entity;
+    float position[3];
+    float distance;
+    float angleFromForward;     // Degrees
+    bool isOccluded;
+};
+
 // AI Vision System for a single entity
 class AIVisionSystem {
 public:
@@ -136,6 +151,9 @@ public:
     void setConfig(const VisionConeConfig& config) { m_config = config; }
     VisionConeConfig& getConfig() { return m_config; }
     
+    // Owner pose. Entity carries no transform here, so the owner pushes it before updates
+    void setTransform(const float position[3], const float forward[3]);
+    
     // Vision queries
     const std::vector<VisionTarget>& getVisibleTargets() const { return m_visibleTargets; }
     VisionTarget* getTarget(Entity* entity);
@@ -175,10 +193,16 @@ public:
     void onTargetLost(TargetLostCallback callback) { m_onTargetLost = callback; }
     
 private:
+    friend class AIVisionManager;
+    
     Entity* m_owner;
     VisionConeConfig m_config;
+    AIVisionManager* m_manager;     // Set while registered
+    float m_position[3];
+    float m_forward[3];
     
-    std::vector<VisionTarget> m_visibleTargets;
+    std::vector<VisionTarget> m_visibleTargets;  // Sorted by entity
+    std::vector<VisionSighting> m_sightings;     // Last vision pass, sorted by entity
     std::vector<VisualMemory> m_visualMemory;
     
     // Enabled senses
@@ -197,8 +221,9 @@ private:
     
     // Internal methods
     void scanForTargets();
+    void applySightings(float deltaTime);
     bool isInFieldOfView(const float targetPos[3], bool usePeripheral) const;
-    float calculateVisibilityScore(const float targetPos[3], Entity* target);
+    float calculateVisibilityScore(const VisionTarget& target) const;
     OcclusionTest performOcclusionTest(const float targetPos[3]) const;
     void updateVisualMemory(float deltaTime);
     void updateTarget(VisionTarget& target, float deltaTime);
@@ -217,6 +242,11 @@ private:
 };
 
 // Global AI Vision Manager
+//
+// Owns one spatial index of targets and occluders shared by every registered vision system.
+// Each update senses a round-robin slice of the observers in one batched pass, on JobSystem
+// workers when one is set, then applies the results on the caller so callbacks stay on the
+// calling thread. Callbacks must not register or unregister vision systems.
 class AIVisionManager {
 public:
     AIVisionManager();
@@ -231,13 +261,28 @@ public:
     // Register potential targets
     void registerTarget(Entity* entity);
     void unregisterTarget(Entity* entity);
+    void setTargetPosition(Entity* entity, const float position[3]);
     
     // Get all registered targets
     const std::vector<Entity*>& getAllTargets() const { return m_targets; }
     
+    // Occluders are axis-aligned boxes. Line of sight against static ones is cached per observer
+    // and target until either end moves or a static occluder changes; moving occluders are
+    // traced every time
+    int addOccluder(const float minCorner[3], const float maxCorner[3], bool isStatic = true);
+    void moveOccluder(int occluderId, const float minCorner[3], const float maxCorner[3]);
+    void removeOccluder(int occluderId);
+    
+    // True when an occluder blocks the segment; fills result when given
+    bool raycast(const float from[3], const float to[3], OcclusionTest* result = nullptr);
+    
     // Spatial optimization
     void setUseSpacialPartitioning(bool use) { m_useSpacialPartitioning = use; }
-    void setSectorSize(float size) { m_sectorSize = size; }
+    void setSectorSize(float size) {
+        m_sectorSize = size;
+        m_targetGridDirty = true;
+    }
+    void setOccluderCellSize(float size);
     
     // Global vision modifiers
     void setGlobalLightLevel(float level) { m_globalLightLevel = level; }
@@ -245,7 +290,10 @@ public:
     
     // Performance tuning
     void setUpdateBudget(float milliseconds) { m_updateBudgetMs = milliseconds; }
+    // Observers sensed per update; 0 or less senses all of them every update
     void setMaxUpdatesPerFrame(int max) { m_maxUpdatesPerFrame = max; }
+    // Workers for the vision pass; without one (or with few observers) it runs on the caller
+    void setJobSystem(Threading::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
     
     // Statistics
     struct Stats {
@@ -255,21 +303,74 @@ public:
         int totalOcclusionTests;
         float averageUpdateTime;
         int targetsVisible;
+        int lineOfSightCacheHits;
     };
     
     Stats getStatistics() const;
     
 private:
+    friend class AIVisionSystem;
+    
+    static constexpr size_t OBSERVERS_PER_JOB = 16;
+    
+    // Hashed uniform grid on the x/z plane; cell c holds items[cellStart[c] .. cellStart[c + 1])
+    struct CellGrid {
+        float inverseCellSize = 0.0f;
+        uint32_t mask = 0;
+        std::vector<uint32_t> cellStart;
+        std::vector<uint32_t> items;
+    };
+    
+    struct Occluder {
+        float minCorner[3];
+        float maxCorner[3];
+        bool isStatic;
+        bool active;
+    };
+    
+    // Line of sight against static occluders, as last traced for one observer and target
+    struct LineOfSight {
+        float eye[3];
+        float target[3];
+        uint32_t revision;          // m_staticRevision when traced
+        uint32_t pass;              // Observer pass that last used the entry
+        bool blocked;
+    };
+    
+    // Per observer bookkeeping, parallel to m_visionSystems
+    struct ObserverState {
+        float pendingTime = 0.0f;   // Time since the observer was last sensed
+        uint32_t pass = 0;
+        int visibilityTests = 0;
+        int occlusionTests = 0;
+        int cacheHits = 0;
+        std::unordered_map<Entity*, LineOfSight> lineOfSight;
+    };
+    
     std::vector<AIVisionSystem*> m_visionSystems;
+    std::vector<ObserverState> m_observerStates;
+    std::vector<size_t> m_slice;    // Observers sensed this update
+    
+    // Targets, parallel arrays indexed like m_targets
     std::vector<Entity*> m_targets;
+    std::vector<float> m_targetPositions;       // x, y, z per target
+    std::vector<int32_t> m_targetCells;         // Unhashed x, z cell per target
+    std::unordered_map<Entity*, size_t> m_targetIndex;
     
     // Spatial partitioning
     bool m_useSpacialPartitioning;
     float m_sectorSize;
-    struct Sector {
-        std::vector<Entity*> targets;
-    };
-    std::unordered_map<uint64_t, Sector> m_sectors;
+    CellGrid m_targetGrid;
+    bool m_targetGridDirty;     // Targets added, removed or moved since the grid was built
+    
+    std::vector<Occluder> m_occluders;
+    std::vector<int> m_freeOccluders;
+    float m_occluderCellSize;
+    CellGrid m_staticOccluderGrid;
+    CellGrid m_dynamicOccluderGrid;
+    uint32_t m_staticRevision;
+    bool m_staticOccludersDirty;
+    bool m_dynamicOccludersDirty;
     
     // Global modifiers
     float m_globalLightLevel;
@@ -279,14 +380,20 @@ private:
     float m_updateBudgetMs;
     int m_maxUpdatesPerFrame;
     int m_currentUpdateIndex;
+    Threading::JobSystem* m_jobSystem;
     
     // Stats
     mutable Stats m_stats;
     
     // Internal
     void updateSpatialPartitioning();
-    uint64_t getSectorKey(float x, float z) const;
-    std::vector<Entity*> getNearbyTargets(const float pos[3], float radius);
+    void refreshTargets();
+    void refreshOccluders();
+    void rebuildOccluderGrid(CellGrid& grid, bool isStatic);
+    void senseObserver(AIVisionSystem& system, ObserverState& state) const;
+    void senseSystem(AIVisionSystem& system);
+    bool traceOccluders(const CellGrid& grid, const float from[3], const float to[3],
+                        float& hitFraction) const;
 };
 
 // Perception query helpers
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
 
+namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+}
+
 // Crowd simulation system with flocking behavior
 namespace Engine {
 
@@ -18,10 +25,15 @@ struct CrowdAgent {
     bool active;
 };
 
+// Agents are stored as parallel arrays (structure of arrays) and found through a uniform
+// grid of cells m_neighborRadius wide, rebuilt once per update with a counting sort. Each
+// agent gathers its neighbours once and the separation, alignment and cohesion passes share
+// that list. Steering reads last tick's positions and velocities and writes the next tick's,
+// so agents can be updated in any order, and in parallel when a JobSystem is set.
 class CrowdSimulation {
 public:
     static CrowdSimulation& getInstance();
-
+    
     // Agent management
     int addAgent(float x, float y, float z, float radius = 0.5f);
     void removeAgent(int agentId);
@@ -32,33 +44,79 @@ public:
     void setAgentVelocity(int agentId, float vx, float vy, float vz);
     void setAgentGroup(int agentId, int groupId);
     void getAgentPosition(int agentId, float& x, float& y, float& z) const;
+    bool getAgent(int agentId, CrowdAgent& agent) const;
     
     // Behavior parameters
     void setSeparationWeight(float weight) { m_separationWeight = weight; }
     void setAlignmentWeight(float weight) { m_alignmentWeight = weight; }
     void setCohesionWeight(float weight) { m_cohesionWeight = weight; }
-    void setNeighborRadius(float radius) { m_neighborRadius = radius; }
+    void setNeighborRadius(float radius);
+    
+    // Workers for update(); without one (or with few agents) agents update on the caller
+    void setJobSystem(JJM::Threading::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
     
     // Update
     void update(float deltaTime);
     
     // Query
-    int getAgentCount() const { return m_agents.size(); }
+    int getAgentCount() const { return static_cast<int>(m_active.size()); }
     void getAgentsInRadius(float x, float y, float z, float radius, std::vector<int>& results) const;
     
 private:
     CrowdSimulation();
     CrowdSimulation(const CrowdSimulation&) = delete;
     CrowdSimulation& operator=(const CrowdSimulation&) = delete;
-
-    void updateAgent(CrowdAgent& agent, float deltaTime);
-    void applySeparation(CrowdAgent& agent, float force[3]);
-    void applyAlignment(CrowdAgent& agent, float force[3]);
-    void applyCohesion(CrowdAgent& agent, float force[3]);
-    void applyAvoidance(CrowdAgent& agent, float force[3]);
-    void getNeighbors(const CrowdAgent& agent, std::vector<CrowdAgent*>& neighbors);
-
-    std::vector<CrowdAgent> m_agents;
+    
+    static constexpr size_t AGENTS_PER_JOB = 512;
+    
+    // Per-tick agent state, one entry per agent id
+    struct MotionArrays {
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> velocityX, velocityY, velocityZ;
+    
+        void resize(size_t count);
+    };
+    
+    // Agents sorted by hashed cell; cell c holds agents[cellStart[c] .. cellStart[c + 1])
+    struct NeighborGrid {
+        float inverseCellSize = 0.0f;
+        uint32_t mask = 0;
+        std::vector<uint32_t> cellOf;
+        std::vector<uint32_t> cellStart;
+        std::vector<uint32_t> agents;
+    };
+    
+    void rebuildGrid();
+    uint32_t cellHash(int x, int y, int z) const;
+    // Distinct hashed cells of the (2 * reach + 1)^3 block around a point
+    void gatherCells(float x, float y, float z, int reach, std::vector<uint32_t>& cells) const;
+    void gatherNeighbors(size_t index, std::vector<uint32_t>& cells,
+                         std::vector<uint32_t>& neighbors) const;
+    void updateAgents(size_t begin, size_t end, float deltaTime, std::vector<uint32_t>& cells,
+                      std::vector<uint32_t>& neighbors);
+    void updateAgent(size_t index, const std::vector<uint32_t>& neighbors, float deltaTime);
+    void applySeparation(size_t index, const std::vector<uint32_t>& neighbors, float force[3]) const;
+    void applyAlignment(size_t index, const std::vector<uint32_t>& neighbors, float force[3]) const;
+    void applyCohesion(size_t index, const std::vector<uint32_t>& neighbors, float force[3]) const;
+    void applyAvoidance(size_t index, float force[3]) const;
+    
+    MotionArrays m_motion;
+    MotionArrays m_nextMotion;  // Written by update(), then swapped with m_motion
+    std::vector<float> m_radius;
+    std::vector<float> m_maxSpeed;
+    std::vector<float> m_maxForce;
+    std::vector<int> m_groupId;
+    std::vector<uint8_t> m_active;
+    NeighborGrid m_grid;
+    bool m_gridDirty;           // Positions changed since the grid was built
+    
+    // Per-job scratch so gathering neighbours doesn't allocate once warm
+    struct Scratch {
+        std::vector<uint32_t> cells;
+        std::vector<uint32_t> neighbors;
+    };
+    std::vector<Scratch> m_scratch;
+    JJM::Threading::JobSystem* m_jobSystem;
     
     float m_separationWeight;
     float m_alignmentWeight;
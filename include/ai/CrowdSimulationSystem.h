@@ -11,6 +11,7 @@ namespace AI {
 // Forward declarations
 class Entity;
 class NavigationMesh;
+class FlowField;
 
 // Crowd agent properties
 struct CrowdAgentProperties {
@@ -75,6 +76,11 @@ public:
     const std::vector<float>& getPath() const { return m_path; }
     int getCurrentWaypointIndex() const { return m_currentWaypoint; }
     
+    // Flow field following; overrides the path while set. Fields are sampled on the x/z
+    // plane at one cell per world unit.
+    void setFlowField(const FlowField* field) { m_flowField = field; }
+    const FlowField* getFlowField() const { return m_flowField; }
+    
     // Neighbors
     void addNeighbor(CrowdAgent* agent);
     void clearNeighbors();
@@ -100,6 +106,7 @@ private:
     
     std::vector<float> m_path;  // Series of waypoints (x,y,z, x,y,z, ...)
     int m_currentWaypoint;
+    const FlowField* m_flowField;
     
     std::vector<CrowdAgent*> m_neighbors;
     bool m_enabled;
@@ -110,6 +117,7 @@ private:
     void calculateCohesion(float outForce[3]);
     void calculateAvoidance(float outForce[3]);
     void calculatePathFollowing(float outForce[3]);
+    void calculateFlowFollowing(float outForce[3]);
 };
 
 // Crowd formation
@@ -185,6 +193,9 @@ public:
     void setGroupTarget(const std::vector<CrowdAgent*>& agents, const float target[3]);
     void makeGroupFlee(const std::vector<CrowdAgent*>& agents, const float fleeFrom[3]);
     void makeGroupFollow(const std::vector<CrowdAgent*>& agents, Entity* leader);
+    // Steers a group by one shared field instead of a path per agent; null stops following.
+    // The field must outlive its use and not be regenerated during update().
+    void setGroupFlowField(const std::vector<CrowdAgent*>& agents, const FlowField* field);
     
     // Navigation
     void setNavigationMesh(NavigationMesh* navmesh) { m_navmesh = navmesh; }
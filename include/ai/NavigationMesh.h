@@ -2,7 +2,10 @@
 #define NAVIGATION_MESH_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <list>
 #include <map>
@@ -23,6 +26,7 @@ class NavMeshNode;
 class NavMeshEdge;
 class NavMesh;
 class NavMeshBuilder;
+class ThreadedPathfinder;
 
 // Navigation mesh node (polygon)
 class NavMeshNode {
@@ -70,6 +74,7 @@ class NavMeshEdge {
 // Navigation mesh path
 struct NavMeshPath {
     std::vector<JJM::Math::Vector2D> waypoints;
+    std::vector<int> nodeIds;  // Polygons crossed, start to end
     float totalCost;
     bool valid;
 
@@ -77,6 +82,7 @@ struct NavMeshPath {
 
     void clear() {
         waypoints.clear();
+        nodeIds.clear();
         totalCost = 0.0f;
         valid = false;
     }
@@ -204,6 +210,15 @@ class NavMeshBuilder {
 class NavMeshAgent {
    public:
     NavMeshAgent(const NavMesh* navMesh);
+    ~NavMeshAgent();
+
+    // An agent may have a request in flight that refers back to it
+    NavMeshAgent(const NavMeshAgent&) = delete;
+    NavMeshAgent& operator=(const NavMeshAgent&) = delete;
+
+    // Routes path requests through the service instead of searching inline; the path
+    // arrives when the service delivers completed requests
+    void setPathService(ThreadedPathfinder* service, int priority = 0, int deadlineFrames = 2);
 
     void setPosition(const JJM::Math::Vector2D& pos);
     void setDestination(const JJM::Math::Vector2D& dest);
@@ -213,6 +228,7 @@ class NavMeshAgent {
     JJM::Math::Vector2D getPosition() const { return position; }
     JJM::Math::Vector2D getVelocity() const { return velocity; }
     bool hasPath() const { return currentPath.valid; }
+    bool isPathPending() const { return pendingRequestId >= 0; }
     bool isAtDestination() const;
 
     // Configuration
@@ -234,6 +250,10 @@ class NavMeshAgent {
 
    private:
     const NavMesh* navMesh;
+    ThreadedPathfinder* pathService{nullptr};
+    int pathPriority{0};
+    int pathDeadlineFrames{2};
+    int pendingRequestId{-1};
 
     JJM::Math::Vector2D position;
     JJM::Math::Vector2D velocity;
@@ -493,6 +513,11 @@ struct PathRequest {
     std::function<void(const NavMeshPath&)> callback;
     bool cancelled{false};
 
+    // Scheduling: the frame by which the result should be delivered, and when it was made
+    uint64_t deadlineFrame{UINT64_MAX};
+    uint64_t submitFrame{0};
+    std::chrono::steady_clock::time_point submitTime;
+
     // Request options
     bool useHierarchical{true};
     bool smoothPath{true};
@@ -501,73 +526,112 @@ struct PathRequest {
 
 /**
  * @brief Threaded pathfinding system
+ *
+ * Requests queue up until the next processCompletedPaths() call, which counts as one frame:
+ * it delivers finished paths to their callbacks on the calling thread, then releases the
+ * next batch to the workers. A batch holds at most maxRequestsPerFrame requests, ordered
+ * by due deadline, then priority, then age; workers also stop taking requests once the
+ * frame's search time budget is spent, and whatever is left waits for the next frame.
+ * Requests between the same pair of polygons share one search: either through the
+ * PathCache, or by waiting on an identical search already running. The mesh must not be
+ * modified while workers are running (pause() first).
  */
 class ThreadedPathfinder {
    public:
     ThreadedPathfinder(NavMesh& mesh, int threadCount = 2);
     ~ThreadedPathfinder();
 
-    // Request management
+    // Request management; deadlineFrames < 0 means no deadline
     int requestPath(const JJM::Math::Vector2D& start, const JJM::Math::Vector2D& end,
-                    std::function<void(const NavMeshPath&)> callback, int priority = 0);
+                    std::function<void(const NavMeshPath&)> callback, int priority = 0,
+                    int deadlineFrames = -1);
     void cancelRequest(int requestId);
     void cancelAllRequests();
 
     // Hierarchical support
     void setHierarchicalMesh(HierarchicalNavMesh* hierarchical) { hierMesh = hierarchical; }
 
-    // Path caching
+    // Path caching; workers lock around the cache, so leave it alone while they run
     void setPathCache(PathCache* cache) { pathCache = cache; }
 
-    // Control
+    // Control; without started workers, processCompletedPaths() searches inline
     void start();
     void stop();
     void pause();
     void resume();
     bool isRunning() const { return running; }
 
-    // Process completed paths on main thread
+    // Process completed paths on main thread, then release the next batch (once per frame)
     void processCompletedPaths();
+    uint64_t getCurrentFrame() const { return currentFrame; }
 
     // Statistics
     struct ThreadStats {
         size_t pendingRequests;
         size_t completedRequests;
         size_t cancelledRequests;
-        float averagePathTime;
+        float averagePathTime;  // Milliseconds per search actually run
         size_t cacheHits;
         size_t cacheMisses;
+        float cacheHitRate;
+        size_t coalescedRequests;  // Served by an identical search already in flight
+        float averageQueueLatency;  // Milliseconds from request to search start
+        float maxQueueLatency;
+        float averageLatencyFrames;  // Frames from request to delivery
+        size_t missedDeadlines;
     };
     ThreadStats getStatistics() const;
+    void resetStatistics();
 
     // Configuration
     void setMaxRequestsPerFrame(int max) { maxRequestsPerFrame = max; }
+    void setFrameTimeBudget(float milliseconds);
 
    private:
+    struct CompletedPath {
+        int requestId;
+        NavMeshPath path;
+        uint64_t deadlineFrame;
+        uint64_t submitFrame;
+    };
+
     NavMesh& navMesh;
     HierarchicalNavMesh* hierMesh{nullptr};
     PathCache* pathCache{nullptr};
+    int threadCount;
 
     std::vector<std::thread> workers;
-    std::priority_queue<PathRequest, std::vector<PathRequest>,
-                        std::function<bool(const PathRequest&, const PathRequest&)>>
-        requestQueue;
-    std::vector<std::pair<int, NavMeshPath>> completedPaths;
+    std::vector<PathRequest> pendingRequests;  // Waiting for a frame's batch
+    std::deque<PathRequest> requestQueue;      // Released to the workers this frame
+    std::unordered_map<PathCacheKey, std::vector<PathRequest>, PathCacheKeyHash> inFlight;
+    std::vector<CompletedPath> completedPaths;
     std::unordered_map<int, std::function<void(const NavMeshPath&)>> callbacks;
 
-    std::mutex queueMutex;
-    std::mutex completedMutex;
+    mutable std::mutex queueMutex;      // Requests, in-flight searches and callbacks
+    mutable std::mutex completedMutex;  // Completed paths and statistics
+    std::mutex cacheMutex;
     std::condition_variable queueCondition;
 
     std::atomic<bool> running{false};
     std::atomic<bool> paused{false};
+    std::atomic<uint64_t> currentFrame{0};
+    std::atomic<int64_t> frameWorkMicros{0};
+    std::atomic<int64_t> frameBudgetMicros{INT64_MAX};
     int nextRequestId{0};
     int maxRequestsPerFrame{10};
 
-    mutable ThreadStats stats{};
+    ThreadStats stats{};
+    double totalPathTime{0.0};
+    double totalQueueLatency{0.0};
+    uint64_t totalLatencyFrames{0};
+    size_t searchCount{0};
+    size_t startedRequests{0};
 
     void workerThread();
     void processRequest(PathRequest& request);
+    void completeRequest(const PathRequest& request, const NavMeshPath& nodePath);
+    void releaseBatch();
+    bool frameBudgetSpent() const;
 };
 
 // =============================================================================
@@ -628,6 +692,7 @@ class DynamicObstacleManager {
     void updateObstacle(int obstacleId, const JJM::Math::Vector2D& position, float rotation = 0.0f);
     void updateObstacleVelocity(int obstacleId, const JJM::Math::Vector2D& velocity);
     DynamicObstacle* getObstacle(int obstacleId);
+    const std::unordered_map<int, DynamicObstacle>& getObstacles() const { return obstacles; }
 
     // Batch updates
     void updateAllObstacles(float deltaTime);
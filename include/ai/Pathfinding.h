@@ -2,6 +2,7 @@
 #define PATHFINDING_H
 
 #include "math/Vector2D.h"
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include <unordered_map>
@@ -10,6 +11,8 @@
 namespace JJM {
 namespace AI {
 
+class DynamicObstacleManager;
+
 struct GridNode {
     int x, y;
     float gCost, hCost;
@@ -32,6 +35,8 @@ struct GridNodeHash {
     }
 };
 
+// Walkability changes must go through setWalkable(): searches read a packed copy of the
+// flags, and the revision tells cached layers (HierarchicalPathfinder) what changed
 class Grid {
 public:
     Grid(int width, int height);
@@ -46,33 +51,212 @@ public:
     int getWidth() const { return width; }
     int getHeight() const { return height; }
     
+    const uint8_t* getWalkableData() const { return walkableMask.data(); }
+    uint64_t getRevision() const { return revision; }
+    
 private:
     int width, height;
     std::vector<GridNode> nodes;
+    std::vector<uint8_t> walkableMask;
+    uint64_t revision;
+};
+
+// Inclusive cell rectangle a search may not leave
+struct GridRect {
+    int minX, minY, maxX, maxY;
+    
+    bool contains(int x, int y) const {
+        return x >= minX && x <= maxX && y >= minY && y <= maxY;
+    }
+};
+
+// Per-node search state, valid only when generation matches the current search, so
+// nothing is cleared between queries
+struct SearchNodeState {
+    uint32_t generation;
+    int32_t parent;
+    float gCost;
+    int32_t heapIndex;              // Position in the open heap, or CLOSED
+    
+    static constexpr int32_t CLOSED = -1;
+};
+
+/**
+ * Binary min-heap of node indices ordered by f, then h (deeper nodes first on ties). Each
+ * node's position is kept in its SearchNodeState so a queued node's key can be lowered in
+ * place instead of pushing a duplicate.
+ */
+class IndexedBinaryHeap {
+public:
+    explicit IndexedBinaryHeap(std::vector<SearchNodeState>& states) : states(states) {}
+    
+    void clear() { entries.clear(); }
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    
+    void push(int32_t node, float f, float h);
+    void decreaseKey(int32_t node, float f);
+    int32_t pop();                  // Marks the node CLOSED
+    
+private:
+    struct Entry {
+        float f;
+        float h;
+        int32_t node;
+    };
+    
+    std::vector<SearchNodeState>& states;
+    std::vector<Entry> entries;
+    
+    static bool less(const Entry& a, const Entry& b) {
+        return a.f < b.f || (a.f == b.f && a.h < b.h);
+    }
+    void siftUp(size_t index);
+    void siftDown(size_t index);
 };
 
+/**
+ * Grid A* with straight steps costing 1 and diagonal steps sqrt(2) (no corner cutting).
+ * Search state lives in the AStar instance and is reused across queries, so findPath does
+ * not allocate once warm; use one instance per thread over a shared Grid.
+ */
 class AStar {
 public:
     AStar(Grid* grid);
     
     std::vector<Math::Vector2D> findPath(const Math::Vector2D& start, const Math::Vector2D& goal);
     
+    // Overrides the built-in octile/Manhattan estimate (slower: called per expanded node)
     void setHeuristic(std::function<float(const GridNode&, const GridNode&)> heuristic) {
         this->heuristic = heuristic;
     }
     
     void setAllowDiagonal(bool allow) { allowDiagonal = allow; }
+    bool getAllowDiagonal() const { return allowDiagonal; }
+    
+    // Weights above 1 expand fewer nodes for paths up to `weight` times longer
+    void setHeuristicWeight(float weight) { heuristicWeight = weight; }
+    
+    size_t getLastExpandedCount() const { return lastExpanded; }
     
     static float manhattanDistance(const GridNode& a, const GridNode& b);
     static float euclideanDistance(const GridNode& a, const GridNode& b);
     static float chebyshevDistance(const GridNode& a, const GridNode& b);
+    static float octileDistance(const GridNode& a, const GridNode& b);
     
 private:
+    friend class HierarchicalPathfinder;
+    
     Grid* grid;
     bool allowDiagonal;
+    float heuristicWeight;
     std::function<float(const GridNode&, const GridNode&)> heuristic;
     
-    std::vector<Math::Vector2D> reconstructPath(GridNode* endNode);
+    std::vector<SearchNodeState> states;
+    IndexedBinaryHeap openSet;
+    uint32_t generation;
+    size_t lastExpanded;
+    std::vector<int32_t> cellPath;
+    std::vector<uint32_t> targetMarks; // Stamped with generation for costsWithin's targets
+    
+    void beginSearch();
+    float estimate(int32_t cell, int32_t goal) const;
+    // Fills cellPath with start..goal and returns the cost, or a negative value
+    float search(int32_t start, int32_t goal, const GridRect& bounds);
+    // Path costs from source to each target without leaving bounds (infinity if unreachable);
+    // stops once every target is settled
+    void costsWithin(int32_t source, const GridRect& bounds, const int32_t* targets,
+                     size_t targetCount, float* costs);
+    template <typename Visit>
+    void forEachNeighbor(int32_t cell, const GridRect& bounds, Visit&& visit) const;
+};
+
+/**
+ * HPA*-style abstraction over a Grid for long paths. The grid is cut into square clusters;
+ * walkable runs along each cluster border become entrances, and the path costs between
+ * entrances of the same cluster are precomputed. A query searches this small graph and
+ * then refines each leg with an A* confined to one cluster, so the work grows with the
+ * number of clusters crossed rather than the cells in between. Paths are within a few
+ * percent of optimal; queries spanning at most one cluster go straight to A*.
+ *
+ * The abstract search is guided by landmark distances (ALT) as well as the grid distance:
+ * exact costs from a few entrances near the map's edge to every entrance bound the remaining
+ * cost far more tightly around walls. build() computes them; after updateRegion() they are
+ * recomputed by the next query, which then costs about as much as a dozen more.
+ */
+class HierarchicalPathfinder {
+public:
+    HierarchicalPathfinder(Grid* grid, int clusterSize = 32);
+    
+    // Rebuilds every cluster; call after construction or wholesale grid changes
+    void build();
+    // Rebuilds the clusters overlapping the given cells and their neighbours
+    void updateRegion(int minX, int minY, int maxX, int maxY);
+    
+    std::vector<Math::Vector2D> findPath(const Math::Vector2D& start, const Math::Vector2D& goal);
+    
+    void setAllowDiagonal(bool allow);
+    
+    int getClusterSize() const { return clusterSize; }
+    size_t getEntranceCount() const;
+    size_t getLastAbstractExpandedCount() const { return lastAbstractExpanded; }
+    
+private:
+    // Abstract edge with its target's coordinates, so the search never divides by width
+    struct AbstractEdge {
+        int32_t node;
+        float cost;
+        int32_t x, y;
+    };
+    
+    struct Cluster {
+        GridRect bounds;
+        std::vector<int32_t> cells;     // Entrance cells on this side, by border
+        std::vector<float> costs;       // cells.size() squared; infinity if unreachable
+        int borderOffsets[5];           // Start of each border's entrances in `cells`
+        // Reachable entrances in this cluster and the one across the border, per entrance
+        std::vector<AbstractEdge> edges;
+        std::vector<int> edgeOffsets;   // cells.size() + 1
+    };
+    
+    // Cell pairs (this side, other side) on the border to the right of or below a cluster
+    using Border = std::vector<std::pair<int32_t, int32_t>>;
+    
+    Grid* grid;
+    AStar low;
+    int clusterSize;
+    int clustersX, clustersY;
+    int nodeStride;                     // Abstract node id = cluster * nodeStride + entrance
+    std::vector<Cluster> clusters;
+    std::vector<Border> rightBorders;
+    std::vector<Border> bottomBorders;
+    
+    // Abstract search over nodeStride * clusters nodes plus start and goal
+    std::vector<SearchNodeState> abstractStates;
+    IndexedBinaryHeap abstractOpen;
+    uint32_t abstractGeneration;
+    size_t lastAbstractExpanded;
+    // Start and goal edges, kept while the same endpoint is queried again and the clusters
+    // are unchanged (-1 = none), since agents often share a goal or re-plan from one cell
+    std::vector<float> startCosts;
+    std::vector<float> goalCosts;
+    int32_t startCostsCell;
+    int32_t goalCostsCell;
+    std::vector<int32_t> abstractPath;
+    
+    // Abstract-graph costs from each landmark, indexed node * LANDMARKS + landmark
+    static constexpr int LANDMARKS = 8;
+    std::vector<float> landmarkCosts;
+    bool landmarksValid;
+    
+    int clusterOf(int32_t cell) const;
+    void buildBorders(int cx, int cy);
+    void linkCluster(int cluster);
+    void computeCosts(int cluster);
+    int32_t nodeCell(int32_t node) const;
+    void beginAbstractSearch();
+    void computeLandmarks();
+    bool searchAbstract(int32_t startCell, int32_t goalCell);
 };
 
 class Dijkstra {
@@ -86,21 +270,125 @@ private:
     Grid* grid;
 };
 
+/**
+ * Flow field toward one goal, for moving large groups without a search per agent. The grid is
+ * cut into square sectors and generateField() runs a Dijkstra wavefront over them: each
+ * sector is integrated from the goal or from the costs across its borders with sectors
+ * already done, and is revisited if a later neighbour offers a cheaper way in. A sector's
+ * result (a direction and cost per cell) is a tile cached under its border costs relative to
+ * the cheapest, so after a goal move or an edit only sectors whose borders changed are
+ * integrated again. Every direction leads to a cell with a lower cost, so following the field
+ * always ends at the goal.
+ *
+ * Edits (setCellCost, updateRegion, applyObstacles) are repaired on the next generateField();
+ * until then queries keep answering from the previous field. Queries are lookups and may run
+ * from any number of threads between generateField() calls.
+ */
 class FlowField {
 public:
-    FlowField(Grid* grid);
+    static constexpr uint8_t BLOCKED = 255;
+    
+    FlowField(Grid* grid, int sectorSize = 16);
     
     void generateField(const Math::Vector2D& goal);
+    // Unit step toward the goal; zero at the goal and where it can't be reached
     Math::Vector2D getDirection(const Math::Vector2D& position) const;
+    // Cost to reach the goal, or the float maximum where it can't be reached
     float getCost(int x, int y) const;
     
+    // Cost of entering a cell on top of the grid's walkability: 1 is open ground, BLOCKED is
+    // impassable
+    void setCellCost(int x, int y, uint8_t cost);
+    // Re-reads walkability after Grid::setWalkable() calls in the rectangle. Grid changes
+    // not reported here are caught by the grid revision and re-read everywhere.
+    void updateRegion(int minX, int minY, int maxX, int maxY);
+    // Stamps the enabled obstacles into the cost field, replacing the previous call's stamps.
+    // Cells are one world unit; polygon vertices are relative to the obstacle position.
+    void applyObstacles(const DynamicObstacleManager& obstacles);
+    
+    // Tiles kept for reuse; never fewer than one per sector
+    void setMaxCachedTiles(size_t count) { maxCachedTiles = count; }
+    
+    struct Statistics {
+        size_t sectorCount;
+        size_t cachedTiles;
+        size_t sectorVisits;            // By the last generateField(), revisits included
+        size_t tilesBuilt;
+        size_t tilesReused;
+        size_t sectorsRepaired;
+    };
+    Statistics getStatistics() const;
+    
 private:
+    // Keyed by sector, sector revision, and each seed's cell, direction and cost relative to
+    // the cheapest seed (quantized)
+    struct Tile {
+        uint32_t lastUsed;
+        std::vector<uint8_t> directions;
+        std::vector<float> costs;
+    };
+    
+    struct TileKeyHash {
+        size_t operator()(const std::vector<int32_t>& key) const;
+    };
+    
+    struct Seed {
+        int32_t cell;
+        float cost;
+        uint8_t direction;
+    };
+    
     Grid* grid;
-    std::vector<float> costField;
-    std::vector<Math::Vector2D> flowField;
+    int sectorSize;
+    int sectorsX, sectorsY;
+    
+    std::vector<uint8_t> baseCosts;     // From setCellCost
+    std::vector<uint8_t> obstacleCosts; // From applyObstacles
+    std::vector<uint8_t> costs;         // Combined with walkability; what integration reads
+    std::vector<int32_t> obstacleCells;
+    uint64_t gridRevision;
+    
+    std::vector<GridRect> sectorBounds;
+    std::vector<uint32_t> sectorRevisions;  // Bumped when a sector's cells change
+    std::vector<uint8_t> touchedSectors;
+    bool touched;
+    
+    // The current field; sectors without a tile can't reach the goal
+    bool hasGoal;
+    std::vector<const Tile*> sectorTiles;
+    std::vector<float> sectorOffsets;   // Added to a tile's costs
+    
+    std::unordered_map<std::vector<int32_t>, Tile, TileKeyHash> tiles;
+    size_t maxCachedTiles;
+    uint32_t fieldGeneration;
+    Statistics stats;
+    
+    std::vector<SearchNodeState> sectorStates;  // The wavefront, keyed on cheapest entry
+    IndexedBinaryHeap sectorOpen;
+    std::vector<SearchNodeState> localStates;   // One sector's integration, by local cell
+    IndexedBinaryHeap localOpen;
+    uint32_t localGeneration;
+    std::vector<Seed> seeds;
+    std::vector<int32_t> key;
     
-    void calculateCostField(const Math::Vector2D& goal);
-    void calculateFlowField();
+    int sectorOf(int x, int y) const { return (y / sectorSize) * sectorsX + x / sectorSize; }
+    int32_t localIndex(int sector, int32_t cell) const;
+    float fieldCost(int sector, int32_t cell) const;
+    bool refreshCost(int32_t cell);
+    void touch(int32_t cell);
+    void repair();
+    int neighborSector(int sector, int side) const;
+    // Calls visit(inside, outside, length, direction) for each open step from a cell of
+    // `sector` into the neighbouring sector on `side` (0 right, 1 down, 2 left, 3 up)
+    template <typename Visit>
+    void forEachCrossing(int sector, int side, Visit&& visit) const;
+    void gatherSeeds(int sector, int32_t goalCell);
+    // Cost-to-seed flood of one sector; results stay in localStates
+    void integrate(const GridRect& bounds);
+    const Tile* resolveTile(int sector);
+    // Queues neighbours that this sector's costs would make cheaper
+    void offerNeighbors(int sector);
+    void evictTiles();
 };
 
 } // namespace AI
@@ -1,27 +1,15 @@
 #ifndef JJM_PATHFINDING_GRID_H
 #define JJM_PATHFINDING_GRID_H
 
+#include "ai/Pathfinding.h"
 #include "math/Vector2D.h"
 #include <vector>
-#include <queue>
-#include <functional>
 
 namespace JJM {
 namespace AI {
 
-struct GridNode {
-    int x, y;
-    bool walkable;
-    float gCost, hCost;
-    GridNode* parent;
-    
-    float fCost() const { return gCost + hCost; }
-    
-    bool operator<(const GridNode& other) const {
-        return fCost() > other.fCost();
-    }
-};
-
+// World-space front end for a Grid searched with AStar; positions are scaled by cellSize
+// and paths come back as cell centres
 class PathfindingGrid {
 public:
     PathfindingGrid(int width, int height, float cellSize);
@@ -37,15 +25,9 @@ public:
     void setHeuristicWeight(float weight);
 
 private:
-    int width, height;
     float cellSize;
-    std::vector<std::vector<GridNode>> grid;
-    bool allowDiagonal;
-    float heuristicWeight;
-    
-    float calculateHeuristic(const GridNode& a, const GridNode& b);
-    std::vector<GridNode*> getNeighbors(GridNode& node);
-    void resetGrid();
+    Grid grid;
+    AStar astar;
     
     Math::Vector2D worldToGrid(const Math::Vector2D& world);
     Math::Vector2D gridToWorld(int x, int y);
@@ -0,0 +1,273 @@
+#ifndef ASSET_BUNDLE_H
+#define ASSET_BUNDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
+namespace Core {
+
+/**
+ * @brief Bundle compression types
+ */
+enum class BundleCompression {
+    None,
+    LZ4,   // Fast compression
+    ZSTD,  // Good balance
+    LZMA,  // High compression ratio
+    Custom
+};
+
+/**
+ * @brief Asset entry in a bundle
+ */
+struct BundleAssetEntry {
+    std::string assetId;
+    std::string assetType;  // "Texture", "Audio", "Mesh", "Animation", etc.
+    std::string originalPath;
+
+    // Location in bundle
+    size_t offset{0};
+    size_t compressedSize{0};
+    size_t uncompressedSize{0};
+
+    // Storage. None keeps the bytes as they are, viewable in place; a compressed asset is
+    // split into chunks compressed independently, listed in the bundle's chunk table
+    BundleCompression compression{BundleCompression::None};
+    uint32_t firstChunk{0};
+    uint32_t chunkCount{0};
+
+    // Metadata
+    uint32_t checksum{0};
+    uint32_t version{0};
+    std::unordered_map<std::string, std::string> metadata;
+
+    // Dependencies
+    std::vector<std::string> dependencies;
+};
+
+/**
+ * @brief Bundle header information
+ *
+ * On disk a bundle is a fixed 64-byte header, the table of contents, then the asset data.
+ * The table and every asset start on an ALIGNMENT boundary, so a mapped bundle can hand out
+ * assets in place.
+ */
+struct BundleHeader {
+    static constexpr uint32_t MAGIC = 0x4A4A4D42;  // "JJMB"
+    static constexpr uint32_t CURRENT_VERSION = 1;
+    static constexpr size_t FIXED_SIZE = 64;
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;  // Uncompressed bytes per chunk
+
+    uint32_t magic{MAGIC};
+    uint32_t version{CURRENT_VERSION};
+    uint32_t assetCount{0};
+    uint32_t compression{0};
+
+    // Checksums
+    uint32_t headerChecksum{0};   // Table of contents
+    uint32_t contentChecksum{0};  // Asset data
+
+    // Sizes
+    size_t headerSize{0};  // Fixed header and table of contents
+    size_t totalSize{0};
+    size_t uncompressedSize{0};
+
+    // Layout
+    size_t tocOffset{0};
+    size_t tocSize{0};
+    size_t dataOffset{0};
+    uint32_t chunkCount{0};
+
+    // Metadata
+    std::string bundleName;
+    std::string buildTime;
+    std::string platform;
+    std::string buildTag;
+
+    bool isValid() const { return magic == MAGIC && version <= CURRENT_VERSION; }
+};
+
+/**
+ * @brief Read-only view of an asset's bytes in a loaded bundle, valid until it is unloaded
+ */
+struct BundleAssetView {
+    const uint8_t* data{nullptr};
+    size_t size{0};
+
+    const uint8_t* begin() const { return data; }
+    const uint8_t* end() const { return data + size; }
+    bool empty() const { return size == 0; }
+    const uint8_t& operator[](size_t index) const { return data[index]; }
+};
+
+/**
+ * @brief Loaded asset bundle
+ *
+ * loadFromFile() memory-maps the bundle and reads only the table of contents; asset bytes
+ * are paged in when first touched.
+ */
+class AssetBundle {
+   public:
+    AssetBundle();
+    ~AssetBundle();
+
+    AssetBundle(const AssetBundle&) = delete;
+    AssetBundle& operator=(const AssetBundle&) = delete;
+
+    // Loading; loadFromMemory() copies the bundle
+    bool loadFromFile(const std::string& filepath);
+    bool loadFromMemory(const uint8_t* data, size_t size);
+    void unload();
+    bool isLoaded() const { return loaded; }
+    bool isMapped() const { return fileMapped; }
+
+    // Asset access
+    bool hasAsset(const std::string& assetId) const;
+    std::vector<uint8_t> getAssetData(const std::string& assetId);
+    const BundleAssetEntry* getAssetEntry(const std::string& assetId) const;
+    std::vector<std::string> getAssetIds() const;
+    std::vector<std::string> getAssetIdsByType(const std::string& type) const;
+
+    // An uncompressed asset's bytes in place, without a copy; empty if the asset is
+    // compressed or missing
+    BundleAssetView getAssetView(const std::string& assetId) const;
+
+    // Decompresses or copies an asset into a buffer of at least its uncompressed size
+    bool readAsset(const std::string& assetId, uint8_t* destination, size_t capacity) const;
+
+    // Chunks of a compressed asset are decompressed on these workers
+    void setJobSystem(Threading::JobSystem* system) { jobSystem = system; }
+
+    // Async loading
+    std::future<std::vector<uint8_t>> getAssetDataAsync(const std::string& assetId);
+
+    // Bundle info
+    const BundleHeader& getHeader() const { return header; }
+    const std::string& getName() const { return header.bundleName; }
+    const std::string& getPath() const { return bundlePath; }
+    size_t getAssetCount() const { return assets.size(); }
+    size_t getTotalSize() const { return header.totalSize; }
+
+    // Dependencies
+    std::vector<std::string> getDependencies(const std::string& assetId) const;
+    std::vector<std::string> getAllDependencies() const;
+
+    // Validation
+    bool validateChecksum() const;
+    bool validateAsset(const std::string& assetId) const;
+
+   private:
+    friend class BundleBuilder;  // Incremental builds copy compressed chunks
+
+    struct ChunkEntry {
+        size_t offset;
+        uint32_t compressedSize;  // Equal to uncompressedSize if stored as is
+        uint32_t uncompressedSize;
+    };
+
+    BundleHeader header;
+    std::unordered_map<std::string, BundleAssetEntry> assets;
+    std::vector<ChunkEntry> chunks;
+    std::string bundlePath;
+    bool loaded{false};
+
+    // File mapping for efficient access; ownedData backs it when the bundle is not mapped
+    uint8_t* mappedData{nullptr};
+    size_t mappedSize{0};
+    bool fileMapped{false};
+    std::vector<uint8_t> ownedData;
+
+    Threading::JobSystem* jobSystem{nullptr};
+
+    bool parseTableOfContents();
+    bool readChunk(const ChunkEntry& chunk, uint8_t* destination) const;
+    std::vector<uint8_t> decompressData(const BundleAssetEntry& entry) const;
+};
+
+/**
+ * @brief Asset bundle builder for creating bundles
+ */
+class BundleBuilder {
+   public:
+    BundleBuilder();
+    ~BundleBuilder();
+
+    // Configuration. Only LZ4 is built in; other codecs fall back to it
+    void setName(const std::string& name) { bundleName = name; }
+    void setPlatform(const std::string& platform) { targetPlatform = platform; }
+    void setCompression(BundleCompression compression, int level = -1);
+    void setBuildTag(const std::string& tag) { buildTag = tag; }
+
+    // Adding assets
+    void addAsset(const std::string& assetId, const std::string& filepath, const std::string& type);
+    void addAsset(const std::string& assetId, const std::vector<uint8_t>& data,
+                  const std::string& type);
+    void addAssetWithMetadata(const std::string& assetId, const std::string& filepath,
+                              const std::string& type,
+                              const std::unordered_map<std::string, std::string>& metadata);
+    void removeAsset(const std::string& assetId);
+    void clearAssets();
+
+    // Dependencies
+    void addDependency(const std::string& assetId, const std::string& dependencyId);
+    void setDependencies(const std::string& assetId, const std::vector<std::string>& dependencies);
+
+    // Building. An incremental build reuses the stored bytes of assets whose contents and
+    // compression are unchanged from the previous bundle
+    bool build(const std::string& outputPath);
+    bool buildIncremental(const std::string& outputPath, const std::string& previousBundlePath);
+
+    // Progress
+    using ProgressCallback = std::function<void(const std::string& asset, int current, int total)>;
+    void setProgressCallback(ProgressCallback callback) { progressCallback = callback; }
+
+    // Statistics
+    struct BuildStats {
+        size_t totalAssets;
+        size_t totalUncompressedSize;
+        size_t totalCompressedSize;
+        float compressionRatio;
+        float buildTimeSeconds;
+    };
+    BuildStats getLastBuildStats() const { return lastStats; }
+
+   private:
+    struct PendingAsset {
+        std::string assetId;
+        std::string filepath;
+        std::string type;
+        std::vector<uint8_t> data;
+        std::unordered_map<std::string, std::string> metadata;
+        std::vector<std::string> dependencies;
+        bool hasFileData{false};
+    };
+
+    std::string bundleName;
+    std::string targetPlatform;
+    std::string buildTag;
+    BundleCompression compression{BundleCompression::LZ4};
+    int compressionLevel{-1};
+
+    std::vector<PendingAsset> pendingAssets;
+    ProgressCallback progressCallback;
+    BuildStats lastStats{};
+
+    PendingAsset* findPending(const std::string& assetId);
+    bool writeBundle(const std::string& outputPath, const AssetBundle* previous);
+};
+
+}  // namespace Core
+}  // namespace JJM
+
+#endif  // ASSET_BUNDLE_H
@@ -13,6 +13,7 @@
 #include <thread>
 #include <unordered_map>
 
+#include "core/AssetBundle.h"
 #include "graphics/Texture.h"
 
 namespace JJM {
@@ -203,192 +204,6 @@ class ResourceManager {
 // ASSET BUNDLE SYSTEM
 // =============================================================================
 
-/**
- * @brief Bundle compression types
- */
-enum class BundleCompression {
-    None,
-    LZ4,   // Fast compression
-    ZSTD,  // Good balance
-    LZMA,  // High compression ratio
-    Custom
-};
-
-/**
- * @brief Asset entry in a bundle
- */
-struct BundleAssetEntry {
-    std::string assetId;
-    std::string assetType;  // "Texture", "Audio", "Mesh", "Animation", etc.
-    std::string originalPath;
-
-    // Location in bundle
-    size_t offset{0};
-    size_t compressedSize{0};
-    size_t uncompressedSize{0};
-
-    // Metadata
-    uint32_t checksum{0};
-    uint32_t version{0};
-    std::unordered_map<std::string, std::string> metadata;
-
-    // Dependencies
-    std::vector<std::string> dependencies;
-};
-
-/**
- * @brief Bundle header information
- */
-struct BundleHeader {
-    static constexpr uint32_t MAGIC = 0x4A4A4D42;  // "JJMB"
-    static constexpr uint32_t CURRENT_VERSION = 1;
-
-    uint32_t magic{MAGIC};
-    uint32_t version{CURRENT_VERSION};
-    uint32_t assetCount{0};
-    uint32_t compression{0};
-
-    // Checksums
-    uint32_t headerChecksum{0};
-    uint32_t contentChecksum{0};
-
-    // Sizes
-    size_t headerSize{0};
-    size_t totalSize{0};
-    size_t uncompressedSize{0};
-
-    // Metadata
-    std::string bundleName;
-    std::string buildTime;
-    std::string platform;
-    std::string buildTag;
-
-    bool isValid() const { return magic == MAGIC && version <= CURRENT_VERSION; }
-};
-
-/**
- * @brief Loaded asset bundle
- */
-class AssetBundle {
-   public:
-    AssetBundle();
-    ~AssetBundle();
-
-    // Loading
-    bool loadFromFile(const std::string& filepath);
-    bool loadFromMemory(const uint8_t* data, size_t size);
-    void unload();
-    bool isLoaded() const { return loaded; }
-
-    // Asset access
-    bool hasAsset(const std::string& assetId) const;
-    std::vector<uint8_t> getAssetData(const std::string& assetId);
-    const BundleAssetEntry* getAssetEntry(const std::string& assetId) const;
-    std::vector<std::string> getAssetIds() const;
-    std::vector<std::string> getAssetIdsByType(const std::string& type) const;
-
-    // Async loading
-    std::future<std::vector<uint8_t>> getAssetDataAsync(const std::string& assetId);
-
-    // Bundle info
-    const BundleHeader& getHeader() const { return header; }
-    const std::string& getName() const { return header.bundleName; }
-    const std::string& getPath() const { return bundlePath; }
-    size_t getAssetCount() const { return assets.size(); }
-    size_t getTotalSize() const { return header.totalSize; }
-
-    // Dependencies
-    std::vector<std::string> getDependencies(const std::string& assetId) const;
-    std::vector<std::string> getAllDependencies() const;
-
-    // Validation
-    bool validateChecksum() const;
-    bool validateAsset(const std::string& assetId) const;
-
-   private:
-    BundleHeader header;
-    std::unordered_map<std::string, BundleAssetEntry> assets;
-    std::string bundlePath;
-    bool loaded{false};
-
-    // File mapping for efficient access
-    uint8_t* mappedData{nullptr};
-    size_t mappedSize{0};
-
-    std::vector<uint8_t> decompressData(const BundleAssetEntry& entry);
-};
-
-/**
- * @brief Asset bundle builder for creating bundles
- */
-class BundleBuilder {
-   public:
-    BundleBuilder();
-    ~BundleBuilder();
-
-    // Configuration
-    void setName(const std::string& name) { bundleName = name; }
-    void setPlatform(const std::string& platform) { targetPlatform = platform; }
-    void setCompression(BundleCompression compression, int level = -1);
-    void setBuildTag(const std::string& tag) { buildTag = tag; }
-
-    // Adding assets
-    void addAsset(const std::string& assetId, const std::string& filepath, const std::string& type);
-    void addAsset(const std::string& assetId, const std::vector<uint8_t>& data,
-                  const std::string& type);
-    void addAssetWithMetadata(const std::string& assetId, const std::string& filepath,
-                              const std::string& type,
-                              const std::unordered_map<std::string, std::string>& metadata);
-    void removeAsset(const std::string& assetId);
-    void clearAssets();
-
-    // Dependencies
-    void addDependency(const std::string& assetId, const std::string& dependencyId);
-    void setDependencies(const std::string& assetId, const std::vector<std::string>& dependencies);
-
-    // Building
-    bool build(const std::string& outputPath);
-    bool buildIncremental(const std::string& outputPath, const std::string& previousBundlePath);
-
-    // Progress
-    using ProgressCallback = std::function<void(const std::string& asset, int current, int total)>;
-    void setProgressCallback(ProgressCallback callback) { progressCallback = callback; }
-
-    // Statistics
-    struct BuildStats {
-        size_t totalAssets;
-        size_t totalUncompressedSize;
-        size_t totalCompressedSize;
-        float compressionRatio;
-        float buildTimeSeconds;
-    };
-    BuildStats getLastBuildStats() const { return lastStats; }
-
-   private:
-    struct PendingAsset {
-        std::string assetId;
-        std::string filepath;
-        std::string type;
-        std::vector<uint8_t> data;
-        std::unordered_map<std::string, std::string> metadata;
-        std::vector<std::string> dependencies;
-        bool hasFileData{false};
-    };
-
-    std::string bundleName;
-    std::string targetPlatform;
-    std::string buildTag;
-    BundleCompression compression{BundleCompression::LZ4};
-    int compressionLevel{-1};
-
-    std::vector<PendingAsset> pendingAssets;
-    ProgressCallback progressCallback;
-    BuildStats lastStats{};
-
-    std::vector<uint8_t> compressData(const std::vector<uint8_t>& data);
-    uint32_t calculateChecksum(const uint8_t* data, size_t size);
-};
-
 /**
  * @brief Bundle manager for handling multiple bundles
  */
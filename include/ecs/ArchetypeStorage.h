@@ -0,0 +1,437 @@
+/**
+ * @file ArchetypeStorage.h
+ * @brief Archetype-based (structure-of-arrays) component storage for the ECS
+ * @version 1.0.0
+ * @date 2026-10-15
+ */
+
+#ifndef ARCHETYPE_STORAGE_H
+#define ARCHETYPE_STORAGE_H
+
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ecs/Component.h"
+
+namespace JJM {
+namespace ECS {
+
+class Entity;
+class Archetype;
+
+using ComponentTypeID = uint32_t;
+
+constexpr size_t MAX_COMPONENT_TYPES = 64;
+constexpr ComponentTypeID INVALID_COMPONENT_TYPE = static_cast<ComponentTypeID>(-1);
+
+/**
+ * @brief Bitmask of component types, one bit per ComponentTypeID
+ */
+using ComponentMask = std::bitset<MAX_COMPONENT_TYPES>;
+
+/**
+ * @brief Type-erased, contiguous column holding every component of one type in an archetype
+ */
+class IComponentColumn {
+   public:
+    virtual ~IComponentColumn() = default;
+
+    virtual size_t size() const = 0;
+    virtual void reserve(size_t capacity) = 0;
+    virtual Component* at(size_t row) = 0;
+
+    // Move the component at `row` of `source` (same type) onto the end of this column
+    virtual void pushFrom(IComponentColumn& source, size_t row) = 0;
+
+    // Remove `row` by moving the last element into it
+    virtual void swapRemove(size_t row) = 0;
+
+    // Call destroy() on the component at `row` and then swap-remove it
+    virtual void destroyAt(size_t row) = 0;
+
+    // Update rows flagged in `activeRows`, skipping disabled components
+    virtual void update(float deltaTime, const std::vector<uint8_t>& activeRows) = 0;
+
+    virtual std::unique_ptr<IComponentColumn> createEmpty() const = 0;
+};
+
+template <typename T>
+class ComponentColumn : public IComponentColumn {
+   public:
+    size_t size() const override { return data.size(); }
+    void reserve(size_t capacity) override { data.reserve(capacity); }
+    Component* at(size_t row) override { return &data[row]; }
+
+    void pushFrom(IComponentColumn& source, size_t row) override {
+        auto& typed = static_cast<ComponentColumn<T>&>(source);
+        data.push_back(std::move(typed.data[row]));
+    }
+
+    void swapRemove(size_t row) override {
+        if (row + 1 != data.size()) {
+            data[row] = std::move(data.back());
+        }
+        data.pop_back();
+    }
+
+    void destroyAt(size_t row) override {
+        data[row].destroy();
+        swapRemove(row);
+    }
+
+    void update(float deltaTime, const std::vector<uint8_t>& activeRows) override {
+        // Qualified call: the concrete type is known, so skip the virtual dispatch
+        for (size_t i = 0; i < data.size(); ++i) {
+            if (activeRows[i] && data[i].isEnabled()) {
+                data[i].T::update(deltaTime);
+            }
+        }
+    }
+
+    std::unique_ptr<IComponentColumn> createEmpty() const override {
+        return std::make_unique<ComponentColumn<T>>();
+    }
+
+    T* raw() { return data.data(); }
+
+    template <typename... Args>
+    T& emplace(Args&&... args) {
+        data.emplace_back(std::forward<Args>(args)...);
+        return data.back();
+    }
+
+   private:
+    std::vector<T> data;
+};
+
+/**
+ * @brief Assigns dense IDs to component types so they can be used as bitmask indices
+ */
+class ComponentTypeRegistry {
+   public:
+    // Registering more than MAX_COMPONENT_TYPES types throws std::length_error
+    template <typename T>
+    static ComponentTypeID id() {
+        static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+        static const ComponentTypeID value =
+            registerType(std::type_index(typeid(T)), prototype<T>());
+        return value;
+    }
+
+    // Returns INVALID_COMPONENT_TYPE if the type has not been registered yet
+    static ComponentTypeID find(std::type_index type);
+
+    // Registers the type without a column prototype (used to build query masks for types
+    // that have not been instantiated as components yet)
+    static ComponentTypeID getOrRegister(std::type_index type);
+
+    static std::unique_ptr<IComponentColumn> createColumn(ComponentTypeID id);
+
+    static size_t getTypeCount();
+
+   private:
+    static ComponentTypeID registerType(std::type_index type,
+                                        std::unique_ptr<IComponentColumn> prototype);
+
+    // Abstract bases (e.g. a collider interface) get an ID for lookups but can never be stored
+    template <typename T>
+    static std::unique_ptr<IComponentColumn> prototype() {
+        if constexpr (std::is_abstract<T>::value) {
+            return nullptr;
+        } else {
+            return std::make_unique<ComponentColumn<T>>();
+        }
+    }
+};
+
+/**
+ * @brief Where an entity's components live inside archetype storage
+ */
+struct EntityLocation {
+    Archetype* archetype = nullptr;
+    uint32_t row = 0;
+};
+
+/**
+ * @brief All entities sharing one exact component set, stored column-per-type
+ *
+ * Rows are dense: removing an entity moves the last row into its slot. Pointers to
+ * components are therefore only stable until the next structural change of this
+ * archetype (adding/removing entities or components).
+ */
+class Archetype {
+   public:
+    explicit Archetype(const ComponentMask& mask);
+
+    const ComponentMask& getMask() const { return mask; }
+    size_t size() const { return entities.size(); }
+    bool empty() const { return entities.empty(); }
+
+    bool has(ComponentTypeID type) const { return columnIndex[type] >= 0; }
+
+    IComponentColumn* getColumn(ComponentTypeID type) {
+        int index = columnIndex[type];
+        return index >= 0 ? columns[index].get() : nullptr;
+    }
+
+    template <typename T>
+    ComponentColumn<T>* column() {
+        return static_cast<ComponentColumn<T>*>(getColumn(ComponentTypeRegistry::id<T>()));
+    }
+
+    const std::vector<Entity*>& getEntities() const { return entities; }
+    const std::vector<ComponentTypeID>& getTypes() const { return types; }
+
+   private:
+    friend class ArchetypeStorage;
+
+    ComponentMask mask;
+    std::vector<ComponentTypeID> types;
+    std::vector<std::unique_ptr<IComponentColumn>> columns;
+    std::array<int, MAX_COMPONENT_TYPES> columnIndex;
+
+    // Row bookkeeping, parallel to the columns
+    std::vector<Entity*> entities;
+    std::vector<EntityLocation*> locations;
+
+    // Cached transitions in the archetype graph
+    std::unordered_map<ComponentTypeID, Archetype*> addEdges;
+    std::unordered_map<ComponentTypeID, Archetype*> removeEdges;
+};
+
+template <typename T, typename... Rest>
+class ArchetypeView;
+
+/**
+ * @brief Owns all archetypes of an EntityManager running in archetype mode
+ *
+ * Entities keep their EntityLocation and route component access through here, so
+ * Entity::getComponent<T>() is an array index rather than a hash probe.
+ */
+class ArchetypeStorage {
+   public:
+    ArchetypeStorage();
+    ~ArchetypeStorage();
+
+    ArchetypeStorage(const ArchetypeStorage&) = delete;
+    ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+    template <typename T, typename... Args>
+    T* add(Entity* entity, EntityLocation& location, Args&&... args);
+
+    template <typename T>
+    T* get(const EntityLocation& location) const;
+
+    template <typename T>
+    bool has(const EntityLocation& location) const {
+        return location.archetype && location.archetype->has(ComponentTypeRegistry::id<T>());
+    }
+
+    template <typename T>
+    void remove(EntityLocation& location);
+
+    // Destroy every component of the entity and release its row
+    void removeEntity(EntityLocation& location);
+
+    // Archetypes containing every type in `required` and none in `excluded`
+    std::vector<Archetype*> getMatching(const ComponentMask& required,
+                                        const ComponentMask& excluded = ComponentMask()) const;
+
+    template <typename T, typename... Rest>
+    ArchetypeView<T, Rest...> view();
+
+    template <typename... Ts>
+    static ComponentMask maskOf() {
+        ComponentMask mask;
+        (mask.set(ComponentTypeRegistry::id<Ts>()), ...);
+        return mask;
+    }
+
+    // Update all components column by column
+    void updateComponents(float deltaTime);
+
+    void clear();
+
+    size_t getArchetypeCount() const { return archetypes.size(); }
+    size_t getEntityCount() const;
+
+   private:
+    Archetype* getOrCreateArchetype(const ComponentMask& mask);
+    Archetype* getAddTarget(Archetype* from, ComponentTypeID type);
+    Archetype* getRemoveTarget(Archetype* from, ComponentTypeID type);
+
+    // Move the entity's row into `to`, carrying over the columns both archetypes share
+    void moveEntity(Entity* entity, EntityLocation& location, Archetype* to);
+    uint32_t appendRow(Archetype* archetype, Entity* entity, EntityLocation* location);
+    void releaseRow(Archetype* archetype, uint32_t row);
+
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+    std::vector<Archetype*> archetypeList;
+    Archetype* emptyArchetype;
+
+    // Reused scratch buffer for the active flags passed to column updates
+    std::vector<uint8_t> activeScratch;
+};
+
+/**
+ * @brief Linear iteration over every entity that has all of T, Rest...
+ *
+ * @example
+ * ```cpp
+ * for (auto [entity, body, collider] : manager.view<PhysicsBody, BoxCollider>()) {
+ *     ...
+ * }
+ * manager.view<PhysicsBody>().each([](Entity* e, PhysicsBody& body) { ... });
+ * ```
+ */
+template <typename T, typename... Rest>
+class ArchetypeView {
+   public:
+    using Tuple = std::tuple<Entity*, T&, Rest&...>;
+
+    ArchetypeView() = default;
+    explicit ArchetypeView(std::vector<Archetype*> matching) : archetypes(std::move(matching)) {}
+
+    class Iterator {
+       public:
+        Iterator(const std::vector<Archetype*>* archetypes, size_t archetypeIndex)
+            : archetypes(archetypes), archetypeIndex(archetypeIndex), row(0) {
+            loadArchetype();
+        }
+
+        Tuple operator*() const { return makeTuple(std::index_sequence_for<Rest...>()); }
+
+        Iterator& operator++() {
+            if (++row >= rowCount) {
+                ++archetypeIndex;
+                row = 0;
+                loadArchetype();
+            }
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return archetypeIndex == other.archetypeIndex && row == other.row;
+        }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+       private:
+        void loadArchetype() {
+            // Skip empty archetypes so operator++ never lands on an invalid row
+            while (archetypeIndex < archetypes->size() && (*archetypes)[archetypeIndex]->empty()) {
+                ++archetypeIndex;
+            }
+            if (archetypeIndex < archetypes->size()) {
+                Archetype* archetype = (*archetypes)[archetypeIndex];
+                entities = archetype->getEntities().data();
+                rowCount = archetype->size();
+                columns = std::make_tuple(archetype->column<T>()->raw(),
+                                          archetype->column<Rest>()->raw()...);
+            } else {
+                rowCount = 0;
+            }
+        }
+
+        template <size_t... I>
+        Tuple makeTuple(std::index_sequence<I...>) const {
+            return Tuple(entities[row], std::get<0>(columns)[row],
+                         std::get<I + 1>(columns)[row]...);
+        }
+
+        const std::vector<Archetype*>* archetypes;
+        size_t archetypeIndex;
+        size_t row;
+        size_t rowCount = 0;
+        Entity* const* entities = nullptr;
+        std::tuple<T*, Rest*...> columns;
+    };
+
+    Iterator begin() const { return Iterator(&archetypes, 0); }
+    Iterator end() const { return Iterator(&archetypes, archetypes.size()); }
+
+    // Calls func(Entity*, T&, Rest&...) for every matching entity, one archetype at a time
+    template <typename Func>
+    void each(Func&& func) const {
+        for (Archetype* archetype : archetypes) {
+            const size_t count = archetype->size();
+            if (count == 0) continue;
+            Entity* const* entities = archetype->getEntities().data();
+            T* first = archetype->column<T>()->raw();
+            std::tuple<Rest*...> rest(archetype->column<Rest>()->raw()...);
+            for (size_t i = 0; i < count; ++i) {
+                std::apply([&](Rest*... cols) { func(entities[i], first[i], cols[i]...); },
+                           rest);
+            }
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (Archetype* archetype : archetypes) {
+            total += archetype->size();
+        }
+        return total;
+    }
+
+    const std::vector<Archetype*>& getArchetypes() const { return archetypes; }
+
+   private:
+    std::vector<Archetype*> archetypes;
+};
+
+template <typename T, typename... Args>
+T* ArchetypeStorage::add(Entity* entity, EntityLocation& location, Args&&... args) {
+    const ComponentTypeID type = ComponentTypeRegistry::id<T>();
+    if (location.archetype && location.archetype->has(type)) {
+        return get<T>(location);
+    }
+
+    Archetype* from = location.archetype ? location.archetype : emptyArchetype;
+    Archetype* to = getAddTarget(from, type);
+    moveEntity(entity, location, to);
+
+    // moveEntity appended every shared column; only the new type is still one row short
+    T& component = to->column<T>()->emplace(std::forward<Args>(args)...);
+    return &component;
+}
+
+template <typename T>
+T* ArchetypeStorage::get(const EntityLocation& location) const {
+    if constexpr (std::is_abstract<T>::value) {
+        return nullptr;
+    }
+    if (!location.archetype) return nullptr;
+    ComponentColumn<T>* column = location.archetype->column<T>();
+    return column ? column->raw() + location.row : nullptr;
+}
+
+template <typename T>
+void ArchetypeStorage::remove(EntityLocation& location) {
+    const ComponentTypeID type = ComponentTypeRegistry::id<T>();
+    if (!location.archetype || !location.archetype->has(type)) return;
+
+    Archetype* from = location.archetype;
+    from->getColumn(type)->at(location.row)->destroy();
+    moveEntity(from->entities[location.row], location, getRemoveTarget(from, type));
+}
+
+template <typename T, typename... Rest>
+ArchetypeView<T, Rest...> ArchetypeStorage::view() {
+    return ArchetypeView<T, Rest...>(getMatching(maskOf<T, Rest...>()));
+}
+
+}  // namespace ECS
+}  // namespace JJM
+
+#endif  // ARCHETYPE_STORAGE_H
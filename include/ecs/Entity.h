@@ -2,20 +2,35 @@
 #define ENTITY_H
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <type_traits>
 #include <vector>
 #include <typeindex>
 #include <unordered_map>
 
+#include "ecs/ArchetypeStorage.h"
+#include "ecs/Component.h"
+
 namespace JJM {
 namespace ECS {
 
 // Forward declarations
-class Component;
 class EntityManager;
 
+// Entity IDs are generational handles: the low 32 bits index a slot in the owning
+// EntityManager and the high 32 bits hold the slot's generation at creation time, so a
+// handle to a destroyed entity never resolves to the entity that reuses its slot.
 using EntityID = uint64_t;
 
+constexpr EntityID INVALID_ENTITY_ID = 0;
+
+inline uint32_t getEntityIndex(EntityID id) { return static_cast<uint32_t>(id); }
+inline uint32_t getEntityGeneration(EntityID id) { return static_cast<uint32_t>(id >> 32); }
+inline EntityID makeEntityID(uint32_t index, uint32_t generation) {
+    return (static_cast<EntityID>(generation) << 32) | index;
+}
+
 class Entity {
 private:
     EntityID id;
@@ -23,6 +38,18 @@ private:
     bool active;
     std::unordered_map<std::type_index, std::shared_ptr<Component>> components;
 
+    // Set when the owning manager uses archetype storage; components then live in
+    // contiguous columns and the map above stays empty
+    ArchetypeStorage* storage;
+    EntityLocation location;
+
+    // One bit per component type, kept in sync by add/removeComponent
+    ComponentMask signature;
+
+    friend class EntityManager;
+
+    void onSignatureChanged();
+
 public:
     Entity(EntityID id, EntityManager* manager);
     ~Entity();
@@ -46,15 +73,132 @@ public:
     // Entity management
     EntityID getID() const { return id; }
     bool isActive() const { return active; }
-    void setActive(bool isActive) { active = isActive; }
+    // Deactivated entities are destroyed by the manager's next update()
+    void setActive(bool isActive);
     void destroy();
 
-    // Get all components
+    bool usesArchetypeStorage() const { return storage != nullptr; }
+    const EntityLocation& getLocation() const { return location; }
+    const ComponentMask& getSignature() const { return signature; }
+
+    // Get all components. Legacy storage only: in archetype mode components live by value
+    // in the archetype's columns and this map is always empty; use forEachComponent, which
+    // works in both modes
     const std::unordered_map<std::type_index, std::shared_ptr<Component>>& getComponents() const {
         return components;
     }
+
+    // Visit every component, whichever storage the entity uses. In archetype mode the
+    // pointers are only valid until the entity's component set next changes
+    void forEachComponent(const std::function<void(Component*)>& callback) const;
 };
 
+template<typename T, typename... Args>
+T* Entity::addComponent(Args&&... args) {
+    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+    
+    if (storage) {
+        if (T* existing = storage->get<T>(location)) {
+            return existing;
+        }
+        T* component = storage->add<T>(this, location, std::forward<Args>(args)...);
+        component->setOwner(this);
+        component->init();
+        signature.set(ComponentTypeRegistry::id<T>());
+        onSignatureChanged();
+        return component;
+    }
+    
+    std::type_index typeIndex(typeid(T));
+    
+    // Check if component already exists
+    if (components.find(typeIndex) != components.end()) {
+        return static_cast<T*>(components[typeIndex].get());
+    }
+    
+    // Create new component
+    auto component = std::make_shared<T>(std::forward<Args>(args)...);
+    component->setOwner(this);
+    components[typeIndex] = component;
+    component->init();
+    signature.set(ComponentTypeRegistry::id<T>());
+    onSignatureChanged();
+    
+    return component.get();
+}
+
+template<typename T>
+T* Entity::getComponent() {
+    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+    
+    if (storage) {
+        return storage->get<T>(location);
+    }
+    
+    std::type_index typeIndex(typeid(T));
+    auto it = components.find(typeIndex);
+    
+    if (it != components.end()) {
+        return static_cast<T*>(it->second.get());
+    }
+    
+    return nullptr;
+}
+
+template<typename T>
+const T* Entity::getComponent() const {
+    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+    
+    if (storage) {
+        return storage->get<T>(location);
+    }
+    
+    std::type_index typeIndex(typeid(T));
+    auto it = components.find(typeIndex);
+    
+    if (it != components.end()) {
+        return static_cast<const T*>(it->second.get());
+    }
+    
+    return nullptr;
+}
+
+template<typename T>
+bool Entity::hasComponent() const {
+    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+    
+    if (storage) {
+        return storage->has<T>(location);
+    }
+    
+    std::type_index typeIndex(typeid(T));
+    return components.find(typeIndex) != components.end();
+}
+
+template<typename T>
+void Entity::removeComponent() {
+    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
+    
+    if (storage) {
+        if (storage->has<T>(location)) {
+            storage->remove<T>(location);
+            signature.reset(ComponentTypeRegistry::id<T>());
+            onSignatureChanged();
+        }
+        return;
+    }
+    
+    std::type_index typeIndex(typeid(T));
+    auto it = components.find(typeIndex);
+    
+    if (it != components.end()) {
+        it->second->destroy();
+        components.erase(it);
+        signature.reset(ComponentTypeRegistry::id<T>());
+        onSignatureChanged();
+    }
+}
+
 } // namespace ECS
 } // namespace JJM
 
@@ -2,15 +2,20 @@
 #define ENTITY_MANAGER_H
 
 #include <algorithm>
+#include <cstdint>
+#include <tuple>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <typeindex>
 #include <unordered_set>
 #include <vector>
 
+#include "ecs/ArchetypeStorage.h"
 #include "ecs/Component.h"
 #include "ecs/Entity.h"
+#include "ecs/SystemScheduler.h"
 
 namespace JJM {
 namespace ECS {
@@ -45,6 +50,8 @@ class EntityGroup {
     std::unordered_set<Entity*> entities;
 };
 
+class EntityManager;
+
 // System base class for ECS systems
 class System {
    public:
@@ -53,54 +60,178 @@ class System {
     virtual void onEntityAdded(Entity* entity) {}
     virtual void onEntityRemoved(Entity* entity) {}
 
+    // Name reported to the profiler
+    virtual std::string getName() const { return typeid(*this).name(); }
+
     void setEnabled(bool enabled) { m_enabled = enabled; }
     bool isEnabled() const { return m_enabled; }
     int getPriority() const { return m_priority; }
     void setPriority(int priority) { m_priority = priority; }
 
+    // Component access used by the parallel scheduler. A system that declares nothing is
+    // exclusive and never runs alongside another system.
+    const ComponentMask& getReadMask() const { return m_reads; }
+    const ComponentMask& getWriteMask() const { return m_writes; }
+    bool isExclusive() const { return m_exclusive || (m_reads.none() && m_writes.none()); }
+
+    bool conflictsWith(const System& other) const {
+        if (isExclusive() || other.isExclusive()) return true;
+        return (m_writes & (other.m_reads | other.m_writes)).any() ||
+               (other.m_writes & m_reads).any();
+    }
+
    protected:
+    template <typename T>
+    void reads() {
+        m_reads.set(ComponentTypeRegistry::id<T>());
+    }
+    template <typename T>
+    void writes() {
+        m_writes.set(ComponentTypeRegistry::id<T>());
+    }
+
+    // Systems that create/destroy entities, add/remove components or touch other shared
+    // state must run exclusively
+    void setExclusive(bool exclusive) { m_exclusive = exclusive; }
+
+    EntityManager* getEntityManager() const { return m_manager; }
+
     bool m_enabled = true;
     int m_priority = 0;
+
+   private:
+    friend class EntityManager;
+
+    ComponentMask m_reads;
+    ComponentMask m_writes;
+    bool m_exclusive = false;
+    EntityManager* m_manager = nullptr;
+};
+
+// Told when an entity starts or stops having every component in the mask it was added
+// with, so a subsystem can keep its own index of entities instead of querying each step
+class EntityObserver {
+   public:
+    virtual ~EntityObserver() = default;
+    virtual void onEntityAdded(Entity* entity) = 0;
+    // Called while the entity and its remaining components are still alive
+    virtual void onEntityRemoved(Entity* entity) = 0;
+};
+
+// Component storage backend used by an EntityManager
+enum class StorageMode {
+    LEGACY,    // Per-entity component map (default)
+    ARCHETYPE  // Components packed into per-archetype columns
 };
 
 class EntityManager {
    private:
+    // Declared before the entity list so it outlives the entities' destructors
+    std::unique_ptr<ArchetypeStorage> archetypeStorage;
+    StorageMode storageMode = StorageMode::LEGACY;
+
+    // Sparse set keyed by the handle index: slots map index -> position in the dense
+    // entity array, and freed slots are recycled with a bumped generation
+    struct EntitySlot {
+        uint32_t generation = 1;
+        uint32_t denseIndex = INVALID_DENSE_INDEX;
+    };
+    static constexpr uint32_t INVALID_DENSE_INDEX = UINT32_MAX;
+
     std::vector<std::unique_ptr<Entity>> entities;
-    EntityID nextID;
+    std::vector<EntitySlot> slots;
+    std::vector<uint32_t> freeSlots;
 
     // Entity groups for tag-based queries
     std::unordered_map<std::string, EntityGroup> tagGroups;
 
-    // Query result caching
+    // Query result caching. Cached queries are keyed by the component/tag part of the
+    // filter and kept up to date incrementally as entities change; activeOnly and
+    // customFilter are applied when results are read.
+    struct QueryKey {
+        ComponentMask required;
+        ComponentMask excluded;
+        std::string tag;
+
+        bool operator==(const QueryKey& other) const {
+            return required == other.required && excluded == other.excluded &&
+                   tag == other.tag;
+        }
+    };
+    struct QueryKeyHash {
+        size_t operator()(const QueryKey& key) const {
+            size_t hash = std::hash<ComponentMask>()(key.required);
+            hash ^= std::hash<ComponentMask>()(key.excluded) + 0x9e3779b9 + (hash << 6) +
+                    (hash >> 2);
+            hash ^= std::hash<std::string>()(key.tag) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+            return hash;
+        }
+    };
     struct QueryCache {
-        EntityFilter filter;
         std::vector<Entity*> results;
-        bool dirty;
-        size_t lastEntityCount;
-
-        QueryCache() : dirty(true), lastEntityCount(0) {}
+        // Position + 1 of each entity in results, indexed by entity slot (0 = absent)
+        std::vector<uint32_t> positions;
+        bool dirty = true;
+        uint64_t lastUsed = 0;
     };
-    std::vector<QueryCache> queryCaches;
+    static constexpr size_t MAX_QUERY_CACHES = 32;
+    std::unordered_map<QueryKey, QueryCache, QueryKeyHash> queryCaches;
+    uint64_t queryCacheClock = 0;
     size_t cacheHits = 0;
     size_t cacheMisses = 0;
 
+    // Guards queryCached(), which systems may call concurrently
+    std::mutex queryCacheMutex;
+
     // Systems
     std::vector<std::unique_ptr<System>> systems;
+    std::vector<System*> scheduledSystems;
     bool systemsSorted = false;
+    SystemScheduler scheduler;
+
+    // Observers, with whether each entity slot currently matches
+    struct ObserverEntry {
+        EntityObserver* observer;
+        ComponentMask required;
+        std::vector<uint8_t> present;
+    };
+    std::vector<ObserverEntry> observers;
 
     // Deferred operations
     std::vector<EntityID> entitiesToDestroy;
+    // Entities switched off since the last update; those still inactive are destroyed
+    std::vector<EntityID> deactivatedEntities;
     bool processingUpdate = false;
 
     // Entity callbacks
     std::function<void(Entity*)> onEntityCreated;
     std::function<void(Entity*)> onEntityDestroyed;
 
+    void removeFromTagGroups(Entity* entity);
+
+    QueryKey makeQueryKey(const EntityFilter& filter) const;
+    bool matchesKey(Entity* entity, const QueryKey& key) const;
+    bool matchesFilter(Entity* entity, const EntityFilter& filter, const QueryKey& key) const;
+
+    // Incremental cache maintenance
+    void rebuildQueryCache(const QueryKey& key, QueryCache& cache);
+    void updateQueryMembership(Entity* entity);
+    void removeFromQueryCaches(Entity* entity);
+    void notifyObservers(Entity* entity);
+    void removeFromObservers(Entity* entity);
+    static void cacheInsert(QueryCache& cache, Entity* entity);
+    static void cacheErase(QueryCache& cache, Entity* entity);
+
    public:
     EntityManager();
     ~EntityManager();
 
-    // Entity management
+    // Storage backend; can only be changed while the manager has no entities
+    bool setStorageMode(StorageMode mode);
+    StorageMode getStorageMode() const { return storageMode; }
+    ArchetypeStorage* getArchetypeStorage() { return archetypeStorage.get(); }
+
+    // Entity management (lookup, destroy and liveness checks are O(1))
     Entity* createEntity();
     Entity* createEntity(const std::string& tag);
     void destroyEntity(EntityID id);
@@ -108,6 +239,7 @@ class EntityManager {
     void destroyAllEntities();
     void destroyEntitiesWithTag(const std::string& tag);
     Entity* getEntity(EntityID id);
+    bool isAlive(EntityID id) const;
 
     // Deferred destruction
     void destroyEntityDeferred(EntityID id);
@@ -141,13 +273,23 @@ class EntityManager {
     template <typename T>
     void forEachWith(std::function<void(Entity*, T*)> callback);
 
+    // Linear column iteration over entities with all of T, Rest... (archetype mode only;
+    // returns an empty view in legacy mode)
+    template <typename T, typename... Rest>
+    ArchetypeView<T, Rest...> view();
+
     // Query caching
     std::vector<Entity*> queryCached(const EntityFilter& filter);
+    // Forces every cached query to rebuild on next use (normally not needed: caches follow
+    // entity and component changes incrementally)
     void invalidateQueryCaches();
     void clearQueryCaches();
     void getCacheStatistics(size_t& hits, size_t& misses) const;
 
     std::vector<Entity*> getAllEntities();
+    // Appends the active entities to `out`, for callers with their own (e.g. frame) storage
+    template <typename Container>
+    void getAllEntities(Container& out);
 
     // System management
     template <typename T, typename... Args>
@@ -159,30 +301,68 @@ class EntityManager {
     template <typename T>
     void removeSystem();
 
+    // Runs enabled systems in ascending priority order; with a JobSystem attached,
+    // systems whose declared component access does not conflict run concurrently
     void updateSystems(float deltaTime);
     void sortSystems();
 
+    void setJobSystem(Threading::JobSystem* jobSystem) { scheduler.setJobSystem(jobSystem); }
+    SystemScheduler& getScheduler() { return scheduler; }
+
+    // Calls func(Entity*, T&, Rest&...) for active entities with all of T, Rest..., split
+    // into chunks of `chunkSize` that run on the JobSystem. Must not change entity structure.
+    template <typename T, typename... Rest, typename Func>
+    void parallelForEach(Func&& func, size_t chunkSize = 256);
+
     // Update all entities
     void update(float deltaTime);
 
     // Clear all entities
     void clear();
 
+    // Pre-size the slot table and entity array
+    void reserve(size_t count);
+
     // Entity callbacks
     void setOnEntityCreated(std::function<void(Entity*)> callback) { onEntityCreated = callback; }
     void setOnEntityDestroyed(std::function<void(Entity*)> callback) {
         onEntityDestroyed = callback;
     }
 
+    // Called by Entity when a component is added or removed
+    void onEntitySignatureChanged(Entity* entity);
+
+    // Called by Entity::setActive(false)
+    void onEntityDeactivated(Entity* entity);
+
+    // Report entities gaining or losing all of `required` to the observer; entities that
+    // already match are reported straight away. Inactive entities still count as matching.
+    // The observer must be removed before it is destroyed
+    void addObserver(EntityObserver* observer, const ComponentMask& required);
+    template <typename... Ts>
+    void addObserver(EntityObserver* observer) {
+        addObserver(observer, ArchetypeStorage::maskOf<Ts...>());
+    }
+    void removeObserver(EntityObserver* observer);
+
     // Statistics
     size_t getEntityCount() const { return entities.size(); }
     size_t getActiveEntityCount() const;
     size_t getSystemCount() const { return systems.size(); }
+    size_t getQueryCacheCount() const { return queryCaches.size(); }
 };
 
 template <typename T>
 std::vector<Entity*> EntityManager::getEntitiesWithComponent() {
     std::vector<Entity*> result;
+    if (archetypeStorage) {
+        view<T>().each([&result](Entity* entity, T&) {
+            if (entity->isActive()) {
+                result.push_back(entity);
+            }
+        });
+        return result;
+    }
     for (auto& entity : entities) {
         if (entity->isActive() && entity->hasComponent<T>()) {
             result.push_back(entity.get());
@@ -194,6 +374,17 @@ std::vector<Entity*> EntityManager::getEntitiesWithComponent() {
 template <typename T, typename U, typename... Args>
 std::vector<Entity*> EntityManager::getEntitiesWithComponents() {
     std::vector<Entity*> result;
+    if (archetypeStorage) {
+        auto matching = archetypeStorage->getMatching(ArchetypeStorage::maskOf<T, U, Args...>());
+        for (Archetype* archetype : matching) {
+            for (Entity* entity : archetype->getEntities()) {
+                if (entity->isActive()) {
+                    result.push_back(entity);
+                }
+            }
+        }
+        return result;
+    }
     for (auto& entity : entities) {
         if (entity->isActive() && entity->hasComponent<T>() && entity->hasComponent<U>()) {
             bool hasAll = true;
@@ -219,8 +410,25 @@ std::vector<Entity*> EntityManager::getEntitiesWithoutComponent() {
     return result;
 }
 
+template <typename Container>
+void EntityManager::getAllEntities(Container& out) {
+    for (auto& entity : entities) {
+        if (entity->isActive()) {
+            out.push_back(entity.get());
+        }
+    }
+}
+
 template <typename T>
 void EntityManager::forEachWith(std::function<void(Entity*, T*)> callback) {
+    if (archetypeStorage) {
+        view<T>().each([&callback](Entity* entity, T& component) {
+            if (entity->isActive()) {
+                callback(entity, &component);
+            }
+        });
+        return;
+    }
     for (auto& entity : entities) {
         if (entity->isActive()) {
             T* component = entity->getComponent<T>();
@@ -231,10 +439,69 @@ void EntityManager::forEachWith(std::function<void(Entity*, T*)> callback) {
     }
 }
 
+template <typename T, typename... Rest>
+ArchetypeView<T, Rest...> EntityManager::view() {
+    if (!archetypeStorage) {
+        return ArchetypeView<T, Rest...>();
+    }
+    return archetypeStorage->view<T, Rest...>();
+}
+
+template <typename T, typename... Rest, typename Func>
+void EntityManager::parallelForEach(Func&& func, size_t chunkSize) {
+    if (chunkSize == 0) chunkSize = 1;
+
+    if (archetypeStorage) {
+        struct Chunk {
+            Archetype* archetype;
+            size_t begin;
+            size_t end;
+        };
+        std::vector<Chunk> chunks;
+        auto matching = archetypeStorage->getMatching(ArchetypeStorage::maskOf<T, Rest...>());
+        for (Archetype* archetype : matching) {
+            for (size_t begin = 0; begin < archetype->size(); begin += chunkSize) {
+                chunks.push_back({archetype, begin, std::min(begin + chunkSize, archetype->size())});
+            }
+        }
+
+        scheduler.parallelFor(chunks.size(), [&chunks, &func](size_t index) {
+            const Chunk& chunk = chunks[index];
+            Entity* const* chunkEntities = chunk.archetype->getEntities().data();
+            T* first = chunk.archetype->template column<T>()->raw();
+            std::tuple<Rest*...> rest(chunk.archetype->template column<Rest>()->raw()...);
+            for (size_t i = chunk.begin; i < chunk.end; ++i) {
+                if (!chunkEntities[i]->isActive()) continue;
+                std::apply([&](Rest*... cols) { func(chunkEntities[i], first[i], cols[i]...); },
+                           rest);
+            }
+        });
+        return;
+    }
+
+    std::vector<Entity*> matching;
+    for (auto& entity : entities) {
+        if (entity->isActive() && entity->hasComponent<T>() &&
+            (entity->template hasComponent<Rest>() && ...)) {
+            matching.push_back(entity.get());
+        }
+    }
+
+    const size_t chunkCount = (matching.size() + chunkSize - 1) / chunkSize;
+    scheduler.parallelFor(chunkCount, [&matching, &func, chunkSize](size_t index) {
+        const size_t end = std::min((index + 1) * chunkSize, matching.size());
+        for (size_t i = index * chunkSize; i < end; ++i) {
+            Entity* entity = matching[i];
+            func(entity, *entity->getComponent<T>(), *entity->template getComponent<Rest>()...);
+        }
+    });
+}
+
 template <typename T, typename... Args>
 T* EntityManager::addSystem(Args&&... args) {
     auto system = std::make_unique<T>(std::forward<Args>(args)...);
     T* ptr = system.get();
+    ptr->m_manager = this;
     systems.push_back(std::move(system));
     systemsSorted = false;
     return ptr;
@@ -0,0 +1,112 @@
+/**
+ * @file SystemScheduler.h
+ * @brief Runs ECS systems concurrently based on their declared component access
+ * @version 1.0.0
+ * @date 2026-10-15
+ */
+
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
+namespace ECS {
+
+class System;
+
+/**
+ * @brief Per-frame dependency graph of systems executed on the JobSystem
+ *
+ * Systems are ordered by priority. Each frame a DAG is built in which a system depends on
+ * every earlier system it conflicts with (write/read or write/write on the same component
+ * type, or either side exclusive). Non-conflicting systems run concurrently; conflicting
+ * ones keep their priority order. Without a JobSystem everything runs serially.
+ */
+class SystemScheduler {
+   public:
+    struct SystemTiming {
+        std::string name;
+        double timeMs = 0.0;
+        double startMs = 0.0;  // Relative to the start of the frame's system update
+    };
+
+    struct FrameStats {
+        size_t systemCount = 0;
+        size_t dependencyEdges = 0;
+        size_t criticalPathLength = 0;  // Systems on the longest dependency chain
+        size_t maxConcurrency = 0;      // Most systems observed running at once
+        double wallTimeMs = 0.0;
+        double totalSystemTimeMs = 0.0;
+        double parallelism = 0.0;  // totalSystemTimeMs / wallTimeMs
+    };
+
+    SystemScheduler();
+    ~SystemScheduler();
+
+    void setJobSystem(Threading::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+    Threading::JobSystem* getJobSystem() const { return m_jobSystem; }
+
+    // Report per-system timings and frame parallelism to Utils::PerformanceProfiler
+    void setProfilingEnabled(bool enabled) { m_profilingEnabled = enabled; }
+    bool isProfilingEnabled() const { return m_profilingEnabled; }
+
+    // Run systems (already in priority order); returns after all have finished
+    void run(const std::vector<System*>& systems, float deltaTime);
+
+    // Run job(i) for i in [0, count), spreading indices across workers and helping on the
+    // calling thread until all are done
+    void parallelFor(size_t count, const std::function<void(size_t)>& job);
+
+    const FrameStats& getLastFrameStats() const { return m_stats; }
+    const std::vector<SystemTiming>& getLastTimings() const { return m_timings; }
+
+   private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    void buildGraph(const std::vector<System*>& systems);
+    void runSerial(const std::vector<System*>& systems, float deltaTime);
+    void runParallel(const std::vector<System*>& systems, float deltaTime);
+    void runSystem(size_t index, float deltaTime);
+    void submitSystem(size_t index, float deltaTime);
+    void finishFrame(Clock::time_point frameStart);
+
+    Threading::JobSystem* m_jobSystem;
+    bool m_profilingEnabled;
+
+    // Graph state, reused across frames
+    const std::vector<System*>* m_systems;
+    std::vector<std::vector<size_t>> m_dependents;
+    std::vector<int> m_dependencyCounts;
+    std::unique_ptr<std::atomic<int>[]> m_pending;
+    size_t m_pendingCapacity;
+    std::atomic<size_t> m_remaining;
+    std::atomic<size_t> m_running;
+    std::atomic<size_t> m_maxRunning;
+
+    std::vector<SystemTiming> m_timings;
+    std::vector<Clock::time_point> m_startTimes;
+    std::vector<Clock::time_point> m_endTimes;
+    Clock::time_point m_frameStart;
+    FrameStats m_stats;
+
+    std::mutex m_exceptionMutex;
+    std::exception_ptr m_exception;
+};
+
+}  // namespace ECS
+}  // namespace JJM
+
+#endif  // SYSTEM_SCHEDULER_H
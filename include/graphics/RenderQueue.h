@@ -4,6 +4,11 @@
 #include <vector>
 #include <functional>
 #include <map>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "memory/MemoryPool.h"
 
 namespace JJM {
 namespace Graphics {
@@ -15,6 +20,10 @@ struct RenderCommand {
     int priority;
     float distance;
     std::function<void()> execute;
+    // Set instead of execute for commands built with emplace(): the callable lives in the
+    // submitting thread's frame allocator
+    void (*invoke)(void*) = nullptr;
+    void* payload = nullptr;
     
     bool operator<(const RenderCommand& other) const {
         if (layer != other.layer) return layer < other.layer;
@@ -28,6 +37,10 @@ public:
     static RenderQueue& getInstance();
     
     void submit(RenderLayer layer, std::function<void()> command, int priority = 0, float distance = 0.0f);
+    // Builds the command in frame memory instead of a std::function, so it must be executed
+    // before the frame after next and capture only trivially destructible state
+    template <typename F>
+    void emplace(RenderLayer layer, F&& command, int priority = 0, float distance = 0.0f);
     void sort();
     void execute();
     void clear();
@@ -43,6 +56,30 @@ private:
     bool sorted;
 };
 
+template <typename F>
+void RenderQueue::emplace(RenderLayer layer, F&& command, int priority, float distance) {
+    using Callable = typename std::decay<F>::type;
+    static_assert(std::is_trivially_destructible<Callable>::value,
+                  "frame-allocated render commands are never destroyed");
+    
+    Memory::StackAllocator* frame = Memory::MemoryManager::getInstance()->getFrameAllocator();
+    void* memory = frame ? frame->allocate(sizeof(Callable), alignof(Callable)) : nullptr;
+    if (!memory) {
+        submit(layer, std::function<void()>(std::forward<F>(command)), priority, distance);
+        return;
+    }
+    
+    RenderCommand cmd;
+    cmd.layer = layer;
+    cmd.priority = priority;
+    cmd.distance = distance;
+    cmd.payload = new (memory) Callable(std::forward<F>(command));
+    cmd.invoke = [](void* payload) { (*static_cast<Callable*>(payload))(); };
+    
+    commands.push_back(std::move(cmd));
+    sorted = false;
+}
+
 } // namespace Graphics
 } // namespace JJM
 
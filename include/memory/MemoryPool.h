@@ -11,11 +11,14 @@
 #include <array>
 #include <bitset>
 #include <chrono>
+#include <map>
 #include <unordered_map>
 
 namespace JJM {
 namespace Memory {
 
+class MemoryPool;
+
 // =============================================================================
 // Memory Block
 // =============================================================================
@@ -305,6 +308,9 @@ public:
 
 /**
  * @brief Memory arena for temporary allocations
+ *
+ * Each thread bumps through a chunk of its own without locking; the mutex is only taken
+ * to hand out another chunk. reset() and clear() must not race with allocate().
  */
 class MemoryArena {
 private:
@@ -315,12 +321,20 @@ private:
         Chunk* next;
     };
     
+    // One per thread slot; written only by the thread holding the slot
+    struct alignas(64) ThreadCursor {
+        Chunk* chunk;
+        std::atomic<size_t> bytesUsed;
+    };
+    
     size_t m_defaultChunkSize;
-    Chunk* m_currentChunk;
-    Chunk* m_firstChunk;
+    Chunk* m_currentChunk;          // Shared by threads without a slot
+    Chunk* m_firstChunk;            // Chunks handed out since the last reset
+    Chunk* m_spareChunks;           // Chunks kept by reset() for reuse
+    std::unique_ptr<ThreadCursor[]> m_cursors;
     
     size_t m_totalAllocated;
-    size_t m_totalUsed;
+    std::atomic<size_t> m_sharedBytesUsed;
     
     mutable std::mutex m_mutex;
     
@@ -328,6 +342,9 @@ public:
     MemoryArena(size_t defaultChunkSize = 64 * 1024);
     ~MemoryArena();
     
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+    
     void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
     
     template<typename T, typename... Args>
@@ -340,48 +357,77 @@ public:
     void clear();                   // Free all memory
     
     size_t getTotalAllocated() const { return m_totalAllocated; }
-    size_t getTotalUsed() const { return m_totalUsed; }
+    size_t getTotalUsed() const;
     
 private:
-    void allocateNewChunk(size_t minSize);
+    Chunk* acquireChunk(size_t minSize);
+    static void* allocateFromChunk(Chunk* chunk, size_t size, size_t alignment);
+    static void releaseThreadSlot(void* arena, size_t slot);
 };
 
+/**
+ * @brief Fixed-size block pool
+ *
+ * Blocks live in one slab. Each thread keeps a small cache of free block indices that
+ * only it touches, so most allocations and frees take no lock and no atomic. Caches
+ * refill from and spill to a shared lock-free free list in batches, which is also how a
+ * block freed on another thread finds its way back. Ownership is a range check.
+ */
 class MemoryPool {
 private:
+    struct ThreadCache;
+    
     size_t blockSize;
+    size_t numBlocks;
     size_t poolSize;
     void* poolMemory;
+    char* poolBegin;
+    char* poolEnd;
     
-    MemoryBlock* freeList;
-    std::vector<MemoryBlock*> allBlocks;
+    // Shared free list: (tag << 32) | (block index + 1), with the next links kept outside
+    // the blocks. The tag changes on every update so a stale pop can't succeed.
+    std::atomic<uint64_t> freeHead;
+    std::unique_ptr<std::atomic<uint32_t>[]> nextFree;
     
-    mutable std::mutex poolMutex;
-    std::atomic<size_t> allocatedBytes;
-    std::atomic<size_t> allocatedBlocks;
+    std::unique_ptr<ThreadCache[]> caches;
+    size_t cacheCapacity;
+    std::atomic<size_t> sharedAllocations;      // From threads without a cache slot
+    std::atomic<size_t> sharedDeallocations;
     
 public:
     MemoryPool(size_t blockSize, size_t numBlocks);
     ~MemoryPool();
     
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+    
+    // Returns nullptr once every block is in use (or cached by another thread)
     void* allocate();
     void deallocate(void* ptr);
     
     size_t getBlockSize() const { return blockSize; }
-    size_t getTotalBlocks() const { return allBlocks.size(); }
-    size_t getAllocatedBlocks() const { return allocatedBlocks; }
-    size_t getFreeBlocks() const { return getTotalBlocks() - allocatedBlocks; }
+    size_t getTotalBlocks() const { return numBlocks; }
+    size_t getAllocatedBlocks() const;
+    size_t getFreeBlocks() const { return getTotalBlocks() - getAllocatedBlocks(); }
     
-    size_t getAllocatedBytes() const { return allocatedBytes; }
+    size_t getAllocatedBytes() const { return getAllocatedBlocks() * blockSize; }
     size_t getTotalBytes() const { return poolSize; }
+    const void* getBaseAddress() const { return poolBegin; }
     
     double getUtilization() const;
     
+    bool owns(const void* ptr) const {
+        return static_cast<const char*>(ptr) >= poolBegin &&
+               static_cast<const char*>(ptr) < poolEnd;
+    }
     bool isValidPointer(void* ptr) const;
     void defragment();
     
 private:
     void initializePool();
-    MemoryBlock* findBlock(void* ptr) const;
+    uint32_t popFree(uint32_t* out, uint32_t maxCount);
+    void pushFree(const uint32_t* indices, uint32_t count);
+    static void releaseThreadSlot(void* pool, size_t slot);
 };
 
 class StackAllocator {
@@ -402,6 +448,7 @@ public:
     ~StackAllocator();
     
     void* allocate(size_t bytes, size_t alignment = sizeof(void*));
+    void release(void* ptr, size_t bytes);  // Only the latest allocation is given back
     void pushMarker(const char* label = nullptr);
     void popMarker();
     void popToMarker(const char* label);
@@ -411,6 +458,11 @@ public:
     size_t getFreeBytes() const { return size - offset; }
     size_t getTotalBytes() const { return size; }
     
+    bool owns(const void* ptr) const {
+        return static_cast<const char*>(ptr) >= static_cast<const char*>(memory) &&
+               static_cast<const char*>(ptr) < static_cast<const char*>(memory) + size;
+    }
+    
     double getUtilization() const;
     
 private:
@@ -511,15 +563,49 @@ private:
     void allocateNewChunk();
 };
 
+/**
+ * @brief Owner of named pools, routing unnamed allocations by size class
+ *
+ * Sizes map to 16-byte classes up to 1 KiB and power-of-two classes up to 1 MiB; each
+ * class points at the smallest pool that fits it. Frees find their pool through a sorted
+ * table of pool ranges. Both tables are read without locking.
+ *
+ * Frame allocators are per thread and double-buffered: beginFrame() switches every thread
+ * to its other buffer, which is cleared on that thread's next use. Data allocated during
+ * frame N therefore stays valid through frame N+1, while the renderer consumes it.
+ */
 class MemoryManager {
+public:
+    static constexpr size_t SIZE_CLASS_COUNT = 75;
+    static constexpr size_t MAX_POOLED_SIZE = size_t(1) << 20;
+    
+    static size_t sizeClass(size_t size);
+    static size_t sizeClassBytes(size_t sizeClass);
+    
 private:
+    struct PoolRange {
+        const char* begin;
+        MemoryPool* pool;
+    };
+    
     std::vector<std::unique_ptr<MemoryPool>> pools;
     std::vector<std::unique_ptr<ObjectPool>> objectPools;
-    std::unique_ptr<StackAllocator> frameAllocator;
+    
+    // One per thread slot, created by (and only touched by) the thread holding the slot
+    struct ThreadFrameBuffers;
+    std::unique_ptr<std::atomic<ThreadFrameBuffers*>[]> threadFrameBuffers;
+    size_t frameAllocatorSize;
+    std::atomic<uint64_t> frameIndex;
     
     mutable std::mutex managerMutex;
     std::atomic<size_t> totalAllocatedBytes;
     
+    // Rebuilt under managerMutex when pools change; range tables are kept until shutdown
+    // because readers may still hold an old one
+    std::array<std::atomic<MemoryPool*>, SIZE_CLASS_COUNT> sizeClassPools;
+    std::atomic<const std::vector<PoolRange>*> poolRanges;
+    std::vector<std::unique_ptr<std::vector<PoolRange>>> poolRangeTables;
+    
     static MemoryManager* instance;
     MemoryManager();
     
@@ -536,12 +622,18 @@ public:
     ObjectPool* createObjectPool(const std::string& name, size_t objectSize, size_t objectsPerChunk = 64);
     ObjectPool* getObjectPool(const std::string& name);
     
-    StackAllocator* getFrameAllocator() { return frameAllocator.get(); }
+    // The calling thread's allocator for the current frame; nullptr if it has no thread slot
+    StackAllocator* getFrameAllocator();
+    void beginFrame();
+    uint64_t getFrameIndex() const { return frameIndex.load(std::memory_order_relaxed); }
     
-    void* allocate(size_t size, const std::string& poolName = "");
-    void deallocate(void* ptr, const std::string& poolName = "");
+    void* allocate(size_t size);
+    void* allocate(size_t size, const std::string& poolName);
+    void deallocate(void* ptr);
+    void deallocate(void* ptr, size_t size);    // Routed by size class
+    void deallocate(void* ptr, const std::string& poolName);
     
-    void resetFrameAllocator();
+    void resetFrameAllocator();                 // Same as beginFrame()
     
     void printStatistics() const;
     std::string getStatisticsReport() const;
@@ -552,21 +644,35 @@ private:
     std::map<std::string, MemoryPool*> namedPools;
     std::map<std::string, ObjectPool*> namedObjectPools;
     
-    MemoryPool* findBestFitPool(size_t size);
+    void rebuildRoutingTables();
+    MemoryPool* findOwningPool(const void* ptr) const;
 };
 
-// RAII helper for frame allocations
+// RAII helper for frame allocations on the calling thread; must not span beginFrame().
+// Without a thread slot, or once the frame buffer is full, allocations come from the heap
+// and are freed when the scope ends
 class FrameAllocatorScope {
 private:
     StackAllocator* allocator;
+    std::vector<void*> fallbackBlocks;
+    
+    void* allocateFallback(size_t bytes);
     
 public:
     FrameAllocatorScope(const char* label = nullptr);
     ~FrameAllocatorScope();
     
+    FrameAllocatorScope(const FrameAllocatorScope&) = delete;
+    FrameAllocatorScope& operator=(const FrameAllocatorScope&) = delete;
+    
     template<typename T>
     T* allocate(size_t count = 1) {
-        return static_cast<T*>(allocator->allocate(sizeof(T) * count, alignof(T)));
+        if (allocator) {
+            if (void* memory = allocator->allocate(sizeof(T) * count, alignof(T))) {
+                return static_cast<T*>(memory);
+            }
+        }
+        return static_cast<T*>(allocateFallback(sizeof(T) * count));
     }
 };
 
@@ -586,13 +692,15 @@ public:
     
     T* allocate(size_t n) {
         if (pool && sizeof(T) * n <= pool->getBlockSize()) {
-            return static_cast<T*>(pool->allocate());
+            if (void* block = pool->allocate()) {
+                return static_cast<T*>(block);
+            }
         }
         return static_cast<T*>(std::malloc(sizeof(T) * n));
     }
     
     void deallocate(T* p, size_t n) {
-        if (pool && pool->isValidPointer(p)) {
+        if (pool && pool->owns(p)) {
             pool->deallocate(p);
         } else {
             std::free(p);
@@ -605,6 +713,58 @@ public:
     }
 };
 
+/**
+ * @brief STL allocator over the calling thread's frame allocator
+ *
+ * Memory is released in bulk two frames later; deallocate() only gives back the latest
+ * allocation, so scoped scratch containers can be reused within a frame. Once the frame
+ * buffer is full it falls back to the heap. A container using it
+ * should stay on the thread that created it and must not outlive the next frame.
+ */
+template<typename T>
+class FrameAllocator {
+public:
+    using value_type = T;
+    
+    StackAllocator* arena;
+    
+    FrameAllocator() : arena(MemoryManager::getInstance()->getFrameAllocator()) {}
+    explicit FrameAllocator(StackAllocator* arena) : arena(arena) {}
+    
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U>& other) : arena(other.arena) {}
+    
+    T* allocate(size_t n) {
+        if (arena) {
+            if (void* memory = arena->allocate(sizeof(T) * n, alignof(T))) {
+                return static_cast<T*>(memory);
+            }
+        }
+        return static_cast<T*>(::operator new(sizeof(T) * n));
+    }
+    
+    void deallocate(T* p, size_t n) {
+        if (arena && arena->owns(p)) {
+            arena->release(p, sizeof(T) * n);
+        } else {
+            ::operator delete(p);
+        }
+    }
+    
+    template<typename U>
+    bool operator==(const FrameAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+    
+    template<typename U>
+    bool operator!=(const FrameAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
 } // namespace Memory
 } // namespace JJM
 
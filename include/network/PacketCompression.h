@@ -234,6 +234,12 @@ public:
      * @return True if more data
      */
     bool hasMoreData() const { return m_bitPosition < m_sizeInBits; }
+    
+    /**
+     * @brief Check if a read ran past the end of the buffer
+     * @return True if the buffer was too short for the reads made
+     */
+    bool hasOverrun() const { return m_bitPosition > m_sizeInBits; }
 
 private:
     const uint8_t* m_data;
@@ -3,19 +3,27 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
 #include <cstdint>
 #include <chrono>
 
+namespace Engine {
+class BitPacker;
+class BitUnpacker;
+}
+
 namespace JJM {
 namespace Network {
 
 // Forward declarations
-class SyncVar;
+template<typename T> class SyncVar;
 class NetworkedObject;
 class StateSynchronizer;
 class SnapshotBuffer;
+class InterestManager;
 
 // Synchronization mode
 enum class SyncMode {
@@ -102,6 +110,30 @@ struct NetworkTransform {
                                        const NetworkTransform& b, float t);
 };
 
+// Quantization for delta snapshots; both ends must use the same settings
+struct SnapshotQuantization {
+    float worldMin[3];
+    float worldMax[3];
+    float positionPrecision;    // World units per step
+    int positionDeltaBits;      // Signed steps sent for a small move
+    int rotationBits;           // Per smallest-three quaternion component
+    float maxScale;
+    float scalePrecision;
+    
+    SnapshotQuantization()
+        : positionPrecision(0.01f), positionDeltaBits(8), rotationBits(10),
+          maxScale(16.0f), scalePrecision(0.01f) {
+        worldMin[0] = worldMin[1] = worldMin[2] = -4096.0f;
+        worldMax[0] = worldMax[1] = worldMax[2] = 4096.0f;
+    }
+};
+
+// An object relevant to a client
+struct InterestRelevance {
+    uint32_t objectId;
+    float relevance;    // 1 at the region's center falling to 0 at its edge; 1 if always
+};
+
 // State snapshot
 struct StateSnapshot {
     uint32_t snapshotId;
@@ -154,6 +186,8 @@ public:
     void unregisterSyncVar(const std::string& name);
     SyncVarBase* getSyncVar(const std::string& name);
     const std::unordered_map<std::string, SyncVarBase*>& getSyncVars() const { return m_syncVars; }
+    // Sync vars in name order, the order they are serialized in on every peer
+    const std::vector<SyncVarBase*>& getOrderedSyncVars() const;
     
     // Serialization
     virtual void serialize(std::vector<uint8_t>& buffer) const;
@@ -177,6 +211,8 @@ protected:
     uint32_t m_networkId;
     Authority m_authority;
     std::unordered_map<std::string, SyncVarBase*> m_syncVars;
+    mutable std::vector<SyncVarBase*> m_orderedSyncVars;
+    mutable bool m_syncVarOrderDirty;
     NetworkTransform m_transform;
     bool m_syncTransform;
     float m_updateRate;  // Updates per second
@@ -223,6 +259,44 @@ public:
     void receiveSnapshot(const StateSnapshot& snapshot);
     void applySnapshot(const StateSnapshot& snapshot);
     
+    // Delta snapshots. The server captures every object's quantized state once per snapshot,
+    // then encodes it for each client against the newest snapshot that client acknowledged, so
+    // only fields that differ from what the client already holds are sent. Objects must be
+    // registered on both ends under the same network ids and sync vars.
+    void addClient(uint32_t clientId);
+    void removeClient(uint32_t clientId);
+    uint32_t captureSnapshot();
+    void writeSnapshot(uint32_t clientId, std::vector<uint8_t>& packet);
+    void acknowledgeSnapshot(uint32_t clientId, uint32_t snapshotId);
+    
+    // Client side: decodes against earlier received snapshots and applies the changed objects.
+    // Returns false if the packet's baseline is no longer held; the client keeps acking older
+    // snapshots until the server sends one it can decode.
+    bool readSnapshot(const std::vector<uint8_t>& packet);
+    uint32_t getLastReceivedSnapshot() const { return m_lastReceivedSnapshot; }
+    
+    void setQuantization(const SnapshotQuantization& quantization);
+    const SnapshotQuantization& getQuantization() const { return m_quantization; }
+    
+    // With an interest manager, captureSnapshot() feeds it object positions and each client
+    // only holds the objects relevant to it; objects that stop being relevant are removed from
+    // the client's snapshots. The manager must outlive the synchronizer or be reset to null.
+    void setInterestManager(InterestManager* interest) { m_interestManager = interest; }
+    InterestManager* getInterestManager() const { return m_interestManager; }
+    
+    // Per-client budget; 0 uses setBandwidthLimit(). Changed objects that do not fit in a
+    // packet wait, gaining priority each snapshot, while the client keeps their older state
+    void setClientBandwidthLimit(uint32_t clientId, size_t bytesPerSecond);
+    
+    struct ClientStats {
+        int entitiesRelevant;       // Last snapshot
+        int entitiesSent;
+        int entitiesDeferred;       // Changed but over budget
+        size_t packetBytes;
+        size_t budgetBytes;         // Per snapshot, 0 if unlimited
+    };
+    ClientStats getClientStats(uint32_t clientId) const;
+    
     // Interpolation
     void enableInterpolation(bool enable) { m_interpolationEnabled = enable; }
     bool isInterpolationEnabled() const { return m_interpolationEnabled; }
@@ -247,7 +321,7 @@ public:
     void setPriority(uint32_t objectId, int priority);
     int getPriority(uint32_t objectId) const;
     
-    // Bandwidth management
+    // Bandwidth management; the limit is per client, 0 for none
     void setBandwidthLimit(size_t bytesPerSecond) { m_bandwidthLimit = bytesPerSecond; }
     size_t getBandwidthUsage() const { return m_bandwidthUsage; }
     
@@ -260,6 +334,8 @@ public:
         float avgSnapshotSize;
         float avgInterpolationDelay;
         int objectCount;
+        int entitiesSent;           // Last snapshot, summed over clients
+        int entitiesDeferred;
     };
     const Stats& getStats() const { return m_stats; }
     void resetStats();
@@ -268,7 +344,58 @@ public:
     void setSnapshotRate(float rate) { m_snapshotRate = rate; }
     float getSnapshotRate() const { return m_snapshotRate; }
     
+    static constexpr uint32_t NO_SNAPSHOT = 0xFFFFFFFFu;
+    static constexpr uint32_t SNAPSHOT_HISTORY = 32;  // Snapshots usable as baselines
+    
 private:
+    // One object's quantized state; its sync var bytes and sizes live in the owning frame
+    struct QuantizedState {
+        uint32_t networkId;
+        uint32_t position[3];
+        uint32_t rotation;          // Smallest-three code
+        uint32_t scale[3];
+        uint32_t varOffset;         // Into Frame::vars
+        uint32_t firstVar;          // Into Frame::varSizes
+        uint32_t varCount;
+    };
+    
+    // Every object's state in one snapshot, sorted by network id
+    struct Frame {
+        uint32_t snapshotId = NO_SNAPSHOT;
+        std::vector<QuantizedState> objects;
+        std::vector<uint8_t> vars;
+        std::vector<uint16_t> varSizes;
+        
+        void clear();
+    };
+    
+    // What a client holds after a snapshot: each object and the frame its state came from
+    struct ClientFrame {
+        uint32_t snapshotId = NO_SNAPSHOT;
+        std::vector<std::pair<uint32_t, uint32_t>> objects;  // Network id, source snapshot
+    };
+    
+    struct ClientState {
+        uint32_t acknowledged = NO_SNAPSHOT;
+        std::vector<ClientFrame> frames;  // Ring indexed by snapshot id
+        size_t bandwidthLimit = 0;
+        std::unordered_map<uint32_t, float> priorities;  // Accumulated while changed and unsent
+        ClientStats stats = {};
+    };
+    
+    // A changed object competing for a client's packet
+    struct Candidate {
+        uint32_t stateIndex;            // Into the current frame
+        const QuantizedState* base;
+        const Frame* baseFrame;
+        uint32_t baselineSource;        // NO_SNAPSHOT if the client does not hold the object
+        float* priority;
+        uint32_t sentIndex;             // Into the client frame being written
+        size_t firstBit;                // Of its encoded entry
+        size_t bitCount;
+        bool selected;
+    };
+    
     bool m_isServer;
     std::unordered_map<uint32_t, NetworkedObject*> m_objects;
     std::unordered_map<uint32_t, int> m_priorities;
@@ -297,9 +424,50 @@ private:
     size_t m_bandwidthLimit;
     size_t m_bandwidthUsage;
     
+    // Delta snapshots. The server's ring holds captured frames, a client's the frames it has
+    // decoded; both are indexed by snapshot id
+    std::vector<Frame> m_frames;
+    Frame m_decodeFrame;
+    std::vector<uint32_t> m_receivedIds;                    // Sent in the packet being read
+    std::unordered_map<uint32_t, uint32_t> m_appliedFrom;   // Snapshot an object was last sent in
+    uint32_t m_latestSnapshot;
+    uint32_t m_lastReceivedSnapshot;
+    std::unordered_map<uint32_t, ClientState> m_clients;
+    SnapshotQuantization m_quantization;
+    int m_positionBits[3];
+    int m_scaleBits;
+    uint32_t m_unitScale;           // Quantized 1.0
+    
+    // Interest and per-client budgets
+    InterestManager* m_interestManager;
+    std::vector<InterestRelevance> m_relevant;
+    std::vector<Candidate> m_candidates;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_removals;
+    
     // Stats
     Stats m_stats;
     
+    // Delta snapshot helpers
+    const Frame* findFrame(uint32_t snapshotId) const;
+    static const QuantizedState* findState(const Frame& frame, uint32_t networkId);
+    void quantizeObject(const NetworkedObject& object, Frame& frame) const;
+    void applyState(const QuantizedState& state, const Frame& frame);
+    bool sameState(const QuantizedState& a, const Frame& frameA,
+                   const QuantizedState& b, const Frame& frameB) const;
+    bool sameLayout(const QuantizedState& a, const Frame& frameA,
+                    const QuantizedState& b, const Frame& frameB) const;
+    void writeFullState(Engine::BitPacker& packer, const QuantizedState& state,
+                        const Frame& frame) const;
+    void writeDeltaState(Engine::BitPacker& packer, const QuantizedState& state,
+                         const Frame& frame, const QuantizedState& base,
+                         const Frame& baseFrame) const;
+    bool readFullState(Engine::BitUnpacker& unpacker, QuantizedState& state, Frame& frame) const;
+    void readDeltaState(Engine::BitUnpacker& unpacker, QuantizedState& state, Frame& frame,
+                        const QuantizedState& base, const Frame& baseFrame) const;
+    void copyState(const QuantizedState& state, const Frame& from, Frame& to) const;
+    void gatherRelevant(uint32_t clientId);
+    
     // Helpers
     void updateInterpolation();
     void updatePrediction(float deltaTime);
@@ -324,7 +492,8 @@ public:
                                     const std::vector<uint8_t>& b);
 };
 
-// Interest management (relevancy)
+// Interest management (relevancy). Object positions are indexed in a hashed x/z grid rebuilt
+// by update(), so a client's relevant objects come from the cells its region overlaps
 class InterestManager {
 public:
     struct Region {
@@ -338,6 +507,14 @@ public:
     void setClientInterest(uint32_t clientId, const Region& region);
     void removeClient(uint32_t clientId);
     
+    // Indexed objects; positions take effect on the next update()
+    void setObjectPosition(uint32_t objectId, const float position[3]);
+    void removeObject(uint32_t objectId);
+    void setAlwaysRelevant(uint32_t objectId, bool always);
+    void setCellSize(float size) { m_cellSize = size; }
+    float getCellSize() const { return m_cellSize; }
+    void update();
+    
     // Check if object is relevant to client
     bool isRelevant(uint32_t clientId, uint32_t objectId, const float position[3]) const;
     
@@ -345,10 +522,30 @@ public:
     std::vector<uint32_t> getRelevantObjects(uint32_t clientId,
                                             const std::unordered_map<uint32_t, float[3]>& objectPositions) const;
     
+    // Indexed objects inside the client's region plus always relevant ones, in no order;
+    // appends to relevant. Clients without a region get nothing
+    void gatherRelevant(uint32_t clientId, std::vector<InterestRelevance>& relevant) const;
+    
 private:
+    struct IndexedObject {
+        uint32_t objectId;
+        float position[3];
+        int cell[2];
+    };
+    
     std::unordered_map<uint32_t, Region> m_clientInterests;
+    std::unordered_set<uint32_t> m_alwaysRelevant;
+    
+    // Grid; m_cellObjects holds m_objects indices grouped by hashed cell
+    std::vector<IndexedObject> m_objects;
+    std::unordered_map<uint32_t, size_t> m_objectIndices;
+    float m_cellSize;
+    size_t m_tableMask;
+    std::vector<uint32_t> m_cellStart;
+    std::vector<uint32_t> m_cellObjects;
     
     bool isInRegion(const Region& region, const float position[3]) const;
+    size_t hashCell(int x, int z) const;
 };
 
 // Lag compensation
@@ -0,0 +1,91 @@
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include "ecs/EntityManager.h"
+#include "math/Vector2D.h"
+#include "physics/PhysicsBody.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace JJM {
+namespace Physics {
+
+/**
+ * @brief Persistent structure-of-arrays index of a world's bodies, plus their velocity pass
+ *
+ * The store observes the EntityManager, so entities join when they gain a PhysicsBody and
+ * leave when they lose it or are destroyed; a step walks the member arrays instead of
+ * querying the ECS. Membership is kept in add order with swap-removal.
+ *
+ * Velocity, force and mass stay in the PhysicsBody fields, which game code, colliders and
+ * the solver read and write directly. Integration therefore streams the step's bodies
+ * through fixed-size SoA lanes: each block of BLOCK_SIZE bodies is loaded, integrated in
+ * one SIMD pass (AVX when the build enables it, else SSE2 or NEON, else scalar) and
+ * written back while it is still in cache. The result matches PhysicsBody::integrateVelocity
+ * after PhysicsWorld::applyGravity: gravity is added as a mass-scaled force, and force and
+ * acceleration are cleared afterwards. Bodies with zero inverse mass are not packed.
+ */
+class BodyStore : public ECS::EntityObserver {
+public:
+    static constexpr size_t BLOCK_SIZE = 256;
+
+    BodyStore();
+
+    // Membership, reported by EntityManager::addObserver<PhysicsBody>()
+    void onEntityAdded(ECS::Entity* entity) override;
+    void onEntityRemoved(ECS::Entity* entity) override;
+
+    size_t size() const { return m_entities.size(); }
+    ECS::Entity* getEntity(size_t member) const { return m_entities[member]; }
+    PhysicsBody* getBody(size_t member) const { return m_bodies[member]; }
+
+    // Archetype storage moves components when other entities in their archetype change, so
+    // worlds on such a manager re-read the body pointers before each step
+    void refreshBodies();
+
+    // velocity += (force + gravity * mass) * inverseMass * deltaTime for every body passed
+    // to integrate() between begin and end; requires inverseMass > 0
+    void beginIntegration(const Math::Vector2D& gravity, float deltaTime);
+    void integrate(PhysicsBody* body) {
+        if (m_count == BLOCK_SIZE) flushBlock();
+        const size_t i = m_count++;
+        m_blockBodies[i] = body;
+        m_velocityX[i] = body->velocity.x;
+        m_velocityY[i] = body->velocity.y;
+        m_forceX[i] = body->force.x;
+        m_forceY[i] = body->force.y;
+        m_inverseMass[i] = body->inverseMass;
+        m_gravityMass[i] = body->useGravity ? body->mass : 0.0f;
+    }
+    void endIntegration() { flushBlock(); }
+
+    // Lanes processed per instruction by the integration pass in this build
+    static int getSimdWidth();
+
+private:
+    void flushBlock();
+
+    // Members, parallel arrays in add order; m_positions maps an entity slot to its
+    // member index + 1 (0 = not a member)
+    std::vector<ECS::Entity*> m_entities;
+    std::vector<PhysicsBody*> m_bodies;
+    std::vector<uint32_t> m_positions;
+
+    // One block of packed lanes
+    alignas(32) float m_velocityX[BLOCK_SIZE];
+    alignas(32) float m_velocityY[BLOCK_SIZE];
+    alignas(32) float m_forceX[BLOCK_SIZE];
+    alignas(32) float m_forceY[BLOCK_SIZE];
+    alignas(32) float m_inverseMass[BLOCK_SIZE];
+    alignas(32) float m_gravityMass[BLOCK_SIZE];  // mass if the body uses gravity, else 0
+    PhysicsBody* m_blockBodies[BLOCK_SIZE];
+    size_t m_count;
+    Math::Vector2D m_gravity;
+    float m_deltaTime;
+};
+
+} // namespace Physics
+} // namespace JJM
+
+#endif // BODY_STORE_H
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <functional>
+#include <unordered_map>
 
 /**
  * @file BroadPhase.h
@@ -18,7 +19,12 @@ struct AABB {
     float minX, minY, minZ;
     float maxX, maxY, maxZ;
     
-    bool intersects(const AABB& other) const;
+    // Inline: this is the innermost test of every tree query
+    bool intersects(const AABB& other) const {
+        return !(maxX < other.minX || minX > other.maxX ||
+                 maxY < other.minY || minY > other.maxY ||
+                 maxZ < other.minZ || minZ > other.maxZ);
+    }
     float surfaceArea() const;
     AABB merge(const AABB& other) const;
 };
@@ -142,9 +148,10 @@ public:
     /**
      * @brief Query overlapping proxies
      * @param bounds Query region
-     * @param callback Function called for each overlapping proxy
+     * @param callback Called with each overlapping proxy ID; return false to stop
      */
-    void query(const AABB& bounds, std::function<bool(int)> callback) const;
+    template <typename Callback>
+    void query(const AABB& bounds, Callback&& callback) const;
     
     /**
      * @brief Ray cast against the tree
@@ -216,9 +223,38 @@ private:
     void validateMetrics(int index) const;
 };
 
+template <typename Callback>
+void DynamicAABBTree::query(const AABB& bounds, Callback&& callback) const {
+    // Runs once per moving body every step, so keep the traversal stack off the heap
+    thread_local std::vector<int> stack;
+    stack.clear();
+    stack.push_back(m_root);
+
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        if (nodeId == -1) continue;
+
+        const Node& node = m_nodes[nodeId];
+        if (node.aabb.intersects(bounds)) {
+            if (node.isLeaf()) {
+                if (!callback(nodeId)) return;
+            } else {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+}
+
 /**
  * @class SweepAndPrune
- * @brief Sweep and prune broad-phase using sorted axis lists
+ * @brief Sweep and prune broad-phase using a sorted endpoint list
+ *
+ * Endpoints are kept sorted along the X axis between calls, so in scenes where objects
+ * move a little each step re-sorting is a near-linear insertion sort. Y/Z overlap is
+ * tested only for objects whose X intervals overlap.
  */
 class SweepAndPrune {
 public:
@@ -247,7 +283,7 @@ public:
     void updateObject(int id, const AABB& newBounds);
     
     /**
-     * @brief Get all overlapping pairs
+     * @brief Get all overlapping pairs (pairs of two static objects are skipped)
      * @param outPairs Output vector of pairs
      */
     void computeOverlaps(std::vector<std::pair<int, int>>& outPairs);
@@ -264,14 +300,20 @@ public:
      */
     void clear();
 
+    /**
+     * @brief Get number of objects
+     */
+    size_t getObjectCount() const { return m_objects.size(); }
+
 private:
     struct Endpoint {
         float value;
-        int id;
+        int index;  // Into m_objects
         bool isMin;
         
+        // Min before max at equal values so touching intervals count as overlapping
         bool operator<(const Endpoint& other) const {
-            return value < other.value;
+            return value < other.value || (value == other.value && isMin && !other.isMin);
         }
     };
     
@@ -279,15 +321,15 @@ private:
         int id;
         AABB bounds;
         bool isStatic;
-        int minIndex[3];
-        int maxIndex[3];
     };
     
-    std::vector<Endpoint> m_axes[3];
+    std::vector<Endpoint> m_endpoints;
     std::vector<ObjectData> m_objects;
-    std::vector<std::pair<int, int>> m_pairs;
+    std::unordered_map<int, int> m_indexById;
+    std::vector<int> m_active;
+    bool m_needsFullSort;
     
-    void sortAxis(int axis);
+    void sortEndpoints();
     int findObject(int id) const;
 };
 
@@ -78,6 +78,8 @@ public:
     bool checkCollision(const Collider* other, CollisionInfo& info) const override;
     
 private:
+    friend class BoxCollider;
+
     bool checkCircleCircle(const CircleCollider* other, CollisionInfo& info) const;
     bool checkCircleBox(const class BoxCollider* other, CollisionInfo& info) const;
 };
@@ -4,6 +4,7 @@
 #include "math/Vector2D.h"
 #include "physics/PhysicsBody.h"
 #include <memory>
+#include <vector>
 
 namespace JJM {
 namespace Physics {
@@ -18,6 +19,10 @@ public:
     virtual void solve(float deltaTime) = 0;
     virtual void preStep(float deltaTime) { (void)deltaTime; }
     
+    // Bodies this constraint acts on, so PhysicsWorld can group it into an island
+    virtual PhysicsBody* getBodyA() const { return nullptr; }
+    virtual PhysicsBody* getBodyB() const { return nullptr; }
+    
     void setEnabled(bool enabled) { this->enabled = enabled; }
     bool isEnabled() const { return enabled; }
     
@@ -33,6 +38,8 @@ public:
     DistanceConstraint(PhysicsBody* bodyA, PhysicsBody* bodyB, float distance = -1.0f);
     
     void solve(float deltaTime) override;
+    PhysicsBody* getBodyA() const override { return bodyA; }
+    PhysicsBody* getBodyB() const override { return bodyB; }
     
     void setDistance(float dist) { targetDistance = dist; }
     float getDistance() const { return targetDistance; }
@@ -54,6 +61,8 @@ public:
                      float restLength = 1.0f, float stiffness = 100.0f, float damping = 10.0f);
     
     void solve(float deltaTime) override;
+    PhysicsBody* getBodyA() const override { return bodyA; }
+    PhysicsBody* getBodyB() const override { return bodyB; }
     
     void setRestLength(float length) { restLength = length; }
     void setStiffness(float k) { stiffness = k; }
@@ -75,6 +84,8 @@ public:
     HingeConstraint(PhysicsBody* bodyA, PhysicsBody* bodyB, const Math::Vector2D& anchor);
     
     void solve(float deltaTime) override;
+    PhysicsBody* getBodyA() const override { return bodyA; }
+    PhysicsBody* getBodyB() const override { return bodyB; }
     
     void setAnchor(const Math::Vector2D& pos) { anchor = pos; }
     void setEnableLimits(bool enable) { useLimits = enable; }
@@ -97,6 +108,7 @@ public:
     PositionConstraint(PhysicsBody* body, const Math::Vector2D& targetPos);
     
     void solve(float deltaTime) override;
+    PhysicsBody* getBodyA() const override { return body; }
     
     void setTargetPosition(const Math::Vector2D& pos) { targetPosition = pos; }
     void setStiffness(float s) { stiffness = s; }
@@ -115,6 +127,7 @@ public:
     MotorConstraint(PhysicsBody* body);
     
     void solve(float deltaTime) override;
+    PhysicsBody* getBodyA() const override { return body; }
     
     void setTargetVelocity(const Math::Vector2D& vel) { targetVelocity = vel; }
     void setMaxForce(float force) { maxForce = force; }
@@ -0,0 +1,176 @@
+#ifndef ISLAND_SOLVER_H
+#define ISLAND_SOLVER_H
+
+#include "math/Vector2D.h"
+#include "physics/Collider.h"
+#include "physics/PhysicsBody.h"
+#include "ecs/Entity.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
+namespace Physics {
+
+class Joint;
+class Constraint;
+
+/**
+ * @brief Tuning for the sequential impulse solver, filled from PhysicsConfig
+ */
+struct SolverSettings {
+    int velocityIterations = 8;
+    int positionIterations = 3;
+    bool warmStarting = true;
+    float baumgarte = 0.2f;             // Fraction of penetration removed per position iteration
+    float slop = 0.005f;                // Penetration allowed without correction
+    float restitutionThreshold = 1.0f;  // Slower approaches are treated as inelastic
+    bool allowSleeping = true;
+    float sleepVelocity = 0.01f;        // Bodies slower than this accumulate sleep time
+    float timeToSleep = 0.5f;           // Seconds an island must rest before it sleeps
+};
+
+/**
+ * @brief Persistent contact between two bodies
+ *
+ * Circles and axis-aligned boxes touch at a single point, so a manifold holds one point.
+ * Accumulated impulses survive across steps while the pair keeps touching and are applied
+ * up front next step (warm starting), which lets stacks settle in few iterations.
+ */
+struct ContactManifold {
+    ECS::EntityID idA;
+    ECS::EntityID idB;
+    PhysicsBody* bodyA;         // Null for colliders without a body (treated as static)
+    PhysicsBody* bodyB;
+    Math::Vector2D normal;      // Points from A to B
+    float penetration;
+    Math::Vector2D originA;     // Body positions when penetration was measured
+    Math::Vector2D originB;
+    float friction;
+    float restitution;
+    float normalImpulse;
+    float tangentImpulse;
+    float normalMass;
+    float velocityBias;
+    bool touched;
+};
+
+/**
+ * @brief Per-step island and sleeping statistics
+ */
+struct IslandStats {
+    int islands = 0;            // Islands built this step; resting piles are skipped
+    int awakeIslands = 0;
+    int awakeBodies = 0;
+    int sleepingBodies = 0;
+    int contacts = 0;
+    int joints = 0;
+    int constraints = 0;
+    float solveTimeMs = 0.0f;
+};
+
+/**
+ * @brief Groups bodies into islands and solves awake islands with sequential impulses
+ *
+ * An island is a set of dynamic bodies connected through contacts, joints or constraints;
+ * static and kinematic bodies never join islands, so islands share no mutable state and
+ * are solved concurrently on the JobSystem. When every body of an island has rested for
+ * timeToSleep the whole island sleeps and costs nothing until something awake touches it.
+ */
+class IslandSolver {
+public:
+    IslandSolver();
+    ~IslandSolver();
+
+    void setJobSystem(Threading::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+    Threading::JobSystem* getJobSystem() const { return m_jobSystem; }
+
+    // Maps an entity ID to its current body (or null); returns false once the entity no
+    // longer takes part in collision
+    using BodyResolver = std::function<bool(ECS::EntityID id, PhysicsBody*& body)>;
+
+    // Contact bookkeeping around the narrow phase: mark all manifolds untouched, refresh
+    // touching pairs, then drop pairs that separated. Pairs whose bodies are all asleep or
+    // static are skipped by the broad phase, so they are kept and only have their body
+    // pointers refreshed through resolveBody.
+    void beginContacts();
+    void addContact(ECS::EntityID idA, PhysicsBody* bodyA, ECS::EntityID idB,
+                    PhysicsBody* bodyB, const CollisionInfo& info);
+    void endContacts(const BodyResolver& resolveBody);
+    void clearContacts();
+
+    // Manifolds are kept sorted by (idA, idB), so iteration order never depends on the
+    // order pairs were found in
+    size_t getContactCount() const { return m_manifolds.size(); }
+    const std::vector<ContactManifold>& getContacts() const { return m_manifolds; }
+    
+    // Rollback: replace all manifolds (sorted as returned by getContacts()); body pointers
+    // are re-resolved during the next step's contact update
+    void restoreContacts(const std::vector<ContactManifold>& contacts);
+
+    // Build islands, solve the awake ones, integrate their positions and put resting
+    // islands to sleep. Velocities must already include this step's forces.
+    void solve(float deltaTime, const std::vector<PhysicsBody*>& bodies,
+               const std::vector<Joint*>& joints, const std::vector<Constraint*>& constraints,
+               const SolverSettings& settings);
+
+    const IslandStats& getStats() const { return m_stats; }
+
+private:
+    struct Island {
+        int bodyStart, bodyCount;
+        int contactStart, contactCount;
+        int jointStart, jointCount;
+        int constraintStart, constraintCount;
+        bool awake;
+    };
+
+    // Island building
+    int indexBody(PhysicsBody* body);
+    int findRoot(int index);
+    void link(PhysicsBody* a, PhysicsBody* b);
+    int islandOf(PhysicsBody* a, PhysicsBody* b);
+    void buildIslands(const std::vector<PhysicsBody*>& bodies, const std::vector<Joint*>& joints,
+                      const std::vector<Constraint*>& constraints);
+
+    void solveIsland(const Island& island, float deltaTime, const SolverSettings& settings);
+    void solveIslandsParallel(float deltaTime, const SolverSettings& settings);
+
+    Threading::JobSystem* m_jobSystem;
+
+    // Contacts: [0, m_sortedCount) is sorted and searched; pairs first seen this step are
+    // appended after it and merged in by endContacts()
+    std::vector<ContactManifold> m_manifolds;
+    size_t m_sortedCount;
+
+    // Island scratch, reused across steps
+    uint32_t m_stamp;
+    std::vector<PhysicsBody*> m_solverBodies;
+    std::vector<int> m_parent;
+    std::vector<int> m_rootIsland;          // Island index of each union-find root, or -1
+    std::vector<int> m_bodyIsland;
+    std::vector<Island> m_islands;
+    std::vector<int> m_awakeIslands;
+    std::vector<PhysicsBody*> m_islandBodies;
+    std::vector<int> m_islandContacts;
+    std::vector<Joint*> m_islandJoints;
+    std::vector<Constraint*> m_islandConstraints;
+    std::vector<int> m_contactIsland;
+    std::vector<int> m_jointIsland;
+    std::vector<int> m_constraintIsland;
+    std::vector<int> m_cursor;
+    std::vector<std::pair<size_t, size_t>> m_batches;   // Ranges of m_awakeIslands per job
+
+    IslandStats m_stats;
+};
+
+} // namespace Physics
+} // namespace JJM
+
+#endif // ISLAND_SOLVER_H
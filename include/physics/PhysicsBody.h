@@ -3,6 +3,7 @@
 
 #include "math/Vector2D.h"
 #include "ecs/Component.h"
+#include <cstdint>
 
 namespace JJM {
 namespace Physics {
@@ -27,8 +28,13 @@ public:
     float angularVelocity;
     float rotation;
     
+    // Transform at the start of the last physics step, for render interpolation
+    Math::Vector2D previousPosition;
+    float previousRotation;
+    
     BodyType type;
     bool useGravity;
+    bool canSleep;      // Allow PhysicsWorld to put this body to sleep when it comes to rest
     
     PhysicsBody();
     PhysicsBody(const Math::Vector2D& pos, float mass = 1.0f);
@@ -36,6 +42,10 @@ public:
     void init() override;
     void update(float deltaTime) override;
     
+    // Semi-implicit Euler halves of update(), used separately by PhysicsWorld's solver
+    void integrateVelocity(float deltaTime);
+    void integratePosition(float deltaTime);
+    
     // Force application
     void applyForce(const Math::Vector2D& f);
     void applyImpulse(const Math::Vector2D& impulse);
@@ -44,14 +54,43 @@ public:
     // Setters
     void setMass(float m);
     void setBodyType(BodyType t);
-    void setPosition(const Math::Vector2D& pos) { position = pos; }
-    void setVelocity(const Math::Vector2D& vel) { velocity = vel; }
+    void setPosition(const Math::Vector2D& pos) { position = pos; setAwake(true); }
+    void setVelocity(const Math::Vector2D& vel) { velocity = vel; setAwake(true); }
+    
+    // Sleeping bodies are skipped by PhysicsWorld until touched by an awake body or woken
+    // through the setters above; writing position/velocity directly does not wake them
+    void setAwake(bool value);
+    bool isAwake() const { return awake; }
+    float getSleepTime() const { return sleepTime; }
+    
+    // Blend the previous and current step by PhysicsWorld::getInterpolationAlpha()
+    Math::Vector2D getInterpolatedPosition(float alpha) const {
+        return Math::Vector2D(previousPosition.x + (position.x - previousPosition.x) * alpha,
+                              previousPosition.y + (position.y - previousPosition.y) * alpha);
+    }
+    float getInterpolatedRotation(float alpha) const {
+        return previousRotation + (rotation - previousRotation) * alpha;
+    }
     
     // Getters
     Math::Vector2D getPosition() const { return position; }
     Math::Vector2D getVelocity() const { return velocity; }
     float getMass() const { return mass; }
     float getInverseMass() const { return inverseMass; }
+    
+    // Inverse mass seen by the constraint solver: static and kinematic bodies are immovable
+    float getSolverInverseMass() const { return type == BodyType::DYNAMIC ? inverseMass : 0.0f; }
+
+private:
+    friend class IslandSolver;
+    friend class PhysicsWorld;
+    
+    bool awake;
+    float sleepTime;
+    
+    // Scratch state for island building, valid only while solverStamp matches the step
+    uint32_t solverStamp;
+    int solverIndex;
 };
 
 } // namespace Physics
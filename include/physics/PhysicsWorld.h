@@ -4,7 +4,11 @@
 #include "math/Vector2D.h"
 #include "physics/PhysicsBody.h"
 #include "physics/Collider.h"
+#include "physics/BodyStore.h"
+#include "physics/BroadPhase.h"
+#include "physics/IslandSolver.h"
 #include "ecs/EntityManager.h"
+#include <cstdint>
 #include <vector>
 #include <functional>
 #include <optional>
@@ -13,8 +17,15 @@
 #include <memory>
 
 namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
 namespace Physics {
 
+class JointManager;
+class Constraint;
+
 // Raycast hit result
 struct RaycastHit {
     ECS::Entity* entity;
@@ -37,7 +48,10 @@ struct PhysicsConfig {
     int velocityIterations;
     int positionIterations;
     bool continuousCollision;
-    float sleepThreshold;
+    float sleepThreshold;           // Speed below which a body counts as resting
+    float timeToSleep;              // Seconds an island must rest before it sleeps
+    bool allowSleeping;
+    float restitutionThreshold;     // Slower impacts don't bounce
     
     // Constraint limits
     int maxConstraints;
@@ -46,6 +60,14 @@ struct PhysicsConfig {
     float constraintSlop;
     bool warmStarting;
     
+    // Integrate gravity and forces over packed body arrays with SIMD instead of per body
+    bool vectorizedIntegration;
+    
+    // Fixed stepping: each fixedUpdate() runs subSteps steps of fixedTimeStep / subSteps,
+    // and advance() runs at most maxStepsPerUpdate fixed steps per frame
+    int subSteps;
+    int maxStepsPerUpdate;
+    
     PhysicsConfig()
         : gravity(0.0f, -9.81f)
         , fixedTimeStep(1.0f / 60.0f)
@@ -53,11 +75,17 @@ struct PhysicsConfig {
         , positionIterations(3)
         , continuousCollision(true)
         , sleepThreshold(0.01f)
+        , timeToSleep(0.5f)
+        , allowSleeping(true)
+        , restitutionThreshold(1.0f)
         , maxConstraints(2048)
         , maxConstraintForce(10000.0f)
         , constraintBias(0.2f)
         , constraintSlop(0.005f)
         , warmStarting(true)
+        , vectorizedIntegration(true)
+        , subSteps(1)
+        , maxStepsPerUpdate(5)
     {}
 };
 
@@ -271,11 +299,76 @@ private:
     void updateOverlaps();
 };
 
+/**
+ * @brief Broad phase used by PhysicsWorld to find candidate pairs for the narrow phase
+ */
+enum class BroadphaseType {
+    BRUTE_FORCE,      // Test every pair; only sensible for a handful of bodies
+    AABB_TREE,        // Dynamic AABB tree; good for mixed static/dynamic scenes
+    SWEEP_AND_PRUNE   // Sorted endpoints; good when most bodies move a little each step
+};
+
+/**
+ * @brief Snapshot of one body's simulated state
+ *
+ * Mass, body type, colliders and other configuration are not part of the state; they are
+ * expected to be unchanged when a snapshot is restored.
+ */
+struct PhysicsBodyState {
+    ECS::EntityID entityId;
+    Math::Vector2D position;
+    Math::Vector2D velocity;
+    Math::Vector2D acceleration;
+    Math::Vector2D force;
+    Math::Vector2D previousPosition;
+    float rotation;
+    float angularVelocity;
+    float previousRotation;
+    float sleepTime;
+    bool awake;
+};
+
+/**
+ * @brief Everything PhysicsWorld needs to replay the same steps bit for bit
+ *
+ * Filled by PhysicsWorld::saveState() and applied by restoreState(). Buffers are reused
+ * when the same state object is saved into again, so per-frame rollback snapshots don't
+ * allocate once warm. Entity creation and destruction are not rolled back here.
+ */
+struct PhysicsState {
+    std::vector<PhysicsBodyState> bodies;
+    std::vector<ContactManifold> contacts;  // Warm-starting impulses
+    std::vector<float> joints;              // Joint::saveState() output, in joint order
+    size_t jointCount = 0;
+    float timeAccumulator = 0.0f;
+    uint64_t stepCount = 0;
+};
+
 class PhysicsWorld {
 private:
+    // A narrow-phase hit; info.normal points from entityA toward info.other
+    struct Contact {
+        ECS::Entity* entityA;
+        CollisionInfo info;
+    };
+    
+    // One collider tracked by the broad phase, keyed by its entity's generational ID
+    struct BroadphaseProxy {
+        ECS::EntityID entityId;
+        ECS::Entity* entity;
+        Collider* collider;
+        SpatialAABB bounds;
+        PhysicsBody* body;
+        int treeProxy;
+        bool isStatic;
+        bool sleeping;      // Sleeping proxies keep their bounds and don't query
+        bool alive;
+        bool seen;
+    };
+    
     Math::Vector2D gravity;
     ECS::EntityManager* entityManager;
-    std::vector<CollisionInfo> collisions;
+    std::vector<Contact> collisions;
     PhysicsConfig config;
     
     // Layer collision matrix
@@ -289,10 +382,33 @@ private:
     
     // Time accumulator for fixed timestep
     float timeAccumulator;
+    uint64_t m_stepCount;
     
     // Spatial partitioning
     std::unique_ptr<SpatialHashGrid> m_spatialHash;
     bool m_useSpatialHashing;
+    
+    // Broad phase state, persistent across steps so the tree and endpoint lists stay warm
+    BroadphaseType m_broadphaseType;
+    std::unique_ptr<Engine::DynamicAABBTree> m_aabbTree;
+    std::unique_ptr<Engine::SweepAndPrune> m_sweepAndPrune;
+    std::vector<BroadphaseProxy> m_proxies;
+    std::vector<int> m_freeProxies;
+    std::unordered_map<ECS::EntityID, int> m_proxyLookup;
+    std::vector<std::pair<int, int>> m_candidatePairs;
+    bool m_refreshProxyBounds;  // Set by restoreState(): sleeping proxies re-read bounds
+    
+    // Every body in the world, kept current by EntityManager observer hooks; runs the
+    // vectorized velocity pass
+    BodyStore m_bodyStore;
+    
+    // Contact, joint and constraint solving
+    IslandSolver m_solver;
+    std::unique_ptr<JointManager> m_jointManager;
+    std::vector<std::shared_ptr<Constraint>> m_constraints;
+    std::vector<PhysicsBody*> m_stepBodies;
+    std::vector<Joint*> m_stepJoints;
+    std::vector<Constraint*> m_stepConstraints;
 
 public:
     PhysicsWorld(ECS::EntityManager* em);
@@ -302,9 +418,37 @@ public:
     void setConfig(const PhysicsConfig& cfg);
     const PhysicsConfig& getConfig() const { return config; }
 
-    // Update physics
+    // Update physics. update() takes one variable step. fixedUpdate() takes one step of
+    // config.fixedTimeStep split into config.subSteps, and advance() adds frame time to the
+    // accumulator and runs as many fixed steps as it covers, returning how many ran. Fixed
+    // steps are bitwise deterministic for identical state and inputs.
     void update(float deltaTime);
     void fixedUpdate();
+    int advance(float frameTime);
+    
+    // Fraction of a fixed step left in the accumulator; blend previous and current body
+    // transforms with it to render between steps
+    float getInterpolationAlpha() const;
+    uint64_t getStepCount() const { return m_stepCount; }
+    
+    // Rollback: capture and reapply body, contact and joint state. restoreState() returns
+    // false if a saved entity no longer has a PhysicsBody or the joint count changed.
+    void saveState(PhysicsState& state);
+    bool restoreState(const PhysicsState& state);
+    
+    // Islands are solved on the job system's workers when one is set
+    void setJobSystem(Threading::JobSystem* jobSystem) { m_solver.setJobSystem(jobSystem); }
+    Threading::JobSystem* getJobSystem() const { return m_solver.getJobSystem(); }
+    
+    // Joints and constraints are solved with contacts, per island
+    JointManager& getJointManager() { return *m_jointManager; }
+    void addConstraint(std::shared_ptr<Constraint> constraint);
+    void removeConstraint(const std::shared_ptr<Constraint>& constraint);
+    void clearConstraints() { m_constraints.clear(); }
+    size_t getConstraintCount() const { return m_constraints.size(); }
+    
+    const IslandStats& getIslandStats() const { return m_solver.getStats(); }
+    const std::vector<ContactManifold>& getContacts() const { return m_solver.getContacts(); }
     
     // Gravity
     void setGravity(const Math::Vector2D& g) { gravity = g; config.gravity = g; }
@@ -316,9 +460,15 @@ public:
     SpatialHashGrid* getSpatialHash() { return m_spatialHash.get(); }
     void rebuildSpatialHash();
     
-    // Collision detection
+    // Broad phase selection; switching rebuilds the structure on the next step
+    void setBroadphaseType(BroadphaseType type);
+    BroadphaseType getBroadphaseType() const { return m_broadphaseType; }
+    
+    // Collision detection; update() feeds contacts to the island solver, while
+    // resolveCollisions() remains as a single-pass resolver for manual stepping
     void detectCollisions();
     void resolveCollisions();
+    size_t getCollisionCount() const { return collisions.size(); }
     
     // Broadphase optimization statistics
     struct BroadphaseStats {
@@ -379,8 +529,23 @@ public:
                           const Math::Vector2D& force);
     
 private:
+    void step(float deltaTime, bool captureTransforms);
     void applyGravity(float deltaTime);
-    void resolveCollision(const CollisionInfo& info);
+    void integrateVelocities(float deltaTime, bool captureTransforms);
+    void integrateVelocitiesPacked(float deltaTime, bool captureTransforms);
+    void solveConstraints(float deltaTime);
+    SolverSettings makeSolverSettings() const;
+    void resolveCollision(ECS::Entity* entityA, const CollisionInfo& info);
+    
+    // Broad phase
+    static Collider* findCollider(ECS::Entity* entity);
+    static SpatialAABB computeBounds(const Collider& collider);
+    void syncBroadphaseProxies();
+    int createBroadphaseProxy(ECS::Entity* entity, Collider* collider, PhysicsBody* body,
+                              bool isStatic);
+    void destroyBroadphaseProxy(int index);
+    void clearBroadphase();
+    void findCandidatePairs();
     bool rayIntersectsCollider(const Math::Vector2D& origin,
                                const Math::Vector2D& direction,
                                const Collider& collider,
@@ -515,6 +680,13 @@ public:
     void setBreakForce(float force) { m_breakForce = force; }
     void setBreakTorque(float torque) { m_breakTorque = torque; }
     bool isBroken() const { return m_broken; }
+    // Breaks the joint if the last solve's reaction exceeded the break force or torque
+    bool updateBreakage();
+    
+    // Rollback: append the joint's simulated state (flags and accumulated impulses) to out,
+    // or read it back, returning the position just past what was read
+    void saveState(std::vector<float>& out) const;
+    const float* loadState(const float* in);
     
     // State
     bool isEnabled() const { return m_enabled; }
@@ -524,13 +696,30 @@ public:
     void* getUserData() const { return m_userData; }
     void setUserData(void* data) { m_userData = data; }
     
+    // Sequential impulse interface driven by PhysicsWorld's island solver. Bodies are
+    // point masses: anchors are offsets from body positions and angular terms use unit
+    // inertia. bindBodies() must succeed before the other calls.
+    bool bindBodies();
+    PhysicsBody* getPhysicsBodyA() const { return m_physicsA; }
+    PhysicsBody* getPhysicsBodyB() const { return m_physicsB; }
+    virtual void initVelocityConstraints(float dt, bool warmStart) = 0;
+    virtual void solveVelocityConstraints() = 0;
+    virtual void solvePositionConstraints() = 0;
+    
 protected:
     Joint(JointType type, ECS::Entity* bodyA, ECS::Entity* bodyB)
         : m_type(type), m_bodyA(bodyA), m_bodyB(bodyB) {}
     
+    // Impulses carried between steps for warm starting
+    virtual void saveSolverState(std::vector<float>& out) const = 0;
+    virtual const float* loadSolverState(const float* in) = 0;
+    
     JointType m_type;
     ECS::Entity* m_bodyA;
     ECS::Entity* m_bodyB;
+    PhysicsBody* m_physicsA{nullptr};
+    PhysicsBody* m_physicsB{nullptr};
+    float m_invDt{0.0f};
     float m_breakForce{0.0f};
     float m_breakTorque{0.0f};
     bool m_broken{false};
@@ -562,12 +751,33 @@ public:
     Math::Vector2D getReactionForce(float invDt) const override;
     float getReactionTorque(float invDt) const override { return 0.0f; }
     
+    void initVelocityConstraints(float dt, bool warmStart) override;
+    void solveVelocityConstraints() override;
+    void solvePositionConstraints() override;
+    
+protected:
+    void saveSolverState(std::vector<float>& out) const override;
+    const float* loadSolverState(const float* in) override;
+    
 private:
+    float lowerLength() const;
+    float upperLength() const;
+    
     Math::Vector2D m_anchorA, m_anchorB;
     float m_length;
     float m_minLength, m_maxLength;
     float m_stiffness, m_damping;
     float m_impulse{0.0f};
+    
+    // Solver state
+    Math::Vector2D m_axis;
+    float m_currentLength{0.0f};
+    float m_mass{0.0f};
+    float m_softMass{0.0f};
+    float m_gamma{0.0f};
+    float m_bias{0.0f};
+    float m_lowerImpulse{0.0f};
+    float m_upperImpulse{0.0f};
 };
 
 /**
@@ -596,6 +806,14 @@ public:
     Math::Vector2D getReactionForce(float invDt) const override;
     float getReactionTorque(float invDt) const override;
     
+    void initVelocityConstraints(float dt, bool warmStart) override;
+    void solveVelocityConstraints() override;
+    void solvePositionConstraints() override;
+    
+protected:
+    void saveSolverState(std::vector<float>& out) const override;
+    const float* loadSolverState(const float* in) override;
+    
 private:
     Math::Vector2D m_anchorA, m_anchorB;
     float m_referenceAngle;
@@ -605,6 +823,15 @@ private:
     float m_motorSpeed;
     float m_maxMotorTorque;
     JointLimitState m_limitState{JointLimitState::Inactive};
+    
+    // Solver state
+    Math::Vector2D m_linearImpulse;
+    float m_motorImpulse{0.0f};
+    float m_lowerImpulse{0.0f};
+    float m_upperImpulse{0.0f};
+    float m_linearMass{0.0f};
+    float m_axialMass{0.0f};
+    float m_dt{0.0f};
 };
 
 /**
@@ -629,12 +856,31 @@ public:
     Math::Vector2D getReactionForce(float invDt) const override;
     float getReactionTorque(float invDt) const override { return 0.0f; }
     
+    void initVelocityConstraints(float dt, bool warmStart) override;
+    void solveVelocityConstraints() override;
+    void solvePositionConstraints() override;
+    
+protected:
+    void saveSolverState(std::vector<float>& out) const override;
+    const float* loadSolverState(const float* in) override;
+    
 private:
     Math::Vector2D m_anchorA, m_anchorB;
     float m_restLength;
     float m_stiffness;
     float m_damping;
     float m_minLength, m_maxLength;
+    
+    // Solver state
+    Math::Vector2D m_axis;
+    float m_currentLength{0.0f};
+    float m_mass{0.0f};
+    float m_softMass{0.0f};
+    float m_gamma{0.0f};
+    float m_bias{0.0f};
+    float m_impulse{0.0f};
+    float m_lowerImpulse{0.0f};
+    float m_upperImpulse{0.0f};
 };
 
 /**
@@ -658,6 +904,7 @@ public:
     // Query
     std::vector<Joint*> getJointsForBody(ECS::Entity* body) const;
     size_t getJointCount() const { return m_joints.size(); }
+    const std::vector<std::unique_ptr<Joint>>& getJoints() const { return m_joints; }
     
     // Update
     void solveVelocityConstraints(float dt);
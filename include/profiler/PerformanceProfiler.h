@@ -8,6 +8,7 @@
 #include <memory>
 #include <mutex>
 #include <fstream>
+#include <functional>
 
 namespace JJM {
 namespace Utils {
@@ -425,6 +426,7 @@ private:
     std::vector<ProfileEntry> profileEntries;
     std::vector<ProfileEntry> completedEntries;
     std::unordered_map<std::string, std::vector<double>> timerHistory;
+    std::unordered_map<std::string, std::vector<double>> valueHistory;
     int currentDepth = 0;
     
     // Hierarchical profiling
@@ -497,6 +499,18 @@ public:
     void beginProfile(const std::string& name);
     void endProfile(const std::string& name);
     
+    // Record an already-measured interval (safe to call from worker threads, where
+    // begin/endProfile nesting does not apply)
+    void recordProfile(const std::string& name,
+                       std::chrono::high_resolution_clock::time_point startTime,
+                       std::chrono::high_resolution_clock::time_point endTime, int threadId = 0);
+    
+    // Record a per-frame measurement that is not a duration (e.g. achieved parallelism);
+    // kept with the same history length as timers and listed under "Values" in reports
+    void recordValue(const std::string& name, double value);
+    double getAverageValue(const std::string& name) const;
+    double getLastValue(const std::string& name) const;
+    
     // Timer history
     double getAverageTime(const std::string& name) const;
     double getMinTime(const std::string& name) const;
@@ -791,6 +805,7 @@ public:
     void endEvent(int trackId);
     void endEvent(const std::string& trackName);
     void addInstantEvent(int trackId, const std::string& name, uint32_t color = 0xFFFFFFFF);
+    void addEvent(int trackId, const TimelineEvent& event);   // Times already frame-relative
     
     // Markers
     void addMarker(const std::string& name, uint32_t color = 0xFF0000FF);
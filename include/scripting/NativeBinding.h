@@ -0,0 +1,298 @@
+#ifndef NATIVE_BINDING_H
+#define NATIVE_BINDING_H
+
+#include "scripting/ScriptVM.h"
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace JJM {
+namespace Scripting {
+
+// Binds C++ functions to the VM without ScriptValue conversion. Each binding is a thunk
+// generated from the function's signature: it reads every argument straight from the
+// caller's registers into the parameter type and boxes the result, so a call costs one
+// indirect call and no allocation.
+//
+//     float length(float x, float y);
+//     bindFunction<&length>(context, "length");
+//
+// Parameters may be numbers (int, float, double, ...), bool, std::string, std::string_view,
+// VMTable*, VMValue, VirtualMachine*, or any type with a NativeArgument specialization.
+// A type can take more than one script argument; Math::Vector2D takes two (see
+// VectorScriptBindings.h)
+
+inline VMValue nativeArgumentAt(const VMValue* arguments, uint32_t count, uint32_t index) {
+    return index < count ? arguments[index] : VMValue();
+}
+
+// Converts the script arguments starting at index to a parameter of type T
+template<typename T, typename Enable = void>
+struct NativeArgument;
+
+template<typename T>
+struct NativeArgument<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static constexpr uint32_t SLOTS = 1;
+    static T get(VirtualMachine& vm, const VMValue* arguments, uint32_t count, uint32_t index) {
+        VMValue value = nativeArgumentAt(arguments, count, index);
+        if (value.isInt()) return static_cast<T>(value.asInt());
+        if (!value.isDouble()) vm.argumentError(index, "number", value);
+        return static_cast<T>(value.asDouble());
+    }
+};
+
+// Floats convert when they hold a whole number in the 32-bit range
+template<typename T>
+struct NativeArgument<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static constexpr uint32_t SLOTS = 1;
+    static T get(VirtualMachine& vm, const VMValue* arguments, uint32_t count, uint32_t index) {
+        VMValue value = nativeArgumentAt(arguments, count, index);
+        if (value.isInt()) return static_cast<T>(value.asInt());
+        if (value.isDouble()) {
+            double d = value.asDouble();
+            if (d >= -2147483648.0 && d <= 2147483647.0 && d == std::floor(d)) {
+                return static_cast<T>(static_cast<int32_t>(d));
+            }
+        }
+        vm.argumentError(index, "integer", value);
+    }
+};
+
+// Any value; only nil and false are false
+template<>
+struct NativeArgument<bool> {
+    static constexpr uint32_t SLOTS = 1;
+    static bool get(VirtualMachine&, const VMValue* arguments, uint32_t count, uint32_t index) {
+        return nativeArgumentAt(arguments, count, index).isTruthy();
+    }
+};
+
+// Points at the interned string, which the caller's register keeps alive
+template<>
+struct NativeArgument<std::string_view> {
+    static constexpr uint32_t SLOTS = 1;
+    static std::string_view get(VirtualMachine& vm, const VMValue* arguments, uint32_t count,
+                                uint32_t index) {
+        VMValue value = nativeArgumentAt(arguments, count, index);
+        if (!value.isString()) vm.argumentError(index, "string", value);
+        return value.asString()->text;
+    }
+};
+
+template<>
+struct NativeArgument<std::string> {
+    static constexpr uint32_t SLOTS = 1;
+    static std::string get(VirtualMachine& vm, const VMValue* arguments, uint32_t count,
+                           uint32_t index) {
+        return std::string(NativeArgument<std::string_view>::get(vm, arguments, count, index));
+    }
+};
+
+template<>
+struct NativeArgument<VMTable*> {
+    static constexpr uint32_t SLOTS = 1;
+    static VMTable* get(VirtualMachine& vm, const VMValue* arguments, uint32_t count,
+                        uint32_t index) {
+        VMValue value = nativeArgumentAt(arguments, count, index);
+        if (!value.isTable()) vm.argumentError(index, "table", value);
+        return value.asTable();
+    }
+};
+
+template<>
+struct NativeArgument<VMValue> {
+    static constexpr uint32_t SLOTS = 1;
+    static VMValue get(VirtualMachine&, const VMValue* arguments, uint32_t count,
+                       uint32_t index) {
+        return nativeArgumentAt(arguments, count, index);
+    }
+};
+
+// The VM itself, for natives that allocate or raise errors; takes no script argument
+template<>
+struct NativeArgument<VirtualMachine*> {
+    static constexpr uint32_t SLOTS = 0;
+    static VirtualMachine* get(VirtualMachine& vm, const VMValue*, uint32_t, uint32_t) {
+        return &vm;
+    }
+};
+
+// Boxes a return value of type T
+template<typename T, typename Enable = void>
+struct NativeResult;
+
+template<typename T>
+struct NativeResult<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static VMValue box(VirtualMachine&, T value) {
+        return VMValue::number(static_cast<double>(value));
+    }
+};
+
+// Integers outside the 32-bit range become floats
+template<typename T>
+struct NativeResult<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+    static VMValue box(VirtualMachine&, T value) {
+        bool fits;
+        if constexpr (std::is_signed_v<T>) {
+            fits = static_cast<int64_t>(value) >= INT32_MIN &&
+                   static_cast<int64_t>(value) <= INT32_MAX;
+        } else {
+            fits = static_cast<uint64_t>(value) <= INT32_MAX;
+        }
+        if (fits) return VMValue::integer(static_cast<int32_t>(value));
+        return VMValue::number(static_cast<double>(value));
+    }
+};
+
+template<>
+struct NativeResult<bool> {
+    static VMValue box(VirtualMachine&, bool value) { return VMValue::boolean(value); }
+};
+
+template<>
+struct NativeResult<std::string_view> {
+    static VMValue box(VirtualMachine& vm, std::string_view value) {
+        return VMValue::string(vm.intern(value));
+    }
+};
+
+template<>
+struct NativeResult<std::string> {
+    static VMValue box(VirtualMachine& vm, const std::string& value) {
+        return VMValue::string(vm.intern(value));
+    }
+};
+
+template<>
+struct NativeResult<const char*> {
+    static VMValue box(VirtualMachine& vm, const char* value) {
+        return value ? VMValue::string(vm.intern(value)) : VMValue();
+    }
+};
+
+template<>
+struct NativeResult<VMTable*> {
+    static VMValue box(VirtualMachine&, VMTable* value) {
+        return value ? VMValue::table(value) : VMValue();
+    }
+};
+
+template<>
+struct NativeResult<VMValue> {
+    static VMValue box(VirtualMachine&, VMValue value) { return value; }
+};
+
+// Where each parameter's first script argument is, computed at compile time
+template<typename... Args>
+struct NativeLayout {
+    static constexpr uint32_t SLOTS[] = {NativeArgument<std::decay_t<Args>>::SLOTS..., 0};
+
+    static constexpr uint32_t offset(size_t parameter) {
+        uint32_t slot = 0;
+        for (size_t i = 0; i < parameter; ++i) slot += SLOTS[i];
+        return slot;
+    }
+
+    template<size_t Parameter>
+    static constexpr uint32_t OFFSET = offset(Parameter);
+};
+
+template<typename Class, typename Result, typename... Args>
+struct NativeCall {
+    template<auto Function, size_t... I>
+    static VMValue call(VirtualMachine& vm, void* context, const VMValue* arguments,
+                        uint32_t count, std::index_sequence<I...>) {
+        using Layout = NativeLayout<Args...>;
+        // Braced initialization converts the arguments left to right, so the first bad one
+        // is the one reported
+        std::tuple<std::decay_t<Args>...> values{NativeArgument<std::decay_t<Args>>::get(
+            vm, arguments, count, Layout::template OFFSET<I>)...};
+        static_cast<void>(arguments);
+        static_cast<void>(count);
+
+        auto invoke = [&]() -> Result {
+            if constexpr (std::is_void_v<Class>) {
+                static_cast<void>(context);
+                return Function(std::get<I>(values)...);
+            } else {
+                return (static_cast<Class*>(context)->*Function)(std::get<I>(values)...);
+            }
+        };
+        if constexpr (std::is_void_v<Result>) {
+            invoke();
+            return VMValue();
+        } else {
+            return NativeResult<std::decay_t<Result>>::box(vm, invoke());
+        }
+    }
+
+    template<auto Function>
+    static VMValue thunk(VirtualMachine& vm, void* context, const VMValue* arguments,
+                         uint32_t count) {
+        return call<Function>(vm, context, arguments, count, std::index_sequence_for<Args...>());
+    }
+};
+
+template<typename Signature>
+struct NativeSignature;
+
+template<typename Result, typename... Args>
+struct NativeSignature<Result (*)(Args...)> {
+    using Call = NativeCall<void, Result, Args...>;
+};
+
+template<typename Class, typename Result, typename... Args>
+struct NativeSignature<Result (Class::*)(Args...)> {
+    using Call = NativeCall<Class, Result, Args...>;
+};
+
+template<typename Class, typename Result, typename... Args>
+struct NativeSignature<Result (Class::*)(Args...) const> {
+    using Call = NativeCall<const Class, Result, Args...>;
+};
+
+// The thunk generated for a free function or member function pointer
+template<auto Function>
+constexpr NativeThunk nativeThunk() {
+    return &NativeSignature<decltype(Function)>::Call::template thunk<Function>;
+}
+
+// Adds a free function to the VM's natives and returns its index
+template<auto Function>
+uint32_t addNativeFunction(VirtualMachine& vm, const std::string& name) {
+    static_assert(!std::is_member_function_pointer_v<decltype(Function)>,
+                  "member functions need an instance; use addNativeMethod");
+    return vm.addNative(name, nativeThunk<Function>());
+}
+
+// Adds a member function called on instance, which must outlive the VM's use of it
+template<auto Method, typename Class>
+uint32_t addNativeMethod(VirtualMachine& vm, const std::string& name, Class* instance) {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>,
+                  "addNativeMethod takes a member function pointer");
+    return vm.addNative(name, nativeThunk<Method>(),
+                        const_cast<void*>(static_cast<const void*>(instance)));
+}
+
+// Binds a function to a global, like ScriptContext::registerFunction
+template<auto Function>
+void bindFunction(ScriptContext& context, const std::string& name) {
+    VirtualMachine& vm = context.getVM();
+    vm.setGlobal(vm.resolveGlobal(name), VMValue::native(addNativeFunction<Function>(vm, name)));
+}
+
+template<auto Method, typename Class>
+void bindMethod(ScriptContext& context, const std::string& name, Class* instance) {
+    VirtualMachine& vm = context.getVM();
+    vm.setGlobal(vm.resolveGlobal(name),
+                 VMValue::native(addNativeMethod<Method>(vm, name, instance)));
+}
+
+} // namespace Scripting
+} // namespace JJM
+
+#endif // NATIVE_BINDING_H
@@ -7,6 +7,8 @@
 #include <functional>
 #include <unordered_map>
 #include <any>
+#include <type_traits>
+#include <utility>
 
 namespace JJM {
 namespace Scripting {
@@ -369,26 +371,92 @@ public:
 // Template implementations
 template<typename T>
 ScriptValue TypeConverter::toScript(const T& value) {
-    (void)value;
-    return ScriptValue(); // Stub
+    if constexpr (std::is_same_v<T, ScriptValue>) {
+        return value;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return ScriptValue(value);
+    } else if constexpr (std::is_integral_v<T>) {
+        return ScriptValue(static_cast<int>(value));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return ScriptValue(static_cast<float>(value));
+    } else if constexpr (std::is_convertible_v<const T&, std::string>) {
+        return ScriptValue(std::string(value));
+    } else {
+        static_assert(sizeof(T) == 0, "no script conversion for this type");
+    }
 }
 
 template<typename T>
 T TypeConverter::fromScript(const ScriptValue& value) {
-    (void)value;
-    return T(); // Stub
+    if constexpr (std::is_same_v<T, ScriptValue>) {
+        return value;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return value.toBool();
+    } else if constexpr (std::is_integral_v<T>) {
+        return static_cast<T>(value.toInt());
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return static_cast<T>(value.toFloat());
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        return value.toString();
+    } else {
+        static_assert(sizeof(T) == 0, "no script conversion for this type");
+    }
 }
 
+namespace BindingDetail {
+
+// Missing arguments convert from null
+inline const ScriptValue& argument(const std::vector<ScriptValue>& args, size_t index) {
+    static const ScriptValue null;
+    return index < args.size() ? args[index] : null;
+}
+
+template<typename Ret, typename Call>
+ScriptValue result(Call&& call) {
+    if constexpr (std::is_void_v<Ret>) {
+        call();
+        return ScriptValue();
+    } else {
+        return TypeConverter::toScript<std::decay_t<Ret>>(call());
+    }
+}
+
+template<typename Ret, typename... Args, size_t... I>
+ScriptValue callFunction(Ret (*func)(Args...), const std::vector<ScriptValue>& args,
+                         std::index_sequence<I...>) {
+    static_cast<void>(args);
+    return result<Ret>([&]() -> Ret {
+        return func(TypeConverter::fromScript<std::decay_t<Args>>(argument(args, I))...);
+    });
+}
+
+template<typename Class, typename Ret, typename... Args, size_t... I>
+ScriptValue callMethod(Ret (Class::*method)(Args...), Class* instance,
+                       const std::vector<ScriptValue>& args, std::index_sequence<I...>) {
+    static_cast<void>(args);
+    return result<Ret>([&]() -> Ret {
+        return (instance->*method)(
+            TypeConverter::fromScript<std::decay_t<Args>>(argument(args, I))...);
+    });
+}
+
+} // namespace BindingDetail
+
+// These convert through the argument vector on every call; VM natives bound with
+// NativeBinding.h read their arguments in place instead
 template<typename Ret, typename... Args>
 ScriptFunction::NativeFunction BindingHelpers::wrapFunction(Ret(*func)(Args...)) {
-    (void)func;
-    return [](const std::vector<ScriptValue>&) { return ScriptValue(); }; // Stub
+    return [func](const std::vector<ScriptValue>& args) {
+        return BindingDetail::callFunction(func, args, std::index_sequence_for<Args...>());
+    };
 }
 
 template<typename Class, typename Ret, typename... Args>
 ScriptFunction::NativeFunction BindingHelpers::wrapMethod(Ret(Class::*method)(Args...), Class* instance) {
-    (void)method; (void)instance;
-    return [](const std::vector<ScriptValue>&) { return ScriptValue(); }; // Stub
+    return [method, instance](const std::vector<ScriptValue>& args) {
+        return BindingDetail::callMethod(method, instance, args,
+                                         std::index_sequence_for<Args...>());
+    };
 }
 
 template<typename T>
@@ -0,0 +1,268 @@
+#ifndef SCRIPT_COMPILER_H
+#define SCRIPT_COMPILER_H
+
+#include "scripting/ScriptVM.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace JJM {
+namespace Scripting {
+
+// Script language: a Lua subset with locals, global and local functions, if/while/numeric for,
+// tables with field and index access, and one return value per function. Functions cannot use
+// the locals of an enclosing function
+
+enum class TokenType {
+    NAME,
+    INTEGER,
+    NUMBER,
+    STRING,
+
+    // Keywords
+    AND,
+    BREAK,
+    DO,
+    ELSE,
+    ELSEIF,
+    END,
+    FALSE_KEYWORD,
+    FOR,
+    FUNCTION,
+    IF,
+    LOCAL,
+    NIL,
+    NOT,
+    OR,
+    RETURN,
+    THEN,
+    TRUE_KEYWORD,
+    WHILE,
+
+    // Symbols
+    PLUS,
+    MINUS,
+    STAR,
+    SLASH,
+    PERCENT,
+    HASH,
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    ASSIGN,
+    LEFT_PAREN,
+    RIGHT_PAREN,
+    LEFT_BRACE,
+    RIGHT_BRACE,
+    LEFT_BRACKET,
+    RIGHT_BRACKET,
+    SEMICOLON,
+    COMMA,
+    DOT,
+    CONCAT,
+    END_OF_FILE
+};
+
+struct Token {
+    TokenType type;
+    std::string text;  // Names and string contents
+    int32_t integer = 0;
+    double number = 0.0;
+    int line = 1;
+};
+
+class Lexer {
+public:
+    explicit Lexer(const std::string& source);
+
+    // Throws ScriptException on malformed input
+    std::vector<Token> tokenize();
+
+private:
+    const std::string& source;
+    size_t position;
+    int line;
+
+    void skipWhitespaceAndComments();
+    Token readNumber();
+    Token readString(char quote);
+    Token readName();
+    [[noreturn]] void error(const std::string& message) const;
+};
+
+// Syntax tree
+struct Expression;
+struct Statement;
+struct FunctionBody;
+using Block = std::vector<std::unique_ptr<Statement>>;
+
+struct Expression {
+    enum class Kind {
+        NIL,
+        TRUE_VALUE,
+        FALSE_VALUE,
+        INTEGER,
+        NUMBER,
+        STRING,
+        NAME,
+        INDEX,     // left[right]
+        CALL,      // left(arguments)
+        FUNCTION,
+        TABLE,     // {arguments..., [key] = value...}
+        BINARY,    // left op right
+        UNARY,     // op left
+        AND,
+        OR
+    };
+
+    Kind kind;
+    int line;
+    TokenType op = TokenType::END_OF_FILE;
+    int32_t integer = 0;
+    double number = 0.0;
+    std::string text;
+    std::unique_ptr<Expression> left;
+    std::unique_ptr<Expression> right;
+    std::vector<std::unique_ptr<Expression>> arguments;
+    std::vector<std::pair<std::unique_ptr<Expression>, std::unique_ptr<Expression>>> fields;
+    std::unique_ptr<FunctionBody> function;
+
+    Expression(Kind kind, int line) : kind(kind), line(line) {}
+};
+
+struct Statement {
+    enum class Kind {
+        CALL,            // values[0]
+        LOCAL,           // local names = values
+        ASSIGN,          // targets = values
+        IF,              // values are conditions, blocks their branches plus an optional else
+        WHILE,           // while values[0] do blocks[0]
+        NUMERIC_FOR,     // for names[0] = values[0], values[1], values[2] do blocks[0]
+        RETURN,          // optional values[0]
+        BREAK,
+        DO,              // blocks[0]
+        LOCAL_FUNCTION   // local function names[0], values[0]
+    };
+
+    Kind kind;
+    int line;
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<Expression>> targets;
+    std::vector<std::unique_ptr<Expression>> values;
+    std::vector<Block> blocks;
+
+    Statement(Kind kind, int line) : kind(kind), line(line) {}
+};
+
+struct FunctionBody {
+    std::string name;
+    std::vector<std::string> parameters;
+    Block body;
+    int line = 1;
+};
+
+class Parser {
+public:
+    explicit Parser(std::vector<Token> tokens);
+
+    // The whole script as the body of a function without parameters
+    std::unique_ptr<FunctionBody> parseChunk(const std::string& name);
+
+private:
+    std::vector<Token> tokens;
+    size_t current;
+
+    Block block();
+    std::unique_ptr<Statement> statement();
+    std::unique_ptr<Statement> ifStatement();
+    std::unique_ptr<Statement> forStatement();
+    std::unique_ptr<Statement> functionStatement();
+    std::unique_ptr<Statement> localStatement();
+    std::unique_ptr<Statement> expressionStatement();
+    std::unique_ptr<FunctionBody> functionBody(const std::string& name, int line);
+
+    std::unique_ptr<Expression> expression(int minPrecedence = 0);
+    std::unique_ptr<Expression> unary();
+    std::unique_ptr<Expression> suffixed();
+    std::unique_ptr<Expression> primary();
+    std::unique_ptr<Expression> table();
+
+    const Token& peek() const { return tokens[current]; }
+    bool check(TokenType type) const { return tokens[current].type == type; }
+    bool match(TokenType type);
+    const Token& expect(TokenType type, const char* what);
+    bool blockEnds() const;
+    [[noreturn]] void error(const std::string& message) const;
+};
+
+// Compiles syntax trees to prototypes in a VM, resolving global names to its slots
+class Compiler {
+public:
+    explicit Compiler(VirtualMachine& vm);
+
+    // Returns the prototype index of the compiled function
+    uint32_t compile(const FunctionBody& function);
+
+private:
+    struct LocalVariable {
+        std::string name;
+        int reg;
+    };
+
+    struct FunctionState {
+        FunctionState* enclosing;
+        std::unique_ptr<FunctionPrototype> prototype;
+        std::vector<LocalVariable> locals;
+        std::unordered_map<uint64_t, uint16_t> constantIndex;
+        std::vector<std::vector<size_t>*> breakJumps;  // Innermost loop last
+        int freeRegister = 0;
+        int localTop = 0;  // Registers below this hold named locals
+        int maxRegisters = 0;
+    };
+
+    VirtualMachine& vm;
+    FunctionState* state;
+
+    // Code
+    size_t emit(OpCode op, int a, int b, int c, int line);
+    size_t emitJump(int line);
+    void patchJump(size_t jump, size_t target);
+    size_t here() const { return state->prototype->code.size(); }
+    uint16_t constant(VMValue value, int line);
+    int allocate(int line);
+    int global(const std::string& name, int line);
+
+    // Statements
+    void block(const Block& statements);
+    void statement(const Statement& statement);
+    void localStatement(const Statement& statement);
+    void assignStatement(const Statement& statement);
+    void assign(const Expression& target, int source);
+    void ifStatement(const Statement& statement);
+    void whileStatement(const Statement& statement);
+    void forStatement(const Statement& statement);
+
+    // Expressions
+    void expression(const Expression& e, int target);
+    void call(const Expression& e, int target);
+    void comparison(const Expression& e, int expected, int line);
+    void condition(const Expression& e, std::vector<size_t>& falseJumps);
+    int operand(const Expression& e);
+    int anyRegister(const Expression& e);
+    int findLocal(const std::string& name, int line) const;
+    uint32_t function(const FunctionBody& body);
+
+    [[noreturn]] void error(int line, const std::string& message) const;
+};
+
+// Lexes, parses and compiles a script; returns the prototype index of its main function
+uint32_t compileScript(VirtualMachine& vm, const std::string& source, const std::string& name);
+
+} // namespace Scripting
+} // namespace JJM
+
+#endif // SCRIPT_COMPILER_H
@@ -10,6 +10,7 @@
 #include <chrono>
 #include <optional>
 #include <variant>
+#include <cstdint>
 
 namespace JJM {
 namespace Scripting {
@@ -241,78 +242,193 @@ public:
 
 /**
  * @brief Coroutine scheduler and manager
+ *
+ * Contexts live in a pool of fixed slots that are reused after a coroutine finishes, so
+ * starting, resuming and finishing coroutines allocates nothing once the pool has grown.
+ * Coroutines waiting for seconds or frames sleep in hierarchical timer wheels and are only
+ * touched when they are due (or when their wheel bucket cascades); condition, custom and
+ * coroutine waits are polled every frame. Due coroutines are resumed in order, up to the
+ * per-frame budget; the rest stay queued first in line for the next frame.
  */
 class CoroutineScheduler {
+public:
+    struct CoroutineStats {
+        uint64_t totalCreated = 0;
+        uint64_t totalCompleted = 0;
+        uint64_t totalCancelled = 0;
+        uint64_t totalErrors = 0;
+        uint64_t currentActive = 0;
+        float averageLifetime = 0.0f;  // Seconds, over completed coroutines
+
+        uint64_t totalResumes = 0;
+        uint64_t totalDeferred = 0;    // deferredLastFrame summed over updates
+
+        // Last update
+        uint32_t resumedLastFrame = 0;
+        uint32_t deferredLastFrame = 0;  // Due but left for the next frame
+        uint32_t timersFiredLastFrame = 0;
+        uint32_t polledLastFrame = 0;    // Condition, custom and coroutine waits checked
+        float lastUpdateMs = 0.0f;
+
+        // As of the last update
+        size_t sleeping = 0;             // Waiting for frames or seconds
+        size_t polling = 0;
+        size_t ready = 0;
+        size_t pooledContexts = 0;
+        size_t freeContexts = 0;
+    };
+
 private:
     static CoroutineScheduler* instance;
-    
-    std::map<uint64_t, std::unique_ptr<CoroutineContext>> coroutines;
-    std::map<uint64_t, CoroutineFunction> coroutineFunctions;
-    std::vector<uint64_t> activeCoroutines;
-    std::queue<uint64_t> pendingStart;
-    
-    uint64_t nextCoroutineId;
+
+    static constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+    static constexpr int WHEEL_LEVELS = 4;
+    static constexpr int WHEEL_BITS = 8;
+    static constexpr int WHEEL_BUCKETS = 1 << WHEEL_BITS;
+    static constexpr uint32_t POOL_CHUNK = 256;
+
+    // Intrusive list of slots, linked through CoroutineSlot::next/prev
+    struct SlotList {
+        uint32_t head = NO_SLOT;
+        uint32_t tail = NO_SLOT;
+        size_t size = 0;
+    };
+
+    // Expiries are in ticks; the wheel covers 2^32 ticks ahead, and later expiries wait in
+    // the last bucket and are reinserted when it comes due
+    struct TimerWheel {
+        SlotList buckets[WHEEL_LEVELS * WHEEL_BUCKETS];
+        uint64_t currentTick = 0;
+        size_t count = 0;
+    };
+
+    enum class SlotQueue : uint8_t {
+        None,
+        Pending,
+        Ready,
+        Polling,
+        FrameWheel,
+        TimeWheel,
+        Imminent    // Time waits due within the current tick
+    };
+
+    struct CoroutineSlot {
+        CoroutineContext context;       // context.id is 0 while the slot is free
+        CoroutineFunction function;
+        uint32_t generation = 0;
+        uint32_t next = NO_SLOT;
+        uint32_t prev = NO_SLOT;
+        SlotList* list = nullptr;
+        SlotQueue queue = SlotQueue::None;
+        SlotQueue pausedQueue = SlotQueue::None;
+        bool paused = false;
+        bool running = false;
+        uint64_t expiry = 0;            // Wheel tick, or frames left while paused
+        double deadline = 0.0;          // Scheduler time, or seconds left while paused
+        int yieldFrame = 0;
+        double startTime = 0.0;         // Scheduler time
+    };
+
+    std::vector<std::unique_ptr<CoroutineSlot[]>> pool;  // Chunks never move
+    std::vector<uint32_t> freeSlots;
+    size_t liveCount;
+
+    SlotList pending;                   // Started this frame; run from the next update
+    SlotList ready;
+    SlotList polling;
+    TimerWheel frameWheel;              // One tick per update
+    TimerWheel timeWheel;               // One tick per TIMER_RESOLUTION seconds
+    SlotList imminent;
+
     int currentFrame;
     float deltaTime;
-    
+    double currentTime;
+    std::chrono::steady_clock::time_point frameTimestamp;  // Read once per update
+
+    size_t maxResumesPerFrame;
+    float maxResumeMilliseconds;
+
     // Custom yield handlers
     std::map<std::string, std::function<bool(CoroutineContext&)>> customYieldHandlers;
-    
-    // Statistics
-    struct CoroutineStats {
-        uint64_t totalCreated;
-        uint64_t totalCompleted;
-        uint64_t totalCancelled;
-        uint64_t totalErrors;
-        uint64_t currentActive;
-        float averageLifetime;
-    };
+
     CoroutineStats stats;
-    
+
     CoroutineScheduler();
-    
+
 public:
+    static constexpr double TIMER_RESOLUTION = 0.001;
+
     ~CoroutineScheduler();
-    
+
+    CoroutineScheduler(const CoroutineScheduler&) = delete;
+    CoroutineScheduler& operator=(const CoroutineScheduler&) = delete;
+
     static CoroutineScheduler* getInstance();
     static void cleanup();
-    
-    // Coroutine creation
+
+    // Coroutine creation. New coroutines first run in the next update()
     uint64_t startCoroutine(const std::string& name, CoroutineFunction func);
     uint64_t startCoroutine(CoroutineFunction func);
     uint64_t startChildCoroutine(uint64_t parentId, const std::string& name, CoroutineFunction func);
-    
-    // Coroutine control
+
+    // Coroutine control. Stopping a coroutine also stops its children
     void stopCoroutine(uint64_t id);
     void stopAllCoroutines();
+    // A paused coroutine's wait is frozen until it is resumed
     void pauseCoroutine(uint64_t id);
     void resumeCoroutine(uint64_t id);
-    
-    // Query
+
+    // Query. A finished coroutine's context returns to the pool, after which its id reports
+    // Completed and getContext() returns null
     bool isRunning(uint64_t id) const;
     bool isCompleted(uint64_t id) const;
     CoroutineState getState(uint64_t id) const;
     CoroutineContext* getContext(uint64_t id);
     const CoroutineContext* getContext(uint64_t id) const;
-    
+
     // Update (call once per frame)
     void update(float dt);
-    
-    // Custom yield handlers
+
+    // Limits resumes per update by count and by time; 0 means no limit
+    void setResumeBudget(size_t maxResumes, float maxMilliseconds = 0.0f);
+    size_t getMaxResumesPerFrame() const { return maxResumesPerFrame; }
+    float getMaxResumeMilliseconds() const { return maxResumeMilliseconds; }
+
+    // Grows the context pool ahead of time
+    void reserve(size_t coroutineCount);
+
+    // Custom yield handlers; a Custom wait with no handler registered resumes at once
     void registerYieldHandler(const std::string& name, std::function<bool(CoroutineContext&)> handler);
     void unregisterYieldHandler(const std::string& name);
-    
+
     // Statistics
     const CoroutineStats& getStats() const { return stats; }
     void resetStats();
-    size_t getActiveCount() const { return activeCoroutines.size(); }
+    size_t getActiveCount() const { return liveCount; }
     std::vector<std::string> getActiveCoroutineNames() const;
-    
+
 private:
-    void processCoroutine(uint64_t id);
+    CoroutineSlot& slotAt(uint32_t index) const {
+        return pool[index / POOL_CHUNK][index % POOL_CHUNK];
+    }
+    CoroutineSlot* findSlot(uint64_t id) const;
+    uint32_t allocateSlot();
+
+    void pushBack(SlotList& list, uint32_t index, SlotQueue queue);
+    void unlink(uint32_t index);
+
+    void wheelInsert(TimerWheel& wheel, uint32_t index, uint64_t expiry, SlotQueue queue);
+    void wheelAdvance(TimerWheel& wheel, uint64_t tick, SlotQueue queue);
+    void wheelFire(TimerWheel& wheel, uint64_t tick, SlotQueue queue);
+
+    void schedule(uint32_t index);
+    void sleepFor(uint32_t index, double seconds);
+    void suspend(uint32_t index);
+    void restore(uint32_t index);
+    void processCoroutine(uint32_t index);
     bool checkYieldCondition(CoroutineContext& ctx);
-    void completeCoroutine(uint64_t id, bool success);
-    void removeCoroutine(uint64_t id);
+    void completeCoroutine(uint32_t index, CoroutineState state);
+    void removeCoroutine(uint32_t index);
 };
 
 /**
@@ -356,6 +472,8 @@ public:
     uint64_t startParallel();
 };
 
+class ScriptEngine;
+
 /**
  * @brief Sandboxed script execution environment with controlled API access
  */
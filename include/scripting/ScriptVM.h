@@ -0,0 +1,308 @@
+#ifndef SCRIPT_VM_H
+#define SCRIPT_VM_H
+
+#include "scripting/ScriptingEngine.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace JJM {
+namespace Scripting {
+
+class VMString;
+class VMTable;
+
+// NaN-boxed script value. Doubles are stored as themselves; every other type lives in the
+// payload of a quiet NaN, with pointers marked by the sign bit. Strings are interned, so two
+// strings are equal exactly when their bits are
+class VMValue {
+public:
+    static constexpr uint64_t QNAN = 0x7FF8000000000000ull;
+
+    // Top 16 bits of each boxed type
+    enum Header : uint16_t {
+        NIL = 0x7FF9,
+        FALSE_VALUE = 0x7FFA,
+        TRUE_VALUE = 0x7FFB,
+        INTEGER = 0x7FFC,
+        NATIVE = 0x7FFD,
+        FUNCTION = 0x7FFE,
+        STRING = 0xFFF9,
+        TABLE = 0xFFFA
+    };
+
+    uint64_t bits;
+
+    VMValue() : bits(static_cast<uint64_t>(NIL) << 48) {}
+
+    static VMValue boxed(Header header, uint64_t payload) {
+        VMValue value;
+        value.bits = (static_cast<uint64_t>(header) << 48) | payload;
+        return value;
+    }
+    static VMValue number(double d) {
+        VMValue value;
+        if (d != d) {
+            value.bits = QNAN;  // One NaN, so none collides with a boxed type
+        } else {
+            std::memcpy(&value.bits, &d, sizeof(d));
+        }
+        return value;
+    }
+    static VMValue integer(int32_t i) { return boxed(INTEGER, static_cast<uint32_t>(i)); }
+    static VMValue boolean(bool b) { return boxed(b ? TRUE_VALUE : FALSE_VALUE, 0); }
+    static VMValue native(uint32_t index) { return boxed(NATIVE, index); }
+    static VMValue function(uint32_t index) { return boxed(FUNCTION, index); }
+    static VMValue string(VMString* s) { return boxed(STRING, reinterpret_cast<uintptr_t>(s)); }
+    static VMValue table(VMTable* t) { return boxed(TABLE, reinterpret_cast<uintptr_t>(t)); }
+
+    uint16_t header() const { return static_cast<uint16_t>(bits >> 48); }
+    bool isDouble() const { return (bits & QNAN) != QNAN || bits == QNAN; }
+    bool isInt() const { return header() == INTEGER; }
+    bool isNumber() const { return isInt() || isDouble(); }
+    bool isNil() const { return header() == NIL; }
+    bool isBool() const { return header() == FALSE_VALUE || header() == TRUE_VALUE; }
+    bool isString() const { return header() == STRING; }
+    bool isTable() const { return header() == TABLE; }
+    bool isNative() const { return header() == NATIVE; }
+    bool isFunction() const { return header() == FUNCTION; }
+    bool isObject() const { return isString() || isTable(); }
+    bool isTruthy() const { return header() != NIL && header() != FALSE_VALUE; }
+
+    double asDouble() const {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+    int32_t asInt() const { return static_cast<int32_t>(static_cast<uint32_t>(bits)); }
+    double toDouble() const { return isInt() ? asInt() : asDouble(); }
+    uint32_t asIndex() const { return static_cast<uint32_t>(bits); }
+    VMString* asString() const {
+        return reinterpret_cast<VMString*>(static_cast<uintptr_t>(bits & 0xFFFFFFFFFFFFull));
+    }
+    VMTable* asTable() const {
+        return reinterpret_cast<VMTable*>(static_cast<uintptr_t>(bits & 0xFFFFFFFFFFFFull));
+    }
+
+    bool operator==(const VMValue& other) const { return bits == other.bits; }
+    bool operator!=(const VMValue& other) const { return bits != other.bits; }
+};
+
+// Objects owned by the VM's collector
+class VMObject {
+public:
+    virtual ~VMObject() = default;
+    VMObject* next = nullptr;
+    bool marked = false;
+};
+
+class VMString : public VMObject {
+public:
+    explicit VMString(std::string_view value) : text(value) {}
+    const std::string text;
+};
+
+// Table with an array part for keys 1..n and an open-addressed hash part for the rest
+class VMTable : public VMObject {
+public:
+    VMValue get(VMValue key) const;
+    void set(VMValue key, VMValue value);
+    size_t length() const { return array.size(); }
+
+    struct Entry {
+        VMValue key;
+        VMValue value;
+    };
+
+    std::vector<VMValue> array;
+    std::vector<Entry> entries;  // Power-of-two capacity; a nil value marks a dead entry
+    size_t used = 0;
+
+private:
+    const Entry* find(VMValue key) const;
+    void insert(VMValue key, VMValue value);
+    void grow();
+};
+
+// Bytecode. Operands B and C below 256 name registers and from 256 up name constants (RK);
+// jumps are relative to the next instruction
+enum class OpCode : uint8_t {
+    MOVE,       // R[A] = R[B]
+    LOADK,      // R[A] = K[B]
+    LOADNIL,    // R[A] = nil
+    LOADBOOL,   // R[A] = B != 0; if C skip the next instruction
+    GETGLOBAL,  // R[A] = globals[B]
+    SETGLOBAL,  // globals[B] = R[A]
+    NEWTABLE,   // R[A] = {}
+    GETTABLE,   // R[A] = R[B][RK(C)]
+    SETTABLE,   // R[A][RK(B)] = RK(C)
+    ADD,        // R[A] = RK(B) + RK(C)
+    SUB,
+    MUL,
+    DIV,        // Always a float
+    MOD,        // Floored
+    UNM,        // R[A] = -R[B]
+    NOT,        // R[A] = not R[B]
+    LEN,        // R[A] = #R[B]
+    CONCAT,     // R[A] = RK(B) .. RK(C)
+    JMP,        // pc += sB
+    EQ,         // if (RK(B) == RK(C)) != A skip the next instruction
+    LT,         // if (RK(B) < RK(C)) != A skip the next instruction
+    LE,         // if (RK(B) <= RK(C)) != A skip the next instruction
+    TEST,       // if R[A] is truthy != C skip the next instruction
+    CALL,       // R[A] = R[A](R[A+1], ..., R[A+B])
+    RETURN,     // return B ? R[A] : nil
+    FORPREP,    // R[A+3] = R[A]; pc += sB unless R[A] is within R[A+1] stepping by R[A+2]
+    FORLOOP     // R[A] += R[A+2]; if still within R[A+1], R[A+3] = R[A] and pc += sB
+};
+
+struct Instruction {
+    OpCode op;
+    uint8_t a;
+    uint16_t b;
+    uint16_t c;
+
+    int16_t sb() const { return static_cast<int16_t>(b); }
+};
+
+constexpr uint16_t RK_CONSTANT = 256;
+constexpr int MAX_REGISTERS = 250;
+
+struct FunctionPrototype {
+    std::string name;
+    uint8_t parameterCount = 0;
+    uint8_t registerCount = 0;
+    std::vector<Instruction> code;
+    std::vector<VMValue> constants;
+    std::vector<uint32_t> lines;  // Source line of each instruction
+};
+
+class VirtualMachine;
+
+// Native called on the VM's own values. The arguments point straight into the caller's
+// registers and are only valid until the thunk returns
+using NativeThunk = VMValue (*)(VirtualMachine& vm, void* context, const VMValue* arguments,
+                                uint32_t count);
+
+// Executes compiled functions over a fixed register stack. Globals live in slots that the
+// compiler resolves once, so running code never looks a name up
+class VirtualMachine {
+public:
+    VirtualMachine();
+    ~VirtualMachine();
+
+    VirtualMachine(const VirtualMachine&) = delete;
+    VirtualMachine& operator=(const VirtualMachine&) = delete;
+
+    // Globals
+    uint32_t resolveGlobal(const std::string& name);
+    int findGlobal(const std::string& name) const;
+    VMValue getGlobal(uint32_t slot) const { return globals[slot]; }
+    void setGlobal(uint32_t slot, VMValue value) { globals[slot] = value; }
+    size_t getGlobalCount() const { return globals.size(); }
+    const std::string& getGlobalName(uint32_t slot) const { return globalNames[slot]; }
+
+    // Functions. Natives added here live as long as the VM; host functions converted by
+    // fromScriptValue() are collected once no value refers to them
+    uint32_t addNative(const std::string& name, ScriptFunction function);
+    uint32_t addNative(const std::string& name, NativeThunk thunk, void* context = nullptr);
+    uint32_t addPrototype(std::unique_ptr<FunctionPrototype> prototype);
+    // Frees a prototype no value can refer to, such as a compiled chunk's main function.
+    // Returns false, keeping it, while it is running
+    bool releasePrototype(uint32_t index);
+    const FunctionPrototype& getPrototype(uint32_t index) const { return *prototypes[index]; }
+    const ScriptFunction& getNative(uint32_t index) const;
+    const std::string& getNativeName(uint32_t index) const { return natives[index].name; }
+    size_t getNativeCount() const { return natives.size() - freeNatives.size(); }
+
+    // Errors raised by thunks, with the calling line when a script made the call. Argument
+    // indices count from 0
+    [[noreturn]] void argumentError(uint32_t index, const char* expected, VMValue actual) const;
+    [[noreturn]] void nativeError(const std::string& message) const;
+
+    // Calls a function value; arguments and result are VM values
+    VMValue call(VMValue callee, const VMValue* arguments, size_t count);
+
+    // Calls a function value from the host. Natives get the arguments as they are
+    ScriptValue invoke(VMValue callee, const std::vector<ScriptValue>& arguments);
+
+    // Objects
+    VMString* intern(std::string_view text);
+    VMTable* newTable();
+    void collectGarbage();
+    size_t getObjectCount() const { return objectCount; }
+
+    // Conversions at the host boundary
+    VMValue fromScriptValue(const ScriptValue& value);
+    // Converts and stores a host value; collects first if enough garbage may have built up
+    void setGlobal(uint32_t slot, const ScriptValue& value);
+    ScriptValue toScriptValue(VMValue value);
+    std::string toString(VMValue value) const;
+    static const char* typeName(VMValue value);
+
+private:
+    struct CallFrame {
+        const FunctionPrototype* prototype;
+        const Instruction* pc;
+        VMValue* base;
+        VMValue* result;  // Where RETURN stores its value
+    };
+
+    struct NativeEntry {
+        std::string name;
+        // Shared so a call keeps it alive if the entry is freed or the table grows meanwhile
+        std::shared_ptr<ScriptFunction> function;
+        NativeThunk thunk;  // Called instead of the function when set
+        void* context;
+        bool collectable = false;  // Converted from a host value rather than added by name
+        bool marked = false;
+    };
+
+    std::vector<VMValue> globals;
+    std::vector<std::string> globalNames;
+    std::unordered_map<std::string, uint32_t> globalSlots;
+
+    std::vector<NativeEntry> natives;
+    std::vector<uint32_t> freeNatives;
+    size_t hostFunctionCount = 0;  // Live collectable natives
+    size_t nextNativeCollection = 256;
+    std::vector<std::unique_ptr<FunctionPrototype>> prototypes;
+    std::vector<uint32_t> freePrototypes;
+
+    std::vector<VMValue> stack;
+    std::vector<CallFrame> frames;
+    std::vector<std::vector<ScriptValue>> nativeArguments;  // One per nested native call
+    size_t nativeDepth = 0;
+    size_t conversionDepth = 0;
+    uint32_t activeNative = 0;                    // The thunk converting its arguments
+    const Instruction* nativeCallSite = nullptr;  // Its CALL, or null when the host called
+
+    std::unordered_map<std::string_view, VMString*> strings;
+    VMObject* objects = nullptr;
+    size_t objectCount = 0;
+    size_t nextCollection = 4096;
+
+    uint32_t addNativeEntry(NativeEntry entry);
+    bool collectionDue() const {
+        return objectCount >= nextCollection || hostFunctionCount >= nextNativeCollection;
+    }
+    void execute(size_t entryDepth);
+    VMValue callNative(uint32_t index, const VMValue* arguments, size_t count);
+    VMValue callThunk(uint32_t index, const VMValue* arguments, uint32_t count,
+                      const Instruction* callSite);
+    VMValue* stackTop();
+    bool lessThan(VMValue a, VMValue b, bool orEqual, const Instruction* pc);
+    [[noreturn]] void runtimeError(const Instruction* pc, const std::string& message) const;
+    [[noreturn]] void throwNativeError(const std::string& message) const;
+    void track(VMObject* object);
+    void mark(VMValue value, std::vector<VMTable*>& gray);
+};
+
+} // namespace Scripting
+} // namespace JJM
+
+#endif // SCRIPT_VM_H
@@ -1,10 +1,12 @@
 #ifndef SCRIPTING_ENGINE_H
 #define SCRIPTING_ENGINE_H
 
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include <list>
 #include <vector>
 #include <any>
 
@@ -69,9 +71,14 @@ private:
     std::string msg;
 };
 
-// Script context for execution
+class VirtualMachine;
+
+// Script context for execution. Scripts are compiled once to bytecode for the context's VM;
+// globals and registered functions share one namespace of slots
 class ScriptContext {
 public:
+    using GlobalSlot = uint32_t;
+
     ScriptContext();
     ~ScriptContext();
     
@@ -79,24 +86,37 @@ public:
     void setGlobal(const std::string& name, const ScriptValue& value);
     ScriptValue getGlobal(const std::string& name) const;
     
+    // Slot access for hot paths: resolve a name once, then skip the lookup on every use
+    GlobalSlot resolveGlobal(const std::string& name);
+    void setGlobal(GlobalSlot slot, const ScriptValue& value);
+    ScriptValue getGlobal(GlobalSlot slot) const;
+    
     // Function registration
     void registerFunction(const std::string& name, ScriptFunction func);
     
-    // Script execution
+    // Script execution; the most recent MAX_COMPILED_CHUNKS source texts stay compiled
     void loadScript(const std::string& filename);
     void loadString(const std::string& code);
     ScriptValue callFunction(const std::string& name, const std::vector<ScriptValue>& args = {});
+    ScriptValue callFunction(GlobalSlot slot, const std::vector<ScriptValue>& args = {});
     
     // Error handling
     std::string getLastError() const { return lastError; }
     
+    VirtualMachine& getVM() { return *vm; }
+    
 private:
-    std::unordered_map<std::string, ScriptValue> globals;
-    std::unordered_map<std::string, ScriptFunction> functions;
-    std::string lastError;
+    static constexpr size_t MAX_COMPILED_CHUNKS = 64;
+    
+    struct CompiledChunk {
+        uint32_t function;  // The chunk's main function
+        std::list<const std::string*>::iterator order;
+    };
     
-    void executeCode(const std::string& code);
-    ScriptValue evaluateExpression(const std::string& expr);
+    std::unique_ptr<VirtualMachine> vm;
+    std::unordered_map<std::string, CompiledChunk> compiledChunks;  // By source text
+    std::list<const std::string*> chunkOrder;  // Most recently loaded at front
+    std::string lastError;
 };
 
 // Script manager
@@ -0,0 +1,49 @@
+#ifndef VECTOR_SCRIPT_BINDINGS_H
+#define VECTOR_SCRIPT_BINDINGS_H
+
+#include "math/Vector2D.h"
+#include "scripting/NativeBinding.h"
+
+namespace JJM {
+namespace Scripting {
+
+// A Vector2D parameter takes two number arguments, x then y
+template<>
+struct NativeArgument<Math::Vector2D> {
+    static constexpr uint32_t SLOTS = 2;
+    static Math::Vector2D get(VirtualMachine& vm, const VMValue* arguments, uint32_t count,
+                              uint32_t index) {
+        return Math::Vector2D(NativeArgument<float>::get(vm, arguments, count, index),
+                              NativeArgument<float>::get(vm, arguments, count, index + 1));
+    }
+};
+
+// Vector2D functions for scripts, bound through native thunks. Single vectors are passed as
+// x, y argument pairs. The bulk functions work in place on arrays of packed components
+// {x1, y1, x2, y2, ...}, so a whole set of vectors crosses into C++ in one call instead of
+// one call per vector; each returns the number of vectors it processed
+class VectorScriptBindings {
+public:
+    // vectorLength, vectorDot, vectorCross, vectorDistance and vectorAngle, and the bulk
+    // vectorIntegrate and vector*All functions. MathScriptBindings' vec2* functions take
+    // {x, y} tables instead
+    static void registerBindings(ScriptContext* context);
+
+    static float length(Math::Vector2D v);
+    static float angle(Math::Vector2D v);
+
+    // positions[i] += velocities[i] * dt
+    static int integrate(VirtualMachine* vm, VMTable* positions, VMTable* velocities, float dt);
+    static int translateAll(VirtualMachine* vm, VMTable* vectors, Math::Vector2D offset);
+    static int scaleAll(VirtualMachine* vm, VMTable* vectors, float factor);
+    // Zero-length vectors stay zero
+    static int normalizeAll(VirtualMachine* vm, VMTable* vectors);
+    static int clampLengthAll(VirtualMachine* vm, VMTable* vectors, float maxLength);
+    // lengths[i] = |vectors[i]|; lengths is resized to the vector count
+    static int lengthsAll(VirtualMachine* vm, VMTable* vectors, VMTable* lengths);
+};
+
+} // namespace Scripting
+} // namespace JJM
+
+#endif // VECTOR_SCRIPT_BINDINGS_H
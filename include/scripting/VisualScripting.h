@@ -1,6 +1,7 @@
 #ifndef VISUAL_SCRIPTING_H
 #define VISUAL_SCRIPTING_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
@@ -8,6 +9,10 @@
 #include <functional>
 
 namespace JJM {
+namespace Threading {
+class JobSystem;
+}
+
 namespace Scripting {
 
 enum class PinType {
@@ -27,26 +32,88 @@ struct Pin {
     int index;
 };
 
+// What a node computes. Compiled plans run the built-in operations inline; CUSTOM nodes
+// are called through VisualScriptNode::evaluate()
+enum class NodeOp : uint8_t {
+    CUSTOM,
+    CONSTANT,      // Output: a fixed value
+    GET_VARIABLE,  // Output: an instance variable
+    SET_VARIABLE,  // Writes its input to an instance variable after the rest of the graph ran
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    MIN,
+    MAX,
+    NEGATE,
+    ABS,
+    SQRT,
+    SIN,
+    COS,
+    LESS,
+    GREATER,
+    EQUAL,
+    AND,
+    OR,
+    NOT,
+    SELECT,        // condition ? a : b
+    CLAMP,         // value, min, max
+    LERP           // a, b, t
+};
+
+// Values on FLOAT, INT and BOOL pins are floats; booleans are 0 or 1
 class VisualScriptNode {
 public:
-    VisualScriptNode(int id, const std::string& type);
+    VisualScriptNode(int id, const std::string& type, NodeOp op = NodeOp::CUSTOM);
     virtual ~VisualScriptNode() = default;
-    
+
     int getId() const { return m_id; }
     const std::string& getType() const { return m_type; }
+    NodeOp getOp() const { return m_op; }
     const std::vector<Pin>& getInputs() const { return m_inputs; }
     const std::vector<Pin>& getOutputs() const { return m_outputs; }
-    
-    virtual void execute() = 0;
-    
+
+    // Used by inputs without a connection
+    void setInputDefault(int pin, float value);
+    float getInputDefault(int pin) const { return m_defaults[pin]; }
+
+    // Computes the outputs from the inputs, one value per pin. Batched instances call this
+    // from worker threads, so it must not modify shared state
+    virtual void evaluate(const float* inputs, float* outputs) const = 0;
+
+    // Nodes with side effects are kept even when no variable depends on their outputs
+    virtual bool hasSideEffects() const { return false; }
+
 protected:
     void addInput(const std::string& name, PinType type);
     void addOutput(const std::string& name, PinType type);
-    
+
     int m_id;
     std::string m_type;
+    NodeOp m_op;
     std::vector<Pin> m_inputs;
     std::vector<Pin> m_outputs;
+    std::vector<float> m_defaults;
+};
+
+// The built-in node types, created by VisualScript::addNode()
+class BuiltinNode : public VisualScriptNode {
+public:
+    BuiltinNode(int id, const std::string& type, NodeOp op);
+
+    void evaluate(const float* inputs, float* outputs) const override;
+
+    // CONSTANT nodes
+    void setValue(float value) { m_value = value; }
+    float getValue() const { return m_value; }
+
+    // GET_VARIABLE and SET_VARIABLE nodes
+    void setVariable(const std::string& name) { m_variable = name; }
+    const std::string& getVariable() const { return m_variable; }
+
+private:
+    float m_value;
+    std::string m_variable;
 };
 
 struct NodeConnection {
@@ -56,23 +123,143 @@ struct NodeConnection {
     int targetPin;
 };
 
+// One step of a compiled plan, on value slots
+struct PlanInstruction {
+    NodeOp op;
+    uint16_t output;     // First output slot; CUSTOM nodes index the plan's calls instead
+    uint16_t inputs[3];
+};
+
+// A graph compiled to a flat, topologically ordered instruction array. Every pin resolves to
+// a slot in one value buffer per instance, laid out as variables, then constants, then
+// temporaries. Nodes that no variable or side effect depends on are dropped, and nodes whose
+// inputs are all constant are evaluated at compile time.
+//
+// Instances are stored slot-major (slot s of instance i at values[s * stride + i]), so each
+// instruction runs over a block of instances before the next one starts
+class VisualScriptPlan {
+public:
+    struct Stats {
+        size_t nodes = 0;
+        size_t eliminatedNodes = 0;
+        size_t foldedNodes = 0;
+        size_t instructions = 0;
+        size_t slots = 0;
+    };
+
+    // Runs instances first..first+count-1
+    void execute(float* values, size_t stride, size_t first, size_t count) const;
+
+    // -1 if the graph does not use the variable
+    int getVariableSlot(const std::string& name) const;
+    const std::vector<std::string>& getVariableNames() const { return m_variables; }
+
+    size_t getSlotCount() const { return m_initialValues.size(); }
+    const std::vector<float>& getInitialValues() const { return m_initialValues; }
+    const std::vector<PlanInstruction>& getInstructions() const { return m_code; }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    friend class VisualScript;
+
+    struct Call {
+        const VisualScriptNode* node;
+        std::vector<uint16_t> inputs;
+        std::vector<uint16_t> outputs;
+    };
+
+    std::vector<PlanInstruction> m_code;
+    std::vector<Call> m_calls;
+    std::vector<float> m_initialValues;
+    std::vector<std::string> m_variables;  // Variable i lives in slot i
+    std::vector<std::shared_ptr<const VisualScriptNode>> m_customNodes;  // Kept alive for calls
+    Stats m_stats;
+};
+
 class VisualScript {
 public:
     VisualScript();
     ~VisualScript();
-    
+
+    // Built-in node by type name ("Add", "Constant", "GetVariable", ...); -1 if unknown
     int addNode(const std::string& type);
+
+    // Node of a VisualScriptNode subclass, constructed as T(id, args...)
+    template<typename T, typename... Args>
+    int addCustomNode(Args&&... args) {
+        int id = m_nextNodeId++;
+        m_nodes.push_back(std::make_shared<T>(id, std::forward<Args>(args)...));
+        m_dirty = true;
+        return id;
+    }
+
     void removeNode(int nodeId);
+    VisualScriptNode* getNode(int nodeId);
+
+    // Replaces any connection into the target pin; false for unknown pins or mismatched types
     bool connectNodes(int sourceNode, int sourcePin, int targetNode, int targetPin);
-    
+
+    bool setConstant(int nodeId, float value);
+    bool setNodeVariable(int nodeId, const std::string& name);
+    bool setInputDefault(int nodeId, int pin, float value);
+
+    // Initial value of a variable in new instances
+    void setVariableDefault(const std::string& name, float value);
+
+    // Runs the graph on the script's own instance, compiling it first if it changed
     void execute();
-    
+    float getVariable(const std::string& name) const;
+    void setVariable(const std::string& name, float value);
+
+    // False on cycles or unsupported pin types, with the reason in getCompileError()
     bool compile();
-    
+    std::shared_ptr<const VisualScriptPlan> getPlan() const { return m_plan; }
+    const std::string& getCompileError() const { return m_compileError; }
+
 private:
-    std::vector<std::unique_ptr<VisualScriptNode>> m_nodes;
+    std::vector<std::shared_ptr<VisualScriptNode>> m_nodes;
     std::vector<NodeConnection> m_connections;
+    std::unordered_map<std::string, float> m_variableDefaults;
     int m_nextNodeId;
+
+    std::shared_ptr<const VisualScriptPlan> m_plan;
+    std::vector<float> m_values;  // The script's own instance
+    std::string m_compileError;
+    bool m_dirty;
+};
+
+// Many instances of one compiled graph, executed together. Blocks of instances are spread
+// across JobSystem workers when one is set
+class VisualScriptBatch {
+public:
+    explicit VisualScriptBatch(std::shared_ptr<const VisualScriptPlan> plan);
+
+    // Returns the new instance's index
+    size_t addInstance();
+    // The last instance takes over the removed one's index
+    void removeInstance(size_t index);
+    size_t getInstanceCount() const { return m_count; }
+
+    float getVariable(size_t instance, int slot) const {
+        return m_values[slot * m_capacity + instance];
+    }
+    void setVariable(size_t instance, int slot, float value) {
+        m_values[slot * m_capacity + instance] = value;
+    }
+
+    void setJobSystem(Threading::JobSystem* jobSystem) { m_jobSystem = jobSystem; }
+    void execute();
+
+    const VisualScriptPlan& getPlan() const { return *m_plan; }
+
+private:
+    std::shared_ptr<const VisualScriptPlan> m_plan;
+    std::vector<float> m_values;
+    size_t m_count;
+    size_t m_capacity;
+    Threading::JobSystem* m_jobSystem;
+
+    void grow();
 };
 
 class VisualScriptingSystem {
@@ -80,7 +267,7 @@ public:
     void registerScript(const std::string& name, VisualScript* script);
     VisualScript* getScript(const std::string& name);
     void executeScript(const std::string& name);
-    
+
 private:
     std::unordered_map<std::string, VisualScript*> m_scripts;
 };
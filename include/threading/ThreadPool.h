@@ -16,8 +16,17 @@
 #include <string>
 #include <array>
 #include <optional>
+#include <type_traits>
+#include <new>
+#include <cstddef>
+#include <cstdint>
 
 namespace JJM {
+
+namespace Utils {
+class TimelineProfiler;
+}
+
 namespace Threading {
 
 // =============================================================================
@@ -81,34 +90,138 @@ struct JobDescriptor {
     {}
 };
 
-// Job class representing a unit of work
-class Job {
+// Small-buffer callable stored inside pooled jobs. Captures up to CAPACITY bytes live in
+// the job itself; larger ones fall back to one heap allocation.
+class JobCallable {
+public:
+    static constexpr size_t CAPACITY = 48;
+    
+    JobCallable() : invokeFn(nullptr), destroyFn(nullptr) {}
+    ~JobCallable() { reset(); }
+    
+    JobCallable(const JobCallable&) = delete;
+    JobCallable& operator=(const JobCallable&) = delete;
+    
+    template<typename F>
+    void assign(F&& func) {
+        using T = std::decay_t<F>;
+        reset();
+        if constexpr (sizeof(T) <= CAPACITY && alignof(T) <= alignof(std::max_align_t)) {
+            new (storage) T(std::forward<F>(func));
+            invokeFn = [](void* p) { (*static_cast<T*>(p))(); };
+            destroyFn = [](void* p) { static_cast<T*>(p)->~T(); };
+        } else {
+            new (storage) T*(new T(std::forward<F>(func)));
+            invokeFn = [](void* p) { (**static_cast<T**>(p))(); };
+            destroyFn = [](void* p) { delete *static_cast<T**>(p); };
+        }
+    }
+    
+    void operator()() { invokeFn(storage); }
+    explicit operator bool() const { return invokeFn != nullptr; }
+    
+    void reset() {
+        if (destroyFn) destroyFn(storage);
+        invokeFn = nullptr;
+        destroyFn = nullptr;
+    }
+    
+private:
+    alignas(std::max_align_t) unsigned char storage[CAPACITY];
+    void (*invokeFn)(void*);
+    void (*destroyFn)(void*);
+};
+
+// Job counter for batching. Jobs dispatched against a counter decrement it as their last
+// action, so the counter may be destroyed as soon as it reads zero.
+//
+// The count shares one atomic word with the fiber (if any) suspended on it, so the
+// decrement that reaches zero both observes and resumes the waiter. wait() suspends the
+// calling fiber in a fiber-mode JobSystem, runs other jobs on a worker thread, and yields
+// elsewhere; JobSystem::wait(counter) also rethrows job exceptions.
+class JobCounter {
     friend class JobSystem;
     
 private:
-    JobHandle handle;
-    JobDescriptor descriptor;
+    static constexpr uint64_t COUNT_MASK = 0xFFFFFFFFull;
+    
+    std::atomic<uint64_t> state;    // Count in the low 32 bits, waiting fiber + 1 above
+    std::atomic<bool> failed;
+    std::exception_ptr failure;     // First exception thrown by a job on this counter
+    JobSystem* waitingSystem;       // Owner of the waiting fiber
+    
+public:
+    JobCounter(int initial = 0)
+        : state(static_cast<uint32_t>(initial)), failed(false), waitingSystem(nullptr) {}
+    
+    void increment(int amount = 1) {
+        state.fetch_add(static_cast<uint32_t>(amount), std::memory_order_relaxed);
+    }
+    void decrement();
+    
+    void wait();
+    bool waitFor(std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!isDone()) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+    
+    int get() const {
+        return static_cast<int>(state.load(std::memory_order_acquire) & COUNT_MASK);
+    }
+    bool isDone() const { return get() == 0; }
+    
+private:
+    void fail(std::exception_ptr exception) {
+        if (!failed.exchange(true, std::memory_order_acq_rel)) {
+            failure = exception;
+        }
+    }
+};
+
+// Job class representing a unit of work. Jobs are pooled by their JobSystem and reused
+// once finished; a handle names one use of a slot, so stale handles read as complete.
+class alignas(64) Job {
+    friend class JobSystem;
+    
+private:
+    std::atomic<JobHandle> handle;
     std::atomic<JobStatus> status;
     std::atomic<int> dependencyCount;
-    std::vector<JobHandle> dependents;
+    TaskPriority priority;
+    bool canBeCancelled;
+    bool dependentsClosed;          // Set on completion; later dependents start immediately
+    std::atomic_flag dependentsLock = ATOMIC_FLAG_INIT;
+    uint32_t slot;
+    uint32_t generation;
+    JobCallable function;
+    JobCounter* counter;
+    std::vector<Job*> dependents;
+    std::string name;
     std::chrono::high_resolution_clock::time_point startTime;
     std::chrono::high_resolution_clock::time_point endTime;
     std::exception_ptr exception;
-    std::mutex mutex;
-    std::condition_variable completionCV;
     
 public:
-    Job(JobHandle h, const JobDescriptor& desc)
-        : handle(h)
-        , descriptor(desc)
-        , status(JobStatus::Pending)
-        , dependencyCount(static_cast<int>(desc.dependencies.size()))
+    Job()
+        : handle(0)
+        , status(JobStatus::Completed)
+        , dependencyCount(0)
+        , priority(TaskPriority::Normal)
+        , canBeCancelled(true)
+        , dependentsClosed(true)
+        , slot(0)
+        , generation(1)
+        , counter(nullptr)
     {}
     
-    JobHandle getHandle() const { return handle; }
+    JobHandle getHandle() const { return handle.load(std::memory_order_acquire); }
     JobStatus getStatus() const { return status.load(); }
-    const std::string& getName() const { return descriptor.name; }
-    TaskPriority getPriority() const { return descriptor.priority; }
+    const std::string& getName() const { return name; }
+    TaskPriority getPriority() const { return priority; }
     
     bool isComplete() const {
         auto s = status.load();
@@ -116,15 +229,23 @@ public:
     }
     
     void wait() {
-        std::unique_lock<std::mutex> lock(mutex);
-        completionCV.wait(lock, [this] { return isComplete(); });
+        JobHandle current = getHandle();
+        while (getHandle() == current && !isComplete()) {
+            std::this_thread::yield();
+        }
     }
     
     bool waitFor(std::chrono::milliseconds timeout) {
-        std::unique_lock<std::mutex> lock(mutex);
-        return completionCV.wait_for(lock, timeout, [this] { return isComplete(); });
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        JobHandle current = getHandle();
+        while (getHandle() == current && !isComplete()) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            std::this_thread::yield();
+        }
+        return true;
     }
     
+    // Only measured while JobSystem profiling is enabled
     std::chrono::microseconds getExecutionTime() const {
         return std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime);
     }
@@ -136,145 +257,108 @@ public:
     }
 };
 
-// Priority-based job queue
-class PriorityJobQueue {
-private:
-    static constexpr size_t NUM_PRIORITIES = static_cast<size_t>(TaskPriority::Count);
-    std::array<std::deque<std::shared_ptr<Job>>, NUM_PRIORITIES> queues;
-    mutable std::mutex mutex;
-    std::condition_variable condition;
-    std::atomic<size_t> totalCount;
-    
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models"). The owning thread pushes and pops at the bottom without locks; any
+// thread may steal from the top. The ring grows when full; retired rings are kept until
+// destruction because a thief may still be reading one. The paper's seq_cst fences are
+// folded into seq_cst accesses, which cost the same on x86 and are visible to TSan.
+template<typename T>
+class WorkStealingDeque {
 public:
-    PriorityJobQueue() : totalCount(0) {}
-    
-    void push(std::shared_ptr<Job> job) {
-        std::lock_guard<std::mutex> lock(mutex);
-        size_t priority = static_cast<size_t>(job->getPriority());
-        queues[priority].push_back(std::move(job));
-        ++totalCount;
-        condition.notify_one();
+    explicit WorkStealingDeque(size_t capacity = 256) : top(0), bottom(0) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        rings.push_back(std::make_unique<Ring>(size));
+        ring.store(rings.back().get(), std::memory_order_relaxed);
     }
     
-    std::shared_ptr<Job> pop() {
-        std::unique_lock<std::mutex> lock(mutex);
-        condition.wait(lock, [this] { return totalCount > 0; });
-        
-        for (auto& queue : queues) {
-            if (!queue.empty()) {
-                auto job = std::move(queue.front());
-                queue.pop_front();
-                --totalCount;
-                return job;
-            }
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+    
+    // Owner only
+    void push(T item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Ring* current = ring.load(std::memory_order_relaxed);
+        if (b - t > current->mask) {
+            current = grow(current, t, b);
         }
-        return nullptr;
+        current->put(b, item);
+        bottom.store(b + 1, std::memory_order_release);
     }
     
-    std::shared_ptr<Job> tryPop() {
-        std::lock_guard<std::mutex> lock(mutex);
+    // Owner only; LIFO
+    bool pop(T& out) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring* current = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_seq_cst);
         
-        for (auto& queue : queues) {
-            if (!queue.empty()) {
-                auto job = std::move(queue.front());
-                queue.pop_front();
-                --totalCount;
-                return job;
-            }
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
         }
-        return nullptr;
-    }
-    
-    bool trySteal(std::shared_ptr<Job>& outJob, TaskPriority maxPriority = TaskPriority::Idle) {
-        std::lock_guard<std::mutex> lock(mutex);
         
-        // Steal from back (oldest jobs of same priority)
-        for (size_t i = 0; i <= static_cast<size_t>(maxPriority); ++i) {
-            if (!queues[i].empty()) {
-                outJob = std::move(queues[i].back());
-                queues[i].pop_back();
-                --totalCount;
-                return true;
-            }
+        out = current->get(b);
+        if (t == b) {
+            // Last item: race thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
         }
-        return false;
+        return true;
     }
     
-    size_t size() const { return totalCount.load(); }
-    bool empty() const { return totalCount.load() == 0; }
-    
-    void notifyAll() { condition.notify_all(); }
-};
-
-// Per-thread local queue for work stealing
-class ThreadLocalQueue {
-private:
-    std::deque<std::shared_ptr<Job>> localQueue;
-    mutable std::mutex mutex;
-    
-public:
-    void push(std::shared_ptr<Job> job) {
-        std::lock_guard<std::mutex> lock(mutex);
-        localQueue.push_front(std::move(job));  // LIFO for local
-    }
-    
-    std::shared_ptr<Job> pop() {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (localQueue.empty()) return nullptr;
-        auto job = std::move(localQueue.front());
-        localQueue.pop_front();
-        return job;
-    }
-    
-    std::shared_ptr<Job> steal() {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (localQueue.empty()) return nullptr;
-        auto job = std::move(localQueue.back());  // FIFO for stealing
-        localQueue.pop_back();
-        return job;
+    // Any thread; FIFO. Fails on an empty deque or a lost race.
+    bool steal(T& out) {
+        int64_t t = top.load(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_seq_cst);
+        if (t >= b) return false;
+        
+        Ring* current = ring.load(std::memory_order_acquire);
+        T item = current->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
     }
     
     size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return localQueue.size();
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
     }
+    bool empty() const { return size() == 0; }
     
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(mutex);
-        return localQueue.empty();
-    }
-};
-
-// Job counter for batching
-class JobCounter {
 private:
-    std::atomic<int> count;
-    std::mutex mutex;
-    std::condition_variable cv;
-    
-public:
-    JobCounter(int initial = 0) : count(initial) {}
-    
-    void increment() { ++count; }
+    struct Ring {
+        int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> items;
+        
+        explicit Ring(size_t size)
+            : mask(static_cast<int64_t>(size) - 1), items(new std::atomic<T>[size]) {}
+        
+        T get(int64_t index) const { return items[index & mask].load(std::memory_order_relaxed); }
+        void put(int64_t index, T item) { items[index & mask].store(item, std::memory_order_relaxed); }
+    };
     
-    void decrement() {
-        if (--count == 0) {
-            std::lock_guard<std::mutex> lock(mutex);
-            cv.notify_all();
+    Ring* grow(Ring* current, int64_t t, int64_t b) {
+        rings.push_back(std::make_unique<Ring>(static_cast<size_t>(current->mask + 1) * 2));
+        Ring* larger = rings.back().get();
+        for (int64_t i = t; i < b; ++i) {
+            larger->put(i, current->get(i));
         }
+        ring.store(larger, std::memory_order_release);
+        return larger;
     }
     
-    void wait() {
-        std::unique_lock<std::mutex> lock(mutex);
-        cv.wait(lock, [this] { return count.load() == 0; });
-    }
-    
-    bool waitFor(std::chrono::milliseconds timeout) {
-        std::unique_lock<std::mutex> lock(mutex);
-        return cv.wait_for(lock, timeout, [this] { return count.load() == 0; });
-    }
-    
-    int get() const { return count.load(); }
+    alignas(64) std::atomic<int64_t> top;
+    alignas(64) std::atomic<int64_t> bottom;
+    std::atomic<Ring*> ring;
+    std::vector<std::unique_ptr<Ring>> rings;   // Owner only
 };
 
 // Task graph node for complex dependencies
@@ -292,15 +376,58 @@ struct TaskGraphNode {
     {}
 };
 
+// When a node ran during the last kick, in microseconds from the kick
+struct TaskGraphNodeTiming {
+    uint64_t startMicros;
+    uint64_t endMicros;
+    int threadIndex;    // JobSystem worker, worker count for the startup thread, else -1
+    
+    TaskGraphNodeTiming() : startMicros(0), endMicros(0), threadIndex(-1) {}
+};
+
 // Task graph for expressing complex job dependencies
+//
+// compile() turns the nodes into a flat plan that JobSystem::kick() runs as often as
+// needed without allocating: dependency counters are pre-sized and reset on every kick,
+// and each finishing node dispatches the dependents it made ready. Node costs are
+// learned from the timings of the previous kick; nodes on the longest path run one
+// priority level higher, and among ready siblings the most critical runs first. A graph
+// must finish before it is kicked again.
 class TaskGraph {
+    friend class JobSystem;
+    
 private:
     std::vector<TaskGraphNode> nodes;
     std::unordered_map<std::string, size_t> nodeMap;
     bool compiled;
     
+    // Compiled plan. Dependents are stored flat, each node's in ascending critical order
+    // so the most critical is pushed last and popped first.
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> roots;
+    std::vector<uint32_t> dependentOffsets;
+    std::vector<uint32_t> dependents;
+    std::vector<uint32_t> dependencyCounts;
+    std::unique_ptr<std::atomic<uint32_t>[]> pendingCounts;
+    
+    // Critical path, in estimated microseconds
+    std::vector<float> costs;
+    std::vector<float> topLevels;       // Longest path from a root to the node's start
+    std::vector<float> bottomLevels;    // Longest path from the node's start to the end
+    std::vector<TaskPriority> runPriorities;
+    float criticalPathMicros;
+    
+    // Last kick
+    std::vector<TaskGraphNodeTiming> timings;
+    std::chrono::steady_clock::time_point kickTime;
+    JobCounter* kickCounter;
+    uint64_t kickCount;
+    
+    void learnCosts();
+    void updateCriticalPath();
+    
 public:
-    TaskGraph() : compiled(false) {}
+    TaskGraph() : compiled(false), criticalPathMicros(0.0f), kickCounter(nullptr), kickCount(0) {}
     
     size_t addNode(const std::string& name, JobFunction func, TaskPriority priority = TaskPriority::Normal) {
         size_t index = nodes.size();
@@ -330,41 +457,15 @@ public:
         }
     }
     
-    // Topological sort to verify no cycles
-    bool compile() {
-        std::vector<int> inDegree(nodes.size(), 0);
-        for (const auto& node : nodes) {
-            for (size_t dep : node.dependencyIndices) {
-                ++inDegree[dep];
-            }
-        }
-        
-        std::queue<size_t> queue;
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            if (inDegree[i] == 0) {
-                queue.push(i);
-            }
-        }
-        
-        size_t processed = 0;
-        while (!queue.empty()) {
-            size_t current = queue.front();
-            queue.pop();
-            ++processed;
-            
-            for (size_t dep : nodes[current].dependentIndices) {
-                if (--inDegree[dep] == 0) {
-                    queue.push(dep);
-                }
-            }
-        }
-        
-        compiled = (processed == nodes.size());
-        return compiled;
-    }
+    // Seed a node's cost before the first kick has measured it
+    void setCostEstimate(size_t nodeIndex, float micros);
+    
+    // Topological sort; builds the plan, or returns false on a cycle
+    bool compile();
     
     bool isCompiled() const { return compiled; }
     const std::vector<TaskGraphNode>& getNodes() const { return nodes; }
+    const std::vector<uint32_t>& getExecutionOrder() const { return order; }
     
     // Get root nodes (no dependencies)
     std::vector<size_t> getRootNodes() const {
@@ -376,12 +477,21 @@ public:
         }
         return roots;
     }
+    
+    // Critical path and timing of the last kick
+    float getCriticalPathMicros() const { return criticalPathMicros; }
+    bool isOnCriticalPath(size_t nodeIndex) const;
+    TaskPriority getRunPriority(size_t nodeIndex) const { return runPriorities[nodeIndex]; }
+    uint64_t getKickCount() const { return kickCount; }
+    const std::vector<TaskGraphNodeTiming>& getTimings() const { return timings; }
+    
+    // Adds the last kick's nodes to the profiler's current frame, one track per thread
+    void exportTimeline(Utils::TimelineProfiler& profiler) const;
 };
 
 // Thread worker data
 struct WorkerThread {
     std::thread thread;
-    std::unique_ptr<ThreadLocalQueue> localQueue;
     std::atomic<bool> running;
     size_t threadIndex;
     std::string name;
@@ -421,217 +531,133 @@ struct WorkerThread {
     }
 };
 
+// Job system configuration
+struct JobSystemConfig {
+    size_t workerCount;         // 0 = one less than the hardware threads
+    
+    // Run jobs on fibers so waiting suspends the job instead of the worker. Needs
+    // ucontext (Linux and BSDs); ignored where isFiberModeSupported() is false.
+    bool useFibers;
+    size_t fiberCount;          // Fixed pool; jobs run inline once all fibers are busy
+    size_t fiberStackSize;      // Bytes per fiber, plus one guard page
+    
+    JobSystemConfig()
+        : workerCount(0)
+        , useFibers(false)
+        , fiberCount(128)
+        , fiberStackSize(64 * 1024)
+    {}
+};
+
 // Main job system
+//
+// Each worker, plus the thread that calls startup(), owns one lock-free work-stealing
+// deque per priority: jobs submitted from those threads are pushed locally and popped
+// LIFO, idle threads steal FIFO from the others. Other threads submit through a small
+// locked queue. Job objects come from a slot pool with per-thread free-slot caches, so
+// submitting allocates nothing once warm. Waiting on a JobCounter or handle runs other
+// jobs instead of blocking.
+//
+// In fiber mode every job runs on a fiber from a fixed pool. A job that waits on an
+// unfinished counter is suspended and its worker moves on; the decrement that finishes
+// the counter queues the fiber to resume on whichever worker is free next. Jobs must not
+// hold locks or rely on thread_local state across a wait, since they may resume on
+// another thread. Fibers of only one system may wait on a given counter at a time, and
+// all waits should be over before shutdown().
 class JobSystem {
-private:
-    std::vector<std::unique_ptr<WorkerThread>> workers;
-    PriorityJobQueue globalQueue;
-    
-    std::unordered_map<JobHandle, std::shared_ptr<Job>> jobs;
-    mutable std::mutex jobsMutex;
-    
-    std::atomic<JobHandle> nextHandle;
-    std::atomic<bool> running;
-    std::atomic<size_t> activeJobs;
-    
-    std::mutex waitMutex;
-    std::condition_variable waitCV;
-    
-    size_t mainThreadIndex;
-    
-    // Thread-local storage
-    static thread_local size_t currentThreadIndex;
-    static thread_local bool isWorkerThread;
+    friend class JobCounter;
     
 public:
-    explicit JobSystem(size_t numWorkers = 0)
-        : nextHandle(1)
-        , running(false)
-        , activeJobs(0)
-        , mainThreadIndex(0)
-    {
-        if (numWorkers == 0) {
-            numWorkers = std::max(1u, std::thread::hardware_concurrency() - 1);
-        }
-        
-        workers.resize(numWorkers);
-        for (size_t i = 0; i < numWorkers; ++i) {
-            workers[i] = std::make_unique<WorkerThread>();
-            workers[i]->localQueue = std::make_unique<ThreadLocalQueue>();
-            workers[i]->threadIndex = i;
-            workers[i]->name = "Worker_" + std::to_string(i);
-        }
-    }
+    explicit JobSystem(size_t numWorkers = 0);
+    explicit JobSystem(const JobSystemConfig& config);
+    ~JobSystem();
     
-    ~JobSystem() {
-        shutdown();
-    }
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
     
-    void startup() {
-        running = true;
-        
-        for (size_t i = 0; i < workers.size(); ++i) {
-            workers[i]->running = true;
-            workers[i]->thread = std::thread(&JobSystem::workerMain, this, i);
-        }
-    }
+    void startup();
+    void shutdown();
     
-    void shutdown() {
-        running = false;
-        globalQueue.notifyAll();
-        
-        for (auto& worker : workers) {
-            worker->running = false;
-            if (worker->thread.joinable()) {
-                worker->thread.join();
-            }
-        }
-    }
-    
-    // Submit a job
-    JobHandle submit(const JobDescriptor& desc) {
-        JobHandle handle = nextHandle++;
-        auto job = std::make_shared<Job>(handle, desc);
-        
-        {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            jobs[handle] = job;
-        }
-        
-        // Check if all dependencies are satisfied
-        if (job->dependencyCount.load() == 0) {
-            scheduleJob(job);
-        }
-        
-        return handle;
-    }
+    // Submit a job with name, dependencies and cancellation support
+    JobHandle submit(const JobDescriptor& desc);
     
     // Submit with lambda
-    template<typename F, typename... Args>
+    template<typename F, typename... Args,
+             typename = std::enable_if_t<!std::is_same<std::decay_t<F>, JobDescriptor>::value>>
     JobHandle submit(F&& func, Args&&... args) {
-        JobDescriptor desc;
-        desc.function = std::bind(std::forward<F>(func), std::forward<Args>(args)...);
-        return submit(desc);
+        return submitWithPriority(std::bind(std::forward<F>(func), std::forward<Args>(args)...),
+                                  TaskPriority::Normal);
     }
     
     // Submit with priority
     template<typename F>
     JobHandle submitWithPriority(F&& func, TaskPriority priority) {
-        JobDescriptor desc;
-        desc.function = std::forward<F>(func);
-        desc.priority = priority;
-        return submit(desc);
+        Job* job = allocateJob();
+        job->function.assign(std::forward<F>(func));
+        job->priority = priority;
+        return launch(job);
     }
     
-    // Submit batch of jobs
-    std::vector<JobHandle> submitBatch(const std::vector<JobDescriptor>& descriptors) {
-        std::vector<JobHandle> handles;
-        handles.reserve(descriptors.size());
-        
-        for (const auto& desc : descriptors) {
-            handles.push_back(submit(desc));
-        }
-        
-        return handles;
+    // Fire-and-forget job tracked by a counter: the counter is incremented now and
+    // decremented when the job finishes. Cheapest way to submit; no handle is returned.
+    template<typename F>
+    void dispatch(F&& func, JobCounter& counter, TaskPriority priority = TaskPriority::Normal) {
+        Job* job = allocateJob();
+        job->function.assign(std::forward<F>(func));
+        job->priority = priority;
+        job->counter = &counter;
+        counter.increment();
+        launch(job);
     }
     
-    // Execute task graph
-    std::vector<JobHandle> execute(TaskGraph& graph) {
-        if (!graph.isCompiled() && !graph.compile()) {
-            return {};
-        }
-        
-        std::vector<JobHandle> handles;
-        const auto& nodes = graph.getNodes();
-        handles.resize(nodes.size());
-        
-        // Create jobs for all nodes
-        for (size_t i = 0; i < nodes.size(); ++i) {
-            JobDescriptor desc;
-            desc.name = nodes[i].name;
-            desc.function = nodes[i].function;
-            desc.priority = nodes[i].priority;
-            
-            // Convert dependency indices to handles
-            for (size_t depIdx : nodes[i].dependencyIndices) {
-                if (depIdx < handles.size() && handles[depIdx] != 0) {
-                    desc.dependencies.push_back(handles[depIdx]);
-                }
-            }
-            
-            handles[i] = submit(desc);
-        }
-        
-        return handles;
-    }
+    // Submit batch of jobs
+    std::vector<JobHandle> submitBatch(const std::vector<JobDescriptor>& descriptors);
     
-    // Wait for specific job
-    void wait(JobHandle handle) {
-        std::shared_ptr<Job> job;
-        {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            auto it = jobs.find(handle);
-            if (it == jobs.end()) return;
-            job = it->second;
-        }
-        
-        // Help process jobs while waiting
-        while (!job->isComplete()) {
-            if (!processOneJob()) {
-                std::this_thread::yield();
-            }
-        }
-    }
+    // Execute task graph
+    std::vector<JobHandle> execute(TaskGraph& graph);
     
-    // Wait for multiple jobs
-    void waitAll(const std::vector<JobHandle>& handles) {
-        for (JobHandle h : handles) {
-            wait(h);
-        }
-    }
+    // Run a task graph's compiled plan, compiling first if needed; wait on the counter
+    // for it to finish. Allocates nothing once the job pool is warm. Returns false if the
+    // graph has a cycle.
+    bool kick(TaskGraph& graph, JobCounter& counter);
     
-    // Wait for all jobs to complete
-    void waitIdle() {
-        while (activeJobs.load() > 0 || !globalQueue.empty()) {
-            if (!processOneJob()) {
-                std::this_thread::yield();
-            }
-        }
-    }
+    // Waiting runs other jobs on the calling thread until the target completes
+    void wait(JobHandle handle);
+    void waitAll(const std::vector<JobHandle>& handles);
+    // Rethrows the first exception thrown by a job dispatched on the counter
+    void wait(JobCounter& counter);
+    void waitIdle();
     
     // Process jobs on calling thread
-    bool processOneJob() {
-        auto job = tryGetJob();
-        if (job) {
-            executeJob(job);
-            return true;
-        }
-        return false;
-    }
+    bool processOneJob();
     
-    // Cancel a job
-    bool cancel(JobHandle handle) {
-        std::lock_guard<std::mutex> lock(jobsMutex);
-        auto it = jobs.find(handle);
-        if (it != jobs.end() && it->second->descriptor.canBeCancelled) {
-            auto expected = JobStatus::Pending;
-            if (it->second->status.compare_exchange_strong(expected, JobStatus::Cancelled)) {
-                it->second->completionCV.notify_all();
-                return true;
-            }
-        }
-        return false;
-    }
+    // Cancel a job that has not started
+    bool cancel(JobHandle handle);
     
-    // Get job status
-    JobStatus getJobStatus(JobHandle handle) const {
-        std::lock_guard<std::mutex> lock(jobsMutex);
-        auto it = jobs.find(handle);
-        if (it != jobs.end()) {
-            return it->second->getStatus();
-        }
-        return JobStatus::Completed;  // Assume completed if not found
-    }
+    // Unknown or recycled handles report Completed
+    JobStatus getJobStatus(JobHandle handle) const;
+    
+    // Per-job timing (Job::getExecutionTime() and worker execution time); off by default
+    // because two clock reads cost more than a tiny job
+    void setProfilingEnabled(bool enabled) { profilingEnabled = enabled; }
+    bool isProfilingEnabled() const { return profilingEnabled; }
+    
+    size_t getWorkerCount() const { return workers.size(); }
+    size_t getPooledJobCount() const;
+    
+    // Fibers
+    static bool isFiberModeSupported();
+    bool isUsingFibers() const { return !fibers.empty(); }
+    
+    struct FiberStats {
+        size_t fiberCount;
+        size_t freeFibers;
+        size_t readyFibers;         // Waits finished, not yet resumed
+        uint64_t suspensions;       // Waits that suspended a fiber
+        uint64_t inlineJobs;        // Jobs run without a fiber because the pool was empty
+    };
+    
+    FiberStats getFiberStats() const;
     
     // Performance metrics
     struct WorkerStats {
@@ -648,25 +674,7 @@ public:
         double avgJobTimeMicros;
     };
     
-    std::vector<WorkerStats> getWorkerStats() const {
-        std::vector<WorkerStats> stats;
-        for (const auto& worker : workers) {
-            WorkerStats ws;
-            ws.threadIndex = worker->threadIndex;
-            ws.name = worker->name;
-            ws.jobsExecuted = worker->jobsExecuted.load();
-            ws.jobsStolen = worker->jobsStolen.load();
-            ws.totalExecutionTimeMicros = worker->totalExecutionTimeMicros.load();
-            ws.idleTimeMicros = worker->idleTimeMicros.load();
-            ws.stealAttempts = worker->stealAttempts.load();
-            ws.successfulSteals = worker->successfulSteals.load();
-            ws.localQueueSize = worker->localQueue->size();
-            ws.efficiency = worker->getEfficiency();
-            ws.avgJobTimeMicros = worker->getAverageJobTime();
-            stats.push_back(ws);
-        }
-        return stats;
-    }
+    std::vector<WorkerStats> getWorkerStats() const;
     
     // Get aggregated system metrics
     struct SystemMetrics {
@@ -680,175 +688,91 @@ public:
         size_t queuedJobs;
     };
     
-    SystemMetrics getSystemMetrics() const {
-        SystemMetrics metrics{};
-        
-        for (const auto& worker : workers) {
-            metrics.totalJobsExecuted += worker->jobsExecuted.load();
-            metrics.totalJobsStolen += worker->jobsStolen.load();
-            metrics.totalExecutionTimeMicros += worker->totalExecutionTimeMicros.load();
-            metrics.totalIdleTimeMicros += worker->idleTimeMicros.load();
-            metrics.averageEfficiency += worker->getEfficiency();
-            
-            uint64_t attempts = worker->stealAttempts.load();
-            uint64_t successes = worker->successfulSteals.load();
-            if (attempts > 0) {
-                metrics.stealSuccessRate += static_cast<double>(successes) / attempts;
-            }
-        }
-        
-        if (!workers.empty()) {
-            metrics.averageEfficiency /= workers.size();
-            metrics.stealSuccessRate /= workers.size();
-        }
-        
-        metrics.activeJobs = activeJobs.load();
-        metrics.queuedJobs = globalQueue.size();
-        
-        return metrics;
-    }
+    SystemMetrics getSystemMetrics() const;
     
 private:
-    void workerMain(size_t threadIndex) {
-        currentThreadIndex = threadIndex;
-        isWorkerThread = true;
-        
-        auto& worker = *workers[threadIndex];
-        
-        while (worker.running.load()) {
-            // Try local queue first
-            auto job = worker.localQueue->pop();
-            
-            // Try global queue
-            if (!job) {
-                job = globalQueue.tryPop();
-            }
-            
-            // Try stealing from other workers
-            if (!job) {
-                job = tryStealJob(threadIndex);
-                if (job) {
-                    ++worker.jobsStolen;
-                }
-            }
-            
-            if (job) {
-                executeJob(job);
-                ++worker.jobsExecuted;
-            } else {
-                // Wait for work
-                job = globalQueue.pop();
-                if (job) {
-                    executeJob(job);
-                    ++worker.jobsExecuted;
-                }
-            }
-        }
-    }
+    static constexpr size_t NUM_PRIORITIES = static_cast<size_t>(TaskPriority::Count);
+    static constexpr size_t JOBS_PER_BLOCK = 1024;
+    static constexpr size_t MAX_JOB_BLOCKS = 4096;
     
-    void scheduleJob(std::shared_ptr<Job> job) {
-        job->status = JobStatus::Queued;
-        
-        if (isWorkerThread && currentThreadIndex < workers.size()) {
-            // Push to local queue for better cache locality
-            workers[currentThreadIndex]->localQueue->push(job);
-        } else {
-            globalQueue.push(job);
-        }
-    }
+    // Queues and free-slot cache of one worker or of the startup thread
+    struct ThreadContext;
+    struct Fiber;
+    struct GraphNodeJob;
     
-    void executeJob(std::shared_ptr<Job> job) {
-        ++activeJobs;
-        
-        job->status = JobStatus::Running;
-        job->startTime = std::chrono::high_resolution_clock::now();
-        
-        try {
-            job->descriptor.function();
-            job->status = JobStatus::Completed;
-        } catch (...) {
-            job->exception = std::current_exception();
-            job->status = JobStatus::Failed;
-        }
-        
-        job->endTime = std::chrono::high_resolution_clock::now();
-        
-        // Track execution time
-        if (isWorkerThread && currentThreadIndex < workers.size()) {
-            workers[currentThreadIndex]->totalExecutionTimeMicros += 
-                job->getExecutionTime().count();
-        }
-        
-        // Notify completion
-        {
-            std::lock_guard<std::mutex> lock(job->mutex);
-            job->completionCV.notify_all();
-        }
-        
-        // Signal dependents
-        signalDependents(job->handle);
-        
-        --activeJobs;
-        
-        {
-            std::lock_guard<std::mutex> lock(waitMutex);
-            waitCV.notify_all();
-        }
-    }
+    uint64_t instanceId;
+    std::vector<std::unique_ptr<WorkerThread>> workers;
+    std::vector<std::unique_ptr<ThreadContext>> contexts;  // workers, then startup thread
     
-    void signalDependents(JobHandle handle) {
-        std::shared_ptr<Job> completedJob;
-        {
-            std::lock_guard<std::mutex> lock(jobsMutex);
-            auto it = jobs.find(handle);
-            if (it == jobs.end()) return;
-            completedJob = it->second;
-        }
-        
-        for (JobHandle depHandle : completedJob->dependents) {
-            std::shared_ptr<Job> dependent;
-            {
-                std::lock_guard<std::mutex> lock(jobsMutex);
-                auto it = jobs.find(depHandle);
-                if (it == jobs.end()) continue;
-                dependent = it->second;
-            }
-            
-            if (--dependent->dependencyCount == 0) {
-                scheduleJob(dependent);
-            }
-        }
-    }
+    // Submissions from threads without a context
+    std::array<std::deque<Job*>, NUM_PRIORITIES> injected;
+    std::atomic<size_t> injectedCount;
+    std::mutex injectMutex;
     
-    std::shared_ptr<Job> tryGetJob() {
-        if (isWorkerThread && currentThreadIndex < workers.size()) {
-            auto job = workers[currentThreadIndex]->localQueue->pop();
-            if (job) return job;
-        }
-        
-        return globalQueue.tryPop();
-    }
+    // Job slot pool; blocks are never freed before the system is destroyed
+    std::unique_ptr<std::atomic<Job*>[]> jobBlocks;
+    std::atomic<size_t> jobBlockCount;
+    std::vector<uint32_t> freeSlots;
+    mutable std::mutex poolMutex;
     
-    std::shared_ptr<Job> tryStealJob(size_t thiefIndex) {
-        size_t numWorkers = workers.size();
-        size_t startIndex = (thiefIndex + 1) % numWorkers;
-        
-        for (size_t i = 0; i < numWorkers; ++i) {
-            size_t victimIndex = (startIndex + i) % numWorkers;
-            if (victimIndex != thiefIndex) {
-                auto job = workers[victimIndex]->localQueue->steal();
-                if (job) return job;
-            }
-        }
-        
-        return nullptr;
-    }
+    std::atomic<bool> running;
+    std::atomic<size_t> pendingJobs;    // Submitted and not yet finished
+    bool profilingEnabled;
+    
+    // Fiber pool; ready fibers finished waiting, yielded ones poll and run after new jobs
+    std::vector<std::unique_ptr<Fiber>> fibers;
+    std::vector<Fiber*> freeFibers;
+    std::deque<Fiber*> readyFibers;
+    std::deque<Fiber*> yieldedFibers;
+    std::atomic<size_t> readyFiberCount;
+    std::atomic<size_t> yieldedFiberCount;
+    std::atomic<uint64_t> fiberSuspensions;
+    std::atomic<uint64_t> inlineJobs;
+    mutable std::mutex fiberMutex;
+    
+    // Idle workers sleep until a submit bumps wakeEpoch
+    std::atomic<int> sleepingWorkers;
+    std::atomic<uint64_t> wakeEpoch;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCV;
+    
+    ThreadContext* currentContext() const;
+    Job* lookupJob(JobHandle handle) const;
+    Job* allocateJob();
+    void releaseJob(Job* job);
+    void growPool();
+    JobHandle launch(Job* job);
+    void scheduleJob(Job* job);
+    void wakeWorkers();
+    Job* findJob(ThreadContext* context);
+    bool runOne(ThreadContext* context, bool chainJobs);
+    void startJob(Job* job, ThreadContext* context, bool chainJobs);
+    void executeJob(Job* job, ThreadContext* context);
+    void finishJob(Job* job);
+    void workerMain(size_t threadIndex);
+    
+    void runGraphNode(TaskGraph& graph, uint32_t node);
+    
+    // Waiting without rethrowing; suspends when called on one of this system's fibers
+    void waitForCounter(JobCounter& counter);
+    
+    // Fiber scheduling
+    void createFibers(size_t count, size_t stackSize);
+    static void initFiberContext(Fiber* fiber);
+    Fiber* acquireFiber();
+    Fiber* takeResumableFiber(bool includeYielded);
+    void resumeFiber(Fiber* fiber, bool chainJobs);
+    void suspendFiber(Fiber* fiber);
+    void registerWaiter(Fiber* fiber);
+    void makeFiberReady(Fiber* fiber);
+    void fiberMain(Fiber* fiber);
+    static void fiberEntry(unsigned int high, unsigned int low);
+    
+    // JobCounter hooks
+    static void waitOnCallingThread(JobCounter& counter);
+    static void resumeWaiter(JobSystem* system, uint32_t fiberIndex);
 };
 
-// Static member initialization
-inline thread_local size_t JobSystem::currentThreadIndex = 0;
-inline thread_local bool JobSystem::isWorkerThread = false;
-
 // Parallel for helper
 class ParallelFor {
 public:
@@ -857,23 +781,16 @@ public:
         if (count == 0) return;
         
         size_t numBatches = (count + batchSize - 1) / batchSize;
-        std::vector<JobHandle> handles;
-        handles.reserve(numBatches);
+        JobCounter counter;
         
         for (size_t batch = 0; batch < numBatches; ++batch) {
             size_t start = batch * batchSize;
             size_t end = std::min(start + batchSize, count);
             
-            JobDescriptor desc;
-            desc.priority = priority;
-            desc.function = [func, start, end]() {
-                func(start, end);
-            };
-            
-            handles.push_back(jobSystem.submit(desc));
+            jobSystem.dispatch([&func, start, end]() { func(start, end); }, counter, priority);
         }
         
-        jobSystem.waitAll(handles);
+        jobSystem.wait(counter);
     }
     
     template<typename Iterator, typename Func>
@@ -1,7 +1,10 @@
 #include "ai/AIVisionSystem.h"
+#include "threading/ThreadPool.h"
+#include <chrono>
 #include <cmath>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 namespace JJM {
 namespace AI {
@@ -24,10 +27,22 @@ static void normalize(float v[3]) {
     }
 }
 
+static bool samePosition(const float a[3], const float b[3]) {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+
+static bool entityLess(const Entity* a, const Entity* b) {
+    return std::less<const Entity*>()(a, b);
+}
+
 // AIVisionSystem implementation
 AIVisionSystem::AIVisionSystem(Entity* owner)
-    : m_owner(owner), m_ambientLight(1.0f), m_fogDensity(0.0f),
+    : m_owner(owner), m_manager(nullptr), m_ambientLight(1.0f), m_fogDensity(0.0f),
       m_debugVisualization(false) {
+    m_position[0] = m_position[1] = m_position[2] = 0;
+    m_forward[0] = 0;
+    m_forward[1] = 0;
+    m_forward[2] = 1;
     
     // Enable sight by default
     m_enabledSenses[VisionSense::SIGHT] = true;
@@ -38,16 +53,72 @@ AIVisionSystem::AIVisionSystem(Entity* owner)
 }
 
 AIVisionSystem::~AIVisionSystem() {
+    if (m_manager) {
+        m_manager->unregisterVisionSystem(this);
+    }
+}
+
+void AIVisionSystem::setTransform(const float position[3], const float forward[3]) {
+    m_position[0] = position[0];
+    m_position[1] = position[1];
+    m_position[2] = position[2];
+    m_forward[0] = forward[0];
+    m_forward[1] = forward[1];
+    m_forward[2] = forward[2];
+    normalize(m_forward);
 }
 
 void AIVisionSystem::update(float deltaTime) {
-    // Scan for new targets
     scanForTargets();
-    
-    // Update existing targets
-    for (auto& target : m_visibleTargets) {
+    applySightings(deltaTime);
+}
+
+void AIVisionSystem::applySightings(float deltaTime) {
+    // Both lists are sorted by entity, so one merge matches sightings to known targets
+    std::vector<VisionTarget> merged;
+    std::vector<Entity*> spotted;
+    merged.reserve(m_visibleTargets.size() + m_sightings.size());
+    size_t known = 0;
+    for (const VisionSighting& sighting : m_sightings) {
+        while (known < m_visibleTargets.size() &&
+               entityLess(m_visibleTargets[known].entity, sighting.entity)) {
+            // Left the cone since the last pass
+            merged.push_back(m_visibleTargets[known++]);
+            merged.back().isInFieldOfView = false;
+            merged.back().visibility = VisibilityLevel::INVISIBLE;
+        }
+        const bool isKnown = known < m_visibleTargets.size() &&
+                             m_visibleTargets[known].entity == sighting.entity;
+        if (!isKnown && sighting.isOccluded) continue;
+        
+        if (isKnown) {
+            merged.push_back(m_visibleTargets[known++]);
+        } else {
+            merged.emplace_back();
+            merged.back().entity = sighting.entity;
+            std::copy(sighting.position, sighting.position + 3, merged.back().lastSeenPosition);
+        }
+        VisionTarget& target = merged.back();
+        std::copy(sighting.position, sighting.position + 3, target.position);
+        target.distance = sighting.distance;
+        target.angleFromForward = sighting.angleFromForward;
+        target.isInFieldOfView = true;
+        target.isOccluded = sighting.isOccluded;
         updateTarget(target, deltaTime);
+        
+        if (!isKnown && target.visibility != VisibilityLevel::INVISIBLE) {
+            target.sightingCount = 1;
+            spotted.push_back(target.entity);
+        } else if (!isKnown) {
+            merged.pop_back();
+        }
     }
+    for (; known < m_visibleTargets.size(); ++known) {
+        merged.push_back(m_visibleTargets[known]);
+        merged.back().isInFieldOfView = false;
+        merged.back().visibility = VisibilityLevel::INVISIBLE;
+    }
+    m_visibleTargets.swap(merged);
     
     // Remove targets that are no longer visible
     m_visibleTargets.erase(
@@ -78,6 +149,15 @@ void AIVisionSystem::update(float deltaTime) {
         m_visibleTargets.end()
     );
     
+    for (Entity* entity : spotted) {
+        if (!m_visualMemory.empty()) {
+            forgetEntity(entity);
+        }
+        if (m_onTargetSpotted) {
+            m_onTargetSpotted(getTarget(entity));
+        }
+    }
+    
     // Update memory
     updateVisualMemory(deltaTime);
     
@@ -88,9 +168,12 @@ void AIVisionSystem::update(float deltaTime) {
 }
 
 void AIVisionSystem::scanForTargets() {
-    // Get nearby entities from vision manager
-    // For now, this is a stub
-    // AIVisionManager would provide potential targets
+    // Standalone update; registered systems are normally sensed in the manager's batched pass
+    if (m_manager) {
+        m_manager->senseSystem(*this);
+    } else {
+        m_sightings.clear();
+    }
 }
 
 bool AIVisionSystem::isInFieldOfView(const float targetPos[3], bool usePeripheral) const {
@@ -108,40 +191,36 @@ bool AIVisionSystem::isInFieldOfView(const float targetPos[3], bool usePeriphera
     getForwardDirection(forward);
     
     float dot = dotProduct(forward, toTarget);
-    float angle = std::acos(dot) * 180.0f / 3.14159f;
+    float angle = std::acos(std::max(-1.0f, std::min(1.0f, dot))) * 180.0f / 3.14159f;
     
     float fov = usePeripheral ? m_config.peripheralFOV : m_config.fieldOfView;
     return angle <= fov * 0.5f;
 }
 
-float AIVisionSystem::calculateVisibilityScore(const float targetPos[3], Entity* target) {
+float AIVisionSystem::calculateVisibilityScore(const VisionTarget& target) const {
     float score = 1.0f;
     
     // Distance factor
-    float distance = getDistanceTo(targetPos);
+    float distance = target.distance;
     if (distance > m_config.viewDistance) return 0.0f;
     float distanceFactor = 1.0f - (distance / m_config.viewDistance);
     score *= distanceFactor;
     
     // Angle factor (center of vision = 1.0, edge = 0.0)
-    float angle = getAngleToTarget(targetPos);
+    float angle = target.angleFromForward;
     float angleFactor = 1.0f - (angle / (m_config.fieldOfView * 0.5f));
     score *= std::max(0.0f, angleFactor);
     
     // Lighting factor
-    float lightFactor = calculateLightingFactor(targetPos);
+    float lightFactor = calculateLightingFactor(target.position);
     score *= lightFactor;
     
     // Size factor (larger = easier to see)
-    float sizeFactor = calculateSizeFactor(target, distance);
+    float sizeFactor = calculateSizeFactor(target.entity, distance);
     score *= sizeFactor;
     
     // Motion factor (moving = easier to spot)
-    VisionTarget* existingTarget = const_cast<AIVisionSystem*>(this)->getTarget(target);
-    if (existingTarget) {
-        float motionFactor = calculateMotionFactor(*existingTarget);
-        score *= motionFactor;
-    }
+    score *= calculateMotionFactor(target);
     
     // Fog factor
     if (m_fogDensity > 0.0f) {
@@ -158,9 +237,12 @@ OcclusionTest AIVisionSystem::performOcclusionTest(const float targetPos[3]) con
     result.coveragePercent = 0.0f;
     result.nearestOccluderDistance = 1000000.0f;
     
-    // TODO: Implement raycast occlusion test
-    // This would ray trace from eye position to target
-    // and check for blocking geometry
+    // Occluders live in the manager's shared index
+    if (m_manager) {
+        float eyePos[3];
+        getEyePosition(eyePos);
+        m_manager->raycast(eyePos, targetPos, &result);
+    }
     
     return result;
 }
@@ -185,32 +267,20 @@ void AIVisionSystem::updateVisualMemory(float deltaTime) {
 }
 
 void AIVisionSystem::updateTarget(VisionTarget& target, float deltaTime) {
-    // Update position
-    // target.position would be updated from entity's current position
+    // Position, distance, angle and occlusion come from the vision pass
     
     // Update velocity
-    float dx = target.position[0] - target.lastSeenPosition[0];
-    float dy = target.position[1] - target.lastSeenPosition[1];
-    float dz = target.position[2] - target.lastSeenPosition[2];
-    
-    target.velocity[0] = dx / deltaTime;
-    target.velocity[1] = dy / deltaTime;
-    target.velocity[2] = dz / deltaTime;
+    if (deltaTime > 0.0f) {
+        target.velocity[0] = (target.position[0] - target.lastSeenPosition[0]) / deltaTime;
+        target.velocity[1] = (target.position[1] - target.lastSeenPosition[1]) / deltaTime;
+        target.velocity[2] = (target.position[2] - target.lastSeenPosition[2]) / deltaTime;
+    }
     
     target.movementSpeed = vectorLength(target.velocity);
     target.isMoving = target.movementSpeed > 0.1f;
     
     // Recalculate visibility
-    target.visibilityScore = calculateVisibilityScore(target.position, target.entity);
-    
-    // Update distance and angle
-    target.distance = getDistanceTo(target.position);
-    target.angleFromForward = getAngleToTarget(target.position);
-    target.isInFieldOfView = isInFieldOfView(target.position, false);
-    
-    // Occlusion test
-    OcclusionTest occlusionTest = performOcclusionTest(target.position);
-    target.isOccluded = occlusionTest.isOccluded;
+    target.visibilityScore = calculateVisibilityScore(target);
     
     // Determine visibility level
     if (target.isOccluded || target.visibilityScore < 0.1f) {
@@ -234,21 +304,16 @@ void AIVisionSystem::updateTarget(VisionTarget& target, float deltaTime) {
 }
 
 VisionTarget* AIVisionSystem::getTarget(Entity* entity) {
-    for (auto& target : m_visibleTargets) {
-        if (target.entity == entity) {
-            return &target;
-        }
-    }
-    return nullptr;
+    auto it = std::lower_bound(m_visibleTargets.begin(), m_visibleTargets.end(), entity,
+                               [](const VisionTarget& target, const Entity* e) {
+                                   return entityLess(target.entity, e);
+                               });
+    return it != m_visibleTargets.end() && it->entity == entity ? &*it : nullptr;
 }
 
 bool AIVisionSystem::canSee(Entity* entity) const {
-    for (const auto& target : m_visibleTargets) {
-        if (target.entity == entity && target.visibility != VisibilityLevel::INVISIBLE) {
-            return true;
-        }
-    }
-    return false;
+    const VisionTarget* target = const_cast<AIVisionSystem*>(this)->getTarget(entity);
+    return target && target->visibility != VisibilityLevel::INVISIBLE;
 }
 
 bool AIVisionSystem::canSee(const float position[3]) const {
@@ -257,8 +322,7 @@ bool AIVisionSystem::canSee(const float position[3]) const {
     float distance = getDistanceTo(position);
     if (distance > m_config.viewDistance) return false;
     
-    // Would also check occlusion
-    return true;
+    return !performOcclusionTest(position).isOccluded;
 }
 
 std::vector<VisionTarget*> AIVisionSystem::getTargetsInFOV() {
@@ -377,19 +441,15 @@ float AIVisionSystem::getAngleToTarget(const float targetPos[3]) const {
 }
 
 void AIVisionSystem::getEyePosition(float outPos[3]) const {
-    // Get owner position and add eye height
-    // outPos[0] = ownerPos[0];
-    // outPos[1] = ownerPos[1] + m_config.eyeHeight;
-    // outPos[2] = ownerPos[2];
-    outPos[0] = outPos[1] = outPos[2] = 0;  // Stub
+    outPos[0] = m_position[0];
+    outPos[1] = m_position[1] + m_config.eyeHeight;
+    outPos[2] = m_position[2];
 }
 
 void AIVisionSystem::getForwardDirection(float outDir[3]) const {
-    // Get owner's forward direction
-    // This would come from the entity's transform
-    outDir[0] = 0;
-    outDir[1] = 0;
-    outDir[2] = 1;  // Stub: facing +Z
+    outDir[0] = m_forward[0];
+    outDir[1] = m_forward[1];
+    outDir[2] = m_forward[2];
 }
 
 float AIVisionSystem::calculateLightingFactor(const float pos[3]) const {
@@ -425,62 +485,275 @@ float AIVisionSystem::calculateContrastFactor(Entity* target) const {
 }
 
 // AIVisionManager implementation
+namespace {
+
+uint32_t cellHash(int32_t x, int32_t z, uint32_t mask) {
+    const uint32_t hash = static_cast<uint32_t>(x) * 73856093u ^
+                          static_cast<uint32_t>(z) * 83492791u;
+    return hash & mask;
+}
+
+uint32_t tableSizeFor(size_t entries) {
+    // Hashed cells keep the table O(n) however spread out the contents are
+    uint32_t tableSize = 64;
+    while (tableSize < entries * 2) tableSize *= 2;
+    return tableSize;
+}
+
+// Turns per-cell counts in cellStart into offsets, scatters, then shifts the starts back
+template <typename ForEachEntry>
+void fillCells(std::vector<uint32_t>& cellStart, std::vector<uint32_t>& items,
+               size_t entryCount, ForEachEntry forEachEntry) {
+    const size_t tableSize = cellStart.size() - 1;
+    uint32_t offset = 0;
+    for (size_t cell = 0; cell <= tableSize; ++cell) {
+        const uint32_t cellCount = cellStart[cell];
+        cellStart[cell] = offset;
+        offset += cellCount;
+    }
+    items.resize(entryCount);
+    forEachEntry([&](uint32_t cell, uint32_t item) { items[cellStart[cell]++] = item; });
+    for (size_t cell = tableSize; cell > 0; --cell) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+    cellStart[0] = 0;
+}
+
+// Entry and exit of the segment from + t * delta, t in [0, 1], through a box
+bool segmentBox(const float from[3], const float delta[3], const float minCorner[3],
+                const float maxCorner[3], float& tEnter) {
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::fabs(delta[axis]) < 1e-8f) {
+            if (from[axis] < minCorner[axis] || from[axis] > maxCorner[axis]) return false;
+            continue;
+        }
+        const float inverse = 1.0f / delta[axis];
+        float tNear = (minCorner[axis] - from[axis]) * inverse;
+        float tFar = (maxCorner[axis] - from[axis]) * inverse;
+        if (tNear > tFar) std::swap(tNear, tFar);
+        t0 = std::max(t0, tNear);
+        t1 = std::min(t1, tFar);
+        if (t0 > t1) return false;
+    }
+    tEnter = t0;
+    return true;
+}
+
+}  // namespace
+
 AIVisionManager::AIVisionManager()
     : m_useSpacialPartitioning(true), m_sectorSize(50.0f),
+      m_targetGridDirty(true), m_occluderCellSize(8.0f), m_staticRevision(1),
+      m_staticOccludersDirty(true), m_dynamicOccludersDirty(true),
       m_globalLightLevel(1.0f), m_globalFogDensity(0.0f),
       m_updateBudgetMs(5.0f), m_maxUpdatesPerFrame(10),
-      m_currentUpdateIndex(0) {
+      m_currentUpdateIndex(0), m_jobSystem(nullptr) {
     m_stats = Stats();
 }
 
 AIVisionManager::~AIVisionManager() {
+    for (AIVisionSystem* system : m_visionSystems) {
+        system->m_manager = nullptr;
+    }
 }
 
 void AIVisionManager::update(float deltaTime) {
-    // Update spatial partitioning
-    if (m_useSpacialPartitioning) {
-        updateSpatialPartitioning();
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const size_t systemCount = m_visionSystems.size();
+    for (ObserverState& state : m_observerStates) {
+        state.pendingTime += deltaTime;
     }
     
-    // Update vision systems (time-sliced)
-    int updatesThisFrame = 0;
-    int systemCount = static_cast<int>(m_visionSystems.size());
+    m_stats.totalVisionSystems = static_cast<int>(systemCount);
+    m_stats.totalTargets = static_cast<int>(m_targets.size());
+    m_stats.totalVisibilityTests = 0;
+    m_stats.totalOcclusionTests = 0;
+    m_stats.lineOfSightCacheHits = 0;
+    m_stats.targetsVisible = 0;
+    if (systemCount == 0) return;
+    
+    refreshTargets();
+    refreshOccluders();
     
-    if (systemCount > 0) {
-        while (updatesThisFrame < m_maxUpdatesPerFrame && updatesThisFrame < systemCount) {
-            int index = m_currentUpdateIndex % systemCount;
-            m_visionSystems[index]->update(deltaTime);
-            
-            m_currentUpdateIndex++;
-            updatesThisFrame++;
+    // This update's slice of observers, round robin
+    size_t sliceSize = systemCount;
+    if (m_maxUpdatesPerFrame > 0) {
+        sliceSize = std::min(systemCount, static_cast<size_t>(m_maxUpdatesPerFrame));
+    }
+    m_slice.clear();
+    for (size_t i = 0; i < sliceSize; ++i) {
+        m_slice.push_back((m_currentUpdateIndex + i) % systemCount);
+    }
+    m_currentUpdateIndex = static_cast<int>((m_currentUpdateIndex + sliceSize) % systemCount);
+    
+    // Observers only write their own sightings and cache, so they sense independently
+    if (!m_jobSystem || sliceSize < OBSERVERS_PER_JOB * 2) {
+        for (size_t index : m_slice) {
+            senseObserver(*m_visionSystems[index], m_observerStates[index]);
+        }
+    } else {
+        const size_t jobCount = (sliceSize + OBSERVERS_PER_JOB - 1) / OBSERVERS_PER_JOB;
+        Threading::JobCounter counter;
+        for (size_t job = 0; job < jobCount; ++job) {
+            m_jobSystem->dispatch(
+                [this, job, sliceSize]() {
+                    const size_t begin = job * OBSERVERS_PER_JOB;
+                    const size_t end = std::min(begin + OBSERVERS_PER_JOB, sliceSize);
+                    for (size_t i = begin; i < end; ++i) {
+                        const size_t index = m_slice[i];
+                        senseObserver(*m_visionSystems[index], m_observerStates[index]);
+                    }
+                },
+                counter);
         }
+        m_jobSystem->wait(counter);
     }
     
-    // Update stats
-    m_stats.totalVisionSystems = systemCount;
-    m_stats.totalTargets = static_cast<int>(m_targets.size());
+    // Applied here so spotted/lost callbacks run on the caller
+    for (size_t index : m_slice) {
+        ObserverState& state = m_observerStates[index];
+        m_visionSystems[index]->applySightings(state.pendingTime);
+        state.pendingTime = 0.0f;
+        
+        m_stats.totalVisibilityTests += state.visibilityTests;
+        m_stats.totalOcclusionTests += state.occlusionTests;
+        m_stats.lineOfSightCacheHits += state.cacheHits;
+        m_stats.targetsVisible += static_cast<int>(
+            m_visionSystems[index]->getVisibleTargets().size());
+    }
+    
+    const float elapsedMs = std::chrono::duration<float, std::milli>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+    m_stats.averageUpdateTime = m_stats.averageUpdateTime * 0.9f + elapsedMs * 0.1f;
 }
 
 void AIVisionManager::registerVisionSystem(AIVisionSystem* system) {
+    if (system->m_manager == this) return;
+    if (system->m_manager) {
+        system->m_manager->unregisterVisionSystem(system);
+    }
+    system->m_manager = this;
     m_visionSystems.push_back(system);
+    m_observerStates.emplace_back();
 }
 
 void AIVisionManager::unregisterVisionSystem(AIVisionSystem* system) {
-    m_visionSystems.erase(
-        std::remove(m_visionSystems.begin(), m_visionSystems.end(), system),
-        m_visionSystems.end()
-    );
+    auto it = std::find(m_visionSystems.begin(), m_visionSystems.end(), system);
+    if (it == m_visionSystems.end()) return;
+    
+    m_observerStates.erase(m_observerStates.begin() + (it - m_visionSystems.begin()));
+    m_visionSystems.erase(it);
+    system->m_manager = nullptr;
 }
 
 void AIVisionManager::registerTarget(Entity* entity) {
+    if (m_targetIndex.count(entity)) return;
+    
+    m_targetIndex[entity] = m_targets.size();
     m_targets.push_back(entity);
+    m_targetPositions.insert(m_targetPositions.end(), {0.0f, 0.0f, 0.0f});
+    m_targetGridDirty = true;
 }
 
 void AIVisionManager::unregisterTarget(Entity* entity) {
-    m_targets.erase(
-        std::remove(m_targets.begin(), m_targets.end(), entity),
-        m_targets.end()
-    );
+    auto it = m_targetIndex.find(entity);
+    if (it == m_targetIndex.end()) return;
+    
+    // Swap with the last target so the arrays stay dense
+    const size_t index = it->second;
+    const size_t last = m_targets.size() - 1;
+    m_targetIndex.erase(it);
+    if (index != last) {
+        m_targets[index] = m_targets[last];
+        std::copy(&m_targetPositions[last * 3], &m_targetPositions[last * 3] + 3,
+                  &m_targetPositions[index * 3]);
+        m_targetIndex[m_targets[index]] = index;
+    }
+    m_targets.pop_back();
+    m_targetPositions.resize(last * 3);
+    m_targetGridDirty = true;
+}
+
+void AIVisionManager::setTargetPosition(Entity* entity, const float position[3]) {
+    auto it = m_targetIndex.find(entity);
+    if (it == m_targetIndex.end()) return;
+    std::copy(position, position + 3, &m_targetPositions[it->second * 3]);
+    m_targetGridDirty = true;
+}
+
+int AIVisionManager::addOccluder(const float minCorner[3], const float maxCorner[3],
+                                 bool isStatic) {
+    int occluderId;
+    if (!m_freeOccluders.empty()) {
+        occluderId = m_freeOccluders.back();
+        m_freeOccluders.pop_back();
+    } else {
+        occluderId = static_cast<int>(m_occluders.size());
+        m_occluders.emplace_back();
+    }
+    Occluder& occluder = m_occluders[occluderId];
+    occluder.isStatic = isStatic;
+    occluder.active = true;
+    for (int axis = 0; axis < 3; ++axis) {
+        occluder.minCorner[axis] = std::min(minCorner[axis], maxCorner[axis]);
+        occluder.maxCorner[axis] = std::max(minCorner[axis], maxCorner[axis]);
+    }
+    (isStatic ? m_staticOccludersDirty : m_dynamicOccludersDirty) = true;
+    return occluderId;
+}
+
+void AIVisionManager::moveOccluder(int occluderId, const float minCorner[3],
+                                   const float maxCorner[3]) {
+    if (occluderId < 0 || occluderId >= static_cast<int>(m_occluders.size()) ||
+        !m_occluders[occluderId].active) {
+        return;
+    }
+    Occluder& occluder = m_occluders[occluderId];
+    for (int axis = 0; axis < 3; ++axis) {
+        occluder.minCorner[axis] = std::min(minCorner[axis], maxCorner[axis]);
+        occluder.maxCorner[axis] = std::max(minCorner[axis], maxCorner[axis]);
+    }
+    (occluder.isStatic ? m_staticOccludersDirty : m_dynamicOccludersDirty) = true;
+}
+
+void AIVisionManager::removeOccluder(int occluderId) {
+    if (occluderId < 0 || occluderId >= static_cast<int>(m_occluders.size()) ||
+        !m_occluders[occluderId].active) {
+        return;
+    }
+    Occluder& occluder = m_occluders[occluderId];
+    occluder.active = false;
+    (occluder.isStatic ? m_staticOccludersDirty : m_dynamicOccludersDirty) = true;
+    m_freeOccluders.push_back(occluderId);
+}
+
+void AIVisionManager::setOccluderCellSize(float size) {
+    m_occluderCellSize = std::max(size, 0.001f);
+    m_staticOccludersDirty = true;
+    m_dynamicOccludersDirty = true;
+}
+
+bool AIVisionManager::raycast(const float from[3], const float to[3], OcclusionTest* result) {
+    refreshOccluders();
+    
+    float hitFraction = std::numeric_limits<float>::max();
+    float dynamicFraction = 0.0f;
+    bool blocked = traceOccluders(m_staticOccluderGrid, from, to, hitFraction);
+    if (traceOccluders(m_dynamicOccluderGrid, from, to, dynamicFraction)) {
+        hitFraction = blocked ? std::min(hitFraction, dynamicFraction) : dynamicFraction;
+        blocked = true;
+    }
+    
+    if (result) {
+        result->isOccluded = blocked;
+        result->coveragePercent = blocked ? 1.0f : 0.0f;
+        if (blocked) {
+            const float delta[3] = {to[0] - from[0], to[1] - from[1], to[2] - from[2]};
+            result->nearestOccluderDistance = hitFraction * vectorLength(delta);
+        }
+    }
+    return blocked;
 }
 
 AIVisionManager::Stats AIVisionManager::getStatistics() const {
@@ -488,45 +761,257 @@ AIVisionManager::Stats AIVisionManager::getStatistics() const {
 }
 
 void AIVisionManager::updateSpatialPartitioning() {
-    m_sectors.clear();
+    const size_t count = m_targets.size();
+    const uint32_t tableSize = tableSizeFor(count);
+    m_targetGrid.mask = tableSize - 1;
+    m_targetGrid.inverseCellSize = 1.0f / std::max(m_sectorSize, 0.001f);
+    m_targetGrid.cellStart.assign(tableSize + 1, 0);
+    m_targetCells.resize(count * 2);
     
-    for (Entity* target : m_targets) {
-        // Get target position
-        float pos[3] = {0, 0, 0};  // Would get from entity
-        uint64_t key = getSectorKey(pos[0], pos[2]);
-        m_sectors[key].targets.push_back(target);
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t x = static_cast<int32_t>(
+            std::floor(m_targetPositions[i * 3] * m_targetGrid.inverseCellSize));
+        const int32_t z = static_cast<int32_t>(
+            std::floor(m_targetPositions[i * 3 + 2] * m_targetGrid.inverseCellSize));
+        m_targetCells[i * 2] = x;
+        m_targetCells[i * 2 + 1] = z;
+        m_targetGrid.cellStart[cellHash(x, z, m_targetGrid.mask)]++;
     }
+    fillCells(m_targetGrid.cellStart, m_targetGrid.items, count, [&](auto&& place) {
+        for (size_t i = 0; i < count; ++i) {
+            place(cellHash(m_targetCells[i * 2], m_targetCells[i * 2 + 1], m_targetGrid.mask),
+                  static_cast<uint32_t>(i));
+        }
+    });
 }
 
-uint64_t AIVisionManager::getSectorKey(float x, float z) const {
-    int32_t sectorX = static_cast<int32_t>(std::floor(x / m_sectorSize));
-    int32_t sectorZ = static_cast<int32_t>(std::floor(z / m_sectorSize));
-    return (static_cast<uint64_t>(sectorX) << 32) | static_cast<uint64_t>(sectorZ);
+void AIVisionManager::refreshTargets() {
+    if (m_targetGridDirty) {
+        updateSpatialPartitioning();
+        m_targetGridDirty = false;
+    }
+}
+
+void AIVisionManager::refreshOccluders() {
+    if (m_staticOccludersDirty) {
+        rebuildOccluderGrid(m_staticOccluderGrid, true);
+        m_staticRevision++;
+        m_staticOccludersDirty = false;
+    }
+    if (m_dynamicOccludersDirty) {
+        rebuildOccluderGrid(m_dynamicOccluderGrid, false);
+        m_dynamicOccludersDirty = false;
+    }
+}
+
+void AIVisionManager::rebuildOccluderGrid(CellGrid& grid, bool isStatic) {
+    grid.inverseCellSize = 1.0f / m_occluderCellSize;
+    
+    // A box is listed in every cell its x/z footprint overlaps
+    auto forEachCell = [&](const Occluder& occluder, auto&& visit) {
+        const float scale = grid.inverseCellSize;
+        const int32_t x0 = static_cast<int32_t>(std::floor(occluder.minCorner[0] * scale));
+        const int32_t x1 = static_cast<int32_t>(std::floor(occluder.maxCorner[0] * scale));
+        const int32_t z0 = static_cast<int32_t>(std::floor(occluder.minCorner[2] * scale));
+        const int32_t z1 = static_cast<int32_t>(std::floor(occluder.maxCorner[2] * scale));
+        for (int32_t z = z0; z <= z1; ++z) {
+            for (int32_t x = x0; x <= x1; ++x) {
+                visit(x, z);
+            }
+        }
+    };
+    
+    size_t entryCount = 0;
+    for (const Occluder& occluder : m_occluders) {
+        if (!occluder.active || occluder.isStatic != isStatic) continue;
+        forEachCell(occluder, [&](int32_t, int32_t) { entryCount++; });
+    }
+    if (entryCount == 0) {
+        grid.mask = 0;
+        grid.cellStart.clear();
+        grid.items.clear();
+        return;
+    }
+    
+    const uint32_t tableSize = tableSizeFor(entryCount);
+    grid.mask = tableSize - 1;
+    grid.cellStart.assign(tableSize + 1, 0);
+    for (const Occluder& occluder : m_occluders) {
+        if (!occluder.active || occluder.isStatic != isStatic) continue;
+        forEachCell(occluder, [&](int32_t x, int32_t z) {
+            grid.cellStart[cellHash(x, z, grid.mask)]++;
+        });
+    }
+    fillCells(grid.cellStart, grid.items, entryCount, [&](auto&& place) {
+        for (size_t i = 0; i < m_occluders.size(); ++i) {
+            const Occluder& occluder = m_occluders[i];
+            if (!occluder.active || occluder.isStatic != isStatic) continue;
+            forEachCell(occluder, [&](int32_t x, int32_t z) {
+                place(cellHash(x, z, grid.mask), static_cast<uint32_t>(i));
+            });
+        }
+    });
 }
 
-std::vector<Entity*> AIVisionManager::getNearbyTargets(const float pos[3], float radius) {
-    if (!m_useSpacialPartitioning) {
-        return m_targets;
+bool AIVisionManager::traceOccluders(const CellGrid& grid, const float from[3], const float to[3],
+                                     float& hitFraction) const {
+    if (grid.cellStart.empty()) return false;
+    
+    const float delta[3] = {to[0] - from[0], to[1] - from[1], to[2] - from[2]};
+    
+    // Walk the x/z cells the segment crosses in order, stopping once the nearest hit lies
+    // before the current cell's exit
+    const float fx = from[0] * grid.inverseCellSize, fz = from[2] * grid.inverseCellSize;
+    const float dx = delta[0] * grid.inverseCellSize, dz = delta[2] * grid.inverseCellSize;
+    int32_t cx = static_cast<int32_t>(std::floor(fx));
+    int32_t cz = static_cast<int32_t>(std::floor(fz));
+    const int32_t endX = static_cast<int32_t>(std::floor(to[0] * grid.inverseCellSize));
+    const int32_t endZ = static_cast<int32_t>(std::floor(to[2] * grid.inverseCellSize));
+    const int32_t stepX = dx > 0.0f ? 1 : -1, stepZ = dz > 0.0f ? 1 : -1;
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float tDeltaX = dx != 0.0f ? 1.0f / std::fabs(dx) : infinity;
+    const float tDeltaZ = dz != 0.0f ? 1.0f / std::fabs(dz) : infinity;
+    float tMaxX = dx == 0.0f ? infinity : (dx > 0.0f ? cx + 1 - fx : fx - cx) * tDeltaX;
+    float tMaxZ = dz == 0.0f ? infinity : (dz > 0.0f ? cz + 1 - fz : fz - cz) * tDeltaZ;
+    
+    float best = infinity;
+    int steps = std::abs(endX - cx) + std::abs(endZ - cz) + 1;
+    while (steps-- > 0) {
+        const uint32_t cell = cellHash(cx, cz, grid.mask);
+        for (uint32_t i = grid.cellStart[cell]; i < grid.cellStart[cell + 1]; ++i) {
+            const Occluder& occluder = m_occluders[grid.items[i]];
+            float tEnter;
+            if (segmentBox(from, delta, occluder.minCorner, occluder.maxCorner, tEnter)) {
+                best = std::min(best, tEnter);
+            }
+        }
+        if (best <= std::min(std::min(tMaxX, tMaxZ), 1.0f)) break;
+        if (tMaxX < tMaxZ) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+        } else {
+            cz += stepZ;
+            tMaxZ += tDeltaZ;
+        }
     }
     
-    std::vector<Entity*> nearby;
+    if (best > 1.0f) return false;
+    hitFraction = best;
+    return true;
+}
+
+void AIVisionManager::senseObserver(AIVisionSystem& system, ObserverState& state) const {
+    const VisionConeConfig& config = system.m_config;
+    float eye[3], forward[3];
+    system.getEyePosition(eye);
+    system.getForwardDirection(forward);
+    const float range = config.viewDistance;
+    const float cosHalfFov = std::cos(config.fieldOfView * 0.5f * 3.14159f / 180.0f);
     
-    // Get sectors in radius
-    int sectorRadius = static_cast<int>(std::ceil(radius / m_sectorSize));
-    uint64_t centerKey = getSectorKey(pos[0], pos[2]);
+    state.pass++;
+    state.visibilityTests = 0;
+    state.occlusionTests = 0;
+    state.cacheHits = 0;
+    system.m_sightings.clear();
     
-    // Check neighboring sectors
-    for (int dx = -sectorRadius; dx <= sectorRadius; ++dx) {
-        for (int dz = -sectorRadius; dz <= sectorRadius; ++dz) {
-            uint64_t key = centerKey + (static_cast<uint64_t>(dx) << 32) + dz;
-            auto it = m_sectors.find(key);
-            if (it != m_sectors.end()) {
-                nearby.insert(nearby.end(), it->second.targets.begin(), it->second.targets.end());
+    auto testTarget = [&](size_t index) {
+        const float* position = &m_targetPositions[index * 3];
+        const float toTarget[3] = {position[0] - eye[0], position[1] - eye[1],
+                                   position[2] - eye[2]};
+        const float distanceSq = dotProduct(toTarget, toTarget);
+        if (distanceSq > range * range) return;
+        
+        // Cone test without acos: cos(angle) * distance against cos(fov / 2) * distance
+        state.visibilityTests++;
+        const float distance = std::sqrt(distanceSq);
+        const float along = dotProduct(forward, toTarget);
+        if (along < cosHalfFov * distance) return;
+        
+        Entity* entity = m_targets[index];
+        if (entity == system.m_owner) return;
+        
+        // Static occluders only change the answer if an end moved or the occluders changed
+        LineOfSight& sight = state.lineOfSight[entity];
+        if (sight.pass != 0 && sight.revision == m_staticRevision &&
+            samePosition(sight.eye, eye) && samePosition(sight.target, position)) {
+            state.cacheHits++;
+        } else {
+            state.occlusionTests++;
+            std::copy(eye, eye + 3, sight.eye);
+            std::copy(position, position + 3, sight.target);
+            sight.revision = m_staticRevision;
+            float hitFraction;
+            sight.blocked = traceOccluders(m_staticOccluderGrid, eye, position, hitFraction);
+        }
+        sight.pass = state.pass;
+        
+        bool occluded = sight.blocked;
+        if (!occluded && !m_dynamicOccluderGrid.cellStart.empty()) {
+            float hitFraction;
+            state.occlusionTests++;
+            occluded = traceOccluders(m_dynamicOccluderGrid, eye, position, hitFraction);
+        }
+        
+        VisionSighting sighting;
+        sighting.entity = entity;
+        std::copy(position, position + 3, sighting.position);
+        sighting.distance = distance;
+        sighting.angleFromForward = distance > 0.0f
+            ? std::acos(std::max(-1.0f, std::min(1.0f, along / distance))) * 180.0f / 3.14159f
+            : 0.0f;
+        sighting.isOccluded = occluded;
+        system.m_sightings.push_back(sighting);
+    };
+    
+    const float inverseCellSize = m_targetGrid.inverseCellSize;
+    const int32_t x0 = static_cast<int32_t>(std::floor((eye[0] - range) * inverseCellSize));
+    const int32_t x1 = static_cast<int32_t>(std::floor((eye[0] + range) * inverseCellSize));
+    const int32_t z0 = static_cast<int32_t>(std::floor((eye[2] - range) * inverseCellSize));
+    const int32_t z1 = static_cast<int32_t>(std::floor((eye[2] + range) * inverseCellSize));
+    const size_t cellCount = static_cast<size_t>(x1 - x0 + 1) * static_cast<size_t>(z1 - z0 + 1);
+    
+    if (!m_useSpacialPartitioning || m_targetGrid.cellStart.empty() ||
+        cellCount >= m_targets.size()) {
+        for (size_t i = 0; i < m_targets.size(); ++i) {
+            testTarget(i);
+        }
+    } else {
+        for (int32_t z = z0; z <= z1; ++z) {
+            for (int32_t x = x0; x <= x1; ++x) {
+                const uint32_t cell = cellHash(x, z, m_targetGrid.mask);
+                for (uint32_t i = m_targetGrid.cellStart[cell];
+                     i < m_targetGrid.cellStart[cell + 1]; ++i) {
+                    // Cells share hashed buckets; only take targets that really lie in this one
+                    const uint32_t target = m_targetGrid.items[i];
+                    if (m_targetCells[target * 2] == x && m_targetCells[target * 2 + 1] == z) {
+                        testTarget(target);
+                    }
+                }
             }
         }
     }
     
-    return nearby;
+    // Drop cached pairs whose target has left the cone
+    for (auto it = state.lineOfSight.begin(); it != state.lineOfSight.end();) {
+        it = it->second.pass == state.pass ? std::next(it) : state.lineOfSight.erase(it);
+    }
+    
+    std::sort(system.m_sightings.begin(), system.m_sightings.end(),
+              [](const VisionSighting& a, const VisionSighting& b) {
+                  return entityLess(a.entity, b.entity);
+              });
+}
+
+void AIVisionManager::senseSystem(AIVisionSystem& system) {
+    auto it = std::find(m_visionSystems.begin(), m_visionSystems.end(), &system);
+    if (it == m_visionSystems.end()) return;
+    
+    // Targets may have been added, removed or moved since the last manager update
+    refreshTargets();
+    refreshOccluders();
+    ObserverState& state = m_observerStates[it - m_visionSystems.begin()];
+    senseObserver(system, state);
+    state.pendingTime = 0.0f;
 }
 
 // VisionQueries implementation
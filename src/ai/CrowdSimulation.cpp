@@ -1,11 +1,23 @@
 #include "ai/CrowdSimulation.h"
+#include "threading/ThreadPool.h"
 #include <cmath>
 #include <algorithm>
 
 namespace Engine {
 
+void CrowdSimulation::MotionArrays::resize(size_t count) {
+    positionX.resize(count);
+    positionY.resize(count);
+    positionZ.resize(count);
+    velocityX.resize(count);
+    velocityY.resize(count);
+    velocityZ.resize(count);
+}
+
 CrowdSimulation::CrowdSimulation()
-    : m_separationWeight(1.5f)
+    : m_gridDirty(true)
+    , m_jobSystem(nullptr)
+    , m_separationWeight(1.5f)
     , m_alignmentWeight(1.0f)
     , m_cohesionWeight(1.0f)
     , m_neighborRadius(5.0f)
@@ -19,99 +31,272 @@ CrowdSimulation& CrowdSimulation::getInstance() {
 }
 
 int CrowdSimulation::addAgent(float x, float y, float z, float radius) {
-    CrowdAgent agent;
-    agent.position[0] = x;
-    agent.position[1] = y;
-    agent.position[2] = z;
-    agent.velocity[0] = 0.0f;
-    agent.velocity[1] = 0.0f;
-    agent.velocity[2] = 0.0f;
-    agent.radius = radius;
-    agent.maxSpeed = 2.0f;
-    agent.maxForce = 5.0f;
-    agent.groupId = 0;
-    agent.active = true;
-    
-    m_agents.push_back(agent);
+    m_motion.positionX.push_back(x);
+    m_motion.positionY.push_back(y);
+    m_motion.positionZ.push_back(z);
+    m_motion.velocityX.push_back(0.0f);
+    m_motion.velocityY.push_back(0.0f);
+    m_motion.velocityZ.push_back(0.0f);
+    m_radius.push_back(radius);
+    m_maxSpeed.push_back(2.0f);
+    m_maxForce.push_back(5.0f);
+    m_groupId.push_back(0);
+    m_active.push_back(1);
+    
+    m_gridDirty = true;
     return m_nextAgentId++;
 }
 
 void CrowdSimulation::removeAgent(int agentId) {
-    if (agentId >= 0 && agentId < static_cast<int>(m_agents.size())) {
-        m_agents[agentId].active = false;
+    if (agentId >= 0 && agentId < getAgentCount()) {
+        m_active[agentId] = 0;
+        m_gridDirty = true;
     }
 }
 
 void CrowdSimulation::clearAgents() {
-    m_agents.clear();
+    m_motion.resize(0);
+    m_nextMotion.resize(0);
+    m_radius.clear();
+    m_maxSpeed.clear();
+    m_maxForce.clear();
+    m_groupId.clear();
+    m_active.clear();
+    m_gridDirty = true;
     m_nextAgentId = 0;
 }
 
 void CrowdSimulation::setAgentTarget(int agentId, float x, float y, float z) {
-    if (agentId >= 0 && agentId < static_cast<int>(m_agents.size())) {
-        auto& agent = m_agents[agentId];
-        
+    if (agentId >= 0 && agentId < getAgentCount()) {
         // Calculate direction to target
-        float dx = x - agent.position[0];
-        float dy = y - agent.position[1];
-        float dz = z - agent.position[2];
+        float dx = x - m_motion.positionX[agentId];
+        float dy = y - m_motion.positionY[agentId];
+        float dz = z - m_motion.positionZ[agentId];
         
         float dist = std::sqrt(dx*dx + dy*dy + dz*dz);
         if (dist > 0.001f) {
-            agent.velocity[0] = (dx / dist) * agent.maxSpeed;
-            agent.velocity[1] = (dy / dist) * agent.maxSpeed;
-            agent.velocity[2] = (dz / dist) * agent.maxSpeed;
+            const float maxSpeed = m_maxSpeed[agentId];
+            m_motion.velocityX[agentId] = (dx / dist) * maxSpeed;
+            m_motion.velocityY[agentId] = (dy / dist) * maxSpeed;
+            m_motion.velocityZ[agentId] = (dz / dist) * maxSpeed;
         }
     }
 }
 
 void CrowdSimulation::setAgentVelocity(int agentId, float vx, float vy, float vz) {
-    if (agentId >= 0 && agentId < static_cast<int>(m_agents.size())) {
-        auto& agent = m_agents[agentId];
-        agent.velocity[0] = vx;
-        agent.velocity[1] = vy;
-        agent.velocity[2] = vz;
+    if (agentId >= 0 && agentId < getAgentCount()) {
+        m_motion.velocityX[agentId] = vx;
+        m_motion.velocityY[agentId] = vy;
+        m_motion.velocityZ[agentId] = vz;
     }
 }
 
 void CrowdSimulation::setAgentGroup(int agentId, int groupId) {
-    if (agentId >= 0 && agentId < static_cast<int>(m_agents.size())) {
-        m_agents[agentId].groupId = groupId;
+    if (agentId >= 0 && agentId < getAgentCount()) {
+        m_groupId[agentId] = groupId;
     }
 }
 
 void CrowdSimulation::getAgentPosition(int agentId, float& x, float& y, float& z) const {
-    if (agentId >= 0 && agentId < static_cast<int>(m_agents.size())) {
-        const auto& agent = m_agents[agentId];
-        x = agent.position[0];
-        y = agent.position[1];
-        z = agent.position[2];
+    if (agentId >= 0 && agentId < getAgentCount()) {
+        x = m_motion.positionX[agentId];
+        y = m_motion.positionY[agentId];
+        z = m_motion.positionZ[agentId];
     }
 }
 
+bool CrowdSimulation::getAgent(int agentId, CrowdAgent& agent) const {
+    if (agentId < 0 || agentId >= getAgentCount()) return false;
+    
+    agent.position[0] = m_motion.positionX[agentId];
+    agent.position[1] = m_motion.positionY[agentId];
+    agent.position[2] = m_motion.positionZ[agentId];
+    agent.velocity[0] = m_motion.velocityX[agentId];
+    agent.velocity[1] = m_motion.velocityY[agentId];
+    agent.velocity[2] = m_motion.velocityZ[agentId];
+    agent.radius = m_radius[agentId];
+    agent.maxSpeed = m_maxSpeed[agentId];
+    agent.maxForce = m_maxForce[agentId];
+    agent.groupId = m_groupId[agentId];
+    agent.active = m_active[agentId] != 0;
+    return true;
+}
+
+void CrowdSimulation::setNeighborRadius(float radius) {
+    m_neighborRadius = radius;
+    m_gridDirty = true;
+}
+
 void CrowdSimulation::update(float deltaTime) {
-    for (auto& agent : m_agents) {
-        if (agent.active) {
-            updateAgent(agent, deltaTime);
+    const size_t count = m_active.size();
+    if (count == 0) return;
+    
+    if (m_gridDirty) {
+        rebuildGrid();
+    }
+    m_nextMotion.resize(count);
+    
+    if (!m_jobSystem || count < AGENTS_PER_JOB * 2) {
+        m_scratch.resize(std::max<size_t>(m_scratch.size(), 1));
+        updateAgents(0, count, deltaTime, m_scratch[0].cells, m_scratch[0].neighbors);
+    } else {
+        const size_t jobCount = (count + AGENTS_PER_JOB - 1) / AGENTS_PER_JOB;
+        m_scratch.resize(std::max(m_scratch.size(), jobCount));
+        
+        JJM::Threading::JobCounter counter;
+        for (size_t job = 0; job < jobCount; ++job) {
+            m_jobSystem->dispatch(
+                [this, job, count, deltaTime]() {
+                    const size_t begin = job * AGENTS_PER_JOB;
+                    const size_t end = std::min(begin + AGENTS_PER_JOB, count);
+                    updateAgents(begin, end, deltaTime, m_scratch[job].cells,
+                                 m_scratch[job].neighbors);
+                },
+                counter);
+        }
+        m_jobSystem->wait(counter);
+    }
+    
+    std::swap(m_motion, m_nextMotion);
+    
+    // Built from the new positions, so queries until the next update see them too
+    rebuildGrid();
+}
+
+void CrowdSimulation::rebuildGrid() {
+    const size_t count = m_active.size();
+    
+    // Hashed cells keep the table O(n) however spread out the agents are
+    uint32_t tableSize = 64;
+    while (tableSize < count * 2) tableSize *= 2;
+    m_grid.mask = tableSize - 1;
+    m_grid.inverseCellSize = 1.0f / std::max(m_neighborRadius, 0.001f);
+    m_grid.cellOf.resize(count);
+    m_grid.cellStart.assign(tableSize + 1, 0);
+    m_grid.agents.resize(count);
+    
+    // Counting sort: count per cell, prefix sum, then scatter
+    size_t inserted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_active[i]) continue;
+        const uint32_t cell = cellHash(
+            static_cast<int>(std::floor(m_motion.positionX[i] * m_grid.inverseCellSize)),
+            static_cast<int>(std::floor(m_motion.positionY[i] * m_grid.inverseCellSize)),
+            static_cast<int>(std::floor(m_motion.positionZ[i] * m_grid.inverseCellSize)));
+        m_grid.cellOf[i] = cell;
+        m_grid.cellStart[cell]++;
+        inserted++;
+    }
+    uint32_t offset = 0;
+    for (uint32_t cell = 0; cell <= tableSize; ++cell) {
+        const uint32_t cellCount = m_grid.cellStart[cell];
+        m_grid.cellStart[cell] = offset;
+        offset += cellCount;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_active[i]) continue;
+        m_grid.agents[m_grid.cellStart[m_grid.cellOf[i]]++] = static_cast<uint32_t>(i);
+    }
+    // Scattering advanced each start to the next cell's start; shift them back
+    for (uint32_t cell = tableSize; cell > 0; --cell) {
+        m_grid.cellStart[cell] = m_grid.cellStart[cell - 1];
+    }
+    m_grid.cellStart[0] = 0;
+    m_grid.agents.resize(inserted);
+    
+    m_gridDirty = false;
+}
+
+uint32_t CrowdSimulation::cellHash(int x, int y, int z) const {
+    const uint32_t hash = static_cast<uint32_t>(x) * 73856093u ^
+                          static_cast<uint32_t>(y) * 19349663u ^
+                          static_cast<uint32_t>(z) * 83492791u;
+    return hash & m_grid.mask;
+}
+
+void CrowdSimulation::gatherCells(float x, float y, float z, int reach,
+                                  std::vector<uint32_t>& cells) const {
+    const int cx = static_cast<int>(std::floor(x * m_grid.inverseCellSize));
+    const int cy = static_cast<int>(std::floor(y * m_grid.inverseCellSize));
+    const int cz = static_cast<int>(std::floor(z * m_grid.inverseCellSize));
+    
+    cells.clear();
+    for (int dz = -reach; dz <= reach; ++dz) {
+        for (int dy = -reach; dy <= reach; ++dy) {
+            for (int dx = -reach; dx <= reach; ++dx) {
+                cells.push_back(cellHash(cx + dx, cy + dy, cz + dz));
+            }
         }
     }
+    
+    // Different cells can hash to the same slot; visit each slot once
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
 }
 
-void CrowdSimulation::updateAgent(CrowdAgent& agent, float deltaTime) {
+void CrowdSimulation::gatherNeighbors(size_t index, std::vector<uint32_t>& cells,
+                                      std::vector<uint32_t>& neighbors) const {
+    neighbors.clear();
+    
+    const float x = m_motion.positionX[index];
+    const float y = m_motion.positionY[index];
+    const float z = m_motion.positionZ[index];
+    const int group = m_groupId[index];
+    const float radiusSq = m_neighborRadius * m_neighborRadius;
+    
+    gatherCells(x, y, z, 1, cells);
+    for (uint32_t cell : cells) {
+        for (uint32_t k = m_grid.cellStart[cell]; k < m_grid.cellStart[cell + 1]; ++k) {
+            const uint32_t other = m_grid.agents[k];
+            if (other == index) continue;
+            if (group >= 0 && m_groupId[other] != group) continue;
+            
+            float dx = m_motion.positionX[other] - x;
+            float dy = m_motion.positionY[other] - y;
+            float dz = m_motion.positionZ[other] - z;
+            
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq < radiusSq) {
+                neighbors.push_back(other);
+            }
+        }
+    }
+}
+
+void CrowdSimulation::updateAgents(size_t begin, size_t end, float deltaTime,
+                                   std::vector<uint32_t>& cells, std::vector<uint32_t>& neighbors) {
+    for (size_t i = begin; i < end; ++i) {
+        if (!m_active[i]) {
+            m_nextMotion.positionX[i] = m_motion.positionX[i];
+            m_nextMotion.positionY[i] = m_motion.positionY[i];
+            m_nextMotion.positionZ[i] = m_motion.positionZ[i];
+            m_nextMotion.velocityX[i] = m_motion.velocityX[i];
+            m_nextMotion.velocityY[i] = m_motion.velocityY[i];
+            m_nextMotion.velocityZ[i] = m_motion.velocityZ[i];
+            continue;
+        }
+        
+        gatherNeighbors(i, cells, neighbors);
+        updateAgent(i, neighbors, deltaTime);
+    }
+}
+
+void CrowdSimulation::updateAgent(size_t index, const std::vector<uint32_t>& neighbors,
+                                  float deltaTime) {
     float steering[3] = {0.0f, 0.0f, 0.0f};
     
     // Apply flocking behaviors
     float separation[3] = {0.0f, 0.0f, 0.0f};
-    applySeparation(agent, separation);
+    applySeparation(index, neighbors, separation);
     
     float alignment[3] = {0.0f, 0.0f, 0.0f};
-    applyAlignment(agent, alignment);
+    applyAlignment(index, neighbors, alignment);
     
     float cohesion[3] = {0.0f, 0.0f, 0.0f};
-    applyCohesion(agent, cohesion);
+    applyCohesion(index, neighbors, cohesion);
     
     float avoidance[3] = {0.0f, 0.0f, 0.0f};
-    applyAvoidance(agent, avoidance);
+    applyAvoidance(index, avoidance);
     
     // Combine forces
     steering[0] += separation[0] * m_separationWeight;
@@ -131,51 +316,54 @@ void CrowdSimulation::updateAgent(CrowdAgent& agent, float deltaTime) {
     steering[2] += avoidance[2];
     
     // Limit steering force
+    const float maxForce = m_maxForce[index];
     float forceMag = std::sqrt(steering[0]*steering[0] + steering[1]*steering[1] + steering[2]*steering[2]);
-    if (forceMag > agent.maxForce) {
-        steering[0] = (steering[0] / forceMag) * agent.maxForce;
-        steering[1] = (steering[1] / forceMag) * agent.maxForce;
-        steering[2] = (steering[2] / forceMag) * agent.maxForce;
+    if (forceMag > maxForce) {
+        steering[0] = (steering[0] / forceMag) * maxForce;
+        steering[1] = (steering[1] / forceMag) * maxForce;
+        steering[2] = (steering[2] / forceMag) * maxForce;
     }
     
     // Update velocity
-    agent.velocity[0] += steering[0] * deltaTime;
-    agent.velocity[1] += steering[1] * deltaTime;
-    agent.velocity[2] += steering[2] * deltaTime;
+    float velocity[3] = {
+        m_motion.velocityX[index] + steering[0] * deltaTime,
+        m_motion.velocityY[index] + steering[1] * deltaTime,
+        m_motion.velocityZ[index] + steering[2] * deltaTime,
+    };
     
     // Limit speed
-    float speed = std::sqrt(agent.velocity[0]*agent.velocity[0] + 
-                           agent.velocity[1]*agent.velocity[1] + 
-                           agent.velocity[2]*agent.velocity[2]);
-    if (speed > agent.maxSpeed) {
-        agent.velocity[0] = (agent.velocity[0] / speed) * agent.maxSpeed;
-        agent.velocity[1] = (agent.velocity[1] / speed) * agent.maxSpeed;
-        agent.velocity[2] = (agent.velocity[2] / speed) * agent.maxSpeed;
+    const float maxSpeed = m_maxSpeed[index];
+    float speed = std::sqrt(velocity[0]*velocity[0] + velocity[1]*velocity[1] + velocity[2]*velocity[2]);
+    if (speed > maxSpeed) {
+        velocity[0] = (velocity[0] / speed) * maxSpeed;
+        velocity[1] = (velocity[1] / speed) * maxSpeed;
+        velocity[2] = (velocity[2] / speed) * maxSpeed;
     }
     
     // Update position
-    agent.position[0] += agent.velocity[0] * deltaTime;
-    agent.position[1] += agent.velocity[1] * deltaTime;
-    agent.position[2] += agent.velocity[2] * deltaTime;
+    m_nextMotion.velocityX[index] = velocity[0];
+    m_nextMotion.velocityY[index] = velocity[1];
+    m_nextMotion.velocityZ[index] = velocity[2];
+    m_nextMotion.positionX[index] = m_motion.positionX[index] + velocity[0] * deltaTime;
+    m_nextMotion.positionY[index] = m_motion.positionY[index] + velocity[1] * deltaTime;
+    m_nextMotion.positionZ[index] = m_motion.positionZ[index] + velocity[2] * deltaTime;
 }
 
-void CrowdSimulation::applySeparation(CrowdAgent& agent, float force[3]) {
-    std::vector<CrowdAgent*> neighbors;
-    getNeighbors(agent, neighbors);
-    
+void CrowdSimulation::applySeparation(size_t index, const std::vector<uint32_t>& neighbors,
+                                      float force[3]) const {
     if (neighbors.empty()) return;
     
     force[0] = 0.0f;
     force[1] = 0.0f;
     force[2] = 0.0f;
     
-    for (auto* neighbor : neighbors) {
-        float dx = agent.position[0] - neighbor->position[0];
-        float dy = agent.position[1] - neighbor->position[1];
-        float dz = agent.position[2] - neighbor->position[2];
+    for (uint32_t neighbor : neighbors) {
+        float dx = m_motion.positionX[index] - m_motion.positionX[neighbor];
+        float dy = m_motion.positionY[index] - m_motion.positionY[neighbor];
+        float dz = m_motion.positionZ[index] - m_motion.positionZ[neighbor];
         
         float dist = std::sqrt(dx*dx + dy*dy + dz*dz);
-        if (dist > 0.001f && dist < agent.radius + neighbor->radius + 1.0f) {
+        if (dist > 0.001f && dist < m_radius[index] + m_radius[neighbor] + 1.0f) {
             // Repel stronger when closer
             float weight = 1.0f / (dist * dist);
             force[0] += (dx / dist) * weight;
@@ -185,20 +373,18 @@ void CrowdSimulation::applySeparation(CrowdAgent& agent, float force[3]) {
     }
 }
 
-void CrowdSimulation::applyAlignment(CrowdAgent& agent, float force[3]) {
-    std::vector<CrowdAgent*> neighbors;
-    getNeighbors(agent, neighbors);
-    
+void CrowdSimulation::applyAlignment(size_t index, const std::vector<uint32_t>& neighbors,
+                                     float force[3]) const {
     if (neighbors.empty()) return;
     
     force[0] = 0.0f;
     force[1] = 0.0f;
     force[2] = 0.0f;
     
-    for (auto* neighbor : neighbors) {
-        force[0] += neighbor->velocity[0];
-        force[1] += neighbor->velocity[1];
-        force[2] += neighbor->velocity[2];
+    for (uint32_t neighbor : neighbors) {
+        force[0] += m_motion.velocityX[neighbor];
+        force[1] += m_motion.velocityY[neighbor];
+        force[2] += m_motion.velocityZ[neighbor];
     }
     
     force[0] /= neighbors.size();
@@ -206,23 +392,21 @@ void CrowdSimulation::applyAlignment(CrowdAgent& agent, float force[3]) {
     force[2] /= neighbors.size();
     
     // Steer towards average velocity
-    force[0] -= agent.velocity[0];
-    force[1] -= agent.velocity[1];
-    force[2] -= agent.velocity[2];
+    force[0] -= m_motion.velocityX[index];
+    force[1] -= m_motion.velocityY[index];
+    force[2] -= m_motion.velocityZ[index];
 }
 
-void CrowdSimulation::applyCohesion(CrowdAgent& agent, float force[3]) {
-    std::vector<CrowdAgent*> neighbors;
-    getNeighbors(agent, neighbors);
-    
+void CrowdSimulation::applyCohesion(size_t index, const std::vector<uint32_t>& neighbors,
+                                    float force[3]) const {
     if (neighbors.empty()) return;
     
     float centerX = 0.0f, centerY = 0.0f, centerZ = 0.0f;
     
-    for (auto* neighbor : neighbors) {
-        centerX += neighbor->position[0];
-        centerY += neighbor->position[1];
-        centerZ += neighbor->position[2];
+    for (uint32_t neighbor : neighbors) {
+        centerX += m_motion.positionX[neighbor];
+        centerY += m_motion.positionY[neighbor];
+        centerZ += m_motion.positionZ[neighbor];
     }
     
     centerX /= neighbors.size();
@@ -230,52 +414,58 @@ void CrowdSimulation::applyCohesion(CrowdAgent& agent, float force[3]) {
     centerZ /= neighbors.size();
     
     // Steer towards center of mass
-    force[0] = centerX - agent.position[0];
-    force[1] = centerY - agent.position[1];
-    force[2] = centerZ - agent.position[2];
+    force[0] = centerX - m_motion.positionX[index];
+    force[1] = centerY - m_motion.positionY[index];
+    force[2] = centerZ - m_motion.positionZ[index];
 }
 
-void CrowdSimulation::applyAvoidance(CrowdAgent& agent, float force[3]) {
+void CrowdSimulation::applyAvoidance(size_t index, float force[3]) const {
     // TODO: Obstacle avoidance
+    (void)index;
     force[0] = 0.0f;
     force[1] = 0.0f;
     force[2] = 0.0f;
 }
 
-void CrowdSimulation::getNeighbors(const CrowdAgent& agent, std::vector<CrowdAgent*>& neighbors) {
-    neighbors.clear();
-    
-    for (auto& other : m_agents) {
-        if (!other.active || &other == &agent) continue;
-        if (agent.groupId >= 0 && other.groupId != agent.groupId) continue;
-        
-        float dx = other.position[0] - agent.position[0];
-        float dy = other.position[1] - agent.position[1];
-        float dz = other.position[2] - agent.position[2];
-        
-        float distSq = dx*dx + dy*dy + dz*dz;
-        if (distSq < m_neighborRadius * m_neighborRadius) {
-            neighbors.push_back(const_cast<CrowdAgent*>(&other));
-        }
-    }
-}
-
 void CrowdSimulation::getAgentsInRadius(float x, float y, float z, float radius, std::vector<int>& results) const {
     results.clear();
     float radiusSq = radius * radius;
     
-    for (size_t i = 0; i < m_agents.size(); ++i) {
-        if (!m_agents[i].active) continue;
-        
-        float dx = m_agents[i].position[0] - x;
-        float dy = m_agents[i].position[1] - y;
-        float dz = m_agents[i].position[2] - z;
-        
-        float distSq = dx*dx + dy*dy + dz*dz;
-        if (distSq <= radiusSq) {
-            results.push_back(static_cast<int>(i));
+    // Small radii use the grid; a stale grid or a wide radius falls back to a scan
+    const int reach = static_cast<int>(std::ceil(radius * m_grid.inverseCellSize));
+    if (m_gridDirty || reach > 2) {
+        for (size_t i = 0; i < m_active.size(); ++i) {
+            if (!m_active[i]) continue;
+            
+            float dx = m_motion.positionX[i] - x;
+            float dy = m_motion.positionY[i] - y;
+            float dz = m_motion.positionZ[i] - z;
+            
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= radiusSq) {
+                results.push_back(static_cast<int>(i));
+            }
+        }
+        return;
+    }
+    
+    std::vector<uint32_t> cells;
+    gatherCells(x, y, z, reach, cells);
+    for (uint32_t cell : cells) {
+        for (uint32_t k = m_grid.cellStart[cell]; k < m_grid.cellStart[cell + 1]; ++k) {
+            const uint32_t i = m_grid.agents[k];
+            
+            float dx = m_motion.positionX[i] - x;
+            float dy = m_motion.positionY[i] - y;
+            float dz = m_motion.positionZ[i] - z;
+            
+            float distSq = dx*dx + dy*dy + dz*dz;
+            if (distSq <= radiusSq) {
+                results.push_back(static_cast<int>(i));
+            }
         }
     }
+    std::sort(results.begin(), results.end());
 }
 
 } // namespace Engine
@@ -1,4 +1,5 @@
 #include "ai/CrowdSimulationSystem.h"
+#include "ai/Pathfinding.h"
 
 #include <algorithm>
 #include <cmath>
@@ -33,6 +34,7 @@ CrowdAgent::CrowdAgent(Entity* entity)
       m_state(CrowdAgentState::IDLE),
       m_hasTarget(false),
       m_currentWaypoint(0),
+      m_flowField(nullptr),
       m_enabled(true) {
     m_position[0] = m_position[1] = m_position[2] = 0;
     m_velocity[0] = m_velocity[1] = m_velocity[2] = 0;
@@ -101,7 +103,9 @@ void CrowdAgent::calculateSteering(float outSteering[3]) {
     calculateCohesion(cohesion);
     calculateAvoidance(avoidance);
 
-    if (m_properties.usePathFollowing && !m_path.empty()) {
+    if (m_flowField) {
+        calculateFlowFollowing(pathFollowing);
+    } else if (m_properties.usePathFollowing && !m_path.empty()) {
         calculatePathFollowing(pathFollowing);
     }
 
@@ -221,6 +225,15 @@ void CrowdAgent::calculatePathFollowing(float outForce[3]) {
     outForce[2] = toWaypoint[2];
 }
 
+void CrowdAgent::calculateFlowFollowing(float outForce[3]) {
+    // Zero at the goal or where the goal can't be reached
+    Math::Vector2D direction =
+        m_flowField->getDirection(Math::Vector2D(m_position[0], m_position[2]));
+    outForce[0] = direction.x;
+    outForce[1] = 0;
+    outForce[2] = direction.y;
+}
+
 void CrowdAgent::update(float deltaTime) {
     if (!m_enabled) return;
 
@@ -423,6 +436,13 @@ void CrowdSimulationSystem::update(float deltaTime) {
     m_stats.formationCount = static_cast<int>(m_formations.size());
 }
 
+void CrowdSimulationSystem::setGroupFlowField(const std::vector<CrowdAgent*>& agents,
+                                              const FlowField* field) {
+    for (auto* agent : agents) {
+        agent->setFlowField(field);
+    }
+}
+
 void CrowdSimulationSystem::updateNeighbors() {
     for (auto* agent : m_agents) {
         if (!agent->isEnabled()) continue;
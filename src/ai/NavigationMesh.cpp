@@ -160,6 +160,7 @@ NavMeshPath NavMesh::findPath(int startNodeId, int endNodeId) const {
 
     if (startNodeId == endNodeId) {
         result.waypoints.push_back(nodes[startNodeId]->getCenter());
+        result.nodeIds.push_back(startNodeId);
         result.valid = true;
         return result;
     }
@@ -279,6 +280,7 @@ void NavMesh::reconstructPath(const std::unordered_map<int, int>& cameFrom, int
 
     std::reverse(nodeIds.begin(), nodeIds.end());
 
+    path.nodeIds = nodeIds;
     path.totalCost = 0.0f;
     for (size_t i = 0; i < nodeIds.size(); i++) {
         const NavMeshNode* node = getNode(nodeIds[i]);
@@ -488,6 +490,22 @@ NavMeshAgent::NavMeshAgent(const NavMesh* navMesh)
       timeSinceLastPath(0.0f),
       paused(false) {}
 
+NavMeshAgent::~NavMeshAgent() {
+    if (pathService && pendingRequestId >= 0) {
+        pathService->cancelRequest(pendingRequestId);
+    }
+}
+
+void NavMeshAgent::setPathService(ThreadedPathfinder* service, int priority, int deadlineFrames) {
+    if (pathService && pendingRequestId >= 0) {
+        pathService->cancelRequest(pendingRequestId);
+        pendingRequestId = -1;
+    }
+    pathService = service;
+    pathPriority = priority;
+    pathDeadlineFrames = deadlineFrames;
+}
+
 void NavMeshAgent::setPosition(const JJM::Math::Vector2D& pos) { position = pos; }
 
 void NavMeshAgent::setDestination(const JJM::Math::Vector2D& dest) {
@@ -500,8 +518,8 @@ void NavMeshAgent::update(float deltaTime) {
 
     timeSinceLastPath += deltaTime;
 
-    // Auto repath if enabled
-    if (autoRepath && timeSinceLastPath >= repathInterval) {
+    // Auto repath if enabled, unless the last request has not come back yet
+    if (autoRepath && timeSinceLastPath >= repathInterval && !isPathPending()) {
         calculatePath();
         timeSinceLastPath = 0.0f;
     }
@@ -525,6 +543,22 @@ void NavMeshAgent::resume() { paused = false; }
 void NavMeshAgent::calculatePath() {
     if (!navMesh) return;
 
+    if (pathService) {
+        // A newer destination supersedes the request in flight
+        if (pendingRequestId >= 0) {
+            pathService->cancelRequest(pendingRequestId);
+        }
+        pendingRequestId = pathService->requestPath(
+            position, destination,
+            [this](const NavMeshPath& path) {
+                pendingRequestId = -1;
+                currentPath = path;
+                currentWaypointIndex = 0;
+            },
+            pathPriority, pathDeadlineFrames);
+        return;
+    }
+
     currentPath = navMesh->findPath(position, destination);
     currentWaypointIndex = 0;
 }
@@ -667,5 +701,522 @@ JJM::Math::Vector2D LocalAvoidance::linearProgram(const std::vector<LocalAvoidan
     return result;
 }
 
+// =============================================================================
+// PathCache Implementation
+// =============================================================================
+
+namespace {
+
+uint64_t cacheTimeMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point from,
+                 std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+}  // namespace
+
+PathCache::PathCache(size_t maxSize) : maxSize(maxSize) {}
+
+void PathCache::addPath(const PathCacheKey& key, const NavMeshPath& path) {
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        it->second.path = path;
+        it->second.timestamp = cacheTimeMs();
+        it->second.valid = true;
+        moveToFront(key);
+        return;
+    }
+
+    if (maxSize == 0) return;
+    while (cache.size() >= maxSize) {
+        evictOldest();
+    }
+
+    CachedPath& cached = cache[key];
+    cached.path = path;
+    cached.timestamp = cacheTimeMs();
+    cached.useCount = 0;
+    lruList.push_front(key);
+    lruMap[key] = lruList.begin();
+}
+
+const NavMeshPath* PathCache::getPath(const PathCacheKey& key) {
+    auto it = cache.find(key);
+    if (it == cache.end() || !it->second.valid) {
+        stats.misses++;
+        return nullptr;
+    }
+    if (isExpired(it->second)) {
+        invalidatePath(key);
+        stats.misses++;
+        return nullptr;
+    }
+
+    stats.hits++;
+    it->second.useCount++;
+    moveToFront(key);
+    return &it->second.path;
+}
+
+void PathCache::invalidatePath(const PathCacheKey& key) {
+    auto it = lruMap.find(key);
+    if (it == lruMap.end()) return;
+    lruList.erase(it->second);
+    lruMap.erase(it);
+    cache.erase(key);
+}
+
+void PathCache::invalidatePathsContaining(int nodeId) {
+    std::vector<PathCacheKey> stale;
+    for (const auto& entry : cache) {
+        const std::vector<int>& nodeIds = entry.second.path.nodeIds;
+        if (entry.first.startNodeId == nodeId || entry.first.endNodeId == nodeId ||
+            std::find(nodeIds.begin(), nodeIds.end(), nodeId) != nodeIds.end()) {
+            stale.push_back(entry.first);
+        }
+    }
+    for (const auto& key : stale) {
+        invalidatePath(key);
+    }
+}
+
+void PathCache::clear() {
+    cache.clear();
+    lruList.clear();
+    lruMap.clear();
+}
+
+void PathCache::setMaxSize(size_t size) {
+    maxSize = size;
+    while (cache.size() > maxSize) {
+        evictOldest();
+    }
+}
+
+PathCache::CacheStats PathCache::getStatistics() const {
+    stats.cacheSize = cache.size();
+    const size_t lookups = stats.hits + stats.misses;
+    stats.hitRate = lookups > 0 ? static_cast<float>(stats.hits) / lookups : 0.0f;
+    return stats;
+}
+
+void PathCache::resetStatistics() { stats = CacheStats{}; }
+
+void PathCache::evictOldest() {
+    if (lruList.empty()) return;
+    const PathCacheKey key = lruList.back();
+    lruList.pop_back();
+    lruMap.erase(key);
+    cache.erase(key);
+    stats.evictions++;
+}
+
+void PathCache::moveToFront(const PathCacheKey& key) {
+    auto it = lruMap.find(key);
+    if (it != lruMap.end()) {
+        lruList.splice(lruList.begin(), lruList, it->second);
+    }
+}
+
+bool PathCache::isExpired(const CachedPath& cached) const {
+    if (expirationTime <= 0.0f) return false;
+    return cacheTimeMs() - cached.timestamp > static_cast<uint64_t>(expirationTime * 1000.0f);
+}
+
+// =============================================================================
+// ThreadedPathfinder Implementation
+// =============================================================================
+
+ThreadedPathfinder::ThreadedPathfinder(NavMesh& mesh, int threadCount)
+    : navMesh(mesh), threadCount(std::max(threadCount, 0)) {}
+
+ThreadedPathfinder::~ThreadedPathfinder() { stop(); }
+
+int ThreadedPathfinder::requestPath(const JJM::Math::Vector2D& start,
+                                    const JJM::Math::Vector2D& end,
+                                    std::function<void(const NavMeshPath&)> callback,
+                                    int priority, int deadlineFrames) {
+    PathRequest request;
+    request.start = start;
+    request.end = end;
+    request.priority = priority;
+    request.submitFrame = currentFrame.load();
+    // Results are delivered at the next frame at the earliest
+    if (deadlineFrames >= 0) {
+        request.deadlineFrame = request.submitFrame + std::max(deadlineFrames, 1);
+    }
+    request.submitTime = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    request.requestId = nextRequestId++;
+    callbacks[request.requestId] = std::move(callback);
+    pendingRequests.push_back(std::move(request));
+    return pendingRequests.back().requestId;
+}
+
+void ThreadedPathfinder::cancelRequest(int requestId) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (callbacks.erase(requestId) == 0) return;
+
+    auto matches = [requestId](const PathRequest& request) {
+        return request.requestId == requestId;
+    };
+    pendingRequests.erase(
+        std::remove_if(pendingRequests.begin(), pendingRequests.end(), matches),
+        pendingRequests.end());
+    requestQueue.erase(std::remove_if(requestQueue.begin(), requestQueue.end(), matches),
+                       requestQueue.end());
+    for (auto& entry : inFlight) {
+        auto& waiters = entry.second;
+        waiters.erase(std::remove_if(waiters.begin(), waiters.end(), matches), waiters.end());
+    }
+    // A search already running completes, but nothing is delivered without the callback
+
+    std::lock_guard<std::mutex> statsLock(completedMutex);
+    stats.cancelledRequests++;
+}
+
+void ThreadedPathfinder::cancelAllRequests() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    const size_t cancelled = callbacks.size();
+    callbacks.clear();
+    pendingRequests.clear();
+    requestQueue.clear();
+    for (auto& entry : inFlight) {
+        entry.second.clear();  // The searching worker still owns the entry
+    }
+
+    std::lock_guard<std::mutex> completedLock(completedMutex);
+    completedPaths.clear();
+    stats.cancelledRequests += cancelled;
+}
+
+void ThreadedPathfinder::start() {
+    if (running.exchange(true)) return;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadedPathfinder::workerThread, this);
+    }
+}
+
+void ThreadedPathfinder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        running = false;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadedPathfinder::pause() { paused = true; }
+
+void ThreadedPathfinder::resume() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        paused = false;
+    }
+    queueCondition.notify_all();
+}
+
+void ThreadedPathfinder::setFrameTimeBudget(float milliseconds) {
+    frameBudgetMicros = milliseconds > 0.0f ? static_cast<int64_t>(milliseconds * 1000.0f)
+                                            : INT64_MAX;
+}
+
+bool ThreadedPathfinder::frameBudgetSpent() const {
+    return frameWorkMicros.load(std::memory_order_relaxed) >=
+           frameBudgetMicros.load(std::memory_order_relaxed);
+}
+
+void ThreadedPathfinder::processCompletedPaths() {
+    const uint64_t frame = ++currentFrame;
+
+    std::vector<CompletedPath> completed;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.swap(completedPaths);
+    }
+
+    // Cancelled requests have no callback left and are dropped here
+    std::vector<std::pair<std::function<void(const NavMeshPath&)>, const CompletedPath*>>
+        deliveries;
+    deliveries.reserve(completed.size());
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (const auto& result : completed) {
+            auto it = callbacks.find(result.requestId);
+            if (it == callbacks.end()) continue;
+            deliveries.emplace_back(std::move(it->second), &result);
+            callbacks.erase(it);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        for (const auto& delivery : deliveries) {
+            stats.completedRequests++;
+            totalLatencyFrames += frame - delivery.second->submitFrame;
+            if (frame > delivery.second->deadlineFrame) stats.missedDeadlines++;
+        }
+    }
+
+    // No locks held, so callbacks may submit new requests
+    for (auto& delivery : deliveries) {
+        if (delivery.first) delivery.first(delivery.second->path);
+    }
+
+    releaseBatch();
+
+    if (workers.empty() && !paused) {
+        for (;;) {
+            PathRequest request;
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                if (requestQueue.empty() || frameBudgetSpent()) break;
+                request = std::move(requestQueue.front());
+                requestQueue.pop_front();
+            }
+            processRequest(request);
+        }
+    }
+}
+
+void ThreadedPathfinder::releaseBatch() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+
+        // Requests the workers did not reach compete again with newer ones
+        for (auto& request : requestQueue) {
+            pendingRequests.push_back(std::move(request));
+        }
+        requestQueue.clear();
+        frameWorkMicros = 0;
+        if (pendingRequests.empty()) return;
+
+        // Due requests first (their result is needed by the next frame), then priority,
+        // then the nearer deadline, then age
+        const uint64_t due = currentFrame + 1;
+        auto before = [due](const PathRequest& a, const PathRequest& b) {
+            const bool urgentA = a.deadlineFrame <= due;
+            const bool urgentB = b.deadlineFrame <= due;
+            if (urgentA != urgentB) return urgentA;
+            if (a.priority != b.priority) return a.priority > b.priority;
+            if (a.deadlineFrame != b.deadlineFrame) return a.deadlineFrame < b.deadlineFrame;
+            return a.requestId < b.requestId;
+        };
+        const size_t count =
+            maxRequestsPerFrame > 0
+                ? std::min(pendingRequests.size(), static_cast<size_t>(maxRequestsPerFrame))
+                : pendingRequests.size();
+        std::partial_sort(pendingRequests.begin(), pendingRequests.begin() + count,
+                          pendingRequests.end(), before);
+        for (size_t i = 0; i < count; ++i) {
+            requestQueue.push_back(std::move(pendingRequests[i]));
+        }
+        pendingRequests.erase(pendingRequests.begin(), pendingRequests.begin() + count);
+    }
+    queueCondition.notify_all();
+}
+
+void ThreadedPathfinder::workerThread() {
+    for (;;) {
+        PathRequest request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() {
+                return !running || (!paused && !requestQueue.empty() && !frameBudgetSpent());
+            });
+            if (!running) return;
+            request = std::move(requestQueue.front());
+            requestQueue.pop_front();
+        }
+        processRequest(request);
+    }
+}
+
+void ThreadedPathfinder::processRequest(PathRequest& request) {
+    const auto started = std::chrono::steady_clock::now();
+    auto chargeFrame = [this, started]() {
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started);
+        frameWorkMicros += micros.count();
+    };
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        const double latency = elapsedMs(request.submitTime, started);
+        totalQueueLatency += latency;
+        stats.maxQueueLatency = std::max(stats.maxQueueLatency, static_cast<float>(latency));
+        startedRequests++;
+    }
+
+    // Nearby requests resolve to the same polygons and share the search below
+    const int startNode = navMesh.findNodeContainingPoint(request.start);
+    const int endNode = navMesh.findNodeContainingPoint(request.end);
+    if (startNode < 0 || endNode < 0) {
+        completeRequest(request, NavMeshPath());
+        chargeFrame();
+        return;
+    }
+    const PathCacheKey key{startNode, endNode};
+
+    if (pathCache) {
+        NavMeshPath cached;
+        bool hit = false;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (const NavMeshPath* path = pathCache->getPath(key)) {
+                cached = *path;
+                hit = true;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            hit ? stats.cacheHits++ : stats.cacheMisses++;
+        }
+        if (hit) {
+            completeRequest(request, cached);
+            chargeFrame();
+            return;
+        }
+    }
+
+    // An identical search already running answers this request too
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto it = inFlight.find(key);
+        if (it != inFlight.end()) {
+            it->second.push_back(std::move(request));
+            std::lock_guard<std::mutex> statsLock(completedMutex);
+            stats.coalescedRequests++;
+            return;
+        }
+        inFlight.emplace(key, std::vector<PathRequest>());
+    }
+
+    const auto searchStart = std::chrono::steady_clock::now();
+    const NavMeshPath nodePath = navMesh.findPath(startNode, endNode);
+    const double searchMs = elapsedMs(searchStart, std::chrono::steady_clock::now());
+
+    if (pathCache && nodePath.valid) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        pathCache->addPath(key, nodePath);
+    }
+
+    std::vector<PathRequest> waiters;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto it = inFlight.find(key);
+        waiters = std::move(it->second);
+        inFlight.erase(it);
+    }
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        totalPathTime += searchMs;
+        searchCount++;
+    }
+
+    completeRequest(request, nodePath);
+    for (const auto& waiter : waiters) {
+        completeRequest(waiter, nodePath);
+    }
+    chargeFrame();
+}
+
+void ThreadedPathfinder::completeRequest(const PathRequest& request, const NavMeshPath& nodePath) {
+    CompletedPath completed{request.requestId, nodePath, request.deadlineFrame,
+                            request.submitFrame};
+    if (completed.path.valid) {
+        // Same shape as NavMesh::findPath(start, end): polygon centres between the endpoints
+        completed.path.waypoints.insert(completed.path.waypoints.begin(), request.start);
+        completed.path.waypoints.push_back(request.end);
+    }
+
+    std::lock_guard<std::mutex> lock(completedMutex);
+    completedPaths.push_back(std::move(completed));
+}
+
+ThreadedPathfinder::ThreadStats ThreadedPathfinder::getStatistics() const {
+    // Same lock order as cancelRequest(); workers update stats under completedMutex
+    std::lock_guard<std::mutex> queueLock(queueMutex);
+    std::lock_guard<std::mutex> completedLock(completedMutex);
+    ThreadStats result = stats;
+    result.pendingRequests = pendingRequests.size() + requestQueue.size();
+    result.averagePathTime =
+        searchCount > 0 ? static_cast<float>(totalPathTime / searchCount) : 0.0f;
+    result.averageQueueLatency =
+        startedRequests > 0 ? static_cast<float>(totalQueueLatency / startedRequests) : 0.0f;
+    result.averageLatencyFrames =
+        result.completedRequests > 0
+            ? static_cast<float>(totalLatencyFrames) / result.completedRequests
+            : 0.0f;
+    const size_t lookups = result.cacheHits + result.cacheMisses;
+    result.cacheHitRate = lookups > 0 ? static_cast<float>(result.cacheHits) / lookups : 0.0f;
+    return result;
+}
+
+void ThreadedPathfinder::resetStatistics() {
+    std::lock_guard<std::mutex> lock(completedMutex);
+    stats = ThreadStats{};
+    totalPathTime = 0.0;
+    totalQueueLatency = 0.0;
+    totalLatencyFrames = 0;
+    searchCount = 0;
+    startedRequests = 0;
+}
+
+// =============================================================================
+// DynamicObstacleManager Implementation
+// =============================================================================
+
+DynamicObstacleManager::DynamicObstacleManager(NavMesh& mesh) : navMesh(mesh) {}
+
+DynamicObstacleManager::~DynamicObstacleManager() = default;
+
+int DynamicObstacleManager::addObstacle(const DynamicObstacle& obstacle) {
+    int id = nextObstacleId++;
+    DynamicObstacle& added = obstacles[id];
+    added = obstacle;
+    added.obstacleId = id;
+    return id;
+}
+
+void DynamicObstacleManager::removeObstacle(int obstacleId) { obstacles.erase(obstacleId); }
+
+void DynamicObstacleManager::updateObstacle(int obstacleId, const JJM::Math::Vector2D& position,
+                                            float rotation) {
+    auto it = obstacles.find(obstacleId);
+    if (it != obstacles.end()) {
+        it->second.position = position;
+        it->second.rotation = rotation;
+    }
+}
+
+void DynamicObstacleManager::updateObstacleVelocity(int obstacleId,
+                                                    const JJM::Math::Vector2D& velocity) {
+    auto it = obstacles.find(obstacleId);
+    if (it != obstacles.end()) {
+        it->second.velocity = velocity;
+    }
+}
+
+DynamicObstacle* DynamicObstacleManager::getObstacle(int obstacleId) {
+    auto it = obstacles.find(obstacleId);
+    return it != obstacles.end() ? &it->second : nullptr;
+}
+
+void DynamicObstacleManager::updateAllObstacles(float deltaTime) {
+    for (auto& entry : obstacles) {
+        DynamicObstacle& obstacle = entry.second;
+        obstacle.position = obstacle.position + obstacle.velocity * deltaTime;
+        obstacle.rotation += obstacle.angularVelocity * deltaTime;
+    }
+}
+
 }  // namespace AI
 }  // namespace JJM
@@ -1,4 +1,5 @@
 #include "ai/Pathfinding.h"
+#include "ai/NavigationMesh.h"
 #include <cmath>
 #include <algorithm>
 #include <limits>
@@ -8,7 +9,8 @@ namespace AI {
 
 // Grid implementation
 Grid::Grid(int width, int height)
-    : width(width), height(height) {
+    : width(width), height(height), walkableMask(static_cast<size_t>(width) * height, 1),
+      revision(0) {
     nodes.reserve(width * height);
     for (int y = 0; y < height; ++y) {
         for (int x = 0; x < width; ++x) {
@@ -20,12 +22,14 @@ Grid::Grid(int width, int height)
 void Grid::setWalkable(int x, int y, bool walkable) {
     if (inBounds(x, y)) {
         nodes[y * width + x].walkable = walkable;
+        walkableMask[y * width + x] = walkable ? 1 : 0;
+        ++revision;
     }
 }
 
 bool Grid::isWalkable(int x, int y) const {
     if (!inBounds(x, y)) return false;
-    return nodes[y * width + x].walkable;
+    return walkableMask[y * width + x] != 0;
 }
 
 bool Grid::inBounds(int x, int y) const {
@@ -55,9 +59,80 @@ std::vector<GridNode*> Grid::getNeighbors(GridNode* node) {
     return neighbors;
 }
 
+namespace {
+
+constexpr float DIAGONAL_COST = 1.41421356f;
+constexpr float INFINITE_COST = std::numeric_limits<float>::infinity();
+
+// Exact path length on an obstacle-free grid, so it never overestimates
+float gridDistance(int dx, int dy, bool allowDiagonal) {
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    if (!allowDiagonal) return static_cast<float>(dx + dy);
+    return static_cast<float>(std::max(dx, dy)) +
+           (DIAGONAL_COST - 1.0f) * static_cast<float>(std::min(dx, dy));
+}
+
+} // namespace
+
+// IndexedBinaryHeap implementation
+void IndexedBinaryHeap::push(int32_t node, float f, float h) {
+    entries.push_back({f, h, node});
+    siftUp(entries.size() - 1);
+}
+
+void IndexedBinaryHeap::decreaseKey(int32_t node, float f) {
+    const size_t index = static_cast<size_t>(states[node].heapIndex);
+    entries[index].f = f;
+    siftUp(index);
+}
+
+int32_t IndexedBinaryHeap::pop() {
+    const int32_t node = entries.front().node;
+    states[node].heapIndex = SearchNodeState::CLOSED;
+    
+    const Entry last = entries.back();
+    entries.pop_back();
+    if (!entries.empty()) {
+        entries.front() = last;
+        siftDown(0);
+    }
+    return node;
+}
+
+void IndexedBinaryHeap::siftUp(size_t index) {
+    const Entry entry = entries[index];
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!less(entry, entries[parent])) break;
+        entries[index] = entries[parent];
+        states[entries[index].node].heapIndex = static_cast<int32_t>(index);
+        index = parent;
+    }
+    entries[index] = entry;
+    states[entry.node].heapIndex = static_cast<int32_t>(index);
+}
+
+void IndexedBinaryHeap::siftDown(size_t index) {
+    const Entry entry = entries[index];
+    const size_t count = entries.size();
+    for (;;) {
+        size_t child = index * 2 + 1;
+        if (child >= count) break;
+        if (child + 1 < count && less(entries[child + 1], entries[child])) ++child;
+        if (!less(entries[child], entry)) break;
+        entries[index] = entries[child];
+        states[entries[index].node].heapIndex = static_cast<int32_t>(index);
+        index = child;
+    }
+    entries[index] = entry;
+    states[entry.node].heapIndex = static_cast<int32_t>(index);
+}
+
 // AStar implementation
 AStar::AStar(Grid* grid)
-    : grid(grid), allowDiagonal(true), heuristic(manhattanDistance) {
+    : grid(grid), allowDiagonal(true), heuristicWeight(1.0f), openSet(states), generation(0),
+      lastExpanded(0) {
 }
 
 float AStar::manhattanDistance(const GridNode& a, const GridNode& b) {
@@ -74,66 +149,625 @@ float AStar::chebyshevDistance(const GridNode& a, const GridNode& b) {
     return static_cast<float>(std::max(std::abs(a.x - b.x), std::abs(a.y - b.y)));
 }
 
+float AStar::octileDistance(const GridNode& a, const GridNode& b) {
+    return gridDistance(a.x - b.x, a.y - b.y, true);
+}
+
 std::vector<Math::Vector2D> AStar::findPath(const Math::Vector2D& start, const Math::Vector2D& goal) {
     GridNode* startNode = grid->getNode(static_cast<int>(start.x), static_cast<int>(start.y));
     GridNode* goalNode = grid->getNode(static_cast<int>(goal.x), static_cast<int>(goal.y));
     
-    if (!startNode || !goalNode || !goalNode->walkable) {
+    if (!startNode || !goalNode || !grid->isWalkable(goalNode->x, goalNode->y)) {
         return {};
     }
     
-    auto compare = [](GridNode* a, GridNode* b) { return a->fCost() > b->fCost(); };
-    std::priority_queue<GridNode*, std::vector<GridNode*>, decltype(compare)> openSet(compare);
-    std::unordered_map<GridNode*, bool> closedSet;
+    const int width = grid->getWidth();
+    const GridRect bounds = {0, 0, width - 1, grid->getHeight() - 1};
+    const int32_t startCell = startNode->y * width + startNode->x;
+    const int32_t goalCell = goalNode->y * width + goalNode->x;
+    if (search(startCell, goalCell, bounds) < 0.0f) {
+        return {}; // No path found
+    }
+    
+    std::vector<Math::Vector2D> result;
+    result.reserve(cellPath.size());
+    for (int32_t cell : cellPath) {
+        result.emplace_back(static_cast<float>(cell % width), static_cast<float>(cell / width));
+    }
+    return result;
+}
+
+void AStar::beginSearch() {
+    const size_t cellCount = static_cast<size_t>(grid->getWidth()) * grid->getHeight();
+    if (states.size() != cellCount) {
+        states.assign(cellCount, {0, -1, 0.0f, SearchNodeState::CLOSED});
+        generation = 0;
+    }
     
-    startNode->gCost = 0;
-    startNode->hCost = heuristic(*startNode, *goalNode);
-    startNode->parent = nullptr;
-    openSet.push(startNode);
+    // Stamps only need resetting when the counter wraps
+    if (++generation == 0) {
+        for (auto& state : states) {
+            state.generation = 0;
+        }
+        std::fill(targetMarks.begin(), targetMarks.end(), 0);
+        generation = 1;
+    }
+    openSet.clear();
+}
+
+float AStar::estimate(int32_t cell, int32_t goal) const {
+    const int width = grid->getWidth();
+    if (heuristic) {
+        const GridNode from(cell % width, cell / width);
+        const GridNode to(goal % width, goal / width);
+        return heuristic(from, to) * heuristicWeight;
+    }
+    return gridDistance(cell % width - goal % width, cell / width - goal / width, allowDiagonal) *
+           heuristicWeight;
+}
+
+template <typename Visit>
+void AStar::forEachNeighbor(int32_t cell, const GridRect& bounds, Visit&& visit) const {
+    const int width = grid->getWidth();
+    const uint8_t* walkable = grid->getWalkableData();
+    const int x = cell % width;
+    const int y = cell / width;
     
+    const bool left = x > bounds.minX && walkable[cell - 1];
+    const bool right = x < bounds.maxX && walkable[cell + 1];
+    const bool up = y > bounds.minY && walkable[cell - width];
+    const bool down = y < bounds.maxY && walkable[cell + width];
+    if (left) visit(cell - 1, 1.0f);
+    if (right) visit(cell + 1, 1.0f);
+    if (up) visit(cell - width, 1.0f);
+    if (down) visit(cell + width, 1.0f);
+    
+    // Diagonal steps need both orthogonal cells open, so paths never cut corners
+    if (!allowDiagonal) return;
+    if (left && up && walkable[cell - width - 1]) visit(cell - width - 1, DIAGONAL_COST);
+    if (right && up && walkable[cell - width + 1]) visit(cell - width + 1, DIAGONAL_COST);
+    if (left && down && walkable[cell + width - 1]) visit(cell + width - 1, DIAGONAL_COST);
+    if (right && down && walkable[cell + width + 1]) visit(cell + width + 1, DIAGONAL_COST);
+}
+
+float AStar::search(int32_t start, int32_t goal, const GridRect& bounds) {
+    beginSearch();
+    cellPath.clear();
+    
+    states[start] = {generation, -1, 0.0f, 0};
+    const float startH = estimate(start, goal);
+    openSet.push(start, startH, startH);
+    
+    size_t expanded = 0;
     while (!openSet.empty()) {
-        GridNode* current = openSet.top();
-        openSet.pop();
+        const int32_t current = openSet.pop();
+        ++expanded;
         
-        if (current == goalNode) {
-            return reconstructPath(goalNode);
+        if (current == goal) {
+            for (int32_t cell = goal; cell != -1; cell = states[cell].parent) {
+                cellPath.push_back(cell);
+            }
+            std::reverse(cellPath.begin(), cellPath.end());
+            lastExpanded = expanded;
+            return states[goal].gCost;
         }
         
-        closedSet[current] = true;
-        
-        for (GridNode* neighbor : grid->getNeighbors(current)) {
-            if (closedSet.find(neighbor) != closedSet.end()) continue;
+        const float currentG = states[current].gCost;
+        forEachNeighbor(current, bounds, [&](int32_t next, float stepCost) {
+            SearchNodeState& state = states[next];
+            const float g = currentG + stepCost;
+            if (state.generation != generation) {
+                state.generation = generation;
+                state.parent = current;
+                state.gCost = g;
+                const float h = estimate(next, goal);
+                openSet.push(next, g + h, h);
+            } else if (state.heapIndex != SearchNodeState::CLOSED && g < state.gCost) {
+                state.parent = current;
+                state.gCost = g;
+                openSet.decreaseKey(next, g + estimate(next, goal));
+            }
+        });
+    }
+    
+    lastExpanded = expanded;
+    return -1.0f;
+}
+
+void AStar::costsWithin(int32_t source, const GridRect& bounds, const int32_t* targets,
+                        size_t targetCount, float* costs) {
+    // Dijkstra flood of the bounded region; it is one cluster, so it stays small
+    beginSearch();
+    if (targetMarks.size() != states.size()) {
+        targetMarks.assign(states.size(), 0);
+    }
+    size_t remaining = 0;
+    for (size_t i = 0; i < targetCount; ++i) {
+        if (targetMarks[targets[i]] != generation) {
+            targetMarks[targets[i]] = generation;
+            ++remaining;
+        }
+    }
+    states[source] = {generation, -1, 0.0f, 0};
+    openSet.push(source, 0.0f, 0.0f);
+    
+    while (!openSet.empty() && remaining > 0) {
+        const int32_t current = openSet.pop();
+        if (targetMarks[current] == generation) {
+            --remaining;
+        }
+        const float currentG = states[current].gCost;
+        forEachNeighbor(current, bounds, [&](int32_t next, float stepCost) {
+            SearchNodeState& state = states[next];
+            const float g = currentG + stepCost;
+            if (state.generation != generation) {
+                state.generation = generation;
+                state.parent = current;
+                state.gCost = g;
+                openSet.push(next, g, 0.0f);
+            } else if (state.heapIndex != SearchNodeState::CLOSED && g < state.gCost) {
+                state.parent = current;
+                state.gCost = g;
+                openSet.decreaseKey(next, g);
+            }
+        });
+    }
+    
+    for (size_t i = 0; i < targetCount; ++i) {
+        const SearchNodeState& state = states[targets[i]];
+        const bool settled =
+            state.generation == generation && state.heapIndex == SearchNodeState::CLOSED;
+        costs[i] = settled ? state.gCost : INFINITE_COST;
+    }
+}
+
+// HierarchicalPathfinder implementation
+HierarchicalPathfinder::HierarchicalPathfinder(Grid* grid, int clusterSize)
+    : grid(grid), low(grid), clusterSize(std::max(clusterSize, 2)),
+      clustersX((grid->getWidth() + this->clusterSize - 1) / this->clusterSize),
+      clustersY((grid->getHeight() + this->clusterSize - 1) / this->clusterSize),
+      nodeStride(4 * this->clusterSize), abstractOpen(abstractStates), abstractGeneration(0),
+      lastAbstractExpanded(0), startCostsCell(-1), goalCostsCell(-1),
+      landmarksValid(false) {
+    const size_t clusterCount = static_cast<size_t>(clustersX) * clustersY;
+    clusters.resize(clusterCount);
+    rightBorders.resize(clusterCount);
+    bottomBorders.resize(clusterCount);
+    for (int cy = 0; cy < clustersY; ++cy) {
+        for (int cx = 0; cx < clustersX; ++cx) {
+            Cluster& cluster = clusters[cy * clustersX + cx];
+            cluster.bounds = {cx * this->clusterSize, cy * this->clusterSize,
+                              std::min((cx + 1) * this->clusterSize, grid->getWidth()) - 1,
+                              std::min((cy + 1) * this->clusterSize, grid->getHeight()) - 1};
+        }
+    }
+    abstractStates.assign(clusterCount * nodeStride + 2, {0, -1, 0.0f, SearchNodeState::CLOSED});
+    build();
+}
+
+void HierarchicalPathfinder::setAllowDiagonal(bool allow) {
+    if (allow == low.getAllowDiagonal()) return;
+    low.setAllowDiagonal(allow);
+    build();
+}
+
+size_t HierarchicalPathfinder::getEntranceCount() const {
+    size_t count = 0;
+    for (const auto& cluster : clusters) {
+        count += cluster.cells.size();
+    }
+    return count;
+}
+
+void HierarchicalPathfinder::build() {
+    updateRegion(0, 0, grid->getWidth() - 1, grid->getHeight() - 1);
+    computeLandmarks();
+}
+
+void HierarchicalPathfinder::updateRegion(int minX, int minY, int maxX, int maxY) {
+    auto clampX = [this](int cx) { return std::max(0, std::min(cx, clustersX - 1)); };
+    auto clampY = [this](int cy) { return std::max(0, std::min(cy, clustersY - 1)); };
+    const int cx0 = std::max(minX, 0) / clusterSize;
+    const int cy0 = std::max(minY, 0) / clusterSize;
+    const int cx1 = std::min(maxX, grid->getWidth() - 1) / clusterSize;
+    const int cy1 = std::min(maxY, grid->getHeight() - 1) / clusterSize;
+    
+    // Every border touching a changed cluster is the right or bottom border of one of these
+    for (int cy = clampY(cy0 - 1); cy <= cy1; ++cy) {
+        for (int cx = clampX(cx0 - 1); cx <= cx1; ++cx) {
+            buildBorders(cx, cy);
+        }
+    }
+    
+    // Entrance lists changed for clusters beside a rebuilt border; partner ids changed for
+    // their neighbours too, since they index into those lists
+    const int lx0 = clampX(cx0 - 1), lx1 = clampX(cx1 + 1);
+    const int ly0 = clampY(cy0 - 1), ly1 = clampY(cy1 + 1);
+    std::vector<int> dirty;
+    std::vector<int32_t> previousCells;
+    for (int cy = ly0; cy <= ly1; ++cy) {
+        for (int cx = lx0; cx <= lx1; ++cx) {
+            Cluster& cluster = clusters[cy * clustersX + cx];
+            previousCells.swap(cluster.cells);
+            const Border* borders[4] = {
+                cx > 0 ? &rightBorders[cy * clustersX + cx - 1] : nullptr,
+                &rightBorders[cy * clustersX + cx],
+                cy > 0 ? &bottomBorders[(cy - 1) * clustersX + cx] : nullptr,
+                &bottomBorders[cy * clustersX + cx],
+            };
+            cluster.cells.clear();
+            for (int side = 0; side < 4; ++side) {
+                cluster.borderOffsets[side] = static_cast<int>(cluster.cells.size());
+                if (!borders[side]) continue;
+                // Left and top borders belong to the neighbour, with this cluster second
+                for (const auto& entrance : *borders[side]) {
+                    cluster.cells.push_back(side % 2 == 0 ? entrance.second : entrance.first);
+                }
+            }
+            cluster.borderOffsets[4] = static_cast<int>(cluster.cells.size());
             
-            float tentativeG = current->gCost + 1.0f; // Assume uniform cost
+            // Neighbours whose entrances came out the same keep their cost tables
+            const bool touched = cx >= cx0 && cx <= cx1 && cy >= cy0 && cy <= cy1;
+            if (touched || cluster.cells != previousCells) {
+                dirty.push_back(cy * clustersX + cx);
+            }
+        }
+    }
+    for (int clusterIndex : dirty) {
+        computeCosts(clusterIndex);
+    }
+    for (int cy = clampY(ly0 - 1); cy <= clampY(ly1 + 1); ++cy) {
+        for (int cx = clampX(lx0 - 1); cx <= clampX(lx1 + 1); ++cx) {
+            linkCluster(cy * clustersX + cx);
+        }
+    }
+    startCostsCell = -1;
+    goalCostsCell = -1;
+    landmarksValid = false;
+}
+
+void HierarchicalPathfinder::buildBorders(int cx, int cy) {
+    const int width = grid->getWidth();
+    const uint8_t* walkable = grid->getWalkableData();
+    const Cluster& cluster = clusters[cy * clustersX + cx];
+    
+    // Walkable runs across a border become one entrance in the middle, or one at each end
+    // when the run is long, as in HPA*
+    auto addRuns = [&](Border& border, int length, auto cellPair) {
+        border.clear();
+        int runStart = -1;
+        for (int i = 0; i <= length; ++i) {
+            bool open = false;
+            if (i < length) {
+                const auto cells = cellPair(i);
+                open = walkable[cells.first] && walkable[cells.second];
+            }
+            if (open && runStart < 0) {
+                runStart = i;
+            } else if (!open && runStart >= 0) {
+                const int runLength = i - runStart;
+                if (runLength >= 6) {
+                    border.push_back(cellPair(runStart));
+                    border.push_back(cellPair(i - 1));
+                } else {
+                    border.push_back(cellPair(runStart + runLength / 2));
+                }
+                runStart = -1;
+            }
+        }
+    };
+    
+    Border& right = rightBorders[cy * clustersX + cx];
+    if (cx + 1 < clustersX) {
+        const int x = cluster.bounds.maxX;
+        addRuns(right, cluster.bounds.maxY - cluster.bounds.minY + 1, [&](int i) {
+            const int32_t cell = (cluster.bounds.minY + i) * width + x;
+            return std::make_pair(cell, cell + 1);
+        });
+    } else {
+        right.clear();
+    }
+    
+    Border& bottom = bottomBorders[cy * clustersX + cx];
+    if (cy + 1 < clustersY) {
+        const int y = cluster.bounds.maxY;
+        addRuns(bottom, cluster.bounds.maxX - cluster.bounds.minX + 1, [&](int i) {
+            const int32_t cell = y * width + cluster.bounds.minX + i;
+            return std::make_pair(cell, cell + width);
+        });
+    } else {
+        bottom.clear();
+    }
+}
+
+void HierarchicalPathfinder::linkCluster(int clusterIndex) {
+    Cluster& cluster = clusters[clusterIndex];
+    const int cx = clusterIndex % clustersX;
+    const int cy = clusterIndex / clustersX;
+    
+    // The entrance on the other side has the same index within the matching border there
+    const int neighbours[4] = {clusterIndex - 1, clusterIndex + 1, clusterIndex - clustersX,
+                               clusterIndex + clustersX};
+    const int facingSide[4] = {1, 0, 3, 2};
+    const bool exists[4] = {cx > 0, cx + 1 < clustersX, cy > 0, cy + 1 < clustersY};
+    
+    const int width = grid->getWidth();
+    const size_t count = cluster.cells.size();
+    cluster.edges.clear();
+    cluster.edgeOffsets.resize(count + 1);
+    int side = 0;
+    for (size_t i = 0; i < count; ++i) {
+        cluster.edgeOffsets[i] = static_cast<int>(cluster.edges.size());
+        for (size_t j = 0; j < count; ++j) {
+            const float cost = cluster.costs[i * count + j];
+            if (j != i && cost < INFINITE_COST) {
+                const int32_t cell = cluster.cells[j];
+                cluster.edges.push_back({clusterIndex * nodeStride + static_cast<int32_t>(j),
+                                         cost, cell % width, cell / width});
+            }
+        }
+        
+        while (static_cast<int>(i) >= cluster.borderOffsets[side + 1]) ++side;
+        if (!exists[side]) continue;
+        const Cluster& other = clusters[neighbours[side]];
+        const int local = other.borderOffsets[facingSide[side]] +
+                          (static_cast<int>(i) - cluster.borderOffsets[side]);
+        const int32_t cell = other.cells[local];
+        cluster.edges.push_back({neighbours[side] * nodeStride + local, 1.0f, cell % width,
+                                 cell / width});
+    }
+    cluster.edgeOffsets[count] = static_cast<int>(cluster.edges.size());
+}
+
+void HierarchicalPathfinder::computeCosts(int clusterIndex) {
+    Cluster& cluster = clusters[clusterIndex];
+    const size_t count = cluster.cells.size();
+    cluster.costs.assign(count * count, INFINITE_COST);
+    
+    // Costs are symmetric, so each search only needs the entrances after its source
+    std::vector<float> row(count);
+    for (size_t i = 0; i < count; ++i) {
+        low.costsWithin(cluster.cells[i], cluster.bounds, cluster.cells.data() + i, count - i,
+                        row.data());
+        for (size_t j = i; j < count; ++j) {
+            cluster.costs[i * count + j] = row[j - i];
+            cluster.costs[j * count + i] = row[j - i];
+        }
+    }
+}
+
+int HierarchicalPathfinder::clusterOf(int32_t cell) const {
+    const int width = grid->getWidth();
+    return (cell / width) / clusterSize * clustersX + (cell % width) / clusterSize;
+}
+
+int32_t HierarchicalPathfinder::nodeCell(int32_t node) const {
+    return clusters[node / nodeStride].cells[node % nodeStride];
+}
+
+void HierarchicalPathfinder::beginAbstractSearch() {
+    if (++abstractGeneration == 0) {
+        for (auto& state : abstractStates) {
+            state.generation = 0;
+        }
+        abstractGeneration = 1;
+    }
+    abstractOpen.clear();
+}
+
+void HierarchicalPathfinder::computeLandmarks() {
+    landmarkCosts.assign(abstractStates.size() * LANDMARKS, INFINITE_COST);
+    
+    // The first landmark is the top-left-most entrance; each later one is the entrance
+    // farthest from those already chosen, which spreads them around the map's edge
+    int32_t source = -1;
+    for (int index = 0; index < static_cast<int>(clusters.size()) && source < 0; ++index) {
+        if (!clusters[index].cells.empty()) source = index * nodeStride;
+    }
+    for (int landmark = 0; landmark < LANDMARKS && source >= 0; ++landmark) {
+        // Dijkstra over the whole abstract graph; edge costs are symmetric
+        beginAbstractSearch();
+        abstractStates[source] = {abstractGeneration, -1, 0.0f, 0};
+        abstractOpen.push(source, 0.0f, 0.0f);
+        while (!abstractOpen.empty()) {
+            const int32_t current = abstractOpen.pop();
+            const float g = abstractStates[current].gCost;
+            landmarkCosts[static_cast<size_t>(current) * LANDMARKS + landmark] = g;
             
-            if (tentativeG < neighbor->gCost || neighbor->parent == nullptr) {
-                neighbor->parent = current;
-                neighbor->gCost = tentativeG;
-                neighbor->hCost = heuristic(*neighbor, *goalNode);
-                openSet.push(neighbor);
+            const Cluster& cluster = clusters[current / nodeStride];
+            const int entrance = current % nodeStride;
+            const AbstractEdge* edge = cluster.edges.data() + cluster.edgeOffsets[entrance];
+            const AbstractEdge* end = cluster.edges.data() + cluster.edgeOffsets[entrance + 1];
+            for (; edge != end; ++edge) {
+                SearchNodeState& state = abstractStates[edge->node];
+                const float next = g + edge->cost;
+                if (state.generation != abstractGeneration) {
+                    state = {abstractGeneration, current, next, 0};
+                    abstractOpen.push(edge->node, next, 0.0f);
+                } else if (state.heapIndex != SearchNodeState::CLOSED && next < state.gCost) {
+                    state.gCost = next;
+                    abstractOpen.decreaseKey(edge->node, next);
+                }
+            }
+        }
+        
+        float farthest = 0.0f;
+        source = -1;
+        for (size_t node = 0; node + 2 < abstractStates.size(); ++node) {
+            const float* costs = &landmarkCosts[node * LANDMARKS];
+            float nearest = INFINITE_COST;
+            for (int chosen = 0; chosen <= landmark; ++chosen) {
+                nearest = std::min(nearest, costs[chosen]);
+            }
+            if (nearest < INFINITE_COST && nearest > farthest) {
+                farthest = nearest;
+                source = static_cast<int32_t>(node);
             }
         }
     }
+    landmarksValid = true;
+}
+
+bool HierarchicalPathfinder::searchAbstract(int32_t startCell, int32_t goalCell) {
+    const int32_t startNode = static_cast<int32_t>(clusters.size()) * nodeStride;
+    const int32_t goalNode = startNode + 1;
+    const int width = grid->getWidth();
+    const int goalX = goalCell % width, goalY = goalCell / width;
+    const bool diagonal = low.getAllowDiagonal();
+    
+    // Temporary edges from the start and to the goal within their clusters
+    const int startCluster = clusterOf(startCell);
+    const int goalCluster = clusterOf(goalCell);
+    const Cluster& from = clusters[startCluster];
+    const Cluster& to = clusters[goalCluster];
+    if (startCell != startCostsCell) {
+        startCosts.resize(from.cells.size());
+        low.costsWithin(startCell, from.bounds, from.cells.data(), from.cells.size(),
+                        startCosts.data());
+        startCostsCell = startCell;
+    }
+    if (goalCell != goalCostsCell) {
+        goalCosts.resize(to.cells.size());
+        low.costsWithin(goalCell, to.bounds, to.cells.data(), to.cells.size(), goalCosts.data());
+        goalCostsCell = goalCell;
+    }
     
-    return {}; // No path found
+    // Landmark costs to the goal go through one of its cluster's entrances. By the triangle
+    // inequality |d(L, goal) - d(L, n)| never overestimates the cost from n to the goal
+    if (!landmarksValid) {
+        computeLandmarks();
+    }
+    float goalLandmarkCosts[LANDMARKS];
+    for (int landmark = 0; landmark < LANDMARKS; ++landmark) {
+        float best = INFINITE_COST;
+        for (size_t i = 0; i < to.cells.size(); ++i) {
+            const size_t node = static_cast<size_t>(goalCluster) * nodeStride + i;
+            best = std::min(best, landmarkCosts[node * LANDMARKS + landmark] + goalCosts[i]);
+        }
+        goalLandmarkCosts[landmark] = best;
+    }
+    auto estimate = [&](int32_t node, int x, int y) {
+        float h = gridDistance(x - goalX, y - goalY, diagonal);
+        const float* costs = &landmarkCosts[static_cast<size_t>(node) * LANDMARKS];
+        for (int landmark = 0; landmark < LANDMARKS; ++landmark) {
+            if (costs[landmark] < INFINITE_COST && goalLandmarkCosts[landmark] < INFINITE_COST) {
+                h = std::max(h, std::abs(goalLandmarkCosts[landmark] - costs[landmark]));
+            }
+        }
+        return h;
+    };
+    
+    beginAbstractSearch();
+    auto relax = [&](int32_t node, int32_t parent, float g, int x, int y) {
+        SearchNodeState& state = abstractStates[node];
+        if (state.generation != abstractGeneration) {
+            state = {abstractGeneration, parent, g, 0};
+            const float h = node == goalNode ? 0.0f : estimate(node, x, y);
+            abstractOpen.push(node, g + h, h);
+        } else if (state.heapIndex != SearchNodeState::CLOSED && g < state.gCost) {
+            state.parent = parent;
+            state.gCost = g;
+            abstractOpen.decreaseKey(node, g + (node == goalNode ? 0.0f : estimate(node, x, y)));
+        }
+    };
+    
+    const float startH = gridDistance(startCell % width - goalX, startCell / width - goalY,
+                                      diagonal);
+    abstractStates[startNode] = {abstractGeneration, -1, 0.0f, 0};
+    abstractOpen.push(startNode, startH, startH);
+    size_t expanded = 0;
+    while (!abstractOpen.empty()) {
+        const int32_t current = abstractOpen.pop();
+        ++expanded;
+        if (current == goalNode) break;
+        
+        const float g = abstractStates[current].gCost;
+        if (current == startNode) {
+            for (size_t i = 0; i < from.cells.size(); ++i) {
+                if (startCosts[i] < INFINITE_COST) {
+                    relax(startCluster * nodeStride + static_cast<int32_t>(i), current,
+                          g + startCosts[i], from.cells[i] % width, from.cells[i] / width);
+                }
+            }
+            continue;
+        }
+        
+        const int clusterIndex = current / nodeStride;
+        const int entrance = current % nodeStride;
+        const Cluster& cluster = clusters[clusterIndex];
+        const AbstractEdge* edge = cluster.edges.data() + cluster.edgeOffsets[entrance];
+        const AbstractEdge* end = cluster.edges.data() + cluster.edgeOffsets[entrance + 1];
+        for (; edge != end; ++edge) {
+            relax(edge->node, current, g + edge->cost, edge->x, edge->y);
+        }
+        if (clusterIndex == goalCluster && goalCosts[entrance] < INFINITE_COST) {
+            relax(goalNode, current, g + goalCosts[entrance], goalX, goalY);
+        }
+    }
+    lastAbstractExpanded = expanded;
+    
+    const SearchNodeState& goalState = abstractStates[goalNode];
+    if (goalState.generation != abstractGeneration ||
+        goalState.heapIndex != SearchNodeState::CLOSED) {
+        return false;
+    }
+    abstractPath.clear();
+    for (int32_t node = goalNode; node != -1; node = abstractStates[node].parent) {
+        abstractPath.push_back(node);
+    }
+    std::reverse(abstractPath.begin(), abstractPath.end());
+    return true;
 }
 
-std::vector<Math::Vector2D> AStar::reconstructPath(GridNode* endNode) {
-    std::vector<GridNode*> nodePath;
-    GridNode* current = endNode;
+std::vector<Math::Vector2D> HierarchicalPathfinder::findPath(const Math::Vector2D& start,
+                                                             const Math::Vector2D& goal) {
+    const int sx = static_cast<int>(start.x), sy = static_cast<int>(start.y);
+    const int gx = static_cast<int>(goal.x), gy = static_cast<int>(goal.y);
+    if (!grid->inBounds(sx, sy) || !grid->isWalkable(gx, gy) || !grid->isWalkable(sx, sy)) {
+        return {};
+    }
     
-    while (current != nullptr) {
-        nodePath.push_back(current);
-        current = current->parent;
+    // Short queries are cheaper (and optimal) without the abstract layer
+    const int width = grid->getWidth();
+    const int32_t startCell = sy * width + sx;
+    const int32_t goalCell = gy * width + gx;
+    if (std::max(std::abs(gx - sx), std::abs(gy - sy)) <= clusterSize ||
+        clusterOf(startCell) == clusterOf(goalCell)) {
+        return low.findPath(start, goal);
     }
     
-    std::reverse(nodePath.begin(), nodePath.end());
+    if (!searchAbstract(startCell, goalCell)) {
+        return {};
+    }
     
+    // Refine: legs inside a cluster get a confined A*, border crossings are single steps
     std::vector<Math::Vector2D> result;
-    for (GridNode* node : nodePath) {
-        result.emplace_back(static_cast<float>(node->x), static_cast<float>(node->y));
+    auto append = [&](int32_t cell) {
+        result.emplace_back(static_cast<float>(cell % width), static_cast<float>(cell / width));
+    };
+    append(startCell);
+    int32_t previousCell = startCell;
+    int previousCluster = clusterOf(startCell);
+    const int32_t goalNode = static_cast<int32_t>(clusters.size()) * nodeStride + 1;
+    for (size_t i = 1; i < abstractPath.size(); ++i) {
+        const int32_t node = abstractPath[i];
+        const int32_t cell = node == goalNode ? goalCell : nodeCell(node);
+        const int cluster = node == goalNode ? clusterOf(goalCell) : node / nodeStride;
+        if (cell == previousCell) continue;
+        
+        if (cluster == previousCluster) {
+            if (low.search(previousCell, cell, clusters[cluster].bounds) < 0.0f) {
+                return {};
+            }
+            for (size_t j = 1; j < low.cellPath.size(); ++j) {
+                append(low.cellPath[j]);
+            }
+        } else {
+            append(cell);
+        }
+        previousCell = cell;
+        previousCluster = cluster;
     }
-    
     return result;
 }
 
@@ -194,92 +828,579 @@ std::unordered_map<GridNode*, float> Dijkstra::findDistances(const Math::Vector2
     return distances;
 }
 
+namespace {
+
+constexpr uint8_t NO_DIRECTION = 8;
+constexpr float COST_QUANTUM = 4.0f;    // Tiles are keyed on portal costs rounded to 1/4
+constexpr float DIAGONAL_UNIT = 0.70710678f;
+
+// Direction codes 0-7 run clockwise from +x (y grows downward); odd codes are diagonal
+const int DIRECTION_X[] = {1, 1, 0, -1, -1, -1, 0, 1};
+const int DIRECTION_Y[] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+uint8_t directionCode(int dx, int dy) {
+    static const uint8_t codes[3][3] = {{5, 6, 7}, {4, NO_DIRECTION, 0}, {3, 2, 1}};
+    return codes[dy + 1][dx + 1];
+}
+
+// Calls visit for each cell whose center lies inside the obstacle
+template <typename Visit>
+void forEachCoveredCell(const DynamicObstacle& obstacle, int width, int height, Visit&& visit) {
+    float reach = 0.0f;
+    switch (obstacle.shape) {
+        case ObstacleShape::Circle:
+            reach = obstacle.circle.radius;
+            break;
+        case ObstacleShape::Rectangle:
+            reach = 0.5f * std::sqrt(obstacle.rectangle.width * obstacle.rectangle.width +
+                                     obstacle.rectangle.height * obstacle.rectangle.height);
+            break;
+        case ObstacleShape::Capsule:
+            reach = 0.5f * obstacle.capsule.length + obstacle.capsule.radius;
+            break;
+        case ObstacleShape::Polygon:
+            for (const auto& vertex : obstacle.polygonVertices) {
+                reach = std::max(reach, std::sqrt(vertex.x * vertex.x + vertex.y * vertex.y));
+            }
+            break;
+    }
+    
+    const Math::Vector2D& center = obstacle.position;
+    const int minX = std::max(0, static_cast<int>(std::floor(center.x - reach)));
+    const int maxX = std::min(width - 1, static_cast<int>(std::floor(center.x + reach)));
+    const int minY = std::max(0, static_cast<int>(std::floor(center.y - reach)));
+    const int maxY = std::min(height - 1, static_cast<int>(std::floor(center.y + reach)));
+    const float cosine = std::cos(obstacle.rotation);
+    const float sine = std::sin(obstacle.rotation);
+    
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            // Cell center in the obstacle's frame
+            const float dx = static_cast<float>(x) + 0.5f - center.x;
+            const float dy = static_cast<float>(y) + 0.5f - center.y;
+            const float localX = dx * cosine + dy * sine;
+            const float localY = dy * cosine - dx * sine;
+            
+            bool inside = false;
+            switch (obstacle.shape) {
+                case ObstacleShape::Circle:
+                    inside = localX * localX + localY * localY <=
+                             obstacle.circle.radius * obstacle.circle.radius;
+                    break;
+                case ObstacleShape::Rectangle:
+                    inside = std::abs(localX) <= 0.5f * obstacle.rectangle.width &&
+                             std::abs(localY) <= 0.5f * obstacle.rectangle.height;
+                    break;
+                case ObstacleShape::Capsule: {
+                    const float halfLength = 0.5f * obstacle.capsule.length;
+                    const float along = std::max(-halfLength, std::min(localX, halfLength));
+                    const float offset = localX - along;
+                    inside = offset * offset + localY * localY <=
+                             obstacle.capsule.radius * obstacle.capsule.radius;
+                    break;
+                }
+                case ObstacleShape::Polygon: {
+                    const auto& vertices = obstacle.polygonVertices;
+                    for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+                        if ((vertices[i].y > localY) != (vertices[j].y > localY) &&
+                            localX < (vertices[j].x - vertices[i].x) * (localY - vertices[i].y) /
+                                             (vertices[j].y - vertices[i].y) +
+                                         vertices[i].x) {
+                            inside = !inside;
+                        }
+                    }
+                    break;
+                }
+            }
+            if (inside) {
+                visit(y * width + x);
+            }
+        }
+    }
+}
+
+} // namespace
+
 // FlowField implementation
-FlowField::FlowField(Grid* grid)
-    : grid(grid) {
-    int size = grid->getWidth() * grid->getHeight();
-    costField.resize(size, std::numeric_limits<float>::max());
-    flowField.resize(size);
+size_t FlowField::TileKeyHash::operator()(const std::vector<int32_t>& key) const {
+    uint64_t hash = 14695981039346656037ull;   // FNV-1a
+    for (int32_t value : key) {
+        hash = (hash ^ static_cast<uint32_t>(value)) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
 }
 
-void FlowField::generateField(const Math::Vector2D& goal) {
-    calculateCostField(goal);
-    calculateFlowField();
+FlowField::FlowField(Grid* grid, int sectorSize)
+    : grid(grid), sectorSize(std::max(sectorSize, 2)),
+      sectorsX((grid->getWidth() + this->sectorSize - 1) / this->sectorSize),
+      sectorsY((grid->getHeight() + this->sectorSize - 1) / this->sectorSize),
+      gridRevision(grid->getRevision()), touched(false), hasGoal(false), maxCachedTiles(0),
+      fieldGeneration(0), stats(), sectorOpen(sectorStates), localOpen(localStates),
+      localGeneration(0) {
+    const int width = grid->getWidth();
+    const size_t cellCount = static_cast<size_t>(width) * grid->getHeight();
+    baseCosts.assign(cellCount, 1);
+    obstacleCosts.assign(cellCount, 1);
+    costs.assign(cellCount, 1);
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        refreshCost(static_cast<int32_t>(cell));
+    }
+    
+    const size_t sectorCount = static_cast<size_t>(sectorsX) * sectorsY;
+    for (int sy = 0; sy < sectorsY; ++sy) {
+        for (int sx = 0; sx < sectorsX; ++sx) {
+            sectorBounds.push_back({sx * this->sectorSize, sy * this->sectorSize,
+                                    std::min((sx + 1) * this->sectorSize, width) - 1,
+                                    std::min((sy + 1) * this->sectorSize, grid->getHeight()) - 1});
+        }
+    }
+    sectorRevisions.assign(sectorCount, 0);
+    touchedSectors.assign(sectorCount, 0);
+    sectorTiles.assign(sectorCount, nullptr);
+    sectorOffsets.assign(sectorCount, INFINITE_COST);
+    sectorStates.assign(sectorCount, {0, -1, 0.0f, SearchNodeState::CLOSED});
+    localStates.assign(static_cast<size_t>(this->sectorSize) * this->sectorSize,
+                       {0, -1, 0.0f, SearchNodeState::CLOSED});
+    maxCachedTiles = 2 * sectorCount;
+    stats.sectorCount = sectorCount;
+}
+
+void FlowField::setCellCost(int x, int y, uint8_t cost) {
+    if (!grid->inBounds(x, y)) return;
+    const int32_t cell = y * grid->getWidth() + x;
+    baseCosts[cell] = std::max<uint8_t>(cost, 1);
+    if (refreshCost(cell)) {
+        touch(cell);
+    }
 }
 
-void FlowField::calculateCostField(const Math::Vector2D& goal) {
-    std::fill(costField.begin(), costField.end(), std::numeric_limits<float>::max());
+void FlowField::updateRegion(int minX, int minY, int maxX, int maxY) {
+    const int width = grid->getWidth();
+    minX = std::max(minX, 0);
+    minY = std::max(minY, 0);
+    maxX = std::min(maxX, width - 1);
+    maxY = std::min(maxY, grid->getHeight() - 1);
+    for (int y = minY; y <= maxY; ++y) {
+        for (int x = minX; x <= maxX; ++x) {
+            if (refreshCost(y * width + x)) {
+                touch(y * width + x);
+            }
+        }
+    }
+    gridRevision = grid->getRevision();
+}
+
+void FlowField::applyObstacles(const DynamicObstacleManager& obstacles) {
+    struct Stamp {
+        int32_t cell;
+        int priority;
+        uint8_t cost;
+    };
+    std::vector<Stamp> stamps;
+    for (const auto& entry : obstacles.getObstacles()) {
+        const DynamicObstacle& obstacle = entry.second;
+        if (!obstacle.enabled) continue;
+        const uint8_t cost = obstacle.costMultiplier < 0.0f
+            ? BLOCKED
+            : static_cast<uint8_t>(std::min(std::max(std::lround(obstacle.costMultiplier), 1L),
+                                            static_cast<long>(BLOCKED - 1)));
+        forEachCoveredCell(obstacle, grid->getWidth(), grid->getHeight(), [&](int32_t cell) {
+            stamps.push_back({cell, obstacle.priority, cost});
+        });
+    }
     
-    GridNode* goalNode = grid->getNode(static_cast<int>(goal.x), static_cast<int>(goal.y));
-    if (!goalNode) return;
+    // The highest priority obstacle over a cell decides its cost, the dearest among equals
+    std::sort(stamps.begin(), stamps.end(), [](const Stamp& a, const Stamp& b) {
+        if (a.cell != b.cell) return a.cell < b.cell;
+        if (a.priority != b.priority) return a.priority > b.priority;
+        return a.cost > b.cost;
+    });
     
-    int width = grid->getWidth();
-    costField[goalNode->y * width + goalNode->x] = 0;
+    std::vector<int32_t> cleared;
+    cleared.swap(obstacleCells);
+    for (int32_t cell : cleared) {
+        obstacleCosts[cell] = 1;
+    }
+    for (size_t i = 0; i < stamps.size(); ++i) {
+        if (i > 0 && stamps[i].cell == stamps[i - 1].cell) continue;
+        obstacleCosts[stamps[i].cell] = stamps[i].cost;
+        obstacleCells.push_back(stamps[i].cell);
+    }
     
-    std::queue<GridNode*> frontier;
-    frontier.push(goalNode);
+    for (int32_t cell : cleared) {
+        if (refreshCost(cell)) touch(cell);
+    }
+    for (int32_t cell : obstacleCells) {
+        if (refreshCost(cell)) touch(cell);
+    }
+}
+
+bool FlowField::refreshCost(int32_t cell) {
+    uint8_t cost = BLOCKED;
+    if (grid->getWalkableData()[cell] && baseCosts[cell] != BLOCKED &&
+        obstacleCosts[cell] != BLOCKED) {
+        cost = static_cast<uint8_t>(std::min(baseCosts[cell] * obstacleCosts[cell], BLOCKED - 1));
+    }
+    if (costs[cell] == cost) return false;
+    costs[cell] = cost;
+    return true;
+}
+
+void FlowField::touch(int32_t cell) {
+    const int width = grid->getWidth();
+    touchedSectors[sectorOf(cell % width, cell / width)] = 1;
+    touched = true;
+}
+
+void FlowField::repair() {
+    if (grid->getRevision() != gridRevision) {
+        updateRegion(0, 0, grid->getWidth() - 1, grid->getHeight() - 1);
+    }
+    if (!touched) return;
+    touched = false;
     
-    while (!frontier.empty()) {
-        GridNode* current = frontier.front();
-        frontier.pop();
-        
-        float currentCost = costField[current->y * width + current->x];
+    // A new revision retires the sector's cached tiles; neighbours see the change through
+    // the border costs their tiles are keyed on
+    for (size_t s = 0; s < touchedSectors.size(); ++s) {
+        if (touchedSectors[s]) {
+            touchedSectors[s] = 0;
+            ++sectorRevisions[s];
+            ++stats.sectorsRepaired;
+        }
+    }
+}
+
+int32_t FlowField::localIndex(int sector, int32_t cell) const {
+    const int width = grid->getWidth();
+    const GridRect& bounds = sectorBounds[sector];
+    return (cell / width - bounds.minY) * (bounds.maxX - bounds.minX + 1) + cell % width -
+           bounds.minX;
+}
+
+float FlowField::fieldCost(int sector, int32_t cell) const {
+    const Tile* tile = sectorTiles[sector];
+    if (!tile) return INFINITE_COST;
+    const float cost = tile->costs[localIndex(sector, cell)];
+    return cost == INFINITE_COST ? INFINITE_COST : sectorOffsets[sector] + cost;
+}
+
+int FlowField::neighborSector(int sector, int side) const {
+    const int sx = sector % sectorsX;
+    const int sy = sector / sectorsX;
+    switch (side) {
+        case 0: return sx + 1 < sectorsX ? sector + 1 : -1;
+        case 1: return sy + 1 < sectorsY ? sector + sectorsX : -1;
+        case 2: return sx > 0 ? sector - 1 : -1;
+        default: return sy > 0 ? sector - sectorsX : -1;
+    }
+}
+
+template <typename Visit>
+void FlowField::forEachCrossing(int sector, int side, Visit&& visit) const {
+    const GridRect& bounds = sectorBounds[sector];
+    const int width = grid->getWidth();
+    const bool vertical = side == 0 || side == 2;   // Border runs along y
+    const int outX = side == 0 ? 1 : (side == 2 ? -1 : 0);
+    const int outY = side == 1 ? 1 : (side == 3 ? -1 : 0);
+    const int32_t crossing = outY * width + outX;
+    const int32_t step = vertical ? width : 1;
+    const int32_t first = (side == 1 ? bounds.maxY : bounds.minY) * width +
+                          (side == 0 ? bounds.maxX : bounds.minX);
+    const int length = vertical ? bounds.maxY - bounds.minY + 1 : bounds.maxX - bounds.minX + 1;
+    const int alongX = vertical ? 0 : 1;
+    const int alongY = vertical ? 1 : 0;
+    
+    for (int i = 0; i < length; ++i) {
+        const int32_t inside = first + i * step;
+        const int32_t outside = inside + crossing;
+        if (costs[inside] == BLOCKED || costs[outside] == BLOCKED) continue;
+        visit(inside, outside, 1.0f, directionCode(outX, outY));
         
-        for (GridNode* neighbor : grid->getNeighbors(current)) {
-            int idx = neighbor->y * width + neighbor->x;
-            float newCost = currentCost + 1.0f;
-            
-            if (newCost < costField[idx]) {
-                costField[idx] = newCost;
-                frontier.push(neighbor);
-            }
+        // Diagonal steps stay between the two sectors and never cut corners
+        if (i > 0 && costs[inside - step] != BLOCKED && costs[outside - step] != BLOCKED) {
+            visit(inside, outside - step, DIAGONAL_COST,
+                  directionCode(outX - alongX, outY - alongY));
+        }
+        if (i + 1 < length && costs[inside + step] != BLOCKED && costs[outside + step] != BLOCKED) {
+            visit(inside, outside + step, DIAGONAL_COST,
+                  directionCode(outX + alongX, outY + alongY));
         }
     }
 }
 
-void FlowField::calculateFlowField() {
-    int width = grid->getWidth();
-    int height = grid->getHeight();
+void FlowField::gatherSeeds(int sector, int32_t goalCell) {
+    seeds.clear();
+    const int width = grid->getWidth();
+    if (sectorOf(goalCell % width, goalCell / width) == sector) {
+        seeds.push_back({goalCell, 0.0f, NO_DIRECTION});
+    }
     
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            GridNode* node = grid->getNode(x, y);
-            if (!node || !node->walkable) continue;
-            
-            GridNode* bestNeighbor = nullptr;
-            float lowestCost = costField[y * width + x];
-            
-            for (GridNode* neighbor : grid->getNeighbors(node)) {
-                int idx = neighbor->y * width + neighbor->x;
-                if (costField[idx] < lowestCost) {
-                    lowestCost = costField[idx];
-                    bestNeighbor = neighbor;
-                }
+    // A border cell can reach the goal by stepping into a finished neighbour
+    for (int side = 0; side < 4; ++side) {
+        const int neighbor = neighborSector(sector, side);
+        if (neighbor < 0 || !sectorTiles[neighbor]) continue;
+        forEachCrossing(sector, side, [&](int32_t inside, int32_t outside, float length,
+                                          uint8_t direction) {
+            const float cost = fieldCost(neighbor, outside);
+            if (cost < INFINITE_COST) {
+                seeds.push_back({inside, cost + length * costs[outside], direction});
             }
-            
-            if (bestNeighbor) {
-                Math::Vector2D dir(
-                    static_cast<float>(bestNeighbor->x - x),
-                    static_cast<float>(bestNeighbor->y - y)
-                );
-                flowField[y * width + x] = dir.normalized();
+        });
+    }
+    
+    // Keep the cheapest seed per cell, in cell order so equal seed sets give equal keys
+    std::sort(seeds.begin(), seeds.end(), [](const Seed& a, const Seed& b) {
+        return a.cell < b.cell || (a.cell == b.cell && a.cost < b.cost);
+    });
+    seeds.erase(std::unique(seeds.begin(), seeds.end(),
+                            [](const Seed& a, const Seed& b) { return a.cell == b.cell; }),
+                seeds.end());
+}
+
+void FlowField::integrate(const GridRect& bounds) {
+    const int width = grid->getWidth();
+    const int localWidth = bounds.maxX - bounds.minX + 1;
+    
+    if (++localGeneration == 0) {
+        for (auto& state : localStates) {
+            state.generation = 0;
+        }
+        localGeneration = 1;
+    }
+    localOpen.clear();
+    
+    // Seeds keep their direction code in the parent field as -1 - code
+    for (const Seed& seed : seeds) {
+        const int32_t local =
+            (seed.cell / width - bounds.minY) * localWidth + seed.cell % width - bounds.minX;
+        localStates[local] = {localGeneration, -1 - static_cast<int32_t>(seed.direction),
+                              seed.cost, 0};
+        localOpen.push(local, seed.cost, 0.0f);
+    }
+    
+    while (!localOpen.empty()) {
+        const int32_t current = localOpen.pop();
+        const int x = current % localWidth + bounds.minX;
+        const int y = current / localWidth + bounds.minY;
+        const int32_t cell = y * width + x;
+        // Neighbours reach the goal by stepping onto this cell, so they pay its cost
+        const float cellCost = static_cast<float>(costs[cell]);
+        const float currentCost = localStates[current].gCost;
+        
+        auto visit = [&](int dx, int dy, float length) {
+            const int32_t next = current + dy * localWidth + dx;
+            SearchNodeState& state = localStates[next];
+            const float g = currentCost + length * cellCost;
+            if (state.generation != localGeneration) {
+                state = {localGeneration, current, g, 0};
+                localOpen.push(next, g, 0.0f);
+            } else if (state.heapIndex != SearchNodeState::CLOSED && g < state.gCost) {
+                state.parent = current;
+                state.gCost = g;
+                localOpen.decreaseKey(next, g);
+            }
+        };
+        
+        const bool left = x > bounds.minX && costs[cell - 1] != BLOCKED;
+        const bool right = x < bounds.maxX && costs[cell + 1] != BLOCKED;
+        const bool up = y > bounds.minY && costs[cell - width] != BLOCKED;
+        const bool down = y < bounds.maxY && costs[cell + width] != BLOCKED;
+        if (left) visit(-1, 0, 1.0f);
+        if (right) visit(1, 0, 1.0f);
+        if (up) visit(0, -1, 1.0f);
+        if (down) visit(0, 1, 1.0f);
+        if (left && up && costs[cell - width - 1] != BLOCKED) visit(-1, -1, DIAGONAL_COST);
+        if (right && up && costs[cell - width + 1] != BLOCKED) visit(1, -1, DIAGONAL_COST);
+        if (left && down && costs[cell + width - 1] != BLOCKED) visit(-1, 1, DIAGONAL_COST);
+        if (right && down && costs[cell + width + 1] != BLOCKED) visit(1, 1, DIAGONAL_COST);
+    }
+}
+
+const FlowField::Tile* FlowField::resolveTile(int sector) {
+    if (seeds.empty()) return nullptr;
+    
+    float base = INFINITE_COST;
+    for (const Seed& seed : seeds) {
+        base = std::min(base, seed.cost);
+    }
+    sectorOffsets[sector] = base;
+    
+    key.clear();
+    key.push_back(sector);
+    key.push_back(static_cast<int32_t>(sectorRevisions[sector]));
+    for (Seed& seed : seeds) {
+        const int32_t quantized =
+            static_cast<int32_t>(std::lround((seed.cost - base) * COST_QUANTUM));
+        key.push_back(localIndex(sector, seed.cell) * 16 + seed.direction);
+        key.push_back(quantized);
+        // Integrated from the rounded costs, so the tile is the same whichever goal built it
+        seed.cost = static_cast<float>(quantized) / COST_QUANTUM;
+    }
+    
+    auto found = tiles.find(key);
+    if (found != tiles.end()) {
+        found->second.lastUsed = fieldGeneration;
+        ++stats.tilesReused;
+        return &found->second;
+    }
+    
+    const GridRect& bounds = sectorBounds[sector];
+    const int localWidth = bounds.maxX - bounds.minX + 1;
+    integrate(bounds);
+    
+    Tile& tile = tiles[key];
+    tile.lastUsed = fieldGeneration;
+    const size_t cellCount = static_cast<size_t>(localWidth) * (bounds.maxY - bounds.minY + 1);
+    tile.directions.resize(cellCount);
+    tile.costs.resize(cellCount);
+    for (size_t local = 0; local < cellCount; ++local) {
+        const SearchNodeState& state = localStates[local];
+        if (state.generation != localGeneration) {
+            tile.directions[local] = NO_DIRECTION;
+            tile.costs[local] = INFINITE_COST;
+            continue;
+        }
+        if (state.parent >= 0) {
+            const int here = static_cast<int>(local);
+            tile.directions[local] = directionCode(state.parent % localWidth - here % localWidth,
+                                                   state.parent / localWidth - here / localWidth);
+        } else {
+            tile.directions[local] = static_cast<uint8_t>(-1 - state.parent);
+        }
+        tile.costs[local] = state.gCost;
+    }
+    ++stats.tilesBuilt;
+    return &tile;
+}
+
+void FlowField::offerNeighbors(int sector) {
+    // Rounding moves costs by up to half a quantum, so smaller gains are not worth a revisit
+    const float margin = 1.0f / COST_QUANTUM;
+    for (int side = 0; side < 4; ++side) {
+        const int neighbor = neighborSector(sector, side);
+        if (neighbor < 0) continue;
+        
+        float best = INFINITE_COST;
+        forEachCrossing(neighbor, (side + 2) % 4, [&](int32_t inside, int32_t outside,
+                                                      float length, uint8_t) {
+            const float through = fieldCost(sector, outside);
+            if (through == INFINITE_COST) return;
+            const float cost = through + length * costs[outside];
+            if (cost < fieldCost(neighbor, inside) - margin) {
+                best = std::min(best, cost);
             }
+        });
+        if (best == INFINITE_COST) continue;
+        
+        SearchNodeState& state = sectorStates[neighbor];
+        if (state.generation != fieldGeneration || state.heapIndex == SearchNodeState::CLOSED) {
+            state.generation = fieldGeneration;
+            state.gCost = best;
+            sectorOpen.push(neighbor, best, 0.0f);
+        } else if (best < state.gCost) {
+            state.gCost = best;
+            sectorOpen.decreaseKey(neighbor, best);
         }
     }
 }
 
+void FlowField::evictTiles() {
+    const size_t limit = std::max(maxCachedTiles, sectorTiles.size());
+    if (tiles.size() <= limit) return;
+    
+    // Tiles touched by the current field are never evicted; the rest go oldest first
+    std::vector<uint32_t> ages;
+    for (const auto& entry : tiles) {
+        if (entry.second.lastUsed != fieldGeneration) {
+            ages.push_back(fieldGeneration - entry.second.lastUsed);
+        }
+    }
+    size_t excess = std::min(tiles.size() - limit, ages.size());
+    if (excess == 0) return;
+    std::nth_element(ages.begin(), ages.begin() + (excess - 1), ages.end(),
+                     std::greater<uint32_t>());
+    const uint32_t threshold = ages[excess - 1];
+    for (auto it = tiles.begin(); it != tiles.end() && excess > 0;) {
+        if (it->second.lastUsed != fieldGeneration &&
+            fieldGeneration - it->second.lastUsed >= threshold) {
+            it = tiles.erase(it);
+            --excess;
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FlowField::generateField(const Math::Vector2D& goal) {
+    stats.sectorVisits = 0;
+    stats.tilesBuilt = 0;
+    stats.tilesReused = 0;
+    stats.sectorsRepaired = 0;
+    repair();
+    
+    if (++fieldGeneration == 0) {
+        for (auto& state : sectorStates) {
+            state.generation = 0;
+        }
+        for (auto& entry : tiles) {
+            entry.second.lastUsed = 0;
+        }
+        fieldGeneration = 1;
+    }
+    hasGoal = false;
+    std::fill(sectorTiles.begin(), sectorTiles.end(), nullptr);
+    std::fill(sectorOffsets.begin(), sectorOffsets.end(), INFINITE_COST);
+    
+    const int goalX = static_cast<int>(std::floor(goal.x));
+    const int goalY = static_cast<int>(std::floor(goal.y));
+    if (!grid->inBounds(goalX, goalY)) return;
+    const int32_t goalCell = goalY * grid->getWidth() + goalX;
+    if (costs[goalCell] == BLOCKED) return;
+    
+    // Sectors are finished cheapest entry first; a sector comes back if a neighbour finished
+    // later offers a cheaper way in
+    const int goalSector = sectorOf(goalX, goalY);
+    sectorOpen.clear();
+    sectorStates[goalSector] = {fieldGeneration, -1, 0.0f, 0};
+    sectorOpen.push(goalSector, 0.0f, 0.0f);
+    while (!sectorOpen.empty()) {
+        const int sector = sectorOpen.pop();
+        ++stats.sectorVisits;
+        gatherSeeds(sector, goalCell);
+        sectorTiles[sector] = resolveTile(sector);
+        if (sectorTiles[sector]) {
+            offerNeighbors(sector);
+        }
+    }
+    hasGoal = true;
+    
+    evictTiles();
+    stats.cachedTiles = tiles.size();
+}
+
 Math::Vector2D FlowField::getDirection(const Math::Vector2D& position) const {
-    int x = static_cast<int>(position.x);
-    int y = static_cast<int>(position.y);
+    const int x = static_cast<int>(std::floor(position.x));
+    const int y = static_cast<int>(std::floor(position.y));
+    if (!hasGoal || !grid->inBounds(x, y)) return Math::Vector2D(0, 0);
     
-    if (!grid->inBounds(x, y)) return Math::Vector2D(0, 0);
+    const int sector = sectorOf(x, y);
+    const Tile* tile = sectorTiles[sector];
+    if (!tile) return Math::Vector2D(0, 0);
     
-    return flowField[y * grid->getWidth() + x];
+    const uint8_t code = tile->directions[localIndex(sector, y * grid->getWidth() + x)];
+    if (code == NO_DIRECTION) return Math::Vector2D(0, 0);
+    const float scale = (code & 1) ? DIAGONAL_UNIT : 1.0f;
+    return Math::Vector2D(DIRECTION_X[code] * scale, DIRECTION_Y[code] * scale);
 }
 
 float FlowField::getCost(int x, int y) const {
-    if (!grid->inBounds(x, y)) return std::numeric_limits<float>::max();
-    return costField[y * grid->getWidth() + x];
+    if (!hasGoal || !grid->inBounds(x, y)) return std::numeric_limits<float>::max();
+    const float cost = fieldCost(sectorOf(x, y), y * grid->getWidth() + x);
+    return cost == INFINITE_COST ? std::numeric_limits<float>::max() : cost;
+}
+
+FlowField::Statistics FlowField::getStatistics() const {
+    return stats;
 }
 
 } // namespace AI
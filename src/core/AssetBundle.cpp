@@ -0,0 +1,866 @@
+#include "core/AssetBundle.h"
+#include "threading/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <unordered_set>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define JJM_BUNDLE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace JJM {
+namespace Core {
+
+namespace {
+
+// FNV-1a
+uint32_t checksum(const uint8_t* data, size_t size, uint32_t hash = 2166136261u) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+size_t alignUp(size_t value) {
+    return (value + BundleHeader::ALIGNMENT - 1) / BundleHeader::ALIGNMENT *
+           BundleHeader::ALIGNMENT;
+}
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// ============================================================================
+// LZ4 block format: sequences of a token (literal count, match length - 4), literals, a
+// 16-bit match offset and length extensions. The last 5 bytes are always literals and the
+// last match starts at least 12 bytes before the end, as the format requires
+// ============================================================================
+
+const size_t MIN_MATCH = 4;
+const size_t LAST_LITERALS = 5;
+const size_t MATCH_LIMIT = 12;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 12;
+
+void writeLength(std::vector<uint8_t>& out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+void writeSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount,
+                   size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength - MIN_MATCH;
+    out.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) |
+                                       std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) writeLength(out, literalCount - 15);
+    out.insert(out.end(), literals, literals + literalCount);
+    out.push_back(static_cast<uint8_t>(offset & 0xFF));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+// Greedy: one hash table of the last position of each 4-byte sequence
+void compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    uint32_t table[1 << HASH_BITS];
+    std::memset(table, 0, sizeof(table));  // Positions + 1; 0 is empty
+
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + MATCH_LIMIT < size) {
+        uint32_t sequence = read32(src + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - HASH_BITS);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET ||
+            read32(src + candidate - 1) != sequence) {
+            i++;
+            continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        size_t maxLength = size - LAST_LITERALS - i;
+        while (length < maxLength && src[match + length] == src[i + length]) {
+            length++;
+        }
+        writeSequence(out, src + anchor, i - anchor, i - match, length);
+        i += length;
+        anchor = i;
+    }
+
+    size_t literalCount = size - anchor;
+    out.push_back(static_cast<uint8_t>(std::min<size_t>(literalCount, 15) << 4));
+    if (literalCount >= 15) writeLength(out, literalCount - 15);
+    out.insert(out.end(), src + anchor, src + size);
+}
+
+bool readLength(const uint8_t* src, size_t size, size_t& position, size_t& length) {
+    uint8_t byte;
+    do {
+        if (position >= size) return false;
+        byte = src[position++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Bounds-checked; fails unless the block decodes to exactly size bytes
+bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    size_t in = 0, out = 0;
+    while (in < srcSize) {
+        uint8_t token = src[in++];
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(src, srcSize, in, literalCount)) return false;
+        if (literalCount > srcSize - in || literalCount > dstSize - out) return false;
+        std::memcpy(dst + out, src + in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        if (in == srcSize) break;  // Last sequence has no match
+
+        if (srcSize - in < 2) return false;
+        size_t offset = src[in] | (static_cast<size_t>(src[in + 1]) << 8);
+        in += 2;
+        if (offset == 0 || offset > out) return false;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(src, srcSize, in, length)) return false;
+        length += MIN_MATCH;
+        if (length > dstSize - out) return false;
+
+        // Overlapping copies repeat the last offset bytes
+        const uint8_t* match = dst + out - offset;
+        if (offset >= length) {
+            std::memcpy(dst + out, match, length);
+        } else {
+            for (size_t k = 0; k < length; k++) {
+                dst[out + k] = match[k];
+            }
+        }
+        out += length;
+    }
+    return out == dstSize;
+}
+
+// ============================================================================
+// Table of contents encoding, little-endian
+// ============================================================================
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void put64(std::vector<uint8_t>& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void putString(std::vector<uint8_t>& out, const std::string& value) {
+    put32(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+// Reads fail softly: past the end they return zeros and clear ok
+struct TocReader {
+    const uint8_t* data;
+    size_t size;
+    size_t position;
+    bool ok;
+
+    uint64_t get(int bytes) {
+        if (size - position < static_cast<size_t>(bytes)) {
+            ok = false;
+            position = size;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; i++) {
+            value |= static_cast<uint64_t>(data[position + i]) << (8 * i);
+        }
+        position += bytes;
+        return value;
+    }
+    uint32_t get32() { return static_cast<uint32_t>(get(4)); }
+    uint64_t get64() { return get(8); }
+    std::string getString() {
+        uint32_t length = get32();
+        if (size - position < length) {
+            ok = false;
+            position = size;
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+        return value;
+    }
+};
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0);
+    data.resize(static_cast<size_t>(size));
+    return size == 0 || file.read(reinterpret_cast<char*>(data.data()), size).good();
+}
+
+}  // namespace
+
+// ============================================================================
+// AssetBundle
+// ============================================================================
+
+AssetBundle::AssetBundle() {}
+
+AssetBundle::~AssetBundle() {
+    unload();
+}
+
+bool AssetBundle::loadFromFile(const std::string& filepath) {
+    unload();
+
+#if defined(JJM_BUNDLE_MMAP)
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "AssetBundle: Failed to open " << filepath << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(BundleHeader::FIXED_SIZE)) {
+        std::cerr << "AssetBundle: Not a bundle: " << filepath << std::endl;
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE,
+                         fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "AssetBundle: Failed to map " << filepath << std::endl;
+        return false;
+    }
+    mappedData = static_cast<uint8_t*>(mapping);
+    mappedSize = static_cast<size_t>(info.st_size);
+    fileMapped = true;
+#else
+    if (!readFile(filepath, ownedData)) {
+        std::cerr << "AssetBundle: Failed to open " << filepath << std::endl;
+        return false;
+    }
+    mappedData = ownedData.data();
+    mappedSize = ownedData.size();
+#endif
+
+    bundlePath = filepath;
+    if (!parseTableOfContents()) {
+        std::cerr << "AssetBundle: Invalid bundle: " << filepath << std::endl;
+        unload();
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+bool AssetBundle::loadFromMemory(const uint8_t* data, size_t size) {
+    unload();
+    ownedData.assign(data, data + size);
+    mappedData = ownedData.data();
+    mappedSize = ownedData.size();
+    if (!parseTableOfContents()) {
+        unload();
+        return false;
+    }
+    loaded = true;
+    return true;
+}
+
+void AssetBundle::unload() {
+#if defined(JJM_BUNDLE_MMAP)
+    if (fileMapped) {
+        munmap(mappedData, mappedSize);
+    }
+#endif
+    mappedData = nullptr;
+    mappedSize = 0;
+    fileMapped = false;
+    ownedData.clear();
+    ownedData.shrink_to_fit();
+    assets.clear();
+    chunks.clear();
+    header = BundleHeader();
+    bundlePath.clear();
+    loaded = false;
+}
+
+bool AssetBundle::parseTableOfContents() {
+    if (mappedSize < BundleHeader::FIXED_SIZE) return false;
+
+    TocReader fixed{mappedData, BundleHeader::FIXED_SIZE, 0, true};
+    header.magic = fixed.get32();
+    header.version = fixed.get32();
+    header.assetCount = fixed.get32();
+    header.compression = fixed.get32();
+    header.headerChecksum = fixed.get32();
+    header.contentChecksum = fixed.get32();
+    header.chunkCount = fixed.get32();
+    fixed.get32();
+    header.tocOffset = fixed.get64();
+    header.tocSize = fixed.get64();
+    header.dataOffset = fixed.get64();
+    header.totalSize = fixed.get64();
+    if (!header.isValid() || header.totalSize != mappedSize ||
+        header.tocOffset < BundleHeader::FIXED_SIZE || header.tocOffset > mappedSize ||
+        header.tocSize > mappedSize - header.tocOffset ||
+        header.dataOffset < header.tocOffset + header.tocSize || header.dataOffset > mappedSize) {
+        return false;
+    }
+    header.headerSize = header.tocOffset + header.tocSize;
+
+    const uint8_t* toc = mappedData + header.tocOffset;
+    if (checksum(toc, header.tocSize) != header.headerChecksum) return false;
+
+    TocReader reader{toc, header.tocSize, 0, true};
+    header.uncompressedSize = reader.get64();
+    header.bundleName = reader.getString();
+    header.buildTime = reader.getString();
+    header.platform = reader.getString();
+    header.buildTag = reader.getString();
+
+    // Counts are bounded by the smallest encoding of an entry before anything is allocated
+    if (header.assetCount > header.tocSize / 64 || header.chunkCount > header.tocSize / 16) {
+        return false;
+    }
+    assets.reserve(header.assetCount);
+    for (uint32_t i = 0; i < header.assetCount && reader.ok; i++) {
+        BundleAssetEntry entry;
+        entry.assetId = reader.getString();
+        entry.assetType = reader.getString();
+        entry.originalPath = reader.getString();
+        entry.offset = reader.get64();
+        entry.compressedSize = reader.get64();
+        entry.uncompressedSize = reader.get64();
+        entry.checksum = reader.get32();
+        entry.version = reader.get32();
+        entry.compression = static_cast<BundleCompression>(reader.get32());
+        entry.firstChunk = reader.get32();
+        entry.chunkCount = reader.get32();
+        uint32_t metadataCount = reader.get32();
+        for (uint32_t m = 0; m < metadataCount && reader.ok; m++) {
+            std::string key = reader.getString();
+            entry.metadata[key] = reader.getString();
+        }
+        uint32_t dependencyCount = reader.get32();
+        for (uint32_t d = 0; d < dependencyCount && reader.ok; d++) {
+            entry.dependencies.push_back(reader.getString());
+        }
+
+        bool inBounds = entry.offset >= header.dataOffset && entry.offset <= mappedSize &&
+                        entry.compressedSize <= mappedSize - entry.offset;
+        bool stored = entry.compression == BundleCompression::None &&
+                      entry.compressedSize == entry.uncompressedSize && entry.chunkCount == 0;
+        bool chunked = entry.compression == BundleCompression::LZ4 &&
+                       entry.firstChunk <= header.chunkCount &&
+                       entry.chunkCount <= header.chunkCount - entry.firstChunk;
+        if (!inBounds || !(stored || chunked)) return false;
+        std::string id = entry.assetId;
+        assets[id] = std::move(entry);
+    }
+
+    chunks.resize(reader.ok ? header.chunkCount : 0);
+    for (ChunkEntry& chunk : chunks) {
+        chunk.offset = reader.get64();
+        chunk.compressedSize = reader.get32();
+        chunk.uncompressedSize = reader.get32();
+        if (chunk.offset < header.dataOffset || chunk.offset > mappedSize ||
+            chunk.compressedSize > mappedSize - chunk.offset ||
+            chunk.uncompressedSize > BundleHeader::CHUNK_SIZE ||
+            chunk.compressedSize > chunk.uncompressedSize) {
+            return false;
+        }
+    }
+    if (!reader.ok || assets.size() != header.assetCount) return false;
+
+    // A compressed asset's chunks must add up to it
+    for (const auto& pair : assets) {
+        const BundleAssetEntry& entry = pair.second;
+        if (entry.compression != BundleCompression::LZ4) continue;
+        size_t total = 0;
+        for (uint32_t c = 0; c < entry.chunkCount; c++) {
+            total += chunks[entry.firstChunk + c].uncompressedSize;
+        }
+        if (total != entry.uncompressedSize) return false;
+    }
+    return true;
+}
+
+bool AssetBundle::hasAsset(const std::string& assetId) const {
+    return assets.find(assetId) != assets.end();
+}
+
+const BundleAssetEntry* AssetBundle::getAssetEntry(const std::string& assetId) const {
+    auto it = assets.find(assetId);
+    return it != assets.end() ? &it->second : nullptr;
+}
+
+std::vector<std::string> AssetBundle::getAssetIds() const {
+    std::vector<std::string> ids;
+    ids.reserve(assets.size());
+    for (const auto& pair : assets) {
+        ids.push_back(pair.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<std::string> AssetBundle::getAssetIdsByType(const std::string& type) const {
+    std::vector<std::string> ids;
+    for (const auto& pair : assets) {
+        if (pair.second.assetType == type) {
+            ids.push_back(pair.first);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+BundleAssetView AssetBundle::getAssetView(const std::string& assetId) const {
+    const BundleAssetEntry* entry = getAssetEntry(assetId);
+    if (!entry || entry->compression != BundleCompression::None) {
+        return BundleAssetView();
+    }
+    return BundleAssetView{mappedData + entry->offset, entry->uncompressedSize};
+}
+
+bool AssetBundle::readChunk(const ChunkEntry& chunk, uint8_t* destination) const {
+    const uint8_t* source = mappedData + chunk.offset;
+    if (chunk.compressedSize == chunk.uncompressedSize) {
+        std::memcpy(destination, source, chunk.uncompressedSize);
+        return true;
+    }
+    return decompressBlock(source, chunk.compressedSize, destination, chunk.uncompressedSize);
+}
+
+bool AssetBundle::readAsset(const std::string& assetId, uint8_t* destination,
+                            size_t capacity) const {
+    const BundleAssetEntry* entry = getAssetEntry(assetId);
+    if (!entry || capacity < entry->uncompressedSize) return false;
+
+    if (entry->compression == BundleCompression::None) {
+        if (entry->uncompressedSize > 0) {
+            std::memcpy(destination, mappedData + entry->offset, entry->uncompressedSize);
+        }
+        return true;
+    }
+
+    const ChunkEntry* first = chunks.data() + entry->firstChunk;
+    if (!jobSystem || entry->chunkCount < 2) {
+        for (uint32_t c = 0; c < entry->chunkCount; c++) {
+            if (!readChunk(first[c], destination)) return false;
+            destination += first[c].uncompressedSize;
+        }
+        return true;
+    }
+
+    // Chunks are independent, one job each
+    std::atomic<bool> ok(true);
+    Threading::JobCounter counter;
+    for (uint32_t c = 0; c < entry->chunkCount; c++) {
+        const ChunkEntry* chunk = first + c;
+        jobSystem->dispatch(
+            [this, chunk, destination, &ok]() {
+                if (!readChunk(*chunk, destination)) {
+                    ok.store(false, std::memory_order_relaxed);
+                }
+            },
+            counter);
+        destination += chunk->uncompressedSize;
+    }
+    jobSystem->wait(counter);
+    return ok.load();
+}
+
+std::vector<uint8_t> AssetBundle::decompressData(const BundleAssetEntry& entry) const {
+    std::vector<uint8_t> data(entry.uncompressedSize);
+    if (!readAsset(entry.assetId, data.data(), data.size())) {
+        std::cerr << "AssetBundle: Corrupt asset " << entry.assetId << " in " << bundlePath
+                  << std::endl;
+        data.clear();
+    }
+    return data;
+}
+
+std::vector<uint8_t> AssetBundle::getAssetData(const std::string& assetId) {
+    const BundleAssetEntry* entry = getAssetEntry(assetId);
+    if (!entry) return std::vector<uint8_t>();
+
+    if (entry->compression == BundleCompression::None) {
+        const uint8_t* data = mappedData + entry->offset;
+        return std::vector<uint8_t>(data, data + entry->uncompressedSize);
+    }
+    return decompressData(*entry);
+}
+
+std::future<std::vector<uint8_t>> AssetBundle::getAssetDataAsync(const std::string& assetId) {
+    return std::async(std::launch::async, [this, assetId]() { return getAssetData(assetId); });
+}
+
+std::vector<std::string> AssetBundle::getDependencies(const std::string& assetId) const {
+    const BundleAssetEntry* entry = getAssetEntry(assetId);
+    return entry ? entry->dependencies : std::vector<std::string>();
+}
+
+std::vector<std::string> AssetBundle::getAllDependencies() const {
+    std::unordered_set<std::string> unique;
+    for (const auto& pair : assets) {
+        unique.insert(pair.second.dependencies.begin(), pair.second.dependencies.end());
+    }
+    std::vector<std::string> dependencies(unique.begin(), unique.end());
+    std::sort(dependencies.begin(), dependencies.end());
+    return dependencies;
+}
+
+bool AssetBundle::validateChecksum() const {
+    if (!loaded) return false;
+    return checksum(mappedData + header.tocOffset, header.tocSize) == header.headerChecksum &&
+           checksum(mappedData + header.dataOffset, mappedSize - header.dataOffset) ==
+               header.contentChecksum;
+}
+
+bool AssetBundle::validateAsset(const std::string& assetId) const {
+    const BundleAssetEntry* entry = getAssetEntry(assetId);
+    if (!entry) return false;
+    if (entry->compression == BundleCompression::None) {
+        return checksum(mappedData + entry->offset, entry->uncompressedSize) == entry->checksum;
+    }
+    std::vector<uint8_t> data = decompressData(*entry);
+    return data.size() == entry->uncompressedSize &&
+           checksum(data.data(), data.size()) == entry->checksum;
+}
+
+// ============================================================================
+// BundleBuilder
+// ============================================================================
+
+BundleBuilder::BundleBuilder() {}
+
+BundleBuilder::~BundleBuilder() {}
+
+void BundleBuilder::setCompression(BundleCompression value, int level) {
+    if (value != BundleCompression::None && value != BundleCompression::LZ4) {
+        std::cerr << "BundleBuilder: Only LZ4 compression is built in, using LZ4" << std::endl;
+        value = BundleCompression::LZ4;
+    }
+    compression = value;
+    compressionLevel = level;
+}
+
+BundleBuilder::PendingAsset* BundleBuilder::findPending(const std::string& assetId) {
+    for (PendingAsset& asset : pendingAssets) {
+        if (asset.assetId == assetId) return &asset;
+    }
+    return nullptr;
+}
+
+void BundleBuilder::addAsset(const std::string& assetId, const std::string& filepath,
+                             const std::string& type) {
+    addAssetWithMetadata(assetId, filepath, type, {});
+}
+
+void BundleBuilder::addAsset(const std::string& assetId, const std::vector<uint8_t>& data,
+                             const std::string& type) {
+    removeAsset(assetId);
+    PendingAsset asset;
+    asset.assetId = assetId;
+    asset.type = type;
+    asset.data = data;
+    asset.hasFileData = true;
+    pendingAssets.push_back(std::move(asset));
+}
+
+void BundleBuilder::addAssetWithMetadata(
+    const std::string& assetId, const std::string& filepath, const std::string& type,
+    const std::unordered_map<std::string, std::string>& metadata) {
+    removeAsset(assetId);
+    PendingAsset asset;
+    asset.assetId = assetId;
+    asset.filepath = filepath;
+    asset.type = type;
+    asset.metadata = metadata;
+    pendingAssets.push_back(std::move(asset));
+}
+
+void BundleBuilder::removeAsset(const std::string& assetId) {
+    pendingAssets.erase(std::remove_if(pendingAssets.begin(), pendingAssets.end(),
+                                       [&](const PendingAsset& asset) {
+                                           return asset.assetId == assetId;
+                                       }),
+                        pendingAssets.end());
+}
+
+void BundleBuilder::clearAssets() {
+    pendingAssets.clear();
+}
+
+void BundleBuilder::addDependency(const std::string& assetId, const std::string& dependencyId) {
+    if (PendingAsset* asset = findPending(assetId)) {
+        asset->dependencies.push_back(dependencyId);
+    }
+}
+
+void BundleBuilder::setDependencies(const std::string& assetId,
+                                    const std::vector<std::string>& dependencies) {
+    if (PendingAsset* asset = findPending(assetId)) {
+        asset->dependencies = dependencies;
+    }
+}
+
+bool BundleBuilder::build(const std::string& outputPath) {
+    return writeBundle(outputPath, nullptr);
+}
+
+bool BundleBuilder::buildIncremental(const std::string& outputPath,
+                                     const std::string& previousBundlePath) {
+    AssetBundle previous;
+    if (!previous.loadFromFile(previousBundlePath)) {
+        return writeBundle(outputPath, nullptr);
+    }
+    return writeBundle(outputPath, &previous);
+}
+
+bool BundleBuilder::writeBundle(const std::string& outputPath, const AssetBundle* previous) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Assets are laid out in id order so builds are reproducible
+    std::vector<PendingAsset*> order;
+    for (PendingAsset& asset : pendingAssets) {
+        order.push_back(&asset);
+    }
+    std::sort(order.begin(), order.end(), [](const PendingAsset* a, const PendingAsset* b) {
+        return a->assetId < b->assetId;
+    });
+
+    struct Encoded {
+        BundleAssetEntry entry;
+        std::vector<uint8_t> stored;
+        std::vector<std::pair<uint32_t, uint32_t>> chunkSizes;  // Compressed, uncompressed
+    };
+    std::vector<Encoded> encoded(order.size());
+    std::vector<uint8_t> fileData, chunkData;
+    size_t totalUncompressed = 0, totalStored = 0;
+
+    for (size_t i = 0; i < order.size(); i++) {
+        const PendingAsset& asset = *order[i];
+        Encoded& out = encoded[i];
+        if (progressCallback) {
+            progressCallback(asset.assetId, static_cast<int>(i), static_cast<int>(order.size()));
+        }
+
+        const std::vector<uint8_t>* data = &asset.data;
+        if (!asset.hasFileData) {
+            if (!readFile(asset.filepath, fileData)) {
+                std::cerr << "BundleBuilder: Failed to read " << asset.filepath << std::endl;
+                return false;
+            }
+            data = &fileData;
+        }
+
+        BundleAssetEntry& entry = out.entry;
+        entry.assetId = asset.assetId;
+        entry.assetType = asset.type;
+        entry.originalPath = asset.filepath;
+        entry.uncompressedSize = data->size();
+        entry.checksum = checksum(data->data(), data->size());
+        entry.metadata = asset.metadata;
+        entry.dependencies = asset.dependencies;
+        totalUncompressed += data->size();
+
+        // Unchanged since the previous bundle: copy its compressed chunks as they are
+        const BundleAssetEntry* old = previous ? previous->getAssetEntry(asset.assetId) : nullptr;
+        bool reuse = old && compression != BundleCompression::None &&
+                     old->compression == BundleCompression::LZ4 &&
+                     old->checksum == entry.checksum &&
+                     old->uncompressedSize == entry.uncompressedSize;
+        if (reuse) {
+            for (uint32_t c = 0; c < old->chunkCount; c++) {
+                const AssetBundle::ChunkEntry& chunk = previous->chunks[old->firstChunk + c];
+                const uint8_t* source = previous->mappedData + chunk.offset;
+                out.stored.insert(out.stored.end(), source, source + chunk.compressedSize);
+                out.chunkSizes.emplace_back(chunk.compressedSize, chunk.uncompressedSize);
+            }
+            entry.compression = BundleCompression::LZ4;
+        } else if (compression != BundleCompression::None) {
+            // Chunks that do not shrink are kept as they are; an asset that does not shrink
+            // as a whole is stored uncompressed so it can be viewed in place
+            for (size_t first = 0; first < data->size(); first += BundleHeader::CHUNK_SIZE) {
+                size_t size = std::min(BundleHeader::CHUNK_SIZE, data->size() - first);
+                chunkData.clear();
+                compressBlock(data->data() + first, size, chunkData);
+                if (chunkData.size() >= size) {
+                    out.stored.insert(out.stored.end(), data->begin() + first,
+                                      data->begin() + first + size);
+                    out.chunkSizes.emplace_back(static_cast<uint32_t>(size),
+                                                static_cast<uint32_t>(size));
+                } else {
+                    out.stored.insert(out.stored.end(), chunkData.begin(), chunkData.end());
+                    out.chunkSizes.emplace_back(static_cast<uint32_t>(chunkData.size()),
+                                                static_cast<uint32_t>(size));
+                }
+            }
+            entry.compression = BundleCompression::LZ4;
+            if (out.stored.size() >= data->size()) {
+                out.chunkSizes.clear();
+                entry.compression = BundleCompression::None;
+            }
+        }
+        if (entry.compression == BundleCompression::None) {
+            out.stored = *data;
+        }
+        entry.compressedSize = out.stored.size();
+        totalStored += out.stored.size();
+    }
+
+    BundleHeader bundleHeader;
+    bundleHeader.assetCount = static_cast<uint32_t>(encoded.size());
+    bundleHeader.compression = static_cast<uint32_t>(compression);
+    bundleHeader.uncompressedSize = totalUncompressed;
+    bundleHeader.bundleName = bundleName;
+    bundleHeader.platform = targetPlatform;
+    bundleHeader.buildTag = buildTag;
+    std::time_t now = std::time(nullptr);
+    char timeText[32];
+    std::strftime(timeText, sizeof(timeText), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    bundleHeader.buildTime = timeText;
+
+    // Offsets are fixed width, so the table's size is known before they are: lay out the
+    // data after a first pass, then write the table again with the real offsets
+    std::vector<uint8_t> toc;
+    auto writeToc = [&]() {
+        toc.clear();
+        put64(toc, bundleHeader.uncompressedSize);
+        putString(toc, bundleHeader.bundleName);
+        putString(toc, bundleHeader.buildTime);
+        putString(toc, bundleHeader.platform);
+        putString(toc, bundleHeader.buildTag);
+        for (const Encoded& out : encoded) {
+            const BundleAssetEntry& entry = out.entry;
+            putString(toc, entry.assetId);
+            putString(toc, entry.assetType);
+            putString(toc, entry.originalPath);
+            put64(toc, entry.offset);
+            put64(toc, entry.compressedSize);
+            put64(toc, entry.uncompressedSize);
+            put32(toc, entry.checksum);
+            put32(toc, entry.version);
+            put32(toc, static_cast<uint32_t>(entry.compression));
+            put32(toc, entry.firstChunk);
+            put32(toc, entry.chunkCount);
+            put32(toc, static_cast<uint32_t>(entry.metadata.size()));
+            for (const auto& pair : entry.metadata) {
+                putString(toc, pair.first);
+                putString(toc, pair.second);
+            }
+            put32(toc, static_cast<uint32_t>(entry.dependencies.size()));
+            for (const std::string& dependency : entry.dependencies) {
+                putString(toc, dependency);
+            }
+        }
+        for (const Encoded& out : encoded) {
+            size_t offset = out.entry.offset;
+            for (const auto& sizes : out.chunkSizes) {
+                put64(toc, offset);
+                put32(toc, sizes.first);
+                put32(toc, sizes.second);
+                offset += sizes.first;
+            }
+        }
+    };
+
+    uint32_t chunkCount = 0;
+    for (Encoded& out : encoded) {
+        out.entry.firstChunk = out.chunkSizes.empty() ? 0 : chunkCount;
+        out.entry.chunkCount = static_cast<uint32_t>(out.chunkSizes.size());
+        chunkCount += out.entry.chunkCount;
+    }
+    bundleHeader.chunkCount = chunkCount;
+    writeToc();
+    bundleHeader.tocOffset = BundleHeader::FIXED_SIZE;
+    bundleHeader.tocSize = toc.size();
+    bundleHeader.dataOffset = alignUp(bundleHeader.tocOffset + bundleHeader.tocSize);
+    size_t position = bundleHeader.dataOffset;
+    for (Encoded& out : encoded) {
+        out.entry.offset = position;
+        position = alignUp(position + out.stored.size());
+    }
+    bundleHeader.totalSize = position;
+    writeToc();
+    bundleHeader.headerChecksum = checksum(toc.data(), toc.size());
+
+    // Asset data, zero padded between assets
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "BundleBuilder: Failed to create " << outputPath << std::endl;
+        return false;
+    }
+    static const uint8_t zeros[BundleHeader::ALIGNMENT] = {};
+    std::vector<uint8_t> fixed(BundleHeader::FIXED_SIZE);
+    file.write(reinterpret_cast<const char*>(fixed.data()), fixed.size());
+    file.write(reinterpret_cast<const char*>(toc.data()), toc.size());
+    file.write(reinterpret_cast<const char*>(zeros),
+               bundleHeader.dataOffset - bundleHeader.tocOffset - bundleHeader.tocSize);
+    uint32_t contentChecksum = 2166136261u;
+    for (const Encoded& out : encoded) {
+        size_t padding = alignUp(out.stored.size()) - out.stored.size();
+        file.write(reinterpret_cast<const char*>(out.stored.data()), out.stored.size());
+        file.write(reinterpret_cast<const char*>(zeros), padding);
+        contentChecksum = checksum(out.stored.data(), out.stored.size(), contentChecksum);
+        contentChecksum = checksum(zeros, padding, contentChecksum);
+    }
+    bundleHeader.contentChecksum = contentChecksum;
+
+    fixed.clear();
+    put32(fixed, bundleHeader.magic);
+    put32(fixed, bundleHeader.version);
+    put32(fixed, bundleHeader.assetCount);
+    put32(fixed, bundleHeader.compression);
+    put32(fixed, bundleHeader.headerChecksum);
+    put32(fixed, bundleHeader.contentChecksum);
+    put32(fixed, bundleHeader.chunkCount);
+    put32(fixed, 0);
+    put64(fixed, bundleHeader.tocOffset);
+    put64(fixed, bundleHeader.tocSize);
+    put64(fixed, bundleHeader.dataOffset);
+    put64(fixed, bundleHeader.totalSize);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(fixed.data()), fixed.size());
+    file.close();
+    if (!file) {
+        std::cerr << "BundleBuilder: Failed to write " << outputPath << std::endl;
+        return false;
+    }
+
+    lastStats.totalAssets = encoded.size();
+    lastStats.totalUncompressedSize = totalUncompressed;
+    lastStats.totalCompressedSize = totalStored;
+    lastStats.compressionRatio =
+        totalUncompressed > 0 ? static_cast<float>(totalStored) / totalUncompressed : 1.0f;
+    lastStats.buildTimeSeconds = std::chrono::duration<float>(
+                                     std::chrono::steady_clock::now() - startTime)
+                                     .count();
+    return true;
+}
+
+}  // namespace Core
+}  // namespace JJM
@@ -0,0 +1,242 @@
+#include "ecs/ArchetypeStorage.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ecs/Entity.h"
+
+namespace JJM {
+namespace ECS {
+
+namespace {
+
+struct TypeRegistryData {
+    std::mutex mutex;
+    std::unordered_map<std::type_index, ComponentTypeID> ids;
+    std::vector<std::unique_ptr<IComponentColumn>> prototypes;
+};
+
+TypeRegistryData& registryData() {
+    static TypeRegistryData data;
+    return data;
+}
+
+}  // namespace
+
+// ComponentTypeRegistry implementation
+ComponentTypeID ComponentTypeRegistry::registerType(std::type_index type,
+                                                    std::unique_ptr<IComponentColumn> prototype) {
+    TypeRegistryData& data = registryData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+
+    auto it = data.ids.find(type);
+    if (it != data.ids.end()) {
+        // May have been registered from a query before its first instantiation
+        if (!data.prototypes[it->second]) {
+            data.prototypes[it->second] = std::move(prototype);
+        }
+        return it->second;
+    }
+
+    // Signatures are fixed-size bitsets, so a further type would have no bit to set
+    if (data.prototypes.size() >= MAX_COMPONENT_TYPES) {
+        throw std::length_error("ComponentTypeRegistry: too many component types");
+    }
+    ComponentTypeID id = static_cast<ComponentTypeID>(data.prototypes.size());
+    data.ids.emplace(type, id);
+    data.prototypes.push_back(std::move(prototype));
+    return id;
+}
+
+ComponentTypeID ComponentTypeRegistry::getOrRegister(std::type_index type) {
+    return registerType(type, nullptr);
+}
+
+ComponentTypeID ComponentTypeRegistry::find(std::type_index type) {
+    TypeRegistryData& data = registryData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    auto it = data.ids.find(type);
+    return it != data.ids.end() ? it->second : INVALID_COMPONENT_TYPE;
+}
+
+std::unique_ptr<IComponentColumn> ComponentTypeRegistry::createColumn(ComponentTypeID id) {
+    TypeRegistryData& data = registryData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return data.prototypes[id]->createEmpty();
+}
+
+size_t ComponentTypeRegistry::getTypeCount() {
+    TypeRegistryData& data = registryData();
+    std::lock_guard<std::mutex> lock(data.mutex);
+    return data.prototypes.size();
+}
+
+// Archetype implementation
+Archetype::Archetype(const ComponentMask& mask) : mask(mask) {
+    columnIndex.fill(-1);
+    for (ComponentTypeID type = 0; type < MAX_COMPONENT_TYPES; ++type) {
+        if (mask.test(type)) {
+            columnIndex[type] = static_cast<int>(columns.size());
+            types.push_back(type);
+            columns.push_back(ComponentTypeRegistry::createColumn(type));
+        }
+    }
+}
+
+// ArchetypeStorage implementation
+ArchetypeStorage::ArchetypeStorage() : emptyArchetype(nullptr) {
+    emptyArchetype = getOrCreateArchetype(ComponentMask());
+}
+
+ArchetypeStorage::~ArchetypeStorage() { clear(); }
+
+Archetype* ArchetypeStorage::getOrCreateArchetype(const ComponentMask& mask) {
+    auto it = archetypes.find(mask);
+    if (it != archetypes.end()) {
+        return it->second.get();
+    }
+
+    auto archetype = std::make_unique<Archetype>(mask);
+    Archetype* ptr = archetype.get();
+    archetypes.emplace(mask, std::move(archetype));
+    archetypeList.push_back(ptr);
+    return ptr;
+}
+
+Archetype* ArchetypeStorage::getAddTarget(Archetype* from, ComponentTypeID type) {
+    auto it = from->addEdges.find(type);
+    if (it != from->addEdges.end()) {
+        return it->second;
+    }
+
+    ComponentMask mask = from->mask;
+    mask.set(type);
+    Archetype* to = getOrCreateArchetype(mask);
+    from->addEdges[type] = to;
+    to->removeEdges[type] = from;
+    return to;
+}
+
+Archetype* ArchetypeStorage::getRemoveTarget(Archetype* from, ComponentTypeID type) {
+    auto it = from->removeEdges.find(type);
+    if (it != from->removeEdges.end()) {
+        return it->second;
+    }
+
+    ComponentMask mask = from->mask;
+    mask.reset(type);
+    Archetype* to = getOrCreateArchetype(mask);
+    from->removeEdges[type] = to;
+    to->addEdges[type] = from;
+    return to;
+}
+
+uint32_t ArchetypeStorage::appendRow(Archetype* archetype, Entity* entity,
+                                     EntityLocation* location) {
+    uint32_t row = static_cast<uint32_t>(archetype->entities.size());
+    archetype->entities.push_back(entity);
+    archetype->locations.push_back(location);
+    return row;
+}
+
+void ArchetypeStorage::releaseRow(Archetype* archetype, uint32_t row) {
+    for (auto& column : archetype->columns) {
+        column->swapRemove(row);
+    }
+
+    const uint32_t last = static_cast<uint32_t>(archetype->entities.size() - 1);
+    if (row != last) {
+        archetype->entities[row] = archetype->entities[last];
+        archetype->locations[row] = archetype->locations[last];
+        archetype->locations[row]->row = row;
+    }
+    archetype->entities.pop_back();
+    archetype->locations.pop_back();
+}
+
+void ArchetypeStorage::moveEntity(Entity* entity, EntityLocation& location, Archetype* to) {
+    Archetype* from = location.archetype;
+    const uint32_t newRow = appendRow(to, entity, &location);
+
+    if (from) {
+        for (size_t i = 0; i < to->types.size(); ++i) {
+            if (IComponentColumn* source = from->getColumn(to->types[i])) {
+                to->columns[i]->pushFrom(*source, location.row);
+            }
+        }
+        releaseRow(from, location.row);
+    }
+
+    location.archetype = to;
+    location.row = newRow;
+}
+
+void ArchetypeStorage::removeEntity(EntityLocation& location) {
+    Archetype* archetype = location.archetype;
+    if (!archetype) return;
+
+    for (auto& column : archetype->columns) {
+        column->at(location.row)->destroy();
+    }
+    releaseRow(archetype, location.row);
+
+    location.archetype = nullptr;
+    location.row = 0;
+}
+
+std::vector<Archetype*> ArchetypeStorage::getMatching(const ComponentMask& required,
+                                                      const ComponentMask& excluded) const {
+    std::vector<Archetype*> result;
+    for (Archetype* archetype : archetypeList) {
+        const ComponentMask& mask = archetype->mask;
+        if ((mask & required) == required && (mask & excluded).none()) {
+            result.push_back(archetype);
+        }
+    }
+    return result;
+}
+
+void ArchetypeStorage::updateComponents(float deltaTime) {
+    for (Archetype* archetype : archetypeList) {
+        if (archetype->empty() || archetype->columns.empty()) continue;
+
+        const size_t count = archetype->entities.size();
+        activeScratch.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            activeScratch[i] = archetype->entities[i]->isActive() ? 1 : 0;
+        }
+
+        for (auto& column : archetype->columns) {
+            column->update(deltaTime, activeScratch);
+        }
+    }
+}
+
+void ArchetypeStorage::clear() {
+    for (Archetype* archetype : archetypeList) {
+        for (auto& column : archetype->columns) {
+            for (size_t row = 0; row < column->size(); ++row) {
+                column->at(row)->destroy();
+            }
+        }
+        for (EntityLocation* location : archetype->locations) {
+            location->archetype = nullptr;
+            location->row = 0;
+        }
+    }
+
+    archetypes.clear();
+    archetypeList.clear();
+    emptyArchetype = getOrCreateArchetype(ComponentMask());
+}
+
+size_t ArchetypeStorage::getEntityCount() const {
+    size_t total = 0;
+    for (Archetype* archetype : archetypeList) {
+        total += archetype->size();
+    }
+    return total;
+}
+
+}  // namespace ECS
+}  // namespace JJM
@@ -6,9 +6,13 @@ namespace JJM {
 namespace ECS {
 
 Entity::Entity(EntityID id, EntityManager* manager) 
-    : id(id), manager(manager), active(true) {}
+    : id(id), manager(manager), active(true), storage(nullptr) {}
 
 Entity::~Entity() {
+    if (storage) {
+        storage->removeEntity(location);
+    }
+    
     for (auto& pair : components) {
         if (pair.second) {
             pair.second->destroy();
@@ -17,83 +21,41 @@ Entity::~Entity() {
     components.clear();
 }
 
-void Entity::destroy() {
-    active = false;
+void Entity::onSignatureChanged() {
     if (manager) {
-        manager->destroyEntity(this);
+        manager->onEntitySignatureChanged(this);
     }
 }
 
-template<typename T, typename... Args>
-T* Entity::addComponent(Args&&... args) {
-    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-    
-    std::type_index typeIndex(typeid(T));
-    
-    // Check if component already exists
-    if (components.find(typeIndex) != components.end()) {
-        return static_cast<T*>(components[typeIndex].get());
+void Entity::setActive(bool isActive) {
+    if (active && !isActive && manager) {
+        manager->onEntityDeactivated(this);
     }
-    
-    // Create new component
-    auto component = std::make_shared<T>(std::forward<Args>(args)...);
-    component->setOwner(this);
-    components[typeIndex] = component;
-    component->init();
-    
-    return component.get();
+    active = isActive;
 }
 
-template<typename T>
-T* Entity::getComponent() {
-    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-    
-    std::type_index typeIndex(typeid(T));
-    auto it = components.find(typeIndex);
-    
-    if (it != components.end()) {
-        return static_cast<T*>(it->second.get());
+void Entity::forEachComponent(const std::function<void(Component*)>& callback) const {
+    if (storage) {
+        Archetype* archetype = location.archetype;
+        if (!archetype) return;
+        for (ComponentTypeID type : archetype->getTypes()) {
+            callback(archetype->getColumn(type)->at(location.row));
+        }
+        return;
     }
-    
-    return nullptr;
-}
-
-template<typename T>
-const T* Entity::getComponent() const {
-    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-    
-    std::type_index typeIndex(typeid(T));
-    auto it = components.find(typeIndex);
-    
-    if (it != components.end()) {
-        return static_cast<const T*>(it->second.get());
+    for (const auto& pair : components) {
+        if (pair.second) {
+            callback(pair.second.get());
+        }
     }
-    
-    return nullptr;
-}
-
-template<typename T>
-bool Entity::hasComponent() const {
-    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-    
-    std::type_index typeIndex(typeid(T));
-    return components.find(typeIndex) != components.end();
 }
 
-template<typename T>
-void Entity::removeComponent() {
-    static_assert(std::is_base_of<Component, T>::value, "T must derive from Component");
-    
-    std::type_index typeIndex(typeid(T));
-    auto it = components.find(typeIndex);
-    
-    if (it != components.end()) {
-        it->second->destroy();
-        components.erase(it);
+void Entity::destroy() {
+    active = false;
+    if (manager) {
+        manager->destroyEntity(this);
     }
 }
 
-// Explicit template instantiations will be in the implementation files that use them
-
 } // namespace ECS
 } // namespace JJM
@@ -5,26 +5,93 @@
 namespace JJM {
 namespace ECS {
 
-EntityManager::EntityManager() : nextID(1) {}
+EntityManager::EntityManager() {}
 
 EntityManager::~EntityManager() { clear(); }
 
+bool EntityManager::setStorageMode(StorageMode mode) {
+    if (mode == storageMode) return true;
+    if (!entities.empty()) return false;
+
+    storageMode = mode;
+    if (mode == StorageMode::ARCHETYPE) {
+        archetypeStorage = std::make_unique<ArchetypeStorage>();
+    } else {
+        archetypeStorage.reset();
+    }
+    return true;
+}
+
 Entity* EntityManager::createEntity() {
-    auto entity = std::make_unique<Entity>(nextID++, this);
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+
+    EntitySlot& slot = slots[index];
+    slot.denseIndex = static_cast<uint32_t>(entities.size());
+
+    auto entity = std::make_unique<Entity>(makeEntityID(index, slot.generation), this);
     Entity* ptr = entity.get();
+    ptr->storage = archetypeStorage.get();
     entities.push_back(std::move(entity));
-    invalidateQueryCaches();
+    updateQueryMembership(ptr);
+    notifyObservers(ptr);
+
+    if (onEntityCreated) {
+        onEntityCreated(ptr);
+    }
     return ptr;
 }
 
+Entity* EntityManager::createEntity(const std::string& tag) {
+    Entity* entity = createEntity();
+    setEntityTag(entity, tag);
+    return entity;
+}
+
 void EntityManager::destroyEntity(EntityID id) {
-    auto it = std::find_if(entities.begin(), entities.end(),
-                           [id](const std::unique_ptr<Entity>& e) { return e->getID() == id; });
+    if (!isAlive(id)) return;
+
+    // Destroying while components are updating would reshuffle the dense array under the
+    // update loop
+    if (processingUpdate) {
+        destroyEntityDeferred(id);
+        return;
+    }
+
+    EntitySlot& slot = slots[getEntityIndex(id)];
+    const uint32_t dense = slot.denseIndex;
+    Entity* entity = entities[dense].get();
+
+    if (onEntityDestroyed) {
+        onEntityDestroyed(entity);
+    }
+    removeFromTagGroups(entity);
+    removeFromQueryCaches(entity);
+    removeFromObservers(entity);
+
+    // Swap-remove from the dense array and repoint the moved entity's slot
+    std::unique_ptr<Entity> doomed = std::move(entities[dense]);
+    const uint32_t last = static_cast<uint32_t>(entities.size() - 1);
+    if (dense != last) {
+        entities[dense] = std::move(entities[last]);
+        slots[getEntityIndex(entities[dense]->getID())].denseIndex = dense;
+    }
+    entities.pop_back();
 
-    if (it != entities.end()) {
-        entities.erase(it);
-        invalidateQueryCaches();
+    slot.denseIndex = INVALID_DENSE_INDEX;
+    if (++slot.generation == 0) {
+        slot.generation = 1;  // Keep 0 reserved so INVALID_ENTITY_ID never matches
     }
+    freeSlots.push_back(getEntityIndex(id));
+
+    // Run the destructor last so the tables are consistent if it re-enters the manager
+    doomed.reset();
 }
 
 void EntityManager::destroyEntity(Entity* entity) {
@@ -33,17 +100,155 @@ void EntityManager::destroyEntity(Entity* entity) {
     }
 }
 
+void EntityManager::destroyAllEntities() {
+    while (!entities.empty()) {
+        destroyEntity(entities.back()->getID());
+    }
+    entitiesToDestroy.clear();
+}
+
+void EntityManager::destroyEntitiesWithTag(const std::string& tag) {
+    std::vector<Entity*> tagged = getEntitiesWithTag(tag);
+    for (Entity* entity : tagged) {
+        destroyEntity(entity->getID());
+    }
+}
+
 Entity* EntityManager::getEntity(EntityID id) {
-    auto it = std::find_if(entities.begin(), entities.end(),
-                           [id](const std::unique_ptr<Entity>& e) { return e->getID() == id; });
+    if (!isAlive(id)) return nullptr;
+    return entities[slots[getEntityIndex(id)].denseIndex].get();
+}
 
-    if (it != entities.end()) {
-        return it->get();
+bool EntityManager::isAlive(EntityID id) const {
+    const uint32_t index = getEntityIndex(id);
+    return index < slots.size() && slots[index].generation == getEntityGeneration(id) &&
+           slots[index].denseIndex != INVALID_DENSE_INDEX;
+}
+
+void EntityManager::destroyEntityDeferred(EntityID id) {
+    if (isAlive(id)) {
+        entitiesToDestroy.push_back(id);
     }
+}
 
+void EntityManager::destroyEntityDeferred(Entity* entity) {
+    if (entity) {
+        destroyEntityDeferred(entity->getID());
+    }
+}
+
+void EntityManager::processDeferred() {
+    // Stale or duplicate IDs fail the generation check, so no dedup is needed
+    std::vector<EntityID> pending;
+    pending.swap(entitiesToDestroy);
+    for (EntityID id : pending) {
+        destroyEntity(id);
+    }
+}
+
+void EntityManager::setEntityTag(Entity* entity, const std::string& tag) {
+    if (entity && !tag.empty()) {
+        tagGroups[tag].addEntity(entity);
+        updateQueryMembership(entity);
+    }
+}
+
+void EntityManager::removeEntityTag(Entity* entity, const std::string& tag) {
+    auto it = tagGroups.find(tag);
+    if (it != tagGroups.end()) {
+        it->second.removeEntity(entity);
+        updateQueryMembership(entity);
+    }
+}
+
+bool EntityManager::entityHasTag(Entity* entity, const std::string& tag) const {
+    auto it = tagGroups.find(tag);
+    return it != tagGroups.end() && it->second.contains(entity);
+}
+
+std::vector<Entity*> EntityManager::getEntitiesWithTag(const std::string& tag) {
+    std::vector<Entity*> result;
+    auto it = tagGroups.find(tag);
+    if (it != tagGroups.end()) {
+        for (Entity* entity : it->second.getEntities()) {
+            if (entity->isActive()) {
+                result.push_back(entity);
+            }
+        }
+    }
+    return result;
+}
+
+Entity* EntityManager::getFirstEntityWithTag(const std::string& tag) {
+    auto it = tagGroups.find(tag);
+    if (it != tagGroups.end()) {
+        for (Entity* entity : it->second.getEntities()) {
+            if (entity->isActive()) {
+                return entity;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void EntityManager::removeFromTagGroups(Entity* entity) {
+    for (auto& pair : tagGroups) {
+        pair.second.removeEntity(entity);
+    }
+}
+
+std::vector<Entity*> EntityManager::query(const EntityFilter& filter) {
+    std::vector<Entity*> result;
+    forEach(filter, [&result](Entity* entity) { result.push_back(entity); });
+    return result;
+}
+
+Entity* EntityManager::queryFirst(const EntityFilter& filter) {
+    const QueryKey key = makeQueryKey(filter);
+    for (auto& entity : entities) {
+        if (matchesFilter(entity.get(), filter, key)) {
+            return entity.get();
+        }
+    }
     return nullptr;
 }
 
+void EntityManager::forEach(const EntityFilter& filter, std::function<void(Entity*)> callback) {
+    const QueryKey key = makeQueryKey(filter);
+    for (auto& entity : entities) {
+        if (matchesFilter(entity.get(), filter, key)) {
+            callback(entity.get());
+        }
+    }
+}
+
+EntityManager::QueryKey EntityManager::makeQueryKey(const EntityFilter& filter) const {
+    QueryKey key;
+    for (const auto& type : filter.requiredComponents) {
+        key.required.set(ComponentTypeRegistry::getOrRegister(type));
+    }
+    for (const auto& type : filter.excludedComponents) {
+        key.excluded.set(ComponentTypeRegistry::getOrRegister(type));
+    }
+    key.tag = filter.tag;
+    return key;
+}
+
+bool EntityManager::matchesKey(Entity* entity, const QueryKey& key) const {
+    const ComponentMask& signature = entity->getSignature();
+    if ((signature & key.required) != key.required || (signature & key.excluded).any()) {
+        return false;
+    }
+    return key.tag.empty() || entityHasTag(entity, key.tag);
+}
+
+bool EntityManager::matchesFilter(Entity* entity, const EntityFilter& filter,
+                                  const QueryKey& key) const {
+    if (filter.activeOnly && !entity->isActive()) return false;
+    if (!matchesKey(entity, key)) return false;
+    return !filter.customFilter || filter.customFilter(entity);
+}
+
 std::vector<Entity*> EntityManager::getAllEntities() {
     std::vector<Entity*> result;
     for (auto& entity : entities) {
@@ -54,63 +259,259 @@ std::vector<Entity*> EntityManager::getAllEntities() {
     return result;
 }
 
+size_t EntityManager::getActiveEntityCount() const {
+    size_t count = 0;
+    for (const auto& entity : entities) {
+        if (entity->isActive()) {
+            count++;
+        }
+    }
+    return count;
+}
+
 void EntityManager::update(float deltaTime) {
-    // Remove inactive entities
-    entities.erase(std::remove_if(entities.begin(), entities.end(),
-                                  [](const std::unique_ptr<Entity>& e) { return !e->isActive(); }),
-                   entities.end());
+    // Remove entities that were deactivated, as the old full scan for inactive entities
+    // did, but only visit the ones setActive(false) reported. An entity reactivated since
+    // then stays
+    std::vector<EntityID> deactivated;
+    deactivated.swap(deactivatedEntities);
+    for (EntityID id : deactivated) {
+        Entity* entity = getEntity(id);
+        if (entity && !entity->isActive()) {
+            destroyEntity(id);
+        }
+    }
+    processDeferred();
+
+    processingUpdate = true;
 
     // Update all active entities' components
-    for (auto& entity : entities) {
-        if (entity->isActive()) {
-            for (auto& pair : entity->getComponents()) {
-                if (pair.second && pair.second->isEnabled()) {
-                    pair.second->update(deltaTime);
+    if (archetypeStorage) {
+        archetypeStorage->updateComponents(deltaTime);
+    } else {
+        for (auto& entity : entities) {
+            if (entity->isActive()) {
+                for (auto& pair : entity->getComponents()) {
+                    if (pair.second && pair.second->isEnabled()) {
+                        pair.second->update(deltaTime);
+                    }
                 }
             }
         }
     }
+
+    processingUpdate = false;
+    processDeferred();
+}
+
+void EntityManager::sortSystems() {
+    std::stable_sort(systems.begin(), systems.end(),
+                     [](const std::unique_ptr<System>& a, const std::unique_ptr<System>& b) {
+                         return a->getPriority() < b->getPriority();
+                     });
+    systemsSorted = true;
+}
+
+void EntityManager::updateSystems(float deltaTime) {
+    if (!systemsSorted) {
+        sortSystems();
+    }
+
+    scheduledSystems.clear();
+    for (auto& system : systems) {
+        if (system->isEnabled()) {
+            scheduledSystems.push_back(system.get());
+        }
+    }
+
+    processingUpdate = true;
+    scheduler.run(scheduledSystems, deltaTime);
+    processingUpdate = false;
+
+    processDeferred();
 }
 
 void EntityManager::clear() {
+    for (auto& entity : entities) {
+        removeFromObservers(entity.get());
+    }
     entities.clear();
-    nextID = 1;
+
+    // Keep the slots' generations so handles from before the clear never match the
+    // entities created after it; every slot is retired and goes back on the free list
+    freeSlots.clear();
+    for (uint32_t index = static_cast<uint32_t>(slots.size()); index-- > 0;) {
+        EntitySlot& slot = slots[index];
+        if (slot.denseIndex != INVALID_DENSE_INDEX) {
+            slot.denseIndex = INVALID_DENSE_INDEX;
+            if (++slot.generation == 0) {
+                slot.generation = 1;
+            }
+        }
+        freeSlots.push_back(index);
+    }
+    entitiesToDestroy.clear();
+    deactivatedEntities.clear();
+    tagGroups.clear();
     clearQueryCaches();
 }
 
+void EntityManager::reserve(size_t count) {
+    entities.reserve(count);
+    slots.reserve(count);
+}
+
 std::vector<Entity*> EntityManager::queryCached(const EntityFilter& filter) {
-    // Check if we have a cached result for this filter
-    for (auto& cache : queryCaches) {
-        if (cache.filter == filter && !cache.dirty && cache.lastEntityCount == entities.size()) {
-            cacheHits++;
-            return cache.results;
+    std::lock_guard<std::mutex> lock(queryCacheMutex);
+    QueryKey key = makeQueryKey(filter);
+
+    auto it = queryCaches.find(key);
+    if (it != queryCaches.end() && !it->second.dirty) {
+        cacheHits++;
+    } else {
+        cacheMisses++;
+        if (it == queryCaches.end()) {
+            // Evict the least recently used cache to bound per-change maintenance cost
+            if (queryCaches.size() >= MAX_QUERY_CACHES) {
+                auto oldest = queryCaches.begin();
+                for (auto cacheIt = queryCaches.begin(); cacheIt != queryCaches.end(); ++cacheIt) {
+                    if (cacheIt->second.lastUsed < oldest->second.lastUsed) {
+                        oldest = cacheIt;
+                    }
+                }
+                queryCaches.erase(oldest);
+            }
+            it = queryCaches.emplace(std::move(key), QueryCache()).first;
         }
+        rebuildQueryCache(it->first, it->second);
     }
 
-    // Cache miss - perform the query
-    cacheMisses++;
-    std::vector<Entity*> results = query(filter);
+    QueryCache& cache = it->second;
+    cache.lastUsed = ++queryCacheClock;
 
-    // Store in cache
-    QueryCache newCache;
-    newCache.filter = filter;
-    newCache.results = results;
-    newCache.dirty = false;
-    newCache.lastEntityCount = entities.size();
+    std::vector<Entity*> results;
+    results.reserve(cache.results.size());
+    for (Entity* entity : cache.results) {
+        if ((!filter.activeOnly || entity->isActive()) &&
+            (!filter.customFilter || filter.customFilter(entity))) {
+            results.push_back(entity);
+        }
+    }
+    return results;
+}
+
+void EntityManager::rebuildQueryCache(const QueryKey& key, QueryCache& cache) {
+    cache.results.clear();
+    cache.positions.assign(slots.size(), 0);
+    for (auto& entity : entities) {
+        if (matchesKey(entity.get(), key)) {
+            cacheInsert(cache, entity.get());
+        }
+    }
+    cache.dirty = false;
+}
 
-    queryCaches.push_back(newCache);
+void EntityManager::onEntitySignatureChanged(Entity* entity) {
+    updateQueryMembership(entity);
+    notifyObservers(entity);
+}
+
+void EntityManager::onEntityDeactivated(Entity* entity) {
+    deactivatedEntities.push_back(entity->getID());
+}
 
-    // Limit cache size to prevent unbounded growth
-    if (queryCaches.size() > 32) {
-        queryCaches.erase(queryCaches.begin());
+void EntityManager::updateQueryMembership(Entity* entity) {
+    for (auto& pair : queryCaches) {
+        QueryCache& cache = pair.second;
+        if (cache.dirty) continue;
+
+        const bool matches = matchesKey(entity, pair.first);
+        const uint32_t index = getEntityIndex(entity->getID());
+        const bool present = index < cache.positions.size() && cache.positions[index] != 0;
+        if (matches && !present) {
+            cacheInsert(cache, entity);
+        } else if (!matches && present) {
+            cacheErase(cache, entity);
+        }
     }
+}
 
-    return results;
+void EntityManager::addObserver(EntityObserver* observer, const ComponentMask& required) {
+    observers.push_back({observer, required, std::vector<uint8_t>(slots.size(), 0)});
+    for (auto& entity : entities) {
+        notifyObservers(entity.get());
+    }
+}
+
+void EntityManager::removeObserver(EntityObserver* observer) {
+    observers.erase(std::remove_if(observers.begin(), observers.end(),
+                                   [observer](const ObserverEntry& entry) {
+                                       return entry.observer == observer;
+                                   }),
+                    observers.end());
+}
+
+void EntityManager::notifyObservers(Entity* entity) {
+    const uint32_t index = getEntityIndex(entity->getID());
+    for (auto& entry : observers) {
+        if (index >= entry.present.size()) {
+            entry.present.resize(slots.size(), 0);
+        }
+        const bool matches = (entity->getSignature() & entry.required) == entry.required;
+        if (matches != (entry.present[index] != 0)) {
+            entry.present[index] = matches ? 1 : 0;
+            if (matches) {
+                entry.observer->onEntityAdded(entity);
+            } else {
+                entry.observer->onEntityRemoved(entity);
+            }
+        }
+    }
+}
+
+void EntityManager::removeFromObservers(Entity* entity) {
+    const uint32_t index = getEntityIndex(entity->getID());
+    for (auto& entry : observers) {
+        if (index < entry.present.size() && entry.present[index]) {
+            entry.present[index] = 0;
+            entry.observer->onEntityRemoved(entity);
+        }
+    }
+}
+
+void EntityManager::removeFromQueryCaches(Entity* entity) {
+    const uint32_t index = getEntityIndex(entity->getID());
+    for (auto& pair : queryCaches) {
+        QueryCache& cache = pair.second;
+        if (!cache.dirty && index < cache.positions.size() && cache.positions[index] != 0) {
+            cacheErase(cache, entity);
+        }
+    }
+}
+
+void EntityManager::cacheInsert(QueryCache& cache, Entity* entity) {
+    const uint32_t index = getEntityIndex(entity->getID());
+    if (index >= cache.positions.size()) {
+        cache.positions.resize(index + 1, 0);
+    }
+    cache.results.push_back(entity);
+    cache.positions[index] = static_cast<uint32_t>(cache.results.size());
+}
+
+void EntityManager::cacheErase(QueryCache& cache, Entity* entity) {
+    const uint32_t index = getEntityIndex(entity->getID());
+    const uint32_t position = cache.positions[index] - 1;
+
+    Entity* last = cache.results.back();
+    cache.results[position] = last;
+    cache.positions[getEntityIndex(last->getID())] = position + 1;
+    cache.results.pop_back();
+    cache.positions[index] = 0;
 }
 
 void EntityManager::invalidateQueryCaches() {
-    for (auto& cache : queryCaches) {
-        cache.dirty = true;
+    for (auto& pair : queryCaches) {
+        pair.second.dirty = true;
     }
 }
 
@@ -0,0 +1,208 @@
+#include "ecs/SystemScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "ecs/EntityManager.h"
+#include "profiler/PerformanceProfiler.h"
+#include "threading/ThreadPool.h"
+
+namespace JJM {
+namespace ECS {
+
+namespace {
+
+double toMs(std::chrono::high_resolution_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+int currentThreadId() {
+    return static_cast<int>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+}
+
+}  // namespace
+
+SystemScheduler::SystemScheduler()
+    : m_jobSystem(nullptr),
+      m_profilingEnabled(false),
+      m_systems(nullptr),
+      m_pendingCapacity(0),
+      m_remaining(0),
+      m_running(0),
+      m_maxRunning(0) {}
+
+SystemScheduler::~SystemScheduler() = default;
+
+void SystemScheduler::run(const std::vector<System*>& systems, float deltaTime) {
+    m_systems = &systems;
+    m_frameStart = Clock::now();
+    m_startTimes.assign(systems.size(), m_frameStart);
+    m_endTimes.assign(systems.size(), m_frameStart);
+    m_maxRunning = 0;
+
+    buildGraph(systems);
+
+    if (m_jobSystem && systems.size() > 1) {
+        runParallel(systems, deltaTime);
+    } else {
+        runSerial(systems, deltaTime);
+    }
+
+    finishFrame(m_frameStart);
+    m_systems = nullptr;
+
+    if (m_exception) {
+        std::exception_ptr exception = m_exception;
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void SystemScheduler::buildGraph(const std::vector<System*>& systems) {
+    const size_t count = systems.size();
+    m_dependents.resize(count);
+    for (auto& list : m_dependents) {
+        list.clear();
+    }
+    m_dependencyCounts.assign(count, 0);
+
+    // Longest chain ending at each system, for the critical path statistic
+    std::vector<size_t> depth(count, 1);
+    size_t edges = 0;
+    size_t criticalPath = count > 0 ? 1 : 0;
+
+    for (size_t j = 0; j < count; ++j) {
+        for (size_t i = 0; i < j; ++i) {
+            if (systems[i]->conflictsWith(*systems[j])) {
+                m_dependents[i].push_back(j);
+                m_dependencyCounts[j]++;
+                depth[j] = std::max(depth[j], depth[i] + 1);
+                edges++;
+            }
+        }
+        criticalPath = std::max(criticalPath, depth[j]);
+    }
+
+    m_stats.systemCount = count;
+    m_stats.dependencyEdges = edges;
+    m_stats.criticalPathLength = criticalPath;
+}
+
+void SystemScheduler::runSystem(size_t index, float deltaTime) {
+    const size_t running = ++m_running;
+    size_t observed = m_maxRunning.load();
+    while (running > observed && !m_maxRunning.compare_exchange_weak(observed, running)) {
+    }
+
+    m_startTimes[index] = Clock::now();
+    try {
+        (*m_systems)[index]->update(deltaTime);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(m_exceptionMutex);
+        if (!m_exception) {
+            m_exception = std::current_exception();
+        }
+    }
+    m_endTimes[index] = Clock::now();
+
+    if (m_profilingEnabled) {
+        Utils::PerformanceProfiler::getInstance()->recordProfile(
+            "ECS::" + (*m_systems)[index]->getName(), m_startTimes[index], m_endTimes[index],
+            currentThreadId());
+    }
+
+    --m_running;
+}
+
+void SystemScheduler::runSerial(const std::vector<System*>& systems, float deltaTime) {
+    for (size_t i = 0; i < systems.size(); ++i) {
+        runSystem(i, deltaTime);
+    }
+}
+
+void SystemScheduler::submitSystem(size_t index, float deltaTime) {
+    m_jobSystem->submitWithPriority(
+        [this, index, deltaTime]() {
+            runSystem(index, deltaTime);
+
+            for (size_t dependent : m_dependents[index]) {
+                if (--m_pending[dependent] == 0) {
+                    submitSystem(dependent, deltaTime);
+                }
+            }
+            --m_remaining;
+        },
+        Threading::TaskPriority::High);
+}
+
+void SystemScheduler::runParallel(const std::vector<System*>& systems, float deltaTime) {
+    const size_t count = systems.size();
+    if (count > m_pendingCapacity) {
+        m_pending = std::make_unique<std::atomic<int>[]>(count);
+        m_pendingCapacity = count;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        m_pending[i].store(m_dependencyCounts[i]);
+    }
+    m_remaining = count;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (m_dependencyCounts[i] == 0) {
+            submitSystem(i, deltaTime);
+        }
+    }
+
+    // Help run jobs instead of blocking so the calling thread counts as a worker
+    while (m_remaining.load() > 0) {
+        if (!m_jobSystem->processOneJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void SystemScheduler::parallelFor(size_t count, const std::function<void(size_t)>& job) {
+    if (!m_jobSystem || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            job(i);
+        }
+        return;
+    }
+
+    // wait() helps run the chunks and rethrows the first exception one of them threw
+    Threading::JobCounter counter;
+    for (size_t i = 0; i < count; ++i) {
+        m_jobSystem->dispatch([&job, i]() { job(i); }, counter, Threading::TaskPriority::High);
+    }
+    m_jobSystem->wait(counter);
+}
+
+void SystemScheduler::finishFrame(Clock::time_point frameStart) {
+    const Clock::time_point frameEnd = Clock::now();
+    const size_t count = m_systems->size();
+
+    m_timings.resize(count);
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        SystemTiming& timing = m_timings[i];
+        timing.name = (*m_systems)[i]->getName();
+        timing.timeMs = toMs(m_endTimes[i] - m_startTimes[i]);
+        timing.startMs = toMs(m_startTimes[i] - frameStart);
+        total += timing.timeMs;
+    }
+
+    m_stats.wallTimeMs = toMs(frameEnd - frameStart);
+    m_stats.totalSystemTimeMs = total;
+    m_stats.parallelism = m_stats.wallTimeMs > 0.0 ? total / m_stats.wallTimeMs : 0.0;
+    m_stats.maxConcurrency = m_maxRunning.load();
+
+    if (m_profilingEnabled) {
+        Utils::PerformanceProfiler* profiler = Utils::PerformanceProfiler::getInstance();
+        profiler->recordProfile("ECS::Systems", frameStart, frameEnd, currentThreadId());
+        profiler->recordValue("ECS::Systems.parallelism", m_stats.parallelism);
+        profiler->recordValue("ECS::Systems.maxConcurrency",
+                              static_cast<double>(m_stats.maxConcurrency));
+    }
+}
+
+}  // namespace ECS
+}  // namespace JJM
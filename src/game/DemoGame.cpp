@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "graphics/Color.h"
+#include "memory/MemoryPool.h"
 #include "utils/DebugUtils.h"
 
 using namespace JJM;
@@ -64,6 +65,8 @@ void DemoGame::setupEvents() {
 
 void DemoGame::run() {
     while (running) {
+        // Flips every thread's frame allocator; last frame's data stays valid until the next flip
+        Memory::MemoryManager::getInstance()->beginFrame();
         calculateDeltaTime();
         handleEvents();
         update(deltaTime);
@@ -21,9 +21,9 @@ void RenderQueue::submit(RenderLayer layer, std::function<void()> command, int p
     cmd.layer = layer;
     cmd.priority = priority;
     cmd.distance = distance;
-    cmd.execute = command;
+    cmd.execute = std::move(command);
     
-    commands.push_back(cmd);
+    commands.push_back(std::move(cmd));
     sorted = false;
 }
 
@@ -38,7 +38,9 @@ void RenderQueue::execute() {
     sort();
     
     for (auto& cmd : commands) {
-        if (cmd.execute) {
+        if (cmd.invoke) {
+            cmd.invoke(cmd.payload);
+        } else if (cmd.execute) {
             cmd.execute();
         }
     }
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <cstring>
 #include <algorithm>
+#include <stdexcept>
 
 namespace JJM {
 namespace Memory {
@@ -21,18 +22,111 @@ MemoryBlock::~MemoryBlock() {
     }
 }
 
+// Thread slots
+namespace {
+
+// Per-thread state in pools and arenas is indexed by a small slot number, since
+// thread_local storage can't be keyed per instance. A slot is recycled when its thread
+// exits, once every registered owner has released what the slot held.
+constexpr size_t MAX_THREAD_SLOTS = 64;
+constexpr size_t NO_THREAD_SLOT = SIZE_MAX;
+constexpr size_t THREAD_CACHE_CAPACITY = 64;
+
+struct SlotOwner {
+    void* owner;
+    void (*release)(void* owner, size_t slot);
+};
+
+struct SlotRegistry {
+    std::mutex mutex;
+    std::vector<size_t> freeSlots;
+    size_t nextSlot = 0;
+    std::vector<SlotOwner> owners;
+};
+
+SlotRegistry& slotRegistry() {
+    static SlotRegistry registry;
+    return registry;
+}
+
+struct ThreadSlot {
+    size_t index = NO_THREAD_SLOT;
+    
+    ThreadSlot() {
+        SlotRegistry& registry = slotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        if (!registry.freeSlots.empty()) {
+            index = registry.freeSlots.back();
+            registry.freeSlots.pop_back();
+        } else if (registry.nextSlot < MAX_THREAD_SLOTS) {
+            index = registry.nextSlot++;
+        }
+    }
+    
+    ~ThreadSlot() {
+        if (index == NO_THREAD_SLOT) return;
+        SlotRegistry& registry = slotRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const SlotOwner& owner : registry.owners) {
+            owner.release(owner.owner, index);
+        }
+        registry.freeSlots.push_back(index);
+    }
+};
+
+// NO_THREAD_SLOT once every slot is taken; callers fall back to their shared path
+size_t currentThreadSlot() {
+    thread_local ThreadSlot slot;
+    return slot.index;
+}
+
+void registerSlotOwner(void* owner, void (*release)(void*, size_t)) {
+    SlotRegistry& registry = slotRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.owners.push_back({owner, release});
+}
+
+void unregisterSlotOwner(void* owner) {
+    SlotRegistry& registry = slotRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.owners.erase(std::remove_if(registry.owners.begin(), registry.owners.end(),
+                                         [owner](const SlotOwner& entry) {
+                                             return entry.owner == owner;
+                                         }),
+                          registry.owners.end());
+}
+
+// Counters written only by the thread holding the slot, so no read-modify-write is needed
+void bumpCounter(std::atomic<size_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace
+
 // MemoryPool implementation
+struct alignas(64) MemoryPool::ThreadCache {
+    uint32_t count = 0;
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    uint32_t blocks[THREAD_CACHE_CAPACITY];
+};
+
 MemoryPool::MemoryPool(size_t blockSize, size_t numBlocks)
-    : blockSize(blockSize), poolSize(blockSize * numBlocks),
-      poolMemory(nullptr), freeList(nullptr),
-      allocatedBytes(0), allocatedBlocks(0) {
+    : blockSize((std::max(blockSize, sizeof(void*)) + sizeof(void*) - 1) & ~(sizeof(void*) - 1)),
+      numBlocks(numBlocks), poolSize(0), poolMemory(nullptr), poolBegin(nullptr),
+      poolEnd(nullptr), freeHead(0),
+      cacheCapacity(std::min(THREAD_CACHE_CAPACITY, numBlocks / 32)),
+      sharedAllocations(0), sharedDeallocations(0) {
+    if (numBlocks >= UINT32_MAX) {
+        throw std::length_error("MemoryPool: too many blocks");
+    }
+    poolSize = this->blockSize * numBlocks;
     initializePool();
+    registerSlotOwner(this, &MemoryPool::releaseThreadSlot);
 }
 
 MemoryPool::~MemoryPool() {
-    for (auto* block : allBlocks) {
-        delete block;
-    }
+    unregisterSlotOwner(this);
     
     if (poolMemory) {
         std::free(poolMemory);
@@ -40,48 +134,71 @@ MemoryPool::~MemoryPool() {
 }
 
 void* MemoryPool::allocate() {
-    std::lock_guard<std::mutex> lock(poolMutex);
-    
-    if (!freeList) {
-        return nullptr; // Pool exhausted
+    uint32_t index;
+    const size_t slot = currentThreadSlot();
+    if (slot != NO_THREAD_SLOT && cacheCapacity > 0) {
+        ThreadCache& cache = caches[slot];
+        if (cache.count == 0) {
+            const size_t refill = std::max<size_t>(cacheCapacity / 2, 1);
+            cache.count = popFree(cache.blocks, static_cast<uint32_t>(refill));
+            if (cache.count == 0) {
+                return nullptr; // Pool exhausted
+            }
+        }
+        index = cache.blocks[--cache.count];
+        bumpCounter(cache.allocations);
+    } else {
+        if (popFree(&index, 1) == 0) {
+            return nullptr; // Pool exhausted
+        }
+        sharedAllocations.fetch_add(1, std::memory_order_relaxed);
     }
     
-    MemoryBlock* block = freeList;
-    freeList = freeList->getNext();
-    
-    block->setAllocated(true);
-    block->setNext(nullptr);
-    
-    allocatedBlocks++;
-    allocatedBytes += blockSize;
-    
-    return block->getData();
+    return poolBegin + static_cast<size_t>(index) * blockSize;
 }
 
 void MemoryPool::deallocate(void* ptr) {
-    if (!ptr) return;
-    
-    std::lock_guard<std::mutex> lock(poolMutex);
-    
-    MemoryBlock* block = findBlock(ptr);
-    if (block && block->isAllocated()) {
-        block->setAllocated(false);
-        block->setNext(freeList);
-        freeList = block;
-        
-        allocatedBlocks--;
-        allocatedBytes -= blockSize;
+    if (!ptr || !owns(ptr)) return;
+    
+    uint32_t index = static_cast<uint32_t>((static_cast<char*>(ptr) - poolBegin) / blockSize);
+    const size_t slot = currentThreadSlot();
+    if (slot != NO_THREAD_SLOT && cacheCapacity > 0) {
+        ThreadCache& cache = caches[slot];
+        if (cache.count == cacheCapacity) {
+            // Spill the older half, keeping recently freed blocks warm in this thread
+            const uint32_t spill = static_cast<uint32_t>(std::max<size_t>(cacheCapacity / 2, 1));
+            pushFree(cache.blocks, spill);
+            std::memmove(cache.blocks, cache.blocks + spill,
+                         (cache.count - spill) * sizeof(uint32_t));
+            cache.count -= spill;
+        }
+        cache.blocks[cache.count++] = index;
+        bumpCounter(cache.deallocations);
+    } else {
+        pushFree(&index, 1);
+        sharedDeallocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+size_t MemoryPool::getAllocatedBlocks() const {
+    // Blocks are often freed on a different thread than the one that allocated them, so
+    // the difference is only meaningful summed over every slot
+    int64_t allocated = static_cast<int64_t>(sharedAllocations.load(std::memory_order_relaxed)) -
+                        static_cast<int64_t>(sharedDeallocations.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        allocated += static_cast<int64_t>(caches[i].allocations.load(std::memory_order_relaxed));
+        allocated -= static_cast<int64_t>(caches[i].deallocations.load(std::memory_order_relaxed));
     }
+    return static_cast<size_t>(std::max<int64_t>(allocated, 0));
 }
 
 double MemoryPool::getUtilization() const {
-    if (allBlocks.empty()) return 0.0;
-    return static_cast<double>(allocatedBlocks) / static_cast<double>(allBlocks.size());
+    if (numBlocks == 0) return 0.0;
+    return static_cast<double>(getAllocatedBlocks()) / static_cast<double>(numBlocks);
 }
 
 bool MemoryPool::isValidPointer(void* ptr) const {
-    std::lock_guard<std::mutex> lock(poolMutex);
-    return findBlock(ptr) != nullptr;
+    return owns(ptr) && (static_cast<char*>(ptr) - poolBegin) % blockSize == 0;
 }
 
 void MemoryPool::defragment() {
@@ -90,38 +207,204 @@ void MemoryPool::defragment() {
 }
 
 void MemoryPool::initializePool() {
-    poolMemory = std::aligned_alloc(sizeof(void*), poolSize);
-    if (!poolMemory) {
-        throw std::bad_alloc();
+    if (numBlocks > 0) {
+        poolMemory = std::aligned_alloc(64, (poolSize + 63) & ~size_t(63));
+        if (!poolMemory) {
+            throw std::bad_alloc();
+        }
     }
+    poolBegin = static_cast<char*>(poolMemory);
+    poolEnd = poolBegin + poolSize;
     
-    size_t numBlocks = poolSize / blockSize;
-    allBlocks.reserve(numBlocks);
-    
-    char* current = static_cast<char*>(poolMemory);
-    
+    // Thread link every block in address order, so a fresh pool hands them out sequentially
+    nextFree.reset(new std::atomic<uint32_t>[numBlocks]);
     for (size_t i = 0; i < numBlocks; i++) {
-        MemoryBlock* block = new MemoryBlock(0); // Don't allocate memory in block
-        block->data = current;
-        block->size = blockSize;
-        
-        allBlocks.push_back(block);
+        const uint32_t next = i + 1 < numBlocks ? static_cast<uint32_t>(i + 2) : 0;
+        nextFree[i].store(next, std::memory_order_relaxed);
+    }
+    freeHead.store(numBlocks > 0 ? 1 : 0, std::memory_order_release);
+    
+    caches.reset(new ThreadCache[MAX_THREAD_SLOTS]);
+}
+
+uint32_t MemoryPool::popFree(uint32_t* out, uint32_t maxCount) {
+    uint64_t head = freeHead.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t next = static_cast<uint32_t>(head);
+        if (next == 0) {
+            return 0;
+        }
         
-        // Add to free list
-        block->setNext(freeList);
-        freeList = block;
+        // Take up to maxCount blocks with a single exchange. The chain may change under us,
+        // but any change also moves the tag, so the exchange then fails and we walk again.
+        uint32_t count = 0;
+        while (next != 0 && count < maxCount) {
+            out[count++] = next - 1;
+            next = nextFree[next - 1].load(std::memory_order_relaxed);
+        }
         
-        current += blockSize;
+        const uint64_t replacement = (((head >> 32) + 1) << 32) | next;
+        if (freeHead.compare_exchange_weak(head, replacement, std::memory_order_acquire,
+                                           std::memory_order_acquire)) {
+            return count;
+        }
     }
 }
 
-MemoryBlock* MemoryPool::findBlock(void* ptr) const {
-    for (auto* block : allBlocks) {
-        if (block->getData() == ptr) {
-            return block;
+void MemoryPool::pushFree(const uint32_t* indices, uint32_t count) {
+    for (uint32_t i = 0; i + 1 < count; i++) {
+        nextFree[indices[i]].store(indices[i + 1] + 1, std::memory_order_relaxed);
+    }
+    
+    const uint32_t last = indices[count - 1];
+    uint64_t head = freeHead.load(std::memory_order_relaxed);
+    for (;;) {
+        nextFree[last].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        const uint64_t replacement = (((head >> 32) + 1) << 32) | (indices[0] + 1);
+        if (freeHead.compare_exchange_weak(head, replacement, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+            return;
         }
     }
-    return nullptr;
+}
+
+void MemoryPool::releaseThreadSlot(void* pool, size_t slot) {
+    MemoryPool* self = static_cast<MemoryPool*>(pool);
+    ThreadCache& cache = self->caches[slot];
+    if (cache.count > 0) {
+        self->pushFree(cache.blocks, cache.count);
+        cache.count = 0;
+    }
+}
+
+// MemoryArena implementation
+MemoryArena::MemoryArena(size_t defaultChunkSize)
+    : m_defaultChunkSize(defaultChunkSize), m_currentChunk(nullptr), m_firstChunk(nullptr),
+      m_spareChunks(nullptr), m_cursors(new ThreadCursor[MAX_THREAD_SLOTS]),
+      m_totalAllocated(0), m_sharedBytesUsed(0) {
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        m_cursors[i].chunk = nullptr;
+        m_cursors[i].bytesUsed.store(0, std::memory_order_relaxed);
+    }
+    registerSlotOwner(this, &MemoryArena::releaseThreadSlot);
+}
+
+MemoryArena::~MemoryArena() {
+    unregisterSlotOwner(this);
+    clear();
+}
+
+void* MemoryArena::allocate(size_t size, size_t alignment) {
+    const size_t slot = currentThreadSlot();
+    if (slot == NO_THREAD_SLOT) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        void* memory =
+            m_currentChunk ? allocateFromChunk(m_currentChunk, size, alignment) : nullptr;
+        if (!memory) {
+            m_currentChunk = acquireChunk(size + alignment);
+            memory = allocateFromChunk(m_currentChunk, size, alignment);
+        }
+        m_sharedBytesUsed.fetch_add(size, std::memory_order_relaxed);
+        return memory;
+    }
+    
+    // The chunk under this thread's cursor is its own, so bumping it needs no lock
+    ThreadCursor& cursor = m_cursors[slot];
+    void* memory = cursor.chunk ? allocateFromChunk(cursor.chunk, size, alignment) : nullptr;
+    if (!memory) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            cursor.chunk = acquireChunk(size + alignment);
+        }
+        memory = allocateFromChunk(cursor.chunk, size, alignment);
+    }
+    cursor.bytesUsed.store(cursor.bytesUsed.load(std::memory_order_relaxed) + size,
+                           std::memory_order_relaxed);
+    return memory;
+}
+
+void MemoryArena::reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    // Every chunk handed out goes back on the spare list with its contents discarded
+    while (m_firstChunk) {
+        Chunk* chunk = m_firstChunk;
+        m_firstChunk = chunk->next;
+        chunk->used = 0;
+        chunk->next = m_spareChunks;
+        m_spareChunks = chunk;
+    }
+    m_currentChunk = nullptr;
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        m_cursors[i].chunk = nullptr;
+        m_cursors[i].bytesUsed.store(0, std::memory_order_relaxed);
+    }
+    m_sharedBytesUsed.store(0, std::memory_order_relaxed);
+}
+
+void MemoryArena::clear() {
+    reset();
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    while (m_spareChunks) {
+        Chunk* chunk = m_spareChunks;
+        m_spareChunks = chunk->next;
+        std::free(chunk->memory);
+        delete chunk;
+    }
+    m_totalAllocated = 0;
+}
+
+size_t MemoryArena::getTotalUsed() const {
+    size_t used = m_sharedBytesUsed.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        used += m_cursors[i].bytesUsed.load(std::memory_order_relaxed);
+    }
+    return used;
+}
+
+MemoryArena::Chunk* MemoryArena::acquireChunk(size_t minSize) {
+    // Reuse the first spare chunk that is big enough
+    for (Chunk** link = &m_spareChunks; *link; link = &(*link)->next) {
+        if ((*link)->size >= minSize) {
+            Chunk* chunk = *link;
+            *link = chunk->next;
+            chunk->next = m_firstChunk;
+            m_firstChunk = chunk;
+            return chunk;
+        }
+    }
+    
+    Chunk* chunk = new Chunk();
+    chunk->size = std::max(m_defaultChunkSize, minSize);
+    chunk->memory = std::malloc(chunk->size);
+    if (!chunk->memory) {
+        delete chunk;
+        throw std::bad_alloc();
+    }
+    chunk->used = 0;
+    chunk->next = m_firstChunk;
+    m_firstChunk = chunk;
+    m_totalAllocated += chunk->size;
+    return chunk;
+}
+
+void* MemoryArena::allocateFromChunk(Chunk* chunk, size_t size, size_t alignment) {
+    const uintptr_t base = reinterpret_cast<uintptr_t>(chunk->memory);
+    const uintptr_t aligned = (base + chunk->used + alignment - 1) & ~(uintptr_t(alignment) - 1);
+    const size_t end = static_cast<size_t>(aligned - base) + size;
+    if (end > chunk->size) {
+        return nullptr;
+    }
+    chunk->used = end;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void MemoryArena::releaseThreadSlot(void* arena, size_t slot) {
+    // The chunk stays on the arena's list; the next thread in this slot starts a new one
+    MemoryArena* self = static_cast<MemoryArena*>(arena);
+    std::lock_guard<std::mutex> lock(self->m_mutex);
+    self->m_cursors[slot].chunk = nullptr;
 }
 
 // StackAllocator implementation
@@ -151,6 +434,12 @@ void* StackAllocator::allocate(size_t bytes, size_t alignment) {
     return result;
 }
 
+void StackAllocator::release(void* ptr, size_t bytes) {
+    if (static_cast<char*>(ptr) + bytes == static_cast<char*>(memory) + offset) {
+        offset = static_cast<size_t>(static_cast<char*>(ptr) - static_cast<char*>(memory));
+    }
+}
+
 void StackAllocator::pushMarker(const char* label) {
     markers.push_back({offset, label});
 }
@@ -260,7 +549,38 @@ void ObjectPool::allocateNewChunk() {
 // MemoryManager implementation
 MemoryManager* MemoryManager::instance = nullptr;
 
-MemoryManager::MemoryManager() : totalAllocatedBytes(0) {}
+struct MemoryManager::ThreadFrameBuffers {
+    uint64_t frame;
+    std::unique_ptr<StackAllocator> buffers[2];
+};
+
+MemoryManager::MemoryManager()
+    : threadFrameBuffers(new std::atomic<ThreadFrameBuffers*>[MAX_THREAD_SLOTS]),
+      frameAllocatorSize(1024 * 1024), frameIndex(0), totalAllocatedBytes(0),
+      poolRanges(nullptr) {
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        threadFrameBuffers[i].store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto& entry : sizeClassPools) {
+        entry.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+size_t MemoryManager::sizeClass(size_t size) {
+    // 16-byte steps up to 1 KiB, then one class per power of two
+    if (size <= 1024) {
+        return (size + 15) / 16;
+    }
+    size_t sizeClass = 65;
+    for (size_t bytes = 2048; bytes < size; bytes <<= 1) {
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+size_t MemoryManager::sizeClassBytes(size_t sizeClass) {
+    return sizeClass <= 64 ? sizeClass * 16 : size_t(1024) << (sizeClass - 64);
+}
 
 MemoryManager* MemoryManager::getInstance() {
     if (!instance) {
@@ -274,13 +594,24 @@ MemoryManager::~MemoryManager() {
 }
 
 void MemoryManager::initialize(size_t frameAllocatorSize) {
-    frameAllocator = std::make_unique<StackAllocator>(frameAllocatorSize);
+    // Applies to frame buffers created after this call, so call it before threads start
+    this->frameAllocatorSize = frameAllocatorSize;
 }
 
 void MemoryManager::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(managerMutex);
+        for (auto& entry : sizeClassPools) {
+            entry.store(nullptr, std::memory_order_release);
+        }
+        poolRanges.store(nullptr, std::memory_order_release);
+        poolRangeTables.clear();
+    }
     pools.clear();
     objectPools.clear();
-    frameAllocator.reset();
+    for (size_t i = 0; i < MAX_THREAD_SLOTS; i++) {
+        delete threadFrameBuffers[i].exchange(nullptr);
+    }
     namedPools.clear();
     namedObjectPools.clear();
 }
@@ -293,6 +624,7 @@ MemoryPool* MemoryManager::createPool(const std::string& name, size_t blockSize,
     
     pools.push_back(std::move(pool));
     namedPools[name] = ptr;
+    rebuildRoutingTables();
     
     return ptr;
 }
@@ -331,51 +663,107 @@ ObjectPool* MemoryManager::getObjectPool(const std::string& name) {
     return nullptr;
 }
 
-void* MemoryManager::allocate(size_t size, const std::string& poolName) {
-    if (!poolName.empty()) {
-        MemoryPool* pool = getPool(poolName);
-        if (pool) {
-            return pool->allocate();
+void* MemoryManager::allocate(size_t size) {
+    if (size <= MAX_POOLED_SIZE) {
+        // Walk up the classes so an exhausted pool spills into the next larger one
+        MemoryPool* tried = nullptr;
+        for (size_t c = sizeClass(size); c < SIZE_CLASS_COUNT; c++) {
+            MemoryPool* pool = sizeClassPools[c].load(std::memory_order_acquire);
+            if (!pool) break;
+            if (pool == tried) continue;
+            if (void* ptr = pool->allocate()) {
+                return ptr;
+            }
+            tried = pool;
         }
     }
     
-    MemoryPool* pool = findBestFitPool(size);
-    if (pool) {
-        return pool->allocate();
-    }
-    
     // Fallback to regular malloc
     totalAllocatedBytes += size;
     return std::malloc(size);
 }
 
-void MemoryManager::deallocate(void* ptr, const std::string& poolName) {
-    if (!ptr) return;
-    
-    if (!poolName.empty()) {
-        MemoryPool* pool = getPool(poolName);
-        if (pool && pool->isValidPointer(ptr)) {
-            pool->deallocate(ptr);
-            return;
+void* MemoryManager::allocate(size_t size, const std::string& poolName) {
+    MemoryPool* pool = getPool(poolName);
+    if (pool && size <= pool->getBlockSize()) {
+        if (void* ptr = pool->allocate()) {
+            return ptr;
         }
     }
+    return allocate(size);
+}
+
+void MemoryManager::deallocate(void* ptr) {
+    if (!ptr) return;
     
-    // Try to find in any pool
-    for (const auto& pool : pools) {
-        if (pool->isValidPointer(ptr)) {
-            pool->deallocate(ptr);
-            return;
-        }
+    if (MemoryPool* pool = findOwningPool(ptr)) {
+        pool->deallocate(ptr);
+        return;
     }
     
     // Fallback to regular free
     std::free(ptr);
 }
 
-void MemoryManager::resetFrameAllocator() {
-    if (frameAllocator) {
-        frameAllocator->clear();
+void MemoryManager::deallocate(void* ptr, size_t size) {
+    if (!ptr) return;
+    
+    // The block came from this size's pool or, if that one was exhausted, a larger one
+    if (size <= MAX_POOLED_SIZE) {
+        for (size_t c = sizeClass(size); c < SIZE_CLASS_COUNT; c++) {
+            MemoryPool* pool = sizeClassPools[c].load(std::memory_order_acquire);
+            if (!pool) break;
+            if (pool->owns(ptr)) {
+                pool->deallocate(ptr);
+                return;
+            }
+        }
+    }
+    deallocate(ptr);
+}
+
+void MemoryManager::deallocate(void* ptr, const std::string& poolName) {
+    if (!ptr) return;
+    
+    MemoryPool* pool = getPool(poolName);
+    if (pool && pool->owns(ptr)) {
+        pool->deallocate(ptr);
+        return;
     }
+    deallocate(ptr);
+}
+
+StackAllocator* MemoryManager::getFrameAllocator() {
+    const size_t slot = currentThreadSlot();
+    if (slot == NO_THREAD_SLOT) {
+        return nullptr;
+    }
+    
+    ThreadFrameBuffers* frameBuffers = threadFrameBuffers[slot].load(std::memory_order_acquire);
+    if (!frameBuffers) {
+        frameBuffers = new ThreadFrameBuffers();
+        frameBuffers->frame = frameIndex.load(std::memory_order_acquire);
+        frameBuffers->buffers[0] = std::make_unique<StackAllocator>(frameAllocatorSize);
+        frameBuffers->buffers[1] = std::make_unique<StackAllocator>(frameAllocatorSize);
+        threadFrameBuffers[slot].store(frameBuffers, std::memory_order_release);
+    }
+    
+    // The buffer being switched to was last filled two frames ago, so it is free to clear
+    const uint64_t frame = frameIndex.load(std::memory_order_acquire);
+    StackAllocator* buffer = frameBuffers->buffers[frame & 1].get();
+    if (frameBuffers->frame != frame) {
+        frameBuffers->frame = frame;
+        buffer->clear();
+    }
+    return buffer;
+}
+
+void MemoryManager::beginFrame() {
+    frameIndex.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void MemoryManager::resetFrameAllocator() {
+    beginFrame();
 }
 
 void MemoryManager::printStatistics() const {
@@ -401,8 +789,13 @@ std::string MemoryManager::getStatisticsReport() const {
            << " objects" << std::endl;
     }
     
-    if (frameAllocator) {
-        ss << "\n--- Frame Allocator ---" << std::endl;
+    // Other threads' buffers change under us, so only the caller's is reported
+    const size_t slot = currentThreadSlot();
+    const ThreadFrameBuffers* frameBuffers =
+        slot != NO_THREAD_SLOT ? threadFrameBuffers[slot].load(std::memory_order_acquire) : nullptr;
+    if (frameBuffers) {
+        const StackAllocator* frameAllocator = frameBuffers->buffers[frameBuffers->frame & 1].get();
+        ss << "\n--- Frame Allocator (this thread) ---" << std::endl;
         ss << "Used: " << frameAllocator->getUsedBytes() << "/" << frameAllocator->getTotalBytes()
            << " bytes (" << (frameAllocator->getUtilization() * 100.0) << "% util)" << std::endl;
     }
@@ -410,18 +803,45 @@ std::string MemoryManager::getStatisticsReport() const {
     return ss.str();
 }
 
-MemoryPool* MemoryManager::findBestFitPool(size_t size) {
-    MemoryPool* bestFit = nullptr;
-    size_t smallestFit = SIZE_MAX;
+void MemoryManager::rebuildRoutingTables() {
+    // Called with managerMutex held. Each class routes to the smallest pool that fits it.
+    for (size_t c = 0; c < SIZE_CLASS_COUNT; c++) {
+        const size_t bytes = sizeClassBytes(c);
+        MemoryPool* bestFit = nullptr;
+        for (const auto& pool : pools) {
+            if (pool->getBlockSize() >= bytes &&
+                (!bestFit || pool->getBlockSize() < bestFit->getBlockSize())) {
+                bestFit = pool.get();
+            }
+        }
+        sizeClassPools[c].store(bestFit, std::memory_order_release);
+    }
     
+    auto ranges = std::make_unique<std::vector<PoolRange>>();
+    ranges->reserve(pools.size());
     for (const auto& pool : pools) {
-        if (pool->getBlockSize() >= size && pool->getBlockSize() < smallestFit && pool->getFreeBlocks() > 0) {
-            bestFit = pool.get();
-            smallestFit = pool->getBlockSize();
+        if (pool->getTotalBytes() > 0) {
+            ranges->push_back({static_cast<const char*>(pool->getBaseAddress()), pool.get()});
         }
     }
+    std::sort(ranges->begin(), ranges->end(),
+              [](const PoolRange& a, const PoolRange& b) { return a.begin < b.begin; });
+    poolRanges.store(ranges.get(), std::memory_order_release);
+    poolRangeTables.push_back(std::move(ranges));
+}
+
+MemoryPool* MemoryManager::findOwningPool(const void* ptr) const {
+    const std::vector<PoolRange>* ranges = poolRanges.load(std::memory_order_acquire);
+    if (!ranges) return nullptr;
     
-    return bestFit;
+    // Last pool starting at or below ptr
+    auto it = std::upper_bound(ranges->begin(), ranges->end(), static_cast<const char*>(ptr),
+                               [](const char* address, const PoolRange& range) {
+                                   return address < range.begin;
+                               });
+    if (it == ranges->begin()) return nullptr;
+    --it;
+    return it->pool->owns(ptr) ? it->pool : nullptr;
 }
 
 // FrameAllocatorScope implementation
@@ -436,6 +856,16 @@ FrameAllocatorScope::~FrameAllocatorScope() {
     if (allocator) {
         allocator->popMarker();
     }
+    for (void* block : fallbackBlocks) {
+        ::operator delete(block);
+    }
+}
+
+void* FrameAllocatorScope::allocateFallback(size_t bytes) {
+    fallbackBlocks.reserve(fallbackBlocks.size() + 1);
+    void* block = ::operator new(bytes);
+    fallbackBlocks.push_back(block);
+    return block;
 }
 
 } // namespace Memory
@@ -166,19 +166,21 @@ BitPacker::BitPacker() : m_bitPosition(0) {
 }
 
 void BitPacker::writeBits(uint32_t value, int numBits) {
-    for (int i = 0; i < numBits; i++) {
+    if (numBits < 32) {
+        value &= (1u << numBits) - 1;
+    }
+    m_data.resize((m_bitPosition + numBits + 7) / 8, 0);
+    
+    // Fill the partial byte, then whole bytes; bits go least significant first
+    while (numBits > 0) {
         size_t byteIndex = m_bitPosition / 8;
-        size_t bitIndex = m_bitPosition % 8;
-        
-        if (byteIndex >= m_data.size()) {
-            m_data.push_back(0);
-        }
-        
-        if (value & (1 << i)) {
-            m_data[byteIndex] |= (1 << bitIndex);
-        }
+        int bitIndex = static_cast<int>(m_bitPosition % 8);
+        int count = std::min(numBits, 8 - bitIndex);
         
-        m_bitPosition++;
+        m_data[byteIndex] |= static_cast<uint8_t>((value & ((1u << count) - 1)) << bitIndex);
+        value = count < 32 ? value >> count : 0;
+        numBits -= count;
+        m_bitPosition += count;
     }
 }
 
@@ -191,7 +193,8 @@ void BitPacker::writeFloat(float value, float min, float max, int numBits) {
     float normalized = (value - min) / (max - min);
     normalized = std::max(0.0f, std::min(1.0f, normalized));
     
-    uint32_t quantized = static_cast<uint32_t>(normalized * ((1 << numBits) - 1));
+    uint32_t maxValue = numBits < 32 ? (1u << numBits) - 1 : 0xFFFFFFFFu;
+    uint32_t quantized = static_cast<uint32_t>(normalized * maxValue);
     writeBits(quantized, numBits);
 }
 
@@ -213,31 +216,38 @@ BitUnpacker::BitUnpacker(const uint8_t* data, size_t sizeInBytes)
 
 uint32_t BitUnpacker::readBits(int numBits) {
     uint32_t value = 0;
+    int shift = 0;
     
-    for (int i = 0; i < numBits; i++) {
-        if (m_bitPosition >= m_sizeInBits) break;
-        
+    // Reads past the end return zero bits and leave the position past the end
+    while (shift < numBits && m_bitPosition < m_sizeInBits) {
         size_t byteIndex = m_bitPosition / 8;
-        size_t bitIndex = m_bitPosition % 8;
-        
-        if (m_data[byteIndex] & (1 << bitIndex)) {
-            value |= (1 << i);
-        }
+        int bitIndex = static_cast<int>(m_bitPosition % 8);
+        int count = std::min(numBits - shift, 8 - bitIndex);
         
-        m_bitPosition++;
+        uint32_t bits = (m_data[byteIndex] >> bitIndex) & ((1u << count) - 1);
+        value |= bits << shift;
+        shift += count;
+        m_bitPosition += count;
     }
+    m_bitPosition += numBits - shift;
     
     return value;
 }
 
 int32_t BitUnpacker::readSignedBits(int numBits) {
     uint32_t unsignedValue = readBits(numBits);
+    
+    // Sign-extend from numBits
+    if (numBits < 32 && (unsignedValue & (1u << (numBits - 1)))) {
+        unsignedValue |= ~((1u << numBits) - 1);
+    }
     return static_cast<int32_t>(unsignedValue);
 }
 
 float BitUnpacker::readFloat(float min, float max, int numBits) {
     uint32_t quantized = readBits(numBits);
-    float normalized = static_cast<float>(quantized) / ((1 << numBits) - 1);
+    uint32_t maxValue = numBits < 32 ? (1u << numBits) - 1 : 0xFFFFFFFFu;
+    float normalized = static_cast<float>(quantized) / maxValue;
     return min + normalized * (max - min);
 }
 
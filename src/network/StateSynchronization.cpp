@@ -1,7 +1,9 @@
 #include "../../include/network/StateSynchronization.h"
+#include "../../include/network/PacketCompression.h"
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <map>
 
 namespace JJM {
 namespace Network {
@@ -57,7 +59,7 @@ void NetworkTransform::serialize(std::vector<uint8_t>& buffer) const {
 void NetworkTransform::deserialize(const std::vector<uint8_t>& buffer, size_t& offset) {
     if (offset + sizeof(NetworkTransform) <= buffer.size()) {
         std::memcpy(this, &buffer[offset], sizeof(NetworkTransform));
-        offset += sizeof(NetworkTransform));
+        offset += sizeof(NetworkTransform);
     }
 }
 
@@ -184,6 +186,7 @@ void SnapshotBuffer::clear() {
 NetworkedObject::NetworkedObject(uint32_t networkId)
     : m_networkId(networkId)
     , m_authority(Authority::SERVER)
+    , m_syncVarOrderDirty(true)
     , m_syncTransform(true)
     , m_updateRate(10.0f)
     , m_lastUpdateTime(0) {
@@ -194,10 +197,25 @@ NetworkedObject::~NetworkedObject() {
 
 void NetworkedObject::registerSyncVar(const std::string& name, SyncVarBase* syncVar) {
     m_syncVars[name] = syncVar;
+    m_syncVarOrderDirty = true;
 }
 
 void NetworkedObject::unregisterSyncVar(const std::string& name) {
     m_syncVars.erase(name);
+    m_syncVarOrderDirty = true;
+}
+
+const std::vector<SyncVarBase*>& NetworkedObject::getOrderedSyncVars() const {
+    // Hash map order differs between processes, so the wire order comes from the names
+    if (m_syncVarOrderDirty) {
+        std::map<std::string, SyncVarBase*> sorted(m_syncVars.begin(), m_syncVars.end());
+        m_orderedSyncVars.clear();
+        for (const auto& pair : sorted) {
+            m_orderedSyncVars.push_back(pair.second);
+        }
+        m_syncVarOrderDirty = false;
+    }
+    return m_orderedSyncVars;
 }
 
 SyncVarBase* NetworkedObject::getSyncVar(const std::string& name) {
@@ -216,8 +234,8 @@ void NetworkedObject::serialize(std::vector<uint8_t>& buffer) const {
     }
     
     // Serialize sync vars
-    for (const auto& pair : m_syncVars) {
-        pair.second->serialize(buffer);
+    for (SyncVarBase* syncVar : getOrderedSyncVars()) {
+        syncVar->serialize(buffer);
     }
 }
 
@@ -236,8 +254,8 @@ void NetworkedObject::deserialize(const std::vector<uint8_t>& buffer) {
     }
     
     // Deserialize sync vars
-    for (auto& pair : m_syncVars) {
-        pair.second->deserialize(buffer, offset);
+    for (SyncVarBase* syncVar : getOrderedSyncVars()) {
+        syncVar->deserialize(buffer, offset);
     }
 }
 
@@ -324,7 +342,12 @@ StateSynchronizer::StateSynchronizer()
     , m_interpolationTime(0)
     , m_predictionEnabled(false)
     , m_bandwidthLimit(1024 * 1024)
-    , m_bandwidthUsage(0) {
+    , m_bandwidthUsage(0)
+    , m_frames(SNAPSHOT_HISTORY)
+    , m_latestSnapshot(NO_SNAPSHOT)
+    , m_lastReceivedSnapshot(NO_SNAPSHOT)
+    , m_interestManager(nullptr) {
+    setQuantization(SnapshotQuantization());
     resetStats();
 }
 
@@ -343,6 +366,13 @@ void StateSynchronizer::shutdown() {
     m_snapshotBuffer.clear();
     m_rpcHandlers.clear();
     m_pendingRPCs.clear();
+    m_clients.clear();
+    for (Frame& frame : m_frames) {
+        frame.clear();
+    }
+    m_latestSnapshot = NO_SNAPSHOT;
+    m_lastReceivedSnapshot = NO_SNAPSHOT;
+    m_appliedFrom.clear();
 }
 
 void StateSynchronizer::registerObject(NetworkedObject* object) {
@@ -352,6 +382,9 @@ void StateSynchronizer::registerObject(NetworkedObject* object) {
 
 void StateSynchronizer::unregisterObject(uint32_t networkId) {
     m_objects.erase(networkId);
+    if (m_interestManager) {
+        m_interestManager->removeObject(networkId);
+    }
     m_stats.objectCount = m_objects.size();
 }
 
@@ -364,9 +397,9 @@ void StateSynchronizer::update(float deltaTime) {
     double currentTime = getCurrentTime();
     
     if (m_isServer) {
-        // Server: Generate snapshots at regular intervals
+        // Server: Capture snapshots at regular intervals for writeSnapshot()
         if (currentTime - m_lastSnapshotTime >= 1.0 / m_snapshotRate) {
-            generateSnapshot();
+            captureSnapshot();
             m_lastSnapshotTime = currentTime;
         }
     } else {
@@ -427,6 +460,735 @@ void StateSynchronizer::applySnapshot(const StateSnapshot& snapshot) {
     }
 }
 
+// ============================================================================
+// Delta Snapshots
+// ============================================================================
+
+namespace {
+
+// 7-bit groups, least significant first, each followed by a continue bit
+void writeVarUInt(Engine::BitPacker& packer, uint32_t value) {
+    while (value >= 0x80) {
+        packer.writeBits((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    packer.writeBits(value, 8);
+}
+
+int varUIntBits(uint32_t value) {
+    int bits = 8;
+    for (; value >= 0x80; value >>= 7) bits += 8;
+    return bits;
+}
+
+void appendBits(Engine::BitPacker& packer, const std::vector<uint8_t>& data, size_t firstBit,
+                size_t bitCount) {
+    // Up to 24 bits at a time from a 32-bit window
+    while (bitCount > 0) {
+        size_t byteIndex = firstBit / 8;
+        uint32_t window = 0;
+        for (size_t i = 0; i < 4 && byteIndex + i < data.size(); i++) {
+            window |= static_cast<uint32_t>(data[byteIndex + i]) << (8 * i);
+        }
+        int count = static_cast<int>(std::min<size_t>(bitCount, 24));
+        packer.writeBits(window >> (firstBit % 8), count);
+        firstBit += count;
+        bitCount -= count;
+    }
+}
+
+uint32_t readVarUInt(Engine::BitUnpacker& unpacker) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint32_t group = unpacker.readBits(8);
+        value |= (group & 0x7F) << shift;
+        if (!(group & 0x80)) break;
+    }
+    return value;
+}
+
+int bitsFor(float range, float precision) {
+    uint32_t steps = static_cast<uint32_t>(std::ceil(range / precision));
+    int bits = 1;
+    while (bits < 32 && (steps >> bits) != 0) bits++;
+    return bits;
+}
+
+uint32_t quantize(float value, float min, float precision, int bits) {
+    float steps = std::round((value - min) / precision);
+    float maxSteps = static_cast<float>((bits < 32 ? (1u << bits) : 0u) - 1u);
+    return static_cast<uint32_t>(std::max(0.0f, std::min(maxSteps, steps)));
+}
+
+// Smallest three: the largest component is dropped (and made positive), the other three lie
+// in [-1/sqrt(2), 1/sqrt(2)]. The code is the dropped index then the three components
+const float QUATERNION_RANGE = 0.70710678f;
+
+uint32_t quantizeRotation(const float rotation[4], int bits) {
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (std::fabs(rotation[i]) > std::fabs(rotation[largest])) largest = i;
+    }
+    float sign = rotation[largest] < 0.0f ? -1.0f : 1.0f;
+    float precision = 2.0f * QUATERNION_RANGE / static_cast<float>((1u << bits) - 1);
+    
+    uint32_t code = static_cast<uint32_t>(largest);
+    for (int i = 0; i < 4; i++) {
+        if (i == largest) continue;
+        code = (code << bits) | quantize(rotation[i] * sign, -QUATERNION_RANGE, precision, bits);
+    }
+    return code;
+}
+
+void dequantizeRotation(uint32_t code, int bits, float rotation[4]) {
+    float precision = 2.0f * QUATERNION_RANGE / static_cast<float>((1u << bits) - 1);
+    int largest = static_cast<int>(code >> (3 * bits));
+    float sumSquares = 0.0f;
+    for (int i = 3; i >= 0; i--) {
+        if (i == largest) continue;
+        rotation[i] = (code & ((1u << bits) - 1)) * precision - QUATERNION_RANGE;
+        sumSquares += rotation[i] * rotation[i];
+        code >>= bits;
+    }
+    rotation[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+}
+
+}  // namespace
+
+void StateSynchronizer::Frame::clear() {
+    snapshotId = NO_SNAPSHOT;
+    objects.clear();
+    vars.clear();
+    varSizes.clear();
+}
+
+void StateSynchronizer::setQuantization(const SnapshotQuantization& quantization) {
+    m_quantization = quantization;
+    for (int i = 0; i < 3; i++) {
+        m_positionBits[i] = bitsFor(quantization.worldMax[i] - quantization.worldMin[i],
+                                    quantization.positionPrecision);
+    }
+    m_scaleBits = bitsFor(quantization.maxScale, quantization.scalePrecision);
+    m_unitScale = quantize(1.0f, 0.0f, quantization.scalePrecision, m_scaleBits);
+}
+
+void StateSynchronizer::addClient(uint32_t clientId) {
+    ClientState& client = m_clients[clientId];
+    client.acknowledged = NO_SNAPSHOT;
+    client.frames.assign(SNAPSHOT_HISTORY, ClientFrame());
+}
+
+void StateSynchronizer::removeClient(uint32_t clientId) {
+    m_clients.erase(clientId);
+}
+
+void StateSynchronizer::setClientBandwidthLimit(uint32_t clientId, size_t bytesPerSecond) {
+    auto it = m_clients.find(clientId);
+    if (it != m_clients.end()) {
+        it->second.bandwidthLimit = bytesPerSecond;
+    }
+}
+
+StateSynchronizer::ClientStats StateSynchronizer::getClientStats(uint32_t clientId) const {
+    auto it = m_clients.find(clientId);
+    return it != m_clients.end() ? it->second.stats : ClientStats{};
+}
+
+uint32_t StateSynchronizer::captureSnapshot() {
+    uint32_t snapshotId = m_latestSnapshot == NO_SNAPSHOT ? 0 : m_latestSnapshot + 1;
+    Frame& frame = m_frames[snapshotId % SNAPSHOT_HISTORY];
+    frame.clear();
+    frame.snapshotId = snapshotId;
+    
+    std::vector<uint32_t> ids;
+    ids.reserve(m_objects.size());
+    for (const auto& pair : m_objects) {
+        ids.push_back(pair.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    for (uint32_t id : ids) {
+        quantizeObject(*m_objects[id], frame);
+    }
+    
+    if (m_interestManager) {
+        for (const auto& pair : m_objects) {
+            m_interestManager->setObjectPosition(pair.first, pair.second->getTransform().position);
+        }
+        m_interestManager->update();
+    }
+    m_stats.entitiesSent = 0;
+    m_stats.entitiesDeferred = 0;
+    m_latestSnapshot = snapshotId;
+    return snapshotId;
+}
+
+void StateSynchronizer::quantizeObject(const NetworkedObject& object, Frame& frame) const {
+    const NetworkTransform& transform = object.getTransform();
+    QuantizedState state;
+    state.networkId = object.getNetworkId();
+    for (int i = 0; i < 3; i++) {
+        state.position[i] = quantize(transform.position[i], m_quantization.worldMin[i],
+                                     m_quantization.positionPrecision, m_positionBits[i]);
+        state.scale[i] = quantize(transform.scale[i], 0.0f, m_quantization.scalePrecision,
+                                  m_scaleBits);
+    }
+    state.rotation = quantizeRotation(transform.rotation, m_quantization.rotationBits);
+    
+    state.varOffset = static_cast<uint32_t>(frame.vars.size());
+    state.firstVar = static_cast<uint32_t>(frame.varSizes.size());
+    state.varCount = 0;
+    for (SyncVarBase* syncVar : object.getOrderedSyncVars()) {
+        size_t before = frame.vars.size();
+        syncVar->serialize(frame.vars);
+        frame.varSizes.push_back(static_cast<uint16_t>(frame.vars.size() - before));
+        state.varCount++;
+    }
+    frame.objects.push_back(state);
+}
+
+const StateSynchronizer::Frame* StateSynchronizer::findFrame(uint32_t snapshotId) const {
+    if (snapshotId == NO_SNAPSHOT) return nullptr;
+    const Frame& frame = m_frames[snapshotId % SNAPSHOT_HISTORY];
+    return frame.snapshotId == snapshotId ? &frame : nullptr;
+}
+
+const StateSynchronizer::QuantizedState* StateSynchronizer::findState(const Frame& frame,
+                                                                      uint32_t networkId) {
+    auto it = std::lower_bound(frame.objects.begin(), frame.objects.end(), networkId,
+                               [](const QuantizedState& state, uint32_t id) {
+                                   return state.networkId < id;
+                               });
+    return it != frame.objects.end() && it->networkId == networkId ? &*it : nullptr;
+}
+
+bool StateSynchronizer::sameLayout(const QuantizedState& a, const Frame& frameA,
+                                   const QuantizedState& b, const Frame& frameB) const {
+    return a.varCount == b.varCount &&
+           std::equal(frameA.varSizes.begin() + a.firstVar,
+                      frameA.varSizes.begin() + a.firstVar + a.varCount,
+                      frameB.varSizes.begin() + b.firstVar);
+}
+
+bool StateSynchronizer::sameState(const QuantizedState& a, const Frame& frameA,
+                                  const QuantizedState& b, const Frame& frameB) const {
+    if (a.rotation != b.rotation || !sameLayout(a, frameA, b, frameB)) return false;
+    for (int i = 0; i < 3; i++) {
+        if (a.position[i] != b.position[i] || a.scale[i] != b.scale[i]) return false;
+    }
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < a.varCount; i++) {
+        size += frameA.varSizes[a.firstVar + i];
+    }
+    return size == 0 || std::memcmp(&frameA.vars[a.varOffset], &frameB.vars[b.varOffset],
+                                    size) == 0;
+}
+
+void StateSynchronizer::writeFullState(Engine::BitPacker& packer, const QuantizedState& state,
+                                       const Frame& frame) const {
+    for (int i = 0; i < 3; i++) {
+        packer.writeBits(state.position[i], m_positionBits[i]);
+    }
+    packer.writeBits(state.rotation, 2 + 3 * m_quantization.rotationBits);
+    
+    bool unitScale = state.scale[0] == m_unitScale && state.scale[1] == m_unitScale &&
+                     state.scale[2] == m_unitScale;
+    packer.writeBool(unitScale);
+    if (!unitScale) {
+        for (int i = 0; i < 3; i++) {
+            packer.writeBits(state.scale[i], m_scaleBits);
+        }
+    }
+    
+    // Sizes go with a full state, so a delta only needs the mask
+    writeVarUInt(packer, state.varCount);
+    uint32_t offset = state.varOffset;
+    for (uint32_t i = 0; i < state.varCount; i++) {
+        uint32_t size = frame.varSizes[state.firstVar + i];
+        writeVarUInt(packer, size);
+        for (uint32_t b = 0; b < size; b++) {
+            packer.writeBits(frame.vars[offset++], 8);
+        }
+    }
+}
+
+void StateSynchronizer::writeDeltaState(Engine::BitPacker& packer, const QuantizedState& state,
+                                        const Frame& frame, const QuantizedState& base,
+                                        const Frame& baseFrame) const {
+    // Moved axes only; a small move is sent as signed steps from the baseline
+    bool moved = state.position[0] != base.position[0] ||
+                 state.position[1] != base.position[1] ||
+                 state.position[2] != base.position[2];
+    packer.writeBool(moved);
+    if (moved) {
+        int32_t smallLimit = 1 << (m_quantization.positionDeltaBits - 1);
+        for (int i = 0; i < 3; i++) {
+            int32_t delta = static_cast<int32_t>(state.position[i] - base.position[i]);
+            packer.writeBool(delta != 0);
+            if (delta == 0) continue;
+            bool small = delta >= -smallLimit && delta < smallLimit;
+            packer.writeBool(small);
+            if (small) {
+                packer.writeSignedBits(delta, m_quantization.positionDeltaBits);
+            } else {
+                packer.writeBits(state.position[i], m_positionBits[i]);
+            }
+        }
+    }
+    
+    packer.writeBool(state.rotation != base.rotation);
+    if (state.rotation != base.rotation) {
+        packer.writeBits(state.rotation, 2 + 3 * m_quantization.rotationBits);
+    }
+    
+    bool scaled = state.scale[0] != base.scale[0] || state.scale[1] != base.scale[1] ||
+                  state.scale[2] != base.scale[2];
+    packer.writeBool(scaled);
+    if (scaled) {
+        for (int i = 0; i < 3; i++) {
+            packer.writeBits(state.scale[i], m_scaleBits);
+        }
+    }
+    
+    // Per-var change mask; the layout matches the baseline's
+    uint32_t offset = state.varOffset, baseOffset = base.varOffset;
+    bool anyChanged = false;
+    for (uint32_t i = 0; i < state.varCount && !anyChanged; i++) {
+        uint32_t size = frame.varSizes[state.firstVar + i];
+        anyChanged = std::memcmp(&frame.vars[offset], &baseFrame.vars[baseOffset], size) != 0;
+        offset += size;
+        baseOffset += size;
+    }
+    packer.writeBool(anyChanged);
+    if (!anyChanged) return;
+    
+    offset = state.varOffset;
+    baseOffset = base.varOffset;
+    for (uint32_t i = 0; i < state.varCount; i++) {
+        uint32_t size = frame.varSizes[state.firstVar + i];
+        bool changed = std::memcmp(&frame.vars[offset], &baseFrame.vars[baseOffset], size) != 0;
+        packer.writeBool(changed);
+        for (uint32_t b = 0; changed && b < size; b++) {
+            packer.writeBits(frame.vars[offset + b], 8);
+        }
+        offset += size;
+        baseOffset += size;
+    }
+}
+
+void StateSynchronizer::writeSnapshot(uint32_t clientId, std::vector<uint8_t>& packet) {
+    packet.clear();
+    auto clientIt = m_clients.find(clientId);
+    const Frame* current = findFrame(m_latestSnapshot);
+    if (clientIt == m_clients.end() || !current) return;
+    ClientState& client = clientIt->second;
+    
+    // The acknowledged frame is a baseline while both ends still hold it
+    const ClientFrame* baseline = nullptr;
+    if (client.acknowledged != NO_SNAPSHOT && client.acknowledged < current->snapshotId &&
+        current->snapshotId - client.acknowledged < SNAPSHOT_HISTORY) {
+        const ClientFrame& frame = client.frames[client.acknowledged % SNAPSHOT_HISTORY];
+        if (frame.snapshotId == client.acknowledged) baseline = &frame;
+    }
+    
+    Engine::BitPacker packer;
+    packer.writeBits(current->snapshotId, 32);
+    writeVarUInt(packer, baseline ? current->snapshotId - baseline->snapshotId : 0);
+    
+    ClientFrame& sent = client.frames[current->snapshotId % SNAPSHOT_HISTORY];
+    std::vector<std::pair<uint32_t, uint32_t>> sentObjects;
+    sentObjects.swap(sent.objects);
+    sentObjects.clear();
+    
+    // Objects that are gone or no longer relevant are removed, unchanged ones are left out and
+    // changed ones compete for the packet. All three stay in id order
+    if (m_interestManager) {
+        gatherRelevant(clientId);
+    }
+    m_candidates.clear();
+    m_removals.clear();
+    auto remove = [&](uint32_t networkId) {
+        m_removals.push_back(networkId);
+        client.priorities.erase(networkId);
+    };
+    
+    size_t b = 0, r = 0;
+    const size_t baseCount = baseline ? baseline->objects.size() : 0;
+    int relevantCount = 0;
+    for (uint32_t i = 0; i < current->objects.size(); i++) {
+        const QuantizedState& state = current->objects[i];
+        while (b < baseCount && baseline->objects[b].first < state.networkId) {
+            remove(baseline->objects[b++].first);
+        }
+        uint32_t baselineSource = NO_SNAPSHOT;
+        if (b < baseCount && baseline->objects[b].first == state.networkId) {
+            baselineSource = baseline->objects[b++].second;
+        }
+        
+        float relevance = 1.0f;
+        if (m_interestManager) {
+            while (r < m_relevant.size() && m_relevant[r].objectId < state.networkId) r++;
+            if (r == m_relevant.size() || m_relevant[r].objectId != state.networkId) {
+                if (baselineSource != NO_SNAPSHOT) remove(state.networkId);
+                continue;
+            }
+            relevance = m_relevant[r].relevance;
+        }
+        relevantCount++;
+        
+        const Frame* baseFrame = findFrame(baselineSource);
+        const QuantizedState* base = baseFrame ? findState(*baseFrame, state.networkId) : nullptr;
+        sentObjects.emplace_back(state.networkId, current->snapshotId);
+        if (base && sameState(state, *current, *base, *baseFrame)) {
+            client.priorities.erase(state.networkId);
+            continue;
+        }
+        
+        // Waiting objects gain priority every snapshot, near and important ones faster
+        float& priority = client.priorities[state.networkId];
+        priority += (1.0f + std::max(0, getPriority(state.networkId))) *
+                    (0.25f + 0.75f * relevance);
+        Candidate candidate;
+        candidate.stateIndex = i;
+        candidate.base = base;
+        candidate.baseFrame = baseFrame;
+        candidate.baselineSource = baselineSource;
+        candidate.priority = &priority;
+        candidate.sentIndex = static_cast<uint32_t>(sentObjects.size() - 1);
+        m_candidates.push_back(candidate);
+    }
+    while (b < baseCount) {
+        remove(baseline->objects[b++].first);
+    }
+    
+    // Encode every candidate aside. An id costs at most its full varint, since the packet
+    // sends gaps
+    Engine::BitPacker entryBits;
+    size_t usedBits = packer.getBitSize() + varUIntBits(0);
+    for (uint32_t networkId : m_removals) {
+        usedBits += varUIntBits(networkId + 1) + 1;
+    }
+    size_t candidateBits = 0;
+    for (Candidate& candidate : m_candidates) {
+        const QuantizedState& state = current->objects[candidate.stateIndex];
+        candidate.firstBit = entryBits.getBitSize();
+        entryBits.writeBool(false);
+        bool delta = candidate.base &&
+                     sameLayout(state, *current, *candidate.base, *candidate.baseFrame);
+        entryBits.writeBool(!delta);
+        if (delta) {
+            writeDeltaState(entryBits, state, *current, *candidate.base, *candidate.baseFrame);
+        } else {
+            writeFullState(entryBits, state, *current);
+        }
+        candidate.bitCount = entryBits.getBitSize() - candidate.firstBit;
+        candidate.selected = true;
+        candidateBits += candidate.bitCount + varUIntBits(state.networkId + 1);
+    }
+    
+    // Over budget: highest priority first until one does not fit. The first always goes so a
+    // tiny budget still makes progress
+    const size_t limit = client.bandwidthLimit > 0 ? client.bandwidthLimit : m_bandwidthLimit;
+    const size_t budgetBytes =
+        limit > 0 && m_snapshotRate > 0.0f ? static_cast<size_t>(limit / m_snapshotRate) : 0;
+    int sentCount = static_cast<int>(m_candidates.size()), deferredCount = 0;
+    if (budgetBytes > 0 && usedBits + candidateBits > budgetBytes * 8) {
+        m_order.resize(m_candidates.size());
+        for (uint32_t i = 0; i < m_order.size(); i++) {
+            m_order[i] = i;
+        }
+        std::stable_sort(m_order.begin(), m_order.end(), [this](uint32_t a, uint32_t b) {
+            return *m_candidates[a].priority > *m_candidates[b].priority;
+        });
+        sentCount = 0;
+        for (uint32_t index : m_order) {
+            Candidate& candidate = m_candidates[index];
+            size_t cost = candidate.bitCount +
+                          varUIntBits(current->objects[candidate.stateIndex].networkId + 1);
+            candidate.selected = deferredCount == 0 &&
+                                 (sentCount == 0 || usedBits + cost <= budgetBytes * 8);
+            if (candidate.selected) {
+                usedBits += cost;
+                sentCount++;
+            } else {
+                deferredCount++;
+            }
+        }
+    }
+    
+    // Deferred objects keep the state the client holds, if any
+    for (const Candidate& candidate : m_candidates) {
+        if (candidate.selected) {
+            *candidate.priority = 0.0f;
+        } else {
+            sentObjects[candidate.sentIndex].second = candidate.baselineSource;
+        }
+    }
+    if (deferredCount > 0) {
+        sentObjects.erase(std::remove_if(sentObjects.begin(), sentObjects.end(),
+                                         [](const std::pair<uint32_t, uint32_t>& object) {
+                                             return object.second == NO_SNAPSHOT;
+                                         }),
+                          sentObjects.end());
+    }
+    
+    // Removals and sent candidates merged in id order
+    uint32_t previousId = 0;
+    auto writeId = [&](uint32_t id) {
+        writeVarUInt(packer, id - previousId + 1);
+        previousId = id;
+    };
+    size_t removal = 0;
+    for (const Candidate& candidate : m_candidates) {
+        if (!candidate.selected) continue;
+        uint32_t networkId = current->objects[candidate.stateIndex].networkId;
+        while (removal < m_removals.size() && m_removals[removal] < networkId) {
+            writeId(m_removals[removal++]);
+            packer.writeBool(true);
+        }
+        writeId(networkId);
+        appendBits(packer, entryBits.getData(), candidate.firstBit, candidate.bitCount);
+    }
+    while (removal < m_removals.size()) {
+        writeId(m_removals[removal++]);
+        packer.writeBool(true);
+    }
+    writeVarUInt(packer, 0);
+    
+    sent.snapshotId = current->snapshotId;
+    sent.objects.swap(sentObjects);
+    packet = packer.getData();
+    
+    client.stats = ClientStats{relevantCount, sentCount, deferredCount, packet.size(),
+                               budgetBytes};
+    m_stats.entitiesSent += sentCount;
+    m_stats.entitiesDeferred += deferredCount;
+    m_stats.snapshotsSent++;
+    m_stats.bytesUpstream += packet.size();
+    m_stats.avgSnapshotSize += (packet.size() - m_stats.avgSnapshotSize) /
+                               static_cast<float>(m_stats.snapshotsSent);
+    m_bandwidthUsage += packet.size();
+}
+
+void StateSynchronizer::acknowledgeSnapshot(uint32_t clientId, uint32_t snapshotId) {
+    auto it = m_clients.find(clientId);
+    if (it == m_clients.end()) return;
+    
+    // Acks can arrive out of order; only a newer one moves the baseline
+    ClientState& client = it->second;
+    if (client.acknowledged == NO_SNAPSHOT || snapshotId > client.acknowledged) {
+        client.acknowledged = snapshotId;
+    }
+}
+
+void StateSynchronizer::gatherRelevant(uint32_t clientId) {
+    m_relevant.clear();
+    m_interestManager->gatherRelevant(clientId, m_relevant);
+    std::sort(m_relevant.begin(), m_relevant.end(),
+              [](const InterestRelevance& a, const InterestRelevance& b) {
+                  return a.objectId < b.objectId;
+              });
+}
+
+void StateSynchronizer::copyState(const QuantizedState& state, const Frame& from,
+                                  Frame& to) const {
+    QuantizedState copy = state;
+    copy.varOffset = static_cast<uint32_t>(to.vars.size());
+    copy.firstVar = static_cast<uint32_t>(to.varSizes.size());
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < state.varCount; i++) {
+        size += from.varSizes[state.firstVar + i];
+    }
+    to.vars.insert(to.vars.end(), from.vars.begin() + state.varOffset,
+                   from.vars.begin() + state.varOffset + size);
+    to.varSizes.insert(to.varSizes.end(), from.varSizes.begin() + state.firstVar,
+                       from.varSizes.begin() + state.firstVar + state.varCount);
+    to.objects.push_back(copy);
+}
+
+bool StateSynchronizer::readFullState(Engine::BitUnpacker& unpacker, QuantizedState& state,
+                                      Frame& frame) const {
+    for (int i = 0; i < 3; i++) {
+        state.position[i] = unpacker.readBits(m_positionBits[i]);
+    }
+    state.rotation = unpacker.readBits(2 + 3 * m_quantization.rotationBits);
+    bool unitScale = unpacker.readBool();
+    for (int i = 0; i < 3; i++) {
+        state.scale[i] = unitScale ? m_unitScale : unpacker.readBits(m_scaleBits);
+    }
+    
+    state.varOffset = static_cast<uint32_t>(frame.vars.size());
+    state.firstVar = static_cast<uint32_t>(frame.varSizes.size());
+    state.varCount = readVarUInt(unpacker);
+    for (uint32_t i = 0; i < state.varCount; i++) {
+        uint32_t size = readVarUInt(unpacker);
+        if (size > 0xFFFF || unpacker.hasOverrun()) return false;
+        frame.varSizes.push_back(static_cast<uint16_t>(size));
+        for (uint32_t b = 0; b < size; b++) {
+            frame.vars.push_back(static_cast<uint8_t>(unpacker.readBits(8)));
+        }
+    }
+    frame.objects.push_back(state);
+    return true;
+}
+
+void StateSynchronizer::readDeltaState(Engine::BitUnpacker& unpacker, QuantizedState& state,
+                                       Frame& frame, const QuantizedState& base,
+                                       const Frame& baseFrame) const {
+    uint32_t networkId = state.networkId;
+    state = base;
+    state.networkId = networkId;
+    if (unpacker.readBool()) {
+        for (int i = 0; i < 3; i++) {
+            if (!unpacker.readBool()) continue;
+            if (unpacker.readBool()) {
+                int32_t delta = unpacker.readSignedBits(m_quantization.positionDeltaBits);
+                state.position[i] = base.position[i] + static_cast<uint32_t>(delta);
+            } else {
+                state.position[i] = unpacker.readBits(m_positionBits[i]);
+            }
+        }
+    }
+    if (unpacker.readBool()) {
+        state.rotation = unpacker.readBits(2 + 3 * m_quantization.rotationBits);
+    }
+    if (unpacker.readBool()) {
+        for (int i = 0; i < 3; i++) {
+            state.scale[i] = unpacker.readBits(m_scaleBits);
+        }
+    }
+    
+    // Start from the baseline's vars, then overwrite the changed ones
+    size_t start = frame.objects.size();
+    copyState(base, baseFrame, frame);
+    QuantizedState& copy = frame.objects[start];
+    state.varOffset = copy.varOffset;
+    state.firstVar = copy.firstVar;
+    copy = state;
+    if (unpacker.readBool()) {
+        uint32_t offset = state.varOffset;
+        for (uint32_t i = 0; i < state.varCount; i++) {
+            uint32_t size = frame.varSizes[state.firstVar + i];
+            if (unpacker.readBool()) {
+                for (uint32_t b = 0; b < size; b++) {
+                    frame.vars[offset + b] = static_cast<uint8_t>(unpacker.readBits(8));
+                }
+            }
+            offset += size;
+        }
+    }
+}
+
+bool StateSynchronizer::readSnapshot(const std::vector<uint8_t>& packet) {
+    if (packet.size() < 5) return false;
+    Engine::BitUnpacker unpacker(packet.data(), packet.size());
+    uint32_t snapshotId = unpacker.readBits(32);
+    uint32_t back = readVarUInt(unpacker);
+    if (snapshotId == NO_SNAPSHOT || back >= SNAPSHOT_HISTORY) return false;
+    
+    const Frame* baseline = nullptr;
+    if (back != 0) {
+        baseline = findFrame(snapshotId - back);
+        if (!baseline) return false;
+    }
+    
+    // Decoded aside so a truncated packet leaves the ring untouched
+    Frame& frame = m_decodeFrame;
+    frame.clear();
+    frame.snapshotId = snapshotId;
+    m_receivedIds.clear();
+    
+    size_t b = 0;
+    const size_t baseCount = baseline ? baseline->objects.size() : 0;
+    uint32_t previousId = 0;
+    while (true) {
+        uint32_t gap = readVarUInt(unpacker);
+        if (gap == 0) break;
+        if (!unpacker.hasMoreData()) return false;
+        uint32_t networkId = previousId + gap - 1;
+        previousId = networkId;
+        
+        // Objects before this entry are unchanged
+        while (b < baseCount && baseline->objects[b].networkId < networkId) {
+            copyState(baseline->objects[b++], *baseline, frame);
+        }
+        const QuantizedState* base = nullptr;
+        if (b < baseCount && baseline->objects[b].networkId == networkId) {
+            base = &baseline->objects[b++];
+        }
+        
+        if (unpacker.readBool()) continue;  // Removed
+        QuantizedState state;
+        state.networkId = networkId;
+        if (unpacker.readBool()) {
+            if (!readFullState(unpacker, state, frame)) return false;
+        } else {
+            if (!base) return false;
+            readDeltaState(unpacker, state, frame, *base, *baseline);
+        }
+        m_receivedIds.push_back(networkId);
+    }
+    if (unpacker.hasOverrun()) return false;
+    while (b < baseCount) {
+        copyState(baseline->objects[b++], *baseline, frame);
+    }
+    
+    // A late snapshot is only kept as a baseline. A newer one applies the objects it carried,
+    // and baseline copies that differ from the snapshot applied last, unless the object was
+    // sent after the baseline: the server held it back over budget and the client's is newer
+    if (m_lastReceivedSnapshot == NO_SNAPSHOT || snapshotId > m_lastReceivedSnapshot) {
+        const Frame* applied = findFrame(m_lastReceivedSnapshot);
+        size_t received = 0;
+        for (const QuantizedState& state : frame.objects) {
+            while (received < m_receivedIds.size() &&
+                   m_receivedIds[received] < state.networkId) {
+                received++;
+            }
+            if (received < m_receivedIds.size() && m_receivedIds[received] == state.networkId) {
+                applyState(state, frame);
+                m_appliedFrom[state.networkId] = snapshotId;
+                continue;
+            }
+            
+            const QuantizedState* previous =
+                applied ? findState(*applied, state.networkId) : nullptr;
+            if (previous && sameState(state, frame, *previous, *applied)) continue;
+            auto from = m_appliedFrom.find(state.networkId);
+            if (from == m_appliedFrom.end() || from->second <= baseline->snapshotId) {
+                applyState(state, frame);
+            }
+        }
+        m_lastReceivedSnapshot = snapshotId;
+    }
+    std::swap(m_frames[snapshotId % SNAPSHOT_HISTORY], m_decodeFrame);
+    
+    m_stats.snapshotsReceived++;
+    m_stats.bytesDownstream += packet.size();
+    return true;
+}
+
+void StateSynchronizer::applyState(const QuantizedState& state, const Frame& frame) {
+    NetworkedObject* object = getObject(state.networkId);
+    if (!object) return;
+    
+    if (object->getSyncTransform()) {
+        NetworkTransform transform;
+        for (int i = 0; i < 3; i++) {
+            transform.position[i] = m_quantization.worldMin[i] +
+                                    state.position[i] * m_quantization.positionPrecision;
+            transform.scale[i] = state.scale[i] * m_quantization.scalePrecision;
+        }
+        dequantizeRotation(state.rotation, m_quantization.rotationBits, transform.rotation);
+        object->setTransform(transform);
+    }
+    
+    const std::vector<SyncVarBase*>& syncVars = object->getOrderedSyncVars();
+    if (syncVars.size() != state.varCount) return;
+    size_t offset = state.varOffset;
+    for (SyncVarBase* syncVar : syncVars) {
+        syncVar->deserialize(frame.vars, offset);
+    }
+}
+
 void StateSynchronizer::updateInterpolation() {
     double targetTime = getCurrentTime() - m_interpolationDelay;
     
@@ -576,7 +1338,9 @@ float DeltaCompressor::calculateSimilarity(const std::vector<uint8_t>& a,
 // InterestManager Implementation
 // ============================================================================
 
-InterestManager::InterestManager() {
+InterestManager::InterestManager()
+    : m_cellSize(50.0f)
+    , m_tableMask(0) {
 }
 
 void InterestManager::setClientInterest(uint32_t clientId, const Region& region) {
@@ -587,12 +1351,77 @@ void InterestManager::removeClient(uint32_t clientId) {
     m_clientInterests.erase(clientId);
 }
 
+void InterestManager::setObjectPosition(uint32_t objectId, const float position[3]) {
+    auto it = m_objectIndices.find(objectId);
+    if (it == m_objectIndices.end()) {
+        it = m_objectIndices.emplace(objectId, m_objects.size()).first;
+        m_objects.push_back(IndexedObject());
+        m_objects.back().objectId = objectId;
+    }
+    IndexedObject& object = m_objects[it->second];
+    object.position[0] = position[0];
+    object.position[1] = position[1];
+    object.position[2] = position[2];
+}
+
+void InterestManager::removeObject(uint32_t objectId) {
+    auto it = m_objectIndices.find(objectId);
+    if (it == m_objectIndices.end()) return;
+    
+    // Swap with the last; the grid is stale until the next update() anyway
+    size_t index = it->second;
+    m_objectIndices.erase(it);
+    if (index + 1 != m_objects.size()) {
+        m_objects[index] = m_objects.back();
+        m_objectIndices[m_objects[index].objectId] = index;
+    }
+    m_objects.pop_back();
+    m_alwaysRelevant.erase(objectId);
+    m_cellStart.clear();
+}
+
+void InterestManager::setAlwaysRelevant(uint32_t objectId, bool always) {
+    if (always) {
+        m_alwaysRelevant.insert(objectId);
+    } else {
+        m_alwaysRelevant.erase(objectId);
+    }
+}
+
+size_t InterestManager::hashCell(int x, int z) const {
+    uint32_t hash = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(z) * 19349663u;
+    return hash & m_tableMask;
+}
+
+void InterestManager::update() {
+    size_t tableSize = 64;
+    while (tableSize < m_objects.size() * 2) tableSize *= 2;
+    m_tableMask = tableSize - 1;
+    
+    // Counting sort of the objects by hashed cell
+    m_cellStart.assign(tableSize + 1, 0);
+    for (IndexedObject& object : m_objects) {
+        object.cell[0] = static_cast<int>(std::floor(object.position[0] / m_cellSize));
+        object.cell[1] = static_cast<int>(std::floor(object.position[2] / m_cellSize));
+        m_cellStart[hashCell(object.cell[0], object.cell[1]) + 1]++;
+    }
+    for (size_t i = 0; i < tableSize; i++) {
+        m_cellStart[i + 1] += m_cellStart[i];
+    }
+    m_cellObjects.resize(m_objects.size());
+    std::vector<uint32_t> next(m_cellStart.begin(), m_cellStart.end() - 1);
+    for (size_t i = 0; i < m_objects.size(); i++) {
+        const IndexedObject& object = m_objects[i];
+        m_cellObjects[next[hashCell(object.cell[0], object.cell[1])]++] = static_cast<uint32_t>(i);
+    }
+}
+
 bool InterestManager::isRelevant(uint32_t clientId, uint32_t objectId,
                                 const float position[3]) const {
     auto it = m_clientInterests.find(clientId);
     if (it == m_clientInterests.end()) return false;
     
-    return isInRegion(it->second, position);
+    return m_alwaysRelevant.count(objectId) > 0 || isInRegion(it->second, position);
 }
 
 std::vector<uint32_t> InterestManager::getRelevantObjects(
@@ -612,6 +1441,61 @@ std::vector<uint32_t> InterestManager::getRelevantObjects(
     return relevant;
 }
 
+void InterestManager::gatherRelevant(uint32_t clientId,
+                                     std::vector<InterestRelevance>& relevant) const {
+    auto it = m_clientInterests.find(clientId);
+    if (it == m_clientInterests.end()) return;
+    const Region& region = it->second;
+    
+    for (uint32_t objectId : m_alwaysRelevant) {
+        relevant.push_back(InterestRelevance{objectId, 1.0f});
+    }
+    auto consider = [&](const IndexedObject& object) {
+        if (!isInRegion(region, object.position) || m_alwaysRelevant.count(object.objectId)) {
+            return;
+        }
+        float dx = object.position[0] - region.center[0];
+        float dy = object.position[1] - region.center[1];
+        float dz = object.position[2] - region.center[2];
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        float relevance = region.radius > 0.0f ? 1.0f - distance / region.radius : 1.0f;
+        relevant.push_back(InterestRelevance{object.objectId, std::max(0.0f, relevance)});
+    };
+    
+    // Not updated since objects were removed: scan everything
+    if (m_cellStart.empty()) {
+        for (const IndexedObject& object : m_objects) {
+            consider(object);
+        }
+        return;
+    }
+    
+    // Cells overlapping the region on x/z; a cell is matched exactly so hash collisions
+    // inside the region are not visited twice
+    int minX = static_cast<int>(std::floor((region.center[0] - region.radius) / m_cellSize));
+    int maxX = static_cast<int>(std::floor((region.center[0] + region.radius) / m_cellSize));
+    int minZ = static_cast<int>(std::floor((region.center[2] - region.radius) / m_cellSize));
+    int maxZ = static_cast<int>(std::floor((region.center[2] + region.radius) / m_cellSize));
+    if (static_cast<size_t>(maxX - minX + 1) * static_cast<size_t>(maxZ - minZ + 1) >
+        m_objects.size()) {
+        for (const IndexedObject& object : m_objects) {
+            consider(object);
+        }
+        return;
+    }
+    for (int z = minZ; z <= maxZ; z++) {
+        for (int x = minX; x <= maxX; x++) {
+            size_t cell = hashCell(x, z);
+            for (uint32_t i = m_cellStart[cell]; i < m_cellStart[cell + 1]; i++) {
+                const IndexedObject& object = m_objects[m_cellObjects[i]];
+                if (object.cell[0] == x && object.cell[1] == z) {
+                    consider(object);
+                }
+            }
+        }
+    }
+}
+
 bool InterestManager::isInRegion(const Region& region, const float position[3]) const {
     float dx = position[0] - region.center[0];
     float dy = position[1] - region.center[1];
@@ -658,7 +1542,9 @@ NetworkTransform LagCompensator::rewind(uint32_t objectId, double timestamp) con
 }
 
 NetworkTransform LagCompensator::compensate(uint32_t objectId, float clientLatency) const {
-    double targetTime = getCurrentTime() - clientLatency;
+    double now = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    double targetTime = now - clientLatency;
     return rewind(objectId, targetTime);
 }
 
@@ -0,0 +1,140 @@
+#include "physics/BodyStore.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace JJM {
+namespace Physics {
+
+BodyStore::BodyStore() : m_count(0), m_gravity(0, 0), m_deltaTime(0.0f) {}
+
+void BodyStore::onEntityAdded(ECS::Entity* entity) {
+    const uint32_t slot = ECS::getEntityIndex(entity->getID());
+    if (slot >= m_positions.size()) {
+        m_positions.resize(slot + 1, 0);
+    }
+    m_entities.push_back(entity);
+    m_bodies.push_back(entity->getComponent<PhysicsBody>());
+    m_positions[slot] = static_cast<uint32_t>(m_entities.size());
+}
+
+void BodyStore::onEntityRemoved(ECS::Entity* entity) {
+    const uint32_t slot = ECS::getEntityIndex(entity->getID());
+    const uint32_t member = m_positions[slot] - 1;
+    const size_t last = m_entities.size() - 1;
+    if (member != last) {
+        m_entities[member] = m_entities[last];
+        m_bodies[member] = m_bodies[last];
+        m_positions[ECS::getEntityIndex(m_entities[member]->getID())] = member + 1;
+    }
+    m_entities.pop_back();
+    m_bodies.pop_back();
+    m_positions[slot] = 0;
+}
+
+void BodyStore::refreshBodies() {
+    for (size_t i = 0; i < m_entities.size(); ++i) {
+        m_bodies[i] = m_entities[i]->getComponent<PhysicsBody>();
+    }
+}
+
+void BodyStore::beginIntegration(const Math::Vector2D& gravity, float deltaTime) {
+    m_count = 0;
+    m_gravity = gravity;
+    m_deltaTime = deltaTime;
+}
+
+int BodyStore::getSimdWidth() {
+#if defined(__AVX__)
+    return 8;
+#elif defined(__SSE2__) || defined(__ARM_NEON)
+    return 4;
+#else
+    return 1;
+#endif
+}
+
+// Same operation order as applyGravity + integrateVelocity: force += gravity * mass,
+// acceleration = force * inverseMass, velocity += acceleration * deltaTime
+void BodyStore::flushBlock() {
+    const size_t count = m_count;
+    if (count == 0) return;
+
+    float* velocityX = m_velocityX;
+    float* velocityY = m_velocityY;
+    const float* forceX = m_forceX;
+    const float* forceY = m_forceY;
+    const float* inverseMass = m_inverseMass;
+    const float* gravityMass = m_gravityMass;
+    const float deltaTime = m_deltaTime;
+    size_t i = 0;
+
+#if defined(__AVX__)
+    const __m256 gx8 = _mm256_set1_ps(m_gravity.x);
+    const __m256 gy8 = _mm256_set1_ps(m_gravity.y);
+    const __m256 dt8 = _mm256_set1_ps(deltaTime);
+    for (; i + 8 <= count; i += 8) {
+        __m256 invMass = _mm256_load_ps(inverseMass + i);
+        __m256 mass = _mm256_load_ps(gravityMass + i);
+        __m256 fx = _mm256_add_ps(_mm256_load_ps(forceX + i), _mm256_mul_ps(gx8, mass));
+        __m256 fy = _mm256_add_ps(_mm256_load_ps(forceY + i), _mm256_mul_ps(gy8, mass));
+        __m256 ax = _mm256_mul_ps(fx, invMass);
+        __m256 ay = _mm256_mul_ps(fy, invMass);
+        _mm256_store_ps(velocityX + i,
+                        _mm256_add_ps(_mm256_load_ps(velocityX + i), _mm256_mul_ps(ax, dt8)));
+        _mm256_store_ps(velocityY + i,
+                        _mm256_add_ps(_mm256_load_ps(velocityY + i), _mm256_mul_ps(ay, dt8)));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128 gx4 = _mm_set1_ps(m_gravity.x);
+    const __m128 gy4 = _mm_set1_ps(m_gravity.y);
+    const __m128 dt4 = _mm_set1_ps(deltaTime);
+    for (; i + 4 <= count; i += 4) {
+        __m128 invMass = _mm_load_ps(inverseMass + i);
+        __m128 mass = _mm_load_ps(gravityMass + i);
+        __m128 fx = _mm_add_ps(_mm_load_ps(forceX + i), _mm_mul_ps(gx4, mass));
+        __m128 fy = _mm_add_ps(_mm_load_ps(forceY + i), _mm_mul_ps(gy4, mass));
+        __m128 ax = _mm_mul_ps(fx, invMass);
+        __m128 ay = _mm_mul_ps(fy, invMass);
+        _mm_store_ps(velocityX + i, _mm_add_ps(_mm_load_ps(velocityX + i), _mm_mul_ps(ax, dt4)));
+        _mm_store_ps(velocityY + i, _mm_add_ps(_mm_load_ps(velocityY + i), _mm_mul_ps(ay, dt4)));
+    }
+#elif defined(__ARM_NEON)
+    const float32x4_t gx4 = vdupq_n_f32(m_gravity.x);
+    const float32x4_t gy4 = vdupq_n_f32(m_gravity.y);
+    const float32x4_t dt4 = vdupq_n_f32(deltaTime);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t invMass = vld1q_f32(inverseMass + i);
+        float32x4_t mass = vld1q_f32(gravityMass + i);
+        float32x4_t fx = vaddq_f32(vld1q_f32(forceX + i), vmulq_f32(gx4, mass));
+        float32x4_t fy = vaddq_f32(vld1q_f32(forceY + i), vmulq_f32(gy4, mass));
+        float32x4_t ax = vmulq_f32(fx, invMass);
+        float32x4_t ay = vmulq_f32(fy, invMass);
+        vst1q_f32(velocityX + i, vaddq_f32(vld1q_f32(velocityX + i), vmulq_f32(ax, dt4)));
+        vst1q_f32(velocityY + i, vaddq_f32(vld1q_f32(velocityY + i), vmulq_f32(ay, dt4)));
+    }
+#endif
+    for (; i < count; ++i) {
+        float ax = (forceX[i] + m_gravity.x * gravityMass[i]) * inverseMass[i];
+        float ay = (forceY[i] + m_gravity.y * gravityMass[i]) * inverseMass[i];
+        velocityX[i] = velocityX[i] + ax * deltaTime;
+        velocityY[i] = velocityY[i] + ay * deltaTime;
+    }
+
+    // integrateVelocity() ends with clearForces(), which also zeroes the acceleration
+    for (size_t j = 0; j < count; ++j) {
+        PhysicsBody* body = m_blockBodies[j];
+        body->velocity.x = velocityX[j];
+        body->velocity.y = velocityY[j];
+        body->force = Math::Vector2D(0, 0);
+        body->acceleration = Math::Vector2D(0, 0);
+    }
+    m_count = 0;
+}
+
+} // namespace Physics
+} // namespace JJM
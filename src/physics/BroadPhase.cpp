@@ -5,12 +5,6 @@
 namespace Engine {
 
 // AABB Implementation
-bool AABB::intersects(const AABB& other) const {
-    return !(maxX < other.minX || minX > other.maxX ||
-             maxY < other.minY || minY > other.maxY ||
-             maxZ < other.minZ || minZ > other.maxZ);
-}
-
 float AABB::surfaceArea() const {
     float dx = maxX - minX;
     float dy = maxY - minY;
@@ -244,30 +238,6 @@ AABB DynamicAABBTree::getAABB(int proxyId) const {
     return m_nodes[proxyId].aabb;
 }
 
-void DynamicAABBTree::query(const AABB& bounds, std::function<bool(int)> callback) const {
-    std::vector<int> stack;
-    stack.reserve(256);
-    stack.push_back(m_root);
-    
-    while (!stack.empty()) {
-        int nodeId = stack.back();
-        stack.pop_back();
-        
-        if (nodeId == -1) continue;
-        
-        const Node& node = m_nodes[nodeId];
-        if (node.aabb.intersects(bounds)) {
-            if (node.isLeaf()) {
-                bool proceed = callback(nodeId);
-                if (!proceed) return;
-            } else {
-                stack.push_back(node.child1);
-                stack.push_back(node.child2);
-            }
-        }
-    }
-}
-
 int DynamicAABBTree::allocateNode() {
     if (m_freeList == -1) {
         int oldCapacity = m_nodeCapacity;
@@ -520,4 +490,138 @@ int DynamicAABBTree::balance(int iA) {
     return iA;
 }
 
+// SweepAndPrune Implementation
+SweepAndPrune::SweepAndPrune() : m_needsFullSort(false) {}
+
+SweepAndPrune::~SweepAndPrune() {
+    clear();
+}
+
+void SweepAndPrune::addObject(int id, const AABB& bounds, bool isStatic) {
+    if (findObject(id) >= 0) {
+        updateObject(id, bounds);
+        return;
+    }
+    
+    int index = static_cast<int>(m_objects.size());
+    m_objects.push_back({id, bounds, isStatic});
+    m_indexById[id] = index;
+    
+    m_endpoints.push_back({bounds.minX, index, true});
+    m_endpoints.push_back({bounds.maxX, index, false});
+    
+    // Appended endpoints can land anywhere; a bulk insert is cheaper to sort from scratch
+    m_needsFullSort = true;
+}
+
+void SweepAndPrune::removeObject(int id) {
+    int index = findObject(id);
+    if (index < 0) return;
+    
+    int last = static_cast<int>(m_objects.size()) - 1;
+    
+    m_endpoints.erase(
+        std::remove_if(m_endpoints.begin(), m_endpoints.end(),
+                       [index](const Endpoint& e) { return e.index == index; }),
+        m_endpoints.end()
+    );
+    
+    if (index != last) {
+        m_objects[index] = m_objects[last];
+        m_indexById[m_objects[index].id] = index;
+        for (auto& endpoint : m_endpoints) {
+            if (endpoint.index == last) {
+                endpoint.index = index;
+            }
+        }
+    }
+    
+    m_objects.pop_back();
+    m_indexById.erase(id);
+}
+
+void SweepAndPrune::updateObject(int id, const AABB& newBounds) {
+    int index = findObject(id);
+    if (index < 0) return;
+    
+    // Endpoint values are refreshed lazily in sortEndpoints()
+    m_objects[index].bounds = newBounds;
+}
+
+void SweepAndPrune::computeOverlaps(std::vector<std::pair<int, int>>& outPairs) {
+    outPairs.clear();
+    sortEndpoints();
+    
+    m_active.clear();
+    for (const Endpoint& endpoint : m_endpoints) {
+        if (!endpoint.isMin) {
+            auto it = std::find(m_active.begin(), m_active.end(), endpoint.index);
+            *it = m_active.back();
+            m_active.pop_back();
+            continue;
+        }
+        
+        const ObjectData& a = m_objects[endpoint.index];
+        for (int activeIndex : m_active) {
+            const ObjectData& b = m_objects[activeIndex];
+            if (a.isStatic && b.isStatic) continue;
+            
+            // X overlap is implied by the sweep
+            if (a.bounds.maxY < b.bounds.minY || a.bounds.minY > b.bounds.maxY ||
+                a.bounds.maxZ < b.bounds.minZ || a.bounds.minZ > b.bounds.maxZ) {
+                continue;
+            }
+            
+            outPairs.emplace_back(b.id, a.id);
+        }
+        m_active.push_back(endpoint.index);
+    }
+}
+
+void SweepAndPrune::queryRegion(const AABB& bounds, std::vector<int>& outObjects) const {
+    outObjects.clear();
+    for (const auto& object : m_objects) {
+        if (object.bounds.intersects(bounds)) {
+            outObjects.push_back(object.id);
+        }
+    }
+}
+
+void SweepAndPrune::clear() {
+    m_endpoints.clear();
+    m_objects.clear();
+    m_indexById.clear();
+    m_active.clear();
+    m_needsFullSort = false;
+}
+
+void SweepAndPrune::sortEndpoints() {
+    for (auto& endpoint : m_endpoints) {
+        const AABB& bounds = m_objects[endpoint.index].bounds;
+        endpoint.value = endpoint.isMin ? bounds.minX : bounds.maxX;
+    }
+    
+    if (m_needsFullSort) {
+        std::sort(m_endpoints.begin(), m_endpoints.end());
+        m_needsFullSort = false;
+        return;
+    }
+    
+    // Insertion sort: close to linear when objects only moved slightly since last step
+    for (size_t i = 1; i < m_endpoints.size(); ++i) {
+        Endpoint key = m_endpoints[i];
+        size_t j = i;
+        while (j > 0 && key < m_endpoints[j - 1]) {
+            m_endpoints[j] = m_endpoints[j - 1];
+            --j;
+        }
+        m_endpoints[j] = key;
+    }
+}
+
+int SweepAndPrune::findObject(int id) const {
+    auto it = m_indexById.find(id);
+    return it != m_indexById.end() ? it->second : -1;
+}
+
 } // namespace Engine
@@ -67,7 +67,7 @@ bool CircleCollider::checkCircleCircle(const CircleCollider* other, CollisionInf
         info.colliding = true;
         info.penetration = radiusSum - dist;
         info.normal = (dist > 0.0f) ? diff / dist : Math::Vector2D(1, 0);
-        info.other = other->owner;
+        info.other = other->getOwner();
         return true;
     }
     
@@ -92,8 +92,9 @@ bool CircleCollider::checkCircleBox(const BoxCollider* other, CollisionInfo& inf
         float dist = std::sqrt(distSquared);
         info.colliding = true;
         info.penetration = radius - dist;
-        info.normal = (dist > 0.0f) ? diff / dist : Math::Vector2D(0, -1);
-        info.other = other->owner;
+        // Normals point from this collider toward the other one
+        info.normal = (dist > 0.0f) ? -(diff / dist) : Math::Vector2D(0, 1);
+        info.other = other->getOwner();
         return true;
     }
     
@@ -152,14 +153,14 @@ bool BoxCollider::checkBoxBox(const BoxCollider* other, CollisionInfo& info) con
     if (overlapX < overlapY) {
         info.penetration = overlapX;
         info.normal = (getPosition().x < other->getPosition().x) 
-            ? Math::Vector2D(-1, 0) : Math::Vector2D(1, 0);
+            ? Math::Vector2D(1, 0) : Math::Vector2D(-1, 0);
     } else {
         info.penetration = overlapY;
         info.normal = (getPosition().y < other->getPosition().y) 
-            ? Math::Vector2D(0, -1) : Math::Vector2D(0, 1);
+            ? Math::Vector2D(0, 1) : Math::Vector2D(0, -1);
     }
     
-    info.other = other->owner;
+    info.other = other->getOwner();
     return true;
 }
 
@@ -168,6 +169,7 @@ bool BoxCollider::checkBoxCircle(const CircleCollider* other, CollisionInfo& inf
     bool result = other->checkCircleBox(this, info);
     if (result) {
         info.normal = -info.normal;
+        info.other = other->getOwner();
     }
     return result;
 }
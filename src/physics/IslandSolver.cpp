@@ -0,0 +1,576 @@
+#include "physics/IslandSolver.h"
+#include "physics/Constraints.h"
+#include "physics/PhysicsWorld.h"
+#include "threading/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace JJM {
+namespace Physics {
+
+namespace {
+
+// Islands are grouped into jobs of roughly this many bodies so lone bodies don't each
+// pay for a job submission
+constexpr int BODIES_PER_JOB = 128;
+
+bool isSolverBody(const PhysicsBody* body) {
+    return body && body->type == BodyType::DYNAMIC && body->isEnabled();
+}
+
+bool isAwakeSolverBody(const PhysicsBody* body) {
+    return isSolverBody(body) && body->isAwake();
+}
+
+float inverseMassOf(const PhysicsBody* body) {
+    return body ? body->getSolverInverseMass() : 0.0f;
+}
+
+Math::Vector2D velocityOf(const PhysicsBody* body) {
+    return body ? body->velocity : Math::Vector2D(0, 0);
+}
+
+Math::Vector2D tangentOf(const Math::Vector2D& normal) {
+    return Math::Vector2D(normal.y, -normal.x);
+}
+
+bool pairLess(const ContactManifold& manifold, ECS::EntityID idA, ECS::EntityID idB) {
+    return manifold.idA < idA || (manifold.idA == idA && manifold.idB < idB);
+}
+
+bool manifoldLess(const ContactManifold& a, const ContactManifold& b) {
+    return pairLess(a, b.idA, b.idB);
+}
+
+} // namespace
+
+IslandSolver::IslandSolver() : m_jobSystem(nullptr), m_sortedCount(0), m_stamp(0) {}
+
+IslandSolver::~IslandSolver() = default;
+
+// Contacts
+
+void IslandSolver::beginContacts() {
+    for (auto& manifold : m_manifolds) {
+        manifold.touched = false;
+    }
+}
+
+void IslandSolver::addContact(ECS::EntityID idA, PhysicsBody* bodyA, ECS::EntityID idB,
+                              PhysicsBody* bodyB, const CollisionInfo& info) {
+    // Store pairs in ID order so the same pair maps to one manifold whichever way it was found
+    Math::Vector2D normal = info.normal;
+    if (idB < idA) {
+        std::swap(idA, idB);
+        std::swap(bodyA, bodyB);
+        normal = -normal;
+    }
+
+    auto sortedEnd = m_manifolds.begin() + m_sortedCount;
+    auto it = std::lower_bound(m_manifolds.begin(), sortedEnd, idA,
+                               [idB](const ContactManifold& manifold, ECS::EntityID id) {
+                                   return pairLess(manifold, id, idB);
+                               });
+    ContactManifold* manifold;
+    if (it != sortedEnd && it->idA == idA && it->idB == idB) {
+        manifold = &*it;
+        // A flipped normal means the old impulses point the wrong way
+        if (manifold->normal.dot(normal) < 0.0f) {
+            manifold->normalImpulse = 0.0f;
+            manifold->tangentImpulse = 0.0f;
+        }
+    } else if (m_manifolds.size() > m_sortedCount && m_manifolds.back().idA == idA &&
+               m_manifolds.back().idB == idB) {
+        // Reported twice this step; pairs arrive in ID order so repeats are adjacent
+        manifold = &m_manifolds.back();
+    } else {
+        m_manifolds.emplace_back();
+        manifold = &m_manifolds.back();
+        manifold->idA = idA;
+        manifold->idB = idB;
+        manifold->normalImpulse = 0.0f;
+        manifold->tangentImpulse = 0.0f;
+    }
+
+    float frictionA = bodyA ? bodyA->friction : (bodyB ? bodyB->friction : 0.0f);
+    float frictionB = bodyB ? bodyB->friction : frictionA;
+    float restitutionA = bodyA ? bodyA->restitution : (bodyB ? bodyB->restitution : 0.0f);
+    float restitutionB = bodyB ? bodyB->restitution : restitutionA;
+
+    manifold->bodyA = bodyA;
+    manifold->bodyB = bodyB;
+    manifold->normal = normal;
+    manifold->penetration = info.penetration;
+    manifold->originA = bodyA ? bodyA->position : Math::Vector2D(0, 0);
+    manifold->originB = bodyB ? bodyB->position : Math::Vector2D(0, 0);
+    manifold->friction = std::sqrt(frictionA * frictionB);
+    manifold->restitution = std::min(restitutionA, restitutionB);
+    manifold->touched = true;
+}
+
+void IslandSolver::endContacts(const BodyResolver& resolveBody) {
+    // Compact in place so surviving manifolds keep their relative order
+    size_t kept = 0;
+    size_t keptSorted = 0;
+    for (size_t i = 0; i < m_manifolds.size(); ++i) {
+        ContactManifold& manifold = m_manifolds[i];
+        bool keep = manifold.touched;
+
+        if (!keep && resolveBody(manifold.idA, manifold.bodyA) &&
+            resolveBody(manifold.idB, manifold.bodyB)) {
+            // Untouched because the broad phase skipped it, not because it separated
+            keep = !isAwakeSolverBody(manifold.bodyA) && !isAwakeSolverBody(manifold.bodyB);
+        }
+
+        if (!keep) continue;
+        if (kept != i) {
+            m_manifolds[kept] = manifold;
+        }
+        ++kept;
+        if (i < m_sortedCount) {
+            keptSorted = kept;
+        }
+    }
+    m_manifolds.resize(kept);
+
+    // Pairs new this step usually arrive sorted already
+    auto middle = m_manifolds.begin() + keptSorted;
+    if (!std::is_sorted(middle, m_manifolds.end(), manifoldLess)) {
+        std::sort(middle, m_manifolds.end(), manifoldLess);
+    }
+    std::inplace_merge(m_manifolds.begin(), middle, m_manifolds.end(), manifoldLess);
+    m_sortedCount = m_manifolds.size();
+}
+
+void IslandSolver::clearContacts() {
+    m_manifolds.clear();
+    m_sortedCount = 0;
+}
+
+void IslandSolver::restoreContacts(const std::vector<ContactManifold>& contacts) {
+    m_manifolds = contacts;
+    for (auto& manifold : m_manifolds) {
+        manifold.bodyA = nullptr;
+        manifold.bodyB = nullptr;
+        manifold.touched = false;
+    }
+    m_sortedCount = m_manifolds.size();
+}
+
+// Island building
+
+int IslandSolver::indexBody(PhysicsBody* body) {
+    if (body->solverStamp != m_stamp) {
+        body->solverStamp = m_stamp;
+        body->solverIndex = static_cast<int>(m_solverBodies.size());
+        m_solverBodies.push_back(body);
+        m_parent.push_back(body->solverIndex);
+    }
+    return body->solverIndex;
+}
+
+int IslandSolver::findRoot(int index) {
+    while (m_parent[index] != index) {
+        m_parent[index] = m_parent[m_parent[index]];
+        index = m_parent[index];
+    }
+    return index;
+}
+
+void IslandSolver::link(PhysicsBody* a, PhysicsBody* b) {
+    int indexA = isSolverBody(a) ? indexBody(a) : -1;
+    int indexB = isSolverBody(b) ? indexBody(b) : -1;
+    if (indexA < 0 || indexB < 0) return;
+
+    int rootA = findRoot(indexA);
+    int rootB = findRoot(indexB);
+    if (rootA != rootB) {
+        // Lower index wins so island order follows body order
+        if (rootA < rootB) {
+            m_parent[rootB] = rootA;
+        } else {
+            m_parent[rootA] = rootB;
+        }
+    }
+}
+
+int IslandSolver::islandOf(PhysicsBody* a, PhysicsBody* b) {
+    if (isSolverBody(a) && a->solverStamp == m_stamp) return m_bodyIsland[a->solverIndex];
+    if (isSolverBody(b) && b->solverStamp == m_stamp) return m_bodyIsland[b->solverIndex];
+    return -1;
+}
+
+void IslandSolver::buildIslands(const std::vector<PhysicsBody*>& bodies,
+                                const std::vector<Joint*>& joints,
+                                const std::vector<Constraint*>& constraints) {
+    if (++m_stamp == 0) {
+        m_stamp = 1;
+    }
+    m_solverBodies.clear();
+    m_parent.clear();
+
+    int dynamicBodies = 0;
+    for (PhysicsBody* body : bodies) {
+        if (!isSolverBody(body)) continue;
+        ++dynamicBodies;
+        if (body->isAwake()) {
+            indexBody(body);
+        }
+    }
+
+    // Kinematic bodies never sleep, so one moving into a sleeping body has to wake it
+    auto wakeTouched = [this](PhysicsBody* kinematic, PhysicsBody* body) {
+        if (!kinematic || kinematic->type != BodyType::KINEMATIC) return;
+        if (!isSolverBody(body) || body->awake) return;
+        if (kinematic->velocity.magnitudeSquared() > 0.0f || kinematic->angularVelocity != 0.0f) {
+            body->awake = true;
+            body->sleepTime = 0.0f;
+            indexBody(body);
+        }
+    };
+    for (const auto& manifold : m_manifolds) {
+        wakeTouched(manifold.bodyA, manifold.bodyB);
+        wakeTouched(manifold.bodyB, manifold.bodyA);
+    }
+
+    // Edges between sleeping bodies change nothing until one side wakes, so normally only
+    // edges touching an awake body are linked and resting piles cost one flag check per
+    // edge. If that pulls in a sleeping body, everything reachable from it has to wake with
+    // it, so the pass is repeated over all edges.
+    auto linkEdges = [&](bool awakeOnly) {
+        auto skip = [awakeOnly](const PhysicsBody* a, const PhysicsBody* b) {
+            return awakeOnly && !isAwakeSolverBody(a) && !isAwakeSolverBody(b);
+        };
+        for (const auto& manifold : m_manifolds) {
+            if (skip(manifold.bodyA, manifold.bodyB)) continue;
+            link(manifold.bodyA, manifold.bodyB);
+        }
+        for (Joint* joint : joints) {
+            if (skip(joint->getPhysicsBodyA(), joint->getPhysicsBodyB())) continue;
+            link(joint->getPhysicsBodyA(), joint->getPhysicsBodyB());
+        }
+        for (Constraint* constraint : constraints) {
+            PhysicsBody* a = constraint->getBodyA();
+            PhysicsBody* b = constraint->getBodyB();
+            if (skip(a, b)) continue;
+            link(a, b);
+            if (isSolverBody(a)) indexBody(a);
+            if (isSolverBody(b)) indexBody(b);
+        }
+    };
+    const size_t awakeCount = m_solverBodies.size();
+    linkEdges(true);
+    if (m_solverBodies.size() > awakeCount) {
+        linkEdges(false);
+    }
+
+    // Number islands in order of their first body
+    const int bodyCount = static_cast<int>(m_solverBodies.size());
+    m_rootIsland.assign(bodyCount, -1);
+    m_bodyIsland.resize(bodyCount);
+    m_islands.clear();
+    for (int i = 0; i < bodyCount; ++i) {
+        int root = findRoot(i);
+        if (m_rootIsland[root] < 0) {
+            m_rootIsland[root] = static_cast<int>(m_islands.size());
+            m_islands.push_back(Island{0, 0, 0, 0, 0, 0, 0, 0, false});
+        }
+        Island& island = m_islands[m_rootIsland[root]];
+        m_bodyIsland[i] = m_rootIsland[root];
+        island.bodyCount++;
+        island.awake = island.awake || m_solverBodies[i]->isAwake();
+    }
+
+    m_contactIsland.resize(m_manifolds.size());
+    for (size_t i = 0; i < m_manifolds.size(); ++i) {
+        int index = islandOf(m_manifolds[i].bodyA, m_manifolds[i].bodyB);
+        m_contactIsland[i] = index;
+        if (index >= 0) m_islands[index].contactCount++;
+    }
+    m_jointIsland.resize(joints.size());
+    for (size_t i = 0; i < joints.size(); ++i) {
+        int index = islandOf(joints[i]->getPhysicsBodyA(), joints[i]->getPhysicsBodyB());
+        m_jointIsland[i] = index;
+        if (index >= 0) m_islands[index].jointCount++;
+    }
+    m_constraintIsland.resize(constraints.size());
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        int index = islandOf(constraints[i]->getBodyA(), constraints[i]->getBodyB());
+        m_constraintIsland[i] = index;
+        if (index >= 0) m_islands[index].constraintCount++;
+    }
+
+    // Counting sort of bodies and edges by island
+    int bodyStart = 0, contactStart = 0, jointStart = 0, constraintStart = 0;
+    for (Island& island : m_islands) {
+        island.bodyStart = bodyStart;
+        island.contactStart = contactStart;
+        island.jointStart = jointStart;
+        island.constraintStart = constraintStart;
+        bodyStart += island.bodyCount;
+        contactStart += island.contactCount;
+        jointStart += island.jointCount;
+        constraintStart += island.constraintCount;
+    }
+
+    m_islandBodies.resize(bodyStart);
+    m_cursor.resize(m_islands.size());
+    for (size_t i = 0; i < m_islands.size(); ++i) m_cursor[i] = m_islands[i].bodyStart;
+    for (int i = 0; i < bodyCount; ++i) {
+        m_islandBodies[m_cursor[m_bodyIsland[i]]++] = m_solverBodies[i];
+    }
+
+    m_islandContacts.resize(contactStart);
+    for (size_t i = 0; i < m_islands.size(); ++i) m_cursor[i] = m_islands[i].contactStart;
+    for (size_t i = 0; i < m_manifolds.size(); ++i) {
+        if (m_contactIsland[i] >= 0) {
+            m_islandContacts[m_cursor[m_contactIsland[i]]++] = static_cast<int>(i);
+        }
+    }
+
+    m_islandJoints.resize(jointStart);
+    for (size_t i = 0; i < m_islands.size(); ++i) m_cursor[i] = m_islands[i].jointStart;
+    for (size_t i = 0; i < joints.size(); ++i) {
+        if (m_jointIsland[i] >= 0) {
+            m_islandJoints[m_cursor[m_jointIsland[i]]++] = joints[i];
+        }
+    }
+
+    m_islandConstraints.resize(constraintStart);
+    for (size_t i = 0; i < m_islands.size(); ++i) m_cursor[i] = m_islands[i].constraintStart;
+    for (size_t i = 0; i < constraints.size(); ++i) {
+        if (m_constraintIsland[i] >= 0) {
+            m_islandConstraints[m_cursor[m_constraintIsland[i]]++] = constraints[i];
+        }
+    }
+
+    // Wake every body of an island that has an awake member
+    m_awakeIslands.clear();
+    for (size_t i = 0; i < m_islands.size(); ++i) {
+        const Island& island = m_islands[i];
+        if (!island.awake) continue;
+
+        m_awakeIslands.push_back(static_cast<int>(i));
+        for (int b = 0; b < island.bodyCount; ++b) {
+            PhysicsBody* body = m_islandBodies[island.bodyStart + b];
+            if (!body->awake) {
+                body->awake = true;
+                body->sleepTime = 0.0f;
+            }
+        }
+        m_stats.awakeBodies += island.bodyCount;
+        m_stats.contacts += island.contactCount;
+        m_stats.joints += island.jointCount;
+        m_stats.constraints += island.constraintCount;
+    }
+
+    m_stats.islands = static_cast<int>(m_islands.size());
+    m_stats.awakeIslands = static_cast<int>(m_awakeIslands.size());
+    m_stats.sleepingBodies = dynamicBodies - m_stats.awakeBodies;
+}
+
+// Solving
+
+void IslandSolver::solve(float deltaTime, const std::vector<PhysicsBody*>& bodies,
+                         const std::vector<Joint*>& joints,
+                         const std::vector<Constraint*>& constraints,
+                         const SolverSettings& settings) {
+    auto start = std::chrono::high_resolution_clock::now();
+    m_stats = IslandStats();
+
+    // Kinematic bodies move on their own and never join islands
+    for (PhysicsBody* body : bodies) {
+        if (body && body->type == BodyType::KINEMATIC && body->isEnabled()) {
+            body->integratePosition(deltaTime);
+        }
+    }
+
+    buildIslands(bodies, joints, constraints);
+
+    if (deltaTime > 0.0f) {
+        solveIslandsParallel(deltaTime, settings);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_stats.solveTimeMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void IslandSolver::solveIslandsParallel(float deltaTime, const SolverSettings& settings) {
+    if (!m_jobSystem || m_stats.awakeBodies < BODIES_PER_JOB * 2) {
+        for (int index : m_awakeIslands) {
+            solveIsland(m_islands[index], deltaTime, settings);
+        }
+        return;
+    }
+
+    // Largest islands first so a big pile doesn't start last and stall the step
+    std::stable_sort(m_awakeIslands.begin(), m_awakeIslands.end(), [this](int a, int b) {
+        return m_islands[a].bodyCount > m_islands[b].bodyCount;
+    });
+
+    m_batches.clear();
+    size_t batchStart = 0;
+    int batchBodies = 0;
+    for (size_t i = 0; i < m_awakeIslands.size(); ++i) {
+        batchBodies += m_islands[m_awakeIslands[i]].bodyCount;
+        if (batchBodies >= BODIES_PER_JOB) {
+            m_batches.emplace_back(batchStart, i + 1);
+            batchStart = i + 1;
+            batchBodies = 0;
+        }
+    }
+    if (batchStart < m_awakeIslands.size()) {
+        m_batches.emplace_back(batchStart, m_awakeIslands.size());
+    }
+
+    Threading::JobCounter counter;
+    for (const auto& batch : m_batches) {
+        m_jobSystem->dispatch(
+            [this, batch, deltaTime, &settings]() {
+                for (size_t i = batch.first; i < batch.second; ++i) {
+                    solveIsland(m_islands[m_awakeIslands[i]], deltaTime, settings);
+                }
+            },
+            counter, Threading::TaskPriority::High);
+    }
+
+    // Help instead of blocking so the calling thread counts as a worker
+    m_jobSystem->wait(counter);
+}
+
+void IslandSolver::solveIsland(const Island& island, float deltaTime,
+                               const SolverSettings& settings) {
+    PhysicsBody* const* bodies = m_islandBodies.data() + island.bodyStart;
+    const int* contacts = m_islandContacts.data() + island.contactStart;
+    Joint* const* joints = m_islandJoints.data() + island.jointStart;
+    Constraint* const* constraints = m_islandConstraints.data() + island.constraintStart;
+
+    // Prepare contacts and apply last step's impulses
+    for (int c = 0; c < island.contactCount; ++c) {
+        ContactManifold& m = m_manifolds[contacts[c]];
+        float massA = inverseMassOf(m.bodyA);
+        float massB = inverseMassOf(m.bodyB);
+        float massSum = massA + massB;
+        m.normalMass = massSum > 0.0f ? 1.0f / massSum : 0.0f;
+
+        float approach = (velocityOf(m.bodyB) - velocityOf(m.bodyA)).dot(m.normal);
+        m.velocityBias =
+            approach < -settings.restitutionThreshold ? -m.restitution * approach : 0.0f;
+
+        if (!settings.warmStarting) {
+            m.normalImpulse = 0.0f;
+            m.tangentImpulse = 0.0f;
+            continue;
+        }
+
+        Math::Vector2D impulse =
+            m.normal * m.normalImpulse + tangentOf(m.normal) * m.tangentImpulse;
+        if (massA > 0.0f) m.bodyA->velocity -= impulse * massA;
+        if (massB > 0.0f) m.bodyB->velocity += impulse * massB;
+    }
+
+    for (int j = 0; j < island.jointCount; ++j) {
+        joints[j]->initVelocityConstraints(deltaTime, settings.warmStarting);
+    }
+
+    // Velocity iterations: joints, then friction before non-penetration so the normal
+    // constraint has the last word
+    for (int iteration = 0; iteration < settings.velocityIterations; ++iteration) {
+        for (int j = 0; j < island.jointCount; ++j) {
+            joints[j]->solveVelocityConstraints();
+        }
+
+        for (int c = 0; c < island.contactCount; ++c) {
+            ContactManifold& m = m_manifolds[contacts[c]];
+            float massA = inverseMassOf(m.bodyA);
+            float massB = inverseMassOf(m.bodyB);
+            Math::Vector2D tangent = tangentOf(m.normal);
+
+            Math::Vector2D relative = velocityOf(m.bodyB) - velocityOf(m.bodyA);
+            float lambda = -m.normalMass * relative.dot(tangent);
+            float maxFriction = m.friction * m.normalImpulse;
+            float newImpulse =
+                std::max(-maxFriction, std::min(m.tangentImpulse + lambda, maxFriction));
+            lambda = newImpulse - m.tangentImpulse;
+            m.tangentImpulse = newImpulse;
+
+            Math::Vector2D impulse = tangent * lambda;
+            if (massA > 0.0f) m.bodyA->velocity -= impulse * massA;
+            if (massB > 0.0f) m.bodyB->velocity += impulse * massB;
+
+            relative = velocityOf(m.bodyB) - velocityOf(m.bodyA);
+            lambda = -m.normalMass * (relative.dot(m.normal) - m.velocityBias);
+            newImpulse = std::max(m.normalImpulse + lambda, 0.0f);
+            lambda = newImpulse - m.normalImpulse;
+            m.normalImpulse = newImpulse;
+
+            impulse = m.normal * lambda;
+            if (massA > 0.0f) m.bodyA->velocity -= impulse * massA;
+            if (massB > 0.0f) m.bodyB->velocity += impulse * massB;
+        }
+    }
+
+    for (int b = 0; b < island.bodyCount; ++b) {
+        bodies[b]->integratePosition(deltaTime);
+    }
+
+    // Position iterations push out remaining penetration without adding velocity
+    for (int c = 0; c < island.constraintCount; ++c) {
+        constraints[c]->preStep(deltaTime);
+    }
+    const float positionStep = deltaTime / std::max(settings.positionIterations, 1);
+    for (int iteration = 0; iteration < settings.positionIterations; ++iteration) {
+        for (int c = 0; c < island.contactCount; ++c) {
+            ContactManifold& m = m_manifolds[contacts[c]];
+            float massA = inverseMassOf(m.bodyA);
+            float massB = inverseMassOf(m.bodyB);
+
+            Math::Vector2D movedA = m.bodyA ? m.bodyA->position - m.originA : Math::Vector2D(0, 0);
+            Math::Vector2D movedB = m.bodyB ? m.bodyB->position - m.originB : Math::Vector2D(0, 0);
+            float penetration = m.penetration - (movedB - movedA).dot(m.normal);
+            float correction = std::max(penetration - settings.slop, 0.0f) * settings.baumgarte;
+            if (correction <= 0.0f) continue;
+
+            Math::Vector2D push = m.normal * (correction * m.normalMass);
+            if (massA > 0.0f) m.bodyA->position -= push * massA;
+            if (massB > 0.0f) m.bodyB->position += push * massB;
+        }
+
+        for (int j = 0; j < island.jointCount; ++j) {
+            joints[j]->solvePositionConstraints();
+        }
+        for (int c = 0; c < island.constraintCount; ++c) {
+            constraints[c]->solve(positionStep);
+        }
+    }
+
+    if (!settings.allowSleeping) return;
+
+    // The island sleeps once its most recently disturbed body has rested long enough
+    const float toleranceSq = settings.sleepVelocity * settings.sleepVelocity;
+    float minSleepTime = std::numeric_limits<float>::max();
+    for (int b = 0; b < island.bodyCount; ++b) {
+        PhysicsBody* body = bodies[b];
+        if (!body->canSleep || body->velocity.magnitudeSquared() > toleranceSq ||
+            body->angularVelocity * body->angularVelocity > toleranceSq) {
+            body->sleepTime = 0.0f;
+            minSleepTime = 0.0f;
+        } else {
+            body->sleepTime += deltaTime;
+            minSleepTime = std::min(minSleepTime, body->sleepTime);
+        }
+    }
+
+    if (minSleepTime >= settings.timeToSleep) {
+        for (int b = 0; b < island.bodyCount; ++b) {
+            bodies[b]->setAwake(false);
+        }
+    }
+}
+
+} // namespace Physics
+} // namespace JJM
@@ -0,0 +1,639 @@
+#include "physics/PhysicsWorld.h"
+#include <algorithm>
+#include <cmath>
+
+namespace JJM {
+namespace Physics {
+
+namespace {
+
+constexpr float MIN_AXIS_LENGTH = 0.0001f;
+
+PhysicsBody* bodyOf(ECS::Entity* entity) {
+    return entity ? entity->getComponent<PhysicsBody>() : nullptr;
+}
+
+float inverseMassOf(const PhysicsBody* body) {
+    return body ? body->getSolverInverseMass() : 0.0f;
+}
+
+// Bodies carry no rotational inertia, so angular terms treat dynamic bodies as unit inertia
+float inverseInertiaOf(const PhysicsBody* body) {
+    return body && body->type == BodyType::DYNAMIC ? 1.0f : 0.0f;
+}
+
+// Creating or removing a joint changes the forces on its bodies, so sleeping ones must wake
+void wakeBodies(const Joint& joint) {
+    if (PhysicsBody* bodyA = bodyOf(joint.getBodyA())) bodyA->setAwake(true);
+    if (PhysicsBody* bodyB = bodyOf(joint.getBodyB())) bodyB->setAwake(true);
+}
+
+Math::Vector2D worldAnchor(const PhysicsBody* body, const Math::Vector2D& anchor) {
+    return body ? body->position + anchor : anchor;
+}
+
+Math::Vector2D velocityOf(const PhysicsBody* body) {
+    return body ? body->velocity : Math::Vector2D(0, 0);
+}
+
+float angularVelocityOf(const PhysicsBody* body) {
+    return body ? body->angularVelocity : 0.0f;
+}
+
+void applyLinearImpulse(PhysicsBody* bodyA, PhysicsBody* bodyB, const Math::Vector2D& impulse) {
+    float massA = inverseMassOf(bodyA);
+    float massB = inverseMassOf(bodyB);
+    if (massA > 0.0f) bodyA->velocity -= impulse * massA;
+    if (massB > 0.0f) bodyB->velocity += impulse * massB;
+}
+
+void applyPositionImpulse(PhysicsBody* bodyA, PhysicsBody* bodyB, const Math::Vector2D& impulse) {
+    float massA = inverseMassOf(bodyA);
+    float massB = inverseMassOf(bodyB);
+    if (massA > 0.0f) bodyA->position -= impulse * massA;
+    if (massB > 0.0f) bodyB->position += impulse * massB;
+}
+
+void applyAngularImpulse(PhysicsBody* bodyA, PhysicsBody* bodyB, float impulse) {
+    if (inverseInertiaOf(bodyA) > 0.0f) bodyA->angularVelocity -= impulse;
+    if (inverseInertiaOf(bodyB) > 0.0f) bodyB->angularVelocity += impulse;
+}
+
+// Shared setup for distance-style joints: axis, length, effective masses and the soft
+// constraint coefficients (gamma/bias) used when stiffness is non-zero
+struct AxialSetup {
+    Math::Vector2D axis;
+    float length;
+    float mass;
+    float softMass;
+    float gamma;
+    float bias;
+};
+
+AxialSetup prepareAxial(const PhysicsBody* bodyA, const PhysicsBody* bodyB,
+                        const Math::Vector2D& anchorA, const Math::Vector2D& anchorB,
+                        float restLength, float stiffness, float damping, float dt) {
+    AxialSetup setup;
+    Math::Vector2D delta = worldAnchor(bodyB, anchorB) - worldAnchor(bodyA, anchorA);
+    setup.length = delta.magnitude();
+    setup.axis = setup.length > MIN_AXIS_LENGTH ? delta / setup.length : Math::Vector2D(0, 0);
+
+    float massSum = inverseMassOf(bodyA) + inverseMassOf(bodyB);
+    setup.mass = massSum > 0.0f ? 1.0f / massSum : 0.0f;
+    setup.gamma = 0.0f;
+    setup.bias = 0.0f;
+    setup.softMass = setup.mass;
+
+    if (stiffness > 0.0f && massSum > 0.0f) {
+        float gamma = dt * (damping + dt * stiffness);
+        setup.gamma = gamma > 0.0f ? 1.0f / gamma : 0.0f;
+        setup.bias = (setup.length - restLength) * dt * stiffness * setup.gamma;
+        float softSum = massSum + setup.gamma;
+        setup.softMass = softSum > 0.0f ? 1.0f / softSum : 0.0f;
+    }
+    return setup;
+}
+
+// One-sided limits keep length inside [lower, upper]; returns the updated accumulators
+void solveAxialLimits(PhysicsBody* bodyA, PhysicsBody* bodyB, const Math::Vector2D& axis,
+                      float length, float lower, float upper, float mass, float invDt,
+                      float& lowerImpulse, float& upperImpulse) {
+    if (lower > 0.0f) {
+        float C = length - lower;
+        float bias = std::max(0.0f, C) * invDt;
+        float Cdot = axis.dot(velocityOf(bodyB) - velocityOf(bodyA));
+        float impulse = -mass * (Cdot + bias);
+        float newImpulse = std::max(0.0f, lowerImpulse + impulse);
+        impulse = newImpulse - lowerImpulse;
+        lowerImpulse = newImpulse;
+        applyLinearImpulse(bodyA, bodyB, axis * impulse);
+    }
+
+    if (upper > 0.0f) {
+        float C = upper - length;
+        float bias = std::max(0.0f, C) * invDt;
+        float Cdot = axis.dot(velocityOf(bodyA) - velocityOf(bodyB));
+        float impulse = -mass * (Cdot + bias);
+        float newImpulse = std::max(0.0f, upperImpulse + impulse);
+        impulse = newImpulse - upperImpulse;
+        upperImpulse = newImpulse;
+        applyLinearImpulse(bodyA, bodyB, axis * -impulse);
+    }
+}
+
+// Position-level fix-up toward [lower, upper] (equal bounds mean a rigid length)
+void solveAxialPosition(PhysicsBody* bodyA, PhysicsBody* bodyB, const Math::Vector2D& anchorA,
+                        const Math::Vector2D& anchorB, float lower, float upper) {
+    Math::Vector2D delta = worldAnchor(bodyB, anchorB) - worldAnchor(bodyA, anchorA);
+    float length = delta.magnitude();
+    if (length < MIN_AXIS_LENGTH) return;
+
+    float C = 0.0f;
+    if (lower > 0.0f && length < lower) {
+        C = length - lower;
+    } else if (upper > 0.0f && length > upper) {
+        C = length - upper;
+    }
+    if (C == 0.0f) return;
+
+    float massSum = inverseMassOf(bodyA) + inverseMassOf(bodyB);
+    if (massSum <= 0.0f) return;
+
+    Math::Vector2D axis = delta / length;
+    applyPositionImpulse(bodyA, bodyB, axis * (-C / massSum));
+}
+
+} // namespace
+
+// Joint
+
+bool Joint::bindBodies() {
+    m_physicsA = bodyOf(m_bodyA);
+    m_physicsB = bodyOf(m_bodyB);
+    return m_physicsA || m_physicsB;
+}
+
+bool Joint::updateBreakage() {
+    if (m_broken) return true;
+
+    bool overForce = m_breakForce > 0.0f && getReactionForce(m_invDt).magnitude() > m_breakForce;
+    bool overTorque =
+        m_breakTorque > 0.0f && std::abs(getReactionTorque(m_invDt)) > m_breakTorque;
+    if (overForce || overTorque) {
+        m_broken = true;
+        m_enabled = false;
+    }
+    return m_broken;
+}
+
+void Joint::saveState(std::vector<float>& out) const {
+    out.push_back(m_broken ? 1.0f : 0.0f);
+    out.push_back(m_enabled ? 1.0f : 0.0f);
+    out.push_back(m_invDt);
+    saveSolverState(out);
+}
+
+const float* Joint::loadState(const float* in) {
+    m_broken = in[0] != 0.0f;
+    m_enabled = in[1] != 0.0f;
+    m_invDt = in[2];
+    return loadSolverState(in + 3);
+}
+
+// DistanceJoint
+
+DistanceJoint::DistanceJoint(const DistanceJointConfig& config)
+    : Joint(JointType::Distance, config.bodyA, config.bodyB),
+      m_anchorA(config.anchorA), m_anchorB(config.anchorB),
+      m_length(config.length), m_minLength(config.minLength), m_maxLength(config.maxLength),
+      m_stiffness(config.stiffness), m_damping(config.damping) {
+    m_breakForce = config.breakForce;
+    m_breakTorque = config.breakTorque;
+    m_userData = config.userData;
+
+    if (m_length < 0.0f) {
+        Math::Vector2D delta = worldAnchor(bodyOf(m_bodyB), m_anchorB) -
+                               worldAnchor(bodyOf(m_bodyA), m_anchorA);
+        m_length = delta.magnitude();
+    }
+}
+
+float DistanceJoint::lowerLength() const {
+    if (m_minLength > 0.0f) return m_minLength;
+    return m_stiffness > 0.0f ? 0.0f : m_length;
+}
+
+float DistanceJoint::upperLength() const {
+    return m_maxLength > 0.0f ? m_maxLength : m_length;
+}
+
+float DistanceJoint::getCurrentLength() const {
+    Math::Vector2D delta = worldAnchor(bodyOf(m_bodyB), m_anchorB) -
+                           worldAnchor(bodyOf(m_bodyA), m_anchorA);
+    return delta.magnitude();
+}
+
+Math::Vector2D DistanceJoint::getReactionForce(float invDt) const {
+    return m_axis * ((m_impulse + m_lowerImpulse - m_upperImpulse) * invDt);
+}
+
+void DistanceJoint::initVelocityConstraints(float dt, bool warmStart) {
+    m_invDt = dt > 0.0f ? 1.0f / dt : 0.0f;
+
+    AxialSetup setup = prepareAxial(m_physicsA, m_physicsB, m_anchorA, m_anchorB, m_length,
+                                    m_stiffness, m_damping, dt);
+    m_axis = setup.axis;
+    m_currentLength = setup.length;
+    m_mass = setup.mass;
+    m_softMass = setup.softMass;
+    m_gamma = setup.gamma;
+    m_bias = setup.bias;
+
+    if (m_stiffness <= 0.0f && lowerLength() != upperLength()) {
+        // Rigid rope: only the limits carry impulse
+        m_impulse = 0.0f;
+    }
+
+    if (warmStart) {
+        applyLinearImpulse(m_physicsA, m_physicsB,
+                           m_axis * (m_impulse + m_lowerImpulse - m_upperImpulse));
+    } else {
+        m_impulse = 0.0f;
+        m_lowerImpulse = 0.0f;
+        m_upperImpulse = 0.0f;
+    }
+}
+
+void DistanceJoint::solveVelocityConstraints() {
+    const float lower = lowerLength();
+    const float upper = upperLength();
+
+    if (m_stiffness <= 0.0f && lower == upper) {
+        float Cdot = m_axis.dot(velocityOf(m_physicsB) - velocityOf(m_physicsA));
+        float impulse = -m_mass * Cdot;
+        m_impulse += impulse;
+        applyLinearImpulse(m_physicsA, m_physicsB, m_axis * impulse);
+        return;
+    }
+
+    if (m_stiffness > 0.0f) {
+        float Cdot = m_axis.dot(velocityOf(m_physicsB) - velocityOf(m_physicsA));
+        float impulse = -m_softMass * (Cdot + m_bias + m_gamma * m_impulse);
+        m_impulse += impulse;
+        applyLinearImpulse(m_physicsA, m_physicsB, m_axis * impulse);
+    }
+
+    solveAxialLimits(m_physicsA, m_physicsB, m_axis, m_currentLength, lower, upper, m_mass,
+                     m_invDt, m_lowerImpulse, m_upperImpulse);
+}
+
+void DistanceJoint::solvePositionConstraints() {
+    if (m_stiffness > 0.0f && m_minLength <= 0.0f && m_maxLength <= 0.0f) return;
+    solveAxialPosition(m_physicsA, m_physicsB, m_anchorA, m_anchorB, lowerLength(),
+                       upperLength());
+}
+
+void DistanceJoint::saveSolverState(std::vector<float>& out) const {
+    out.push_back(m_impulse);
+    out.push_back(m_lowerImpulse);
+    out.push_back(m_upperImpulse);
+}
+
+const float* DistanceJoint::loadSolverState(const float* in) {
+    m_impulse = in[0];
+    m_lowerImpulse = in[1];
+    m_upperImpulse = in[2];
+    return in + 3;
+}
+
+// RevoluteJoint
+
+RevoluteJoint::RevoluteJoint(const RevoluteJointConfig& config)
+    : Joint(JointType::Revolute, config.bodyA, config.bodyB),
+      m_anchorA(config.anchorA), m_anchorB(config.anchorB),
+      m_referenceAngle(config.referenceAngle),
+      m_enableLimit(config.enableLimit),
+      m_lowerAngle(config.lowerAngle), m_upperAngle(config.upperAngle),
+      m_enableMotor(config.enableMotor),
+      m_motorSpeed(config.motorSpeed),
+      m_maxMotorTorque(config.maxMotorTorque),
+      m_linearImpulse(0, 0) {
+    m_breakForce = config.breakForce;
+    m_breakTorque = config.breakTorque;
+    m_userData = config.userData;
+}
+
+float RevoluteJoint::getJointAngle() const {
+    const PhysicsBody* bodyA = bodyOf(m_bodyA);
+    const PhysicsBody* bodyB = bodyOf(m_bodyB);
+    float angleA = bodyA ? bodyA->rotation : 0.0f;
+    float angleB = bodyB ? bodyB->rotation : 0.0f;
+    return angleB - angleA - m_referenceAngle;
+}
+
+float RevoluteJoint::getJointSpeed() const {
+    return angularVelocityOf(bodyOf(m_bodyB)) - angularVelocityOf(bodyOf(m_bodyA));
+}
+
+void RevoluteJoint::setLimits(float lower, float upper) {
+    m_lowerAngle = std::min(lower, upper);
+    m_upperAngle = std::max(lower, upper);
+    m_lowerImpulse = 0.0f;
+    m_upperImpulse = 0.0f;
+}
+
+float RevoluteJoint::getMotorTorque(float invDt) const {
+    return m_motorImpulse * invDt;
+}
+
+Math::Vector2D RevoluteJoint::getReactionForce(float invDt) const {
+    return m_linearImpulse * invDt;
+}
+
+float RevoluteJoint::getReactionTorque(float invDt) const {
+    return (m_motorImpulse + m_lowerImpulse - m_upperImpulse) * invDt;
+}
+
+void RevoluteJoint::initVelocityConstraints(float dt, bool warmStart) {
+    m_dt = dt;
+    m_invDt = dt > 0.0f ? 1.0f / dt : 0.0f;
+
+    float massSum = inverseMassOf(m_physicsA) + inverseMassOf(m_physicsB);
+    m_linearMass = massSum > 0.0f ? 1.0f / massSum : 0.0f;
+
+    float inertiaSum = inverseInertiaOf(m_physicsA) + inverseInertiaOf(m_physicsB);
+    m_axialMass = inertiaSum > 0.0f ? 1.0f / inertiaSum : 0.0f;
+
+    if (!m_enableMotor || m_axialMass == 0.0f) {
+        m_motorImpulse = 0.0f;
+    }
+    if (!m_enableLimit || m_axialMass == 0.0f) {
+        m_lowerImpulse = 0.0f;
+        m_upperImpulse = 0.0f;
+        m_limitState = JointLimitState::Inactive;
+    } else {
+        float angle = getJointAngle();
+        if (std::abs(m_upperAngle - m_lowerAngle) < MIN_AXIS_LENGTH) {
+            m_limitState = JointLimitState::Equal;
+        } else if (angle <= m_lowerAngle) {
+            m_limitState = JointLimitState::AtLower;
+        } else if (angle >= m_upperAngle) {
+            m_limitState = JointLimitState::AtUpper;
+        } else {
+            m_limitState = JointLimitState::Inactive;
+        }
+    }
+
+    if (warmStart) {
+        applyLinearImpulse(m_physicsA, m_physicsB, m_linearImpulse);
+        applyAngularImpulse(m_physicsA, m_physicsB,
+                            m_motorImpulse + m_lowerImpulse - m_upperImpulse);
+    } else {
+        m_linearImpulse = Math::Vector2D(0, 0);
+        m_motorImpulse = 0.0f;
+        m_lowerImpulse = 0.0f;
+        m_upperImpulse = 0.0f;
+    }
+}
+
+void RevoluteJoint::solveVelocityConstraints() {
+    if (m_enableMotor && m_axialMass > 0.0f) {
+        float Cdot = angularVelocityOf(m_physicsB) - angularVelocityOf(m_physicsA) - m_motorSpeed;
+        float impulse = -m_axialMass * Cdot;
+        float maxImpulse = m_maxMotorTorque * m_dt;
+        float newImpulse = std::max(-maxImpulse, std::min(m_motorImpulse + impulse, maxImpulse));
+        impulse = newImpulse - m_motorImpulse;
+        m_motorImpulse = newImpulse;
+        applyAngularImpulse(m_physicsA, m_physicsB, impulse);
+    }
+
+    if (m_enableLimit && m_axialMass > 0.0f) {
+        float angle = getJointAngle();
+
+        // Lower limit
+        {
+            float C = angle - m_lowerAngle;
+            float bias = std::max(0.0f, C) * m_invDt;
+            float Cdot = angularVelocityOf(m_physicsB) - angularVelocityOf(m_physicsA);
+            float impulse = -m_axialMass * (Cdot + bias);
+            float newImpulse = std::max(0.0f, m_lowerImpulse + impulse);
+            impulse = newImpulse - m_lowerImpulse;
+            m_lowerImpulse = newImpulse;
+            applyAngularImpulse(m_physicsA, m_physicsB, impulse);
+        }
+
+        // Upper limit
+        {
+            float C = m_upperAngle - angle;
+            float bias = std::max(0.0f, C) * m_invDt;
+            float Cdot = angularVelocityOf(m_physicsA) - angularVelocityOf(m_physicsB);
+            float impulse = -m_axialMass * (Cdot + bias);
+            float newImpulse = std::max(0.0f, m_upperImpulse + impulse);
+            impulse = newImpulse - m_upperImpulse;
+            m_upperImpulse = newImpulse;
+            applyAngularImpulse(m_physicsA, m_physicsB, -impulse);
+        }
+    }
+
+    // Point-to-point: anchors share a velocity
+    Math::Vector2D Cdot = velocityOf(m_physicsB) - velocityOf(m_physicsA);
+    Math::Vector2D impulse = Cdot * -m_linearMass;
+    m_linearImpulse += impulse;
+    applyLinearImpulse(m_physicsA, m_physicsB, impulse);
+}
+
+void RevoluteJoint::solvePositionConstraints() {
+    if (m_linearMass == 0.0f) return;
+
+    Math::Vector2D C = worldAnchor(m_physicsB, m_anchorB) - worldAnchor(m_physicsA, m_anchorA);
+    applyPositionImpulse(m_physicsA, m_physicsB, C * -m_linearMass);
+}
+
+void RevoluteJoint::saveSolverState(std::vector<float>& out) const {
+    out.push_back(m_linearImpulse.x);
+    out.push_back(m_linearImpulse.y);
+    out.push_back(m_motorImpulse);
+    out.push_back(m_lowerImpulse);
+    out.push_back(m_upperImpulse);
+}
+
+const float* RevoluteJoint::loadSolverState(const float* in) {
+    m_linearImpulse = Math::Vector2D(in[0], in[1]);
+    m_motorImpulse = in[2];
+    m_lowerImpulse = in[3];
+    m_upperImpulse = in[4];
+    return in + 5;
+}
+
+// SpringJoint
+
+SpringJoint::SpringJoint(const SpringJointConfig& config)
+    : Joint(JointType::Spring, config.bodyA, config.bodyB),
+      m_anchorA(config.anchorA), m_anchorB(config.anchorB),
+      m_restLength(config.restLength),
+      m_stiffness(config.stiffness),
+      m_damping(config.damping),
+      m_minLength(config.minLength), m_maxLength(config.maxLength) {
+    m_breakForce = config.breakForce;
+    m_breakTorque = config.breakTorque;
+    m_userData = config.userData;
+
+    if (m_restLength < 0.0f) {
+        m_restLength = getCurrentLength();
+    }
+}
+
+float SpringJoint::getCurrentLength() const {
+    Math::Vector2D delta = worldAnchor(bodyOf(m_bodyB), m_anchorB) -
+                           worldAnchor(bodyOf(m_bodyA), m_anchorA);
+    return delta.magnitude();
+}
+
+float SpringJoint::getCurrentForce() const {
+    const PhysicsBody* bodyA = bodyOf(m_bodyA);
+    const PhysicsBody* bodyB = bodyOf(m_bodyB);
+    Math::Vector2D delta = worldAnchor(bodyB, m_anchorB) - worldAnchor(bodyA, m_anchorA);
+    float length = delta.magnitude();
+    if (length < MIN_AXIS_LENGTH) return 0.0f;
+
+    float stretchSpeed = (delta / length).dot(velocityOf(bodyB) - velocityOf(bodyA));
+    return -m_stiffness * (length - m_restLength) - m_damping * stretchSpeed;
+}
+
+Math::Vector2D SpringJoint::getReactionForce(float invDt) const {
+    return m_axis * ((m_impulse + m_lowerImpulse - m_upperImpulse) * invDt);
+}
+
+void SpringJoint::initVelocityConstraints(float dt, bool warmStart) {
+    m_invDt = dt > 0.0f ? 1.0f / dt : 0.0f;
+
+    AxialSetup setup = prepareAxial(m_physicsA, m_physicsB, m_anchorA, m_anchorB, m_restLength,
+                                    m_stiffness, m_damping, dt);
+    m_axis = setup.axis;
+    m_currentLength = setup.length;
+    m_mass = setup.mass;
+    m_softMass = setup.softMass;
+    m_gamma = setup.gamma;
+    m_bias = setup.bias;
+
+    if (warmStart) {
+        applyLinearImpulse(m_physicsA, m_physicsB,
+                           m_axis * (m_impulse + m_lowerImpulse - m_upperImpulse));
+    } else {
+        m_impulse = 0.0f;
+        m_lowerImpulse = 0.0f;
+        m_upperImpulse = 0.0f;
+    }
+}
+
+void SpringJoint::solveVelocityConstraints() {
+    if (m_stiffness > 0.0f) {
+        float Cdot = m_axis.dot(velocityOf(m_physicsB) - velocityOf(m_physicsA));
+        float impulse = -m_softMass * (Cdot + m_bias + m_gamma * m_impulse);
+        m_impulse += impulse;
+        applyLinearImpulse(m_physicsA, m_physicsB, m_axis * impulse);
+    }
+
+    solveAxialLimits(m_physicsA, m_physicsB, m_axis, m_currentLength, m_minLength, m_maxLength,
+                     m_mass, m_invDt, m_lowerImpulse, m_upperImpulse);
+}
+
+void SpringJoint::solvePositionConstraints() {
+    solveAxialPosition(m_physicsA, m_physicsB, m_anchorA, m_anchorB, m_minLength, m_maxLength);
+}
+
+void SpringJoint::saveSolverState(std::vector<float>& out) const {
+    out.push_back(m_impulse);
+    out.push_back(m_lowerImpulse);
+    out.push_back(m_upperImpulse);
+}
+
+const float* SpringJoint::loadSolverState(const float* in) {
+    m_impulse = in[0];
+    m_lowerImpulse = in[1];
+    m_upperImpulse = in[2];
+    return in + 3;
+}
+
+// JointManager
+
+JointManager::JointManager(PhysicsWorld& world) : m_world(world) {}
+
+JointManager::~JointManager() = default;
+
+DistanceJoint* JointManager::createDistanceJoint(const DistanceJointConfig& config) {
+    auto joint = std::make_unique<DistanceJoint>(config);
+    DistanceJoint* ptr = joint.get();
+    wakeBodies(*ptr);
+    m_joints.push_back(std::move(joint));
+    return ptr;
+}
+
+RevoluteJoint* JointManager::createRevoluteJoint(const RevoluteJointConfig& config) {
+    auto joint = std::make_unique<RevoluteJoint>(config);
+    RevoluteJoint* ptr = joint.get();
+    wakeBodies(*ptr);
+    m_joints.push_back(std::move(joint));
+    return ptr;
+}
+
+SpringJoint* JointManager::createSpringJoint(const SpringJointConfig& config) {
+    auto joint = std::make_unique<SpringJoint>(config);
+    SpringJoint* ptr = joint.get();
+    wakeBodies(*ptr);
+    m_joints.push_back(std::move(joint));
+    return ptr;
+}
+
+void JointManager::destroyJoint(Joint* joint) {
+    if (joint) wakeBodies(*joint);
+    m_joints.erase(std::remove_if(m_joints.begin(), m_joints.end(),
+                                  [joint](const std::unique_ptr<Joint>& j) {
+                                      return j.get() == joint;
+                                  }),
+                   m_joints.end());
+}
+
+void JointManager::destroyAllJoints() {
+    for (const auto& joint : m_joints) {
+        wakeBodies(*joint);
+    }
+    m_joints.clear();
+}
+
+void JointManager::destroyJointsForBody(ECS::Entity* body) {
+    m_joints.erase(std::remove_if(m_joints.begin(), m_joints.end(),
+                                  [body](const std::unique_ptr<Joint>& j) {
+                                      return j->getBodyA() == body || j->getBodyB() == body;
+                                  }),
+                   m_joints.end());
+}
+
+std::vector<Joint*> JointManager::getJointsForBody(ECS::Entity* body) const {
+    std::vector<Joint*> result;
+    for (const auto& joint : m_joints) {
+        if (joint->getBodyA() == body || joint->getBodyB() == body) {
+            result.push_back(joint.get());
+        }
+    }
+    return result;
+}
+
+void JointManager::solveVelocityConstraints(float dt) {
+    // Standalone path for callers driving joints without PhysicsWorld::update()
+    for (const auto& joint : m_joints) {
+        if (joint->isEnabled() && !joint->isBroken() && joint->bindBodies()) {
+            joint->initVelocityConstraints(dt, m_world.getConfig().warmStarting);
+        }
+    }
+    for (int i = 0; i < m_world.getConfig().velocityIterations; ++i) {
+        for (const auto& joint : m_joints) {
+            if (joint->isEnabled() && !joint->isBroken() && joint->getPhysicsBodyA() != nullptr) {
+                joint->solveVelocityConstraints();
+            }
+        }
+    }
+}
+
+void JointManager::solvePositionConstraints() {
+    for (int i = 0; i < m_world.getConfig().positionIterations; ++i) {
+        for (const auto& joint : m_joints) {
+            if (joint->isEnabled() && !joint->isBroken() && joint->bindBodies()) {
+                joint->solvePositionConstraints();
+            }
+        }
+    }
+}
+
+void JointManager::checkBreakage() {
+    for (const auto& joint : m_joints) {
+        if (!joint->isEnabled() || joint->isBroken()) continue;
+
+        if (joint->updateBreakage() && m_onBreak) {
+            m_onBreak(joint.get());
+        }
+    }
+}
+
+} // namespace Physics
+} // namespace JJM
@@ -8,13 +8,17 @@ PhysicsBody::PhysicsBody()
     : position(0, 0), velocity(0, 0), acceleration(0, 0), force(0, 0),
       mass(1.0f), inverseMass(1.0f), restitution(0.5f), friction(0.3f),
       angularVelocity(0.0f), rotation(0.0f),
-      type(BodyType::DYNAMIC), useGravity(true) {}
+      previousPosition(0, 0), previousRotation(0.0f),
+      type(BodyType::DYNAMIC), useGravity(true), canSleep(true),
+      awake(true), sleepTime(0.0f), solverStamp(0), solverIndex(-1) {}
 
 PhysicsBody::PhysicsBody(const Math::Vector2D& pos, float m)
     : position(pos), velocity(0, 0), acceleration(0, 0), force(0, 0),
       mass(m), restitution(0.5f), friction(0.3f),
       angularVelocity(0.0f), rotation(0.0f),
-      type(BodyType::DYNAMIC), useGravity(true) {
+      previousPosition(pos), previousRotation(0.0f),
+      type(BodyType::DYNAMIC), useGravity(true), canSleep(true),
+      awake(true), sleepTime(0.0f), solverStamp(0), solverIndex(-1) {
     inverseMass = (mass > 0.0f) ? 1.0f / mass : 0.0f;
 }
 
@@ -28,6 +32,11 @@ void PhysicsBody::update(float deltaTime) {
         return;
     }
     
+    integrateVelocity(deltaTime);
+    integratePosition(deltaTime);
+}
+
+void PhysicsBody::integrateVelocity(float deltaTime) {
     // Calculate acceleration from forces
     if (inverseMass > 0.0f) {
         acceleration = force * inverseMass;
@@ -36,25 +45,42 @@ void PhysicsBody::update(float deltaTime) {
     // Update velocity
     velocity += acceleration * deltaTime;
     
-    // Update position
-    position += velocity * deltaTime;
-    
-    // Update rotation
-    rotation += angularVelocity * deltaTime;
-    
     // Clear forces
     clearForces();
 }
 
+void PhysicsBody::integratePosition(float deltaTime) {
+    position += velocity * deltaTime;
+    rotation += angularVelocity * deltaTime;
+}
+
 void PhysicsBody::applyForce(const Math::Vector2D& f) {
     if (type == BodyType::DYNAMIC) {
         force += f;
+        if (f.x != 0.0f || f.y != 0.0f) {
+            setAwake(true);
+        }
     }
 }
 
 void PhysicsBody::applyImpulse(const Math::Vector2D& impulse) {
     if (type == BodyType::DYNAMIC && inverseMass > 0.0f) {
         velocity += impulse * inverseMass;
+        setAwake(true);
+    }
+}
+
+void PhysicsBody::setAwake(bool value) {
+    // Waking an awake body keeps its rest timer, so steady forces like gravity don't
+    // prevent sleep
+    if (awake == value) return;
+    
+    awake = value;
+    sleepTime = 0.0f;
+    if (!awake) {
+        velocity = Math::Vector2D(0, 0);
+        angularVelocity = 0.0f;
+        clearForces();
     }
 }
 
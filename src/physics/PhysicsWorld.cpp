@@ -1,32 +1,297 @@
 #include "physics/PhysicsWorld.h"
+#include "physics/Constraints.h"
+#include "memory/MemoryPool.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 
 namespace JJM {
 namespace Physics {
 
+namespace {
+
+Engine::AABB toBroadphaseAABB(const SpatialAABB& bounds) {
+    Engine::AABB aabb;
+    aabb.minX = bounds.min.x;
+    aabb.minY = bounds.min.y;
+    aabb.minZ = 0.0f;
+    aabb.maxX = bounds.max.x;
+    aabb.maxY = bounds.max.y;
+    aabb.maxZ = 0.0f;
+    return aabb;
+}
+
+float elapsedMs(std::chrono::high_resolution_clock::time_point start,
+                std::chrono::high_resolution_clock::time_point end) {
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// Bodies that move this step: pairs where neither side does are skipped by the narrow phase
+bool isMoving(const PhysicsBody* body) {
+    return body && body->isEnabled() && body->type != BodyType::STATIC && body->isAwake();
+}
+
+void captureTransform(PhysicsBody* body) {
+    body->previousPosition = body->position;
+    body->previousRotation = body->rotation;
+}
+
+} // namespace
+
 PhysicsWorld::PhysicsWorld(ECS::EntityManager* em) 
-    : gravity(0, 980.0f), entityManager(em) {}
+    : gravity(0, 980.0f), entityManager(em), timeAccumulator(0.0f), m_stepCount(0),
+      m_useSpatialHashing(false), m_broadphaseType(BroadphaseType::AABB_TREE),
+      m_aabbTree(std::make_unique<Engine::DynamicAABBTree>()), m_refreshProxyBounds(false),
+      m_jointManager(std::make_unique<JointManager>(*this)) {
+    config.gravity = gravity;
+    if (entityManager) {
+        entityManager->addObserver<PhysicsBody>(&m_bodyStore);
+    }
+}
 
-PhysicsWorld::~PhysicsWorld() {}
+PhysicsWorld::~PhysicsWorld() {
+    if (entityManager) {
+        entityManager->removeObserver(&m_bodyStore);
+    }
+}
+
+void PhysicsWorld::setConfig(const PhysicsConfig& cfg) {
+    config = cfg;
+    gravity = cfg.gravity;
+}
 
 void PhysicsWorld::update(float deltaTime) {
     if (!entityManager) return;
     
-    // Apply gravity
-    applyGravity(deltaTime);
+    step(deltaTime, true);
+    ++m_stepCount;
+}
+
+void PhysicsWorld::fixedUpdate() {
+    if (!entityManager) return;
+    
+    // Transforms are captured once per fixed step, so interpolation spans all sub-steps
+    const int subSteps = std::max(1, config.subSteps);
+    const float subStep = config.fixedTimeStep / static_cast<float>(subSteps);
+    for (int i = 0; i < subSteps; ++i) {
+        step(subStep, i == 0);
+    }
+    ++m_stepCount;
+}
+
+int PhysicsWorld::advance(float frameTime) {
+    const float fixedStep = config.fixedTimeStep;
+    if (fixedStep <= 0.0f) return 0;
+    
+    timeAccumulator += std::max(0.0f, frameTime);
     
-    // Update physics bodies
+    int steps = 0;
+    while (timeAccumulator >= fixedStep && steps < config.maxStepsPerUpdate) {
+        fixedUpdate();
+        timeAccumulator -= fixedStep;
+        ++steps;
+    }
+    
+    // Too far behind to catch up: drop the whole steps rather than spiral
+    if (timeAccumulator >= fixedStep) {
+        timeAccumulator = std::fmod(timeAccumulator, fixedStep);
+    }
+    return steps;
+}
+
+float PhysicsWorld::getInterpolationAlpha() const {
+    if (config.fixedTimeStep <= 0.0f) return 1.0f;
+    return std::min(1.0f, timeAccumulator / config.fixedTimeStep);
+}
+
+void PhysicsWorld::step(float deltaTime, bool captureTransforms) {
+    // Forces become velocity before contacts are solved; positions are integrated by the
+    // solver afterwards. Sleeping bodies are left untouched.
+    if (config.vectorizedIntegration) {
+        integrateVelocitiesPacked(deltaTime, captureTransforms);
+    } else {
+        applyGravity(deltaTime);
+        integrateVelocities(deltaTime, captureTransforms);
+    }
+    
+    // Detect collisions and solve them together with joints and constraints
+    detectCollisions();
+    solveConstraints(deltaTime);
+}
+
+void PhysicsWorld::integrateVelocities(float deltaTime, bool captureTransforms) {
+    m_stepBodies.clear();
     auto entities = entityManager->getEntitiesWithComponent<PhysicsBody>();
     for (auto* entity : entities) {
         auto* body = entity->getComponent<PhysicsBody>();
-        if (body && body->isEnabled()) {
-            body->update(deltaTime);
+        if (!body || !body->isEnabled()) continue;
+        
+        if (captureTransforms) captureTransform(body);
+        m_stepBodies.push_back(body);
+        if (body->type == BodyType::DYNAMIC && body->isAwake()) {
+            body->integrateVelocity(deltaTime);
+        } else if (body->type == BodyType::STATIC) {
+            body->velocity = Math::Vector2D(0, 0);
         }
     }
+}
+
+void PhysicsWorld::integrateVelocitiesPacked(float deltaTime, bool captureTransforms) {
+    // The store already knows the world's bodies, so one pass over it gathers the step's
+    // bodies and streams the awake dynamic ones through the SIMD lanes; no ECS query
+    if (entityManager->getStorageMode() == ECS::StorageMode::ARCHETYPE) {
+        m_bodyStore.refreshBodies();
+    }
     
-    // Detect and resolve collisions
-    detectCollisions();
-    resolveCollisions();
+    m_stepBodies.clear();
+    m_bodyStore.beginIntegration(gravity, deltaTime);
+    const size_t count = m_bodyStore.size();
+    for (size_t i = 0; i < count; ++i) {
+        PhysicsBody* body = m_bodyStore.getBody(i);
+        if (!body->isEnabled() || !m_bodyStore.getEntity(i)->isActive()) continue;
+        
+        if (captureTransforms) captureTransform(body);
+        m_stepBodies.push_back(body);
+        if (body->type == BodyType::DYNAMIC && body->isAwake()) {
+            if (body->inverseMass > 0.0f) {
+                m_bodyStore.integrate(body);
+            } else {
+                // Infinite mass: applyGravity's force is ignored and only a preset
+                // acceleration applies, exactly as on the per-body path
+                if (body->useGravity) body->applyForce(gravity * body->mass);
+                body->integrateVelocity(deltaTime);
+            }
+        } else if (body->type == BodyType::STATIC) {
+            body->velocity = Math::Vector2D(0, 0);
+        }
+    }
+    m_bodyStore.endIntegration();
+}
+
+void PhysicsWorld::solveConstraints(float deltaTime) {
+    m_stepJoints.clear();
+    for (const auto& joint : m_jointManager->getJoints()) {
+        if (joint->isEnabled() && !joint->isBroken() && joint->bindBodies()) {
+            m_stepJoints.push_back(joint.get());
+        }
+    }
+    
+    m_stepConstraints.clear();
+    for (const auto& constraint : m_constraints) {
+        if (constraint->isEnabled()) {
+            m_stepConstraints.push_back(constraint.get());
+        }
+    }
+    
+    m_solver.solve(deltaTime, m_stepBodies, m_stepJoints, m_stepConstraints,
+                   makeSolverSettings());
+    m_jointManager->checkBreakage();
+}
+
+void PhysicsWorld::saveState(PhysicsState& state) {
+    state.bodies.clear();
+    state.joints.clear();
+    state.timeAccumulator = timeAccumulator;
+    state.stepCount = m_stepCount;
+    if (!entityManager) return;
+    
+    auto entities = entityManager->getEntitiesWithComponent<PhysicsBody>();
+    state.bodies.reserve(entities.size());
+    for (auto* entity : entities) {
+        const auto* body = entity->getComponent<PhysicsBody>();
+        if (!body) continue;
+        
+        PhysicsBodyState saved;
+        saved.entityId = entity->getID();
+        saved.position = body->position;
+        saved.velocity = body->velocity;
+        saved.acceleration = body->acceleration;
+        saved.force = body->force;
+        saved.previousPosition = body->previousPosition;
+        saved.rotation = body->rotation;
+        saved.angularVelocity = body->angularVelocity;
+        saved.previousRotation = body->previousRotation;
+        saved.sleepTime = body->sleepTime;
+        saved.awake = body->awake;
+        state.bodies.push_back(saved);
+    }
+    
+    state.contacts = m_solver.getContacts();
+    
+    const auto& joints = m_jointManager->getJoints();
+    state.jointCount = joints.size();
+    for (const auto& joint : joints) {
+        joint->saveState(state.joints);
+    }
+}
+
+bool PhysicsWorld::restoreState(const PhysicsState& state) {
+    if (!entityManager) return false;
+    
+    bool complete = true;
+    for (const auto& saved : state.bodies) {
+        ECS::Entity* entity = entityManager->getEntity(saved.entityId);
+        auto* body = entity ? entity->getComponent<PhysicsBody>() : nullptr;
+        if (!body) {
+            complete = false;
+            continue;
+        }
+        
+        body->position = saved.position;
+        body->velocity = saved.velocity;
+        body->acceleration = saved.acceleration;
+        body->force = saved.force;
+        body->previousPosition = saved.previousPosition;
+        body->rotation = saved.rotation;
+        body->angularVelocity = saved.angularVelocity;
+        body->previousRotation = saved.previousRotation;
+        body->sleepTime = saved.sleepTime;
+        body->awake = saved.awake;
+    }
+    
+    // Manifolds keep their impulses; body pointers are re-resolved by the next contact update
+    m_solver.restoreContacts(state.contacts);
+    
+    const auto& joints = m_jointManager->getJoints();
+    if (joints.size() == state.jointCount) {
+        const float* in = state.joints.data();
+        for (const auto& joint : joints) {
+            in = joint->loadState(in);
+        }
+    } else {
+        complete = false;
+    }
+    
+    timeAccumulator = state.timeAccumulator;
+    m_stepCount = state.stepCount;
+    m_refreshProxyBounds = true;
+    return complete;
+}
+
+SolverSettings PhysicsWorld::makeSolverSettings() const {
+    SolverSettings settings;
+    settings.velocityIterations = config.velocityIterations;
+    settings.positionIterations = config.positionIterations;
+    settings.warmStarting = config.warmStarting;
+    settings.baumgarte = config.constraintBias;
+    settings.slop = config.constraintSlop;
+    settings.restitutionThreshold = config.restitutionThreshold;
+    settings.allowSleeping = config.allowSleeping;
+    settings.sleepVelocity = config.sleepThreshold;
+    settings.timeToSleep = config.timeToSleep;
+    return settings;
+}
+
+void PhysicsWorld::addConstraint(std::shared_ptr<Constraint> constraint) {
+    if (constraint) {
+        m_constraints.push_back(std::move(constraint));
+    }
+}
+
+void PhysicsWorld::removeConstraint(const std::shared_ptr<Constraint>& constraint) {
+    m_constraints.erase(std::remove(m_constraints.begin(), m_constraints.end(), constraint),
+                        m_constraints.end());
 }
 
 void PhysicsWorld::applyGravity(float deltaTime) {
@@ -35,46 +300,290 @@ void PhysicsWorld::applyGravity(float deltaTime) {
     auto entities = entityManager->getEntitiesWithComponent<PhysicsBody>();
     for (auto* entity : entities) {
         auto* body = entity->getComponent<PhysicsBody>();
-        if (body && body->isEnabled() && body->useGravity && body->type == BodyType::DYNAMIC) {
+        if (body && body->isEnabled() && body->useGravity && body->type == BodyType::DYNAMIC &&
+            body->isAwake()) {
             body->applyForce(gravity * body->mass);
         }
     }
 }
 
+void PhysicsWorld::setBroadphaseType(BroadphaseType type) {
+    if (type == m_broadphaseType) return;
+    
+    clearBroadphase();
+    m_broadphaseType = type;
+    m_aabbTree.reset();
+    m_sweepAndPrune.reset();
+    
+    if (type == BroadphaseType::AABB_TREE) {
+        m_aabbTree = std::make_unique<Engine::DynamicAABBTree>();
+    } else if (type == BroadphaseType::SWEEP_AND_PRUNE) {
+        m_sweepAndPrune = std::make_unique<Engine::SweepAndPrune>();
+    }
+}
+
 void PhysicsWorld::detectCollisions() {
     collisions.clear();
     
     if (!entityManager) return;
     
-    auto entities = entityManager->getEntitiesWithComponent<Collider>();
+    auto broadphaseStart = std::chrono::high_resolution_clock::now();
+    syncBroadphaseProxies();
+    findCandidatePairs();
     
-    for (size_t i = 0; i < entities.size(); ++i) {
-        auto* collider1 = entities[i]->getComponent<Collider>();
-        if (!collider1 || !collider1->isEnabled()) continue;
+    // Proxy slots and tree shape depend on history, entity IDs don't: process pairs in ID
+    // order so contacts, callbacks and solver input come out the same on every replay
+    for (auto& pair : m_candidatePairs) {
+        if (m_proxies[pair.second].entityId < m_proxies[pair.first].entityId) {
+            std::swap(pair.first, pair.second);
+        }
+    }
+    std::sort(m_candidatePairs.begin(), m_candidatePairs.end(),
+              [this](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                  ECS::EntityID a1 = m_proxies[a.first].entityId;
+                  ECS::EntityID b1 = m_proxies[b.first].entityId;
+                  if (a1 != b1) return a1 < b1;
+                  return m_proxies[a.second].entityId < m_proxies[b.second].entityId;
+              });
+    auto narrowphaseStart = std::chrono::high_resolution_clock::now();
+    
+    collisions.reserve(m_candidatePairs.size());
+    m_solver.beginContacts();
+    for (const auto& pair : m_candidatePairs) {
+        const BroadphaseProxy& a = m_proxies[pair.first];
+        const BroadphaseProxy& b = m_proxies[pair.second];
+        
+        // Resting pairs keep last step's manifold
+        if (!isMoving(a.body) && !isMoving(b.body)) continue;
+        
+        CollisionInfo info;
+        if (a.collider->checkCollision(b.collider, info)) {
+            collisions.push_back({a.entity, info});
+            if (!a.collider->isTrigger && !b.collider->isTrigger) {
+                m_solver.addContact(a.entityId, a.body, b.entityId, b.body, info);
+            }
+        }
+    }
+    m_solver.endContacts([this](ECS::EntityID id, PhysicsBody*& body) {
+        auto it = m_proxyLookup.find(id);
+        if (it == m_proxyLookup.end()) return false;
+        body = m_proxies[it->second].body;
+        return true;
+    });
+    
+    auto narrowphaseEnd = std::chrono::high_resolution_clock::now();
+    
+    m_broadphaseStats.totalBodies = static_cast<int>(m_proxyLookup.size());
+    m_broadphaseStats.activeCells = 0; // Only meaningful for grid-based broad phases
+    m_broadphaseStats.potentialPairs = static_cast<int>(m_candidatePairs.size());
+    m_broadphaseStats.actualCollisions = static_cast<int>(collisions.size());
+    m_broadphaseStats.broadphaseTimeMs = elapsedMs(broadphaseStart, narrowphaseStart);
+    m_broadphaseStats.narrowphaseTimeMs = elapsedMs(narrowphaseStart, narrowphaseEnd);
+}
+
+Collider* PhysicsWorld::findCollider(ECS::Entity* entity) {
+    // Components are keyed by their concrete type, so look up each shape explicitly
+    if (auto* circle = entity->getComponent<CircleCollider>()) return circle;
+    if (auto* box = entity->getComponent<BoxCollider>()) return box;
+    return entity->getComponent<Collider>();
+}
+
+SpatialAABB PhysicsWorld::computeBounds(const Collider& collider) {
+    if (collider.type == ColliderType::CIRCLE) {
+        const auto& circle = static_cast<const CircleCollider&>(collider);
+        Math::Vector2D center = circle.getPosition();
+        Math::Vector2D extent(circle.radius, circle.radius);
+        return SpatialAABB(center - extent, center + extent);
+    }
+    if (collider.type == ColliderType::BOX) {
+        const auto& box = static_cast<const BoxCollider&>(collider);
+        return SpatialAABB(box.getMin(), box.getMax());
+    }
+    Math::Vector2D position = collider.getPosition();
+    return SpatialAABB(position, position);
+}
+
+void PhysicsWorld::syncBroadphaseProxies() {
+    for (auto& proxy : m_proxies) {
+        proxy.seen = false;
+    }
+    
+    // Entity list is scratch for this step only: build it in the thread's frame allocator
+    Memory::FrameVector<ECS::Entity*> entities;
+    entities.reserve(entityManager->getEntityCount());
+    entityManager->getAllEntities(entities);
+    
+    for (auto* entity : entities) {
+        Collider* collider = findCollider(entity);
+        if (!collider || !collider->isEnabled()) continue;
+        
+        auto* body = entity->getComponent<PhysicsBody>();
+        bool isStatic = !body || body->type == BodyType::STATIC;
         
-        for (size_t j = i + 1; j < entities.size(); ++j) {
-            auto* collider2 = entities[j]->getComponent<Collider>();
-            if (!collider2 || !collider2->isEnabled()) continue;
+        int index;
+        auto it = m_proxyLookup.find(entity->getID());
+        if (it == m_proxyLookup.end()) {
+            index = createBroadphaseProxy(entity, collider, body, isStatic);
+        } else if (m_proxies[it->second].isStatic != isStatic) {
+            destroyBroadphaseProxy(it->second);
+            index = createBroadphaseProxy(entity, collider, body, isStatic);
+        } else {
+            index = it->second;
+            BroadphaseProxy& proxy = m_proxies[index];
+            
+            // Component addresses can change between steps (archetype storage moves them)
+            proxy.entity = entity;
+            proxy.collider = collider;
+            proxy.body = body;
             
-            CollisionInfo info;
-            if (collider1->checkCollision(collider2, info)) {
-                collisions.push_back(info);
+            // Sleeping bodies don't move, so their bounds stay as they are once refreshed
+            // for the step they fell asleep in
+            bool wasSleeping = proxy.sleeping;
+            proxy.sleeping = !isStatic && !isMoving(body);
+            if (proxy.sleeping && wasSleeping && !m_refreshProxyBounds) {
+                proxy.seen = true;
+                continue;
             }
+            
+            SpatialAABB bounds = computeBounds(*collider);
+            if (m_aabbTree) {
+                Math::Vector2D moved = bounds.getCenter() - proxy.bounds.getCenter();
+                float displacement[3] = {moved.x, moved.y, 0.0f};
+                m_aabbTree->moveProxy(proxy.treeProxy, toBroadphaseAABB(bounds), displacement);
+            } else if (m_sweepAndPrune) {
+                m_sweepAndPrune->updateObject(index, toBroadphaseAABB(bounds));
+            }
+            proxy.bounds = bounds;
+        }
+        m_proxies[index].seen = true;
+    }
+    
+    for (size_t i = 0; i < m_proxies.size(); ++i) {
+        if (m_proxies[i].alive && !m_proxies[i].seen) {
+            destroyBroadphaseProxy(static_cast<int>(i));
+        }
+    }
+    m_refreshProxyBounds = false;
+}
+
+int PhysicsWorld::createBroadphaseProxy(ECS::Entity* entity, Collider* collider,
+                                        PhysicsBody* body, bool isStatic) {
+    int index;
+    if (!m_freeProxies.empty()) {
+        index = m_freeProxies.back();
+        m_freeProxies.pop_back();
+    } else {
+        index = static_cast<int>(m_proxies.size());
+        m_proxies.emplace_back();
+    }
+    
+    BroadphaseProxy& proxy = m_proxies[index];
+    proxy.entityId = entity->getID();
+    proxy.entity = entity;
+    proxy.collider = collider;
+    proxy.body = body;
+    proxy.bounds = computeBounds(*collider);
+    proxy.treeProxy = -1;
+    proxy.isStatic = isStatic;
+    proxy.sleeping = !isStatic && !isMoving(body);
+    proxy.alive = true;
+    proxy.seen = true;
+    
+    if (m_aabbTree) {
+        void* userData = reinterpret_cast<void*>(static_cast<intptr_t>(index));
+        proxy.treeProxy = m_aabbTree->createProxy(toBroadphaseAABB(proxy.bounds), userData);
+    } else if (m_sweepAndPrune) {
+        m_sweepAndPrune->addObject(index, toBroadphaseAABB(proxy.bounds), isStatic);
+    }
+    
+    m_proxyLookup[proxy.entityId] = index;
+    return index;
+}
+
+void PhysicsWorld::destroyBroadphaseProxy(int index) {
+    BroadphaseProxy& proxy = m_proxies[index];
+    
+    if (m_aabbTree) {
+        m_aabbTree->destroyProxy(proxy.treeProxy);
+    } else if (m_sweepAndPrune) {
+        m_sweepAndPrune->removeObject(index);
+    }
+    
+    m_proxyLookup.erase(proxy.entityId);
+    proxy.entity = nullptr;
+    proxy.collider = nullptr;
+    proxy.body = nullptr;
+    proxy.alive = false;
+    m_freeProxies.push_back(index);
+}
+
+void PhysicsWorld::clearBroadphase() {
+    for (size_t i = 0; i < m_proxies.size(); ++i) {
+        if (m_proxies[i].alive) {
+            destroyBroadphaseProxy(static_cast<int>(i));
+        }
+    }
+    m_proxies.clear();
+    m_freeProxies.clear();
+    m_candidatePairs.clear();
+}
+
+void PhysicsWorld::findCandidatePairs() {
+    m_candidatePairs.clear();
+    
+    if (m_broadphaseType == BroadphaseType::SWEEP_AND_PRUNE) {
+        m_sweepAndPrune->computeOverlaps(m_candidatePairs);
+        return;
+    }
+    
+    const int count = static_cast<int>(m_proxies.size());
+    
+    if (m_broadphaseType == BroadphaseType::AABB_TREE) {
+        // Only moving bodies query the tree, so static geometry and sleeping bodies cost
+        // nothing until touched. Fat AABBs are tested against fat AABBs, making the test
+        // symmetric: a pair of moving bodies is found from both sides and kept from the
+        // lower index.
+        auto queries = [this](int index) {
+            return !m_proxies[index].isStatic && !m_proxies[index].sleeping;
+        };
+        for (int i = 0; i < count; ++i) {
+            const BroadphaseProxy& proxy = m_proxies[i];
+            if (!proxy.alive || !queries(i)) continue;
+            
+            m_aabbTree->query(m_aabbTree->getAABB(proxy.treeProxy), [&](int node) {
+                int other = static_cast<int>(
+                    reinterpret_cast<intptr_t>(m_aabbTree->getUserData(node)));
+                if (other == i || (queries(other) && other < i)) {
+                    return true;
+                }
+                m_candidatePairs.emplace_back(i, other);
+                return true;
+            });
+        }
+        return;
+    }
+    
+    for (int i = 0; i < count; ++i) {
+        if (!m_proxies[i].alive) continue;
+        for (int j = i + 1; j < count; ++j) {
+            if (!m_proxies[j].alive) continue;
+            if (m_proxies[i].isStatic && m_proxies[j].isStatic) continue;
+            m_candidatePairs.emplace_back(i, j);
         }
     }
 }
 
 void PhysicsWorld::resolveCollisions() {
-    for (const auto& info : collisions) {
-        if (!info.colliding) continue;
-        resolveCollision(info);
+    for (const auto& contact : collisions) {
+        if (!contact.info.colliding) continue;
+        resolveCollision(contact.entityA, contact.info);
     }
 }
 
-void PhysicsWorld::resolveCollision(const CollisionInfo& info) {
-    if (!info.other) return;
+void PhysicsWorld::resolveCollision(ECS::Entity* entityA, const CollisionInfo& info) {
+    if (!entityA || !info.other) return;
     
-    auto* body1 = info.other->getOwner()->getComponent<PhysicsBody>();
+    auto* body1 = entityA->getComponent<PhysicsBody>();
     auto* body2 = info.other->getComponent<PhysicsBody>();
     
     if (!body1 || !body2) return;
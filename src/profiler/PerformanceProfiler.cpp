@@ -188,6 +188,68 @@ void PerformanceProfiler::endProfile(const std::string& name) {
     }
 }
 
+void PerformanceProfiler::recordProfile(const std::string& name,
+                                        std::chrono::high_resolution_clock::time_point startTime,
+                                        std::chrono::high_resolution_clock::time_point endTime,
+                                        int threadId) {
+    if (!profilingEnabled) return;
+    
+    ProfileEntry entry;
+    entry.name = name;
+    entry.startTime = startTime;
+    entry.endTime = endTime;
+    entry.duration = std::chrono::duration<double, std::micro>(endTime - startTime).count();
+    entry.threadId = threadId;
+    entry.completed = true;
+    
+    std::lock_guard<std::mutex> lock(profileMutex);
+    
+    auto& history = timerHistory[name];
+    history.push_back(entry.duration);
+    if (history.size() > maxHistorySize) {
+        history.erase(history.begin());
+    }
+    
+    completedEntries.push_back(entry);
+    
+    if (activeSession) {
+        writeSessionData(entry);
+    }
+}
+
+void PerformanceProfiler::recordValue(const std::string& name, double value) {
+    if (!profilingEnabled) return;
+    
+    std::lock_guard<std::mutex> lock(profileMutex);
+    
+    auto& history = valueHistory[name];
+    history.push_back(value);
+    if (history.size() > maxHistorySize) {
+        history.erase(history.begin());
+    }
+}
+
+double PerformanceProfiler::getAverageValue(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    
+    auto it = valueHistory.find(name);
+    if (it != valueHistory.end() && !it->second.empty()) {
+        double sum = std::accumulate(it->second.begin(), it->second.end(), 0.0);
+        return sum / it->second.size();
+    }
+    return 0.0;
+}
+
+double PerformanceProfiler::getLastValue(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(profileMutex);
+    
+    auto it = valueHistory.find(name);
+    if (it != valueHistory.end() && !it->second.empty()) {
+        return it->second.back();
+    }
+    return 0.0;
+}
+
 double PerformanceProfiler::getAverageTime(const std::string& name) const {
     std::lock_guard<std::mutex> lock(profileMutex);
     
@@ -296,6 +358,14 @@ std::string PerformanceProfiler::generateReport() const {
         report << "    Max: " << (getMaxTime(pair.first) / 1000.0) << " ms\n";
     }
     
+    if (!valueHistory.empty()) {
+        report << "\nValues:\n";
+        for (const auto& pair : valueHistory) {
+            report << "  " << pair.first << ": avg " << getAverageValue(pair.first)
+                   << ", last " << getLastValue(pair.first) << "\n";
+        }
+    }
+    
     return report.str();
 }
 
@@ -317,6 +387,16 @@ void PerformanceProfiler::exportToCSV(const std::string& filepath) const {
              << pair.second.size() << "\n";
     }
     
+    if (!valueHistory.empty()) {
+        file << "\nName,AvgValue,LastValue,SampleCount\n";
+        for (const auto& pair : valueHistory) {
+            file << pair.first << ","
+                 << getAverageValue(pair.first) << ","
+                 << getLastValue(pair.first) << ","
+                 << pair.second.size() << "\n";
+        }
+    }
+    
     file.close();
 }
 
@@ -351,6 +431,21 @@ void PerformanceProfiler::exportToJSON(const std::string& filepath) const {
         file << "    }";
     }
     
+    file << "\n  ],\n";
+    file << "  \"values\": [\n";
+    
+    first = true;
+    for (const auto& pair : valueHistory) {
+        if (!first) file << ",\n";
+        first = false;
+        
+        file << "    {\n";
+        file << "      \"name\": \"" << pair.first << "\",\n";
+        file << "      \"avgValue\": " << getAverageValue(pair.first) << ",\n";
+        file << "      \"lastValue\": " << getLastValue(pair.first) << "\n";
+        file << "    }";
+    }
+    
     file << "\n  ]\n";
     file << "}\n";
     
@@ -385,6 +480,7 @@ void PerformanceProfiler::clear() {
     profileEntries.clear();
     completedEntries.clear();
     timerHistory.clear();
+    valueHistory.clear();
     
     frameStats = FrameStats();
     gpuStats = GPUStats();
@@ -678,5 +774,160 @@ std::string CallStackProfiler::generateFlameGraph() const {
     return oss.str();
 }
 
+// =============================================================================
+// Timeline Profiler Implementation
+// =============================================================================
+
+TimelineProfiler::TimelineProfiler() {
+    currentFrame.frameNumber = 0;
+    currentFrame.frameStartTime = getCurrentTimestamp();
+    currentFrame.frameEndTime = currentFrame.frameStartTime;
+}
+
+TimelineProfiler::~TimelineProfiler() = default;
+
+void TimelineProfiler::beginFrame() {
+    if (!enabled) return;
+    
+    // Tracks persist across frames; only their events are per frame
+    for (auto& track : currentFrame.tracks) {
+        track.events.clear();
+    }
+    currentFrame.markers.clear();
+    currentFrame.frameStartTime = getCurrentTimestamp();
+    currentFrame.frameEndTime = currentFrame.frameStartTime;
+    activeEventStack.clear();
+}
+
+void TimelineProfiler::endFrame() {
+    if (!enabled) return;
+    
+    currentFrame.frameEndTime = getCurrentTimestamp();
+    capturedFrames.push_back(currentFrame);
+    if (static_cast<int>(capturedFrames.size()) > maxCapturedFrames) {
+        capturedFrames.erase(capturedFrames.begin(),
+                             capturedFrames.end() - std::max(maxCapturedFrames, 0));
+    }
+    ++currentFrame.frameNumber;
+}
+
+int TimelineProfiler::createTrack(const std::string& name, const std::string& category) {
+    auto it = trackNameToId.find(name);
+    if (it != trackNameToId.end()) return it->second;
+    
+    TimelineTrack track;
+    track.name = name;
+    track.trackId = nextTrackId++;
+    track.category = category;
+    currentFrame.tracks.push_back(track);
+    trackNameToId[name] = track.trackId;
+    return track.trackId;
+}
+
+void TimelineProfiler::removeTrack(int trackId) {
+    auto& tracks = currentFrame.tracks;
+    for (auto it = tracks.begin(); it != tracks.end(); ++it) {
+        if (it->trackId == trackId) {
+            trackNameToId.erase(it->name);
+            tracks.erase(it);
+            break;
+        }
+    }
+    activeEventStack.erase(trackId);
+}
+
+TimelineTrack* TimelineProfiler::getTrack(int trackId) {
+    for (auto& track : currentFrame.tracks) {
+        if (track.trackId == trackId) return &track;
+    }
+    return nullptr;
+}
+
+TimelineTrack* TimelineProfiler::getTrack(const std::string& name) {
+    auto it = trackNameToId.find(name);
+    return it != trackNameToId.end() ? getTrack(it->second) : nullptr;
+}
+
+void TimelineProfiler::beginEvent(int trackId, const std::string& name, uint32_t color) {
+    TimelineTrack* track = getTrack(trackId);
+    if (!enabled || !track) return;
+    
+    auto& stack = activeEventStack[trackId];
+    TimelineEvent event;
+    event.name = name;
+    event.category = track->category;
+    event.startTime = getCurrentTimestamp() - currentFrame.frameStartTime;
+    event.endTime = event.startTime;
+    event.threadId = 0;
+    event.depth = static_cast<int>(stack.size());
+    event.color = color;
+    stack.push_back(track->events.size());
+    track->events.push_back(std::move(event));
+}
+
+void TimelineProfiler::beginEvent(const std::string& trackName, const std::string& name,
+                                  uint32_t color) {
+    beginEvent(createTrack(trackName), name, color);
+}
+
+void TimelineProfiler::endEvent(int trackId) {
+    TimelineTrack* track = getTrack(trackId);
+    auto it = activeEventStack.find(trackId);
+    if (!track || it == activeEventStack.end() || it->second.empty()) return;
+    
+    track->events[it->second.back()].endTime =
+        getCurrentTimestamp() - currentFrame.frameStartTime;
+    it->second.pop_back();
+}
+
+void TimelineProfiler::endEvent(const std::string& trackName) {
+    auto it = trackNameToId.find(trackName);
+    if (it != trackNameToId.end()) endEvent(it->second);
+}
+
+void TimelineProfiler::addInstantEvent(int trackId, const std::string& name, uint32_t color) {
+    beginEvent(trackId, name, color);
+    endEvent(trackId);
+}
+
+void TimelineProfiler::addEvent(int trackId, const TimelineEvent& event) {
+    TimelineTrack* track = getTrack(trackId);
+    if (!enabled || !track) return;
+    track->events.push_back(event);
+}
+
+void TimelineProfiler::addMarker(const std::string& name, uint32_t color) {
+    if (!enabled) return;
+    currentFrame.markers.push_back(
+        {name, getCurrentTimestamp() - currentFrame.frameStartTime, color});
+}
+
+const TimelineFrame& TimelineProfiler::getCurrentFrame() const {
+    return currentFrame;
+}
+
+const TimelineFrame& TimelineProfiler::getFrame(int frameNumber) const {
+    for (const auto& frame : capturedFrames) {
+        if (frame.frameNumber == frameNumber) return frame;
+    }
+    return currentFrame;
+}
+
+std::vector<TimelineFrame> TimelineProfiler::getFrameRange(int startFrame, int endFrame) const {
+    std::vector<TimelineFrame> frames;
+    for (const auto& frame : capturedFrames) {
+        if (frame.frameNumber >= startFrame && frame.frameNumber <= endFrame) {
+            frames.push_back(frame);
+        }
+    }
+    return frames;
+}
+
+uint64_t TimelineProfiler::getCurrentTimestamp() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
 } // namespace Utils
 } // namespace JJM
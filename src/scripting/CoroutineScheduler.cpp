@@ -0,0 +1,624 @@
+#include "scripting/ScriptEngine.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+
+namespace JJM {
+namespace Scripting {
+
+namespace {
+
+// Ticks the wheels can hold before an expiry is clamped to the last bucket
+constexpr uint64_t WHEEL_SPAN = 1ull << 32;
+
+// The low half is the slot index plus one, so no id is 0; the high half is the slot's
+// generation, so ids of finished coroutines never match the slot's next occupant
+uint64_t makeId(uint32_t generation, uint32_t index) {
+    return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(index) + 1);
+}
+
+bool isFinished(CoroutineState state) {
+    return state == CoroutineState::Completed || state == CoroutineState::Error ||
+           state == CoroutineState::Cancelled;
+}
+
+} // namespace
+
+CoroutineScheduler* CoroutineScheduler::instance = nullptr;
+
+CoroutineScheduler::CoroutineScheduler()
+    : liveCount(0)
+    , currentFrame(0)
+    , deltaTime(0.0f)
+    , currentTime(0.0)
+    , frameTimestamp(std::chrono::steady_clock::now())
+    , maxResumesPerFrame(0)
+    , maxResumeMilliseconds(0.0f)
+{}
+
+CoroutineScheduler::~CoroutineScheduler() = default;
+
+CoroutineScheduler* CoroutineScheduler::getInstance() {
+    if (!instance) {
+        instance = new CoroutineScheduler();
+    }
+    return instance;
+}
+
+void CoroutineScheduler::cleanup() {
+    delete instance;
+    instance = nullptr;
+}
+
+// =============================================================================
+// Context pool
+// =============================================================================
+
+void CoroutineScheduler::reserve(size_t coroutineCount) {
+    while (pool.size() * POOL_CHUNK < coroutineCount) {
+        const uint32_t first = static_cast<uint32_t>(pool.size() * POOL_CHUNK);
+        pool.push_back(std::make_unique<CoroutineSlot[]>(POOL_CHUNK));
+        freeSlots.reserve(pool.size() * POOL_CHUNK);
+        for (uint32_t i = POOL_CHUNK; i-- > 0;) {
+            freeSlots.push_back(first + i);
+        }
+    }
+    stats.pooledContexts = pool.size() * POOL_CHUNK;
+    stats.freeContexts = freeSlots.size();
+}
+
+uint32_t CoroutineScheduler::allocateSlot() {
+    if (freeSlots.empty()) {
+        reserve(pool.size() * POOL_CHUNK + 1);
+    }
+    uint32_t index = freeSlots.back();
+    freeSlots.pop_back();
+    return index;
+}
+
+CoroutineScheduler::CoroutineSlot* CoroutineScheduler::findSlot(uint64_t id) const {
+    const uint32_t low = static_cast<uint32_t>(id);
+    if (low == 0 || low > pool.size() * POOL_CHUNK) return nullptr;
+    CoroutineSlot& slot = slotAt(low - 1);
+    return slot.context.id == id ? &slot : nullptr;
+}
+
+void CoroutineScheduler::pushBack(SlotList& list, uint32_t index, SlotQueue queue) {
+    CoroutineSlot& slot = slotAt(index);
+    slot.prev = list.tail;
+    slot.next = NO_SLOT;
+    if (list.tail != NO_SLOT) {
+        slotAt(list.tail).next = index;
+    } else {
+        list.head = index;
+    }
+    list.tail = index;
+    list.size++;
+    slot.list = &list;
+    slot.queue = queue;
+}
+
+void CoroutineScheduler::unlink(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    if (!slot.list) return;
+
+    SlotList& list = *slot.list;
+    if (slot.prev != NO_SLOT) {
+        slotAt(slot.prev).next = slot.next;
+    } else {
+        list.head = slot.next;
+    }
+    if (slot.next != NO_SLOT) {
+        slotAt(slot.next).prev = slot.prev;
+    } else {
+        list.tail = slot.prev;
+    }
+    list.size--;
+
+    if (slot.queue == SlotQueue::FrameWheel) frameWheel.count--;
+    if (slot.queue == SlotQueue::TimeWheel) timeWheel.count--;
+    slot.next = NO_SLOT;
+    slot.prev = NO_SLOT;
+    slot.list = nullptr;
+    slot.queue = SlotQueue::None;
+}
+
+// =============================================================================
+// Timer wheels
+// =============================================================================
+
+// Level 0 holds expiries in the current 256-tick block, level 1 those in the current
+// 65536-tick block, and so on. A bucket above level 0 is redistributed downwards when the
+// ticks below it wrap around to its position
+void CoroutineScheduler::wheelInsert(TimerWheel& wheel, uint32_t index, uint64_t expiry,
+                                     SlotQueue queue) {
+    slotAt(index).expiry = expiry;
+    const uint64_t current = wheel.currentTick;
+    const uint64_t target = std::min(std::max(expiry, current), current + WHEEL_SPAN - 1);
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 &&
+           (target >> (WHEEL_BITS * (level + 1))) != (current >> (WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    const size_t bucket = level * WHEEL_BUCKETS +
+                          ((target >> (WHEEL_BITS * level)) & (WHEEL_BUCKETS - 1));
+    pushBack(wheel.buckets[bucket], index, queue);
+    wheel.count++;
+}
+
+void CoroutineScheduler::wheelAdvance(TimerWheel& wheel, uint64_t tick, SlotQueue queue) {
+    while (wheel.currentTick < tick) {
+        if (wheel.count == 0) {
+            wheel.currentTick = tick;  // Nothing to cascade or fire on the way
+            break;
+        }
+        const uint64_t t = ++wheel.currentTick;
+
+        for (int level = 1; level < WHEEL_LEVELS; ++level) {
+            if (t & ((1ull << (WHEEL_BITS * level)) - 1)) break;
+
+            SlotList& bucket = wheel.buckets[level * WHEEL_BUCKETS +
+                                             ((t >> (WHEEL_BITS * level)) & (WHEEL_BUCKETS - 1))];
+            uint32_t index = bucket.head;
+            wheel.count -= bucket.size;
+            bucket = SlotList();
+            while (index != NO_SLOT) {
+                CoroutineSlot& slot = slotAt(index);
+                const uint32_t next = slot.next;
+                slot.list = nullptr;
+                wheelInsert(wheel, index, slot.expiry, queue);
+                index = next;
+            }
+        }
+        wheelFire(wheel, t, queue);
+    }
+}
+
+void CoroutineScheduler::wheelFire(TimerWheel& wheel, uint64_t tick, SlotQueue queue) {
+    SlotList& bucket = wheel.buckets[tick & (WHEEL_BUCKETS - 1)];
+    uint32_t index = bucket.head;
+    wheel.count -= bucket.size;
+    bucket = SlotList();
+    while (index != NO_SLOT) {
+        CoroutineSlot& slot = slotAt(index);
+        const uint32_t next = slot.next;
+        slot.list = nullptr;
+        if (slot.expiry > tick) {
+            wheelInsert(wheel, index, slot.expiry, queue);  // Was clamped to the wheel's span
+        } else if (queue == SlotQueue::TimeWheel && slot.deadline > currentTime) {
+            pushBack(imminent, index, SlotQueue::Imminent);
+        } else {
+            pushBack(ready, index, SlotQueue::Ready);
+            stats.timersFiredLastFrame++;
+        }
+        index = next;
+    }
+}
+
+// =============================================================================
+// Creation and control
+// =============================================================================
+
+uint64_t CoroutineScheduler::startCoroutine(const std::string& name, CoroutineFunction func) {
+    const uint32_t index = allocateSlot();
+    CoroutineSlot& slot = slotAt(index);
+    CoroutineContext& ctx = slot.context;
+
+    ctx.id = makeId(slot.generation, index);
+    ctx.name = name;
+    ctx.state = CoroutineState::Created;
+    ctx.startTime = std::chrono::steady_clock::now();
+    ctx.elapsedTime = 0.0f;
+    ctx.frameCount = 0;
+    ctx.framesWaited = 0;
+    slot.function = std::move(func);
+    slot.startTime = currentTime;
+    slot.yieldFrame = currentFrame;
+    pushBack(pending, index, SlotQueue::Pending);
+
+    liveCount++;
+    stats.totalCreated++;
+    stats.currentActive = liveCount;
+    return ctx.id;
+}
+
+uint64_t CoroutineScheduler::startCoroutine(CoroutineFunction func) {
+    return startCoroutine("", std::move(func));
+}
+
+uint64_t CoroutineScheduler::startChildCoroutine(uint64_t parentId, const std::string& name,
+                                                 CoroutineFunction func) {
+    const uint64_t id = startCoroutine(name, std::move(func));
+    if (CoroutineSlot* parent = findSlot(parentId)) {
+        parent->context.childCoroutines.push_back(id);
+        findSlot(id)->context.parentCoroutine = parentId;
+    }
+    return id;
+}
+
+void CoroutineScheduler::stopCoroutine(uint64_t id) {
+    CoroutineSlot* slot = findSlot(id);
+    if (!slot || isFinished(slot->context.state)) return;
+
+    // Finished children keep stale ids here; findSlot() ignores those
+    for (size_t i = 0; i < slot->context.childCoroutines.size(); ++i) {
+        stopCoroutine(slot->context.childCoroutines[i]);
+    }
+    completeCoroutine(static_cast<uint32_t>(id) - 1, CoroutineState::Cancelled);
+}
+
+void CoroutineScheduler::stopAllCoroutines() {
+    for (uint32_t index = 0; index < pool.size() * POOL_CHUNK; ++index) {
+        const CoroutineSlot& slot = slotAt(index);
+        if (slot.context.id != 0 && !isFinished(slot.context.state)) {
+            completeCoroutine(index, CoroutineState::Cancelled);
+        }
+    }
+}
+
+void CoroutineScheduler::pauseCoroutine(uint64_t id) {
+    CoroutineSlot* slot = findSlot(id);
+    if (!slot || slot->paused || isFinished(slot->context.state)) return;
+
+    slot->paused = true;
+    if (slot->running) {
+        slot->context.state = CoroutineState::Suspended;  // Suspended once it yields
+    } else {
+        suspend(static_cast<uint32_t>(id) - 1);
+    }
+}
+
+void CoroutineScheduler::resumeCoroutine(uint64_t id) {
+    CoroutineSlot* slot = findSlot(id);
+    if (!slot || !slot->paused || isFinished(slot->context.state)) return;
+
+    slot->paused = false;
+    if (slot->running) {
+        slot->context.state = CoroutineState::Running;
+    } else {
+        restore(static_cast<uint32_t>(id) - 1);
+    }
+}
+
+// Takes a coroutine out of its queue, keeping what is left of a timed wait
+void CoroutineScheduler::suspend(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    slot.pausedQueue = slot.queue;
+    if (slot.queue == SlotQueue::FrameWheel) slot.expiry -= frameWheel.currentTick;
+    if (slot.queue == SlotQueue::TimeWheel || slot.queue == SlotQueue::Imminent) {
+        slot.pausedQueue = SlotQueue::TimeWheel;
+        slot.deadline -= currentTime;
+    }
+    unlink(index);
+    slot.context.state = CoroutineState::Suspended;
+}
+
+void CoroutineScheduler::restore(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    switch (slot.pausedQueue) {
+        case SlotQueue::Pending:
+            pushBack(pending, index, SlotQueue::Pending);
+            slot.context.state = CoroutineState::Created;
+            return;
+        case SlotQueue::Ready:
+            pushBack(ready, index, SlotQueue::Ready);
+            break;
+        case SlotQueue::Polling:
+            pushBack(polling, index, SlotQueue::Polling);
+            break;
+        case SlotQueue::FrameWheel:
+            wheelInsert(frameWheel, index, frameWheel.currentTick + slot.expiry,
+                        SlotQueue::FrameWheel);
+            break;
+        case SlotQueue::TimeWheel:
+            sleepFor(index, slot.deadline);
+            break;
+        default:
+            break;
+    }
+    slot.context.state = CoroutineState::Waiting;
+}
+
+// =============================================================================
+// Query
+// =============================================================================
+
+bool CoroutineScheduler::isRunning(uint64_t id) const {
+    const CoroutineSlot* slot = findSlot(id);
+    return slot && !slot->paused && !isFinished(slot->context.state);
+}
+
+bool CoroutineScheduler::isCompleted(uint64_t id) const {
+    const CoroutineSlot* slot = findSlot(id);
+    return !slot || isFinished(slot->context.state);
+}
+
+CoroutineState CoroutineScheduler::getState(uint64_t id) const {
+    const CoroutineSlot* slot = findSlot(id);
+    return slot ? slot->context.state : CoroutineState::Completed;
+}
+
+CoroutineContext* CoroutineScheduler::getContext(uint64_t id) {
+    CoroutineSlot* slot = findSlot(id);
+    return slot ? &slot->context : nullptr;
+}
+
+const CoroutineContext* CoroutineScheduler::getContext(uint64_t id) const {
+    const CoroutineSlot* slot = findSlot(id);
+    return slot ? &slot->context : nullptr;
+}
+
+std::vector<std::string> CoroutineScheduler::getActiveCoroutineNames() const {
+    std::vector<std::string> names;
+    names.reserve(liveCount);
+    for (uint32_t index = 0; index < pool.size() * POOL_CHUNK; ++index) {
+        const CoroutineSlot& slot = slotAt(index);
+        if (slot.context.id != 0) names.push_back(slot.context.name);
+    }
+    return names;
+}
+
+// =============================================================================
+// Update
+// =============================================================================
+
+void CoroutineScheduler::setResumeBudget(size_t maxResumes, float maxMilliseconds) {
+    maxResumesPerFrame = maxResumes;
+    maxResumeMilliseconds = maxMilliseconds;
+}
+
+void CoroutineScheduler::update(float dt) {
+    const auto updateStart = std::chrono::steady_clock::now();
+    frameTimestamp = updateStart;
+    currentFrame++;
+    deltaTime = dt;
+    currentTime += std::max(dt, 0.0f);
+
+    stats.resumedLastFrame = 0;
+    stats.timersFiredLastFrame = 0;
+    stats.polledLastFrame = 0;
+
+    // Deferred coroutines from the last update are already first in line
+    while (pending.head != NO_SLOT) {
+        const uint32_t index = pending.head;
+        unlink(index);
+        pushBack(ready, index, SlotQueue::Ready);
+    }
+
+    wheelAdvance(frameWheel, frameWheel.currentTick + 1, SlotQueue::FrameWheel);
+    wheelAdvance(timeWheel, static_cast<uint64_t>(std::floor(currentTime / TIMER_RESOLUTION)),
+                 SlotQueue::TimeWheel);
+    for (uint32_t index = imminent.head; index != NO_SLOT;) {
+        const uint32_t next = slotAt(index).next;
+        if (slotAt(index).deadline <= currentTime) {
+            unlink(index);
+            pushBack(ready, index, SlotQueue::Ready);
+            stats.timersFiredLastFrame++;
+        }
+        index = next;
+    }
+
+    for (uint32_t index = polling.head; index != NO_SLOT;) {
+        CoroutineSlot& slot = slotAt(index);
+        const uint32_t next = slot.next;
+        stats.polledLastFrame++;
+        try {
+            // A condition may stop coroutines, this one included
+            if (checkYieldCondition(slot.context) && slot.queue == SlotQueue::Polling) {
+                unlink(index);
+                pushBack(ready, index, SlotQueue::Ready);
+            }
+        } catch (const std::exception& e) {
+            slot.context.errorMessage = e.what();
+            completeCoroutine(index, CoroutineState::Error);
+        }
+        index = next;
+    }
+
+    const size_t budget =
+        maxResumesPerFrame > 0 ? maxResumesPerFrame : std::numeric_limits<size_t>::max();
+    while (ready.head != NO_SLOT && stats.resumedLastFrame < budget) {
+        if (maxResumeMilliseconds > 0.0f && stats.resumedLastFrame > 0) {
+            std::chrono::duration<float, std::milli> spent =
+                std::chrono::steady_clock::now() - updateStart;
+            if (spent.count() >= maxResumeMilliseconds) break;
+        }
+        const uint32_t index = ready.head;
+        unlink(index);
+        processCoroutine(index);
+    }
+
+    stats.deferredLastFrame = static_cast<uint32_t>(ready.size);
+    stats.totalDeferred += ready.size;
+    stats.currentActive = liveCount;
+    stats.sleeping = frameWheel.count + timeWheel.count + imminent.size;
+    stats.polling = polling.size;
+    stats.ready = ready.size + pending.size;
+    stats.pooledContexts = pool.size() * POOL_CHUNK;
+    stats.freeContexts = freeSlots.size();
+    stats.lastUpdateMs = std::chrono::duration<float, std::milli>(
+                             std::chrono::steady_clock::now() - updateStart)
+                             .count();
+}
+
+void CoroutineScheduler::processCoroutine(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    CoroutineContext& ctx = slot.context;
+    ctx.state = CoroutineState::Running;
+    ctx.resumeTime = frameTimestamp;
+    ctx.elapsedTime = static_cast<float>(currentTime - slot.startTime);
+    ctx.framesWaited = currentFrame - slot.yieldFrame;
+    ctx.frameCount++;
+
+    bool failed = false;
+    slot.running = true;
+    try {
+        ctx.currentYield = slot.function(ctx);
+    } catch (const std::exception& e) {
+        ctx.errorMessage = e.what();
+        failed = true;
+    } catch (...) {
+        ctx.errorMessage = "unknown exception";
+        failed = true;
+    }
+    slot.running = false;
+    stats.totalResumes++;
+    stats.resumedLastFrame++;
+
+    if (ctx.state == CoroutineState::Cancelled) {
+        removeCoroutine(index);  // Stopped while it ran; already counted
+        return;
+    }
+    if (failed) {
+        completeCoroutine(index, CoroutineState::Error);
+        return;
+    }
+
+    ctx.yieldTime = frameTimestamp;
+    slot.yieldFrame = currentFrame;
+    schedule(index);
+    if (ctx.id != 0 && slot.paused) suspend(index);
+}
+
+// Files a coroutine under what it yielded for; YieldType::None finishes it
+void CoroutineScheduler::schedule(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    CoroutineContext& ctx = slot.context;
+    const YieldInstruction& yield = ctx.currentYield;
+
+    switch (yield.type) {
+        case YieldType::None:
+            completeCoroutine(index, CoroutineState::Completed);
+            return;
+        case YieldType::Frame:
+            wheelInsert(frameWheel, index, frameWheel.currentTick + 1, SlotQueue::FrameWheel);
+            break;
+        case YieldType::Frames:
+            wheelInsert(frameWheel, index,
+                        frameWheel.currentTick +
+                            static_cast<uint64_t>(std::max(yield.waitFrames, 1)),
+                        SlotQueue::FrameWheel);
+            break;
+        case YieldType::Seconds:
+            sleepFor(index, yield.waitSeconds);
+            break;
+        default:
+            pushBack(polling, index, SlotQueue::Polling);
+            break;
+    }
+    ctx.state = CoroutineState::Waiting;
+}
+
+// The wheel finds the tick a deadline falls in; the exact deadline is checked once that
+// tick has been reached, so coroutines wake neither early nor a frame late
+void CoroutineScheduler::sleepFor(uint32_t index, double seconds) {
+    CoroutineSlot& slot = slotAt(index);
+    slot.deadline = currentTime + std::max(seconds, 0.0);
+    const uint64_t tick = static_cast<uint64_t>(std::floor(slot.deadline / TIMER_RESOLUTION));
+    if (tick > timeWheel.currentTick) {
+        wheelInsert(timeWheel, index, tick, SlotQueue::TimeWheel);
+    } else {
+        pushBack(imminent, index, SlotQueue::Imminent);
+    }
+}
+
+bool CoroutineScheduler::checkYieldCondition(CoroutineContext& ctx) {
+    const YieldInstruction& yield = ctx.currentYield;
+    switch (yield.type) {
+        case YieldType::Condition:
+            return !yield.condition || yield.condition();
+        case YieldType::All:
+            for (uint64_t id : yield.waitingForCoroutines) {
+                if (!isCompleted(id)) return false;
+            }
+            return true;
+        case YieldType::Any:
+            for (uint64_t id : yield.waitingForCoroutines) {
+                if (isCompleted(id)) return true;
+            }
+            return yield.waitingForCoroutines.empty();
+        case YieldType::Custom: {
+            auto it = customYieldHandlers.find(yield.customYieldName);
+            return it == customYieldHandlers.end() || it->second(ctx);
+        }
+        default:
+            return true;
+    }
+}
+
+void CoroutineScheduler::completeCoroutine(uint32_t index, CoroutineState state) {
+    CoroutineSlot& slot = slotAt(index);
+    slot.context.state = state;
+    switch (state) {
+        case CoroutineState::Completed: {
+            stats.totalCompleted++;
+            const float lifetime = static_cast<float>(currentTime - slot.startTime);
+            stats.averageLifetime +=
+                (lifetime - stats.averageLifetime) / static_cast<float>(stats.totalCompleted);
+            break;
+        }
+        case CoroutineState::Error:
+            stats.totalErrors++;
+            break;
+        default:
+            stats.totalCancelled++;
+            break;
+    }
+
+    // A running coroutine still needs its function; processCoroutine() removes it
+    if (!slot.running) removeCoroutine(index);
+}
+
+// Returns the slot to the pool. Strings and vectors are cleared rather than freed, so the
+// next coroutine in the slot reuses their capacity
+void CoroutineScheduler::removeCoroutine(uint32_t index) {
+    CoroutineSlot& slot = slotAt(index);
+    unlink(index);
+
+    CoroutineContext& ctx = slot.context;
+    ctx.id = 0;
+    ctx.name.clear();
+    ctx.currentYield = YieldInstruction();
+    ctx.returnValue = ScriptValue();
+    ctx.errorMessage.clear();
+    ctx.parentCoroutine.reset();
+    ctx.childCoroutines.clear();
+    ctx.locals.clear();
+
+    slot.function = nullptr;
+    slot.generation++;
+    slot.paused = false;
+    slot.pausedQueue = SlotQueue::None;
+    freeSlots.push_back(index);
+
+    liveCount--;
+    stats.currentActive = liveCount;
+}
+
+// =============================================================================
+// Handlers and statistics
+// =============================================================================
+
+void CoroutineScheduler::registerYieldHandler(const std::string& name,
+                                              std::function<bool(CoroutineContext&)> handler) {
+    customYieldHandlers[name] = std::move(handler);
+}
+
+void CoroutineScheduler::unregisterYieldHandler(const std::string& name) {
+    customYieldHandlers.erase(name);
+}
+
+void CoroutineScheduler::resetStats() {
+    stats = CoroutineStats();
+    stats.currentActive = liveCount;
+    stats.sleeping = frameWheel.count + timeWheel.count + imminent.size;
+    stats.polling = polling.size;
+    stats.ready = ready.size + pending.size;
+    stats.pooledContexts = pool.size() * POOL_CHUNK;
+    stats.freeContexts = freeSlots.size();
+}
+
+} // namespace Scripting
+} // namespace JJM
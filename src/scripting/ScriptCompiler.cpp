@@ -0,0 +1,1115 @@
+#include "scripting/ScriptCompiler.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+namespace JJM {
+namespace Scripting {
+
+namespace {
+
+struct Keyword {
+    const char* text;
+    TokenType type;
+};
+
+const Keyword KEYWORDS[] = {
+    {"and", TokenType::AND},       {"break", TokenType::BREAK},
+    {"do", TokenType::DO},         {"else", TokenType::ELSE},
+    {"elseif", TokenType::ELSEIF}, {"end", TokenType::END},
+    {"false", TokenType::FALSE_KEYWORD}, {"for", TokenType::FOR},
+    {"function", TokenType::FUNCTION}, {"if", TokenType::IF},
+    {"local", TokenType::LOCAL},   {"nil", TokenType::NIL},
+    {"not", TokenType::NOT},       {"or", TokenType::OR},
+    {"return", TokenType::RETURN}, {"then", TokenType::THEN},
+    {"true", TokenType::TRUE_KEYWORD}, {"while", TokenType::WHILE}};
+
+const char* spelling(TokenType type) {
+    for (const Keyword& keyword : KEYWORDS) {
+        if (keyword.type == type) return keyword.text;
+    }
+    switch (type) {
+        case TokenType::PLUS: return "+";
+        case TokenType::MINUS: return "-";
+        case TokenType::STAR: return "*";
+        case TokenType::SLASH: return "/";
+        case TokenType::PERCENT: return "%";
+        case TokenType::HASH: return "#";
+        case TokenType::EQUAL: return "==";
+        case TokenType::NOT_EQUAL: return "~=";
+        case TokenType::LESS: return "<";
+        case TokenType::LESS_EQUAL: return "<=";
+        case TokenType::GREATER: return ">";
+        case TokenType::GREATER_EQUAL: return ">=";
+        case TokenType::ASSIGN: return "=";
+        case TokenType::LEFT_PAREN: return "(";
+        case TokenType::RIGHT_PAREN: return ")";
+        case TokenType::LEFT_BRACE: return "{";
+        case TokenType::RIGHT_BRACE: return "}";
+        case TokenType::LEFT_BRACKET: return "[";
+        case TokenType::RIGHT_BRACKET: return "]";
+        case TokenType::SEMICOLON: return ";";
+        case TokenType::COMMA: return ",";
+        case TokenType::DOT: return ".";
+        case TokenType::CONCAT: return "..";
+        case TokenType::NAME: return "name";
+        case TokenType::INTEGER:
+        case TokenType::NUMBER: return "number";
+        case TokenType::STRING: return "string";
+        case TokenType::END_OF_FILE: return "end of script";
+        default: return "token";
+    }
+}
+
+std::string describe(const Token& token) {
+    if (token.type == TokenType::NAME) return "'" + token.text + "'";
+    if (token.type == TokenType::END_OF_FILE) return "end of script";
+    return std::string("'") + spelling(token.type) + "'";
+}
+
+// Binary operator precedence; 0 for tokens that are not binary operators
+int precedence(TokenType type) {
+    switch (type) {
+        case TokenType::OR: return 1;
+        case TokenType::AND: return 2;
+        case TokenType::EQUAL:
+        case TokenType::NOT_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL: return 3;
+        case TokenType::CONCAT: return 4;
+        case TokenType::PLUS:
+        case TokenType::MINUS: return 5;
+        case TokenType::STAR:
+        case TokenType::SLASH:
+        case TokenType::PERCENT: return 6;
+        default: return 0;
+    }
+}
+
+const int UNARY_PRECEDENCE = 7;
+
+bool isComparison(TokenType type) { return precedence(type) == 3; }
+
+}  // namespace
+
+// Lexer implementation
+Lexer::Lexer(const std::string& source) : source(source), position(0), line(1) {}
+
+void Lexer::error(const std::string& message) const {
+    throw ScriptException("line " + std::to_string(line) + ": " + message);
+}
+
+void Lexer::skipWhitespaceAndComments() {
+    while (position < source.size()) {
+        char c = source[position];
+        if (c == '\n') {
+            line++;
+            position++;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            position++;
+        } else if (c == '-' && position + 1 < source.size() && source[position + 1] == '-') {
+            while (position < source.size() && source[position] != '\n') position++;
+        } else {
+            return;
+        }
+    }
+}
+
+Token Lexer::readNumber() {
+    size_t start = position;
+    bool integral = true;
+    while (position < source.size() && std::isdigit(static_cast<unsigned char>(source[position]))) {
+        position++;
+    }
+    if (position + 1 < source.size() && source[position] == '.' && source[position + 1] != '.') {
+        integral = false;
+        position++;
+        while (position < source.size() &&
+               std::isdigit(static_cast<unsigned char>(source[position]))) {
+            position++;
+        }
+    }
+    if (position < source.size() && (source[position] == 'e' || source[position] == 'E')) {
+        integral = false;
+        position++;
+        if (position < source.size() && (source[position] == '+' || source[position] == '-')) {
+            position++;
+        }
+        if (position >= source.size() ||
+            !std::isdigit(static_cast<unsigned char>(source[position]))) {
+            error("malformed number");
+        }
+        while (position < source.size() &&
+               std::isdigit(static_cast<unsigned char>(source[position]))) {
+            position++;
+        }
+    }
+    if (position < source.size() &&
+        (std::isalpha(static_cast<unsigned char>(source[position])) || source[position] == '_')) {
+        error("malformed number");
+    }
+
+    std::string text = source.substr(start, position - start);
+    Token token;
+    token.line = line;
+    token.number = std::strtod(text.c_str(), nullptr);
+    if (integral && token.number <= 2147483647.0) {
+        token.type = TokenType::INTEGER;
+        token.integer = static_cast<int32_t>(std::strtol(text.c_str(), nullptr, 10));
+    } else {
+        token.type = TokenType::NUMBER;
+    }
+    return token;
+}
+
+Token Lexer::readString(char quote) {
+    Token token;
+    token.type = TokenType::STRING;
+    token.line = line;
+    position++;
+    for (;;) {
+        if (position >= source.size() || source[position] == '\n') error("unfinished string");
+        char c = source[position++];
+        if (c == quote) break;
+        if (c == '\\') {
+            if (position >= source.size()) error("unfinished string");
+            char escaped = source[position++];
+            switch (escaped) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = '\0'; break;
+                case '\\':
+                case '"':
+                case '\'': c = escaped; break;
+                default: error(std::string("invalid escape '\\") + escaped + "'");
+            }
+        }
+        token.text.push_back(c);
+    }
+    return token;
+}
+
+Token Lexer::readName() {
+    size_t start = position;
+    while (position < source.size() &&
+           (std::isalnum(static_cast<unsigned char>(source[position])) ||
+            source[position] == '_')) {
+        position++;
+    }
+    Token token;
+    token.type = TokenType::NAME;
+    token.text = source.substr(start, position - start);
+    token.line = line;
+    for (const Keyword& keyword : KEYWORDS) {
+        if (token.text == keyword.text) token.type = keyword.type;
+    }
+    return token;
+}
+
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    for (;;) {
+        skipWhitespaceAndComments();
+        if (position >= source.size()) break;
+
+        char c = source[position];
+        char next = position + 1 < source.size() ? source[position + 1] : '\0';
+        if (std::isdigit(static_cast<unsigned char>(c)) ||
+            (c == '.' && std::isdigit(static_cast<unsigned char>(next)))) {
+            tokens.push_back(readNumber());
+            continue;
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            tokens.push_back(readName());
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            tokens.push_back(readString(c));
+            continue;
+        }
+
+        Token token;
+        token.line = line;
+        size_t length = 2;
+        if (c == '=' && next == '=') token.type = TokenType::EQUAL;
+        else if ((c == '~' || c == '!') && next == '=') token.type = TokenType::NOT_EQUAL;
+        else if (c == '<' && next == '=') token.type = TokenType::LESS_EQUAL;
+        else if (c == '>' && next == '=') token.type = TokenType::GREATER_EQUAL;
+        else if (c == '.' && next == '.') token.type = TokenType::CONCAT;
+        else {
+            length = 1;
+            switch (c) {
+                case '+': token.type = TokenType::PLUS; break;
+                case '-': token.type = TokenType::MINUS; break;
+                case '*': token.type = TokenType::STAR; break;
+                case '/': token.type = TokenType::SLASH; break;
+                case '%': token.type = TokenType::PERCENT; break;
+                case '#': token.type = TokenType::HASH; break;
+                case '<': token.type = TokenType::LESS; break;
+                case '>': token.type = TokenType::GREATER; break;
+                case '=': token.type = TokenType::ASSIGN; break;
+                case '(': token.type = TokenType::LEFT_PAREN; break;
+                case ')': token.type = TokenType::RIGHT_PAREN; break;
+                case '{': token.type = TokenType::LEFT_BRACE; break;
+                case '}': token.type = TokenType::RIGHT_BRACE; break;
+                case '[': token.type = TokenType::LEFT_BRACKET; break;
+                case ']': token.type = TokenType::RIGHT_BRACKET; break;
+                case ';': token.type = TokenType::SEMICOLON; break;
+                case ',': token.type = TokenType::COMMA; break;
+                case '.': token.type = TokenType::DOT; break;
+                default: error(std::string("unexpected character '") + c + "'");
+            }
+        }
+        position += length;
+        tokens.push_back(token);
+    }
+
+    Token end;
+    end.type = TokenType::END_OF_FILE;
+    end.line = line;
+    tokens.push_back(end);
+    return tokens;
+}
+
+// Parser implementation
+Parser::Parser(std::vector<Token> tokens) : tokens(std::move(tokens)), current(0) {}
+
+void Parser::error(const std::string& message) const {
+    throw ScriptException("line " + std::to_string(peek().line) + ": " + message + " near " +
+                          describe(peek()));
+}
+
+bool Parser::match(TokenType type) {
+    if (!check(type)) return false;
+    current++;
+    return true;
+}
+
+const Token& Parser::expect(TokenType type, const char* what) {
+    if (!check(type)) error(std::string(what) + " expected");
+    return tokens[current++];
+}
+
+bool Parser::blockEnds() const {
+    TokenType type = peek().type;
+    return type == TokenType::END || type == TokenType::ELSE || type == TokenType::ELSEIF ||
+           type == TokenType::END_OF_FILE;
+}
+
+std::unique_ptr<FunctionBody> Parser::parseChunk(const std::string& name) {
+    auto chunk = std::make_unique<FunctionBody>();
+    chunk->name = name;
+    chunk->body = block();
+    if (!check(TokenType::END_OF_FILE)) error("end of script expected");
+    return chunk;
+}
+
+Block Parser::block() {
+    Block statements;
+    while (!blockEnds()) {
+        if (match(TokenType::SEMICOLON)) continue;
+        bool isReturn = check(TokenType::RETURN);
+        statements.push_back(statement());
+        if (isReturn) {
+            match(TokenType::SEMICOLON);
+            if (!blockEnds()) error("'end' expected after return");
+        }
+    }
+    return statements;
+}
+
+std::unique_ptr<Statement> Parser::statement() {
+    const int line = peek().line;
+    switch (peek().type) {
+        case TokenType::IF:
+            return ifStatement();
+        case TokenType::WHILE: {
+            current++;
+            auto loop = std::make_unique<Statement>(Statement::Kind::WHILE, line);
+            loop->values.push_back(expression());
+            expect(TokenType::DO, "'do'");
+            loop->blocks.push_back(block());
+            expect(TokenType::END, "'end'");
+            return loop;
+        }
+        case TokenType::FOR:
+            return forStatement();
+        case TokenType::FUNCTION:
+            return functionStatement();
+        case TokenType::LOCAL:
+            return localStatement();
+        case TokenType::RETURN: {
+            current++;
+            auto result = std::make_unique<Statement>(Statement::Kind::RETURN, line);
+            if (!blockEnds() && !check(TokenType::SEMICOLON)) {
+                result->values.push_back(expression());
+            }
+            return result;
+        }
+        case TokenType::BREAK:
+            current++;
+            return std::make_unique<Statement>(Statement::Kind::BREAK, line);
+        case TokenType::DO: {
+            current++;
+            auto scope = std::make_unique<Statement>(Statement::Kind::DO, line);
+            scope->blocks.push_back(block());
+            expect(TokenType::END, "'end'");
+            return scope;
+        }
+        default:
+            return expressionStatement();
+    }
+}
+
+std::unique_ptr<Statement> Parser::ifStatement() {
+    auto branch = std::make_unique<Statement>(Statement::Kind::IF, peek().line);
+    do {
+        current++;  // 'if' or 'elseif'
+        branch->values.push_back(expression());
+        expect(TokenType::THEN, "'then'");
+        branch->blocks.push_back(block());
+    } while (check(TokenType::ELSEIF));
+    if (match(TokenType::ELSE)) {
+        branch->blocks.push_back(block());
+    }
+    expect(TokenType::END, "'end'");
+    return branch;
+}
+
+std::unique_ptr<Statement> Parser::forStatement() {
+    auto loop = std::make_unique<Statement>(Statement::Kind::NUMERIC_FOR, peek().line);
+    current++;
+    loop->names.push_back(expect(TokenType::NAME, "variable name").text);
+    if (!check(TokenType::ASSIGN)) error("'=' expected (only numeric for loops are supported)");
+    current++;
+    loop->values.push_back(expression());
+    expect(TokenType::COMMA, "','");
+    loop->values.push_back(expression());
+    if (match(TokenType::COMMA)) {
+        loop->values.push_back(expression());
+    }
+    expect(TokenType::DO, "'do'");
+    loop->blocks.push_back(block());
+    expect(TokenType::END, "'end'");
+    return loop;
+}
+
+std::unique_ptr<Statement> Parser::functionStatement() {
+    const int line = peek().line;
+    current++;
+    const Token& first = expect(TokenType::NAME, "function name");
+    std::string name = first.text;
+    auto target = std::make_unique<Expression>(Expression::Kind::NAME, line);
+    target->text = first.text;
+    while (match(TokenType::DOT)) {
+        const Token& field = expect(TokenType::NAME, "field name");
+        auto key = std::make_unique<Expression>(Expression::Kind::STRING, field.line);
+        key->text = field.text;
+        auto index = std::make_unique<Expression>(Expression::Kind::INDEX, field.line);
+        index->left = std::move(target);
+        index->right = std::move(key);
+        target = std::move(index);
+        name += "." + field.text;
+    }
+
+    auto value = std::make_unique<Expression>(Expression::Kind::FUNCTION, line);
+    value->function = functionBody(name, line);
+    auto assignment = std::make_unique<Statement>(Statement::Kind::ASSIGN, line);
+    assignment->targets.push_back(std::move(target));
+    assignment->values.push_back(std::move(value));
+    return assignment;
+}
+
+std::unique_ptr<Statement> Parser::localStatement() {
+    const int line = peek().line;
+    current++;
+    if (match(TokenType::FUNCTION)) {
+        auto local = std::make_unique<Statement>(Statement::Kind::LOCAL_FUNCTION, line);
+        local->names.push_back(expect(TokenType::NAME, "function name").text);
+        auto value = std::make_unique<Expression>(Expression::Kind::FUNCTION, line);
+        value->function = functionBody(local->names[0], line);
+        local->values.push_back(std::move(value));
+        return local;
+    }
+
+    auto local = std::make_unique<Statement>(Statement::Kind::LOCAL, line);
+    do {
+        local->names.push_back(expect(TokenType::NAME, "variable name").text);
+    } while (match(TokenType::COMMA));
+    if (match(TokenType::ASSIGN)) {
+        do {
+            local->values.push_back(expression());
+        } while (match(TokenType::COMMA));
+    }
+    return local;
+}
+
+std::unique_ptr<Statement> Parser::expressionStatement() {
+    const int line = peek().line;
+    std::unique_ptr<Expression> first = suffixed();
+    if (!check(TokenType::ASSIGN) && !check(TokenType::COMMA)) {
+        if (first->kind != Expression::Kind::CALL) error("syntax error");
+        auto call = std::make_unique<Statement>(Statement::Kind::CALL, line);
+        call->values.push_back(std::move(first));
+        return call;
+    }
+
+    auto assignment = std::make_unique<Statement>(Statement::Kind::ASSIGN, line);
+    assignment->targets.push_back(std::move(first));
+    while (match(TokenType::COMMA)) {
+        assignment->targets.push_back(suffixed());
+    }
+    for (const auto& target : assignment->targets) {
+        if (target->kind != Expression::Kind::NAME && target->kind != Expression::Kind::INDEX) {
+            error("cannot assign to this expression");
+        }
+    }
+    expect(TokenType::ASSIGN, "'='");
+    do {
+        assignment->values.push_back(expression());
+    } while (match(TokenType::COMMA));
+    return assignment;
+}
+
+std::unique_ptr<FunctionBody> Parser::functionBody(const std::string& name, int line) {
+    auto body = std::make_unique<FunctionBody>();
+    body->name = name;
+    body->line = line;
+    expect(TokenType::LEFT_PAREN, "'('");
+    if (!check(TokenType::RIGHT_PAREN)) {
+        do {
+            body->parameters.push_back(expect(TokenType::NAME, "parameter name").text);
+        } while (match(TokenType::COMMA));
+    }
+    expect(TokenType::RIGHT_PAREN, "')'");
+    body->body = block();
+    expect(TokenType::END, "'end'");
+    return body;
+}
+
+// Precedence climbing; '..' is right associative
+std::unique_ptr<Expression> Parser::expression(int minPrecedence) {
+    std::unique_ptr<Expression> left = unary();
+    for (;;) {
+        TokenType op = peek().type;
+        int opPrecedence = precedence(op);
+        if (opPrecedence <= minPrecedence) return left;
+        const int line = peek().line;
+        current++;
+        std::unique_ptr<Expression> right =
+            expression(op == TokenType::CONCAT ? opPrecedence - 1 : opPrecedence);
+
+        Expression::Kind kind = op == TokenType::AND  ? Expression::Kind::AND
+                                : op == TokenType::OR ? Expression::Kind::OR
+                                                      : Expression::Kind::BINARY;
+        auto binary = std::make_unique<Expression>(kind, line);
+        binary->op = op;
+        binary->left = std::move(left);
+        binary->right = std::move(right);
+        left = std::move(binary);
+    }
+}
+
+std::unique_ptr<Expression> Parser::unary() {
+    TokenType op = peek().type;
+    if (op != TokenType::NOT && op != TokenType::MINUS && op != TokenType::HASH) {
+        return suffixed();
+    }
+    const int line = peek().line;
+    current++;
+    std::unique_ptr<Expression> operand = expression(UNARY_PRECEDENCE - 1);
+
+    // Negative literals are constants
+    if (op == TokenType::MINUS && operand->kind == Expression::Kind::INTEGER &&
+        operand->integer != INT32_MIN) {
+        operand->integer = -operand->integer;
+        operand->number = -operand->number;
+        return operand;
+    }
+    if (op == TokenType::MINUS && operand->kind == Expression::Kind::NUMBER) {
+        operand->number = -operand->number;
+        return operand;
+    }
+    auto result = std::make_unique<Expression>(Expression::Kind::UNARY, line);
+    result->op = op;
+    result->left = std::move(operand);
+    return result;
+}
+
+std::unique_ptr<Expression> Parser::suffixed() {
+    std::unique_ptr<Expression> e = primary();
+    for (;;) {
+        const int line = peek().line;
+        if (match(TokenType::DOT)) {
+            const Token& field = expect(TokenType::NAME, "field name");
+            auto key = std::make_unique<Expression>(Expression::Kind::STRING, field.line);
+            key->text = field.text;
+            auto index = std::make_unique<Expression>(Expression::Kind::INDEX, line);
+            index->left = std::move(e);
+            index->right = std::move(key);
+            e = std::move(index);
+        } else if (match(TokenType::LEFT_BRACKET)) {
+            auto index = std::make_unique<Expression>(Expression::Kind::INDEX, line);
+            index->left = std::move(e);
+            index->right = expression();
+            expect(TokenType::RIGHT_BRACKET, "']'");
+            e = std::move(index);
+        } else if (match(TokenType::LEFT_PAREN)) {
+            auto call = std::make_unique<Expression>(Expression::Kind::CALL, line);
+            call->left = std::move(e);
+            if (!check(TokenType::RIGHT_PAREN)) {
+                do {
+                    call->arguments.push_back(expression());
+                } while (match(TokenType::COMMA));
+            }
+            expect(TokenType::RIGHT_PAREN, "')'");
+            e = std::move(call);
+        } else {
+            return e;
+        }
+    }
+}
+
+std::unique_ptr<Expression> Parser::primary() {
+    const Token& token = peek();
+    const int line = token.line;
+    std::unique_ptr<Expression> e;
+    switch (token.type) {
+        case TokenType::NAME:
+            e = std::make_unique<Expression>(Expression::Kind::NAME, line);
+            e->text = token.text;
+            break;
+        case TokenType::INTEGER:
+            e = std::make_unique<Expression>(Expression::Kind::INTEGER, line);
+            e->integer = token.integer;
+            e->number = token.number;
+            break;
+        case TokenType::NUMBER:
+            e = std::make_unique<Expression>(Expression::Kind::NUMBER, line);
+            e->number = token.number;
+            break;
+        case TokenType::STRING:
+            e = std::make_unique<Expression>(Expression::Kind::STRING, line);
+            e->text = token.text;
+            break;
+        case TokenType::NIL:
+            e = std::make_unique<Expression>(Expression::Kind::NIL, line);
+            break;
+        case TokenType::TRUE_KEYWORD:
+            e = std::make_unique<Expression>(Expression::Kind::TRUE_VALUE, line);
+            break;
+        case TokenType::FALSE_KEYWORD:
+            e = std::make_unique<Expression>(Expression::Kind::FALSE_VALUE, line);
+            break;
+        case TokenType::FUNCTION:
+            current++;
+            e = std::make_unique<Expression>(Expression::Kind::FUNCTION, line);
+            e->function = functionBody("anonymous", line);
+            return e;
+        case TokenType::LEFT_BRACE:
+            return table();
+        case TokenType::LEFT_PAREN:
+            current++;
+            e = expression();
+            expect(TokenType::RIGHT_PAREN, "')'");
+            return e;
+        default:
+            error("unexpected symbol");
+    }
+    current++;
+    return e;
+}
+
+std::unique_ptr<Expression> Parser::table() {
+    auto result = std::make_unique<Expression>(Expression::Kind::TABLE, peek().line);
+    current++;
+    while (!check(TokenType::RIGHT_BRACE)) {
+        if (check(TokenType::NAME) && tokens[current + 1].type == TokenType::ASSIGN) {
+            auto key = std::make_unique<Expression>(Expression::Kind::STRING, peek().line);
+            key->text = peek().text;
+            current += 2;
+            result->fields.emplace_back(std::move(key), expression());
+        } else if (match(TokenType::LEFT_BRACKET)) {
+            std::unique_ptr<Expression> key = expression();
+            expect(TokenType::RIGHT_BRACKET, "']'");
+            expect(TokenType::ASSIGN, "'='");
+            result->fields.emplace_back(std::move(key), expression());
+        } else {
+            result->arguments.push_back(expression());
+        }
+        if (!match(TokenType::COMMA) && !match(TokenType::SEMICOLON)) break;
+    }
+    expect(TokenType::RIGHT_BRACE, "'}'");
+    return result;
+}
+
+// Compiler implementation
+Compiler::Compiler(VirtualMachine& vm) : vm(vm), state(nullptr) {}
+
+void Compiler::error(int line, const std::string& message) const {
+    throw ScriptException("line " + std::to_string(line) + ": " + message);
+}
+
+size_t Compiler::emit(OpCode op, int a, int b, int c, int line) {
+    FunctionPrototype& prototype = *state->prototype;
+    prototype.code.push_back(Instruction{op, static_cast<uint8_t>(a), static_cast<uint16_t>(b),
+                                         static_cast<uint16_t>(c)});
+    prototype.lines.push_back(static_cast<uint32_t>(line));
+    return prototype.code.size() - 1;
+}
+
+size_t Compiler::emitJump(int line) {
+    return emit(OpCode::JMP, 0, 0, 0, line);
+}
+
+void Compiler::patchJump(size_t jump, size_t target) {
+    long offset = static_cast<long>(target) - static_cast<long>(jump + 1);
+    if (offset < INT16_MIN || offset > INT16_MAX) {
+        error(static_cast<int>(state->prototype->lines[jump]), "control structure too long");
+    }
+    state->prototype->code[jump].b = static_cast<uint16_t>(static_cast<int16_t>(offset));
+}
+
+uint16_t Compiler::constant(VMValue value, int line) {
+    auto it = state->constantIndex.find(value.bits);
+    if (it != state->constantIndex.end()) return it->second;
+    std::vector<VMValue>& constants = state->prototype->constants;
+    if (constants.size() >= 0xFFFF - RK_CONSTANT) error(line, "too many constants in function");
+    constants.push_back(value);
+    uint16_t index = static_cast<uint16_t>(constants.size() - 1);
+    state->constantIndex[value.bits] = index;
+    return index;
+}
+
+int Compiler::global(const std::string& name, int line) {
+    uint32_t slot = vm.resolveGlobal(name);
+    if (slot > 0xFFFF) error(line, "too many globals");
+    return static_cast<int>(slot);
+}
+
+int Compiler::allocate(int line) {
+    if (state->freeRegister >= MAX_REGISTERS) {
+        error(line, "function or expression needs too many registers");
+    }
+    int reg = state->freeRegister++;
+    if (state->freeRegister > state->maxRegisters) state->maxRegisters = state->freeRegister;
+    return reg;
+}
+
+uint32_t Compiler::compile(const FunctionBody& function) {
+    state = nullptr;
+    return this->function(function);
+}
+
+uint32_t Compiler::function(const FunctionBody& body) {
+    FunctionState function;
+    function.enclosing = state;
+    function.prototype = std::make_unique<FunctionPrototype>();
+    function.prototype->name = body.name;
+    if (body.parameters.size() > MAX_REGISTERS) error(body.line, "too many parameters");
+    function.prototype->parameterCount = static_cast<uint8_t>(body.parameters.size());
+    state = &function;
+
+    for (const std::string& parameter : body.parameters) {
+        function.locals.push_back(LocalVariable{parameter, allocate(body.line)});
+    }
+    function.localTop = function.freeRegister;
+    block(body.body);
+    emit(OpCode::RETURN, 0, 0, 0, body.line);
+
+    function.prototype->registerCount = static_cast<uint8_t>(function.maxRegisters);
+    state = function.enclosing;
+    return vm.addPrototype(std::move(function.prototype));
+}
+
+int Compiler::findLocal(const std::string& name, int line) const {
+    for (auto it = state->locals.rbegin(); it != state->locals.rend(); ++it) {
+        if (it->name == name) return it->reg;
+    }
+    for (FunctionState* outer = state->enclosing; outer; outer = outer->enclosing) {
+        for (const LocalVariable& local : outer->locals) {
+            if (local.name == name) {
+                error(line, "cannot use local '" + name +
+                                "' of an enclosing function; make it a global or pass it in");
+            }
+        }
+    }
+    return -1;
+}
+
+// Statements
+void Compiler::block(const Block& statements) {
+    const size_t localCount = state->locals.size();
+    const int localTop = state->localTop;
+    for (const auto& s : statements) {
+        statement(*s);
+        state->freeRegister = state->localTop;  // Temporaries end with their statement
+    }
+    state->locals.resize(localCount);
+    state->localTop = state->freeRegister = localTop;
+}
+
+void Compiler::statement(const Statement& s) {
+    switch (s.kind) {
+        case Statement::Kind::CALL: {
+            int reg = allocate(s.line);
+            call(*s.values[0], reg);
+            break;
+        }
+        case Statement::Kind::LOCAL:
+            localStatement(s);
+            break;
+        case Statement::Kind::ASSIGN:
+            assignStatement(s);
+            break;
+        case Statement::Kind::IF:
+            ifStatement(s);
+            break;
+        case Statement::Kind::WHILE:
+            whileStatement(s);
+            break;
+        case Statement::Kind::NUMERIC_FOR:
+            forStatement(s);
+            break;
+        case Statement::Kind::RETURN:
+            if (s.values.empty()) {
+                emit(OpCode::RETURN, 0, 0, 0, s.line);
+            } else {
+                emit(OpCode::RETURN, anyRegister(*s.values[0]), 1, 0, s.line);
+            }
+            break;
+        case Statement::Kind::BREAK:
+            if (state->breakJumps.empty()) error(s.line, "'break' outside a loop");
+            state->breakJumps.back()->push_back(emitJump(s.line));
+            break;
+        case Statement::Kind::DO:
+            block(s.blocks[0]);
+            break;
+        case Statement::Kind::LOCAL_FUNCTION: {
+            int reg = allocate(s.line);
+            state->locals.push_back(LocalVariable{s.names[0], reg});
+            state->localTop = state->freeRegister;
+            expression(*s.values[0], reg);
+            break;
+        }
+    }
+}
+
+// Values go straight into the new locals' registers, which are named only afterwards so
+// "local x = x" reads the outer x
+void Compiler::localStatement(const Statement& s) {
+    const int first = state->freeRegister;
+    for (size_t i = 0; i < s.names.size(); ++i) {
+        int reg = allocate(s.line);
+        if (i < s.values.size()) {
+            expression(*s.values[i], reg);
+        } else {
+            emit(OpCode::LOADNIL, reg, 0, 0, s.line);
+        }
+    }
+    for (size_t i = s.names.size(); i < s.values.size(); ++i) {
+        expression(*s.values[i], allocate(s.line));
+    }
+    state->freeRegister = first + static_cast<int>(s.names.size());
+    for (size_t i = 0; i < s.names.size(); ++i) {
+        state->locals.push_back(LocalVariable{s.names[i], first + static_cast<int>(i)});
+    }
+    state->localTop = state->freeRegister;
+}
+
+void Compiler::assignStatement(const Statement& s) {
+    if (s.targets.size() == 1 && s.values.size() == 1) {
+        const Expression& target = *s.targets[0];
+        if (target.kind == Expression::Kind::NAME) {
+            int local = findLocal(target.text, target.line);
+            if (local >= 0) {
+                expression(*s.values[0], local);
+                return;
+            }
+        }
+        assign(target, anyRegister(*s.values[0]));
+        return;
+    }
+
+    // Every value is evaluated before anything is assigned
+    const int first = state->freeRegister;
+    for (size_t i = 0; i < s.values.size(); ++i) {
+        expression(*s.values[i], allocate(s.line));
+    }
+    for (size_t i = s.values.size(); i < s.targets.size(); ++i) {
+        emit(OpCode::LOADNIL, allocate(s.line), 0, 0, s.line);
+    }
+    for (size_t i = 0; i < s.targets.size(); ++i) {
+        assign(*s.targets[i], first + static_cast<int>(i));
+    }
+}
+
+void Compiler::assign(const Expression& target, int source) {
+    if (target.kind == Expression::Kind::NAME) {
+        int local = findLocal(target.text, target.line);
+        if (local >= 0) {
+            if (local != source) emit(OpCode::MOVE, local, source, 0, target.line);
+        } else {
+            emit(OpCode::SETGLOBAL, source, global(target.text, target.line), 0, target.line);
+        }
+        return;
+    }
+    const int saved = state->freeRegister;
+    int object = anyRegister(*target.left);
+    int key = operand(*target.right);
+    emit(OpCode::SETTABLE, object, key, source, target.line);
+    state->freeRegister = saved;
+}
+
+void Compiler::ifStatement(const Statement& s) {
+    std::vector<size_t> endJumps;
+    for (size_t i = 0; i < s.values.size(); ++i) {
+        std::vector<size_t> falseJumps;
+        condition(*s.values[i], falseJumps);
+        block(s.blocks[i]);
+        if (i + 1 < s.blocks.size()) endJumps.push_back(emitJump(s.line));
+        for (size_t jump : falseJumps) patchJump(jump, here());
+    }
+    if (s.blocks.size() > s.values.size()) {
+        block(s.blocks.back());
+    }
+    for (size_t jump : endJumps) patchJump(jump, here());
+}
+
+void Compiler::whileStatement(const Statement& s) {
+    const size_t start = here();
+    std::vector<size_t> exitJumps;
+    condition(*s.values[0], exitJumps);
+    state->breakJumps.push_back(&exitJumps);
+    block(s.blocks[0]);
+    state->breakJumps.pop_back();
+    patchJump(emitJump(s.line), start);
+    for (size_t jump : exitJumps) patchJump(jump, here());
+}
+
+// Four registers: index, limit, step, and the visible loop variable
+void Compiler::forStatement(const Statement& s) {
+    const int base = allocate(s.line);
+    allocate(s.line);
+    allocate(s.line);
+    allocate(s.line);
+    expression(*s.values[0], base);
+    expression(*s.values[1], base + 1);
+    if (s.values.size() > 2) {
+        expression(*s.values[2], base + 2);
+    } else {
+        emit(OpCode::LOADK, base + 2, constant(VMValue::integer(1), s.line), 0, s.line);
+    }
+
+    const size_t prepare = emit(OpCode::FORPREP, base, 0, 0, s.line);
+    const size_t localCount = state->locals.size();
+    state->locals.push_back(LocalVariable{"(for index)", base});
+    state->locals.push_back(LocalVariable{"(for limit)", base + 1});
+    state->locals.push_back(LocalVariable{"(for step)", base + 2});
+    state->locals.push_back(LocalVariable{s.names[0], base + 3});
+    state->localTop = state->freeRegister;
+
+    std::vector<size_t> breakJumps;
+    state->breakJumps.push_back(&breakJumps);
+    block(s.blocks[0]);
+    state->breakJumps.pop_back();
+
+    const size_t loop = emit(OpCode::FORLOOP, base, 0, 0, s.line);
+    patchJump(loop, prepare + 1);
+    patchJump(prepare, loop + 1);
+    for (size_t jump : breakJumps) patchJump(jump, here());
+    state->locals.resize(localCount);
+    state->localTop = state->freeRegister = base;
+}
+
+// Expressions
+void Compiler::expression(const Expression& e, int target) {
+    const int saved = state->freeRegister;
+    switch (e.kind) {
+        case Expression::Kind::NIL:
+            emit(OpCode::LOADNIL, target, 0, 0, e.line);
+            break;
+        case Expression::Kind::TRUE_VALUE:
+        case Expression::Kind::FALSE_VALUE:
+            emit(OpCode::LOADBOOL, target, e.kind == Expression::Kind::TRUE_VALUE, 0, e.line);
+            break;
+        case Expression::Kind::INTEGER:
+        case Expression::Kind::NUMBER:
+        case Expression::Kind::STRING:
+        case Expression::Kind::FUNCTION:
+            emit(OpCode::LOADK, target, operand(e) - RK_CONSTANT, 0, e.line);
+            break;
+        case Expression::Kind::NAME: {
+            int local = findLocal(e.text, e.line);
+            if (local < 0) {
+                emit(OpCode::GETGLOBAL, target, global(e.text, e.line), 0, e.line);
+            } else if (local != target) {
+                emit(OpCode::MOVE, target, local, 0, e.line);
+            }
+            break;
+        }
+        case Expression::Kind::INDEX: {
+            int object = anyRegister(*e.left);
+            int key = operand(*e.right);
+            emit(OpCode::GETTABLE, target, object, key, e.line);
+            break;
+        }
+        case Expression::Kind::CALL:
+            call(e, target);
+            break;
+        case Expression::Kind::TABLE:
+        case Expression::Kind::AND:
+        case Expression::Kind::OR: {
+            // These write the target before they are done reading their operands, so a named
+            // local is only assigned at the end
+            const int reg = target < state->localTop ? allocate(e.line) : target;
+            if (e.kind == Expression::Kind::TABLE) {
+                emit(OpCode::NEWTABLE, reg, 0, 0, e.line);
+                for (size_t i = 0; i < e.arguments.size(); ++i) {
+                    const int itemSaved = state->freeRegister;
+                    int key = constant(VMValue::integer(static_cast<int32_t>(i + 1)), e.line);
+                    int value = operand(*e.arguments[i]);
+                    emit(OpCode::SETTABLE, reg, key + RK_CONSTANT, value, e.line);
+                    state->freeRegister = itemSaved;
+                }
+                for (const auto& field : e.fields) {
+                    const int fieldSaved = state->freeRegister;
+                    int key = operand(*field.first);
+                    int value = operand(*field.second);
+                    emit(OpCode::SETTABLE, reg, key, value, e.line);
+                    state->freeRegister = fieldSaved;
+                }
+            } else {
+                expression(*e.left, reg);
+                emit(OpCode::TEST, reg, 0, e.kind == Expression::Kind::OR, e.line);
+                size_t jump = emitJump(e.line);
+                expression(*e.right, reg);
+                patchJump(jump, here());
+            }
+            if (reg != target) emit(OpCode::MOVE, target, reg, 0, e.line);
+            break;
+        }
+        case Expression::Kind::BINARY: {
+            if (isComparison(e.op)) {
+                // if (comparison) != 1 skip the jump to the true load
+                comparison(e, 1, e.line);
+                emit(OpCode::JMP, 0, 1, 0, e.line);
+                emit(OpCode::LOADBOOL, target, 0, 1, e.line);
+                emit(OpCode::LOADBOOL, target, 1, 0, e.line);
+                break;
+            }
+            int b = operand(*e.left);
+            int c = operand(*e.right);
+            OpCode op = OpCode::ADD;
+            switch (e.op) {
+                case TokenType::PLUS: op = OpCode::ADD; break;
+                case TokenType::MINUS: op = OpCode::SUB; break;
+                case TokenType::STAR: op = OpCode::MUL; break;
+                case TokenType::SLASH: op = OpCode::DIV; break;
+                case TokenType::PERCENT: op = OpCode::MOD; break;
+                case TokenType::CONCAT: op = OpCode::CONCAT; break;
+                default: error(e.line, "unknown operator");
+            }
+            emit(op, target, b, c, e.line);
+            break;
+        }
+        case Expression::Kind::UNARY: {
+            int b = anyRegister(*e.left);
+            OpCode op = e.op == TokenType::MINUS ? OpCode::UNM
+                        : e.op == TokenType::NOT ? OpCode::NOT
+                                                 : OpCode::LEN;
+            emit(op, target, b, 0, e.line);
+            break;
+        }
+    }
+    state->freeRegister = saved;
+}
+
+// Emits the comparison of a binary expression; the next instruction runs when its result
+// equals expected
+void Compiler::comparison(const Expression& e, int expected, int line) {
+    int b = operand(*e.left);
+    int c = operand(*e.right);
+    switch (e.op) {
+        case TokenType::EQUAL: emit(OpCode::EQ, expected, b, c, line); break;
+        case TokenType::NOT_EQUAL: emit(OpCode::EQ, !expected, b, c, line); break;
+        case TokenType::LESS: emit(OpCode::LT, expected, b, c, line); break;
+        case TokenType::LESS_EQUAL: emit(OpCode::LE, expected, b, c, line); break;
+        case TokenType::GREATER: emit(OpCode::LT, expected, c, b, line); break;
+        case TokenType::GREATER_EQUAL: emit(OpCode::LE, expected, c, b, line); break;
+        default: error(line, "unknown comparison");
+    }
+}
+
+// Falls through when e is truthy; the returned jumps are taken when it is not
+void Compiler::condition(const Expression& e, std::vector<size_t>& falseJumps) {
+    const int saved = state->freeRegister;
+    if (e.kind == Expression::Kind::BINARY && isComparison(e.op)) {
+        comparison(e, 0, e.line);
+        falseJumps.push_back(emitJump(e.line));
+    } else if (e.kind == Expression::Kind::AND) {
+        condition(*e.left, falseJumps);
+        condition(*e.right, falseJumps);
+    } else if (e.kind == Expression::Kind::TRUE_VALUE) {
+        // Always taken
+    } else {
+        emit(OpCode::TEST, anyRegister(e), 0, 0, e.line);
+        falseJumps.push_back(emitJump(e.line));
+    }
+    state->freeRegister = saved;
+}
+
+// Arguments go in the registers after the callee, where the callee's frame will start
+void Compiler::call(const Expression& e, int target) {
+    const int saved = state->freeRegister;
+    const bool targetOnTop = target >= state->localTop && target + 1 == state->freeRegister;
+    const int base = targetOnTop ? target : allocate(e.line);
+    expression(*e.left, base);
+    for (const auto& argument : e.arguments) {
+        expression(*argument, allocate(argument->line));
+    }
+    emit(OpCode::CALL, base, static_cast<int>(e.arguments.size()), 0, e.line);
+    if (base != target) emit(OpCode::MOVE, target, base, 0, e.line);
+    state->freeRegister = saved;
+}
+
+// A register or constant operand; may leave a temporary allocated
+int Compiler::operand(const Expression& e) {
+    switch (e.kind) {
+        case Expression::Kind::INTEGER:
+            return RK_CONSTANT + constant(VMValue::integer(e.integer), e.line);
+        case Expression::Kind::NUMBER:
+            return RK_CONSTANT + constant(VMValue::number(e.number), e.line);
+        case Expression::Kind::STRING:
+            return RK_CONSTANT + constant(VMValue::string(vm.intern(e.text)), e.line);
+        case Expression::Kind::FUNCTION:
+            return RK_CONSTANT + constant(VMValue::function(function(*e.function)), e.line);
+        default:
+            return anyRegister(e);
+    }
+}
+
+// A local's own register, or a temporary holding the value
+int Compiler::anyRegister(const Expression& e) {
+    if (e.kind == Expression::Kind::NAME) {
+        int local = findLocal(e.text, e.line);
+        if (local >= 0) return local;
+    }
+    int reg = allocate(e.line);
+    expression(e, reg);
+    return reg;
+}
+
+uint32_t compileScript(VirtualMachine& vm, const std::string& source, const std::string& name) {
+    Lexer lexer(source);
+    Parser parser(lexer.tokenize());
+    std::unique_ptr<FunctionBody> chunk = parser.parseChunk(name);
+    Compiler compiler(vm);
+    return compiler.compile(*chunk);
+}
+
+} // namespace Scripting
+} // namespace JJM
@@ -0,0 +1,775 @@
+#include "scripting/ScriptVM.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace JJM {
+namespace Scripting {
+
+namespace {
+
+const size_t STACK_SIZE = 1 << 16;
+const size_t MAX_CALL_DEPTH = 200;
+const size_t MAX_CONVERSION_DEPTH = 32;
+
+// Integral floats index the same entries as integers
+VMValue normalizeKey(VMValue key) {
+    if (key.isDouble()) {
+        double d = key.asDouble();
+        if (d >= -2147483648.0 && d <= 2147483647.0 && d == std::floor(d)) {
+            return VMValue::integer(static_cast<int32_t>(d));
+        }
+    }
+    return key;
+}
+
+size_t hashKey(VMValue key) {
+    uint64_t h = key.bits * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 32));
+}
+
+inline VMValue rk(const VMValue* base, const VMValue* k, uint16_t operand) {
+    return operand < RK_CONSTANT ? base[operand] : k[operand - RK_CONSTANT];
+}
+
+// Numbers compare by value whatever their representation; everything else by identity
+inline bool valuesEqual(VMValue a, VMValue b) {
+    if (a == b) return true;
+    if (a.isNumber() && b.isNumber()) return a.toDouble() == b.toDouble();
+    return false;
+}
+
+}  // namespace
+
+// VMTable implementation
+const VMTable::Entry* VMTable::find(VMValue key) const {
+    if (entries.empty()) return nullptr;
+    size_t mask = entries.size() - 1;
+    for (size_t i = hashKey(key) & mask;; i = (i + 1) & mask) {
+        const Entry& entry = entries[i];
+        if (entry.key == key) return &entry;
+        if (entry.key.isNil()) return nullptr;
+    }
+}
+
+VMValue VMTable::get(VMValue key) const {
+    key = normalizeKey(key);
+    if (key.isInt()) {
+        uint32_t index = static_cast<uint32_t>(key.asInt()) - 1u;
+        if (index < array.size()) return array[index];
+    }
+    const Entry* entry = find(key);
+    return entry ? entry->value : VMValue();
+}
+
+void VMTable::grow() {
+    std::vector<Entry> old;
+    old.swap(entries);
+    entries.resize(old.empty() ? 8 : old.size() * 2);
+    used = 0;
+    for (const Entry& entry : old) {
+        if (!entry.value.isNil()) insert(entry.key, entry.value);
+    }
+}
+
+void VMTable::insert(VMValue key, VMValue value) {
+    if ((used + 1) * 4 > entries.size() * 3) grow();
+    size_t mask = entries.size() - 1;
+    for (size_t i = hashKey(key) & mask;; i = (i + 1) & mask) {
+        Entry& entry = entries[i];
+        if (entry.key.isNil()) {
+            entry.key = key;
+            entry.value = value;
+            used++;
+            return;
+        }
+        if (entry.key == key) {
+            entry.value = value;
+            return;
+        }
+    }
+}
+
+void VMTable::set(VMValue key, VMValue value) {
+    key = normalizeKey(key);
+    if (key.isInt()) {
+        uint32_t index = static_cast<uint32_t>(key.asInt()) - 1u;
+        if (index < array.size()) {
+            array[index] = value;
+            while (!array.empty() && array.back().isNil()) array.pop_back();
+            return;
+        }
+        if (index == array.size() && !value.isNil()) {
+            // Appending may join keys already in the hash part onto the array
+            array.push_back(value);
+            if (const Entry* entry = find(key)) const_cast<Entry*>(entry)->value = VMValue();
+            for (;;) {
+                Entry* next = const_cast<Entry*>(
+                    find(VMValue::integer(static_cast<int32_t>(array.size() + 1))));
+                if (!next || next->value.isNil()) break;
+                array.push_back(next->value);
+                next->value = VMValue();
+            }
+            return;
+        }
+    }
+    Entry* entry = const_cast<Entry*>(find(key));
+    if (entry) {
+        entry->value = value;
+    } else if (!value.isNil()) {
+        insert(key, value);
+    }
+}
+
+// VirtualMachine implementation
+VirtualMachine::VirtualMachine() : stack(STACK_SIZE) {
+    frames.reserve(MAX_CALL_DEPTH + 1);
+}
+
+VirtualMachine::~VirtualMachine() {
+    while (objects) {
+        VMObject* next = objects->next;
+        delete objects;
+        objects = next;
+    }
+}
+
+uint32_t VirtualMachine::resolveGlobal(const std::string& name) {
+    auto it = globalSlots.find(name);
+    if (it != globalSlots.end()) return it->second;
+    uint32_t slot = static_cast<uint32_t>(globals.size());
+    globals.emplace_back();
+    globalNames.push_back(name);
+    globalSlots[name] = slot;
+    return slot;
+}
+
+int VirtualMachine::findGlobal(const std::string& name) const {
+    auto it = globalSlots.find(name);
+    return it != globalSlots.end() ? static_cast<int>(it->second) : -1;
+}
+
+uint32_t VirtualMachine::addNative(const std::string& name, ScriptFunction function) {
+    return addNativeEntry(
+        NativeEntry{name, std::make_shared<ScriptFunction>(std::move(function)), nullptr, nullptr});
+}
+
+uint32_t VirtualMachine::addNative(const std::string& name, NativeThunk thunk, void* context) {
+    return addNativeEntry(NativeEntry{name, nullptr, thunk, context});
+}
+
+uint32_t VirtualMachine::addNativeEntry(NativeEntry entry) {
+    if (entry.collectable) hostFunctionCount++;
+    if (!freeNatives.empty()) {
+        uint32_t index = freeNatives.back();
+        freeNatives.pop_back();
+        natives[index] = std::move(entry);
+        return index;
+    }
+    natives.push_back(std::move(entry));
+    return static_cast<uint32_t>(natives.size() - 1);
+}
+
+const ScriptFunction& VirtualMachine::getNative(uint32_t index) const {
+    static const ScriptFunction none;
+    return natives[index].function ? *natives[index].function : none;
+}
+
+uint32_t VirtualMachine::addPrototype(std::unique_ptr<FunctionPrototype> prototype) {
+    if (!freePrototypes.empty()) {
+        uint32_t index = freePrototypes.back();
+        freePrototypes.pop_back();
+        prototypes[index] = std::move(prototype);
+        return index;
+    }
+    prototypes.push_back(std::move(prototype));
+    return static_cast<uint32_t>(prototypes.size() - 1);
+}
+
+bool VirtualMachine::releasePrototype(uint32_t index) {
+    for (const CallFrame& frame : frames) {
+        if (frame.prototype == prototypes[index].get()) return false;
+    }
+    prototypes[index].reset();
+    freePrototypes.push_back(index);
+    return true;
+}
+
+VMString* VirtualMachine::intern(std::string_view text) {
+    auto it = strings.find(text);
+    if (it != strings.end()) return it->second;
+    VMString* string = new VMString(text);
+    track(string);
+    strings[std::string_view(string->text)] = string;
+    return string;
+}
+
+VMTable* VirtualMachine::newTable() {
+    VMTable* table = new VMTable();
+    track(table);
+    return table;
+}
+
+void VirtualMachine::track(VMObject* object) {
+    object->next = objects;
+    objects = object;
+    objectCount++;
+}
+
+void VirtualMachine::mark(VMValue value, std::vector<VMTable*>& gray) {
+    if (value.isNative()) {
+        natives[value.asIndex()].marked = true;
+        return;
+    }
+    if (!value.isObject()) return;
+    VMObject* object = value.isString() ? static_cast<VMObject*>(value.asString())
+                                        : static_cast<VMObject*>(value.asTable());
+    if (object->marked) return;
+    object->marked = true;
+    if (value.isTable()) gray.push_back(value.asTable());
+}
+
+// Mark and sweep from the globals, constants and live registers. Converted host functions
+// are swept too; natives added by name never are
+void VirtualMachine::collectGarbage() {
+    VMValue* top = stackTop();
+    std::fill(top, stack.data() + stack.size(), VMValue());  // Dead registers hold nothing
+
+    std::vector<VMTable*> gray;
+    for (VMValue value : globals) mark(value, gray);
+    for (const auto& prototype : prototypes) {
+        if (!prototype) continue;
+        for (VMValue value : prototype->constants) mark(value, gray);
+    }
+    for (VMValue* slot = stack.data(); slot < top; ++slot) mark(*slot, gray);
+    while (!gray.empty()) {
+        VMTable* table = gray.back();
+        gray.pop_back();
+        for (VMValue value : table->array) mark(value, gray);
+        for (const VMTable::Entry& entry : table->entries) {
+            if (entry.value.isNil()) continue;
+            mark(entry.key, gray);
+            mark(entry.value, gray);
+        }
+    }
+
+    VMObject** link = &objects;
+    while (*link) {
+        VMObject* object = *link;
+        if (object->marked) {
+            object->marked = false;
+            link = &object->next;
+            continue;
+        }
+        *link = object->next;
+        if (VMString* string = dynamic_cast<VMString*>(object)) {
+            strings.erase(std::string_view(string->text));
+        }
+        delete object;
+        objectCount--;
+    }
+    nextCollection = std::max<size_t>(4096, objectCount * 2);
+
+    hostFunctionCount = 0;
+    for (uint32_t index = 0; index < natives.size(); ++index) {
+        NativeEntry& native = natives[index];
+        bool marked = native.marked;
+        native.marked = false;
+        if (!native.collectable) continue;
+        if (marked) {
+            hostFunctionCount++;
+            continue;
+        }
+        native = NativeEntry{};
+        freeNatives.push_back(index);
+    }
+    nextNativeCollection = std::max<size_t>(256, hostFunctionCount * 2);
+}
+
+VMValue* VirtualMachine::stackTop() {
+    if (frames.empty()) return stack.data();
+    const CallFrame& frame = frames.back();
+    return frame.base + frame.prototype->registerCount;
+}
+
+VMValue VirtualMachine::fromScriptValue(const ScriptValue& value) {
+    switch (value.type) {
+        case ScriptValueType::NIL: return VMValue();
+        case ScriptValueType::BOOLEAN: return VMValue::boolean(value.as<bool>());
+        case ScriptValueType::INTEGER: return VMValue::integer(value.as<int>());
+        case ScriptValueType::FLOAT: return VMValue::number(value.as<float>());
+        case ScriptValueType::STRING: return VMValue::string(intern(value.as<std::string>()));
+        case ScriptValueType::FUNCTION: {
+            NativeEntry entry{"function",
+                              std::make_shared<ScriptFunction>(value.as<ScriptFunction>()),
+                              nullptr, nullptr};
+            entry.collectable = true;
+            return VMValue::native(addNativeEntry(std::move(entry)));
+        }
+        case ScriptValueType::TABLE: {
+            ScriptTable source = value.as<ScriptTable>();
+            VMTable* table = newTable();
+            for (const std::string& key : source.keys()) {
+                table->set(VMValue::string(intern(key)), fromScriptValue(source.get(key)));
+            }
+            return VMValue::table(table);
+        }
+    }
+    return VMValue();
+}
+
+void VirtualMachine::setGlobal(uint32_t slot, const ScriptValue& value) {
+    if (collectionDue()) collectGarbage();
+    globals[slot] = fromScriptValue(value);
+}
+
+ScriptValue VirtualMachine::toScriptValue(VMValue value) {
+    if (value.isInt()) return ScriptValue(static_cast<int>(value.asInt()));
+    if (value.isDouble()) return ScriptValue(static_cast<float>(value.asDouble()));
+    if (value.isNil()) return ScriptValue();
+    if (value.isBool()) return ScriptValue(value.isTruthy());
+    if (value.isString()) return ScriptValue(value.asString()->text);
+    if (value.isNative() && !natives[value.asIndex()].thunk) {
+        return ScriptValue(*natives[value.asIndex()].function);
+    }
+    if (value.isNative() || value.isFunction()) {
+        // Only valid while this VM lives
+        VirtualMachine* vm = this;
+        ScriptFunction function = [vm, value](const std::vector<ScriptValue>& args) {
+            return vm->invoke(value, args);
+        };
+        return ScriptValue(function);
+    }
+
+    // Tables have string keys on the host side; nesting is cut off so cycles end
+    VMTable* source = value.asTable();
+    ScriptTable table;
+    if (conversionDepth >= MAX_CONVERSION_DEPTH) return ScriptValue(table);
+    conversionDepth++;
+    for (size_t i = 0; i < source->array.size(); ++i) {
+        table.set(std::to_string(i + 1), toScriptValue(source->array[i]));
+    }
+    for (const VMTable::Entry& entry : source->entries) {
+        if (entry.value.isNil()) continue;
+        if (entry.key.isString() || entry.key.isNumber()) {
+            table.set(toString(entry.key), toScriptValue(entry.value));
+        }
+    }
+    conversionDepth--;
+    return ScriptValue(table);
+}
+
+std::string VirtualMachine::toString(VMValue value) const {
+    if (value.isString()) return value.asString()->text;
+    if (value.isInt()) return std::to_string(value.asInt());
+    if (value.isDouble()) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.14g", value.asDouble());
+        return buffer;
+    }
+    if (value.isBool()) return value.isTruthy() ? "true" : "false";
+    return typeName(value);
+}
+
+const char* VirtualMachine::typeName(VMValue value) {
+    if (value.isNumber()) return "number";
+    if (value.isNil()) return "nil";
+    if (value.isBool()) return "boolean";
+    if (value.isString()) return "string";
+    if (value.isTable()) return "table";
+    return "function";
+}
+
+void VirtualMachine::runtimeError(const Instruction* pc, const std::string& message) const {
+    const FunctionPrototype* prototype = frames.back().prototype;
+    size_t index = static_cast<size_t>(pc - prototype->code.data());
+    throw ScriptException("line " + std::to_string(prototype->lines[index]) + ": " + message);
+}
+
+bool VirtualMachine::lessThan(VMValue a, VMValue b, bool orEqual, const Instruction* pc) {
+    if (a.isInt() && b.isInt()) return orEqual ? a.asInt() <= b.asInt() : a.asInt() < b.asInt();
+    if (a.isNumber() && b.isNumber()) {
+        return orEqual ? a.toDouble() <= b.toDouble() : a.toDouble() < b.toDouble();
+    }
+    if (a.isString() && b.isString()) {
+        int order = a.asString()->text.compare(b.asString()->text);
+        return orEqual ? order <= 0 : order < 0;
+    }
+    runtimeError(pc, std::string("attempt to compare ") + typeName(a) + " with " + typeName(b));
+}
+
+void VirtualMachine::argumentError(uint32_t index, const char* expected, VMValue actual) const {
+    std::string message = "bad argument #" + std::to_string(index + 1) + " to '" +
+                          natives[activeNative].name + "' (" + expected + " expected, got " +
+                          typeName(actual) + ")";
+    throwNativeError(message);
+}
+
+void VirtualMachine::nativeError(const std::string& message) const {
+    throwNativeError(natives[activeNative].name + ": " + message);
+}
+
+void VirtualMachine::throwNativeError(const std::string& message) const {
+    if (nativeCallSite) runtimeError(nativeCallSite, message);
+    throw ScriptException(message);
+}
+
+// The thunk may call back into the VM and run other thunks, so the outer thunk's name and
+// call site are restored for its own argument errors afterwards
+VMValue VirtualMachine::callThunk(uint32_t index, const VMValue* arguments, uint32_t count,
+                                  const Instruction* callSite) {
+    const uint32_t outerNative = activeNative;
+    const Instruction* outerCallSite = nativeCallSite;
+    activeNative = index;
+    nativeCallSite = callSite;
+    VMValue result;
+    try {
+        result = natives[index].thunk(*this, natives[index].context, arguments, count);
+    } catch (...) {
+        activeNative = outerNative;
+        nativeCallSite = outerCallSite;
+        throw;
+    }
+    activeNative = outerNative;
+    nativeCallSite = outerCallSite;
+    return result;
+}
+
+VMValue VirtualMachine::callNative(uint32_t index, const VMValue* arguments, size_t count) {
+    if (natives[index].thunk) {
+        return callThunk(index, arguments, static_cast<uint32_t>(count), nullptr);
+    }
+
+    if (nativeDepth == nativeArguments.size()) nativeArguments.emplace_back();
+    std::vector<ScriptValue>& args = nativeArguments[nativeDepth];
+    args.clear();
+    for (size_t i = 0; i < count; ++i) args.push_back(toScriptValue(arguments[i]));
+
+    nativeDepth++;
+    ScriptValue result;
+    std::shared_ptr<ScriptFunction> function = natives[index].function;
+    try {
+        result = (*function)(args);
+    } catch (...) {
+        nativeDepth--;
+        throw;
+    }
+    nativeDepth--;
+    return fromScriptValue(result);
+}
+
+VMValue VirtualMachine::call(VMValue callee, const VMValue* arguments, size_t count) {
+    if (callee.isNative()) return callNative(callee.asIndex(), arguments, count);
+    if (!callee.isFunction()) {
+        throw ScriptException(std::string("attempt to call a ") + typeName(callee) + " value");
+    }
+
+    const FunctionPrototype* prototype = prototypes[callee.asIndex()].get();
+    VMValue* base = stackTop();
+    if (frames.size() >= MAX_CALL_DEPTH ||
+        base + prototype->registerCount > stack.data() + stack.size()) {
+        throw ScriptException("stack overflow");
+    }
+    for (size_t i = 0; i < prototype->registerCount; ++i) {
+        base[i] = i < count && i < prototype->parameterCount ? arguments[i] : VMValue();
+    }
+
+    VMValue result;
+    const size_t depth = frames.size();
+    frames.push_back(CallFrame{prototype, prototype->code.data(), base, &result});
+    try {
+        execute(depth);
+    } catch (...) {
+        frames.resize(depth);
+        throw;
+    }
+    return result;
+}
+
+ScriptValue VirtualMachine::invoke(VMValue callee, const std::vector<ScriptValue>& arguments) {
+    if (callee.isNative() && !natives[callee.asIndex()].thunk) {
+        std::shared_ptr<ScriptFunction> function = natives[callee.asIndex()].function;
+        return (*function)(arguments);
+    }
+
+    // Collections otherwise only run inside scripts, but the host may intern strings too
+    if (collectionDue()) collectGarbage();
+    VMValue local[8];
+    std::vector<VMValue> spilled;
+    VMValue* converted = local;
+    if (arguments.size() > 8) {
+        spilled.resize(arguments.size());
+        converted = spilled.data();
+    }
+    for (size_t i = 0; i < arguments.size(); ++i) converted[i] = fromScriptValue(arguments[i]);
+    return toScriptValue(call(callee, converted, arguments.size()));
+}
+
+// Runs until the frame at entryDepth returns
+void VirtualMachine::execute(size_t entryDepth) {
+    CallFrame* frame = &frames.back();
+    const Instruction* pc = frame->pc;
+    VMValue* base = frame->base;
+    const VMValue* k = frame->prototype->constants.data();
+
+    for (;;) {
+        const Instruction i = *pc++;
+        switch (i.op) {
+            case OpCode::MOVE:
+                base[i.a] = base[i.b];
+                break;
+            case OpCode::LOADK:
+                base[i.a] = k[i.b];
+                break;
+            case OpCode::LOADNIL:
+                base[i.a] = VMValue();
+                break;
+            case OpCode::LOADBOOL:
+                base[i.a] = VMValue::boolean(i.b != 0);
+                if (i.c) pc++;
+                break;
+            case OpCode::GETGLOBAL:
+                base[i.a] = globals[i.b];
+                break;
+            case OpCode::SETGLOBAL:
+                globals[i.b] = base[i.a];
+                break;
+            case OpCode::NEWTABLE:
+                if (collectionDue()) collectGarbage();
+                base[i.a] = VMValue::table(newTable());
+                break;
+            case OpCode::GETTABLE: {
+                VMValue object = base[i.b];
+                if (!object.isTable()) {
+                    runtimeError(pc - 1, std::string("attempt to index a ") + typeName(object) +
+                                             " value");
+                }
+                base[i.a] = object.asTable()->get(rk(base, k, i.c));
+                break;
+            }
+            case OpCode::SETTABLE: {
+                VMValue object = base[i.a];
+                VMValue key = rk(base, k, i.b);
+                if (!object.isTable()) {
+                    runtimeError(pc - 1, std::string("attempt to index a ") + typeName(object) +
+                                             " value");
+                }
+                if (key.isNil() || key.bits == VMValue::QNAN) {
+                    runtimeError(pc - 1, "table index is nil or NaN");
+                }
+                object.asTable()->set(key, rk(base, k, i.c));
+                break;
+            }
+            case OpCode::ADD:
+            case OpCode::SUB:
+            case OpCode::MUL: {
+                VMValue b = rk(base, k, i.b), c = rk(base, k, i.c);
+                if (b.isInt() && c.isInt()) {
+                    // Exact in 64 bits; results outside the 32-bit range become floats, which
+                    // round the same way the float operation would
+                    int64_t x = b.asInt(), y = c.asInt();
+                    int64_t r = i.op == OpCode::ADD ? x + y : i.op == OpCode::SUB ? x - y : x * y;
+                    base[i.a] = r >= INT32_MIN && r <= INT32_MAX
+                                    ? VMValue::integer(static_cast<int32_t>(r))
+                                    : VMValue::number(static_cast<double>(r));
+                } else if (b.isNumber() && c.isNumber()) {
+                    double x = b.toDouble(), y = c.toDouble();
+                    double r = i.op == OpCode::ADD ? x + y : i.op == OpCode::SUB ? x - y : x * y;
+                    base[i.a] = VMValue::number(r);
+                } else {
+                    runtimeError(pc - 1, std::string("attempt to perform arithmetic on a ") +
+                                             typeName(b.isNumber() ? c : b) + " value");
+                }
+                break;
+            }
+            case OpCode::DIV: {
+                VMValue b = rk(base, k, i.b), c = rk(base, k, i.c);
+                if (!b.isNumber() || !c.isNumber()) {
+                    runtimeError(pc - 1, std::string("attempt to perform arithmetic on a ") +
+                                             typeName(b.isNumber() ? c : b) + " value");
+                }
+                base[i.a] = VMValue::number(b.toDouble() / c.toDouble());
+                break;
+            }
+            case OpCode::MOD: {
+                VMValue b = rk(base, k, i.b), c = rk(base, k, i.c);
+                if (b.isInt() && c.isInt()) {
+                    int32_t x = b.asInt(), y = c.asInt();
+                    if (y == 0) runtimeError(pc - 1, "attempt to perform 'n%0'");
+                    int32_t r = y == -1 ? 0 : x % y;
+                    if (r != 0 && (r < 0) != (y < 0)) r += y;
+                    base[i.a] = VMValue::integer(r);
+                } else if (b.isNumber() && c.isNumber()) {
+                    double x = b.toDouble(), y = c.toDouble();
+                    double r = std::fmod(x, y);
+                    if (r != 0.0 && (r < 0.0) != (y < 0.0)) r += y;
+                    base[i.a] = VMValue::number(r);
+                } else {
+                    runtimeError(pc - 1, std::string("attempt to perform arithmetic on a ") +
+                                             typeName(b.isNumber() ? c : b) + " value");
+                }
+                break;
+            }
+            case OpCode::UNM: {
+                VMValue b = base[i.b];
+                if (b.isInt() && b.asInt() != INT32_MIN) {
+                    base[i.a] = VMValue::integer(-b.asInt());
+                } else if (b.isInt()) {
+                    base[i.a] = VMValue::number(-static_cast<double>(b.asInt()));
+                } else if (b.isDouble()) {
+                    base[i.a] = VMValue::number(-b.asDouble());
+                } else {
+                    runtimeError(pc - 1, std::string("attempt to perform arithmetic on a ") +
+                                             typeName(b) + " value");
+                }
+                break;
+            }
+            case OpCode::NOT:
+                base[i.a] = VMValue::boolean(!base[i.b].isTruthy());
+                break;
+            case OpCode::LEN: {
+                VMValue b = base[i.b];
+                if (b.isTable()) {
+                    base[i.a] = VMValue::integer(static_cast<int32_t>(b.asTable()->length()));
+                } else if (b.isString()) {
+                    base[i.a] = VMValue::integer(static_cast<int32_t>(b.asString()->text.size()));
+                } else {
+                    runtimeError(pc - 1, std::string("attempt to get length of a ") +
+                                             typeName(b) + " value");
+                }
+                break;
+            }
+            case OpCode::CONCAT: {
+                VMValue b = rk(base, k, i.b), c = rk(base, k, i.c);
+                if (!(b.isString() || b.isNumber()) || !(c.isString() || c.isNumber())) {
+                    runtimeError(pc - 1, std::string("attempt to concatenate a ") +
+                                             typeName(b.isString() || b.isNumber() ? c : b) +
+                                             " value");
+                }
+                if (collectionDue()) collectGarbage();
+                base[i.a] = VMValue::string(intern(toString(b) + toString(c)));
+                break;
+            }
+            case OpCode::JMP:
+                pc += i.sb();
+                break;
+            case OpCode::EQ:
+                if (valuesEqual(rk(base, k, i.b), rk(base, k, i.c)) != (i.a != 0)) pc++;
+                break;
+            case OpCode::LT:
+            case OpCode::LE: {
+                VMValue b = rk(base, k, i.b), c = rk(base, k, i.c);
+                bool result = b.isInt() && c.isInt()
+                                  ? (i.op == OpCode::LT ? b.asInt() < c.asInt()
+                                                        : b.asInt() <= c.asInt())
+                                  : lessThan(b, c, i.op == OpCode::LE, pc - 1);
+                if (result != (i.a != 0)) pc++;
+                break;
+            }
+            case OpCode::TEST:
+                if (base[i.a].isTruthy() != (i.c != 0)) pc++;
+                break;
+            case OpCode::CALL: {
+                VMValue callee = base[i.a];
+                if (callee.isNative()) {
+                    frame->pc = pc;
+                    VMValue result;
+                    if (natives[callee.asIndex()].thunk) {
+                        // Bound natives read the argument registers in place
+                        result = callThunk(callee.asIndex(), base + i.a + 1, i.b, pc - 1);
+                    } else {
+                        result = callNative(callee.asIndex(), base + i.a + 1, i.b);
+                    }
+                    frame = &frames.back();  // The native may have called back into the VM
+                    base[i.a] = result;
+                    break;
+                }
+                if (!callee.isFunction()) {
+                    runtimeError(pc - 1, std::string("attempt to call a ") + typeName(callee) +
+                                             " value");
+                }
+
+                // Arguments are already in place as the callee's first registers
+                const FunctionPrototype* prototype = prototypes[callee.asIndex()].get();
+                VMValue* calleeBase = base + i.a + 1;
+                if (frames.size() >= MAX_CALL_DEPTH ||
+                    calleeBase + prototype->registerCount > stack.data() + stack.size()) {
+                    runtimeError(pc - 1, "stack overflow");
+                }
+                for (size_t r = i.b < prototype->parameterCount ? i.b : prototype->parameterCount;
+                     r < prototype->registerCount; ++r) {
+                    calleeBase[r] = VMValue();
+                }
+                frame->pc = pc;
+                frames.push_back(CallFrame{prototype, prototype->code.data(), calleeBase,
+                                           base + i.a});
+                frame = &frames.back();
+                pc = frame->pc;
+                base = calleeBase;
+                k = prototype->constants.data();
+                break;
+            }
+            case OpCode::RETURN: {
+                *frame->result = i.b ? base[i.a] : VMValue();
+                frames.pop_back();
+                if (frames.size() == entryDepth) return;
+                frame = &frames.back();
+                pc = frame->pc;
+                base = frame->base;
+                k = frame->prototype->constants.data();
+                break;
+            }
+            case OpCode::FORPREP: {
+                VMValue* r = base + i.a;
+                if (r[0].isInt() && r[1].isInt() && r[2].isInt()) {
+                    int32_t step = r[2].asInt();
+                    if (step == 0) runtimeError(pc - 1, "'for' step is zero");
+                    bool enter = step > 0 ? r[0].asInt() <= r[1].asInt()
+                                          : r[0].asInt() >= r[1].asInt();
+                    if (!enter) {
+                        pc += i.sb();
+                        break;
+                    }
+                } else if (r[0].isNumber() && r[1].isNumber() && r[2].isNumber()) {
+                    double step = r[2].toDouble();
+                    if (step == 0.0) runtimeError(pc - 1, "'for' step is zero");
+                    r[0] = VMValue::number(r[0].toDouble());
+                    r[1] = VMValue::number(r[1].toDouble());
+                    r[2] = VMValue::number(step);
+                    bool enter = step > 0 ? r[0].asDouble() <= r[1].asDouble()
+                                          : r[0].asDouble() >= r[1].asDouble();
+                    if (!enter) {
+                        pc += i.sb();
+                        break;
+                    }
+                } else {
+                    runtimeError(pc - 1, "'for' initial value, limit and step must be numbers");
+                }
+                r[3] = r[0];
+                break;
+            }
+            case OpCode::FORLOOP: {
+                VMValue* r = base + i.a;
+                if (r[0].isInt()) {
+                    // Stops instead of wrapping past the end of the integer range
+                    int64_t next = static_cast<int64_t>(r[0].asInt()) + r[2].asInt();
+                    int32_t step = r[2].asInt();
+                    if (step > 0 ? next <= r[1].asInt() : next >= r[1].asInt()) {
+                        r[0] = r[3] = VMValue::integer(static_cast<int32_t>(next));
+                        pc += i.sb();
+                    }
+                } else {
+                    double next = r[0].asDouble() + r[2].asDouble();
+                    if (r[2].asDouble() > 0 ? next <= r[1].asDouble() : next >= r[1].asDouble()) {
+                        r[0] = r[3] = VMValue::number(next);
+                        pc += i.sb();
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+} // namespace Scripting
+} // namespace JJM
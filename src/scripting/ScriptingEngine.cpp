@@ -1,4 +1,7 @@
 #include "scripting/ScriptingEngine.h"
+#include "scripting/ScriptCompiler.h"
+#include "scripting/ScriptVM.h"
+#include <cmath>
 #include <fstream>
 #include <sstream>
 #include <ctime>
@@ -88,7 +91,7 @@ std::vector<std::string> ScriptTable::keys() const {
 }
 
 // ScriptContext implementation
-ScriptContext::ScriptContext() {
+ScriptContext::ScriptContext() : vm(std::make_unique<VirtualMachine>()) {
     // Register standard library functions
     registerFunction("print", [](const std::vector<ScriptValue>& args) {
         for (const auto& arg : args) {
@@ -124,16 +127,28 @@ ScriptContext::ScriptContext() {
 ScriptContext::~ScriptContext() {}
 
 void ScriptContext::setGlobal(const std::string& name, const ScriptValue& value) {
-    globals[name] = value;
+    setGlobal(resolveGlobal(name), value);
 }
 
 ScriptValue ScriptContext::getGlobal(const std::string& name) const {
-    auto it = globals.find(name);
-    return (it != globals.end()) ? it->second : ScriptValue();
+    int slot = vm->findGlobal(name);
+    return slot >= 0 ? getGlobal(static_cast<GlobalSlot>(slot)) : ScriptValue();
+}
+
+ScriptContext::GlobalSlot ScriptContext::resolveGlobal(const std::string& name) {
+    return vm->resolveGlobal(name);
+}
+
+void ScriptContext::setGlobal(GlobalSlot slot, const ScriptValue& value) {
+    vm->setGlobal(slot, value);
+}
+
+ScriptValue ScriptContext::getGlobal(GlobalSlot slot) const {
+    return vm->toScriptValue(vm->getGlobal(slot));
 }
 
 void ScriptContext::registerFunction(const std::string& name, ScriptFunction func) {
-    functions[name] = func;
+    vm->setGlobal(vm->resolveGlobal(name), VMValue::native(vm->addNative(name, std::move(func))));
 }
 
 void ScriptContext::loadScript(const std::string& filename) {
@@ -150,7 +165,29 @@ void ScriptContext::loadScript(const std::string& filename) {
 
 void ScriptContext::loadString(const std::string& code) {
     try {
-        executeCode(code);
+        auto it = compiledChunks.find(code);
+        if (it != compiledChunks.end()) {
+            chunkOrder.splice(chunkOrder.begin(), chunkOrder, it->second.order);
+        } else {
+            // Only loadString refers to a main function, so the oldest one that is not running
+            // (a native may load scripts from inside one) can be freed; any functions the
+            // chunk defined stay
+            if (compiledChunks.size() >= MAX_COMPILED_CHUNKS) {
+                for (auto order = chunkOrder.rbegin(); order != chunkOrder.rend(); ++order) {
+                    auto oldest = compiledChunks.find(**order);
+                    if (vm->releasePrototype(oldest->second.function)) {
+                        chunkOrder.erase(std::next(order).base());
+                        compiledChunks.erase(oldest);
+                        break;
+                    }
+                }
+            }
+            uint32_t function = compileScript(*vm, code, "main");
+            it = compiledChunks.emplace(code, CompiledChunk{function, {}}).first;
+            chunkOrder.push_front(&it->first);
+            it->second.order = chunkOrder.begin();
+        }
+        vm->call(VMValue::function(it->second.function), nullptr, 0);
         lastError.clear();
     } catch (const ScriptException& e) {
         lastError = e.what();
@@ -159,103 +196,30 @@ void ScriptContext::loadString(const std::string& code) {
 }
 
 ScriptValue ScriptContext::callFunction(const std::string& name, const std::vector<ScriptValue>& args) {
-    auto it = functions.find(name);
-    if (it == functions.end()) {
+    int slot = vm->findGlobal(name);
+    VMValue callee = slot >= 0 ? vm->getGlobal(static_cast<GlobalSlot>(slot)) : VMValue();
+    if (!callee.isNative() && !callee.isFunction()) {
         lastError = "Function not found: " + name;
         throw ScriptException(lastError);
     }
+    return callFunction(static_cast<GlobalSlot>(slot), args);
+}
+
+ScriptValue ScriptContext::callFunction(GlobalSlot slot, const std::vector<ScriptValue>& args) {
+    VMValue callee = vm->getGlobal(slot);
+    if (!callee.isNative() && !callee.isFunction()) {
+        lastError = "Function not found: " + vm->getGlobalName(slot);
+        throw ScriptException(lastError);
+    }
     
     try {
-        return it->second(args);
+        return vm->invoke(callee, args);
     } catch (const ScriptException& e) {
         lastError = e.what();
         throw;
     }
 }
 
-void ScriptContext::executeCode(const std::string& code) {
-    // Simple script interpreter (this is a minimal implementation)
-    // In a real implementation, you would integrate Lua or Python here
-    
-    // Parse variable assignments: var_name = value
-    size_t pos = 0;
-    while ((pos = code.find('=', pos)) != std::string::npos) {
-        // Find variable name
-        size_t start = pos;
-        while (start > 0 && (isalnum(code[start - 1]) || code[start - 1] == '_')) {
-            start--;
-        }
-        std::string varName = code.substr(start, pos - start);
-        
-        // Trim whitespace
-        varName.erase(0, varName.find_first_not_of(" \t\n\r"));
-        varName.erase(varName.find_last_not_of(" \t\n\r") + 1);
-        
-        // Find value (simplified - just handles numbers and strings)
-        size_t valueStart = pos + 1;
-        while (valueStart < code.length() && isspace(code[valueStart])) {
-            valueStart++;
-        }
-        
-        size_t valueEnd = code.find_first_of(";\n", valueStart);
-        if (valueEnd == std::string::npos) valueEnd = code.length();
-        
-        std::string valueStr = code.substr(valueStart, valueEnd - valueStart);
-        valueStr.erase(0, valueStr.find_first_not_of(" \t\n\r"));
-        valueStr.erase(valueStr.find_last_not_of(" \t\n\r") + 1);
-        
-        // Parse value
-        ScriptValue value;
-        if (valueStr[0] == '"' || valueStr[0] == '\'') {
-            // String value
-            value = ScriptValue(valueStr.substr(1, valueStr.length() - 2));
-        } else if (valueStr == "true" || valueStr == "false") {
-            // Boolean value
-            value = ScriptValue(valueStr == "true");
-        } else if (valueStr.find('.') != std::string::npos) {
-            // Float value
-            value = ScriptValue(std::stof(valueStr));
-        } else {
-            // Integer value
-            value = ScriptValue(std::stoi(valueStr));
-        }
-        
-        if (!varName.empty()) {
-            setGlobal(varName, value);
-        }
-        
-        pos = valueEnd;
-    }
-}
-
-ScriptValue ScriptContext::evaluateExpression(const std::string& expr) {
-    // Simplified expression evaluation
-    std::string trimmed = expr;
-    trimmed.erase(0, trimmed.find_first_not_of(" \t\n\r"));
-    trimmed.erase(trimmed.find_last_not_of(" \t\n\r") + 1);
-    
-    // Check if it's a variable
-    if (isalpha(trimmed[0]) || trimmed[0] == '_') {
-        return getGlobal(trimmed);
-    }
-    
-    // Check if it's a number
-    if (isdigit(trimmed[0]) || trimmed[0] == '-') {
-        if (trimmed.find('.') != std::string::npos) {
-            return ScriptValue(std::stof(trimmed));
-        } else {
-            return ScriptValue(std::stoi(trimmed));
-        }
-    }
-    
-    // Check if it's a string
-    if (trimmed[0] == '"' || trimmed[0] == '\'') {
-        return ScriptValue(trimmed.substr(1, trimmed.length() - 2));
-    }
-    
-    return ScriptValue();
-}
-
 // ScriptManager implementation
 ScriptManager& ScriptManager::getInstance() {
     static ScriptManager instance;
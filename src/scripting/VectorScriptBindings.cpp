@@ -0,0 +1,106 @@
+#include "scripting/VectorScriptBindings.h"
+#include <algorithm>
+#include <string>
+
+namespace JJM {
+namespace Scripting {
+
+namespace {
+
+// Packed components are read and written in place, without converting the array
+float component(VirtualMachine* vm, const VMTable* table, size_t index) {
+    VMValue value = table->array[index];
+    if (value.isDouble()) return static_cast<float>(value.asDouble());
+    if (value.isInt()) return static_cast<float>(value.asInt());
+    vm->nativeError("element " + std::to_string(index + 1) + " is a " +
+                    VirtualMachine::typeName(value) + ", not a number");
+}
+
+Math::Vector2D load(VirtualMachine* vm, const VMTable* table, size_t vector) {
+    return Math::Vector2D(component(vm, table, vector * 2), component(vm, table, vector * 2 + 1));
+}
+
+void store(VMTable* table, size_t vector, const Math::Vector2D& v) {
+    table->array[vector * 2] = VMValue::number(v.x);
+    table->array[vector * 2 + 1] = VMValue::number(v.y);
+}
+
+size_t vectorCount(const VMTable* table) { return table->length() / 2; }
+
+} // namespace
+
+void VectorScriptBindings::registerBindings(ScriptContext* context) {
+    bindFunction<&length>(*context, "vectorLength");
+    bindFunction<&Math::Vector2D::Dot>(*context, "vectorDot");
+    bindFunction<&Math::Vector2D::Cross>(*context, "vectorCross");
+    bindFunction<&Math::Vector2D::Distance>(*context, "vectorDistance");
+    bindFunction<&angle>(*context, "vectorAngle");
+
+    bindFunction<&integrate>(*context, "vectorIntegrate");
+    bindFunction<&translateAll>(*context, "vectorTranslateAll");
+    bindFunction<&scaleAll>(*context, "vectorScaleAll");
+    bindFunction<&normalizeAll>(*context, "vectorNormalizeAll");
+    bindFunction<&clampLengthAll>(*context, "vectorClampLengthAll");
+    bindFunction<&lengthsAll>(*context, "vectorLengthsAll");
+}
+
+float VectorScriptBindings::length(Math::Vector2D v) { return v.magnitude(); }
+
+float VectorScriptBindings::angle(Math::Vector2D v) { return v.angle(); }
+
+int VectorScriptBindings::integrate(VirtualMachine* vm, VMTable* positions, VMTable* velocities,
+                                    float dt) {
+    const size_t count = vectorCount(positions);
+    if (vectorCount(velocities) < count) {
+        vm->nativeError("fewer velocities than positions");
+    }
+    for (size_t i = 0; i < count; ++i) {
+        store(positions, i, load(vm, positions, i) + load(vm, velocities, i) * dt);
+    }
+    return static_cast<int>(count);
+}
+
+int VectorScriptBindings::translateAll(VirtualMachine* vm, VMTable* vectors,
+                                       Math::Vector2D offset) {
+    const size_t count = vectorCount(vectors);
+    for (size_t i = 0; i < count; ++i) store(vectors, i, load(vm, vectors, i) + offset);
+    return static_cast<int>(count);
+}
+
+int VectorScriptBindings::scaleAll(VirtualMachine* vm, VMTable* vectors, float factor) {
+    const size_t count = vectorCount(vectors);
+    for (size_t i = 0; i < count; ++i) store(vectors, i, load(vm, vectors, i) * factor);
+    return static_cast<int>(count);
+}
+
+int VectorScriptBindings::normalizeAll(VirtualMachine* vm, VMTable* vectors) {
+    const size_t count = vectorCount(vectors);
+    for (size_t i = 0; i < count; ++i) {
+        Math::Vector2D v = load(vm, vectors, i);
+        if (v.magnitudeSquared() > 0.0f) store(vectors, i, v.normalized());
+    }
+    return static_cast<int>(count);
+}
+
+int VectorScriptBindings::clampLengthAll(VirtualMachine* vm, VMTable* vectors, float maxLength) {
+    const size_t count = vectorCount(vectors);
+    const float maxSquared = maxLength * maxLength;
+    for (size_t i = 0; i < count; ++i) {
+        Math::Vector2D v = load(vm, vectors, i);
+        if (v.magnitudeSquared() > maxSquared) store(vectors, i, v.normalized() * maxLength);
+    }
+    return static_cast<int>(count);
+}
+
+int VectorScriptBindings::lengthsAll(VirtualMachine* vm, VMTable* vectors, VMTable* lengths) {
+    const size_t count = vectorCount(vectors);
+    if (lengths->array.size() < count) lengths->array.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        lengths->array[i] = VMValue::number(load(vm, vectors, i).magnitude());
+    }
+    lengths->array.resize(count);  // Shrunk afterwards, so lengths may be the vectors table
+    return static_cast<int>(count);
+}
+
+} // namespace Scripting
+} // namespace JJM
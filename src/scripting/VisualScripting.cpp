@@ -1,10 +1,99 @@
 #include "scripting/VisualScripting.h"
+#include "threading/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace JJM {
 namespace Scripting {
 
-VisualScriptNode::VisualScriptNode(int id, const std::string& type)
-    : m_id(id), m_type(type) {
+namespace {
+
+struct BuiltinType {
+    const char* name;
+    NodeOp op;
+};
+
+const BuiltinType BUILTIN_TYPES[] = {
+    {"Constant", NodeOp::CONSTANT}, {"GetVariable", NodeOp::GET_VARIABLE},
+    {"SetVariable", NodeOp::SET_VARIABLE}, {"Add", NodeOp::ADD},
+    {"Subtract", NodeOp::SUBTRACT}, {"Multiply", NodeOp::MULTIPLY},
+    {"Divide", NodeOp::DIVIDE}, {"Min", NodeOp::MIN}, {"Max", NodeOp::MAX},
+    {"Negate", NodeOp::NEGATE}, {"Abs", NodeOp::ABS}, {"Sqrt", NodeOp::SQRT},
+    {"Sin", NodeOp::SIN}, {"Cos", NodeOp::COS}, {"Less", NodeOp::LESS},
+    {"Greater", NodeOp::GREATER}, {"Equal", NodeOp::EQUAL}, {"And", NodeOp::AND},
+    {"Or", NodeOp::OR}, {"Not", NodeOp::NOT}, {"Select", NodeOp::SELECT},
+    {"Clamp", NodeOp::CLAMP}, {"Lerp", NodeOp::LERP}};
+
+// Instances per pass over the instructions; keeps a block's slots in cache
+constexpr size_t BLOCK_INSTANCES = 256;
+// Instances per job when a batch runs on workers
+constexpr size_t JOB_INSTANCES = 1024;
+constexpr size_t MAX_CUSTOM_PINS = 32;
+constexpr size_t MAX_SLOTS = 0xFFFF;
+
+bool isScalar(PinType type) {
+    return type == PinType::FLOAT || type == PinType::INT || type == PinType::BOOL;
+}
+
+bool isPure(NodeOp op) {
+    return op != NodeOp::CUSTOM && op != NodeOp::GET_VARIABLE && op != NodeOp::SET_VARIABLE;
+}
+
+float evaluateOp(NodeOp op, const float* in) {
+    switch (op) {
+        case NodeOp::ADD: return in[0] + in[1];
+        case NodeOp::SUBTRACT: return in[0] - in[1];
+        case NodeOp::MULTIPLY: return in[0] * in[1];
+        case NodeOp::DIVIDE: return in[0] / in[1];
+        case NodeOp::MIN: return std::min(in[0], in[1]);
+        case NodeOp::MAX: return std::max(in[0], in[1]);
+        case NodeOp::NEGATE: return -in[0];
+        case NodeOp::ABS: return std::fabs(in[0]);
+        case NodeOp::SQRT: return std::sqrt(in[0]);
+        case NodeOp::SIN: return std::sin(in[0]);
+        case NodeOp::COS: return std::cos(in[0]);
+        case NodeOp::LESS: return in[0] < in[1] ? 1.0f : 0.0f;
+        case NodeOp::GREATER: return in[0] > in[1] ? 1.0f : 0.0f;
+        case NodeOp::EQUAL: return in[0] == in[1] ? 1.0f : 0.0f;
+        case NodeOp::AND: return in[0] != 0.0f && in[1] != 0.0f ? 1.0f : 0.0f;
+        case NodeOp::OR: return in[0] != 0.0f || in[1] != 0.0f ? 1.0f : 0.0f;
+        case NodeOp::NOT: return in[0] == 0.0f ? 1.0f : 0.0f;
+        case NodeOp::SELECT: return in[0] != 0.0f ? in[1] : in[2];
+        case NodeOp::CLAMP: return std::min(std::max(in[0], in[1]), in[2]);
+        case NodeOp::LERP: return in[0] + (in[1] - in[0]) * in[2];
+        default: return 0.0f;
+    }
+}
+
+// One operation over a block of instances; the loops stay free of dispatch so they vectorize
+template<typename F>
+void unary(float* out, const float* a, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) out[i] = f(a[i]);
+}
+
+template<typename F>
+void binary(float* out, const float* a, const float* b, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) out[i] = f(a[i], b[i]);
+}
+
+template<typename F>
+void ternary(float* out, const float* a, const float* b, const float* c, size_t n, F f) {
+    for (size_t i = 0; i < n; ++i) out[i] = f(a[i], b[i], c[i]);
+}
+
+// Where a pin's value comes from while compiling; slots are numbered once the counts are known
+struct Operand {
+    enum class Kind { VARIABLE, CONSTANT, TEMPORARY };
+    Kind kind = Kind::CONSTANT;
+    uint32_t index = 0;
+    float value = 0.0f;
+};
+
+} // namespace
+
+VisualScriptNode::VisualScriptNode(int id, const std::string& type, NodeOp op)
+    : m_id(id), m_type(type), m_op(op) {
 }
 
 void VisualScriptNode::addInput(const std::string& name, PinType type) {
@@ -14,6 +103,7 @@ void VisualScriptNode::addInput(const std::string& name, PinType type) {
     pin.isInput = true;
     pin.index = static_cast<int>(m_inputs.size());
     m_inputs.push_back(pin);
+    m_defaults.push_back(0.0f);
 }
 
 void VisualScriptNode::addOutput(const std::string& name, PinType type) {
@@ -25,51 +115,646 @@ void VisualScriptNode::addOutput(const std::string& name, PinType type) {
     m_outputs.push_back(pin);
 }
 
-VisualScript::VisualScript() : m_nextNodeId(1) {
+void VisualScriptNode::setInputDefault(int pin, float value) {
+    if (pin >= 0 && pin < static_cast<int>(m_defaults.size())) {
+        m_defaults[pin] = value;
+    }
+}
+
+BuiltinNode::BuiltinNode(int id, const std::string& type, NodeOp op)
+    : VisualScriptNode(id, type, op), m_value(0.0f) {
+    switch (op) {
+        case NodeOp::CONSTANT:
+        case NodeOp::GET_VARIABLE:
+            addOutput("Value", PinType::FLOAT);
+            return;
+        case NodeOp::SET_VARIABLE:
+            addInput("Value", PinType::FLOAT);
+            return;
+        case NodeOp::NEGATE:
+        case NodeOp::ABS:
+        case NodeOp::SQRT:
+        case NodeOp::SIN:
+        case NodeOp::COS:
+            addInput("Value", PinType::FLOAT);
+            addOutput("Result", PinType::FLOAT);
+            return;
+        case NodeOp::LESS:
+        case NodeOp::GREATER:
+        case NodeOp::EQUAL:
+            addInput("A", PinType::FLOAT);
+            addInput("B", PinType::FLOAT);
+            addOutput("Result", PinType::BOOL);
+            return;
+        case NodeOp::AND:
+        case NodeOp::OR:
+            addInput("A", PinType::BOOL);
+            addInput("B", PinType::BOOL);
+            addOutput("Result", PinType::BOOL);
+            return;
+        case NodeOp::NOT:
+            addInput("Value", PinType::BOOL);
+            addOutput("Result", PinType::BOOL);
+            return;
+        case NodeOp::SELECT:
+            addInput("Condition", PinType::BOOL);
+            addInput("True", PinType::FLOAT);
+            addInput("False", PinType::FLOAT);
+            addOutput("Result", PinType::FLOAT);
+            return;
+        case NodeOp::CLAMP:
+            addInput("Value", PinType::FLOAT);
+            addInput("Min", PinType::FLOAT);
+            addInput("Max", PinType::FLOAT);
+            addOutput("Result", PinType::FLOAT);
+            return;
+        case NodeOp::LERP:
+            addInput("A", PinType::FLOAT);
+            addInput("B", PinType::FLOAT);
+            addInput("T", PinType::FLOAT);
+            addOutput("Result", PinType::FLOAT);
+            return;
+        default:
+            addInput("A", PinType::FLOAT);
+            addInput("B", PinType::FLOAT);
+            addOutput("Result", PinType::FLOAT);
+            return;
+    }
+}
+
+void BuiltinNode::evaluate(const float* inputs, float* outputs) const {
+    if (m_op == NodeOp::CONSTANT) {
+        outputs[0] = m_value;
+    } else if (m_op != NodeOp::GET_VARIABLE && m_op != NodeOp::SET_VARIABLE) {
+        outputs[0] = evaluateOp(m_op, inputs);
+    }
+}
+
+// VisualScriptPlan implementation
+void VisualScriptPlan::execute(float* values, size_t stride, size_t first, size_t count) const {
+    const size_t end = first + count;
+    for (size_t start = first; start < end; start += BLOCK_INSTANCES) {
+        const size_t n = std::min(BLOCK_INSTANCES, end - start);
+        auto slot = [values, stride, start](uint16_t s) { return values + s * stride + start; };
+
+        for (const PlanInstruction& ins : m_code) {
+            if (ins.op == NodeOp::CUSTOM) {
+                const Call& call = m_calls[ins.output];
+                float inputs[MAX_CUSTOM_PINS];
+                float outputs[MAX_CUSTOM_PINS];
+                for (size_t i = 0; i < n; ++i) {
+                    for (size_t p = 0; p < call.inputs.size(); ++p) {
+                        inputs[p] = slot(call.inputs[p])[i];
+                    }
+                    call.node->evaluate(inputs, outputs);
+                    for (size_t p = 0; p < call.outputs.size(); ++p) {
+                        slot(call.outputs[p])[i] = outputs[p];
+                    }
+                }
+                continue;
+            }
+
+            float* out = slot(ins.output);
+            const float* a = slot(ins.inputs[0]);
+            const float* b = slot(ins.inputs[1]);
+            const float* c = slot(ins.inputs[2]);
+            switch (ins.op) {
+                case NodeOp::SET_VARIABLE:
+                    std::memcpy(out, a, n * sizeof(float));
+                    break;
+                case NodeOp::ADD:
+                    binary(out, a, b, n, [](float x, float y) { return x + y; });
+                    break;
+                case NodeOp::SUBTRACT:
+                    binary(out, a, b, n, [](float x, float y) { return x - y; });
+                    break;
+                case NodeOp::MULTIPLY:
+                    binary(out, a, b, n, [](float x, float y) { return x * y; });
+                    break;
+                case NodeOp::DIVIDE:
+                    binary(out, a, b, n, [](float x, float y) { return x / y; });
+                    break;
+                case NodeOp::MIN:
+                    binary(out, a, b, n, [](float x, float y) { return std::min(x, y); });
+                    break;
+                case NodeOp::MAX:
+                    binary(out, a, b, n, [](float x, float y) { return std::max(x, y); });
+                    break;
+                case NodeOp::NEGATE:
+                    unary(out, a, n, [](float x) { return -x; });
+                    break;
+                case NodeOp::ABS:
+                    unary(out, a, n, [](float x) { return std::fabs(x); });
+                    break;
+                case NodeOp::SQRT:
+                    unary(out, a, n, [](float x) { return std::sqrt(x); });
+                    break;
+                case NodeOp::SIN:
+                    unary(out, a, n, [](float x) { return std::sin(x); });
+                    break;
+                case NodeOp::COS:
+                    unary(out, a, n, [](float x) { return std::cos(x); });
+                    break;
+                case NodeOp::LESS:
+                    binary(out, a, b, n, [](float x, float y) { return x < y ? 1.0f : 0.0f; });
+                    break;
+                case NodeOp::GREATER:
+                    binary(out, a, b, n, [](float x, float y) { return x > y ? 1.0f : 0.0f; });
+                    break;
+                case NodeOp::EQUAL:
+                    binary(out, a, b, n, [](float x, float y) { return x == y ? 1.0f : 0.0f; });
+                    break;
+                case NodeOp::AND:
+                    binary(out, a, b, n, [](float x, float y) {
+                        return x != 0.0f && y != 0.0f ? 1.0f : 0.0f;
+                    });
+                    break;
+                case NodeOp::OR:
+                    binary(out, a, b, n, [](float x, float y) {
+                        return x != 0.0f || y != 0.0f ? 1.0f : 0.0f;
+                    });
+                    break;
+                case NodeOp::NOT:
+                    unary(out, a, n, [](float x) { return x == 0.0f ? 1.0f : 0.0f; });
+                    break;
+                case NodeOp::SELECT:
+                    ternary(out, a, b, c, n, [](float x, float y, float z) {
+                        return x != 0.0f ? y : z;
+                    });
+                    break;
+                case NodeOp::CLAMP:
+                    ternary(out, a, b, c, n, [](float x, float lo, float hi) {
+                        return std::min(std::max(x, lo), hi);
+                    });
+                    break;
+                case NodeOp::LERP:
+                    ternary(out, a, b, c, n, [](float x, float y, float t) {
+                        return x + (y - x) * t;
+                    });
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+int VisualScriptPlan::getVariableSlot(const std::string& name) const {
+    auto it = std::find(m_variables.begin(), m_variables.end(), name);
+    return it != m_variables.end() ? static_cast<int>(it - m_variables.begin()) : -1;
+}
+
+// VisualScript implementation
+VisualScript::VisualScript() : m_nextNodeId(1), m_dirty(false) {
 }
 
 VisualScript::~VisualScript() {
 }
 
 int VisualScript::addNode(const std::string& type) {
-    int id = m_nextNodeId++;
-    // m_nodes.push_back(NodeFactory::create(id, type));
-    return id;
+    for (const BuiltinType& builtin : BUILTIN_TYPES) {
+        if (type == builtin.name) {
+            int id = m_nextNodeId++;
+            m_nodes.push_back(std::make_shared<BuiltinNode>(id, type, builtin.op));
+            m_dirty = true;
+            return id;
+        }
+    }
+    return -1;
 }
 
 void VisualScript::removeNode(int nodeId) {
     m_nodes.erase(
         std::remove_if(m_nodes.begin(), m_nodes.end(),
-                      [nodeId](const std::unique_ptr<VisualScriptNode>& node) {
+                      [nodeId](const std::shared_ptr<VisualScriptNode>& node) {
                           return node->getId() == nodeId;
                       }),
         m_nodes.end()
     );
+    m_connections.erase(
+        std::remove_if(m_connections.begin(), m_connections.end(),
+                      [nodeId](const NodeConnection& conn) {
+                          return conn.sourceNode == nodeId || conn.targetNode == nodeId;
+                      }),
+        m_connections.end()
+    );
+    m_dirty = true;
+}
+
+VisualScriptNode* VisualScript::getNode(int nodeId) {
+    for (const auto& node : m_nodes) {
+        if (node->getId() == nodeId) return node.get();
+    }
+    return nullptr;
 }
 
 bool VisualScript::connectNodes(int sourceNode, int sourcePin,
                                int targetNode, int targetPin) {
+    VisualScriptNode* source = getNode(sourceNode);
+    VisualScriptNode* target = getNode(targetNode);
+    if (!source || !target || source == target) return false;
+    if (sourcePin < 0 || sourcePin >= static_cast<int>(source->getOutputs().size()) ||
+        targetPin < 0 || targetPin >= static_cast<int>(target->getInputs().size())) {
+        return false;
+    }
+    PinType from = source->getOutputs()[sourcePin].type;
+    PinType to = target->getInputs()[targetPin].type;
+    if (from != to && !(isScalar(from) && isScalar(to))) return false;
+
+    // An input has one source
+    m_connections.erase(
+        std::remove_if(m_connections.begin(), m_connections.end(),
+                      [targetNode, targetPin](const NodeConnection& conn) {
+                          return conn.targetNode == targetNode && conn.targetPin == targetPin;
+                      }),
+        m_connections.end()
+    );
+
     NodeConnection conn;
     conn.sourceNode = sourceNode;
     conn.sourcePin = sourcePin;
     conn.targetNode = targetNode;
     conn.targetPin = targetPin;
     m_connections.push_back(conn);
+    m_dirty = true;
     return true;
 }
 
+bool VisualScript::setConstant(int nodeId, float value) {
+    VisualScriptNode* node = getNode(nodeId);
+    if (!node || node->getOp() != NodeOp::CONSTANT) return false;
+    static_cast<BuiltinNode*>(node)->setValue(value);
+    m_dirty = true;
+    return true;
+}
+
+bool VisualScript::setNodeVariable(int nodeId, const std::string& name) {
+    VisualScriptNode* node = getNode(nodeId);
+    if (!node || (node->getOp() != NodeOp::GET_VARIABLE && node->getOp() != NodeOp::SET_VARIABLE)) {
+        return false;
+    }
+    static_cast<BuiltinNode*>(node)->setVariable(name);
+    m_dirty = true;
+    return true;
+}
+
+bool VisualScript::setInputDefault(int nodeId, int pin, float value) {
+    VisualScriptNode* node = getNode(nodeId);
+    if (!node || pin < 0 || pin >= static_cast<int>(node->getInputs().size())) return false;
+    node->setInputDefault(pin, value);
+    m_dirty = true;
+    return true;
+}
+
+void VisualScript::setVariableDefault(const std::string& name, float value) {
+    m_variableDefaults[name] = value;
+    m_dirty = true;
+}
+
 void VisualScript::execute() {
-    // Execute nodes in order
-    for (const auto& node : m_nodes) {
-        node->execute();
+    if (m_dirty) compile();
+    if (m_plan) {
+        m_plan->execute(m_values.data(), 1, 0, 1);
     }
 }
 
+float VisualScript::getVariable(const std::string& name) const {
+    int slot = m_plan ? m_plan->getVariableSlot(name) : -1;
+    return slot >= 0 ? m_values[slot] : 0.0f;
+}
+
+void VisualScript::setVariable(const std::string& name, float value) {
+    if (m_dirty) compile();
+    int slot = m_plan ? m_plan->getVariableSlot(name) : -1;
+    if (slot >= 0) m_values[slot] = value;
+}
+
 bool VisualScript::compile() {
-    // Compile graph to executable form
+    m_dirty = false;
+    m_compileError.clear();
+    std::shared_ptr<const VisualScriptPlan> previous = m_plan;
+    m_plan.reset();
+    auto fail = [this](const std::string& message) {
+        m_compileError = message;
+        return false;
+    };
+
+    const size_t nodeCount = m_nodes.size();
+    std::unordered_map<int, size_t> indexOf;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        const VisualScriptNode& node = *m_nodes[i];
+        indexOf[node.getId()] = i;
+        for (const std::vector<Pin>* pins : {&node.getInputs(), &node.getOutputs()}) {
+            for (const Pin& pin : *pins) {
+                if (!isScalar(pin.type)) {
+                    return fail("node " + std::to_string(node.getId()) + " (" + node.getType() +
+                                ") has a pin type compiled plans do not support");
+                }
+            }
+        }
+        if (node.getOp() == NodeOp::CUSTOM && (node.getInputs().size() > MAX_CUSTOM_PINS ||
+                                               node.getOutputs().size() > MAX_CUSTOM_PINS)) {
+            return fail("node " + std::to_string(node.getId()) + " has too many pins");
+        }
+    }
+
+    // The connection feeding each input, and the nodes each node feeds
+    std::vector<std::vector<const NodeConnection*>> incoming(nodeCount);
+    std::vector<std::vector<size_t>> users(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        incoming[i].assign(m_nodes[i]->getInputs().size(), nullptr);
+    }
+    for (const NodeConnection& conn : m_connections) {
+        size_t source = indexOf.at(conn.sourceNode);
+        size_t target = indexOf.at(conn.targetNode);
+        incoming[target][conn.targetPin] = &conn;
+        users[source].push_back(target);
+    }
+
+    // Dead-node elimination: keep what variables and side effects depend on
+    std::vector<char> live(nodeCount, 0);
+    std::vector<size_t> stack;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        if (m_nodes[i]->getOp() == NodeOp::SET_VARIABLE || m_nodes[i]->hasSideEffects()) {
+            live[i] = 1;
+            stack.push_back(i);
+        }
+    }
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        for (const NodeConnection* conn : incoming[i]) {
+            if (!conn) continue;
+            size_t source = indexOf.at(conn->sourceNode);
+            if (!live[source]) {
+                live[source] = 1;
+                stack.push_back(source);
+            }
+        }
+    }
+
+    // Topological order of the live nodes, ties broken by insertion order
+    std::vector<size_t> pending(nodeCount, 0);
+    std::vector<size_t> order;
+    size_t liveCount = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        if (!live[i]) continue;
+        liveCount++;
+        for (const NodeConnection* conn : incoming[i]) pending[i] += conn ? 1 : 0;
+        if (pending[i] == 0) order.push_back(i);
+    }
+    for (size_t next = 0; next < order.size(); ++next) {
+        for (size_t user : users[order[next]]) {
+            if (live[user] && --pending[user] == 0) order.push_back(user);
+        }
+    }
+    if (order.size() != liveCount) return fail("graph has a cycle");
+
+    auto plan = std::make_shared<VisualScriptPlan>();
+    plan->m_stats.nodes = nodeCount;
+    plan->m_stats.eliminatedNodes = nodeCount - liveCount;
+
+    struct Step {
+        NodeOp op;
+        size_t call;
+        Operand output;
+        Operand inputs[3];
+        size_t inputCount;
+    };
+    std::vector<Step> steps;
+    std::vector<Step> writes;  // Variable writes run last, after every read
+    std::vector<std::vector<Operand>> outputs(nodeCount);
+    std::vector<std::vector<Operand>> callInputs, callOutputs;
+    uint32_t temporaries = 0;
+
+    auto variable = [&plan](const std::string& name) {
+        Operand operand;
+        operand.kind = Operand::Kind::VARIABLE;
+        auto it = std::find(plan->m_variables.begin(), plan->m_variables.end(), name);
+        operand.index = static_cast<uint32_t>(it - plan->m_variables.begin());
+        if (it == plan->m_variables.end()) plan->m_variables.push_back(name);
+        return operand;
+    };
+    auto constant = [](float value) {
+        Operand operand;
+        operand.value = value;
+        return operand;
+    };
+    auto temporary = [&temporaries]() {
+        Operand operand;
+        operand.kind = Operand::Kind::TEMPORARY;
+        operand.index = temporaries++;
+        return operand;
+    };
+
+    for (size_t i : order) {
+        const VisualScriptNode& node = *m_nodes[i];
+        const NodeOp op = node.getOp();
+        std::vector<Operand> inputs;
+        bool allConstant = true;
+        for (size_t p = 0; p < incoming[i].size(); ++p) {
+            const NodeConnection* conn = incoming[i][p];
+            inputs.push_back(conn ? outputs[indexOf.at(conn->sourceNode)][conn->sourcePin]
+                                  : constant(node.getInputDefault(static_cast<int>(p))));
+            allConstant = allConstant && inputs.back().kind == Operand::Kind::CONSTANT;
+        }
+
+        if (op == NodeOp::CONSTANT) {
+            outputs[i].push_back(constant(static_cast<const BuiltinNode&>(node).getValue()));
+            continue;
+        }
+        if (op == NodeOp::GET_VARIABLE || op == NodeOp::SET_VARIABLE) {
+            const std::string& name = static_cast<const BuiltinNode&>(node).getVariable();
+            if (name.empty()) {
+                return fail("node " + std::to_string(node.getId()) + " has no variable name");
+            }
+            Operand target = variable(name);
+            if (op == NodeOp::GET_VARIABLE) {
+                outputs[i].push_back(target);
+            } else if (inputs[0].kind != target.kind || inputs[0].index != target.index) {
+                // Writes read what the graph computed this run, not another write's result
+                Operand source = inputs[0];
+                if (source.kind == Operand::Kind::VARIABLE) {
+                    Operand copy = temporary();
+                    steps.push_back(Step{op, 0, copy, {source, {}, {}}, 1});
+                    source = copy;
+                }
+                writes.push_back(Step{op, 0, target, {source, {}, {}}, 1});
+            }
+            continue;
+        }
+
+        // Constant folding; a constant condition also picks its branch
+        if (isPure(op) && allConstant) {
+            float values[3] = {inputs[0].value, inputs.size() > 1 ? inputs[1].value : 0.0f,
+                               inputs.size() > 2 ? inputs[2].value : 0.0f};
+            outputs[i].push_back(constant(evaluateOp(op, values)));
+            plan->m_stats.foldedNodes++;
+            continue;
+        }
+        if (op == NodeOp::SELECT && inputs[0].kind == Operand::Kind::CONSTANT) {
+            outputs[i].push_back(inputs[0].value != 0.0f ? inputs[1] : inputs[2]);
+            plan->m_stats.foldedNodes++;
+            continue;
+        }
+
+        if (op == NodeOp::CUSTOM) {
+            for (size_t p = 0; p < node.getOutputs().size(); ++p) {
+                outputs[i].push_back(temporary());
+            }
+            steps.push_back(Step{op, callInputs.size(), {}, {}, 0});
+            callInputs.push_back(inputs);
+            callOutputs.push_back(outputs[i]);
+            plan->m_customNodes.push_back(m_nodes[i]);
+            continue;
+        }
+
+        Step step{op, 0, temporary(), {}, inputs.size()};
+        for (size_t p = 0; p < inputs.size(); ++p) step.inputs[p] = inputs[p];
+        outputs[i].push_back(step.output);
+        steps.push_back(step);
+    }
+    steps.insert(steps.end(), writes.begin(), writes.end());
+
+    // Number the slots: variables, then the constants still in use, then temporaries
+    const size_t variableCount = plan->m_variables.size();
+    std::vector<float> constants;
+    std::unordered_map<uint32_t, size_t> constantIndex;
+    auto constantSlot = [&](float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        auto it = constantIndex.find(bits);
+        if (it != constantIndex.end()) return it->second;
+        constants.push_back(value);
+        constantIndex[bits] = constants.size() - 1;
+        return constants.size() - 1;
+    };
+    for (const Step& step : steps) {
+        const Operand* inputs =
+            step.op == NodeOp::CUSTOM ? callInputs[step.call].data() : step.inputs;
+        size_t inputCount =
+            step.op == NodeOp::CUSTOM ? callInputs[step.call].size() : step.inputCount;
+        for (size_t p = 0; p < inputCount; ++p) {
+            if (inputs[p].kind == Operand::Kind::CONSTANT) constantSlot(inputs[p].value);
+        }
+    }
+    const size_t slotCount = variableCount + constants.size() + temporaries;
+    if (slotCount > MAX_SLOTS) return fail("graph needs too many value slots");
+
+    auto slotOf = [&](const Operand& operand) {
+        switch (operand.kind) {
+            case Operand::Kind::VARIABLE: return static_cast<uint16_t>(operand.index);
+            case Operand::Kind::CONSTANT:
+                return static_cast<uint16_t>(variableCount + constantSlot(operand.value));
+            default:
+                return static_cast<uint16_t>(variableCount + constants.size() + operand.index);
+        }
+    };
+
+    for (const Step& step : steps) {
+        PlanInstruction ins;
+        ins.op = step.op;
+        if (step.op == NodeOp::CUSTOM) {
+            VisualScriptPlan::Call call;
+            call.node = plan->m_customNodes[plan->m_calls.size()].get();
+            for (const Operand& operand : callInputs[step.call]) {
+                call.inputs.push_back(slotOf(operand));
+            }
+            for (const Operand& operand : callOutputs[step.call]) {
+                call.outputs.push_back(slotOf(operand));
+            }
+            ins.output = static_cast<uint16_t>(plan->m_calls.size());
+            ins.inputs[0] = ins.inputs[1] = ins.inputs[2] = 0;
+            plan->m_calls.push_back(std::move(call));
+        } else {
+            // Unused operands read slot 0, which always exists
+            ins.output = slotOf(step.output);
+            for (size_t p = 0; p < 3; ++p) {
+                ins.inputs[p] = p < step.inputCount ? slotOf(step.inputs[p]) : 0;
+            }
+        }
+        plan->m_code.push_back(ins);
+    }
+
+    plan->m_initialValues.assign(slotCount, 0.0f);
+    for (size_t v = 0; v < variableCount; ++v) {
+        auto it = m_variableDefaults.find(plan->m_variables[v]);
+        if (it != m_variableDefaults.end()) plan->m_initialValues[v] = it->second;
+    }
+    std::copy(constants.begin(), constants.end(), plan->m_initialValues.begin() + variableCount);
+    plan->m_stats.instructions = plan->m_code.size();
+    plan->m_stats.slots = slotCount;
+
+    // The script's own instance keeps the values of variables that survive the recompile
+    std::vector<float> values = plan->m_initialValues;
+    if (previous) {
+        for (size_t v = 0; v < variableCount; ++v) {
+            int old = previous->getVariableSlot(plan->m_variables[v]);
+            if (old >= 0) values[v] = m_values[old];
+        }
+    }
+    m_values = std::move(values);
+    m_plan = std::move(plan);
     return true;
 }
 
+// VisualScriptBatch implementation
+VisualScriptBatch::VisualScriptBatch(std::shared_ptr<const VisualScriptPlan> plan)
+    : m_plan(std::move(plan)), m_count(0), m_capacity(0), m_jobSystem(nullptr) {
+}
+
+void VisualScriptBatch::grow() {
+    const size_t slots = m_plan->getSlotCount();
+    const size_t capacity = std::max<size_t>(BLOCK_INSTANCES, m_capacity * 2);
+    std::vector<float> values(slots * capacity);
+    for (size_t s = 0; s < slots; ++s) {
+        std::copy(m_values.begin() + s * m_capacity, m_values.begin() + s * m_capacity + m_count,
+                  values.begin() + s * capacity);
+    }
+    m_values = std::move(values);
+    m_capacity = capacity;
+}
+
+size_t VisualScriptBatch::addInstance() {
+    if (m_count == m_capacity) grow();
+    const std::vector<float>& initial = m_plan->getInitialValues();
+    for (size_t s = 0; s < initial.size(); ++s) {
+        m_values[s * m_capacity + m_count] = initial[s];
+    }
+    return m_count++;
+}
+
+void VisualScriptBatch::removeInstance(size_t index) {
+    if (index >= m_count) return;
+    const size_t last = m_count - 1;
+    for (size_t s = 0; s < m_plan->getSlotCount(); ++s) {
+        m_values[s * m_capacity + index] = m_values[s * m_capacity + last];
+    }
+    m_count--;
+}
+
+void VisualScriptBatch::execute() {
+    if (!m_jobSystem || m_count <= JOB_INSTANCES) {
+        m_plan->execute(m_values.data(), m_capacity, 0, m_count);
+        return;
+    }
+
+    // Instances are independent, one job per range
+    Threading::JobCounter counter;
+    const VisualScriptPlan* plan = m_plan.get();
+    float* values = m_values.data();
+    const size_t stride = m_capacity;
+    for (size_t first = 0; first < m_count; first += JOB_INSTANCES) {
+        const size_t count = std::min(JOB_INSTANCES, m_count - first);
+        m_jobSystem->dispatch(
+            [plan, values, stride, first, count]() {
+                plan->execute(values, stride, first, count);
+            },
+            counter);
+    }
+    m_jobSystem->wait(counter);
+}
+
 void VisualScriptingSystem::registerScript(const std::string& name, VisualScript* script) {
     m_scripts[name] = script;
 }
@@ -1,4 +1,43 @@
 #include "threading/ThreadPool.h"
+#include "profiler/PerformanceProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Fiber mode switches stacks with ucontext
+#if defined(__unix__) && !defined(__ANDROID__)
+#define JJM_JOB_FIBERS 1
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+// Sanitizers must be told about stack switches
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JJM_FIBER_ASAN 1
+#endif
+#if __has_feature(thread_sanitizer)
+#define JJM_FIBER_TSAN 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define JJM_FIBER_ASAN 1
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define JJM_FIBER_TSAN 1
+#endif
+#if defined(JJM_FIBER_ASAN)
+#include <sanitizer/common_interface_defs.h>
+#endif
+#if defined(JJM_FIBER_TSAN)
+#include <sanitizer/tsan_interface.h>
+#endif
+
+#if defined(_MSC_VER)
+#define JJM_NOINLINE __declspec(noinline)
+#else
+#define JJM_NOINLINE __attribute__((noinline))
+#endif
 
 namespace JJM {
 namespace Threading {
@@ -174,5 +213,1242 @@ void WorkStealingThreadPool::stop() {
     }
 }
 
+// TaskGraph
+
+namespace {
+
+// Weight of the newest measurement in a node's learned cost
+constexpr float COST_SMOOTHING = 0.25f;
+constexpr float MIN_NODE_COST = 0.1f;
+
+// Nodes within this fraction of the longest path count as critical
+constexpr float CRITICAL_TOLERANCE = 0.001f;
+
+TaskPriority boostPriority(TaskPriority priority) {
+    return priority == TaskPriority::Critical
+               ? priority
+               : static_cast<TaskPriority>(static_cast<int>(priority) - 1);
+}
+
+uint64_t microsSince(std::chrono::steady_clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+}
+
+} // namespace
+
+void TaskGraph::setCostEstimate(size_t nodeIndex, float micros) {
+    if (nodeIndex >= nodes.size()) return;
+    if (costs.size() < nodes.size()) costs.resize(nodes.size(), 1.0f);
+    
+    costs[nodeIndex] = std::max(micros, MIN_NODE_COST);
+    if (compiled) updateCriticalPath();
+}
+
+bool TaskGraph::compile() {
+    const size_t count = nodes.size();
+    
+    // Flatten the dependents
+    dependencyCounts.assign(count, 0);
+    dependentOffsets.assign(count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        dependencyCounts[i] = static_cast<uint32_t>(nodes[i].dependencyIndices.size());
+        dependentOffsets[i + 1] =
+            dependentOffsets[i] + static_cast<uint32_t>(nodes[i].dependentIndices.size());
+    }
+    dependents.resize(dependentOffsets[count]);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t* out = &dependents[dependentOffsets[i]];
+        for (size_t dependent : nodes[i].dependentIndices) {
+            *out++ = static_cast<uint32_t>(dependent);
+        }
+    }
+    
+    // Kahn's algorithm; nodes left over sit on a cycle
+    std::vector<uint32_t> remaining(dependencyCounts);
+    order.clear();
+    roots.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (remaining[i] == 0) {
+            order.push_back(static_cast<uint32_t>(i));
+            roots.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    for (size_t head = 0; head < order.size(); ++head) {
+        uint32_t current = order[head];
+        for (uint32_t k = dependentOffsets[current]; k < dependentOffsets[current + 1]; ++k) {
+            if (--remaining[dependents[k]] == 0) {
+                order.push_back(dependents[k]);
+            }
+        }
+    }
+    
+    compiled = (order.size() == count);
+    if (!compiled) {
+        order.clear();
+        return false;
+    }
+    
+    pendingCounts.reset(new std::atomic<uint32_t>[count]);
+    costs.resize(count, 1.0f);
+    topLevels.assign(count, 0.0f);
+    bottomLevels.assign(count, 0.0f);
+    runPriorities.assign(count, TaskPriority::Normal);
+    timings.assign(count, TaskGraphNodeTiming());
+    kickCount = 0;
+    
+    updateCriticalPath();
+    return true;
+}
+
+void TaskGraph::learnCosts() {
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        float measured = static_cast<float>(timings[i].endMicros - timings[i].startMicros);
+        costs[i] = std::max(costs[i] + (measured - costs[i]) * COST_SMOOTHING, MIN_NODE_COST);
+    }
+}
+
+void TaskGraph::updateCriticalPath() {
+    for (uint32_t node : order) {
+        float top = 0.0f;
+        for (size_t dependency : nodes[node].dependencyIndices) {
+            top = std::max(top, topLevels[dependency] + costs[dependency]);
+        }
+        topLevels[node] = top;
+    }
+    
+    criticalPathMicros = 0.0f;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        uint32_t node = *it;
+        float bottom = 0.0f;
+        for (uint32_t k = dependentOffsets[node]; k < dependentOffsets[node + 1]; ++k) {
+            bottom = std::max(bottom, bottomLevels[dependents[k]]);
+        }
+        bottomLevels[node] = costs[node] + bottom;
+        criticalPathMicros = std::max(criticalPathMicros, bottomLevels[node]);
+    }
+    
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        runPriorities[i] = isOnCriticalPath(i) ? boostPriority(nodes[i].priority)
+                                               : nodes[i].priority;
+    }
+    
+    // Dispatch the most critical sibling last, so its thread pops it next
+    auto lessCritical = [this](uint32_t a, uint32_t b) {
+        return bottomLevels[a] < bottomLevels[b];
+    };
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        std::sort(dependents.begin() + dependentOffsets[i],
+                  dependents.begin() + dependentOffsets[i + 1], lessCritical);
+    }
+    std::sort(roots.begin(), roots.end(), lessCritical);
+}
+
+bool TaskGraph::isOnCriticalPath(size_t nodeIndex) const {
+    if (!compiled || nodeIndex >= nodes.size()) return false;
+    return topLevels[nodeIndex] + bottomLevels[nodeIndex] >=
+           criticalPathMicros * (1.0f - CRITICAL_TOLERANCE);
+}
+
+void TaskGraph::exportTimeline(Utils::TimelineProfiler& profiler) const {
+    if (kickCount == 0) return;
+    
+    // Both sides count microseconds on the steady clock
+    const uint64_t kickMicros = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(kickTime.time_since_epoch())
+            .count());
+    const uint64_t frameStart = profiler.getCurrentFrame().frameStartTime;
+    const uint64_t offset = kickMicros > frameStart ? kickMicros - frameStart : 0;
+    
+    for (uint32_t node : order) {
+        const TaskGraphNodeTiming& timing = timings[node];
+        std::string trackName = timing.threadIndex < 0
+                                    ? std::string("Jobs: other threads")
+                                    : "Jobs: thread " + std::to_string(timing.threadIndex);
+        Utils::TimelineTrack* track = profiler.getTrack(trackName);
+        int trackId = track ? track->trackId : profiler.createTrack(trackName, "CPU");
+        
+        Utils::TimelineEvent event;
+        event.name = nodes[node].name;
+        event.category = "CPU";
+        event.startTime = offset + timing.startMicros;
+        event.endTime = offset + timing.endMicros;
+        event.threadId = timing.threadIndex;
+        event.depth = 0;
+        event.color = isOnCriticalPath(node) ? 0xFF3030FFu : 0x30A0FFFFu;
+        if (isOnCriticalPath(node)) event.details = "critical path";
+        profiler.addEvent(trackId, event);
+    }
+}
+
+// JobSystem
+
+namespace {
+
+// Which JobSystem context, if any, the calling thread owns. Systems are told apart by
+// instance ID rather than address, which a later system may reuse.
+struct ThreadState {
+    uint64_t jobSystemId = 0;
+    size_t contextIndex = 0;
+    JobSystem* workerSystem = nullptr;  // Set on worker threads only
+    void* fiber = nullptr;              // JobSystem::Fiber running on this thread
+};
+
+std::atomic<uint64_t> g_nextJobSystemId(1);
+thread_local ThreadState t_threadState;
+
+// A job suspended on one thread may resume on another, so code running on fibers must
+// never reuse a thread_local address computed before a switch. Going through an opaque
+// call every time keeps the compiler from caching it.
+JJM_NOINLINE ThreadState& threadState() {
+#if !defined(_MSC_VER)
+    asm volatile("" ::: "memory");
+#endif
+    return t_threadState;
+}
+
+// Free slots kept per thread before half are handed back to the shared pool
+constexpr size_t SLOT_CACHE_LIMIT = 128;
+constexpr size_t SLOT_CACHE_BATCH = 64;
+
+// Failed find attempts before an idle worker goes to sleep
+constexpr int IDLE_SPINS = 64;
+
+void lockDependents(std::atomic_flag& lock) {
+    while (lock.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+JobSystemConfig workerConfig(size_t numWorkers) {
+    JobSystemConfig config;
+    config.workerCount = numWorkers;
+    return config;
+}
+
+uint64_t elapsedMicros(std::chrono::high_resolution_clock::time_point start,
+                       std::chrono::high_resolution_clock::time_point end) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+// Relaxed counter bump for statistics written by a single thread
+void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// Job body for one task graph node; fits the job's inline storage
+struct JobSystem::GraphNodeJob {
+    JobSystem* system;
+    TaskGraph* graph;
+    uint32_t node;
+    
+    void operator()() const { system->runGraphNode(*graph, node); }
+};
+
+struct JobSystem::ThreadContext {
+    std::array<WorkStealingDeque<Job*>, NUM_PRIORITIES> queues;
+    std::vector<uint32_t> freeSlots;
+    WorkerThread* worker = nullptr;     // Null for the startup thread
+    uint32_t victimSeed = 0;
+};
+
+// A pooled stack with a guard page below it. The fiber loops in fiberMain for the life of
+// the system, so a new job only needs a switch, never a fresh context.
+struct JobSystem::Fiber {
+    // What the thread that resumed the fiber does once it is switched out
+    enum class Action { Release, Wait, Yield };
+    
+    JobSystem* system = nullptr;
+    uint32_t index = 0;
+    Job* job = nullptr;                 // Job to start on the next resume
+    Action action = Action::Release;
+    JobCounter* waitCounter = nullptr;
+    bool chainJobs = false;             // Keep taking new jobs instead of switching out
+    
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    void* stack = nullptr;
+    size_t stackSize = 0;
+    
+#if defined(JJM_JOB_FIBERS)
+    ucontext_t context;
+    ucontext_t* caller = nullptr;       // Switched back to on suspend; set by every resume
+#endif
+#if defined(JJM_FIBER_ASAN)
+    const void* callerStack = nullptr;
+    size_t callerStackSize = 0;
+#endif
+#if defined(JJM_FIBER_TSAN)
+    void* tsanFiber = nullptr;
+    void* tsanCaller = nullptr;
+#endif
+    
+    ~Fiber() {
+#if defined(JJM_FIBER_TSAN)
+        if (tsanFiber) __tsan_destroy_fiber(tsanFiber);
+#endif
+#if defined(JJM_JOB_FIBERS)
+        if (mapping) munmap(mapping, mappingSize);
+#endif
+    }
+};
+
+JobSystem::JobSystem(size_t numWorkers)
+    : JobSystem(workerConfig(numWorkers))
+{
+}
+
+JobSystem::JobSystem(const JobSystemConfig& config)
+    : instanceId(g_nextJobSystemId.fetch_add(1))
+    , injectedCount(0)
+    , jobBlocks(new std::atomic<Job*>[MAX_JOB_BLOCKS])
+    , jobBlockCount(0)
+    , running(false)
+    , pendingJobs(0)
+    , profilingEnabled(false)
+    , readyFiberCount(0)
+    , yieldedFiberCount(0)
+    , fiberSuspensions(0)
+    , inlineJobs(0)
+    , sleepingWorkers(0)
+    , wakeEpoch(0)
+{
+    size_t numWorkers = config.workerCount;
+    if (numWorkers == 0) {
+        numWorkers = std::max(1u, std::thread::hardware_concurrency() - 1);
+    }
+    
+    for (size_t i = 0; i < MAX_JOB_BLOCKS; ++i) {
+        jobBlocks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    
+    workers.resize(numWorkers);
+    for (size_t i = 0; i < numWorkers; ++i) {
+        workers[i] = std::make_unique<WorkerThread>();
+        workers[i]->threadIndex = i;
+        workers[i]->name = "Worker_" + std::to_string(i);
+    }
+    
+    contexts.resize(numWorkers + 1);
+    for (size_t i = 0; i <= numWorkers; ++i) {
+        contexts[i] = std::make_unique<ThreadContext>();
+        contexts[i]->worker = i < numWorkers ? workers[i].get() : nullptr;
+        contexts[i]->victimSeed = static_cast<uint32_t>(i * 2654435761u + 1);
+        contexts[i]->freeSlots.reserve(SLOT_CACHE_LIMIT + 1);
+    }
+    
+    if (config.useFibers && config.fiberCount > 0 && isFiberModeSupported()) {
+        createFibers(config.fiberCount, config.fiberStackSize);
+    }
+}
+
+JobSystem::~JobSystem() {
+    shutdown();
+    
+    size_t blocks = jobBlockCount.load();
+    for (size_t i = 0; i < blocks; ++i) {
+        delete[] jobBlocks[i].load();
+    }
+}
+
+void JobSystem::startup() {
+    if (running.exchange(true)) return;
+    
+    // The starting thread owns the last context, so its submissions stay lock-free
+    ThreadState& state = threadState();
+    state.jobSystemId = instanceId;
+    state.contextIndex = workers.size();
+    
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->running = true;
+        workers[i]->thread = std::thread(&JobSystem::workerMain, this, i);
+    }
+}
+
+void JobSystem::shutdown() {
+    running = false;
+    for (auto& worker : workers) {
+        worker->running = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        ++wakeEpoch;
+        wakeCV.notify_all();
+    }
+    
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    
+    ThreadState& state = threadState();
+    if (state.jobSystemId == instanceId) {
+        state.jobSystemId = 0;
+    }
+}
+
+JobHandle JobSystem::submit(const JobDescriptor& desc) {
+    Job* job = allocateJob();
+    job->function.assign(desc.function);
+    job->priority = desc.priority;
+    job->canBeCancelled = desc.canBeCancelled;
+    job->name = desc.name;
+    
+    // Hold one extra count so the job can't start while dependencies are being linked
+    job->dependencyCount.store(1, std::memory_order_relaxed);
+    for (JobHandle dependency : desc.dependencies) {
+        Job* other = lookupJob(dependency);
+        if (!other) continue;
+        
+        lockDependents(other->dependentsLock);
+        if (other->getHandle() == dependency && !other->dependentsClosed) {
+            job->dependencyCount.fetch_add(1, std::memory_order_relaxed);
+            other->dependents.push_back(job);
+        }
+        other->dependentsLock.clear(std::memory_order_release);
+    }
+    
+    JobHandle handle = job->getHandle();
+    pendingJobs.fetch_add(1, std::memory_order_relaxed);
+    if (job->dependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        scheduleJob(job);
+    }
+    return handle;
+}
+
+JobHandle JobSystem::launch(Job* job) {
+    JobHandle handle = job->getHandle();
+    pendingJobs.fetch_add(1, std::memory_order_relaxed);
+    scheduleJob(job);
+    return handle;
+}
+
+std::vector<JobHandle> JobSystem::submitBatch(const std::vector<JobDescriptor>& descriptors) {
+    std::vector<JobHandle> handles;
+    handles.reserve(descriptors.size());
+    
+    for (const auto& desc : descriptors) {
+        handles.push_back(submit(desc));
+    }
+    
+    return handles;
+}
+
+std::vector<JobHandle> JobSystem::execute(TaskGraph& graph) {
+    if (!graph.isCompiled() && !graph.compile()) {
+        return {};
+    }
+    
+    std::vector<JobHandle> handles;
+    const auto& nodes = graph.getNodes();
+    handles.resize(nodes.size());
+    
+    // Create jobs for all nodes, dependencies first
+    for (size_t i : graph.getExecutionOrder()) {
+        JobDescriptor desc;
+        desc.name = nodes[i].name;
+        desc.function = nodes[i].function;
+        desc.priority = nodes[i].priority;
+        
+        // Convert dependency indices to handles
+        for (size_t depIdx : nodes[i].dependencyIndices) {
+            if (depIdx < handles.size() && handles[depIdx] != 0) {
+                desc.dependencies.push_back(handles[depIdx]);
+            }
+        }
+        
+        handles[i] = submit(desc);
+    }
+    
+    return handles;
+}
+
+bool JobSystem::kick(TaskGraph& graph, JobCounter& counter) {
+    if (!graph.isCompiled() && !graph.compile()) {
+        return false;
+    }
+    
+    if (graph.kickCount > 0) {
+        graph.learnCosts();
+        graph.updateCriticalPath();
+    }
+    
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        graph.pendingCounts[i].store(graph.dependencyCounts[i], std::memory_order_relaxed);
+    }
+    graph.kickCounter = &counter;
+    graph.kickTime = std::chrono::steady_clock::now();
+    ++graph.kickCount;
+    
+    for (uint32_t root : graph.roots) {
+        dispatch(GraphNodeJob{this, &graph, root}, counter, graph.runPriorities[root]);
+    }
+    return true;
+}
+
+void JobSystem::runGraphNode(TaskGraph& graph, uint32_t node) {
+    TaskGraphNodeTiming& timing = graph.timings[node];
+    const ThreadState& state = threadState();
+    timing.threadIndex = state.jobSystemId == instanceId ? static_cast<int>(state.contextIndex)
+                                                         : -1;
+    timing.startMicros = microsSince(graph.kickTime);
+    
+    std::exception_ptr failure;
+    const JobFunction& function = graph.nodes[node].function;
+    if (function) {
+        try {
+            function();
+        } catch (...) {
+            failure = std::current_exception();
+        }
+    }
+    timing.endMicros = microsSince(graph.kickTime);
+    
+    // Dependents run even after a failure so the graph always drains; the counter's
+    // waiter gets the exception
+    for (uint32_t k = graph.dependentOffsets[node]; k < graph.dependentOffsets[node + 1]; ++k) {
+        uint32_t dependent = graph.dependents[k];
+        if (graph.pendingCounts[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            dispatch(GraphNodeJob{this, &graph, dependent}, *graph.kickCounter,
+                     graph.runPriorities[dependent]);
+        }
+    }
+    
+    if (failure) std::rethrow_exception(failure);
+}
+
+void JobSystem::wait(JobHandle handle) {
+    Job* job = lookupJob(handle);
+    if (!job) return;
+    
+    // Help process jobs while waiting, or let a fiber poll between other jobs; a recycled
+    // slot means the job finished
+    Fiber* fiber = static_cast<Fiber*>(threadState().fiber);
+    if (fiber && fiber->system != this) fiber = nullptr;
+    
+    while (job->getHandle() == handle && !job->isComplete()) {
+        if (fiber) {
+            fiber->action = Fiber::Action::Yield;
+            suspendFiber(fiber);
+        } else if (!processOneJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::waitAll(const std::vector<JobHandle>& handles) {
+    for (JobHandle h : handles) {
+        wait(h);
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    waitForCounter(counter);
+    
+    if (counter.failed.load(std::memory_order_acquire)) {
+        std::exception_ptr failure = counter.failure;
+        counter.failure = nullptr;
+        counter.failed.store(false, std::memory_order_relaxed);
+        std::rethrow_exception(failure);
+    }
+}
+
+void JobSystem::waitIdle() {
+    while (pendingJobs.load(std::memory_order_acquire) > 0) {
+        if (!processOneJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::processOneJob() {
+    return runOne(currentContext(), false);
+}
+
+bool JobSystem::cancel(JobHandle handle) {
+    Job* job = lookupJob(handle);
+    if (!job || job->getHandle() != handle || !job->canBeCancelled) return false;
+    
+    // The job still passes through the queues so its dependents get released
+    for (JobStatus from : {JobStatus::Pending, JobStatus::Queued}) {
+        JobStatus expected = from;
+        if (job->status.compare_exchange_strong(expected, JobStatus::Cancelled)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+JobStatus JobSystem::getJobStatus(JobHandle handle) const {
+    Job* job = lookupJob(handle);
+    if (!job) return JobStatus::Completed;
+    
+    JobStatus status = job->getStatus();
+    return job->getHandle() == handle ? status : JobStatus::Completed;
+}
+
+size_t JobSystem::getPooledJobCount() const {
+    return jobBlockCount.load() * JOBS_PER_BLOCK;
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::getWorkerStats() const {
+    std::vector<WorkerStats> stats;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const auto& worker = workers[i];
+        WorkerStats ws;
+        ws.threadIndex = worker->threadIndex;
+        ws.name = worker->name;
+        ws.jobsExecuted = worker->jobsExecuted.load();
+        ws.jobsStolen = worker->jobsStolen.load();
+        ws.totalExecutionTimeMicros = worker->totalExecutionTimeMicros.load();
+        ws.idleTimeMicros = worker->idleTimeMicros.load();
+        ws.stealAttempts = worker->stealAttempts.load();
+        ws.successfulSteals = worker->successfulSteals.load();
+        ws.localQueueSize = 0;
+        for (const auto& queue : contexts[i]->queues) {
+            ws.localQueueSize += queue.size();
+        }
+        ws.efficiency = worker->getEfficiency();
+        ws.avgJobTimeMicros = worker->getAverageJobTime();
+        stats.push_back(ws);
+    }
+    return stats;
+}
+
+bool JobSystem::isFiberModeSupported() {
+#if defined(JJM_JOB_FIBERS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+JobSystem::FiberStats JobSystem::getFiberStats() const {
+    FiberStats stats{};
+    stats.fiberCount = fibers.size();
+    stats.suspensions = fiberSuspensions.load(std::memory_order_relaxed);
+    stats.inlineJobs = inlineJobs.load(std::memory_order_relaxed);
+    
+    std::lock_guard<std::mutex> lock(fiberMutex);
+    stats.freeFibers = freeFibers.size();
+    stats.readyFibers = readyFibers.size();
+    return stats;
+}
+
+JobSystem::SystemMetrics JobSystem::getSystemMetrics() const {
+    SystemMetrics metrics{};
+    
+    for (const auto& worker : workers) {
+        metrics.totalJobsExecuted += worker->jobsExecuted.load();
+        metrics.totalJobsStolen += worker->jobsStolen.load();
+        metrics.totalExecutionTimeMicros += worker->totalExecutionTimeMicros.load();
+        metrics.totalIdleTimeMicros += worker->idleTimeMicros.load();
+        metrics.averageEfficiency += worker->getEfficiency();
+        
+        uint64_t attempts = worker->stealAttempts.load();
+        uint64_t successes = worker->successfulSteals.load();
+        if (attempts > 0) {
+            metrics.stealSuccessRate += static_cast<double>(successes) / attempts;
+        }
+    }
+    
+    if (!workers.empty()) {
+        metrics.averageEfficiency /= workers.size();
+        metrics.stealSuccessRate /= workers.size();
+    }
+    
+    metrics.activeJobs = pendingJobs.load();
+    metrics.queuedJobs = injectedCount.load();
+    for (const auto& context : contexts) {
+        for (const auto& queue : context->queues) {
+            metrics.queuedJobs += queue.size();
+        }
+    }
+    
+    return metrics;
+}
+
+JobSystem::ThreadContext* JobSystem::currentContext() const {
+    const ThreadState& state = threadState();
+    return state.jobSystemId == instanceId ? contexts[state.contextIndex].get() : nullptr;
+}
+
+Job* JobSystem::lookupJob(JobHandle handle) const {
+    uint32_t slot = static_cast<uint32_t>(handle);
+    size_t blockIndex = slot / JOBS_PER_BLOCK;
+    if (handle == 0 || blockIndex >= MAX_JOB_BLOCKS) return nullptr;
+    
+    Job* block = jobBlocks[blockIndex].load(std::memory_order_acquire);
+    return block ? &block[slot % JOBS_PER_BLOCK] : nullptr;
+}
+
+Job* JobSystem::allocateJob() {
+    ThreadContext* context = currentContext();
+    uint32_t slot;
+    
+    if (context) {
+        if (context->freeSlots.empty()) {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (freeSlots.empty()) growPool();
+            size_t take = std::min(SLOT_CACHE_BATCH, freeSlots.size());
+            context->freeSlots.insert(context->freeSlots.end(), freeSlots.end() - take,
+                                      freeSlots.end());
+            freeSlots.resize(freeSlots.size() - take);
+        }
+        slot = context->freeSlots.back();
+        context->freeSlots.pop_back();
+    } else {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (freeSlots.empty()) growPool();
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    
+    Job* job = &jobBlocks[slot / JOBS_PER_BLOCK].load(std::memory_order_relaxed)
+                    [slot % JOBS_PER_BLOCK];
+    job->status.store(JobStatus::Pending, std::memory_order_relaxed);
+    job->dependencyCount.store(0, std::memory_order_relaxed);
+    job->priority = TaskPriority::Normal;
+    job->canBeCancelled = true;
+    job->dependentsClosed = false;
+    job->counter = nullptr;
+    job->exception = nullptr;
+    if (!job->name.empty()) job->name.clear();
+    return job;
+}
+
+void JobSystem::growPool() {
+    size_t blockIndex = jobBlockCount.load(std::memory_order_relaxed);
+    if (blockIndex >= MAX_JOB_BLOCKS) {
+        throw std::runtime_error("JobSystem job pool exhausted");
+    }
+    
+    Job* block = new Job[JOBS_PER_BLOCK];
+    const uint32_t first = static_cast<uint32_t>(blockIndex * JOBS_PER_BLOCK);
+    for (size_t i = 0; i < JOBS_PER_BLOCK; ++i) {
+        block[i].slot = first + static_cast<uint32_t>(i);
+        block[i].handle.store((static_cast<JobHandle>(block[i].generation) << 32) | block[i].slot,
+                              std::memory_order_relaxed);
+    }
+    jobBlocks[blockIndex].store(block, std::memory_order_release);
+    jobBlockCount.store(blockIndex + 1, std::memory_order_release);
+    
+    // Hand out low slots first
+    for (size_t i = JOBS_PER_BLOCK; i > 0; --i) {
+        freeSlots.push_back(first + static_cast<uint32_t>(i - 1));
+    }
+}
+
+void JobSystem::releaseJob(Job* job) {
+    // A new generation invalidates every handle to the finished job
+    if (++job->generation == 0) job->generation = 1;
+    job->handle.store((static_cast<JobHandle>(job->generation) << 32) | job->slot,
+                      std::memory_order_release);
+    
+    ThreadContext* context = currentContext();
+    if (!context) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        freeSlots.push_back(job->slot);
+        return;
+    }
+    
+    context->freeSlots.push_back(job->slot);
+    if (context->freeSlots.size() > SLOT_CACHE_LIMIT) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        freeSlots.insert(freeSlots.end(), context->freeSlots.end() - SLOT_CACHE_BATCH,
+                         context->freeSlots.end());
+        context->freeSlots.resize(context->freeSlots.size() - SLOT_CACHE_BATCH);
+    }
+}
+
+void JobSystem::scheduleJob(Job* job) {
+    JobStatus expected = JobStatus::Pending;
+    job->status.compare_exchange_strong(expected, JobStatus::Queued, std::memory_order_relaxed);
+    
+    size_t priority = static_cast<size_t>(job->priority);
+    ThreadContext* context = currentContext();
+    if (context) {
+        // Push to local queue for better cache locality
+        context->queues[priority].push(job);
+    } else {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        injected[priority].push_back(job);
+        injectedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    
+    wakeWorkers();
+}
+
+void JobSystem::wakeWorkers() {
+    // Pairs with workerMain: either the sleeper's last look sees the new job, or this
+    // sees the sleeper and wakes it. The fence orders the queue push before the load.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepingWorkers.load(std::memory_order_seq_cst) == 0) return;
+    
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeEpoch.fetch_add(1, std::memory_order_relaxed);
+    wakeCV.notify_one();
+}
+
+Job* JobSystem::findJob(ThreadContext* context) {
+    Job* job = nullptr;
+    
+    if (context) {
+        for (auto& queue : context->queues) {
+            if (queue.pop(job)) return job;
+        }
+    }
+    
+    if (injectedCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(injectMutex);
+        for (auto& queue : injected) {
+            if (!queue.empty()) {
+                job = queue.front();
+                queue.pop_front();
+                injectedCount.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+    }
+    
+    // Steal, starting from a different victim each time to spread contention
+    const size_t count = contexts.size();
+    size_t start = 0;
+    if (context) {
+        context->victimSeed = context->victimSeed * 1664525u + 1013904223u;
+        start = context->victimSeed >> 16;
+    }
+    WorkerThread* thief = context ? context->worker : nullptr;
+    if (thief) bump(thief->stealAttempts);
+    
+    for (size_t i = 0; i < count; ++i) {
+        ThreadContext* victim = contexts[(start + i) % count].get();
+        if (victim == context) continue;
+        for (auto& queue : victim->queues) {
+            if (queue.steal(job)) {
+                if (thief) {
+                    bump(thief->successfulSteals);
+                    bump(thief->jobsStolen);
+                }
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::executeJob(Job* job, ThreadContext* context) {
+    JobStatus expected = JobStatus::Queued;
+    if (job->status.compare_exchange_strong(expected, JobStatus::Running,
+                                            std::memory_order_acquire)) {
+        const bool timed = profilingEnabled;
+        if (timed) job->startTime = std::chrono::high_resolution_clock::now();
+        
+        try {
+            job->function();
+            job->status.store(JobStatus::Completed, std::memory_order_release);
+        } catch (...) {
+            job->exception = std::current_exception();
+            if (job->counter) job->counter->fail(job->exception);
+            job->status.store(JobStatus::Failed, std::memory_order_release);
+        }
+        
+        // A job that waited on a fiber may have finished on another thread
+        if (!fibers.empty()) context = currentContext();
+        
+        if (timed) {
+            job->endTime = std::chrono::high_resolution_clock::now();
+            if (context && context->worker) {
+                bump(context->worker->totalExecutionTimeMicros,
+                     elapsedMicros(job->startTime, job->endTime));
+            }
+        }
+    }
+    
+    if (context && context->worker) {
+        bump(context->worker->jobsExecuted);
+    }
+    finishJob(job);
+}
+
+void JobSystem::finishJob(Job* job) {
+    job->function.reset();
+    
+    // Signal dependents
+    lockDependents(job->dependentsLock);
+    job->dependentsClosed = true;
+    for (Job* dependent : job->dependents) {
+        if (dependent->dependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            scheduleJob(dependent);
+        }
+    }
+    job->dependents.clear();
+    job->dependentsLock.clear(std::memory_order_release);
+    
+    // The counter may be destroyed by its waiter right after this
+    if (job->counter) {
+        job->counter->decrement();
+    }
+    
+    pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+    releaseJob(job);
+}
+
+bool JobSystem::runOne(ThreadContext* context, bool chainJobs) {
+    // Fibers whose waits are over go first, then new jobs, then fibers polling a handle
+    Fiber* fiber = fibers.empty() ? nullptr : takeResumableFiber(false);
+    if (fiber) {
+        resumeFiber(fiber, chainJobs);
+        return true;
+    }
+    
+    Job* job = findJob(context);
+    if (job) {
+        startJob(job, context, chainJobs);
+        return true;
+    }
+    
+    fiber = fibers.empty() ? nullptr : takeResumableFiber(true);
+    if (fiber) {
+        resumeFiber(fiber, chainJobs);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::startJob(Job* job, ThreadContext* context, bool chainJobs) {
+    Fiber* fiber = fibers.empty() ? nullptr : acquireFiber();
+    if (!fiber) {
+        // Without a free fiber the job runs on this stack, and its waits help instead
+        if (!fibers.empty()) inlineJobs.fetch_add(1, std::memory_order_relaxed);
+        executeJob(job, context);
+        return;
+    }
+    
+    fiber->job = job;
+    resumeFiber(fiber, chainJobs);
+}
+
+void JobSystem::waitForCounter(JobCounter& counter) {
+    Fiber* fiber = static_cast<Fiber*>(threadState().fiber);
+    if (fiber && fiber->system == this) {
+        // Woken by the decrement that empties the counter, or straight away if it
+        // emptied while the fiber was switching out
+        while (!counter.isDone()) {
+            fiber->action = Fiber::Action::Wait;
+            fiber->waitCounter = &counter;
+            suspendFiber(fiber);
+        }
+        return;
+    }
+    
+    while (!counter.isDone()) {
+        if (!processOneJob()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+#if defined(JJM_JOB_FIBERS)
+// Kept out of createFibers' loop: getcontext returns like setjmp, so locals live across it
+// there could be clobbered
+void JobSystem::initFiberContext(Fiber* fiber) {
+    getcontext(&fiber->context);
+    fiber->context.uc_stack.ss_sp = fiber->stack;
+    fiber->context.uc_stack.ss_size = fiber->stackSize;
+    fiber->context.uc_link = nullptr;
+    
+    // makecontext only passes ints, so the fiber pointer goes in two halves
+    uint64_t address = reinterpret_cast<uintptr_t>(fiber);
+    makecontext(&fiber->context, reinterpret_cast<void (*)()>(&JobSystem::fiberEntry), 2,
+                static_cast<unsigned int>(address >> 32),
+                static_cast<unsigned int>(address & 0xFFFFFFFFu));
+}
+#endif
+
+void JobSystem::createFibers(size_t count, size_t stackSize) {
+#if defined(JJM_JOB_FIBERS)
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    stackSize = std::max<size_t>(stackSize, 4 * page);
+    stackSize = (stackSize + page - 1) / page * page;
+    
+    fibers.reserve(count);
+    freeFibers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto fiber = std::make_unique<Fiber>();
+        fiber->system = this;
+        fiber->index = static_cast<uint32_t>(i);
+        
+        fiber->mappingSize = stackSize + page;
+        void* mapping = mmap(nullptr, fiber->mappingSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("JobSystem could not allocate fiber stacks");
+        }
+        fiber->mapping = mapping;
+        mprotect(mapping, page, PROT_NONE);
+        fiber->stack = static_cast<char*>(mapping) + page;
+        fiber->stackSize = stackSize;
+        initFiberContext(fiber.get());
+#if defined(JJM_FIBER_TSAN)
+        fiber->tsanFiber = __tsan_create_fiber(0);
+#endif
+        
+        freeFibers.push_back(fiber.get());
+        fibers.push_back(std::move(fiber));
+    }
+#else
+    (void)count;
+    (void)stackSize;
+#endif
+}
+
+JobSystem::Fiber* JobSystem::acquireFiber() {
+    std::lock_guard<std::mutex> lock(fiberMutex);
+    if (freeFibers.empty()) return nullptr;
+    
+    Fiber* fiber = freeFibers.back();
+    freeFibers.pop_back();
+    return fiber;
+}
+
+JobSystem::Fiber* JobSystem::takeResumableFiber(bool includeYielded) {
+    if (readyFiberCount.load(std::memory_order_relaxed) == 0 &&
+        (!includeYielded || yieldedFiberCount.load(std::memory_order_relaxed) == 0)) {
+        return nullptr;
+    }
+    
+    std::lock_guard<std::mutex> lock(fiberMutex);
+    Fiber* fiber = nullptr;
+    if (!readyFibers.empty()) {
+        fiber = readyFibers.front();
+        readyFibers.pop_front();
+        readyFiberCount.fetch_sub(1, std::memory_order_relaxed);
+    } else if (includeYielded && !yieldedFibers.empty()) {
+        fiber = yieldedFibers.front();
+        yieldedFibers.pop_front();
+        yieldedFiberCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return fiber;
+}
+
+// Never inlined: the caller's thread_local addresses are stale once a fiber migrates
+JJM_NOINLINE void JobSystem::resumeFiber(Fiber* fiber, bool chainJobs) {
+#if defined(JJM_JOB_FIBERS)
+    void* previous = threadState().fiber;
+    ucontext_t self;
+    fiber->caller = &self;
+    fiber->chainJobs = chainJobs;
+    threadState().fiber = fiber;
+    
+#if defined(JJM_FIBER_ASAN)
+    void* fakeStack = nullptr;
+    __sanitizer_start_switch_fiber(&fakeStack, fiber->stack, fiber->stackSize);
+#endif
+#if defined(JJM_FIBER_TSAN)
+    fiber->tsanCaller = __tsan_get_current_fiber();
+    __tsan_switch_to_fiber(fiber->tsanFiber, 0);
+#endif
+    swapcontext(&self, &fiber->context);
+#if defined(JJM_FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(fakeStack, nullptr, nullptr);
+#endif
+    
+    threadState().fiber = previous;
+    
+    // The fiber's context is saved now, so it is safe to hand it to other threads
+    switch (fiber->action) {
+        case Fiber::Action::Release: {
+            std::lock_guard<std::mutex> lock(fiberMutex);
+            freeFibers.push_back(fiber);
+            break;
+        }
+        case Fiber::Action::Wait:
+            registerWaiter(fiber);
+            break;
+        case Fiber::Action::Yield: {
+            std::lock_guard<std::mutex> lock(fiberMutex);
+            yieldedFibers.push_back(fiber);
+            yieldedFiberCount.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+    }
+#else
+    (void)fiber;
+    (void)chainJobs;
+#endif
+}
+
+JJM_NOINLINE void JobSystem::suspendFiber(Fiber* fiber) {
+#if defined(JJM_JOB_FIBERS)
+#if defined(JJM_FIBER_ASAN)
+    void* fakeStack = nullptr;
+    __sanitizer_start_switch_fiber(&fakeStack, fiber->callerStack, fiber->callerStackSize);
+#endif
+#if defined(JJM_FIBER_TSAN)
+    __tsan_switch_to_fiber(fiber->tsanCaller, 0);
+#endif
+    swapcontext(&fiber->context, fiber->caller);
+#if defined(JJM_FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(fakeStack, &fiber->callerStack, &fiber->callerStackSize);
+#endif
+#else
+    (void)fiber;
+#endif
+}
+
+void JobSystem::registerWaiter(Fiber* fiber) {
+    JobCounter& counter = *fiber->waitCounter;
+    const uint64_t waiterBits = static_cast<uint64_t>(fiber->index + 1) << 32;
+    
+    uint64_t state = counter.state.load(std::memory_order_acquire);
+    for (;;) {
+        if ((state & JobCounter::COUNT_MASK) == 0) {
+            makeFiberReady(fiber);
+            return;
+        }
+        if ((state >> 32) != 0) {
+            // Another fiber holds the waiter slot; poll between jobs instead
+            std::lock_guard<std::mutex> lock(fiberMutex);
+            yieldedFibers.push_back(fiber);
+            yieldedFiberCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        
+        counter.waitingSystem = this;
+        if (counter.state.compare_exchange_weak(state, state | waiterBits,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            fiberSuspensions.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void JobSystem::makeFiberReady(Fiber* fiber) {
+    {
+        std::lock_guard<std::mutex> lock(fiberMutex);
+        readyFibers.push_back(fiber);
+        readyFiberCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeWorkers();
+}
+
+void JobSystem::fiberMain(Fiber* fiber) {
+    for (;;) {
+        executeJob(fiber->job, currentContext());
+        fiber->job = nullptr;
+        
+        // Workers run job after job on one fiber and only switch out to resume a waiter
+        while (fiber->chainJobs && readyFiberCount.load(std::memory_order_relaxed) == 0) {
+            ThreadContext* context = currentContext();
+            Job* job = findJob(context);
+            if (!job) break;
+            executeJob(job, context);
+        }
+        
+        fiber->action = Fiber::Action::Release;
+        suspendFiber(fiber);
+    }
+}
+
+void JobSystem::fiberEntry(unsigned int high, unsigned int low) {
+    Fiber* fiber = reinterpret_cast<Fiber*>((static_cast<uintptr_t>(high) << 32) | low);
+#if defined(JJM_FIBER_ASAN)
+    __sanitizer_finish_switch_fiber(nullptr, &fiber->callerStack, &fiber->callerStackSize);
+#endif
+    fiber->system->fiberMain(fiber);
+}
+
+void JobSystem::waitOnCallingThread(JobCounter& counter) {
+    ThreadState& state = threadState();
+    JobSystem* system = state.fiber ? static_cast<Fiber*>(state.fiber)->system
+                                    : state.workerSystem;
+    if (system) {
+        system->waitForCounter(counter);
+        return;
+    }
+    
+    while (!counter.isDone()) {
+        std::this_thread::yield();
+    }
+}
+
+void JobSystem::resumeWaiter(JobSystem* system, uint32_t fiberIndex) {
+    system->makeFiberReady(system->fibers[fiberIndex].get());
+}
+
+void JobSystem::workerMain(size_t threadIndex) {
+    ThreadState& state = threadState();
+    state.jobSystemId = instanceId;
+    state.contextIndex = threadIndex;
+    state.workerSystem = this;
+    
+    auto& worker = *workers[threadIndex];
+    ThreadContext* context = contexts[threadIndex].get();
+    int idleSpins = 0;
+    
+    while (worker.running.load(std::memory_order_relaxed)) {
+        if (runOne(context, true)) {
+            idleSpins = 0;
+            continue;
+        }
+        
+        if (++idleSpins < IDLE_SPINS) {
+            std::this_thread::yield();
+            continue;
+        }
+        
+        // Announce the sleep, then look once more before blocking
+        auto idleStart = std::chrono::high_resolution_clock::now();
+        sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        uint64_t epoch = wakeEpoch.load(std::memory_order_relaxed);
+        Job* job = findJob(context);
+        if (!job && readyFiberCount.load(std::memory_order_seq_cst) == 0) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCV.wait(lock, [&] {
+                return wakeEpoch.load(std::memory_order_relaxed) != epoch ||
+                       !worker.running.load(std::memory_order_relaxed);
+            });
+        }
+        sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        bump(worker.idleTimeMicros,
+             elapsedMicros(idleStart, std::chrono::high_resolution_clock::now()));
+        
+        idleSpins = 0;
+        if (job) {
+            startJob(job, context, true);
+        }
+    }
+    
+    state = ThreadState();
+}
+
+// JobCounter
+
+void JobCounter::decrement() {
+    // Emptying the counter clears the waiter slot in the same step, and whoever empties
+    // it resumes the waiter. With no waiter, this is the last access to the counter.
+    uint64_t current = state.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        next = (current & COUNT_MASK) == 1 ? 0 : current - 1;
+    } while (!state.compare_exchange_weak(current, next, std::memory_order_acq_rel,
+                                          std::memory_order_relaxed));
+    
+    if (next == 0 && (current >> 32) != 0) {
+        JobSystem::resumeWaiter(waitingSystem, static_cast<uint32_t>((current >> 32) - 1));
+    }
+}
+
+void JobCounter::wait() {
+    JobSystem::waitOnCallingThread(*this);
+}
+
 } // namespace Threading
 } // namespace JJM
@@ -0,0 +1,223 @@
+// Asset bundle benchmark for Core::AssetBundle: 1000 assets of 1 KB to 128 KB (log-uniform
+// sizes, half compressible, half noise) loaded from loose files, from an uncompressed bundle
+// through in-place views of the mapped file, and from an LZ4 bundle decompressed serially and
+// with chunks spread over a JobSystem. Cold runs drop the files from the page cache first;
+// every run must read back the same bytes
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_asset_bundle.cpp src/core/AssetBundle.cpp
+//            src/threading/ThreadPool.cpp src/profiler/PerformanceProfiler.cpp -lpthread
+//            -o bench_asset_bundle
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../include/core/AssetBundle.h"
+#include "../include/threading/ThreadPool.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr size_t ASSETS = 1000;
+constexpr size_t MIN_SIZE = 1024;
+constexpr size_t MAX_SIZE = 128 * 1024;
+constexpr float COMPRESSIBLE = 0.5f;
+constexpr size_t WORKERS = 4;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+struct Result {
+    double coldMs = 0.0;
+    double warmMs = 0.0;
+    uint64_t sum = 0;
+};
+
+// Text-like bytes from a small vocabulary, or noise
+std::vector<uint8_t> makeAsset(std::mt19937& random, bool compressible) {
+    std::uniform_real_distribution<double> exponent(std::log(MIN_SIZE), std::log(MAX_SIZE));
+    std::vector<uint8_t> data(static_cast<size_t>(std::exp(exponent(random))));
+    static const char* words[] = {"vertex ", "normal ", "0.125 ", "texcoord ", "-1.0 ", "face ",
+                                  "index ",  "weight ", "bone ",  "\n"};
+    size_t i = 0;
+    while (i < data.size()) {
+        if (compressible) {
+            const char* word = words[random() % 10];
+            for (; *word && i < data.size(); ++word) data[i++] = static_cast<uint8_t>(*word);
+        } else {
+            data[i++] = static_cast<uint8_t>(random());
+        }
+    }
+    return data;
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    std::fwrite(data.data(), 1, data.size(), file);
+    std::fclose(file);
+}
+
+// Flushed, then evicted from the page cache so the next read goes to the device
+void dropFromCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+#if defined(__linux__)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+    close(fd);
+}
+
+uint64_t sumBytes(const uint8_t* data, size_t size) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; ++i) sum += data[i];
+    return sum;
+}
+
+std::string assetId(size_t index) { return "asset" + std::to_string(index); }
+
+uint64_t loadLoose(const std::vector<std::string>& paths) {
+    uint64_t sum = 0;
+    std::vector<uint8_t> buffer;
+    for (const std::string& path : paths) {
+        FILE* file = std::fopen(path.c_str(), "rb");
+        std::fseek(file, 0, SEEK_END);
+        buffer.resize(static_cast<size_t>(std::ftell(file)));
+        std::fseek(file, 0, SEEK_SET);
+        size_t read = std::fread(buffer.data(), 1, buffer.size(), file);
+        std::fclose(file);
+        sum += sumBytes(buffer.data(), read);
+    }
+    return sum;
+}
+
+uint64_t loadViews(const std::string& path) {
+    Core::AssetBundle bundle;
+    if (!bundle.loadFromFile(path)) return 0;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < ASSETS; ++i) {
+        Core::BundleAssetView view = bundle.getAssetView(assetId(i));
+        sum += sumBytes(view.data, view.size);
+    }
+    return sum;
+}
+
+uint64_t loadDecompressed(const std::string& path, Threading::JobSystem* jobSystem) {
+    Core::AssetBundle bundle;
+    if (!bundle.loadFromFile(path)) return 0;
+    bundle.setJobSystem(jobSystem);
+    uint64_t sum = 0;
+    std::vector<uint8_t> buffer(MAX_SIZE);
+    for (size_t i = 0; i < ASSETS; ++i) {
+        const Core::BundleAssetEntry* entry = bundle.getAssetEntry(assetId(i));
+        if (!bundle.readAsset(assetId(i), buffer.data(), buffer.size())) return 0;
+        sum += sumBytes(buffer.data(), entry->uncompressedSize);
+    }
+    return sum;
+}
+
+template <typename Load>
+Result measure(const std::vector<std::string>& files, Load load) {
+    Result result;
+    for (const std::string& file : files) dropFromCache(file);
+    Timer cold;
+    result.sum = load();
+    result.coldMs = cold.elapsedMs();
+    Timer warm;
+    uint64_t warmSum = load();
+    result.warmMs = warm.elapsedMs();
+    if (warmSum != result.sum) result.sum = 0;
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << "    " << name << ": cold " << result.coldMs << " ms, warm " << result.warmMs
+              << " ms" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    char directoryTemplate[] = "/tmp/bench_asset_bundle_XXXXXX";
+    if (!mkdtemp(directoryTemplate)) {
+        std::cerr << "Could not create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string directory = directoryTemplate;
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<std::string> loosePaths;
+    Core::BundleBuilder stored, compressed;
+    stored.setCompression(Core::BundleCompression::None);
+    compressed.setCompression(Core::BundleCompression::LZ4);
+    size_t totalBytes = 0;
+    uint64_t expectedSum = 0;
+    for (size_t i = 0; i < ASSETS; ++i) {
+        std::vector<uint8_t> data = makeAsset(random, unit(random) < COMPRESSIBLE);
+        loosePaths.push_back(directory + "/" + assetId(i) + ".bin");
+        writeFile(loosePaths.back(), data);
+        stored.addAsset(assetId(i), loosePaths.back(), "Blob");
+        compressed.addAsset(assetId(i), loosePaths.back(), "Blob");
+        totalBytes += data.size();
+        expectedSum += sumBytes(data.data(), data.size());
+    }
+    const std::string storedPath = directory + "/stored.bundle";
+    const std::string compressedPath = directory + "/lz4.bundle";
+    Timer buildTimer;
+    bool built = stored.build(storedPath) && compressed.build(compressedPath);
+    const double buildMs = buildTimer.elapsedMs();
+
+    std::cout << "Asset bundle benchmark (" << ASSETS << " assets, " << totalBytes / 1024
+              << " KB, " << COMPRESSIBLE * 100 << "% compressible, " << WORKERS << " workers)"
+              << std::endl;
+    std::cout << "    bundles built in " << buildMs << " ms, LZ4 bundle at "
+              << compressed.getLastBuildStats().compressionRatio * 100 << "% of the data"
+              << std::endl;
+
+    Threading::JobSystem jobSystem(WORKERS);
+    Result loose = measure(loosePaths, [&]() { return loadLoose(loosePaths); });
+    report("loose files, fopen/fread", loose);
+    Result views = measure({storedPath}, [&]() { return loadViews(storedPath); });
+    report("uncompressed bundle, mapped views", views);
+    Result serial = measure({compressedPath}, [&]() {
+        return loadDecompressed(compressedPath, nullptr);
+    });
+    report("LZ4 bundle, serial decompression", serial);
+    Result parallel = measure({compressedPath}, [&]() {
+        return loadDecompressed(compressedPath, &jobSystem);
+    });
+    report("LZ4 bundle, chunks on workers", parallel);
+
+    for (const std::string& path : loosePaths) std::remove(path.c_str());
+    std::remove(storedPath.c_str());
+    std::remove(compressedPath.c_str());
+    rmdir(directory.c_str());
+
+    bool consistent = built && loose.sum == expectedSum && views.sum == expectedSum &&
+                      serial.sum == expectedSum && parallel.sum == expectedSum;
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: a bundle could not be built or loaded, or "
+                     "a load read back different bytes than were written"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
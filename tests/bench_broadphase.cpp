@@ -0,0 +1,164 @@
+// Broad phase benchmark for Physics::PhysicsWorld: candidate pairs and step time per
+// broad phase from 1k to 50k bodies
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_broadphase.cpp src/physics/PhysicsWorld.cpp
+//            src/physics/BodyStore.cpp src/physics/IslandSolver.cpp src/physics/Joints.cpp
+//            src/physics/Constraints.cpp src/physics/BroadPhase.cpp src/physics/Collider.cpp
+//            src/physics/PhysicsBody.cpp src/ecs/EntityManager.cpp src/ecs/Entity.cpp
+//            src/ecs/ArchetypeStorage.cpp src/ecs/SystemScheduler.cpp
+//            src/profiler/PerformanceProfiler.cpp src/threading/ThreadPool.cpp
+//            src/math/Vector2D.cpp src/memory/MemoryPool.cpp -lpthread -o bench_broadphase
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../include/physics/PhysicsWorld.h"
+
+using namespace JJM;
+using namespace JJM::Physics;
+
+// PhysicsWorld owns a SpatialHashGrid that no translation unit implements yet
+SpatialHashGrid::~SpatialHashGrid() = default;
+
+namespace {
+
+constexpr size_t BODY_COUNTS[] = {1000, 5000, 10000, 25000, 50000};
+constexpr size_t BRUTE_FORCE_LIMIT = 5000;
+constexpr int MEASURED_STEPS = 10;
+constexpr float TIME_STEP = 1.0f / 60.0f;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+const char* broadphaseName(BroadphaseType type) {
+    switch (type) {
+        case BroadphaseType::BRUTE_FORCE:
+            return "brute force";
+        case BroadphaseType::AABB_TREE:
+            return "AABB tree";
+        case BroadphaseType::SWEEP_AND_PRUNE:
+            return "sweep and prune";
+    }
+    return "?";
+}
+
+// staticPerTen of every ten bodies are static boxes, the rest small moving circles; density
+// stays constant as count grows
+void populate(ECS::EntityManager& manager, size_t count, size_t staticPerTen) {
+    std::mt19937 rng(42);
+    const float extent = std::sqrt(static_cast<float>(count)) * 20.0f;
+    std::uniform_real_distribution<float> position(0.0f, extent);
+    std::uniform_real_distribution<float> speed(-60.0f, 60.0f);
+
+    for (size_t i = 0; i < count; ++i) {
+        ECS::Entity* entity = manager.createEntity();
+        auto* body = entity->addComponent<PhysicsBody>(
+            Math::Vector2D(position(rng), position(rng)), 1.0f);
+        if (i % 10 < staticPerTen) {
+            body->setBodyType(BodyType::STATIC);
+            entity->addComponent<BoxCollider>(16.0f, 16.0f);
+        } else {
+            body->setVelocity(Math::Vector2D(speed(rng), speed(rng)));
+            entity->addComponent<CircleCollider>(4.0f);
+        }
+    }
+}
+
+struct Result {
+    double stepMs = 0.0;
+    double broadphaseMs = 0.0;
+    double narrowphaseMs = 0.0;
+    int potentialPairs = 0;
+    int firstStepCollisions = 0;
+};
+
+Result run(BroadphaseType type, size_t count, size_t staticPerTen) {
+    ECS::EntityManager manager;
+    manager.reserve(count);
+    populate(manager, count, staticPerTen);
+
+    PhysicsWorld world(&manager);
+    world.setGravity(Math::Vector2D(0.0f, 0.0f));
+    world.setBroadphaseType(type);
+
+    Result result;
+    world.update(TIME_STEP);  // Builds the broad phase structure
+    result.firstStepCollisions = world.getBroadphaseStats().actualCollisions;
+
+    for (int step = 0; step < MEASURED_STEPS; ++step) {
+        Timer timer;
+        world.update(TIME_STEP);
+        result.stepMs += timer.elapsedMs();
+
+        PhysicsWorld::BroadphaseStats stats = world.getBroadphaseStats();
+        result.broadphaseMs += stats.broadphaseTimeMs;
+        result.narrowphaseMs += stats.narrowphaseTimeMs;
+        result.potentialPairs += stats.potentialPairs;
+    }
+
+    result.stepMs /= MEASURED_STEPS;
+    result.broadphaseMs /= MEASURED_STEPS;
+    result.narrowphaseMs /= MEASURED_STEPS;
+    result.potentialPairs /= MEASURED_STEPS;
+    return result;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "PhysicsWorld broad phase benchmark (" << MEASURED_STEPS << " steps each)"
+              << std::endl;
+
+    const BroadphaseType types[] = {BroadphaseType::BRUTE_FORCE, BroadphaseType::AABB_TREE,
+                                    BroadphaseType::SWEEP_AND_PRUNE};
+    const struct {
+        const char* name;
+        size_t staticPerTen;
+    } scenes[] = {{"mostly dynamic (10% static)", 1}, {"mostly static (90% static)", 9}};
+    bool consistent = true;
+
+    for (const auto& scene : scenes) {
+        std::cout << "Scene: " << scene.name << std::endl;
+
+        for (size_t count : BODY_COUNTS) {
+            std::cout << "  " << count << " bodies" << std::endl;
+            int expectedCollisions = -1;
+
+            for (BroadphaseType type : types) {
+                if (type == BroadphaseType::BRUTE_FORCE && count > BRUTE_FORCE_LIMIT) continue;
+
+                Result result = run(type, count, scene.staticPerTen);
+                std::cout << "    " << broadphaseName(type) << ": step " << result.stepMs
+                          << " ms (broad " << result.broadphaseMs << " ms, narrow "
+                          << result.narrowphaseMs << " ms), " << result.potentialPairs
+                          << " candidate pairs, " << result.firstStepCollisions
+                          << " collisions on first step" << std::endl;
+
+                // Every broad phase must hand the narrow phase the same contacts
+                if (expectedCollisions < 0) {
+                    expectedCollisions = result.firstStepCollisions;
+                } else if (result.firstStepCollisions != expectedCollisions) {
+                    consistent = false;
+                }
+            }
+        }
+    }
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: broad phases disagree" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Coroutine scheduler benchmark: 50,000 coroutines that mostly sleep for seconds at a time,
+// with some waiting a few frames, updated for ten seconds of 60 Hz frames. The scheduler's
+// timer wheels only touch coroutines that are due; the baseline polls every coroutine every
+// frame. Heap allocations during the steady-state updates are counted, and a burst of
+// coroutines waking on the same frame is spread over frames by a resume budget
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_coroutine_scheduler.cpp
+//            src/scripting/CoroutineScheduler.cpp src/scripting/ScriptEngine.cpp
+//            -o bench_coroutine_scheduler
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "../include/scripting/ScriptEngine.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int COROUTINES = 50000;
+constexpr int FRAMES = 600;
+constexpr int WARMUP_FRAMES = 60;
+constexpr float FRAME_TIME = 1.0f / 60.0f;
+constexpr int BURST = 20000;
+constexpr size_t BURST_BUDGET = 2000;
+constexpr int BURST_FRAMES = 120;
+
+size_t allocations = 0;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// One coroutine in ten waits a few frames, one in ten sleeps under a second, and the rest
+// sleep 5 to 60 seconds
+Scripting::YieldInstruction nextWait(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    const uint32_t r = seed >> 8;
+    switch (r % 10) {
+        case 0:
+            return Scripting::YieldInstruction::WaitForFrames(1 + static_cast<int>(r % 30));
+        case 1:
+            return Scripting::YieldInstruction::WaitForSeconds(0.1f + (r % 90) * 0.01f);
+        default:
+            return Scripting::YieldInstruction::WaitForSeconds(5.0f + (r % 5500) * 0.01f);
+    }
+}
+
+// The same coroutines, each checked every frame
+struct PolledCoroutine {
+    Scripting::CoroutineFunction function;
+    Scripting::YieldInstruction wait;
+    double yieldTime;
+    int yieldFrame;
+};
+
+size_t runPolling(double& ms) {
+    std::vector<PolledCoroutine> coroutines(COROUTINES);
+    std::vector<Scripting::CoroutineContext> contexts(COROUTINES);
+    size_t resumes = 0;
+    for (int i = 0; i < COROUTINES; ++i) {
+        uint32_t seed = static_cast<uint32_t>(i);
+        coroutines[i].function = [seed](Scripting::CoroutineContext&) mutable {
+            return nextWait(seed);
+        };
+        coroutines[i].wait = Scripting::YieldInstruction::WaitForNextFrame();
+        coroutines[i].yieldTime = 0.0;
+        coroutines[i].yieldFrame = 0;
+    }
+
+    double time = 0.0;
+    Timer timer;
+    for (int frame = 1; frame <= FRAMES; ++frame) {
+        time += FRAME_TIME;
+        for (int i = 0; i < COROUTINES; ++i) {
+            PolledCoroutine& coroutine = coroutines[i];
+            const Scripting::YieldInstruction& wait = coroutine.wait;
+            const bool due = wait.type == Scripting::YieldType::Seconds
+                                 ? time >= coroutine.yieldTime + wait.waitSeconds
+                                 : frame - coroutine.yieldFrame >= std::max(wait.waitFrames, 1);
+            if (!due) continue;
+            coroutine.wait = coroutine.function(contexts[i]);
+            coroutine.yieldTime = time;
+            coroutine.yieldFrame = frame;
+            resumes++;
+        }
+    }
+    ms = timer.elapsedMs();
+    return resumes;
+}
+
+size_t runScheduler(double& ms, size_t& steadyAllocations, size_t& steadyResumes) {
+    Scripting::CoroutineScheduler* scheduler = Scripting::CoroutineScheduler::getInstance();
+    scheduler->reserve(COROUTINES);
+    for (int i = 0; i < COROUTINES; ++i) {
+        uint32_t seed = static_cast<uint32_t>(i);
+        scheduler->startCoroutine([seed](Scripting::CoroutineContext&) mutable {
+            return nextWait(seed);
+        });
+    }
+
+    size_t resumes = 0;
+    size_t allocationsBefore = 0;
+    Timer timer;
+    for (int frame = 1; frame <= FRAMES; ++frame) {
+        if (frame == WARMUP_FRAMES + 1) allocationsBefore = allocations;
+        scheduler->update(FRAME_TIME);
+        resumes += scheduler->getStats().resumedLastFrame;
+        if (frame > WARMUP_FRAMES) steadyResumes += scheduler->getStats().resumedLastFrame;
+    }
+    ms = timer.elapsedMs();
+    steadyAllocations = allocations - allocationsBefore;
+
+    Scripting::CoroutineScheduler::cleanup();
+    return resumes;
+}
+
+// All coroutines wake together every half second
+bool runBurst(size_t& maxResumed, int& deferringFrames, size_t& resumes) {
+    Scripting::CoroutineScheduler* scheduler = Scripting::CoroutineScheduler::getInstance();
+    scheduler->setResumeBudget(BURST_BUDGET);
+    for (int i = 0; i < BURST; ++i) {
+        scheduler->startCoroutine([](Scripting::CoroutineContext&) {
+            return Scripting::YieldInstruction::WaitForSeconds(0.5f);
+        });
+    }
+
+    maxResumed = 0;
+    deferringFrames = 0;
+    resumes = 0;
+    for (int frame = 0; frame < BURST_FRAMES; ++frame) {
+        scheduler->update(FRAME_TIME);
+        const Scripting::CoroutineScheduler::CoroutineStats& stats = scheduler->getStats();
+        maxResumed = std::max<size_t>(maxResumed, stats.resumedLastFrame);
+        if (stats.deferredLastFrame > 0) deferringFrames++;
+        resumes += stats.resumedLastFrame;
+    }
+    bool accounted = scheduler->getStats().totalResumes == resumes;
+
+    Scripting::CoroutineScheduler::cleanup();
+    return accounted;
+}
+
+}  // namespace
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main() {
+    std::cout << "Coroutine scheduler benchmark (" << COROUTINES << " coroutines, " << FRAMES
+              << " frames)" << std::endl;
+
+    double pollingMs = 0.0;
+    const size_t pollingResumes = runPolling(pollingMs);
+    std::cout << "    polling every coroutine: " << pollingMs / FRAMES << " ms/frame, "
+              << static_cast<double>(pollingResumes) / FRAMES << " resumes/frame" << std::endl;
+
+    double wheelMs = 0.0;
+    size_t steadyAllocations = 0;
+    size_t steadyResumes = 0;
+    const size_t wheelResumes = runScheduler(wheelMs, steadyAllocations, steadyResumes);
+    std::cout << "    timer wheels: " << wheelMs / FRAMES << " ms/frame, "
+              << static_cast<double>(wheelResumes) / FRAMES << " resumes/frame, "
+              << steadyAllocations << " allocations in " << steadyResumes
+              << " steady-state resumes" << std::endl;
+
+    size_t maxResumed = 0;
+    int deferringFrames = 0;
+    size_t burstResumes = 0;
+    const bool accounted = runBurst(maxResumed, deferringFrames, burstResumes);
+    std::cout << "    " << BURST << " coroutines waking together, budget " << BURST_BUDGET
+              << ": at most " << maxResumed << " resumes/frame, " << deferringFrames
+              << " frames deferring" << std::endl;
+
+    bool consistent = pollingResumes == wheelResumes && steadyAllocations == 0 &&
+                      maxResumed <= BURST_BUDGET && deferringFrames > 0 && accounted &&
+                      burstResumes > static_cast<size_t>(BURST);
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: the scheduler resumed coroutines "
+                     "differently from polling, allocated while resuming, or exceeded its budget"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Entity create/destroy/lookup churn benchmark for ECS::EntityManager
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_entity_churn.cpp src/ecs/EntityManager.cpp
+//            src/ecs/Entity.cpp src/ecs/ArchetypeStorage.cpp src/ecs/SystemScheduler.cpp
+//            src/threading/ThreadPool.cpp src/profiler/PerformanceProfiler.cpp -lpthread
+//            -o bench_entity_churn
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../include/ecs/EntityManager.h"
+
+using namespace JJM::ECS;
+
+namespace {
+
+constexpr size_t ENTITY_COUNT = 100000;
+constexpr int CHURN_ROUNDS = 10;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+void report(const char* name, double ms, size_t ops) {
+    std::cout << "  " << name << ": " << ms << " ms (" << (ms * 1e6 / ops) << " ns/op)"
+              << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "EntityManager churn benchmark (" << ENTITY_COUNT << " entities)" << std::endl;
+
+    std::mt19937 rng(1234);
+    EntityManager manager;
+    manager.reserve(ENTITY_COUNT);
+
+    std::vector<EntityID> ids;
+    ids.reserve(ENTITY_COUNT);
+
+    Timer createTimer;
+    for (size_t i = 0; i < ENTITY_COUNT; ++i) {
+        ids.push_back(manager.createEntity()->getID());
+    }
+    report("create", createTimer.elapsedMs(), ENTITY_COUNT);
+
+    std::vector<EntityID> shuffled = ids;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+
+    Timer lookupTimer;
+    size_t found = 0;
+    for (EntityID id : shuffled) {
+        found += manager.getEntity(id) != nullptr;
+    }
+    report("lookup (random order)", lookupTimer.elapsedMs(), ENTITY_COUNT);
+
+    // Destroy half, recreate into recycled slots, and check the stale handles
+    std::vector<EntityID> stale;
+    size_t churnOps = 0;
+    Timer churnTimer;
+    for (int round = 0; round < CHURN_ROUNDS; ++round) {
+        std::shuffle(ids.begin(), ids.end(), rng);
+        const size_t half = ids.size() / 2;
+        for (size_t i = 0; i < half; ++i) {
+            manager.destroyEntity(ids[i]);
+        }
+        stale.assign(ids.begin(), ids.begin() + half);
+        for (size_t i = 0; i < half; ++i) {
+            ids[i] = manager.createEntity()->getID();
+        }
+        churnOps += half * 2;
+    }
+    report("destroy+create churn", churnTimer.elapsedMs(), churnOps);
+
+    Timer staleTimer;
+    size_t staleAlive = 0;
+    for (EntityID id : stale) {
+        staleAlive += manager.isAlive(id);
+    }
+    report("stale handle check", staleTimer.elapsedMs(), stale.size());
+
+    Timer deferredTimer;
+    for (EntityID id : ids) {
+        manager.destroyEntityDeferred(id);
+    }
+    manager.processDeferred();
+    report("deferred destroy all", deferredTimer.elapsedMs(), ids.size());
+
+    if (found != ENTITY_COUNT || staleAlive != 0 || manager.getEntityCount() != 0) {
+        std::cerr << "Benchmark sanity check failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,291 @@
+// Flow field benchmark for AI::FlowField: one goal on a 1024x1024 grid with scattered obstacles
+// and walls, against the previous field (a breadth-first flood of the whole grid through
+// Grid::getNeighbors), then the incremental cases a crowd hits every few frames: the goal
+// moving a few cells and DynamicObstacleManager obstacles moving across the map. 10k agents
+// sampling the field are compared with one A* query per agent.
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_flow_field.cpp src/ai/Pathfinding.cpp
+//            src/ai/NavigationMesh.cpp src/math/Vector2D.cpp -lpthread -o bench_flow_field
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <random>
+#include <vector>
+
+#include "../include/ai/NavigationMesh.h"
+#include "../include/ai/Pathfinding.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int GRID_SIZE = 1024;
+constexpr int SECTOR_SIZE = 16;
+constexpr int AGENTS = 10000;
+constexpr int ASTAR_SAMPLES = 20;
+constexpr int GOAL_MOVES = 20;
+constexpr int OBSTACLES = 20;
+constexpr int OBSTACLE_FRAMES = 20;
+constexpr int WALKS = 30;
+constexpr float DIAGONAL_COST = 1.41421356f;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// The pre-change field: unit-cost flood from the goal, then each cell points at its cheapest
+// neighbour
+class PreviousFlowField {
+   public:
+    explicit PreviousFlowField(AI::Grid* grid)
+        : grid(grid),
+          costField(static_cast<size_t>(grid->getWidth()) * grid->getHeight()),
+          flowField(costField.size()) {}
+
+    void generateField(int goalX, int goalY) {
+        std::fill(costField.begin(), costField.end(), std::numeric_limits<float>::max());
+        const int width = grid->getWidth();
+        AI::GridNode* goal = grid->getNode(goalX, goalY);
+        costField[goalY * width + goalX] = 0;
+        std::queue<AI::GridNode*> frontier;
+        frontier.push(goal);
+        while (!frontier.empty()) {
+            AI::GridNode* current = frontier.front();
+            frontier.pop();
+            const float cost = costField[current->y * width + current->x] + 1.0f;
+            for (AI::GridNode* neighbor : grid->getNeighbors(current)) {
+                const int index = neighbor->y * width + neighbor->x;
+                if (cost < costField[index]) {
+                    costField[index] = cost;
+                    frontier.push(neighbor);
+                }
+            }
+        }
+
+        for (int y = 0; y < grid->getHeight(); ++y) {
+            for (int x = 0; x < width; ++x) {
+                AI::GridNode* node = grid->getNode(x, y);
+                if (!node->walkable) continue;
+                AI::GridNode* best = nullptr;
+                float lowest = costField[y * width + x];
+                for (AI::GridNode* neighbor : grid->getNeighbors(node)) {
+                    const int index = neighbor->y * width + neighbor->x;
+                    if (costField[index] < lowest) {
+                        lowest = costField[index];
+                        best = neighbor;
+                    }
+                }
+                if (best) {
+                    flowField[y * width + x] =
+                        Math::Vector2D(static_cast<float>(best->x - x),
+                                       static_cast<float>(best->y - y)).normalized();
+                }
+            }
+        }
+    }
+
+   private:
+    AI::Grid* grid;
+    std::vector<float> costField;
+    std::vector<Math::Vector2D> flowField;
+};
+
+void buildMap(AI::Grid& grid, std::mt19937& random) {
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE / 5; ++i) {
+        grid.setWalkable(random() % GRID_SIZE, random() % GRID_SIZE, false);
+    }
+    // Long walls with gaps, so straight-line paths are rarely available
+    for (int wall = 0; wall < 200; ++wall) {
+        const int x = random() % GRID_SIZE, y = random() % GRID_SIZE;
+        const int length = 50 + random() % 200;
+        const bool horizontal = random() % 2 == 0;
+        for (int i = 0; i < length; ++i) {
+            grid.setWalkable(horizontal ? x + i : x, horizontal ? y : y + i, false);
+        }
+    }
+}
+
+float pathCost(const std::vector<Math::Vector2D>& path) {
+    if (path.empty()) return -1.0f;
+    float cost = 0.0f;
+    for (size_t i = 1; i < path.size(); ++i) {
+        const bool diagonal = path[i].x != path[i - 1].x && path[i].y != path[i - 1].y;
+        cost += diagonal ? DIAGONAL_COST : 1.0f;
+    }
+    return cost;
+}
+
+// Steps cell to cell along the field; returns the cost walked, or a negative value if the
+// walk stops or loops before the goal
+float followField(const AI::FlowField& field, const AI::Grid& grid, int x, int y, int goalX,
+                  int goalY) {
+    float cost = 0.0f;
+    for (int steps = 0; steps < GRID_SIZE * GRID_SIZE; ++steps) {
+        if (x == goalX && y == goalY) return cost;
+        const Math::Vector2D direction =
+            field.getDirection(Math::Vector2D(x + 0.5f, y + 0.5f));
+        const int dx = direction.x > 0.1f ? 1 : (direction.x < -0.1f ? -1 : 0);
+        const int dy = direction.y > 0.1f ? 1 : (direction.y < -0.1f ? -1 : 0);
+        if (dx == 0 && dy == 0) return -1.0f;
+        x += dx;
+        y += dy;
+        if (!grid.isWalkable(x, y)) return -1.0f;
+        cost += dx != 0 && dy != 0 ? DIAGONAL_COST : 1.0f;
+    }
+    return -1.0f;
+}
+
+void report(const char* name, double ms, const AI::FlowField::Statistics& stats) {
+    std::cout << "    " << name << ": " << ms << " ms, " << stats.tilesBuilt << " tiles built, "
+              << stats.tilesReused << " reused" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 random(1234);
+    AI::Grid grid(GRID_SIZE, GRID_SIZE);
+    buildMap(grid, random);
+
+    auto randomWalkable = [&]() {
+        for (;;) {
+            const int x = random() % GRID_SIZE, y = random() % GRID_SIZE;
+            if (grid.isWalkable(x, y)) return std::make_pair(x, y);
+        }
+    };
+    const auto goal = randomWalkable();
+    std::vector<Math::Vector2D> agents;
+    for (int i = 0; i < AGENTS; ++i) {
+        const auto cell = randomWalkable();
+        agents.emplace_back(cell.first + 0.5f, cell.second + 0.5f);
+    }
+
+    std::cout << "Flow field benchmark (" << GRID_SIZE << "x" << GRID_SIZE << " grid, "
+              << SECTOR_SIZE << "x" << SECTOR_SIZE << " sectors, " << AGENTS << " agents)"
+              << std::endl;
+
+    PreviousFlowField previous(&grid);
+    Timer previousTimer;
+    previous.generateField(goal.first, goal.second);
+    std::cout << "    previous FlowField: " << previousTimer.elapsedMs() << " ms" << std::endl;
+
+    AI::FlowField field(&grid, SECTOR_SIZE);
+    const Math::Vector2D goalPosition(goal.first + 0.5f, goal.second + 0.5f);
+    Timer coldTimer;
+    field.generateField(goalPosition);
+    report("FlowField, first goal", coldTimer.elapsedMs(), field.getStatistics());
+    std::cout << "      " << field.getStatistics().sectorVisits << " sector visits for "
+              << field.getStatistics().sectorCount << " sectors" << std::endl;
+
+    Timer sameTimer;
+    field.generateField(goalPosition);
+    report("FlowField, same goal again", sameTimer.elapsedMs(), field.getStatistics());
+
+    // A target wandering a few cells per update
+    int goalX = goal.first, goalY = goal.second;
+    size_t built = 0, reused = 0;
+    Timer moveTimer;
+    for (int move = 0; move < GOAL_MOVES; ++move) {
+        const int x = goalX + static_cast<int>(random() % 5) - 2;
+        const int y = goalY + static_cast<int>(random() % 5) - 2;
+        if (!grid.isWalkable(x, y)) continue;
+        goalX = x;
+        goalY = y;
+        field.generateField(Math::Vector2D(goalX + 0.5f, goalY + 0.5f));
+        built += field.getStatistics().tilesBuilt;
+        reused += field.getStatistics().tilesReused;
+    }
+    std::cout << "    FlowField, goal moving: " << moveTimer.elapsedMs() / GOAL_MOVES
+              << " ms/update, " << built / GOAL_MOVES << " tiles built, " << reused / GOAL_MOVES
+              << " reused" << std::endl;
+    field.generateField(goalPosition);
+
+    // Vehicles crossing the map; each frame restamps them and repairs what they touched
+    AI::NavMesh mesh;
+    AI::DynamicObstacleManager obstacles(mesh);
+    std::vector<int> obstacleIds;
+    for (int i = 0; i < OBSTACLES; ++i) {
+        AI::DynamicObstacle obstacle{};
+        obstacle.shape = AI::ObstacleShape::Circle;
+        obstacle.circle.radius = 3.0f;
+        obstacle.position = Math::Vector2D(static_cast<float>(random() % GRID_SIZE),
+                                           static_cast<float>(random() % GRID_SIZE));
+        obstacle.velocity = Math::Vector2D(2.0f, 1.0f);
+        obstacleIds.push_back(obstacles.addObstacle(obstacle));
+    }
+    built = reused = 0;
+    size_t repaired = 0;
+    Timer obstacleTimer;
+    for (int frame = 0; frame < OBSTACLE_FRAMES; ++frame) {
+        obstacles.updateAllObstacles(1.0f);
+        field.applyObstacles(obstacles);
+        field.generateField(goalPosition);
+        built += field.getStatistics().tilesBuilt;
+        reused += field.getStatistics().tilesReused;
+        repaired += field.getStatistics().sectorsRepaired;
+    }
+    std::cout << "    FlowField, " << OBSTACLES
+              << " moving obstacles: " << obstacleTimer.elapsedMs() / OBSTACLE_FRAMES
+              << " ms/frame, " << repaired / OBSTACLE_FRAMES << " sectors repaired, "
+              << built / OBSTACLE_FRAMES << " tiles built, " << reused / OBSTACLE_FRAMES
+              << " reused" << std::endl;
+    for (int id : obstacleIds) obstacles.removeObstacle(id);
+    field.applyObstacles(obstacles);
+    field.generateField(goalPosition);
+
+    // Every agent steering by the field, against a path search per agent
+    Math::Vector2D sum(0.0f, 0.0f);
+    Timer sampleTimer;
+    for (const auto& agent : agents) {
+        sum += field.getDirection(agent);
+    }
+    std::cout << "    " << AGENTS << " agents sampling the field: " << sampleTimer.elapsedMs()
+              << " ms" << std::endl;
+
+    AI::AStar astar(&grid);
+    Timer astarTimer;
+    for (int i = 0; i < ASTAR_SAMPLES; ++i) {
+        astar.findPath(agents[i], goalPosition);
+    }
+    const double perQuery = astarTimer.elapsedMs() / ASTAR_SAMPLES;
+    std::cout << "    AStar per agent: " << perQuery << " ms/query, " << perQuery * AGENTS / 1000.0
+              << " s for all agents" << std::endl;
+
+    // Walking the field reaches the goal from wherever A* does, on a near-optimal route
+    bool consistent = true;
+    double worstRatio = 1.0, totalRatio = 0.0;
+    int solved = 0;
+    for (int i = 0; i < WALKS; ++i) {
+        const int x = static_cast<int>(agents[i].x), y = static_cast<int>(agents[i].y);
+        const float optimal = pathCost(astar.findPath(agents[i], goalPosition));
+        const float walked = followField(field, grid, x, y, goal.first, goal.second);
+        consistent = consistent && (optimal < 0.0f) == (walked < 0.0f);
+        if (optimal <= 0.0f || walked < 0.0f) continue;
+        const double ratio = walked / optimal;
+        worstRatio = std::max(worstRatio, ratio);
+        totalRatio += ratio;
+        ++solved;
+    }
+    std::cout << "      walked length vs optimal: " << totalRatio / std::max(solved, 1) << " mean, "
+              << worstRatio << " worst" << std::endl;
+    consistent = consistent && worstRatio < 1.1;
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: following the field missed the goal where a "
+                     "path exists, or walked a route too long"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
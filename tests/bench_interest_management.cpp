@@ -0,0 +1,260 @@
+// Interest management benchmark for Network::StateSynchronizer: 4000 objects spread over a
+// 2 km square (30% moving, 10% turning and 5% changing a sync var each tick) replicated to 64
+// clients that each follow a player object, sending every object to every client, only the
+// objects in each client's interest region, and relevant objects under a per-client bandwidth
+// budget filled by the priority accumulator. Eight of the clients decode their packets; once
+// the world stops moving they must converge on the server's state for everything they can see
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_interest_management.cpp
+//            src/network/StateSynchronization.cpp src/network/PacketCompression.cpp
+//            -o bench_interest_management
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../include/network/StateSynchronization.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr size_t OBJECTS = 4000;
+constexpr uint32_t CLIENTS = 64;
+constexpr uint32_t DECODING_CLIENTS = 8;
+constexpr int TICKS = 200;
+constexpr int SETTLE_TICKS = 100;   // World frozen, clients catch up
+constexpr int LATENCY_TICKS = 1;    // Each way
+constexpr float WORLD_SIZE = 2000.0f;
+constexpr float INTEREST_RADIUS = 200.0f;
+constexpr size_t CLIENT_BANDWIDTH = 6000;  // Bytes per second
+constexpr float SNAPSHOT_RATE = 20.0f;
+constexpr float MOVING = 0.3f;
+constexpr float TURNING = 0.1f;
+constexpr float VAR_CHANGES = 0.05f;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+enum class Mode { Everything, Interest, Budget };
+
+struct Replicated {
+    Network::NetworkedObject object;
+    Network::SyncVar<int> ammo;
+
+    explicit Replicated(uint32_t id) : object(id), ammo(30) {
+        object.registerSyncVar("ammo", &ammo);
+    }
+};
+
+struct Peer {
+    Network::StateSynchronizer sync;
+    std::vector<std::unique_ptr<Replicated>> objects;
+
+    Peer(bool isServer, std::mt19937* placement) {
+        sync.initialize(isServer);
+        sync.setSnapshotRate(SNAPSHOT_RATE);
+        std::uniform_real_distribution<float> coordinate(0.0f, WORLD_SIZE);
+        for (size_t i = 0; i < OBJECTS; ++i) {
+            objects.push_back(std::make_unique<Replicated>(static_cast<uint32_t>(i * 2 + 1)));
+            if (placement) {
+                Network::NetworkTransform transform;
+                transform.position[0] = coordinate(*placement);
+                transform.position[2] = coordinate(*placement);
+                objects.back()->object.setTransform(transform);
+            }
+            sync.registerObject(&objects.back()->object);
+        }
+    }
+};
+
+struct InFlight {
+    int arrival;
+    uint32_t client;
+    uint32_t snapshotId;
+    std::vector<uint8_t> packet;
+};
+
+struct Result {
+    double bytesPerClientTick = 0.0;
+    double encodeUsPerClientTick = 0.0;
+    double entitiesSentPerTick = 0.0;
+    double entitiesDeferredPerTick = 0.0;
+    size_t largestPacket = 0;
+    bool converged = false;
+};
+
+// One tick of gameplay; the first CLIENTS objects are the players
+void simulate(Peer& server, std::mt19937& random) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (size_t i = 0; i < OBJECTS; ++i) {
+        Replicated& r = *server.objects[i];
+        Network::NetworkTransform transform = r.object.getTransform();
+        if (i < OBJECTS * MOVING) {
+            float heading = static_cast<float>(i) * 0.37f;
+            for (int axis = 0; axis < 3; axis += 2) {
+                float step = (axis == 0 ? std::cos(heading) : std::sin(heading)) * 0.25f;
+                float next = transform.position[axis] + step;
+                transform.position[axis] = next < 0.0f || next > WORLD_SIZE
+                                               ? transform.position[axis] - step
+                                               : next;
+            }
+        }
+        if (unit(random) < TURNING) {
+            transform.rotation[1] += 0.05f;
+            float* q = transform.rotation;
+            float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+            for (int k = 0; k < 4; ++k) q[k] /= length;
+        }
+        if (unit(random) < VAR_CHANGES) {
+            r.ammo = r.ammo.get() - 1;
+        }
+        r.object.setTransform(transform);
+    }
+}
+
+float distance(const float a[3], const float b[3]) {
+    float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+// Every object the client can see (away from the region's edge) matches the server
+bool converged(const Peer& server, const Peer& client, uint32_t clientIndex, Mode mode,
+               float precision) {
+    const float* center = server.objects[clientIndex]->object.getTransform().position;
+    for (size_t i = 0; i < OBJECTS; ++i) {
+        const Network::NetworkTransform& s = server.objects[i]->object.getTransform();
+        if (mode != Mode::Everything && distance(s.position, center) > INTEREST_RADIUS - 1.0f) {
+            continue;
+        }
+        const Network::NetworkTransform& c = client.objects[i]->object.getTransform();
+        float dot = 0.0f;
+        for (int k = 0; k < 4; ++k) dot += s.rotation[k] * c.rotation[k];
+        if (distance(s.position, c.position) > precision + 0.002f || std::fabs(dot) < 0.9999f ||
+            server.objects[i]->ammo.get() != client.objects[i]->ammo.get()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Result run(Mode mode) {
+    std::mt19937 random(7);
+    Peer server(true, &random);
+    Network::InterestManager interest;
+    interest.setCellSize(INTEREST_RADIUS * 0.5f);
+    if (mode != Mode::Everything) {
+        server.sync.setInterestManager(&interest);
+    }
+    server.sync.setBandwidthLimit(mode == Mode::Budget ? CLIENT_BANDWIDTH : 0);
+
+    std::vector<std::unique_ptr<Peer>> clients;
+    for (uint32_t c = 0; c < CLIENTS; ++c) {
+        if (c < DECODING_CLIENTS) clients.push_back(std::make_unique<Peer>(false, nullptr));
+        server.sync.addClient(c);
+    }
+    const float precision = server.sync.getQuantization().positionPrecision;
+
+    Result result;
+    std::deque<InFlight> snapshots, acks;
+    std::vector<uint8_t> packet;
+    size_t bytes = 0, entitiesSent = 0, entitiesDeferred = 0;
+    double encodeMs = 0.0;
+    for (int tick = 0; tick < TICKS + SETTLE_TICKS; ++tick) {
+        if (tick < TICKS) simulate(server, random);
+        for (uint32_t c = 0; c < CLIENTS; ++c) {
+            const float* center = server.objects[c]->object.getTransform().position;
+            interest.setClientInterest(
+                c, Network::InterestManager::Region{{center[0], center[1], center[2]},
+                                                    INTEREST_RADIUS});
+        }
+
+        Timer encodeTimer;
+        const uint32_t snapshotId = server.sync.captureSnapshot();
+        for (uint32_t c = 0; c < CLIENTS; ++c) {
+            server.sync.writeSnapshot(c, packet);
+            if (tick < TICKS) bytes += packet.size();
+            result.largestPacket = std::max(result.largestPacket, packet.size());
+            snapshots.push_back(InFlight{tick + LATENCY_TICKS, c, snapshotId, packet});
+        }
+        if (tick < TICKS) {
+            encodeMs += encodeTimer.elapsedMs();
+            entitiesSent += server.sync.getStats().entitiesSent;
+            entitiesDeferred += server.sync.getStats().entitiesDeferred;
+        }
+
+        // Clients past the decoding ones ack without decoding
+        while (!snapshots.empty() && snapshots.front().arrival <= tick) {
+            InFlight& flight = snapshots.front();
+            if (flight.client < DECODING_CLIENTS &&
+                !clients[flight.client]->sync.readSnapshot(flight.packet)) {
+                return result;
+            }
+            acks.push_back(InFlight{tick + LATENCY_TICKS, flight.client, flight.snapshotId, {}});
+            snapshots.pop_front();
+        }
+        while (!acks.empty() && acks.front().arrival <= tick) {
+            server.sync.acknowledgeSnapshot(acks.front().client, acks.front().snapshotId);
+            acks.pop_front();
+        }
+    }
+
+    const double perClientTick = static_cast<double>(CLIENTS) * TICKS;
+    result.bytesPerClientTick = bytes / perClientTick;
+    result.encodeUsPerClientTick = encodeMs / perClientTick * 1000.0;
+    result.entitiesSentPerTick = static_cast<double>(entitiesSent) / TICKS;
+    result.entitiesDeferredPerTick = static_cast<double>(entitiesDeferred) / TICKS;
+    result.converged = true;
+    for (uint32_t c = 0; c < DECODING_CLIENTS; ++c) {
+        result.converged = result.converged && converged(server, *clients[c], c, mode, precision);
+    }
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << "    " << name << ": " << result.bytesPerClientTick << " bytes/client/tick, "
+              << result.entitiesSentPerTick << " entities sent/tick ("
+              << result.entitiesDeferredPerTick << " deferred), encode "
+              << result.encodeUsPerClientTick << " us/client/tick" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "Interest management benchmark (" << OBJECTS << " objects, " << CLIENTS
+              << " clients, " << TICKS << " ticks, " << INTEREST_RADIUS << " m interest radius, "
+              << CLIENT_BANDWIDTH << " B/s per client)" << std::endl;
+
+    Result everything = run(Mode::Everything);
+    report("every object to every client", everything);
+    Result interest = run(Mode::Interest);
+    report("relevant objects", interest);
+    Result budget = run(Mode::Budget);
+    report("relevant objects within budget", budget);
+    std::cout << "      largest packet " << budget.largestPacket << " bytes, budget "
+              << static_cast<size_t>(CLIENT_BANDWIDTH / SNAPSHOT_RATE) << " bytes" << std::endl;
+
+    bool consistent = everything.converged && interest.converged && budget.converged &&
+                      budget.largestPacket <= CLIENT_BANDWIDTH / SNAPSHOT_RATE;
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: a client did not converge on the server's "
+                     "state once the world stopped, or a packet exceeded the budget"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
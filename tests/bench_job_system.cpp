@@ -0,0 +1,440 @@
+// Job system benchmark for Threading::JobSystem: millions of tiny jobs through the
+// lock-free work-stealing scheduler against the previous mutex-and-shared_ptr scheduler,
+// reproduced below, both for jobs submitted from the main thread and spawned by jobs, and
+// jobs that wait on their children with and without fibers
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_job_system.cpp
+//            src/threading/ThreadPool.cpp src/profiler/PerformanceProfiler.cpp -lpthread
+//            -o bench_job_system
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "../include/threading/ThreadPool.h"
+
+using namespace JJM;
+using namespace JJM::Threading;
+
+namespace {
+
+constexpr size_t WORKER_COUNT = 4;
+constexpr size_t WAVES = 200;
+constexpr size_t JOBS_PER_WAVE = 10000;
+constexpr size_t PARENTS = 2000;
+constexpr size_t CHILDREN_PER_PARENT = 100;
+constexpr int TREE_DEPTH = 16;
+constexpr size_t FIBER_COUNT = 128;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// The scheduler JobSystem used before the work-stealing deques: a shared_ptr<Job> with its
+// own mutex and condition variable per job, a handle map behind a mutex, and mutex-guarded
+// global and per-worker queues. Trimmed to the paths measured here.
+namespace legacy {
+
+class Job {
+   public:
+    Job(JobHandle h, JobFunction f, TaskPriority p)
+        : handle(h), function(std::move(f)), priority(p), status(JobStatus::Pending) {}
+
+    JobHandle handle;
+    JobFunction function;
+    TaskPriority priority;
+    std::atomic<JobStatus> status;
+    std::chrono::high_resolution_clock::time_point startTime;
+    std::chrono::high_resolution_clock::time_point endTime;
+    std::mutex mutex;
+    std::condition_variable completionCV;
+};
+
+class PriorityJobQueue {
+   public:
+    void push(std::shared_ptr<Job> job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queues[static_cast<size_t>(job->priority)].push_back(std::move(job));
+        ++totalCount;
+        condition.notify_one();
+    }
+
+    std::shared_ptr<Job> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return totalCount > 0 || closed; });
+        return popLocked();
+    }
+
+    std::shared_ptr<Job> tryPop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return popLocked();
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        condition.notify_all();
+    }
+
+   private:
+    std::shared_ptr<Job> popLocked() {
+        for (auto& queue : queues) {
+            if (!queue.empty()) {
+                auto job = std::move(queue.front());
+                queue.pop_front();
+                --totalCount;
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    std::array<std::deque<std::shared_ptr<Job>>, static_cast<size_t>(TaskPriority::Count)> queues;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::atomic<size_t> totalCount{0};
+    bool closed = false;
+};
+
+class ThreadLocalQueue {
+   public:
+    void push(std::shared_ptr<Job> job) {
+        std::lock_guard<std::mutex> lock(mutex);
+        localQueue.push_front(std::move(job));
+    }
+
+    std::shared_ptr<Job> pop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (localQueue.empty()) return nullptr;
+        auto job = std::move(localQueue.front());
+        localQueue.pop_front();
+        return job;
+    }
+
+    std::shared_ptr<Job> steal() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (localQueue.empty()) return nullptr;
+        auto job = std::move(localQueue.back());
+        localQueue.pop_back();
+        return job;
+    }
+
+   private:
+    std::deque<std::shared_ptr<Job>> localQueue;
+    std::mutex mutex;
+};
+
+thread_local size_t currentThreadIndex = 0;
+thread_local bool isWorkerThread = false;
+
+class JobSystem {
+   public:
+    explicit JobSystem(size_t numWorkers) : queues(numWorkers) {
+        for (auto& queue : queues) queue = std::make_unique<ThreadLocalQueue>();
+        running = true;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            threads.emplace_back(&JobSystem::workerMain, this, i);
+        }
+    }
+
+    ~JobSystem() {
+        running = false;
+        globalQueue.close();
+        for (auto& thread : threads) thread.join();
+    }
+
+    template <typename F>
+    JobHandle submitWithPriority(F&& func, TaskPriority priority) {
+        JobHandle handle = nextHandle++;
+        auto job = std::make_shared<Job>(handle, std::forward<F>(func), priority);
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            jobs[handle] = job;
+        }
+        job->status = JobStatus::Queued;
+        if (isWorkerThread) {
+            queues[currentThreadIndex]->push(job);
+        } else {
+            globalQueue.push(job);
+        }
+        return handle;
+    }
+
+    bool processOneJob() {
+        std::shared_ptr<Job> job;
+        if (isWorkerThread) job = queues[currentThreadIndex]->pop();
+        if (!job) job = globalQueue.tryPop();
+        if (!job) return false;
+        executeJob(job);
+        return true;
+    }
+
+   private:
+    void workerMain(size_t index) {
+        currentThreadIndex = index;
+        isWorkerThread = true;
+        while (running) {
+            auto job = queues[index]->pop();
+            if (!job) job = globalQueue.tryPop();
+            for (size_t i = 1; !job && i < queues.size(); ++i) {
+                job = queues[(index + i) % queues.size()]->steal();
+            }
+            if (!job) job = globalQueue.pop();
+            if (job) executeJob(job);
+        }
+    }
+
+    void executeJob(const std::shared_ptr<Job>& job) {
+        job->status = JobStatus::Running;
+        job->startTime = std::chrono::high_resolution_clock::now();
+        job->function();
+        job->status = JobStatus::Completed;
+        job->endTime = std::chrono::high_resolution_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->completionCV.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        jobs.erase(job->handle);
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<ThreadLocalQueue>> queues;
+    PriorityJobQueue globalQueue;
+    std::unordered_map<JobHandle, std::shared_ptr<Job>> jobs;
+    std::mutex jobsMutex;
+    std::atomic<JobHandle> nextHandle{1};
+    std::atomic<bool> running{false};
+};
+
+}  // namespace legacy
+
+// Each job adds its index into its own slot, so results can be checked afterwards
+template <typename Submit, typename Wait>
+double runWaves(std::vector<uint64_t>& slots, Submit submit, Wait wait) {
+    Timer timer;
+    for (size_t wave = 0; wave < WAVES; ++wave) {
+        for (size_t i = 0; i < JOBS_PER_WAVE; ++i) {
+            submit(&slots[i], wave + i);
+        }
+        wait();
+    }
+    return timer.elapsedMs();
+}
+
+bool checkWaves(const std::vector<uint64_t>& slots) {
+    for (size_t i = 0; i < JOBS_PER_WAVE; ++i) {
+        uint64_t expected = WAVES * i + WAVES * (WAVES - 1) / 2;
+        if (slots[i] != expected) return false;
+    }
+    return true;
+}
+
+// Every inner node dispatches its two subtrees and waits for them, so thousands of jobs
+// are waiting at once while only a handful of workers exist
+size_t countTree(JobSystem& jobSystem, int depth) {
+    if (depth == 0) return 1;
+    size_t left = 0;
+    size_t right = 0;
+    JobCounter children;
+    jobSystem.dispatch([&]() { left = countTree(jobSystem, depth - 1); }, children);
+    jobSystem.dispatch([&]() { right = countTree(jobSystem, depth - 1); }, children);
+    jobSystem.wait(children);
+    return left + right + 1;
+}
+
+JobSystemConfig fiberConfig() {
+    JobSystemConfig config;
+    config.workerCount = WORKER_COUNT;
+    config.useFibers = true;
+    config.fiberCount = FIBER_COUNT;
+    return config;
+}
+
+void report(const char* name, double ms, size_t jobs) {
+    std::cout << "    " << name << ": " << ms << " ms, " << ms * 1.0e6 / jobs << " ns/job"
+              << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    const size_t flatJobs = WAVES * JOBS_PER_WAVE;
+    const size_t nestedJobs = PARENTS * (CHILDREN_PER_PARENT + 1);
+    std::cout << "JobSystem benchmark (" << WORKER_COUNT << " workers, "
+              << std::thread::hardware_concurrency() << " hardware threads)" << std::endl;
+    bool consistent = true;
+
+    // Flat: the main thread submits waves of tiny jobs and helps until each wave is done
+    std::cout << "  " << flatJobs << " jobs from the main thread in waves of " << JOBS_PER_WAVE
+              << std::endl;
+    {
+        std::vector<uint64_t> slots(JOBS_PER_WAVE, 0);
+        std::atomic<size_t> remaining(0);
+        legacy::JobSystem old(WORKER_COUNT);
+        double ms = runWaves(
+            slots,
+            [&](uint64_t* slot, uint64_t value) {
+                ++remaining;
+                old.submitWithPriority(
+                    [slot, value, &remaining]() {
+                        *slot += value;
+                        --remaining;
+                    },
+                    TaskPriority::Normal);
+            },
+            [&]() {
+                while (remaining.load() > 0) {
+                    if (!old.processOneJob()) std::this_thread::yield();
+                }
+            });
+        report("previous scheduler", ms, flatJobs);
+        consistent = consistent && checkWaves(slots);
+    }
+    {
+        std::vector<uint64_t> slots(JOBS_PER_WAVE, 0);
+        JobSystem jobSystem(WORKER_COUNT);
+        jobSystem.startup();
+        JobCounter counter;
+        double ms = runWaves(
+            slots,
+            [&](uint64_t* slot, uint64_t value) {
+                jobSystem.dispatch([slot, value]() { *slot += value; }, counter);
+            },
+            [&]() { jobSystem.wait(counter); });
+        report("work stealing, counter", ms, flatJobs);
+        consistent = consistent && checkWaves(slots);
+
+        std::fill(slots.begin(), slots.end(), 0);
+        ms = runWaves(
+            slots,
+            [&](uint64_t* slot, uint64_t value) {
+                jobSystem.submitWithPriority([slot, value]() { *slot += value; },
+                                             TaskPriority::Normal);
+            },
+            [&]() { jobSystem.waitIdle(); });
+        report("work stealing, handles", ms, flatJobs);
+        consistent = consistent && checkWaves(slots);
+        std::cout << "    pooled job slots: " << jobSystem.getPooledJobCount() << std::endl;
+    }
+
+    // Nested: parent jobs spawn children from worker threads and wait for them
+    std::cout << "  " << nestedJobs << " jobs, " << PARENTS << " parents spawning "
+              << CHILDREN_PER_PARENT << " children each" << std::endl;
+    {
+        std::atomic<size_t> leaves(0);
+        std::atomic<size_t> parentsLeft(PARENTS);
+        legacy::JobSystem old(WORKER_COUNT);
+        Timer timer;
+        for (size_t p = 0; p < PARENTS; ++p) {
+            old.submitWithPriority(
+                [&]() {
+                    std::atomic<size_t> children(CHILDREN_PER_PARENT);
+                    for (size_t c = 0; c < CHILDREN_PER_PARENT; ++c) {
+                        old.submitWithPriority(
+                            [&]() {
+                                ++leaves;
+                                --children;
+                            },
+                            TaskPriority::Normal);
+                    }
+                    while (children.load() > 0) {
+                        if (!old.processOneJob()) std::this_thread::yield();
+                    }
+                    --parentsLeft;
+                },
+                TaskPriority::Normal);
+        }
+        while (parentsLeft.load() > 0) {
+            if (!old.processOneJob()) std::this_thread::yield();
+        }
+        report("previous scheduler", timer.elapsedMs(), nestedJobs);
+        consistent = consistent && leaves.load() == PARENTS * CHILDREN_PER_PARENT;
+    }
+    {
+        std::atomic<size_t> leaves(0);
+        JobSystem jobSystem(WORKER_COUNT);
+        jobSystem.startup();
+        JobCounter parents;
+        Timer timer;
+        for (size_t p = 0; p < PARENTS; ++p) {
+            jobSystem.dispatch(
+                [&]() {
+                    JobCounter children;
+                    for (size_t c = 0; c < CHILDREN_PER_PARENT; ++c) {
+                        jobSystem.dispatch([&]() { ++leaves; }, children);
+                    }
+                    jobSystem.wait(children);
+                },
+                parents);
+        }
+        jobSystem.wait(parents);
+        report("work stealing, counter", timer.elapsedMs(), nestedJobs);
+        consistent = consistent && leaves.load() == PARENTS * CHILDREN_PER_PARENT;
+
+        JobSystem::SystemMetrics metrics = jobSystem.getSystemMetrics();
+        std::cout << "    executed on workers: " << metrics.totalJobsExecuted
+                  << ", stolen: " << metrics.totalJobsStolen << std::endl;
+    }
+    if (JobSystem::isFiberModeSupported()) {
+        std::atomic<size_t> leaves(0);
+        JobSystem jobSystem(fiberConfig());
+        jobSystem.startup();
+        JobCounter parents;
+        Timer timer;
+        for (size_t p = 0; p < PARENTS; ++p) {
+            jobSystem.dispatch(
+                [&]() {
+                    JobCounter children;
+                    for (size_t c = 0; c < CHILDREN_PER_PARENT; ++c) {
+                        jobSystem.dispatch([&]() { ++leaves; }, children);
+                    }
+                    jobSystem.wait(children);
+                },
+                parents);
+        }
+        jobSystem.wait(parents);
+        report("fibers, counter", timer.elapsedMs(), nestedJobs);
+        consistent = consistent && leaves.load() == PARENTS * CHILDREN_PER_PARENT;
+        std::cout << "    suspended waits: " << jobSystem.getFiberStats().suspensions << std::endl;
+    }
+
+    // Tree: waits nest TREE_DEPTH deep; helping runs them on one stack, fibers park them
+    const size_t treeJobs = (size_t(1) << (TREE_DEPTH + 1)) - 1;
+    std::cout << "  " << treeJobs << " jobs in a binary tree of depth " << TREE_DEPTH
+              << ", every inner node waiting" << std::endl;
+    {
+        JobSystem jobSystem(WORKER_COUNT);
+        jobSystem.startup();
+        Timer timer;
+        size_t nodes = countTree(jobSystem, TREE_DEPTH);
+        report("helping waits", timer.elapsedMs(), treeJobs);
+        consistent = consistent && nodes == treeJobs;
+    }
+    if (JobSystem::isFiberModeSupported()) {
+        JobSystem jobSystem(fiberConfig());
+        jobSystem.startup();
+        Timer timer;
+        size_t nodes = countTree(jobSystem, TREE_DEPTH);
+        report("fibers", timer.elapsedMs(), treeJobs);
+        consistent = consistent && nodes == treeJobs;
+
+        JobSystem::FiberStats stats = jobSystem.getFiberStats();
+        std::cout << "    " << stats.fiberCount << " fibers, suspended waits: "
+                  << stats.suspensions << ", jobs run inline: " << stats.inlineJobs << std::endl;
+    }
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: jobs were lost or ran twice" << std::endl;
+        return 1;
+    }
+    return 0;
+}
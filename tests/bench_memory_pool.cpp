@@ -0,0 +1,314 @@
+// Allocator benchmark for Memory::MemoryManager and MemoryArena: 8 and 16 threads churning
+// mixed small sizes locally and handing blocks to a neighbour thread to free, against
+// malloc/free and a mutex-guarded free list (the previous MemoryPool's locking scheme)
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_memory_pool.cpp src/memory/MemoryPool.cpp
+//            -lpthread -o bench_memory_pool
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../include/memory/MemoryPool.h"
+
+using namespace JJM::Memory;
+
+namespace {
+
+constexpr size_t THREAD_COUNTS[] = {8, 16};
+constexpr size_t OPS_PER_THREAD = 200000;
+constexpr size_t ARENA_OPS_PER_THREAD = 50000;  // Arena memory is only reclaimed by reset()
+constexpr size_t BATCH = 64;
+constexpr size_t RING_SIZE = 1024;
+constexpr size_t SIZES[] = {16, 24, 48, 64, 96, 128, 200, 256};
+constexpr size_t SIZE_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// The pre-change pool: every allocation and free takes the pool mutex
+class MutexPool {
+   public:
+    MutexPool(size_t blockSize, size_t blockCount)
+        : blockSize(blockSize), memory(static_cast<char*>(std::malloc(blockSize * blockCount))) {
+        freeList.reserve(blockCount);
+        for (size_t i = blockCount; i-- > 0;) freeList.push_back(memory + i * blockSize);
+        end = memory + blockSize * blockCount;
+    }
+    ~MutexPool() { std::free(memory); }
+
+    void* allocate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeList.empty()) return nullptr;
+        void* block = freeList.back();
+        freeList.pop_back();
+        return block;
+    }
+    void deallocate(void* block) {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeList.push_back(static_cast<char*>(block));
+    }
+    bool owns(const void* block) const { return block >= memory && block < end; }
+
+    size_t blockSize;
+
+   private:
+    char* memory;
+    char* end;
+    std::vector<char*> freeList;
+    std::mutex mutex;
+};
+
+class MutexPools {
+   public:
+    explicit MutexPools(size_t blockCount) {
+        for (size_t size : {32, 64, 128, 256}) pools.emplace_back(new MutexPool(size, blockCount));
+    }
+
+    void* allocate(size_t size) {
+        for (auto& pool : pools) {
+            if (pool->blockSize >= size) {
+                if (void* block = pool->allocate()) return block;
+            }
+        }
+        return std::malloc(size);
+    }
+    void deallocate(void* block, size_t) {
+        for (auto& pool : pools) {
+            if (pool->owns(block)) {
+                pool->deallocate(block);
+                return;
+            }
+        }
+        std::free(block);
+    }
+
+   private:
+    std::vector<std::unique_ptr<MutexPool>> pools;
+};
+
+struct MallocAllocator {
+    void* allocate(size_t size) { return std::malloc(size); }
+    void deallocate(void* block, size_t) { std::free(block); }
+};
+
+struct ManagerAllocator {
+    MemoryManager* manager;
+    void* allocate(size_t size) { return manager->allocate(size); }
+    void deallocate(void* block, size_t size) { manager->deallocate(block, size); }
+};
+
+// Single-producer, single-consumer ring carrying blocks to the neighbouring thread
+struct alignas(64) Ring {
+    struct Item {
+        void* block;
+        size_t size;
+    };
+    Item items[RING_SIZE];
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+
+    bool push(Item item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == RING_SIZE) return false;
+        items[h % RING_SIZE] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(Item& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = items[t % RING_SIZE];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Writes the first and last byte of each block so a block handed out twice is caught
+void stamp(void* block, size_t size, unsigned char value) {
+    unsigned char* bytes = static_cast<unsigned char*>(block);
+    bytes[0] = value;
+    bytes[size - 1] = value;
+}
+
+bool checkStamp(void* block, size_t size, unsigned char value) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(block);
+    return bytes[0] == value && bytes[size - 1] == value;
+}
+
+// Each thread allocates a batch, verifies and frees it locally
+template <typename Allocator>
+double runLocal(Allocator& allocator, size_t threadCount, std::atomic<int>& errors) {
+    std::vector<std::thread> threads;
+    Timer timer;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&allocator, &errors, t]() {
+            void* blocks[BATCH];
+            const unsigned char value = static_cast<unsigned char>(t + 1);
+            for (size_t op = 0; op < OPS_PER_THREAD; op += BATCH) {
+                for (size_t i = 0; i < BATCH; ++i) {
+                    const size_t size = SIZES[(op + i + t) % SIZE_COUNT];
+                    blocks[i] = allocator.allocate(size);
+                    stamp(blocks[i], size, value);
+                }
+                for (size_t i = 0; i < BATCH; ++i) {
+                    const size_t size = SIZES[(op + i + t) % SIZE_COUNT];
+                    if (!checkStamp(blocks[i], size, value)) ++errors;
+                    allocator.deallocate(blocks[i], size);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    return timer.elapsedMs();
+}
+
+// Each thread allocates and passes every block to the next thread, which frees it
+template <typename Allocator>
+double runCrossThread(Allocator& allocator, size_t threadCount, std::atomic<int>& errors) {
+    std::vector<Ring> rings(threadCount);
+    std::vector<std::thread> threads;
+    Timer timer;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t]() {
+            Ring& outgoing = rings[t];
+            Ring& incoming = rings[(t + threadCount - 1) % threadCount];
+            const unsigned char value = static_cast<unsigned char>(t + 1);
+            const unsigned char sender =
+                static_cast<unsigned char>((t + threadCount - 1) % threadCount + 1);
+            size_t sent = 0;
+            size_t received = 0;
+            while (sent < OPS_PER_THREAD || received < OPS_PER_THREAD) {
+                if (sent < OPS_PER_THREAD) {
+                    const size_t size = SIZES[(sent + t) % SIZE_COUNT];
+                    void* block = allocator.allocate(size);
+                    stamp(block, size, value);
+                    while (!outgoing.push({block, size})) {
+                        Ring::Item item;
+                        if (incoming.pop(item)) {
+                            if (!checkStamp(item.block, item.size, sender)) ++errors;
+                            allocator.deallocate(item.block, item.size);
+                            ++received;
+                        } else {
+                            std::this_thread::yield();
+                        }
+                    }
+                    ++sent;
+                }
+                Ring::Item item;
+                if (incoming.pop(item)) {
+                    if (!checkStamp(item.block, item.size, sender)) ++errors;
+                    allocator.deallocate(item.block, item.size);
+                    ++received;
+                } else if (sent == OPS_PER_THREAD) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    return timer.elapsedMs();
+}
+
+// Per-thread bump allocation against malloc for short-lived scratch data
+double runArena(MemoryArena* arena, size_t threadCount, std::atomic<int>& errors) {
+    std::vector<std::thread> threads;
+    Timer timer;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([arena, &errors, t]() {
+            void* blocks[BATCH];
+            const unsigned char value = static_cast<unsigned char>(t + 1);
+            for (size_t op = 0; op < ARENA_OPS_PER_THREAD; op += BATCH) {
+                for (size_t i = 0; i < BATCH; ++i) {
+                    const size_t size = SIZES[(op + i + t) % SIZE_COUNT];
+                    blocks[i] = arena ? arena->allocate(size) : std::malloc(size);
+                    stamp(blocks[i], size, value);
+                }
+                for (size_t i = 0; i < BATCH; ++i) {
+                    const size_t size = SIZES[(op + i + t) % SIZE_COUNT];
+                    if (!checkStamp(blocks[i], size, value)) ++errors;
+                    if (!arena) std::free(blocks[i]);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    return timer.elapsedMs();
+}
+
+void report(const char* name, double ms, size_t threadCount,
+            size_t opsPerThread = OPS_PER_THREAD) {
+    const double ops = static_cast<double>(threadCount * opsPerThread);
+    std::cout << "    " << name << ": " << ms << " ms, " << (ms * 1e6 / ops) << " ns/op"
+              << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    MemoryManager* manager = MemoryManager::getInstance();
+    // Enough blocks that the cross-thread rings (16 x 1024 in flight) never spill to malloc
+    manager->createPool("Small", 32, 32768);
+    manager->createPool("Medium", 64, 32768);
+    manager->createPool("Large", 128, 32768);
+    manager->createPool("Huge", 256, 32768);
+
+    std::atomic<int> errors(0);
+    std::cout << "MemoryPool benchmark (" << std::thread::hardware_concurrency()
+              << " hardware threads, " << OPS_PER_THREAD << " allocations per thread)"
+              << std::endl;
+
+    MallocAllocator mallocAllocator;
+    ManagerAllocator managerAllocator{manager};
+    MutexPools mutexPools(32768);
+    for (size_t threadCount : THREAD_COUNTS) {
+        std::cout << "  " << threadCount << " threads, local alloc/free" << std::endl;
+        report("malloc/free", runLocal(mallocAllocator, threadCount, errors), threadCount);
+        report("mutex pools", runLocal(mutexPools, threadCount, errors), threadCount);
+        report("MemoryManager", runLocal(managerAllocator, threadCount, errors), threadCount);
+
+        std::cout << "  " << threadCount << " threads, freed by the next thread" << std::endl;
+        report("malloc/free", runCrossThread(mallocAllocator, threadCount, errors), threadCount);
+        report("mutex pools", runCrossThread(mutexPools, threadCount, errors), threadCount);
+        report("MemoryManager", runCrossThread(managerAllocator, threadCount, errors),
+               threadCount);
+
+        std::cout << "  " << threadCount << " threads, scratch allocations" << std::endl;
+        report("malloc/free", runArena(nullptr, threadCount, errors), threadCount,
+               ARENA_OPS_PER_THREAD);
+        MemoryArena arena;
+        report("MemoryArena", runArena(&arena, threadCount, errors), threadCount,
+               ARENA_OPS_PER_THREAD);
+        arena.reset();
+        report("MemoryArena, reused chunks", runArena(&arena, threadCount, errors), threadCount,
+               ARENA_OPS_PER_THREAD);
+    }
+
+    size_t leaked = 0;
+    for (const char* name : {"Small", "Medium", "Large", "Huge"}) {
+        leaked += manager->getPool(name)->getAllocatedBlocks();
+    }
+    manager->shutdown();
+
+    if (errors.load() != 0 || leaked != 0) {
+        std::cerr << "Benchmark sanity check failed: " << errors.load()
+                  << " blocks were handed out twice, " << leaked << " blocks leaked"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
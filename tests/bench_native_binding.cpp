@@ -0,0 +1,232 @@
+// Native binding benchmark for the script VM: the same C++ function called from script when
+// registered as a ScriptFunction (arguments converted into a ScriptValue vector and called
+// through std::function) and when bound through a generated thunk that reads the argument
+// registers in place. Vector2D math is measured three ways: per-vector calls on {x, y}
+// tables through MathScriptBindings, per-vector thunk calls on x, y arguments, and one bulk
+// vectorIntegrate call over a packed component array. Every scenario's result is checked
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_native_binding.cpp
+//            src/scripting/ScriptingEngine.cpp src/scripting/ScriptVM.cpp
+//            src/scripting/ScriptCompiler.cpp src/scripting/VectorScriptBindings.cpp
+//            src/math/Vector2D.cpp -o bench_native_binding
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/scripting/NativeBinding.h"
+#include "../include/scripting/VectorScriptBindings.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int NATIVE_CALLS = 2000000;
+constexpr int LENGTH_CALLS = 500000;
+constexpr int VECTORS = 1000;
+constexpr int FRAMES = 200;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+const char* SCRIPT = R"(
+function callAdd(count)
+    local sum = 0
+    for i = 1, count do
+        sum = add(sum, 1)
+    end
+    return sum
+end
+
+function callBoundAdd(count)
+    local sum = 0
+    for i = 1, count do
+        sum = boundAdd(sum, 1)
+    end
+    return sum
+end
+
+function tableLengths(count)
+    local v = vec2(3.0, 4.0)
+    local sum = 0
+    for i = 1, count do
+        sum = sum + vec2Length(v)
+    end
+    return sum
+end
+
+function boundLengths(count)
+    local sum = 0
+    for i = 1, count do
+        sum = sum + vectorLength(3, 4)
+    end
+    return sum
+end
+
+function makeTables(count)
+    local positions = {}
+    local velocities = {}
+    for i = 1, count do
+        -- MathScriptBindings reads the components as floats
+        positions[i] = vec2(i + 0.0, 0.0)
+        velocities[i] = vec2(1.0, i % 5 + 0.0)
+    end
+    tablePositions = positions
+    tableVelocities = velocities
+end
+
+function integrateTables(count, dt)
+    local positions = tablePositions
+    local velocities = tableVelocities
+    for i = 1, count do
+        positions[i] = vec2Add(positions[i], vec2Mul(velocities[i], dt))
+    end
+end
+
+function makePacked(count)
+    local positions = {}
+    local velocities = {}
+    for i = 1, count do
+        positions[i * 2 - 1] = i
+        positions[i * 2] = 0
+        velocities[i * 2 - 1] = 1
+        velocities[i * 2] = i % 5
+    end
+    packedPositions = positions
+    packedVelocities = velocities
+    loopPositions = {}
+    for i = 1, count * 2 do loopPositions[i] = positions[i] end
+end
+
+function integrateLoop(count, dt)
+    local positions = loopPositions
+    local velocities = packedVelocities
+    for i = 1, count * 2 do
+        positions[i] = positions[i] + velocities[i] * dt
+    end
+end
+
+function integrateBulk(dt)
+    return vectorIntegrate(packedPositions, packedVelocities, dt)
+end
+)";
+
+int add(int a, int b) { return a + b; }
+
+void report(const char* name, double operations, const char* unit, double ms) {
+    std::cout << "    " << name << ": " << ms << " ms, " << operations / (ms / 1000.0) / 1e6
+              << " M " << unit << "/s" << std::endl;
+}
+
+double numberResult(const Scripting::ScriptValue& value) {
+    if (value.isInt()) return value.as<int>();
+    if (value.isFloat()) return value.as<float>();
+    return -1.0;
+}
+
+}  // namespace
+
+int main() {
+    Scripting::ScriptContext context;
+    context.registerFunction("add", [](const std::vector<Scripting::ScriptValue>& args) {
+        return Scripting::ScriptValue(args[0].as<int>() + args[1].as<int>());
+    });
+    Scripting::bindFunction<&add>(context, "boundAdd");
+    Scripting::MathScriptBindings::registerBindings(&context);
+    Scripting::VectorScriptBindings::registerBindings(&context);
+    context.loadString(SCRIPT);
+
+    std::cout << "Native binding benchmark" << std::endl;
+
+    const std::vector<Scripting::ScriptValue> nativeCalls = {Scripting::ScriptValue(NATIVE_CALLS)};
+    Timer functionTimer;
+    double functionSum = numberResult(context.callFunction("callAdd", nativeCalls));
+    report("add() as a ScriptFunction", NATIVE_CALLS, "calls", functionTimer.elapsedMs());
+
+    Timer thunkTimer;
+    double thunkSum = numberResult(context.callFunction("callBoundAdd", nativeCalls));
+    report("add() through a bound thunk", NATIVE_CALLS, "calls", thunkTimer.elapsedMs());
+
+    const std::vector<Scripting::ScriptValue> lengthCalls = {Scripting::ScriptValue(LENGTH_CALLS)};
+    Timer tableLengthTimer;
+    double tableLengths = numberResult(context.callFunction("tableLengths", lengthCalls));
+    report("vec2Length on a {x, y} table", LENGTH_CALLS, "calls", tableLengthTimer.elapsedMs());
+
+    Timer boundLengthTimer;
+    double boundLengths = numberResult(context.callFunction("boundLengths", lengthCalls));
+    report("vectorLength on x, y arguments", LENGTH_CALLS, "calls", boundLengthTimer.elapsedMs());
+
+    const Scripting::ScriptValue count(VECTORS);
+    const Scripting::ScriptValue dt(0.5f);
+    context.callFunction("makeTables", {count});
+    context.callFunction("makePacked", {count});
+
+    Timer tableTimer;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        context.callFunction("integrateTables", {count, dt});
+    }
+    report("integrating {x, y} tables with vec2Add and vec2Mul", VECTORS * FRAMES, "vectors",
+           tableTimer.elapsedMs());
+
+    Timer loopTimer;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        context.callFunction("integrateLoop", {count, dt});
+    }
+    report("integrating packed components in a script loop", VECTORS * FRAMES, "vectors",
+           loopTimer.elapsedMs());
+
+    const Scripting::ScriptContext::GlobalSlot integrateBulk =
+        context.resolveGlobal("integrateBulk");
+    double integrated = 0.0;
+    Timer bulkTimer;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        integrated += numberResult(context.callFunction(integrateBulk, {dt}));
+    }
+    report("integrating packed components with vectorIntegrate", VECTORS * FRAMES, "vectors",
+           bulkTimer.elapsedMs());
+
+    // All three integrations must land every vector in the same place
+    Scripting::VirtualMachine& vm = context.getVM();
+    const Scripting::VMTable* tables = vm.getGlobal(vm.findGlobal("tablePositions")).asTable();
+    const Scripting::VMTable* loop = vm.getGlobal(vm.findGlobal("loopPositions")).asTable();
+    const Scripting::VMTable* packed = vm.getGlobal(vm.findGlobal("packedPositions")).asTable();
+    const Scripting::VMValue x = Scripting::VMValue::string(vm.intern("x"));
+    const Scripting::VMValue y = Scripting::VMValue::string(vm.intern("y"));
+    bool positionsMatch = tables->length() == VECTORS && loop->length() == VECTORS * 2 &&
+                          packed->length() == VECTORS * 2;
+    for (int i = 0; positionsMatch && i < VECTORS; ++i) {
+        const double expectedX = (i + 1) + FRAMES * 0.5;
+        const double expectedY = ((i + 1) % 5) * FRAMES * 0.5;
+        const Scripting::VMTable* vector = tables->array[i].asTable();
+        const double found[] = {vector->get(x).toDouble(), vector->get(y).toDouble(),
+                                loop->array[i * 2].toDouble(), loop->array[i * 2 + 1].toDouble(),
+                                packed->array[i * 2].toDouble(),
+                                packed->array[i * 2 + 1].toDouble()};
+        for (int j = 0; j < 6; j += 2) {
+            positionsMatch = positionsMatch && std::fabs(found[j] - expectedX) < 1e-3 &&
+                             std::fabs(found[j + 1] - expectedY) < 1e-3;
+        }
+    }
+
+    bool consistent = functionSum == NATIVE_CALLS && thunkSum == NATIVE_CALLS &&
+                      std::fabs(tableLengths - LENGTH_CALLS * 5.0) < 1e-6 &&
+                      std::fabs(boundLengths - LENGTH_CALLS * 5.0) < 1e-6 &&
+                      integrated == static_cast<double>(VECTORS) * FRAMES && positionsMatch;
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: the bindings computed different results"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,235 @@
+// Path request benchmark for AI::ThreadedPathfinder on a 64x64 cell NavMesh with walls: agents
+// in a few squads repath towards a few rally points, so most requests repeat a search another
+// worker is already running. The service with 4 workers is compared with one NavMesh::findPath
+// per request on the main thread. Then requests already handed to the workers are
+// cancelled, and finished batches are handed out every frame while callbacks submit new
+// requests, a PathCache serves repeats and another thread polls the statistics.
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_path_requests.cpp src/ai/NavigationMesh.cpp
+//            src/math/Vector2D.cpp -lpthread -o bench_path_requests
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../include/ai/NavigationMesh.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int GRID_SIZE = 64;
+constexpr int WORKERS = 4;
+constexpr int SQUADS = 4;
+constexpr int RALLY_POINTS = 4;
+constexpr int REQUESTS = 2000;
+constexpr int AGENTS = 128;
+constexpr int FRAMES = 200;
+constexpr int REQUESTS_PER_FRAME = 64;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// Alternating vertical and horizontal walls every 16 cells with one gap each, so paths wind
+// across the map
+AI::NavMesh buildMesh() {
+    std::vector<bool> walkable(GRID_SIZE * GRID_SIZE, true);
+    for (int wall = 16; wall < GRID_SIZE; wall += 16) {
+        const int gap = (wall * 7) % (GRID_SIZE - 2) + 1;
+        const bool vertical = (wall / 16) % 2 == 1;
+        for (int i = 0; i < GRID_SIZE; ++i) {
+            if (i == gap) continue;
+            walkable[vertical ? i * GRID_SIZE + wall : wall * GRID_SIZE + i] = false;
+        }
+    }
+    AI::NavMeshBuilder builder;
+    return builder.buildFromGrid(GRID_SIZE, GRID_SIZE, 1.0f, walkable);
+}
+
+// Points in the same cell resolve to the same polygon, so their searches can be shared
+Math::Vector2D squadPoint(int squad, std::mt19937& random) {
+    const float jitter = static_cast<float>(random() % 100) / 200.0f;
+    return Math::Vector2D(2.25f + jitter, 2.25f + 14.0f * squad + jitter);
+}
+
+Math::Vector2D rallyPoint(int rally) {
+    return Math::Vector2D(GRID_SIZE - 3.5f, 3.5f + 15.0f * rally);
+}
+
+struct Delivery {
+    int count = 0;
+    bool valid = false;
+    size_t polygons = 0;
+};
+
+}  // namespace
+
+int main() {
+    AI::NavMesh mesh = buildMesh();
+    std::mt19937 random(1234);
+    std::cout << "Path request benchmark (" << mesh.getNodeCount() << " polygons, " << REQUESTS
+              << " requests from " << SQUADS << " squads to " << RALLY_POINTS
+              << " rally points, " << WORKERS << " workers)" << std::endl;
+
+    std::vector<std::pair<Math::Vector2D, Math::Vector2D>> requests;
+    for (int i = 0; i < REQUESTS; ++i) {
+        const int group = i * SQUADS * RALLY_POINTS / REQUESTS;
+        requests.emplace_back(squadPoint(group % SQUADS, random),
+                              rallyPoint(group / SQUADS));
+    }
+
+    std::vector<AI::NavMeshPath> expected(REQUESTS);
+    Timer inlineTimer;
+    for (int i = 0; i < REQUESTS; ++i) {
+        expected[i] = mesh.findPath(requests[i].first, requests[i].second);
+    }
+    std::cout << "    NavMesh::findPath per request: " << inlineTimer.elapsedMs() << " ms"
+              << std::endl;
+
+    // Coalescing: every request released in one batch, identical ones next to each other, so
+    // workers taking them find the first search still running
+    bool consistent = true;
+    {
+        AI::ThreadedPathfinder service(mesh, WORKERS);
+        service.setMaxRequestsPerFrame(0);
+        service.start();
+        std::vector<Delivery> deliveries(REQUESTS);
+        Timer serviceTimer;
+        for (int i = 0; i < REQUESTS; ++i) {
+            service.requestPath(requests[i].first, requests[i].second,
+                                [&deliveries, i](const AI::NavMeshPath& path) {
+                                    deliveries[i].count++;
+                                    deliveries[i].valid = path.valid;
+                                    deliveries[i].polygons = path.nodeIds.size();
+                                });
+        }
+        service.processCompletedPaths();
+        while (service.getStatistics().completedRequests < static_cast<size_t>(REQUESTS)) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            service.processCompletedPaths();
+        }
+        const double serviceMs = serviceTimer.elapsedMs();
+        const AI::ThreadedPathfinder::ThreadStats stats = service.getStatistics();
+        std::cout << "    ThreadedPathfinder: " << serviceMs << " ms, " << stats.coalescedRequests
+                  << " of " << REQUESTS << " requests coalesced, " << stats.averagePathTime
+                  << " ms/search" << std::endl;
+
+        for (int i = 0; i < REQUESTS; ++i) {
+            consistent = consistent && deliveries[i].count == 1 &&
+                         deliveries[i].valid == expected[i].valid &&
+                         deliveries[i].polygons == expected[i].nodeIds.size();
+        }
+        consistent = consistent && stats.coalescedRequests > 0;
+    }
+
+    // Cancelling after release: identical requests, so later ones may wait on the first's
+    // search, which keeps running for the request that was not cancelled
+    {
+        AI::ThreadedPathfinder service(mesh, WORKERS);
+        service.start();
+        int cancelledCalls = 0, keptCalls = 0;
+        const int running = service.requestPath(requests[0].first, requests[0].second,
+                                                [&](const AI::NavMeshPath&) { cancelledCalls++; });
+        const int waiter = service.requestPath(requests[0].first, requests[0].second,
+                                               [&](const AI::NavMeshPath&) { cancelledCalls++; });
+        service.requestPath(requests[0].first, requests[0].second,
+                            [&](const AI::NavMeshPath&) { keptCalls++; });
+        service.processCompletedPaths();
+        while (service.getStatistics().pendingRequests > 0) {
+            std::this_thread::yield();
+        }
+        service.cancelRequest(running);
+        service.cancelRequest(waiter);
+        for (int frame = 0; frame < 1000 && keptCalls == 0; ++frame) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            service.processCompletedPaths();
+        }
+        const AI::ThreadedPathfinder::ThreadStats stats = service.getStatistics();
+        std::cout << "    cancelled 2 of 3 identical requests after release: " << keptCalls
+                  << " delivered, " << cancelledCalls << " cancelled callbacks run" << std::endl;
+        consistent = consistent && keptCalls == 1 && cancelledCalls == 0 &&
+                     stats.cancelledRequests == 2 && stats.completedRequests == 1;
+    }
+
+    // Batches: callbacks repath their agent while another thread reads the statistics
+    {
+        AI::PathCache cache(64);
+        AI::ThreadedPathfinder service(mesh, WORKERS);
+        service.setPathCache(&cache);
+        service.setMaxRequestsPerFrame(REQUESTS_PER_FRAME);
+        service.start();
+
+        std::atomic<bool> polling{true};
+        std::atomic<size_t> polls{0};
+        std::thread poller([&]() {
+            while (polling) {
+                const AI::ThreadedPathfinder::ThreadStats stats = service.getStatistics();
+                if (stats.completedRequests + stats.pendingRequests > 0) polls++;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+
+        std::vector<int> delivered(AGENTS, 0);
+        size_t submitted = 0;
+        std::function<void(int)> repath = [&](int agent) {
+            submitted++;
+            service.requestPath(squadPoint(agent % SQUADS, random),
+                                rallyPoint(static_cast<int>(random() % RALLY_POINTS)),
+                                [&, agent](const AI::NavMeshPath&) {
+                                    delivered[agent]++;
+                                    repath(agent);
+                                },
+                                static_cast<int>(random() % 3), 4);
+        };
+        for (int agent = 0; agent < AGENTS; ++agent) {
+            repath(agent);
+        }
+
+        Timer frameTimer;
+        for (int frame = 0; frame < FRAMES; ++frame) {
+            service.processCompletedPaths();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        const double frameMs = frameTimer.elapsedMs();
+        service.cancelAllRequests();
+        polling = false;
+        poller.join();
+
+        const AI::ThreadedPathfinder::ThreadStats stats = service.getStatistics();
+        size_t total = 0;
+        for (int count : delivered) {
+            total += count;
+        }
+        std::cout << "    " << FRAMES << " frames of batches of " << REQUESTS_PER_FRAME << ": "
+                  << frameMs / FRAMES << " ms/frame, " << total << " delivered, "
+                  << stats.averageLatencyFrames << " frames latency, " << stats.missedDeadlines
+                  << " missed deadlines, " << stats.cacheHitRate * 100.0f << "% cache hits, "
+                  << polls << " concurrent statistics reads" << std::endl;
+
+        // Every agent always has exactly one request outstanding, which cancelAllRequests drops
+        consistent = consistent && total == stats.completedRequests &&
+                     submitted == total + AGENTS && stats.cancelledRequests == AGENTS &&
+                     stats.pendingRequests == 0 && total > 0;
+    }
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: a request was delivered twice, not at all, "
+                     "after being cancelled, or with a different path than NavMesh::findPath"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,249 @@
+// Pathfinding benchmark for AI::AStar and AI::HierarchicalPathfinder: random long queries on a
+// 1024x1024 grid with scattered obstacles and walls, against the previous A* scheme (a
+// priority_queue of node pointers keyed on their mutable costs, an unordered_map closed set and
+// per-node state reset before every query), plus the cost of repairing the hierarchy after a
+// local edit and of the landmark refresh that follows
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_pathfinding.cpp src/ai/Pathfinding.cpp
+//            src/math/Vector2D.cpp -o bench_pathfinding
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/ai/Pathfinding.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int GRID_SIZE = 1024;
+constexpr int CLUSTER_SIZE = 32;
+constexpr int QUERIES = 50;
+constexpr int MIN_QUERY_DISTANCE = 300;
+constexpr int EDITS = 50;
+constexpr float DIAGONAL_COST = 1.41421356f;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+struct Query {
+    int sx, sy, gx, gy;
+};
+
+float octile(int dx, int dy) {
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return static_cast<float>(std::max(dx, dy)) +
+           (DIAGONAL_COST - 1.0f) * static_cast<float>(std::min(dx, dy));
+}
+
+// The pre-change search, with the same step costs and corner rule. Costs change while nodes sit
+// in the heap, so its paths can come out slightly longer than optimal
+class PreviousAStar {
+   public:
+    explicit PreviousAStar(AI::Grid* grid) : grid(grid) {}
+
+    float findPath(const Query& query, size_t& expanded) {
+        const int width = grid->getWidth();
+        for (int y = 0; y < grid->getHeight(); ++y) {
+            for (int x = 0; x < width; ++x) {
+                AI::GridNode* node = grid->getNode(x, y);
+                node->gCost = 0.0f;
+                node->hCost = 0.0f;
+                node->parent = nullptr;
+            }
+        }
+
+        auto compare = [](AI::GridNode* a, AI::GridNode* b) { return a->fCost() > b->fCost(); };
+        std::priority_queue<AI::GridNode*, std::vector<AI::GridNode*>, decltype(compare)> openSet(
+            compare);
+        std::unordered_map<AI::GridNode*, bool> closedSet;
+
+        AI::GridNode* start = grid->getNode(query.sx, query.sy);
+        AI::GridNode* goal = grid->getNode(query.gx, query.gy);
+        start->hCost = octile(query.gx - query.sx, query.gy - query.sy);
+        openSet.push(start);
+        expanded = 0;
+        while (!openSet.empty()) {
+            AI::GridNode* current = openSet.top();
+            openSet.pop();
+            if (closedSet.count(current)) continue;
+            ++expanded;
+            if (current == goal) return current->gCost;
+            closedSet[current] = true;
+
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    const int x = current->x + dx, y = current->y + dy;
+                    if ((dx == 0 && dy == 0) || !grid->isWalkable(x, y)) continue;
+                    if (dx != 0 && dy != 0 && (!grid->isWalkable(current->x + dx, current->y) ||
+                                               !grid->isWalkable(current->x, current->y + dy))) {
+                        continue;
+                    }
+                    AI::GridNode* neighbor = grid->getNode(x, y);
+                    if (closedSet.count(neighbor)) continue;
+                    const float g = current->gCost + (dx != 0 && dy != 0 ? DIAGONAL_COST : 1.0f);
+                    if (neighbor != start && (neighbor->parent == nullptr || g < neighbor->gCost)) {
+                        neighbor->parent = current;
+                        neighbor->gCost = g;
+                        neighbor->hCost = octile(query.gx - neighbor->x, query.gy - neighbor->y);
+                        openSet.push(neighbor);
+                    }
+                }
+            }
+        }
+        return -1.0f;
+    }
+
+   private:
+    AI::Grid* grid;
+};
+
+float pathCost(const std::vector<Math::Vector2D>& path) {
+    if (path.empty()) return -1.0f;
+    float cost = 0.0f;
+    for (size_t i = 1; i < path.size(); ++i) {
+        const bool diagonal = path[i].x != path[i - 1].x && path[i].y != path[i - 1].y;
+        cost += diagonal ? DIAGONAL_COST : 1.0f;
+    }
+    return cost;
+}
+
+void buildMap(AI::Grid& grid, std::mt19937& random) {
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE / 5; ++i) {
+        grid.setWalkable(random() % GRID_SIZE, random() % GRID_SIZE, false);
+    }
+    // Long walls with gaps, so straight-line paths are rarely available
+    for (int wall = 0; wall < 200; ++wall) {
+        const int x = random() % GRID_SIZE, y = random() % GRID_SIZE;
+        const int length = 50 + random() % 200;
+        const bool horizontal = random() % 2 == 0;
+        for (int i = 0; i < length; ++i) {
+            grid.setWalkable(horizontal ? x + i : x, horizontal ? y : y + i, false);
+        }
+    }
+}
+
+void report(const char* name, double ms, size_t expanded) {
+    std::cout << "    " << name << ": " << ms / QUERIES << " ms/query, "
+              << expanded / QUERIES << " nodes expanded/query" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 random(1234);
+    AI::Grid grid(GRID_SIZE, GRID_SIZE);
+    buildMap(grid, random);
+
+    std::vector<Query> queries;
+    while (queries.size() < static_cast<size_t>(QUERIES)) {
+        Query query{static_cast<int>(random() % GRID_SIZE), static_cast<int>(random() % GRID_SIZE),
+                    static_cast<int>(random() % GRID_SIZE), static_cast<int>(random() % GRID_SIZE)};
+        if (std::abs(query.gx - query.sx) + std::abs(query.gy - query.sy) < MIN_QUERY_DISTANCE ||
+            !grid.isWalkable(query.sx, query.sy) || !grid.isWalkable(query.gx, query.gy)) {
+            continue;
+        }
+        queries.push_back(query);
+    }
+
+    std::cout << "Pathfinding benchmark (" << GRID_SIZE << "x" << GRID_SIZE << " grid, " << QUERIES
+              << " queries of at least " << MIN_QUERY_DISTANCE << " cells)" << std::endl;
+
+    PreviousAStar previous(&grid);
+    std::vector<float> previousCosts(queries.size());
+    size_t expanded = 0;
+    Timer previousTimer;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        size_t count = 0;
+        previousCosts[i] = previous.findPath(queries[i], count);
+        expanded += count;
+    }
+    report("previous A*", previousTimer.elapsedMs(), expanded);
+
+    // AStar must find a path exactly when the previous search did, and never a longer one
+    AI::AStar astar(&grid);
+    std::vector<float> optimal(queries.size());
+    bool consistent = true;
+    expanded = 0;
+    Timer astarTimer;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const Query& q = queries[i];
+        auto path = astar.findPath(Math::Vector2D(q.sx, q.sy), Math::Vector2D(q.gx, q.gy));
+        expanded += astar.getLastExpandedCount();
+        optimal[i] = pathCost(path);
+        consistent = consistent && (optimal[i] < 0.0f) == (previousCosts[i] < 0.0f) &&
+                     optimal[i] <= previousCosts[i] + 0.01f;
+    }
+    report("AStar", astarTimer.elapsedMs(), expanded);
+
+    Timer buildTimer;
+    AI::HierarchicalPathfinder hierarchy(&grid, CLUSTER_SIZE);
+    std::cout << "    HierarchicalPathfinder build: " << buildTimer.elapsedMs() << " ms, "
+              << hierarchy.getEntranceCount() << " entrances" << std::endl;
+
+    expanded = 0;
+    double worstRatio = 1.0, totalRatio = 0.0;
+    int solved = 0;
+    Timer hierarchyTimer;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const Query& q = queries[i];
+        auto path = hierarchy.findPath(Math::Vector2D(q.sx, q.sy), Math::Vector2D(q.gx, q.gy));
+        expanded += hierarchy.getLastAbstractExpandedCount();
+        if (optimal[i] < 0.0f) {
+            consistent = consistent && path.empty();
+            continue;
+        }
+        const double ratio = pathCost(path) / optimal[i];
+        worstRatio = std::max(worstRatio, ratio);
+        totalRatio += ratio;
+        ++solved;
+        consistent = consistent && !path.empty();
+    }
+    report("HierarchicalPathfinder", hierarchyTimer.elapsedMs(), expanded);
+    std::cout << "      path length vs optimal: " << totalRatio / std::max(solved, 1)
+              << " mean, " << worstRatio << " worst" << std::endl;
+    consistent = consistent && worstRatio < 1.25;
+
+    // Local edits, each repaired in place instead of rebuilding the hierarchy
+    Timer editTimer;
+    for (int edit = 0; edit < EDITS; ++edit) {
+        const int x = random() % (GRID_SIZE - 8), y = random() % (GRID_SIZE - 8);
+        for (int i = 0; i < 8; ++i) {
+            grid.setWalkable(x + i, y + 4, false);
+        }
+        hierarchy.updateRegion(x, y + 4, x + 7, y + 4);
+    }
+    std::cout << "    HierarchicalPathfinder updateRegion: " << editTimer.elapsedMs() / EDITS
+              << " ms/edit" << std::endl;
+
+    // The first query after edits also recomputes the landmark costs
+    Timer refreshTimer;
+    const Query& first = queries.front();
+    hierarchy.findPath(Math::Vector2D(first.sx, first.sy), Math::Vector2D(first.gx, first.gy));
+    std::cout << "    HierarchicalPathfinder first query after edits: " << refreshTimer.elapsedMs()
+              << " ms" << std::endl;
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: AStar returned a longer path than the "
+                     "previous search, or a hierarchical path was missing or too long"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
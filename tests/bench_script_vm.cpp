@@ -0,0 +1,165 @@
+// Script VM benchmark for Scripting::ScriptContext: recursive fib, a numeric loop, table
+// field and array access, and native calls, each compiled once and run in the bytecode VM,
+// plus host-to-script calls through a resolved global slot against calls by name, and a
+// reloaded script hitting the compiled-chunk cache. Every scenario's result is checked
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_script_vm.cpp
+//            src/scripting/ScriptingEngine.cpp src/scripting/ScriptVM.cpp
+//            src/scripting/ScriptCompiler.cpp -o bench_script_vm
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/scripting/ScriptingEngine.h"
+
+using namespace JJM;
+
+namespace {
+
+constexpr int FIB_N = 27;
+constexpr int LOOP_ITERATIONS = 10000000;
+constexpr int TABLE_ITERATIONS = 2000000;
+constexpr int NATIVE_CALLS = 2000000;
+constexpr int HOST_CALLS = 200000;
+constexpr int RELOADS = 10000;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+const char* SCRIPT = R"(
+function fib(n)
+    if n < 2 then return n end
+    return fib(n - 1) + fib(n - 2)
+end
+
+function loop(count)
+    local sum = 0
+    for i = 1, count do
+        sum = sum + i % 7
+    end
+    return sum
+end
+
+function tables(count)
+    local t = {x = 0, y = 3}
+    local slots = {}
+    for i = 1, 64 do slots[i] = 0 end
+    for i = 1, count do
+        t.x = t.x + t.y
+        local k = i % 64 + 1
+        slots[k] = slots[k] + 1
+    end
+    return t.x + slots[1]
+end
+
+function natives(count)
+    local sum = 0
+    for i = 1, count do
+        sum = add(sum, 1)
+    end
+    return sum
+end
+
+function update(dt)
+    ticks = ticks + 1
+    return dt
+end
+)";
+
+// fib(n) makes 2 * fib(n + 1) - 1 calls
+long long fibCalls(int n) {
+    long long a = 0, b = 1;
+    for (int i = 0; i < n + 1; ++i) {
+        long long next = a + b;
+        a = b;
+        b = next;
+    }
+    return 2 * a - 1;
+}
+
+int fibonacci(int n) { return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2); }
+
+void report(const char* name, double operations, const char* unit, double ms) {
+    std::cout << "    " << name << ": " << ms << " ms, " << operations / (ms / 1000.0) / 1e6
+              << " M " << unit << "/s" << std::endl;
+}
+
+int intResult(const Scripting::ScriptValue& value) { return value.isInt() ? value.as<int>() : -1; }
+
+}  // namespace
+
+int main() {
+    Scripting::ScriptContext context;
+    context.registerFunction("add", [](const std::vector<Scripting::ScriptValue>& args) {
+        return Scripting::ScriptValue(args[0].as<int>() + args[1].as<int>());
+    });
+    context.setGlobal("ticks", Scripting::ScriptValue(0));
+
+    Timer compileTimer;
+    context.loadString(SCRIPT);
+    const double compileMs = compileTimer.elapsedMs();
+
+    std::cout << "Script VM benchmark (script compiled in " << compileMs << " ms)" << std::endl;
+
+    Timer fibTimer;
+    int fib = intResult(context.callFunction("fib", {Scripting::ScriptValue(FIB_N)}));
+    report("recursive fib(27)", static_cast<double>(fibCalls(FIB_N)), "calls",
+           fibTimer.elapsedMs());
+
+    Timer loopTimer;
+    int loop = intResult(context.callFunction("loop", {Scripting::ScriptValue(LOOP_ITERATIONS)}));
+    report("numeric for loop", LOOP_ITERATIONS, "iterations", loopTimer.elapsedMs());
+
+    Timer tableTimer;
+    int tables =
+        intResult(context.callFunction("tables", {Scripting::ScriptValue(TABLE_ITERATIONS)}));
+    report("table field and array access", TABLE_ITERATIONS * 5.0, "accesses",
+           tableTimer.elapsedMs());
+
+    Timer nativeTimer;
+    int natives =
+        intResult(context.callFunction("natives", {Scripting::ScriptValue(NATIVE_CALLS)}));
+    report("native calls from script", NATIVE_CALLS, "calls", nativeTimer.elapsedMs());
+
+    const std::vector<Scripting::ScriptValue> dt = {Scripting::ScriptValue(0.016f)};
+    Timer byNameTimer;
+    for (int i = 0; i < HOST_CALLS; ++i) context.callFunction("update", dt);
+    report("host calls by name", HOST_CALLS, "calls", byNameTimer.elapsedMs());
+
+    const Scripting::ScriptContext::GlobalSlot update = context.resolveGlobal("update");
+    Timer bySlotTimer;
+    for (int i = 0; i < HOST_CALLS; ++i) context.callFunction(update, dt);
+    report("host calls through a resolved slot", HOST_CALLS, "calls", bySlotTimer.elapsedMs());
+    int ticks = intResult(context.getGlobal("ticks"));
+
+    Timer reloadTimer;
+    for (int i = 0; i < RELOADS; ++i) context.loadString("ticks = ticks + 1");
+    report("reloading a compiled chunk", RELOADS, "loads", reloadTimer.elapsedMs());
+
+    int expectedLoop = 0;
+    for (int i = 1; i <= LOOP_ITERATIONS; ++i) expectedLoop += i % 7;
+    const int expectedTables = TABLE_ITERATIONS * 3 + TABLE_ITERATIONS / 64;
+
+    bool consistent = fib == fibonacci(FIB_N) && loop == expectedLoop &&
+                      tables == expectedTables && natives == NATIVE_CALLS &&
+                      ticks == 2 * HOST_CALLS &&
+                      intResult(context.getGlobal("ticks")) == 2 * HOST_CALLS + RELOADS;
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: a script returned a different result than "
+                     "the same computation in C++"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
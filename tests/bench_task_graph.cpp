@@ -0,0 +1,249 @@
+// Task graph benchmark for Threading::JobSystem: a frame-shaped graph (input, AI, physics,
+// animation, render submission) run through execute(), which submits every node with
+// handles, and through the compiled plan with kick(), counting heap allocations per frame
+// and checking that every node ran once, after its dependencies
+//
+// Build: g++ -std=c++17 -O2 -Iinclude tests/bench_task_graph.cpp src/threading/ThreadPool.cpp
+//            src/profiler/PerformanceProfiler.cpp -lpthread -o bench_task_graph
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "../include/profiler/PerformanceProfiler.h"
+#include "../include/threading/ThreadPool.h"
+
+using namespace JJM;
+using namespace JJM::Threading;
+
+// Every heap allocation in the process is counted
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+
+constexpr size_t WORKER_COUNT = 4;
+constexpr int WARMUP_FRAMES = 20;
+constexpr int FRAMES = 2000;
+constexpr int WORK_FRAMES = 200;
+constexpr size_t AI_AGENTS = 16;
+constexpr size_t ISLANDS = 8;
+constexpr size_t ANIMATION_BATCHES = 16;
+constexpr size_t RENDER_BATCHES = 8;
+
+class Timer {
+   public:
+    Timer() : start(std::chrono::high_resolution_clock::now()) {}
+    double elapsedMs() const {
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+   private:
+    std::chrono::high_resolution_clock::time_point start;
+};
+
+// Busy work the optimizer can't drop
+uint64_t spin(uint64_t iterations) {
+    volatile uint64_t value = 1;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+    return value;
+}
+
+// Each node stamps the frame it ran in, and counts an error if any dependency has not
+// stamped the same frame yet
+struct FrameGraph {
+    TaskGraph graph;
+    std::vector<std::atomic<int>> stamps;
+    std::vector<std::vector<size_t>> dependencies;
+    std::atomic<int> frame{0};
+    std::atomic<int> errors{0};
+    std::atomic<uint64_t> runs{0};
+    uint64_t workScale = 0;
+
+    FrameGraph() : stamps(256) {}
+
+    size_t add(const std::string& name, uint64_t work, std::vector<size_t> deps,
+               TaskPriority priority = TaskPriority::Normal) {
+        size_t index = dependencies.size();
+        graph.addNode(
+            name,
+            [this, index, work]() {
+                const int current = frame.load(std::memory_order_relaxed);
+                for (size_t dep : dependencies[index]) {
+                    if (stamps[dep].load(std::memory_order_acquire) != current) ++errors;
+                }
+                if (workScale > 0) spin(work * workScale);
+                runs.fetch_add(1, std::memory_order_relaxed);
+                stamps[index].store(current, std::memory_order_release);
+            },
+            priority);
+        for (size_t dep : deps) graph.addDependency(index, dep);
+        dependencies.push_back(std::move(deps));
+        return index;
+    }
+
+    void build() {
+        size_t input = add("Input", 2, {}, TaskPriority::High);
+
+        std::vector<size_t> ai;
+        for (size_t i = 0; i < AI_AGENTS; ++i) {
+            // A few agents replan this frame and take much longer
+            ai.push_back(add("AI " + std::to_string(i), i % 5 == 0 ? 40 : 4, {input}));
+        }
+        size_t broadPhase = add("Physics broad phase", 10, {input}, TaskPriority::High);
+        std::vector<size_t> islands;
+        for (size_t i = 0; i < ISLANDS; ++i) {
+            islands.push_back(
+                add("Physics island " + std::to_string(i), 8, {broadPhase}, TaskPriority::High));
+        }
+        size_t integrate = add("Physics integrate", 6, islands, TaskPriority::High);
+
+        std::vector<size_t> animation;
+        for (size_t i = 0; i < ANIMATION_BATCHES; ++i) {
+            animation.push_back(add("Animation " + std::to_string(i), 5,
+                                    {integrate, ai[i % AI_AGENTS]}));
+        }
+        std::vector<size_t> render;
+        for (size_t i = 0; i < RENDER_BATCHES; ++i) {
+            render.push_back(add("Render build " + std::to_string(i), 6,
+                                 {animation[i * 2], animation[i * 2 + 1]}));
+        }
+        add("Render submit", 3, render, TaskPriority::High);
+    }
+
+    bool checkFrame() const {
+        for (size_t i = 0; i < dependencies.size(); ++i) {
+            if (stamps[i].load() != frame.load()) return false;
+        }
+        return errors.load() == 0;
+    }
+};
+
+struct Result {
+    double msPerFrame = 0.0;
+    double allocationsPerFrame = 0.0;
+    bool consistent = true;
+};
+
+template <typename RunFrame>
+Result runFrames(FrameGraph& frameGraph, int frames, RunFrame runFrame) {
+    Result result;
+    for (int i = 0; i < WARMUP_FRAMES; ++i) {
+        frameGraph.frame.fetch_add(1);
+        runFrame();
+    }
+
+    uint64_t allocationsBefore = g_allocations.load();
+    uint64_t runsBefore = frameGraph.runs.load();
+    Timer timer;
+    for (int i = 0; i < frames; ++i) {
+        frameGraph.frame.fetch_add(1);
+        runFrame();
+        result.consistent = frameGraph.checkFrame() && result.consistent;
+    }
+    result.msPerFrame = timer.elapsedMs() / frames;
+    result.allocationsPerFrame =
+        static_cast<double>(g_allocations.load() - allocationsBefore) / frames;
+    result.consistent = result.consistent &&
+                        frameGraph.runs.load() - runsBefore ==
+                            static_cast<uint64_t>(frames) * frameGraph.dependencies.size();
+    return result;
+}
+
+void report(const char* name, const Result& result) {
+    std::cout << "    " << name << ": " << result.msPerFrame * 1000.0 << " us/frame, "
+              << result.allocationsPerFrame << " allocations/frame" << std::endl;
+}
+
+}  // namespace
+
+int main() {
+    JobSystem jobSystem(WORKER_COUNT);
+    jobSystem.startup();
+    bool consistent = true;
+
+    FrameGraph frameGraph;
+    frameGraph.build();
+    if (!frameGraph.graph.compile()) {
+        std::cerr << "Frame graph failed to compile" << std::endl;
+        return 1;
+    }
+    const size_t nodeCount = frameGraph.graph.getNodes().size();
+    std::cout << "TaskGraph benchmark (" << WORKER_COUNT << " workers, "
+              << std::thread::hardware_concurrency() << " hardware threads, " << nodeCount
+              << " nodes per frame)" << std::endl;
+
+    // Scheduling overhead alone: nodes only check their dependencies
+    std::cout << "  " << FRAMES << " frames of empty nodes" << std::endl;
+    Result submitted = runFrames(frameGraph, FRAMES, [&]() {
+        std::vector<JobHandle> handles = jobSystem.execute(frameGraph.graph);
+        jobSystem.waitAll(handles);
+    });
+    report("execute, handles", submitted);
+    JobCounter counter;
+    Result kicked = runFrames(frameGraph, FRAMES, [&]() {
+        jobSystem.kick(frameGraph.graph, counter);
+        jobSystem.wait(counter);
+    });
+    report("compiled plan, kick", kicked);
+    consistent = consistent && submitted.consistent && kicked.consistent;
+    consistent = consistent && kicked.allocationsPerFrame == 0.0;
+
+    // With work: learned costs pick out the critical path
+    frameGraph.workScale = 100;
+    std::cout << "  " << WORK_FRAMES << " frames with work" << std::endl;
+    Result working = runFrames(frameGraph, WORK_FRAMES, [&]() {
+        jobSystem.kick(frameGraph.graph, counter);
+        jobSystem.wait(counter);
+    });
+    report("compiled plan, kick", working);
+    consistent = consistent && working.consistent;
+
+    const TaskGraph& graph = frameGraph.graph;
+    size_t critical = 0;
+    for (size_t i = 0; i < nodeCount; ++i) {
+        if (graph.isOnCriticalPath(i)) ++critical;
+    }
+    std::cout << "    critical path " << graph.getCriticalPathMicros() << " us over " << critical
+              << " nodes" << std::endl;
+    consistent = consistent && critical > 0 && graph.isOnCriticalPath(graph.getRootNodes()[0]);
+
+    // Export the last frame's nodes to the timeline
+    Utils::TimelineProfiler profiler;
+    profiler.beginFrame();
+    frameGraph.frame.fetch_add(1);
+    jobSystem.kick(frameGraph.graph, counter);
+    jobSystem.wait(counter);
+    graph.exportTimeline(profiler);
+    profiler.endFrame();
+    size_t events = 0;
+    for (const auto& track : profiler.getFrame(0).tracks) {
+        events += track.events.size();
+    }
+    std::cout << "    exported " << events << " events on " << profiler.getFrame(0).tracks.size()
+              << " timeline tracks" << std::endl;
+    consistent = consistent && events == nodeCount;
+
+    jobSystem.shutdown();
+
+    if (!consistent) {
+        std::cerr << "Benchmark sanity check failed: nodes ran out of order, were lost, or "
+                     "kicks allocated"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}